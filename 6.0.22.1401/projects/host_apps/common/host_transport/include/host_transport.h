@@ -0,0 +1,327 @@
+/**
+ ****************************************************************************************
+ *
+ * @file host_transport.h
+ *
+ * @brief Batched UART reception and lock-free frame queue for the host applications.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _HOST_TRANSPORT_H_
+#define _HOST_TRANSPORT_H_
+
+/*
+ * The receive path of the host applications:
+ *
+ *   UART --(batched reads)--> byte ring --(H4/GTL parser)--> frame queue --> main thread
+ *
+ * The reception thread calls ht_transport_rx_poll() in a loop. Every call reads all the
+ * bytes the driver has (up to HT_RX_RING_SIZE) with one system call and parses them in
+ * place. Complete frames are written straight into the preallocated slots of a lock-free
+ * single-producer/single-consumer queue, from which the main thread takes them with
+ * ht_queue_peek()/ht_queue_release(). Nothing is allocated after ht_transport_init().
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// H4 packet types
+#define HT_PKT_HCI_CMD          0x01
+#define HT_PKT_HCI_ACL          0x02
+#define HT_PKT_HCI_EVT          0x04
+#define HT_PKT_GTL              0x05    // FE_MSG, see RW-BLE-HOST-IS
+
+/// Mask of packet types for ht_transport_init()
+#define HT_FILTER(type)         (1UL << (type))
+
+/// Largest frame handed to the consumer, header included and packet type excluded
+#ifndef HT_MAX_FRAME_LENGTH
+#define HT_MAX_FRAME_LENGTH     1024
+#endif
+
+/// Number of frames in the receive queue (power of 2)
+#ifndef HT_QUEUE_DEPTH
+#define HT_QUEUE_DEPTH          64
+#endif
+
+/// Size of the receive byte ring (power of 2)
+#ifndef HT_RX_RING_SIZE
+#define HT_RX_RING_SIZE         4096
+#endif
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/// Received frame
+typedef struct
+{
+    uint16_t length;                        ///< Number of bytes in data
+    uint8_t  type;                          ///< H4 packet type
+    uint8_t  reserved;
+    uint8_t  data[HT_MAX_FRAME_LENGTH];     ///< Frame without the packet type byte
+} ht_frame;
+
+/// Single-producer/single-consumer frame queue
+typedef struct
+{
+    volatile uint32_t head;                 ///< Written by the producer only
+    uint8_t  pad0[60];
+    volatile uint32_t tail;                 ///< Written by the consumer only
+    uint8_t  pad1[60];
+    ht_frame frames[HT_QUEUE_DEPTH];
+} ht_queue;
+
+/// Incremental H4/GTL frame parser
+typedef struct
+{
+    uint8_t  state;
+    uint8_t  type;
+    uint8_t  hdr_len;
+    uint16_t pos;
+    uint16_t expected;
+    uint8_t  hdr[8];
+    ht_frame *frame;                        ///< Queue slot being filled, NULL if skipped
+    uint32_t filter;                        ///< Packet types forwarded to the consumer
+} ht_parser;
+
+/// Serial port
+typedef struct
+{
+    int fd;
+} ht_port;
+
+/// Transport statistics, updated by the reception thread
+typedef struct
+{
+    uint32_t reads;                         ///< Read system calls returning data
+    uint32_t bytes;                         ///< Bytes received
+    uint32_t frames;                        ///< Frames forwarded to the consumer
+    uint32_t skipped;                       ///< Well-formed frames filtered out
+    uint32_t sync_errors;                   ///< Bytes dropped while looking for a frame
+    uint32_t stalls;                        ///< Times the queue was found full
+} ht_stats;
+
+/// Host transport
+typedef struct
+{
+    ht_port   port;
+    ht_parser parser;
+    ht_queue  queue;
+    ht_stats  stats;
+    uint32_t  ring_rd, ring_wr;
+    uint8_t   ring[HT_RX_RING_SIZE];
+    /// Called by the reception thread when frames have been queued
+    void (*notify)(void *arg);
+    void *notify_arg;
+} ht_transport;
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+/*
+ ****************************************************************************************
+ * @brief Initialize the frame queue.
+ *
+ * @param[in] q  Queue.
+ ****************************************************************************************
+*/
+void ht_queue_init(ht_queue *q);
+
+/*
+ ****************************************************************************************
+ * @brief Get the free slot at the head of the queue (producer).
+ *
+ * @param[in] q  Queue.
+ *
+ * @return the slot to fill, or NULL if the queue is full
+ ****************************************************************************************
+*/
+ht_frame *ht_queue_alloc(ht_queue *q);
+
+/*
+ ****************************************************************************************
+ * @brief Publish the slot returned by ht_queue_alloc() (producer).
+ *
+ * @param[in] q  Queue.
+ ****************************************************************************************
+*/
+void ht_queue_commit(ht_queue *q);
+
+/*
+ ****************************************************************************************
+ * @brief Get the oldest frame of the queue without removing it (consumer).
+ *
+ * @param[in] q  Queue.
+ *
+ * @return the frame, or NULL if the queue is empty
+ ****************************************************************************************
+*/
+ht_frame *ht_queue_peek(ht_queue *q);
+
+/*
+ ****************************************************************************************
+ * @brief Give the frame returned by ht_queue_peek() back to the producer (consumer).
+ *
+ * @param[in] q  Queue.
+ ****************************************************************************************
+*/
+void ht_queue_release(ht_queue *q);
+
+/*
+ ****************************************************************************************
+ * @brief Initialize the frame parser.
+ *
+ * @param[in] p       Parser.
+ * @param[in] filter  HT_FILTER() mask of the packet types to forward. The other
+ *                    packet types are parsed and dropped (e.g. the command echo of
+ *                    a 1-wire UART).
+ ****************************************************************************************
+*/
+void ht_parser_init(ht_parser *p, uint32_t filter);
+
+/*
+ ****************************************************************************************
+ * @brief Parse received bytes into queue frames.
+ *
+ * @param[in] p      Parser.
+ * @param[in] q      Queue receiving the frames.
+ * @param[in] stats  Statistics to update.
+ * @param[in] buf    Received bytes.
+ * @param[in] len    Number of bytes.
+ *
+ * @return number of bytes consumed; less than len only when the queue is full
+ ****************************************************************************************
+*/
+size_t ht_parser_feed(ht_parser *p, ht_queue *q, ht_stats *stats, const uint8_t *buf, size_t len);
+
+/*
+ ****************************************************************************************
+ * @brief Open a serial port, 8N1.
+ *
+ * @param[out] port          Port.
+ * @param[in]  name          Device name ("/dev/ttyUSB0").
+ * @param[in]  baudrate      Baud rate.
+ * @param[in]  flow_control  Use RTS/CTS if not zero.
+ *
+ * @return -1 on failure / 0 on success.
+ ****************************************************************************************
+*/
+int ht_port_open(ht_port *port, const char *name, uint32_t baudrate, int flow_control);
+
+/*
+ ****************************************************************************************
+ * @brief Read all the bytes available, waiting for the first one.
+ *
+ * @param[in] port        Port.
+ * @param[in] buf         Buffer.
+ * @param[in] len         Buffer size.
+ * @param[in] timeout_ms  Time to wait for the first byte.
+ *
+ * @return number of bytes read, 0 on timeout, -1 on error
+ ****************************************************************************************
+*/
+int ht_port_read(ht_port *port, uint8_t *buf, size_t len, uint32_t timeout_ms);
+
+/*
+ ****************************************************************************************
+ * @brief Write bytes.
+ *
+ * @param[in] port  Port.
+ * @param[in] buf   Bytes to write.
+ * @param[in] len   Number of bytes.
+ *
+ * @return -1 on failure / 0 on success.
+ ****************************************************************************************
+*/
+int ht_port_write(ht_port *port, const uint8_t *buf, size_t len);
+
+/*
+ ****************************************************************************************
+ * @brief Discard the pending data and close the port.
+ *
+ * @param[in] port  Port.
+ ****************************************************************************************
+*/
+void ht_port_close(ht_port *port);
+
+/*
+ ****************************************************************************************
+ * @brief Sleep.
+ *
+ * @param[in] ms  Milliseconds, 0 to only give the processor to another thread.
+ ****************************************************************************************
+*/
+void ht_sleep_ms(uint32_t ms);
+
+/*
+ ****************************************************************************************
+ * @brief Initialize the transport. The port is opened separately with ht_port_open().
+ *
+ * @param[in] t           Transport.
+ * @param[in] filter      HT_FILTER() mask of the packet types to forward.
+ * @param[in] notify      Called by the reception thread when frames are queued, or NULL.
+ * @param[in] notify_arg  Argument of notify.
+ ****************************************************************************************
+*/
+void ht_transport_init(ht_transport *t, uint32_t filter, void (*notify)(void *arg), void *notify_arg);
+
+/*
+ ****************************************************************************************
+ * @brief Receive a batch of bytes and queue the complete frames (reception thread).
+ *
+ * @param[in] t           Transport.
+ * @param[in] timeout_ms  Time to wait for data.
+ *
+ * @return number of frames queued, -1 if the port failed
+ ****************************************************************************************
+*/
+int ht_transport_rx_poll(ht_transport *t, uint32_t timeout_ms);
+
+/*
+ ****************************************************************************************
+ * @brief Send a message with its packet type byte.
+ *
+ * @param[in] t     Transport.
+ * @param[in] type  H4 packet type.
+ * @param[in] data  Message.
+ * @param[in] len   Message size.
+ *
+ * @return -1 on failure / 0 on success.
+ ****************************************************************************************
+*/
+int ht_transport_send(ht_transport *t, uint8_t type, const void *data, uint16_t len);
+
+#endif // _HOST_TRANSPORT_H_
@@ -0,0 +1,324 @@
+/**
+ ****************************************************************************************
+ *
+ * @file host_transport.c
+ *
+ * @brief Batched UART reception and lock-free frame queue for the host applications.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+#include <string.h>
+#include "host_transport.h"
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+#define HT_LOAD_ACQUIRE(p)      __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define HT_STORE_RELEASE(p, v)  __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+/// Parser states
+enum
+{
+    HT_RX_TYPE,     // waiting for the packet type byte
+    HT_RX_HEADER,   // receiving the header
+    HT_RX_DATA,     // receiving the parameters
+};
+
+/*
+ * Header of the packets after the type byte: header size, offset and size of the
+ * parameter length field.
+ */
+static const struct
+{
+    uint8_t hdr_len;
+    uint8_t len_offset;
+    uint8_t len_size;
+} ht_formats[] =
+{
+    [HT_PKT_HCI_CMD] = {3, 2, 1},   // opcode[2] length
+    [HT_PKT_HCI_ACL] = {4, 2, 2},   // handle[2] length[2]
+    [HT_PKT_HCI_EVT] = {2, 1, 1},   // event length
+    [HT_PKT_GTL]     = {8, 6, 2},   // msg_id[2] dest_id[2] src_id[2] length[2]
+};
+
+/*
+ * FRAME QUEUE
+ ****************************************************************************************
+ */
+
+void ht_queue_init(ht_queue *q)
+{
+    q->head = 0;
+    q->tail = 0;
+}
+
+ht_frame *ht_queue_alloc(ht_queue *q)
+{
+    uint32_t head = q->head;
+
+    if (head - HT_LOAD_ACQUIRE(&q->tail) == HT_QUEUE_DEPTH)
+    {
+        return NULL;
+    }
+    return &q->frames[head & (HT_QUEUE_DEPTH - 1)];
+}
+
+void ht_queue_commit(ht_queue *q)
+{
+    HT_STORE_RELEASE(&q->head, q->head + 1);
+}
+
+ht_frame *ht_queue_peek(ht_queue *q)
+{
+    uint32_t tail = q->tail;
+
+    if (HT_LOAD_ACQUIRE(&q->head) == tail)
+    {
+        return NULL;
+    }
+    return &q->frames[tail & (HT_QUEUE_DEPTH - 1)];
+}
+
+void ht_queue_release(ht_queue *q)
+{
+    HT_STORE_RELEASE(&q->tail, q->tail + 1);
+}
+
+/*
+ * FRAME PARSER
+ ****************************************************************************************
+ */
+
+void ht_parser_init(ht_parser *p, uint32_t filter)
+{
+    memset(p, 0, sizeof(*p));
+    p->state = HT_RX_TYPE;
+    p->filter = filter;
+}
+
+static void ht_parser_complete(ht_parser *p, ht_queue *q, ht_stats *stats)
+{
+    if (p->frame)
+    {
+        p->frame->type = p->type;
+        p->frame->length = p->expected;
+        ht_queue_commit(q);
+        stats->frames++;
+    }
+    else
+    {
+        stats->skipped++;
+    }
+    p->state = HT_RX_TYPE;
+}
+
+size_t ht_parser_feed(ht_parser *p, ht_queue *q, ht_stats *stats, const uint8_t *buf, size_t len)
+{
+    size_t i = 0;
+    size_t n;
+
+    while (i < len)
+    {
+        switch (p->state)
+        {
+        case HT_RX_TYPE:
+            if ((buf[i] >= sizeof(ht_formats) / sizeof(ht_formats[0])) || (ht_formats[buf[i]].hdr_len == 0))
+            {
+                stats->sync_errors++;
+                i++;
+                break;
+            }
+            p->frame = NULL;
+            if (p->filter & HT_FILTER(buf[i]))
+            {
+                // Keep the type byte until the consumer frees a slot
+                p->frame = ht_queue_alloc(q);
+                if (p->frame == NULL)
+                {
+                    stats->stalls++;
+                    return i;
+                }
+            }
+            p->type = buf[i++];
+            p->hdr_len = ht_formats[p->type].hdr_len;
+            p->pos = 0;
+            p->state = HT_RX_HEADER;
+            break;
+
+        case HT_RX_HEADER:
+            p->hdr[p->pos++] = buf[i++];
+            if (p->pos < p->hdr_len)
+            {
+                break;
+            }
+
+            p->expected = p->hdr_len + p->hdr[ht_formats[p->type].len_offset];
+            if (ht_formats[p->type].len_size == 2)
+            {
+                p->expected += p->hdr[ht_formats[p->type].len_offset + 1] << 8;
+            }
+            if (p->expected > HT_MAX_FRAME_LENGTH)
+            {
+                // Not a frame, resynchronize on the next byte
+                stats->sync_errors += 1 + p->hdr_len;
+                p->state = HT_RX_TYPE;
+                break;
+            }
+            if (p->frame)
+            {
+                memcpy(p->frame->data, p->hdr, p->hdr_len);
+            }
+            p->state = HT_RX_DATA;
+            if (p->expected == p->pos)
+            {
+                ht_parser_complete(p, q, stats);
+            }
+            break;
+
+        case HT_RX_DATA:
+            n = p->expected - p->pos;
+            if (n > len - i)
+            {
+                n = len - i;
+            }
+            if (p->frame)
+            {
+                memcpy(&p->frame->data[p->pos], &buf[i], n);
+            }
+            p->pos += n;
+            i += n;
+            if (p->pos == p->expected)
+            {
+                ht_parser_complete(p, q, stats);
+            }
+            break;
+        }
+    }
+    return i;
+}
+
+/*
+ * TRANSPORT
+ ****************************************************************************************
+ */
+
+void ht_transport_init(ht_transport *t, uint32_t filter, void (*notify)(void *arg), void *notify_arg)
+{
+    ht_queue_init(&t->queue);
+    ht_parser_init(&t->parser, filter);
+    memset(&t->stats, 0, sizeof(t->stats));
+    t->ring_rd = 0;
+    t->ring_wr = 0;
+    t->notify = notify;
+    t->notify_arg = notify_arg;
+}
+
+/* Parse the bytes of the ring, in at most two contiguous spans */
+static void ht_transport_parse(ht_transport *t)
+{
+    uint32_t rd, len;
+    size_t done;
+
+    while (t->ring_rd != t->ring_wr)
+    {
+        rd = t->ring_rd & (HT_RX_RING_SIZE - 1);
+        len = t->ring_wr - t->ring_rd;
+        if (len > HT_RX_RING_SIZE - rd)
+        {
+            len = HT_RX_RING_SIZE - rd;
+        }
+        done = ht_parser_feed(&t->parser, &t->queue, &t->stats, &t->ring[rd], len);
+        t->ring_rd += done;
+        if (done < len)
+        {
+            break;  // queue full
+        }
+    }
+}
+
+int ht_transport_rx_poll(ht_transport *t, uint32_t timeout_ms)
+{
+    uint32_t frames = t->stats.frames;
+    uint32_t wr, len;
+    int n;
+
+    if (t->ring_rd != t->ring_wr)
+    {
+        // Bytes left by a full queue: let the consumer run
+        ht_transport_parse(t);
+        if (t->ring_rd != t->ring_wr)
+        {
+            ht_sleep_ms(0);
+            return 0;
+        }
+    }
+    else
+    {
+        // Read at the beginning of the ring for the largest possible batch
+        t->ring_rd = t->ring_wr = 0;
+    }
+
+    wr = t->ring_wr & (HT_RX_RING_SIZE - 1);
+    len = HT_RX_RING_SIZE - (t->ring_wr - t->ring_rd);
+    if (len > HT_RX_RING_SIZE - wr)
+    {
+        len = HT_RX_RING_SIZE - wr;
+    }
+
+    n = ht_port_read(&t->port, &t->ring[wr], len, timeout_ms);
+    if (n <= 0)
+    {
+        return n;
+    }
+    t->stats.reads++;
+    t->stats.bytes += n;
+    t->ring_wr += n;
+
+    ht_transport_parse(t);
+
+    if ((t->stats.frames != frames) && t->notify)
+    {
+        t->notify(t->notify_arg);
+    }
+    return t->stats.frames - frames;
+}
+
+int ht_transport_send(ht_transport *t, uint8_t type, const void *data, uint16_t len)
+{
+    uint8_t buf[1 + HT_MAX_FRAME_LENGTH];
+
+    if (len > HT_MAX_FRAME_LENGTH)
+    {
+        return -1;
+    }
+    buf[0] = type;
+    memcpy(&buf[1], data, len);
+
+    return ht_port_write(&t->port, buf, 1 + len);
+}
@@ -0,0 +1,195 @@
+/**
+ ****************************************************************************************
+ *
+ * @file host_transport_posix.c
+ *
+ * @brief Host transport serial port backend for POSIX systems (termios).
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sched.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include "host_transport.h"
+
+static speed_t ht_baudrate_to_speed(uint32_t baudrate)
+{
+    switch (baudrate)
+    {
+    case 9600:      return B9600;
+    case 19200:     return B19200;
+    case 38400:     return B38400;
+    case 57600:     return B57600;
+    case 115200:    return B115200;
+    case 230400:    return B230400;
+#ifdef B460800
+    case 460800:    return B460800;
+#endif
+#ifdef B921600
+    case 921600:    return B921600;
+#endif
+#ifdef B1000000
+    case 1000000:   return B1000000;
+#endif
+    default:        return B0;
+    }
+}
+
+int ht_port_open(ht_port *port, const char *name, uint32_t baudrate, int flow_control)
+{
+    struct termios tio;
+    speed_t speed = ht_baudrate_to_speed(baudrate);
+
+    if (speed == B0)
+    {
+        return -1;
+    }
+
+    port->fd = open(name, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (port->fd < 0)
+    {
+        return -1;
+    }
+
+    if (tcgetattr(port->fd, &tio) < 0)
+    {
+        close(port->fd);
+        return -1;
+    }
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cflag &= ~CSTOPB;
+#ifdef CRTSCTS
+    if (flow_control)
+    {
+        tio.c_cflag |= CRTSCTS;
+    }
+    else
+    {
+        tio.c_cflag &= ~CRTSCTS;
+    }
+#endif
+    tio.c_cc[VMIN] = 1;
+    tio.c_cc[VTIME] = 0;
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+    if (tcsetattr(port->fd, TCSANOW, &tio) < 0)
+    {
+        close(port->fd);
+        return -1;
+    }
+    tcflush(port->fd, TCIOFLUSH);
+
+    return 0;
+}
+
+int ht_port_read(ht_port *port, uint8_t *buf, size_t len, uint32_t timeout_ms)
+{
+    struct pollfd pfd;
+    ssize_t n;
+
+    pfd.fd = port->fd;
+    pfd.events = POLLIN;
+
+    n = read(port->fd, buf, len);
+    if (n > 0)
+    {
+        return n;
+    }
+    if ((n < 0) && (errno != EAGAIN) && (errno != EINTR))
+    {
+        return -1;
+    }
+
+    // Nothing buffered: wait for the first byte, then take all that has arrived
+    n = poll(&pfd, 1, timeout_ms);
+    if (n <= 0)
+    {
+        return ((n < 0) && (errno != EINTR)) ? -1 : 0;
+    }
+
+    n = read(port->fd, buf, len);
+    if (n < 0)
+    {
+        return ((errno == EAGAIN) || (errno == EINTR)) ? 0 : -1;
+    }
+    return (n == 0) ? -1 : n;
+}
+
+int ht_port_write(ht_port *port, const uint8_t *buf, size_t len)
+{
+    struct pollfd pfd;
+    ssize_t n;
+
+    pfd.fd = port->fd;
+    pfd.events = POLLOUT;
+
+    while (len)
+    {
+        n = write(port->fd, buf, len);
+        if (n < 0)
+        {
+            if (errno == EAGAIN)
+            {
+                poll(&pfd, 1, 100);
+                continue;
+            }
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+        buf += n;
+        len -= n;
+    }
+    return 0;
+}
+
+void ht_port_close(ht_port *port)
+{
+    tcflush(port->fd, TCIOFLUSH);
+    close(port->fd);
+}
+
+void ht_sleep_ms(uint32_t ms)
+{
+    struct timespec ts;
+
+    if (ms == 0)
+    {
+        sched_yield();
+        return;
+    }
+    ts.tv_sec = ms / 1000;
+    ts.tv_nsec = (ms % 1000) * 1000000L;
+    nanosleep(&ts, NULL);
+}
@@ -0,0 +1,394 @@
+/**
+ ****************************************************************************************
+ *
+ * @file fleet.h
+ *
+ * @brief SUOTA fleet initiator definitions.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef FLEET_H_
+#define FLEET_H_
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/types.h>
+#include "co_bt.h"
+#include "gapc_task.h"
+#include "gapm_task.h"
+#include "gattc_task.h"
+
+#include "host_transport.h"
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+#define FLEET_VERSION           "1.0"
+
+#define MAX_IMAGE_SIZE          (0x18000) // 96Kb
+#define CHECKSUM_SIZE           (1)       // in bytes
+
+/// Maximum number of target devices of one run
+#define FLEET_MAX_DEVICES       (1024)
+
+/// Maximum number of simultaneous connections of the DA14585 GTL firmware (CFG_CON)
+#define FLEET_MAX_CONNECTIONS   (8)
+
+#define FLEET_MAX_SCANNING_ATTEMPTS     (3)
+#define FLEET_MAX_CONNECT_ATTEMPTS      (3)
+
+/// Time allowed to a direct connection before it is cancelled
+#define FLEET_CONNECT_TIMEOUT_MS        (5000)
+/// Time allowed to a session without any answer from its peer
+#define FLEET_SESSION_TIMEOUT_MS        (20000)
+/// Time allowed to a disconnection before the link is considered gone
+#define FLEET_DISCONNECT_TIMEOUT_MS     (3000)
+
+/// LL TX data buffers per link (BLE_TX_DESC_DATA / BLE_CONNECTION_MAX) of the DA14585
+#define FLEET_LL_TX_BUFFERS     (3)
+/// Largest chunk write window of one link
+#define FLEET_WINDOW_MAX        (32)
+/// Default bound of the chunk bytes queued in the DA14585 for all the links
+#define FLEET_INFLIGHT_BYTES    (4096)
+
+#define MAX_LE_PKT_SIZE         (251)
+#define MAX_LE_TX_TIME          (2120)
+#define MAX_GATT_MTU_SIZE       (247)
+#define ATT_HEADER_SIZE         (3)
+#define L2CAP_HEADER_SIZE       (4)
+#define LE_DEFAULT_PKT_SIZE     (27)
+#define DEFAULT_DATA_CHUNK_SIZE (20)
+
+#define SUOTA_VERSION_1_3       (13)
+
+#define CLIENT_CHARACTERISTIC_CONFIGURATION_DESCRIPTOR_UUID 0x2902
+
+// SUOTA service UUIDs
+#define SUOTA_PRIMARY_SERVICE_UUID 0xFEF5  // SUOTA standard UUID
+
+// 128-bit UUID (stored in LE order)
+typedef uint8_t uuid_128_t[16];
+
+#define UUID_128_LE(b15, b14, b13, b12, b11, b10, b9, b8, b7, b6, b5, b4, b3, b2, b1, b0) \
+    {b0, b1, b2, b3, b4, b5, b6, b7, b8, b9, b10, b11, b12, b13, b14, b15}
+
+extern const uuid_128_t SUOTA_MEM_DEV_UUID;
+extern const uuid_128_t SUOTA_GPIO_MAP_UUID;
+extern const uuid_128_t SUOTA_MEM_INFO_UUID;
+extern const uuid_128_t SUOTA_PATCH_LEN_UUID;
+extern const uuid_128_t SUOTA_PATCH_DATA_UUID;
+extern const uuid_128_t SUOTA_SERV_STATUS_UUID;
+extern const uuid_128_t SUOTA_VERSION_UUID;
+extern const uuid_128_t SUOTA_MTU_UUID;
+extern const uuid_128_t SUOTA_PD_CHAR_SIZE_UUID;
+
+// SUOTA_SERV_STATUS values
+enum {
+    SUOTA_STATUS_SRV_STARTED    = 0x01,
+    SUOTA_STATUS_CMP_OK         = 0x02,
+    SUOTA_STATUS_SRV_EXIT       = 0x03,
+    SUOTA_STATUS_CRC_ERR        = 0x04,
+    SUOTA_STATUS_PATCH_LEN_ERR  = 0x05,
+    SUOTA_STATUS_EXT_MEM_ERR    = 0x06,
+    SUOTA_STATUS_INT_MEM_ERR    = 0x07,
+    SUOTA_STATUS_INVAL_MEM_TYPE = 0x08,
+    SUOTA_STATUS_APP_ERROR      = 0x09,
+    SUOTA_STATUS_IMG_STARTED    = 0x10,     // SUOTA started for downloading image (SUOTA application)
+};
+
+// SUOTA memory types and commands written to SUOTA_MEM_DEV
+enum
+{
+    SUOTA_MEM_DEV_I2C = 0x12,
+    SUOTA_MEM_DEV_SPI = 0x13,
+    SUOTA_REBOOT      = 0xFD,
+    SUOTA_END         = 0xFE,
+};
+
+#define INVALID_GPIO    0xFF
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/// GTL message header, followed by the parameters of the message
+typedef struct {
+  unsigned short bType;
+  unsigned short bDstid;
+  unsigned short bSrcid;
+  unsigned short bLength;
+} ble_hdr;
+
+typedef struct {
+    uint32_t patch_base_address;
+    uint16_t i2c_device_address;
+    uint8_t scl_gpio;
+    uint8_t sda_gpio;
+} suota_i2c_options_t;
+
+typedef struct {
+    uint32_t patch_base_address;
+    uint8_t miso_gpio;
+    uint8_t mosi_gpio;
+    uint8_t cs_gpio;
+    uint8_t sck_gpio;
+} suota_spi_options_t;
+
+/// Command line options
+struct fleet_options
+{
+    const char *port;
+    uint32_t baudrate;
+    const char *bin_file_name;
+    const char *report_name;
+
+    /// SUOTA sessions in flight
+    unsigned int concurrency;
+    /// Chunk writes in flight per link, 0 to size it from the MTU and the LL packet size
+    unsigned int window;
+    /// Write whole blocks at once like the single device initiator
+    bool block_burst;
+    /// Chunk bytes in flight for all the links
+    uint32_t inflight_bytes;
+
+    uint16_t block_size;
+    uint8_t mem_type;
+    union {
+        suota_i2c_options_t i2c_options;
+        suota_spi_options_t spi_options;
+    };
+
+    /// Simulated peers, 0 to use the port
+    unsigned int sim_count;
+    /// Make every sim_faulty_every-th simulated peer fail
+    unsigned int sim_faulty_every;
+};
+
+/// Progress of the SUOTA session of a device
+enum fleet_state
+{
+    FLEET_PENDING,
+    FLEET_CONNECTING,
+    FLEET_DISC_SVC,
+    FLEET_DISC_CHAR,
+    FLEET_DISC_DESC,
+    FLEET_EN_SERV_STATUS_NOTIFICATIONS,
+    FLEET_RD_SUOTA_VERSION,
+    FLEET_RD_MTU_SIZE,
+    FLEET_RD_PD_CHAR_SIZE,
+    FLEET_DLE_NEGOTIATION,
+    FLEET_GATT_MTU_NEGOTIATION,
+    FLEET_WR_MEM_DEV,
+    FLEET_WR_GPIO_MAP,
+    FLEET_RD_MEM_INFO,
+    FLEET_WR_PATCH_LEN,
+    FLEET_WR_PATCH_DATA,
+    FLEET_RD_MEM_INFO_2,
+    FLEET_WR_END_OF_SUOTA,
+    FLEET_DISCONNECTING,
+    FLEET_DONE,
+};
+
+/// Outcome of the SUOTA session of a device
+enum fleet_result
+{
+    FLEET_RES_NONE,
+    FLEET_RES_OK,
+    FLEET_RES_NOT_FOUND,
+    FLEET_RES_CONNECT_FAILED,
+    FLEET_RES_NO_SERVICE,
+    FLEET_RES_GATT_ERROR,
+    FLEET_RES_SUOTA_ERROR,
+    FLEET_RES_LINK_LOST,
+    FLEET_RES_TIMEOUT,
+};
+
+/// Target device and its SUOTA session
+struct fleet_device
+{
+    struct bd_addr addr;
+    uint8_t addr_type;
+    bool found;
+    uint8_t connect_attempts;
+
+    uint8_t state;
+    uint8_t result;
+    /// Status code of the failure
+    uint8_t status;
+
+    uint8_t conidx;
+    uint16_t conhdl;
+
+    uint16_t svc_start_handle;
+    uint16_t svc_end_handle;
+    uint16_t mem_dev_handle;
+    uint16_t gpio_map_handle;
+    uint16_t mem_info_handle;
+    uint16_t patch_len_handle;
+    uint16_t patch_data_handle;
+    uint16_t serv_status_handle;
+    uint16_t serv_status_cli_char_cfg_desc_handle;
+    uint16_t suota_version_handle;
+    uint16_t suota_mtu_handle;
+    uint16_t pd_char_size_handle;
+
+    uint8_t suota_version;
+    uint16_t pd_char_size;
+    uint16_t tx_octets;
+    uint16_t mtu;
+
+    uint16_t chunk_size;
+    uint16_t block_size;
+    /// Chunk writes allowed in flight
+    uint16_t window;
+
+    uint32_t block_offset;
+    uint16_t block_length;
+    /// Block bytes written, and acknowledged by their write completion
+    uint16_t sent_offset;
+    uint16_t acked_offset;
+    /// SUOTA_STATUS_CMP_OK notified for the current block
+    bool block_done;
+
+    /// Times of the connection, of the first and the last block, and of the last event
+    double t_connect;
+    double t_start;
+    double t_end;
+    double t_activity;
+};
+
+/*
+ * EXTERNAL VARIABLE DECLARATIONS
+ ****************************************************************************************
+ */
+
+extern struct fleet_options fleet_options;
+
+extern struct fleet_device fleet_devices[FLEET_MAX_DEVICES];
+extern unsigned int fleet_device_count;
+
+extern uint32_t patch_length;
+extern uint8_t patch_data[MAX_IMAGE_SIZE + CHECKSUM_SIZE];
+
+extern ht_transport fleet_transport;
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Monotonic time in seconds.
+ ****************************************************************************************
+ */
+double fleet_now(void);
+
+/**
+ ****************************************************************************************
+ * @brief Print a device address as used on the command line.
+ *
+ * @param[in] addr  Device address.
+ *
+ * @return static string, overwritten by the next call
+ ****************************************************************************************
+ */
+const char *fleet_bdaddr_str(const struct bd_addr *addr);
+
+/**
+ ****************************************************************************************
+ * @brief Reset the DA14585 and start updating the devices.
+ ****************************************************************************************
+ */
+void fleet_start(void);
+
+/**
+ ****************************************************************************************
+ * @brief Handle a GTL message of the DA14585.
+ *
+ * @param[in] msg    Message header.
+ * @param[in] param  Message parameters.
+ ****************************************************************************************
+ */
+void fleet_handle_msg(const ble_hdr *msg, const void *param);
+
+/**
+ ****************************************************************************************
+ * @brief Run the timeouts and start the next connections. Called after every batch of
+ *        messages and at least every few milliseconds.
+ ****************************************************************************************
+ */
+void fleet_poll(void);
+
+/**
+ ****************************************************************************************
+ * @brief Check if every device has its outcome.
+ ****************************************************************************************
+ */
+bool fleet_finished(void);
+
+/**
+ ****************************************************************************************
+ * @brief Name of a session outcome.
+ ****************************************************************************************
+ */
+const char *fleet_result_str(uint8_t result);
+
+/**
+ ****************************************************************************************
+ * @brief Address of a simulated peer.
+ *
+ * @param[in]  index  Peer index.
+ * @param[out] addr   Peer address.
+ ****************************************************************************************
+ */
+void fleet_sim_bdaddr(unsigned int index, struct bd_addr *addr);
+
+/**
+ ****************************************************************************************
+ * @brief Start a simulated DA14585 GTL firmware with 'count' SUOTA receivers in range,
+ *        served by a child process over a pty.
+ *
+ * @param[in]  count          Number of simulated SUOTA receivers.
+ * @param[in]  faulty_every   Make every faulty_every-th receiver fail, 0 for none.
+ * @param[in]  baudrate       Simulated UART baud rate.
+ * @param[out] port           Name of the pty to open.
+ * @param[in]  port_size      Size of port.
+ *
+ * @return pid of the child process, -1 on failure
+ ****************************************************************************************
+ */
+pid_t fleet_sim_start(unsigned int count, unsigned int faulty_every, uint32_t baudrate,
+                      char *port, size_t port_size);
+
+#endif // FLEET_H_
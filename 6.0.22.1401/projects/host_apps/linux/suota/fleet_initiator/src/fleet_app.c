@@ -0,0 +1,1303 @@
+/**
+ ****************************************************************************************
+ *
+ * @file fleet_app.c
+ *
+ * @brief SUOTA fleet initiator: concurrent SUOTA sessions over one GTL link.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "co_math.h"
+#include "fleet.h"
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Connection interval of every link, in 1.25 ms units
+#define FLEET_CON_INTERVAL      (12)
+
+/// Time between two progress reports
+#define FLEET_PROGRESS_PERIOD_S (5.0)
+
+/*
+ * GLOBAL VARIABLE DEFINITIONS
+ ****************************************************************************************
+ */
+
+// SUOTA service characteristic UUIDs
+const uuid_128_t SUOTA_MEM_DEV_UUID      = UUID_128_LE(0x80, 0x82, 0xCA, 0xA8, 0x41, 0xA6, 0x40, 0x21, 0x91, 0xC6, 0x56, 0xF9, 0xB9, 0x54, 0xCC, 0x34);
+const uuid_128_t SUOTA_GPIO_MAP_UUID     = UUID_128_LE(0x72, 0x42, 0x49, 0xF0, 0x5E, 0xC3, 0x4B, 0x5F, 0x88, 0x04, 0x42, 0x34, 0x5A, 0xF0, 0x86, 0x51);
+const uuid_128_t SUOTA_MEM_INFO_UUID     = UUID_128_LE(0x6C, 0x53, 0xDB, 0x25, 0x47, 0xA1, 0x45, 0xFE, 0xA0, 0x22, 0x7C, 0x92, 0xFB, 0x33, 0x4F, 0xD4);
+const uuid_128_t SUOTA_PATCH_LEN_UUID    = UUID_128_LE(0x9D, 0x84, 0xB9, 0xA3, 0x00, 0x0C, 0x49, 0xD8, 0x91, 0x83, 0x85, 0x5B, 0x67, 0x3F, 0xDA, 0x31);
+const uuid_128_t SUOTA_PATCH_DATA_UUID   = UUID_128_LE(0x45, 0x78, 0x71, 0xE8, 0xD5, 0x16, 0x4C, 0xA1, 0x91, 0x16, 0x57, 0xD0, 0xB1, 0x7B, 0x9C, 0xB2);
+const uuid_128_t SUOTA_SERV_STATUS_UUID  = UUID_128_LE(0x5F, 0x78, 0xDF, 0x94, 0x79, 0x8C, 0x46, 0xF5, 0x99, 0x0A, 0xB3, 0xEB, 0x6A, 0x06, 0x5C, 0x88);
+const uuid_128_t SUOTA_VERSION_UUID      = UUID_128_LE(0x64, 0xB4, 0xE8, 0xB5, 0x0D, 0xE5, 0x40, 0x1B, 0xA2, 0x1D, 0xAC, 0xC8, 0xDB, 0x3B, 0x91, 0x3A);
+const uuid_128_t SUOTA_PD_CHAR_SIZE_UUID = UUID_128_LE(0x42, 0xC3, 0xDF, 0xDD, 0x77, 0xBE, 0x4D, 0x9C, 0x84, 0x54, 0x8F, 0x87, 0x52, 0x67, 0xFB, 0x3B);
+const uuid_128_t SUOTA_MTU_UUID          = UUID_128_LE(0xB7, 0xDE, 0x1E, 0xEA, 0x82, 0x3D, 0x43, 0xBB, 0xA3, 0xAF, 0xC4, 0x90, 0x3D, 0xFC, 0xE2, 0x3C);
+
+/// State shared by all the sessions
+static struct
+{
+    /// Reset and configuration of the DA14585 done
+    bool ready;
+    /// The DA14585 could not be configured
+    bool fatal;
+    /// GAPM operation in progress
+    uint8_t gapm_op;
+
+    uint8_t scan_attempts_made;
+    bool scan_done;
+
+    /// Device of the direct connection in progress
+    struct fleet_device *connecting;
+    double connect_deadline;
+    bool cancel_sent;
+
+    /// Device of every connection index
+    struct fleet_device *links[FLEET_MAX_CONNECTIONS];
+    /// Sessions between their connection request and their outcome
+    unsigned int active;
+    unsigned int done;
+    /// Link served first by the next fleet_suota_fill_windows()
+    unsigned int rr;
+
+    /// Chunk bytes written and not completed yet, for all the links
+    uint32_t inflight_bytes;
+    /// Image bytes acknowledged, for all the links
+    uint64_t bytes_acked;
+    double t_begin;
+    double t_progress;
+} fleet_env;
+
+/// Buffer of the message being built
+static uint8_t msg_buf[HT_MAX_FRAME_LENGTH];
+
+/*
+ * MESSAGES TO THE DA14585
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Start building a message. Only one message can be built at a time.
+ *
+ * @param[in] id         Id of the message.
+ * @param[in] dest_id    ID of the receiving task instance.
+ * @param[in] param_len  Parameters length.
+ *
+ * @return pointer to the zeroed parameters
+ ****************************************************************************************
+ */
+static void *fleet_msg_alloc(unsigned short id, unsigned short dest_id, unsigned short param_len)
+{
+    ble_hdr *hdr = (ble_hdr *) msg_buf;
+
+    assert(sizeof(ble_hdr) + param_len <= sizeof(msg_buf));
+
+    hdr->bType   = id;
+    hdr->bDstid  = dest_id;
+    hdr->bSrcid  = TASK_ID_GTL;
+    hdr->bLength = param_len;
+    memset(hdr + 1, 0, param_len);
+
+    return hdr + 1;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Send the message built by fleet_msg_alloc().
+ ****************************************************************************************
+ */
+static void fleet_msg_send(void)
+{
+    ble_hdr *hdr = (ble_hdr *) msg_buf;
+
+    if (ht_transport_send(&fleet_transport, HT_PKT_GTL, hdr, sizeof(ble_hdr) + hdr->bLength) != 0)
+    {
+        fprintf(stderr, "Error: could not write to %s\n", fleet_options.port);
+        fleet_env.fatal = true;
+    }
+}
+
+static void fleet_rst_gap(void)
+{
+    struct gapm_reset_cmd *msg = fleet_msg_alloc(GAPM_RESET_CMD, TASK_ID_GAPM, sizeof(struct gapm_reset_cmd));
+
+    msg->operation = GAPM_RESET;
+    fleet_env.gapm_op = GAPM_RESET;
+
+    fleet_msg_send();
+}
+
+static void fleet_set_mode(void)
+{
+    struct gapm_set_dev_config_cmd *msg = fleet_msg_alloc(GAPM_SET_DEV_CONFIG_CMD, TASK_ID_GAPM,
+                                                          sizeof(struct gapm_set_dev_config_cmd));
+
+    msg->operation = GAPM_SET_DEV_CONFIG;
+    msg->role = GAP_ROLE_CENTRAL;
+    msg->addr_type = GAPM_CFG_ADDR_PUBLIC;
+    msg->att_cfg = GAPM_MASK_ATT_SVC_CHG_EN;
+    msg->max_mtu = MAX_GATT_MTU_SIZE;
+    fleet_env.gapm_op = GAPM_SET_DEV_CONFIG;
+
+    fleet_msg_send();
+}
+
+static void fleet_inq(void)
+{
+    struct gapm_start_scan_cmd *msg = fleet_msg_alloc(GAPM_START_SCAN_CMD, TASK_ID_GAPM,
+                                                      sizeof(struct gapm_start_scan_cmd));
+
+    msg->op.code = GAPM_SCAN_ACTIVE;
+    msg->op.addr_src = GAPM_STATIC_ADDR;
+    msg->interval = 10;
+    msg->window = 5;
+    msg->mode = GAP_GEN_DISCOVERY;
+    msg->filt_policy = SCAN_ALLOW_ADV_ALL;
+    msg->filter_duplic = SCAN_FILT_DUPLIC_EN;
+    fleet_env.gapm_op = GAPM_SCAN_ACTIVE;
+    fleet_env.scan_attempts_made++;
+
+    fleet_msg_send();
+}
+
+static void fleet_cancel(void)
+{
+    struct gapm_cancel_cmd *msg = fleet_msg_alloc(GAPM_CANCEL_CMD, TASK_ID_GAPM, sizeof(struct gapm_cancel_cmd));
+
+    msg->operation = GAPM_CANCEL;
+
+    fleet_msg_send();
+}
+
+/**
+ ****************************************************************************************
+ * @brief Connect to a device. The links share the connection interval: every link gets
+ *        an equal part of it as connection event length.
+ ****************************************************************************************
+ */
+static void fleet_connect(struct fleet_device *dev)
+{
+    struct gapm_start_connection_cmd *msg = fleet_msg_alloc(GAPM_START_CONNECTION_CMD, TASK_ID_GAPM,
+                                                            sizeof(struct gapm_start_connection_cmd)
+                                                            + sizeof(struct gap_bdaddr));
+    uint16_t ce_len = (FLEET_CON_INTERVAL * 2) / fleet_options.concurrency;
+
+    if (ce_len < 2)
+    {
+        ce_len = 2;
+    }
+
+    msg->op.code = GAPM_CONNECTION_DIRECT;
+    msg->op.addr_src = GAPM_STATIC_ADDR;
+    msg->nb_peers = 1;
+    memcpy(&msg->peers[0].addr, &dev->addr, sizeof(struct bd_addr));
+    msg->peers[0].addr_type = dev->addr_type;
+    msg->con_intv_min = FLEET_CON_INTERVAL;
+    msg->con_intv_max = FLEET_CON_INTERVAL;
+    msg->ce_len_min = ce_len;
+    msg->ce_len_max = ce_len;
+    msg->con_latency = 0;
+    msg->superv_to = 0x1F4;
+    msg->scan_interval = 0x180;
+    msg->scan_window = 0x160;
+
+    fleet_env.gapm_op = GAPM_CONNECTION_DIRECT;
+    fleet_env.connecting = dev;
+    fleet_env.connect_deadline = fleet_now() + FLEET_CONNECT_TIMEOUT_MS / 1000.0;
+    fleet_env.cancel_sent = false;
+
+    dev->state = FLEET_CONNECTING;
+    dev->connect_attempts++;
+    dev->t_activity = fleet_now();
+
+    fleet_msg_send();
+}
+
+static void fleet_connect_confirm(struct fleet_device *dev)
+{
+    struct gapc_connection_cfm *cfm = fleet_msg_alloc(GAPC_CONNECTION_CFM, KE_BUILD_ID(TASK_ID_GAPC, dev->conidx),
+                                                      sizeof(struct gapc_connection_cfm));
+
+    cfm->auth = GAP_AUTH_REQ_NO_MITM_NO_BOND;
+
+    fleet_msg_send();
+}
+
+static void fleet_disconnect_conidx(uint8_t conidx)
+{
+    struct gapc_disconnect_cmd *req = fleet_msg_alloc(GAPC_DISCONNECT_CMD, KE_BUILD_ID(TASK_ID_GAPC, conidx),
+                                                      sizeof(struct gapc_disconnect_cmd));
+
+    req->operation = GAPC_DISCONNECT;
+    req->reason = CO_ERROR_REMOTE_USER_TERM_CON;
+
+    fleet_msg_send();
+}
+
+static void fleet_discover(struct fleet_device *dev, uint8_t operation, uint16_t start_handle,
+                           uint16_t end_handle, uint16_t uuid)
+{
+    struct gattc_disc_cmd *req = fleet_msg_alloc(GATTC_DISC_CMD, KE_BUILD_ID(TASK_ID_GATTC, dev->conidx),
+                                                 sizeof(struct gattc_disc_cmd) + 2 /*uuid length*/);
+
+    req->operation = operation;
+    req->uuid_len = 2; // 16 bit UUID
+    req->start_hdl = start_handle;
+    req->end_hdl = end_handle;
+    req->uuid[0] = uuid & 0xFF;
+    req->uuid[1] = (uuid >> 8) & 0xFF;
+
+    fleet_msg_send();
+}
+
+static void fleet_characteristic_write(struct fleet_device *dev, uint8_t operation, uint16_t handle,
+                                       const uint8_t *value, uint16_t value_length)
+{
+    struct gattc_write_cmd *req = fleet_msg_alloc(GATTC_WRITE_CMD, KE_BUILD_ID(TASK_ID_GATTC, dev->conidx),
+                                                  sizeof(struct gattc_write_cmd) + value_length);
+
+    req->operation = operation;
+    req->auto_execute = 1;
+    req->handle = handle;
+    req->length = value_length;
+    memcpy(req->value, value, value_length);
+
+    fleet_msg_send();
+}
+
+static void fleet_characteristic_read(struct fleet_device *dev, uint16_t handle)
+{
+    struct gattc_read_cmd *req = fleet_msg_alloc(GATTC_READ_CMD, KE_BUILD_ID(TASK_ID_GATTC, dev->conidx),
+                                                 sizeof(struct gattc_read_cmd));
+
+    req->operation = GATTC_READ;
+    req->req.simple.handle = handle;
+
+    fleet_msg_send();
+}
+
+static void fleet_write_mem_dev(struct fleet_device *dev, uint8_t command, uint32_t address)
+{
+    uint8_t value[4];
+
+    value[3] = command;
+    value[2] = (address >> 16) & 0xFF;
+    value[1] = (address >> 8) & 0xFF;
+    value[0] = address & 0xFF;
+
+    fleet_characteristic_write(dev, GATTC_WRITE, dev->mem_dev_handle, value, sizeof(value));
+}
+
+/*
+ * SESSION OUTCOME
+ ****************************************************************************************
+ */
+
+const char *fleet_result_str(uint8_t result)
+{
+    switch (result)
+    {
+        case FLEET_RES_OK:              return "ok";
+        case FLEET_RES_NOT_FOUND:       return "not found";
+        case FLEET_RES_CONNECT_FAILED:  return "connect failed";
+        case FLEET_RES_NO_SERVICE:      return "no SUOTA service";
+        case FLEET_RES_GATT_ERROR:      return "GATT error";
+        case FLEET_RES_SUOTA_ERROR:     return "SUOTA error";
+        case FLEET_RES_LINK_LOST:       return "link lost";
+        case FLEET_RES_TIMEOUT:         return "timeout";
+        default:                        return "not run";
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Record the outcome of a session and print it.
+ ****************************************************************************************
+ */
+static void fleet_finish(struct fleet_device *dev, uint8_t result, uint8_t status)
+{
+    if (dev->result == FLEET_RES_NONE)
+    {
+        dev->result = result;
+        dev->status = status;
+    }
+    if (dev->state != FLEET_PENDING)
+    {
+        fleet_env.active--;
+    }
+    dev->state = FLEET_DONE;
+    fleet_env.done++;
+
+    if (dev->result == FLEET_RES_OK)
+    {
+        double t = dev->t_end - dev->t_start;
+
+        printf("[%4u/%u] %s ok, %u bytes in %.2f s, %.2f KB/s (MTU %u, LL %u, chunk %u, window %u)\n",
+               fleet_env.done, fleet_device_count, fleet_bdaddr_str(&dev->addr), patch_length, t,
+               t > 0 ? patch_length / t / 1024 : 0, dev->mtu, dev->tx_octets, dev->chunk_size, dev->window);
+    }
+    else
+    {
+        printf("[%4u/%u] %s failed: %s (status 0x%02X)\n",
+               fleet_env.done, fleet_device_count, fleet_bdaddr_str(&dev->addr),
+               fleet_result_str(dev->result), dev->status);
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief The link of a device is gone: free its connection index and its share of the
+ *        chunks in flight, and record the outcome.
+ ****************************************************************************************
+ */
+static void fleet_release(struct fleet_device *dev, uint8_t reason)
+{
+    fleet_env.links[dev->conidx] = NULL;
+    fleet_env.inflight_bytes -= dev->sent_offset - dev->acked_offset;
+    dev->sent_offset = dev->acked_offset;
+
+    fleet_finish(dev, FLEET_RES_LINK_LOST, reason);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Abort the session of a device.
+ ****************************************************************************************
+ */
+static void fleet_fail(struct fleet_device *dev, uint8_t result, uint8_t status)
+{
+    if (dev->result == FLEET_RES_NONE)
+    {
+        dev->result = result;
+        dev->status = status;
+    }
+    dev->state = FLEET_DISCONNECTING;
+    dev->t_activity = fleet_now();
+    fleet_disconnect_conidx(dev->conidx);
+}
+
+/*
+ * SUOTA PROCEDURE
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Size the chunks, the blocks and the write window of a device from its MTU, its
+ *        SUOTA_PATCH_DATA size and its LL packet size.
+ *
+ * Every chunk takes one ATT Write Command, i.e. one L2CAP packet split into LL packets
+ * of tx_octets. The window holds two connection events worth of LL TX buffers so that the
+ * DA14585 always has the packets of the next event queued, without filling its message
+ * heap with the packets of events to come.
+ ****************************************************************************************
+ */
+static void fleet_suota_set_data_params(struct fleet_device *dev)
+{
+    uint16_t pd_char_size = dev->pd_char_size ? dev->pd_char_size : DEFAULT_DATA_CHUNK_SIZE;
+    uint16_t pdus;
+
+    dev->chunk_size = co_min(dev->mtu - ATT_HEADER_SIZE, pd_char_size);
+    dev->block_size = fleet_options.block_size;
+
+    if (dev->chunk_size > dev->block_size)
+    {
+        dev->chunk_size = dev->block_size;
+    }
+    else
+    {// Set block size to the closest possible value to the user input
+        dev->block_size = (dev->block_size / dev->chunk_size) * dev->chunk_size;
+    }
+
+    pdus = (dev->chunk_size + ATT_HEADER_SIZE + L2CAP_HEADER_SIZE + dev->tx_octets - 1) / dev->tx_octets;
+
+    if (fleet_options.block_burst)
+    {
+        dev->window = (dev->block_size + dev->chunk_size - 1) / dev->chunk_size;
+    }
+    else
+    {
+        dev->window = fleet_options.window ? fleet_options.window : (2 * FLEET_LL_TX_BUFFERS) / pdus;
+        dev->window = co_max(dev->window, 2);
+        dev->window = co_min(dev->window, FLEET_WINDOW_MAX);
+    }
+}
+
+static void fleet_suota_write_patch_len(struct fleet_device *dev)
+{
+    uint8_t value[2];
+
+    value[0] = dev->block_length & 0xFF;
+    value[1] = (dev->block_length >> 8) & 0xFF;
+
+    dev->state = FLEET_WR_PATCH_LEN;
+    fleet_characteristic_write(dev, GATTC_WRITE, dev->patch_len_handle, value, sizeof(value));
+}
+
+/**
+ ****************************************************************************************
+ * @brief Start writing the block at block_offset. SUOTA_PATCH_LEN is written for the
+ *        first block and when the block length changes, i.e. for a shorter last block.
+ ****************************************************************************************
+ */
+static void fleet_suota_start_block(struct fleet_device *dev)
+{
+    uint16_t previous_length = dev->block_length;
+
+    dev->block_length = co_min(dev->block_size, patch_length - dev->block_offset);
+    dev->sent_offset = 0;
+    dev->acked_offset = 0;
+    dev->block_done = false;
+
+    if (dev->block_offset == 0 || dev->block_length != previous_length)
+    {
+        fleet_suota_write_patch_len(dev);
+    }
+    else
+    {
+        dev->state = FLEET_WR_PATCH_DATA;
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Write chunks on every link until its window is full or the chunk bytes in flight
+ *        for all the links reach their bound. The links are served one chunk at a time,
+ *        from a different first link at every call, so that the bound is shared fairly.
+ ****************************************************************************************
+ */
+static void fleet_suota_fill_windows(void)
+{
+    bool progress;
+    unsigned int i;
+
+    do
+    {
+        progress = false;
+
+        for (i = 0; i < FLEET_MAX_CONNECTIONS; i++)
+        {
+            struct fleet_device *dev = fleet_env.links[(fleet_env.rr + i) % FLEET_MAX_CONNECTIONS];
+            uint16_t inflight, len;
+
+            if (dev == NULL || dev->state != FLEET_WR_PATCH_DATA || dev->sent_offset == dev->block_length)
+            {
+                continue;
+            }
+
+            inflight = (dev->sent_offset - dev->acked_offset + dev->chunk_size - 1) / dev->chunk_size;
+            if (inflight >= dev->window)
+            {
+                continue;
+            }
+
+            len = co_min(dev->chunk_size, dev->block_length - dev->sent_offset);
+            if (!fleet_options.block_burst && fleet_env.inflight_bytes
+                && fleet_env.inflight_bytes + len > fleet_options.inflight_bytes)
+            {
+                progress = false;
+                break;
+            }
+
+            fleet_characteristic_write(dev, GATTC_WRITE_NO_RESPONSE, dev->patch_data_handle,
+                                       &patch_data[dev->block_offset + dev->sent_offset], len);
+            dev->sent_offset += len;
+            fleet_env.inflight_bytes += len;
+            progress = true;
+        }
+    } while (progress);
+
+    fleet_env.rr = (fleet_env.rr + 1) % FLEET_MAX_CONNECTIONS;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Go on with the next block, or end the procedure, once every chunk of the block
+ *        is completed and the device has notified that it stored the block.
+ ****************************************************************************************
+ */
+static void fleet_suota_check_block(struct fleet_device *dev)
+{
+    if (dev->acked_offset != dev->block_length || !dev->block_done)
+    {
+        return;
+    }
+
+    if (dev->block_offset + dev->block_length == patch_length)
+    {
+        // no more blocks to write - read SUOTA_MEM_INFO (the 2nd time)
+        dev->t_end = fleet_now();
+        dev->state = FLEET_RD_MEM_INFO_2;
+        fleet_characteristic_read(dev, dev->mem_info_handle);
+    }
+    else
+    {
+        dev->block_offset += dev->block_length;
+        fleet_suota_start_block(dev);
+    }
+}
+
+/*
+ * MESSAGE HANDLERS
+ ****************************************************************************************
+ */
+
+static struct fleet_device *fleet_device_find(const struct bd_addr *addr)
+{
+    unsigned int i;
+
+    for (i = 0; i < fleet_device_count; i++)
+    {
+        if (memcmp(&fleet_devices[i].addr, addr, sizeof(struct bd_addr)) == 0)
+        {
+            return &fleet_devices[i];
+        }
+    }
+
+    return NULL;
+}
+
+static struct fleet_device *fleet_device_of(ke_task_id_t src_id)
+{
+    uint8_t conidx = KE_IDX_GET(src_id);
+
+    if (conidx >= FLEET_MAX_CONNECTIONS || fleet_env.links[conidx] == NULL)
+    {
+        return NULL;
+    }
+    fleet_env.links[conidx]->t_activity = fleet_now();
+
+    return fleet_env.links[conidx];
+}
+
+/**
+ ****************************************************************************************
+ * @brief Every target was seen or the scanning attempts are exhausted: give up the
+ *        devices that were not found.
+ ****************************************************************************************
+ */
+static void fleet_scan_complete(void)
+{
+    unsigned int i, found = 0;
+
+    for (i = 0; i < fleet_device_count; i++)
+    {
+        found += fleet_devices[i].found;
+    }
+
+    if (found < fleet_device_count && fleet_env.scan_attempts_made < FLEET_MAX_SCANNING_ATTEMPTS)
+    {
+        return;
+    }
+
+    printf("%u of %u devices found\n", found, fleet_device_count);
+    fleet_env.scan_done = true;
+    fleet_env.t_begin = fleet_now();
+    fleet_env.t_progress = fleet_env.t_begin;
+
+    for (i = 0; i < fleet_device_count; i++)
+    {
+        if (!fleet_devices[i].found)
+        {
+            fleet_finish(&fleet_devices[i], FLEET_RES_NOT_FOUND, 0);
+        }
+    }
+}
+
+static void gapm_cmp_evt_handler(const struct gapm_cmp_evt *param)
+{
+    switch (param->operation)
+    {
+        case GAPM_RESET:
+        case GAPM_SET_DEV_CONFIG:
+            if (param->status != CO_ERROR_NO_ERROR)
+            {
+                fprintf(stderr, "Error: DA14585 configuration failed (operation %u, status 0x%02X)\n",
+                        param->operation, param->status);
+                fleet_env.fatal = true;
+            }
+            else if (param->operation == GAPM_RESET)
+            {
+                fleet_set_mode();
+            }
+            else
+            {
+                fleet_env.gapm_op = GAPM_NO_OP;
+                fleet_env.ready = true;
+                printf("Scanning...\n");
+            }
+            break;
+
+        case GAPM_SCAN_ACTIVE:
+        case GAPM_SCAN_PASSIVE:
+            fleet_env.gapm_op = GAPM_NO_OP;
+            fleet_scan_complete();
+            break;
+
+        case GAPM_CONNECTION_DIRECT:
+        {
+            struct fleet_device *dev = fleet_env.connecting;
+
+            fleet_env.gapm_op = GAPM_NO_OP;
+            fleet_env.connecting = NULL;
+
+            if (dev == NULL || dev->state != FLEET_CONNECTING)
+            {
+                break;
+            }
+
+            // not connected: try again later or give up
+            if (dev->connect_attempts < FLEET_MAX_CONNECT_ATTEMPTS)
+            {
+                dev->state = FLEET_PENDING;
+                fleet_env.active--;
+            }
+            else
+            {
+                fleet_finish(dev, FLEET_RES_CONNECT_FAILED, param->status);
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+static void gapm_dev_inq_result_handler(const struct gapm_adv_report_ind *param)
+{
+    struct fleet_device *dev;
+    unsigned int i;
+
+    if (fleet_env.gapm_op != GAPM_SCAN_ACTIVE)
+    {
+        return;
+    }
+
+    dev = fleet_device_find(&param->report.adv_addr);
+    if (dev == NULL || dev->found)
+    {
+        return;
+    }
+
+    dev->found = true;
+    dev->addr_type = param->report.adv_addr_type;
+
+    for (i = 0; i < fleet_device_count; i++)
+    {
+        if (!fleet_devices[i].found)
+        {
+            return;
+        }
+    }
+
+    // every target was found - cancel scan operation
+    fleet_cancel();
+}
+
+static void gapc_connection_req_ind_handler(const struct gapc_connection_req_ind *param, ke_task_id_t src_id)
+{
+    struct fleet_device *dev = fleet_device_find(&param->peer_addr);
+    uint8_t conidx = KE_IDX_GET(src_id);
+
+    if (dev == NULL || dev != fleet_env.connecting || conidx >= FLEET_MAX_CONNECTIONS)
+    {
+        // not requested
+        fleet_disconnect_conidx(conidx);
+        return;
+    }
+
+    dev->conidx = conidx;
+    dev->conhdl = param->conhdl;
+    dev->t_connect = fleet_now();
+    dev->t_activity = dev->t_connect;
+    dev->mtu = ATT_DEFAULT_MTU;
+    dev->tx_octets = LE_DEFAULT_PKT_SIZE;
+    dev->suota_version = 0;
+    dev->pd_char_size = 0;
+    dev->svc_start_handle = 0;
+    dev->svc_end_handle = 0;
+    dev->mem_dev_handle = 0;
+    dev->gpio_map_handle = 0;
+    dev->mem_info_handle = 0;
+    dev->patch_len_handle = 0;
+    dev->patch_data_handle = 0;
+    dev->serv_status_handle = 0;
+    dev->serv_status_cli_char_cfg_desc_handle = 0;
+    dev->suota_version_handle = 0;
+    dev->suota_mtu_handle = 0;
+    dev->pd_char_size_handle = 0;
+    fleet_env.links[conidx] = dev;
+
+    fleet_connect_confirm(dev);
+
+    dev->state = FLEET_DISC_SVC;
+    fleet_discover(dev, GATTC_DISC_BY_UUID_SVC, 0x0001, 0xFFFF, SUOTA_PRIMARY_SERVICE_UUID);
+}
+
+static void gapc_disconnect_ind_handler(const struct gapc_disconnect_ind *param, ke_task_id_t src_id)
+{
+    struct fleet_device *dev = fleet_device_of(src_id);
+
+    if (dev == NULL || dev->conhdl != param->conhdl)
+    {
+        return;
+    }
+
+    fleet_release(dev, param->reason);
+}
+
+static void gapc_cmp_evt_handler(const struct gapc_cmp_evt *param, ke_task_id_t src_id)
+{
+    struct fleet_device *dev = fleet_device_of(src_id);
+
+    if (dev == NULL || param->status == CO_ERROR_NO_ERROR)
+    {
+        return;
+    }
+
+    if (param->operation == GAPC_DISCONNECT)
+    {
+        // the link is already gone
+        fleet_release(dev, param->status);
+    }
+    else if (dev->state != FLEET_DISCONNECTING)
+    {
+        fleet_fail(dev, FLEET_RES_GATT_ERROR, param->status);
+    }
+}
+
+static void gapc_le_pkt_size_ind_handler(const struct gapc_le_pkt_size_ind *param, ke_task_id_t src_id)
+{
+    struct fleet_device *dev = fleet_device_of(src_id);
+    struct gattc_exc_mtu_cmd *req;
+
+    if (dev == NULL)
+    {
+        return;
+    }
+
+    dev->tx_octets = param->max_tx_octets;
+
+    if (dev->state == FLEET_DLE_NEGOTIATION)
+    {
+        req = fleet_msg_alloc(GATTC_EXC_MTU_CMD, KE_BUILD_ID(TASK_ID_GATTC, dev->conidx),
+                              sizeof(struct gattc_exc_mtu_cmd));
+        req->operation = GATTC_MTU_EXCH;
+        dev->state = FLEET_GATT_MTU_NEGOTIATION;
+        fleet_msg_send();
+    }
+}
+
+static void fleet_suota_write_mem_dev(struct fleet_device *dev)
+{
+    uint32_t address = (fleet_options.mem_type == SUOTA_MEM_DEV_I2C)
+                     ? fleet_options.i2c_options.patch_base_address
+                     : fleet_options.spi_options.patch_base_address;
+
+    dev->state = FLEET_WR_MEM_DEV;
+    fleet_write_mem_dev(dev, fleet_options.mem_type, address);
+}
+
+static void gattc_mtu_changed_ind_handler(const struct gattc_mtu_changed_ind *param, ke_task_id_t src_id)
+{
+    struct fleet_device *dev = fleet_device_of(src_id);
+
+    if (dev == NULL)
+    {
+        return;
+    }
+
+    dev->mtu = param->mtu;
+
+    if (dev->state == FLEET_GATT_MTU_NEGOTIATION)
+    {
+        fleet_suota_set_data_params(dev);
+        fleet_suota_write_mem_dev(dev);
+    }
+}
+
+static void gattc_disc_svc_ind_handler(const struct gattc_disc_svc_ind *param, ke_task_id_t src_id)
+{
+    struct fleet_device *dev = fleet_device_of(src_id);
+
+    if (dev != NULL && param->uuid_len == 2
+        && ((param->uuid[1] << 8) | param->uuid[0]) == SUOTA_PRIMARY_SERVICE_UUID)
+    {
+        dev->svc_start_handle = param->start_hdl;
+        dev->svc_end_handle = param->end_hdl;
+    }
+}
+
+static void gattc_disc_char_ind_handler(const struct gattc_disc_char_ind *param, ke_task_id_t src_id)
+{
+    struct fleet_device *dev = fleet_device_of(src_id);
+
+    // SUOTA characteristics have 128 bit UUIDs
+    if (dev == NULL || param->uuid_len != 16)
+    {
+        return;
+    }
+
+    if      ( 0 == memcmp(param->uuid, SUOTA_MEM_DEV_UUID, 16) ) { dev->mem_dev_handle = param->pointer_hdl; }
+    else if ( 0 == memcmp(param->uuid, SUOTA_GPIO_MAP_UUID, 16) ) { dev->gpio_map_handle = param->pointer_hdl; }
+    else if ( 0 == memcmp(param->uuid, SUOTA_MEM_INFO_UUID, 16) ) { dev->mem_info_handle = param->pointer_hdl; }
+    else if ( 0 == memcmp(param->uuid, SUOTA_PATCH_LEN_UUID, 16) ) { dev->patch_len_handle = param->pointer_hdl; }
+    else if ( 0 == memcmp(param->uuid, SUOTA_PATCH_DATA_UUID, 16) ) { dev->patch_data_handle = param->pointer_hdl; }
+    else if ( 0 == memcmp(param->uuid, SUOTA_SERV_STATUS_UUID, 16) ) { dev->serv_status_handle = param->pointer_hdl; }
+    else if ( 0 == memcmp(param->uuid, SUOTA_VERSION_UUID, 16) ) { dev->suota_version_handle = param->pointer_hdl; }
+    else if ( 0 == memcmp(param->uuid, SUOTA_MTU_UUID, 16) ) { dev->suota_mtu_handle = param->pointer_hdl; }
+    else if ( 0 == memcmp(param->uuid, SUOTA_PD_CHAR_SIZE_UUID, 16) ) { dev->pd_char_size_handle = param->pointer_hdl; }
+}
+
+static void gattc_disc_char_desc_ind_handler(const struct gattc_disc_char_desc_ind *param, ke_task_id_t src_id)
+{
+    struct fleet_device *dev = fleet_device_of(src_id);
+
+    if (dev != NULL && param->uuid_len == 2
+        && ((param->uuid[1] << 8) | param->uuid[0]) == CLIENT_CHARACTERISTIC_CONFIGURATION_DESCRIPTOR_UUID)
+    {
+        dev->serv_status_cli_char_cfg_desc_handle = param->attr_hdl;
+    }
+}
+
+static void gattc_read_ind_handler(const struct gattc_read_ind *param, ke_task_id_t src_id)
+{
+    struct fleet_device *dev = fleet_device_of(src_id);
+
+    if (dev == NULL || param->length == 0)
+    {
+        return;
+    }
+
+    if (param->handle == dev->suota_version_handle)
+    {
+        dev->suota_version = param->value[0];
+    }
+    else if (param->handle == dev->pd_char_size_handle && param->length >= 2)
+    {
+        dev->pd_char_size = (param->value[1] << 8) | param->value[0];
+    }
+}
+
+static void gattc_event_ind_handler(const struct gattc_event_ind *param, ke_task_id_t src_id)
+{
+    struct fleet_device *dev = fleet_device_of(src_id);
+    uint8_t status;
+
+    // handle notifications from SUOTA_SERV_STATUS only
+    if (dev == NULL || param->handle != dev->serv_status_handle || param->length == 0)
+    {
+        return;
+    }
+
+    status = param->value[0];
+
+    switch (dev->state)
+    {
+        case FLEET_WR_MEM_DEV:
+            if (status != SUOTA_STATUS_IMG_STARTED)
+            {
+                fleet_fail(dev, FLEET_RES_SUOTA_ERROR, status);
+                break;
+            }
+
+            // trigger next step - write SUOTA_GPIO_MAP
+            {
+                uint8_t v[4];
+
+                if (fleet_options.mem_type == SUOTA_MEM_DEV_I2C)
+                {
+                    v[3] = (fleet_options.i2c_options.i2c_device_address >> 8) & 0xFF;
+                    v[2] = fleet_options.i2c_options.i2c_device_address & 0xFF;
+                    v[1] = fleet_options.i2c_options.scl_gpio;
+                    v[0] = fleet_options.i2c_options.sda_gpio;
+                }
+                else
+                {
+                    v[3] = fleet_options.spi_options.miso_gpio;
+                    v[2] = fleet_options.spi_options.mosi_gpio;
+                    v[1] = fleet_options.spi_options.cs_gpio;
+                    v[0] = fleet_options.spi_options.sck_gpio;
+                }
+                dev->state = FLEET_WR_GPIO_MAP;
+                fleet_characteristic_write(dev, GATTC_WRITE, dev->gpio_map_handle, v, sizeof(v));
+            }
+            break;
+
+        case FLEET_WR_PATCH_LEN:
+        case FLEET_WR_PATCH_DATA:
+            if (status != SUOTA_STATUS_CMP_OK)
+            {
+                fleet_fail(dev, FLEET_RES_SUOTA_ERROR, status);
+                break;
+            }
+            dev->block_done = true;
+            fleet_suota_check_block(dev);
+            break;
+
+        case FLEET_WR_END_OF_SUOTA:
+            if (status != SUOTA_STATUS_CMP_OK)
+            {
+                fleet_fail(dev, FLEET_RES_SUOTA_ERROR, status);
+                break;
+            }
+
+            // SUOTA procedure completed successfully - reboot the device and disconnect
+            dev->result = FLEET_RES_OK;
+            fleet_write_mem_dev(dev, SUOTA_REBOOT, 0);
+            fleet_fail(dev, FLEET_RES_OK, 0);
+            break;
+
+        default:
+            // no handling of notifications in the rest of the states
+            break;
+    }
+}
+
+static void gattc_cmp_evt_handler(const struct gattc_cmp_evt *param, ke_task_id_t src_id)
+{
+    struct fleet_device *dev = fleet_device_of(src_id);
+
+    if (dev == NULL || dev->state == FLEET_DISCONNECTING)
+    {
+        return;
+    }
+
+    if (param->status != CO_ERROR_NO_ERROR && param->status != ATT_ERR_ATTRIBUTE_NOT_FOUND)
+    {
+        if (param->status == ATT_ERR_INSUFF_AUTHEN || param->status == ATT_ERR_INSUFF_ENC)
+        {
+            printf("%s requires pairing, which the fleet initiator does not do\n", fleet_bdaddr_str(&dev->addr));
+        }
+        fleet_fail(dev, FLEET_RES_GATT_ERROR, param->status);
+        return;
+    }
+
+    switch (param->operation)
+    {
+        case GATTC_DISC_BY_UUID_SVC:
+            if (dev->svc_start_handle == 0)
+            {
+                fleet_fail(dev, FLEET_RES_NO_SERVICE, 0);
+                break;
+            }
+            // SUOTA service was discovered. Now discover SUOTA characteristics.
+            dev->state = FLEET_DISC_CHAR;
+            fleet_discover(dev, GATTC_DISC_ALL_CHAR, dev->svc_start_handle, dev->svc_end_handle, 0);
+            break;
+
+        case GATTC_DISC_ALL_CHAR:
+            if (dev->mem_dev_handle == 0 || dev->gpio_map_handle == 0 || dev->mem_info_handle == 0
+                || dev->patch_len_handle == 0 || dev->patch_data_handle == 0 || dev->serv_status_handle == 0)
+            {
+                fleet_fail(dev, FLEET_RES_NO_SERVICE, 0);
+                break;
+            }
+            // discover SUOTA_SERV_STATUS Client char descriptor
+            dev->state = FLEET_DISC_DESC;
+            fleet_discover(dev, GATTC_DISC_DESC_CHAR, dev->serv_status_handle, dev->svc_end_handle, 0);
+            break;
+
+        case GATTC_DISC_DESC_CHAR:
+            if (dev->serv_status_cli_char_cfg_desc_handle == 0)
+            {
+                fleet_fail(dev, FLEET_RES_NO_SERVICE, 0);
+                break;
+            }
+            // enable SUOTA_SERV_STATUS notifications
+            {
+                uint8_t v[2] = {0x01, 0x00};
+
+                dev->state = FLEET_EN_SERV_STATUS_NOTIFICATIONS;
+                fleet_characteristic_write(dev, GATTC_WRITE, dev->serv_status_cli_char_cfg_desc_handle, v, sizeof(v));
+            }
+            break;
+
+        case GATTC_WRITE_NO_RESPONSE:
+            if (dev->state == FLEET_WR_PATCH_DATA && dev->acked_offset < dev->sent_offset)
+            {
+                uint16_t len = co_min(dev->chunk_size, dev->block_length - dev->acked_offset);
+
+                dev->acked_offset += len;
+                fleet_env.inflight_bytes -= len;
+                fleet_env.bytes_acked += len;
+                fleet_suota_check_block(dev);
+            }
+            break;
+
+        case GATTC_WRITE:
+            switch (dev->state)
+            {
+                case FLEET_EN_SERV_STATUS_NOTIFICATIONS:
+                    if (dev->suota_version_handle != 0)
+                    {
+                        dev->state = FLEET_RD_SUOTA_VERSION;
+                        fleet_characteristic_read(dev, dev->suota_version_handle);
+                    }
+                    else
+                    {
+                        // SUOTA version 1.0: default MTU and chunk size
+                        fleet_suota_set_data_params(dev);
+                        fleet_suota_write_mem_dev(dev);
+                    }
+                    break;
+
+                case FLEET_WR_GPIO_MAP:
+                    dev->state = FLEET_RD_MEM_INFO;
+                    fleet_characteristic_read(dev, dev->mem_info_handle);
+                    break;
+
+                case FLEET_WR_PATCH_LEN:
+                    dev->state = FLEET_WR_PATCH_DATA;
+                    break;
+
+                default:
+                    // SUOTA_MEM_DEV written - wait for notification on SUOTA_SERV_STATUS
+                    break;
+            }
+            break;
+
+        case GATTC_READ:
+            switch (dev->state)
+            {
+                case FLEET_RD_SUOTA_VERSION:
+                    if (dev->suota_version >= SUOTA_VERSION_1_3 && dev->pd_char_size_handle != 0)
+                    {
+                        dev->state = FLEET_RD_PD_CHAR_SIZE;
+                        fleet_characteristic_read(dev, dev->pd_char_size_handle);
+                    }
+                    else
+                    {
+                        fleet_suota_set_data_params(dev);
+                        fleet_suota_write_mem_dev(dev);
+                    }
+                    break;
+
+                case FLEET_RD_PD_CHAR_SIZE:
+                {
+                    struct gapc_set_le_pkt_size_cmd *req = fleet_msg_alloc(GAPC_SET_LE_PKT_SIZE_CMD,
+                                                                           KE_BUILD_ID(TASK_ID_GAPC, dev->conidx),
+                                                                           sizeof(struct gapc_set_le_pkt_size_cmd));
+
+                    req->operation = GAPC_SET_LE_PKT_SIZE;
+                    req->tx_octets = MAX_LE_PKT_SIZE;
+                    req->tx_time = MAX_LE_TX_TIME;
+                    dev->state = FLEET_DLE_NEGOTIATION;
+                    fleet_msg_send();
+                    break;
+                }
+
+                case FLEET_RD_MEM_INFO:
+                    // write SUOTA_PATCH_LEN of 1st block
+                    dev->t_start = fleet_now();
+                    dev->block_offset = 0;
+                    dev->block_length = 0;
+                    fleet_suota_start_block(dev);
+                    break;
+
+                case FLEET_RD_MEM_INFO_2:
+                    // send END OF SUOTA
+                    dev->state = FLEET_WR_END_OF_SUOTA;
+                    fleet_write_mem_dev(dev, SUOTA_END, 0);
+                    break;
+
+                default:
+                    break;
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+void fleet_handle_msg(const ble_hdr *msg, const void *param)
+{
+    if (msg->bDstid != TASK_ID_GTL)
+    {
+        return;
+    }
+
+    switch (msg->bType)
+    {
+        case GAPM_DEVICE_READY_IND:
+            fleet_rst_gap();
+            break;
+
+        case GAPM_CMP_EVT:
+            gapm_cmp_evt_handler(param);
+            break;
+
+        case GAPM_ADV_REPORT_IND:
+            gapm_dev_inq_result_handler(param);
+            break;
+
+        case GAPC_CONNECTION_REQ_IND:
+            gapc_connection_req_ind_handler(param, msg->bSrcid);
+            break;
+
+        case GAPC_DISCONNECT_IND:
+            gapc_disconnect_ind_handler(param, msg->bSrcid);
+            break;
+
+        case GAPC_CMP_EVT:
+            gapc_cmp_evt_handler(param, msg->bSrcid);
+            break;
+
+        case GAPC_LE_PKT_SIZE_IND:
+            gapc_le_pkt_size_ind_handler(param, msg->bSrcid);
+            break;
+
+        case GATTC_DISC_SVC_IND:
+            gattc_disc_svc_ind_handler(param, msg->bSrcid);
+            break;
+
+        case GATTC_DISC_CHAR_IND:
+            gattc_disc_char_ind_handler(param, msg->bSrcid);
+            break;
+
+        case GATTC_DISC_CHAR_DESC_IND:
+            gattc_disc_char_desc_ind_handler(param, msg->bSrcid);
+            break;
+
+        case GATTC_READ_IND:
+            gattc_read_ind_handler(param, msg->bSrcid);
+            break;
+
+        case GATTC_EVENT_IND:
+            gattc_event_ind_handler(param, msg->bSrcid);
+            break;
+
+        case GATTC_MTU_CHANGED_IND:
+            gattc_mtu_changed_ind_handler(param, msg->bSrcid);
+            break;
+
+        case GATTC_CMP_EVT:
+            gattc_cmp_evt_handler(param, msg->bSrcid);
+            break;
+
+        default:
+            break;
+    }
+
+    // refill the windows opened by the completions
+    fleet_suota_fill_windows();
+}
+
+/*
+ * SCHEDULING
+ ****************************************************************************************
+ */
+
+void fleet_start(void)
+{
+    memset(&fleet_env, 0, sizeof(fleet_env));
+
+    printf("Waiting for DA14585 Device\n");
+    fleet_rst_gap();
+}
+
+void fleet_poll(void)
+{
+    double now = fleet_now();
+    unsigned int i;
+
+    // sessions that stopped answering
+    for (i = 0; i < FLEET_MAX_CONNECTIONS; i++)
+    {
+        struct fleet_device *dev = fleet_env.links[i];
+
+        if (dev == NULL)
+        {
+            continue;
+        }
+        if (dev->state == FLEET_DISCONNECTING)
+        {
+            if (now - dev->t_activity > FLEET_DISCONNECT_TIMEOUT_MS / 1000.0)
+            {
+                fleet_release(dev, CO_ERROR_CON_TIMEOUT);
+            }
+        }
+        else if (now - dev->t_activity > FLEET_SESSION_TIMEOUT_MS / 1000.0)
+        {
+            fleet_fail(dev, FLEET_RES_TIMEOUT, dev->state);
+        }
+    }
+
+    if (fleet_env.gapm_op == GAPM_CONNECTION_DIRECT && !fleet_env.cancel_sent && now > fleet_env.connect_deadline)
+    {
+        fleet_cancel();
+        fleet_env.cancel_sent = true;
+    }
+
+    if (!fleet_env.ready || fleet_env.gapm_op != GAPM_NO_OP)
+    {
+        return;
+    }
+
+    if (!fleet_env.scan_done)
+    {
+        fleet_inq();
+        return;
+    }
+
+    // start the next session
+    if (fleet_env.active < fleet_options.concurrency)
+    {
+        for (i = 0; i < fleet_device_count; i++)
+        {
+            if (fleet_devices[i].state == FLEET_PENDING && fleet_devices[i].found)
+            {
+                fleet_env.active++;
+                fleet_connect(&fleet_devices[i]);
+                break;
+            }
+        }
+    }
+
+    if (now - fleet_env.t_progress >= FLEET_PROGRESS_PERIOD_S)
+    {
+        fleet_env.t_progress = now;
+        printf("%u/%u devices done, %u in progress, %.2f KB/s\n", fleet_env.done, fleet_device_count,
+               fleet_env.active, fleet_env.bytes_acked / (now - fleet_env.t_begin) / 1024);
+    }
+}
+
+bool fleet_finished(void)
+{
+    return fleet_env.fatal || fleet_env.done == fleet_device_count;
+}
@@ -0,0 +1,627 @@
+/**
+ ****************************************************************************************
+ *
+ * @file fleet_main.c
+ *
+ * @brief SUOTA fleet initiator: command line, image loading and report.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "fleet.h"
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+#define DEFAULT_BAUDRATE        (115200)
+#define DEFAULT_CONCURRENCY     (4)
+
+/// Longest wait for the DA14585 between two runs of fleet_poll()
+#define FLEET_POLL_PERIOD_MS    (5)
+
+/*
+ * GLOBAL VARIABLE DEFINITIONS
+ ****************************************************************************************
+ */
+
+struct fleet_options fleet_options;
+
+struct fleet_device fleet_devices[FLEET_MAX_DEVICES];
+unsigned int fleet_device_count;
+
+uint32_t patch_length;
+uint8_t patch_data[MAX_IMAGE_SIZE + CHECKSUM_SIZE];
+
+ht_transport fleet_transport;
+
+typedef struct
+{
+    const char *name;
+    uint8_t code;
+} gpio_name_t;
+
+static const gpio_name_t gpio_names[] = {
+    {"P0_0", 0x00}, {"P0_1", 0x01}, {"P0_2", 0x02}, {"P0_3", 0x03},
+    {"P0_4", 0x04}, {"P0_5", 0x05}, {"P0_6", 0x06}, {"P0_7", 0x07},
+
+    {"P1_0", 0x10}, {"P1_1", 0x11}, {"P1_2", 0x12}, {"P1_3", 0x13},
+
+    {"P2_0", 0x20}, {"P2_1", 0x21}, {"P2_2", 0x22}, {"P2_3", 0x23}, {"P2_4", 0x24},
+    {"P2_5", 0x25}, {"P2_6", 0x26}, {"P2_7", 0x27}, {"P2_8", 0x28}, {"P2_9", 0x29},
+
+    {"P3_0", 0x30}, {"P3_1", 0x31}, {"P3_2", 0x32}, {"P3_3", 0x33},
+    {"P3_4", 0x34}, {"P3_5", 0x35}, {"P3_6", 0x36}, {"P3_7", 0x37},
+
+    {0, 0} // end marker
+};
+
+/*
+ * FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+double fleet_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+const char *fleet_bdaddr_str(const struct bd_addr *addr)
+{
+    static char str[18];
+
+    snprintf(str, sizeof(str), "%02X:%02X:%02X:%02X:%02X:%02X",
+             addr->addr[5], addr->addr[4], addr->addr[3], addr->addr[2], addr->addr[1], addr->addr[0]);
+
+    return str;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Parse string GPIO name and return a GPIO code.
+ *
+ * @param[in] s  GPIO name
+ *
+ * @return GPIO code, INVALID_GPIO if unknown
+ ****************************************************************************************
+ */
+static uint8_t parse_gpio(const char *s)
+{
+    int kk;
+
+    for (kk = 0; gpio_names[kk].name != 0; kk++)
+    {
+        if (0 == strcmp(gpio_names[kk].name, s))
+        {
+            return gpio_names[kk].code;
+        }
+    }
+
+    return INVALID_GPIO;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Add a target device.
+ *
+ * @param[in] s  BD address, e.g. 11:89:55:45:23:01.
+ *
+ * @return 0 on success, -1 on failure
+ ****************************************************************************************
+ */
+static int add_target(const char *s)
+{
+    unsigned int bdaddr[6];
+    struct fleet_device *dev;
+    unsigned int i;
+
+    if (6 != sscanf(s, "%02X:%02X:%02X:%02X:%02X:%02X",
+                    &bdaddr[5], &bdaddr[4], &bdaddr[3], &bdaddr[2], &bdaddr[1], &bdaddr[0]))
+    {
+        printf("invalid BD address \"%s\" \n", s);
+        return -1;
+    }
+
+    if (fleet_device_count == FLEET_MAX_DEVICES)
+    {
+        printf("too many target devices, at most %d \n", FLEET_MAX_DEVICES);
+        return -1;
+    }
+
+    dev = &fleet_devices[fleet_device_count];
+    memset(dev, 0, sizeof(*dev));
+    for (i = 0; i < 6; i++)
+    {
+        dev->addr.addr[i] = bdaddr[i] & 0xFF;
+    }
+
+    for (i = 0; i < fleet_device_count; i++)
+    {
+        if (0 == memcmp(&fleet_devices[i].addr, &dev->addr, sizeof(struct bd_addr)))
+        {
+            // listed twice
+            return 0;
+        }
+    }
+    fleet_device_count++;
+
+    return 0;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Add the target devices of a comma separated list of BD addresses, or of a file
+ *        with one BD address per line if the list starts with '@'.
+ *
+ * @return 0 on success, -1 on failure
+ ****************************************************************************************
+ */
+static int parse_targets(const char *list)
+{
+    char line[128];
+
+    if (list[0] == '@')
+    {
+        FILE *f = fopen(list + 1, "r");
+        int rc = 0;
+
+        if (f == NULL)
+        {
+            printf("could not open \"%s\" \n", list + 1);
+            return -1;
+        }
+
+        while (rc == 0 && fgets(line, sizeof(line), f) != NULL)
+        {
+            char *s = line + strspn(line, " \t");
+
+            s[strcspn(s, " \t\r\n#")] = '\0';
+            if (s[0] != '\0')
+            {
+                rc = add_target(s);
+            }
+        }
+        fclose(f);
+
+        return rc;
+    }
+
+    while (*list != '\0')
+    {
+        size_t len = strcspn(list, ",");
+
+        if (len >= sizeof(line))
+        {
+            printf("invalid BD address list \n");
+            return -1;
+        }
+        memcpy(line, list, len);
+        line[len] = '\0';
+
+        if (len && add_target(line) != 0)
+        {
+            return -1;
+        }
+        list += len + (list[len] == ',');
+    }
+
+    return 0;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Parse <mem_dev_opts> as the single device initiator does.
+ *
+ * @return 0 on success, -1 on failure
+ ****************************************************************************************
+ */
+static int parse_mem_dev_opts(int argc, char **argv)
+{
+    unsigned int patch_base_addr;
+    unsigned int block_size;
+
+    if (argc < 1)
+    {
+        printf("missing memory type \n");
+        return -1;
+    }
+
+    if (0 == strcmp(argv[0], "i2c"))
+    {
+        unsigned int i2c_addr;
+
+        // i2c options:  <patch base addr>  <I2C device address> <SCL gpio>  <SDA gpio>  <SUOTA block size>
+        if (argc != 6) { printf("wrong number of parameters \n"); return -1; }
+
+        if (sscanf(argv[1], "%x", &patch_base_addr) != 1) { printf("invalid patch base address \n"); return -1; }
+        if (sscanf(argv[2], "%x", &i2c_addr) != 1) { printf("invalid i2c_addr \n"); return -1; }
+
+        fleet_options.mem_type = SUOTA_MEM_DEV_I2C;
+        fleet_options.i2c_options.patch_base_address = patch_base_addr;
+        fleet_options.i2c_options.i2c_device_address = i2c_addr & 0xFFFF;
+
+        fleet_options.i2c_options.scl_gpio = parse_gpio(argv[3]);
+        if (fleet_options.i2c_options.scl_gpio == INVALID_GPIO) { printf("invalid gpio \"%s\" for SCL \n", argv[3]); return -1; }
+
+        fleet_options.i2c_options.sda_gpio = parse_gpio(argv[4]);
+        if (fleet_options.i2c_options.sda_gpio == INVALID_GPIO) { printf("invalid gpio \"%s\" for SDA \n", argv[4]); return -1; }
+
+        block_size = atoi(argv[5]);
+    }
+    else if (0 == strcmp(argv[0], "spi"))
+    {
+        // spi options: <patch base addr>  <MISO gpio> <MOSI gpio> <CS gpio>  <SCK gpio>  <SUOTA block size>
+        if (argc != 7) { printf("wrong number of parameters \n"); return -1; }
+
+        if (sscanf(argv[1], "%x", &patch_base_addr) != 1) { printf("invalid patch base address \n"); return -1; }
+
+        fleet_options.mem_type = SUOTA_MEM_DEV_SPI;
+        fleet_options.spi_options.patch_base_address = patch_base_addr;
+
+        fleet_options.spi_options.miso_gpio = parse_gpio(argv[2]);
+        if (fleet_options.spi_options.miso_gpio == INVALID_GPIO) { printf("invalid gpio \"%s\" for MISO \n", argv[2]); return -1; }
+
+        fleet_options.spi_options.mosi_gpio = parse_gpio(argv[3]);
+        if (fleet_options.spi_options.mosi_gpio == INVALID_GPIO) { printf("invalid gpio \"%s\" for MOSI \n", argv[3]); return -1; }
+
+        fleet_options.spi_options.cs_gpio = parse_gpio(argv[4]);
+        if (fleet_options.spi_options.cs_gpio == INVALID_GPIO) { printf("invalid gpio \"%s\" for CS \n", argv[4]); return -1; }
+
+        fleet_options.spi_options.sck_gpio = parse_gpio(argv[5]);
+        if (fleet_options.spi_options.sck_gpio == INVALID_GPIO) { printf("invalid gpio \"%s\" for SCK \n", argv[5]); return -1; }
+
+        block_size = atoi(argv[6]);
+    }
+    else
+    {
+        printf("invalid memory type \"%s\" \n", argv[0]);
+        return -1;
+    }
+
+    if (block_size == 0 || block_size > 0xFFFF)
+    {
+        printf("invalid block size: %s \n", argv[argc - 1]);
+        return -1;
+    }
+    fleet_options.block_size = block_size;
+
+    return 0;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Load the image and append its XOR checksum.
+ *
+ * @return 0 on success, -1 on failure
+ ****************************************************************************************
+ */
+static int patch_data_load_bin(const char *bin_filename)
+{
+    FILE *f;
+    size_t kk;
+    uint8_t crc_code = 0;
+    uint32_t i;
+
+    f = fopen(bin_filename, "rb");
+    if (f == NULL)
+    {
+        printf("could not open \"%s\" \n", bin_filename);
+        return -1;
+    }
+
+    kk = fread(patch_data, 1, MAX_IMAGE_SIZE + 1, f);
+    fclose(f);
+
+    if (kk == 0 || kk > MAX_IMAGE_SIZE)
+    {
+        printf("invalid image size, the image must be 1 to %d bytes \n", MAX_IMAGE_SIZE);
+        return -1;
+    }
+
+    for (i = 0; i < kk; i++)
+    {
+        crc_code ^= patch_data[i];
+    }
+    patch_data[kk] = crc_code;
+    patch_length = kk + CHECKSUM_SIZE;
+
+    return 0;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Print usage message in standard output
+ ****************************************************************************************
+ */
+static void print_usage(void)
+{
+    printf("SUOTA fleet initiator v_%s\n\n", FLEET_VERSION);
+    printf("Usage: \n");
+    printf("\t fleet_initiator [options] <port> <targets> <.bin file> <mem_dev_opts> \n");
+    printf("\t fleet_initiator [options] -S <count> <.bin file> <mem_dev_opts> \n\n");
+
+    printf("<port>            = the serial port of the full embedded DA14585 (GTL), e.g. /dev/ttyUSB0. \n");
+    printf("<targets>         = comma separated BD addresses of the SUOTA receivers, e.g. 11:89:55:45:23:01,11:89:55:45:23:02, \n");
+    printf("                    or @file with one BD address per line. \n");
+    printf("<.bin file>       = the binary file containing the image. \n");
+    printf("<mem_dev_opts>    = i2c <i2c_dev_opts> | spi <spi_dev_opts> \n");
+    printf("<i2c_dev_opts>    = <image bank>  <I2C device addr> <SCL gpio>  <SDA gpio>  <block size>\n");
+    printf("<spi_dev_opts>    = <image bank>  <MISO gpio> <MOSI gpio> <CS gpio>  <SCK gpio>  <block size> \n");
+    printf("                    as for the single device initiator (host_suotai). \n\n");
+
+    printf("Options: \n");
+    printf("  -c <sessions>   SUOTA sessions in flight, 1 to %d (default %d). \n", FLEET_MAX_CONNECTIONS, DEFAULT_CONCURRENCY);
+    printf("  -w <chunks>     chunk writes in flight per link (default: sized from the MTU and the LL packet size). \n");
+    printf("  -B              write whole blocks at once, as the single device initiator does. \n");
+    printf("  -W <bytes>      chunk bytes in flight for all the links (default %d). \n", FLEET_INFLIGHT_BYTES);
+    printf("  -b <baudrate>   UART baud rate (default %d). \n", DEFAULT_BAUDRATE);
+    printf("  -o <file>       write a JSON report of every device. \n");
+    printf("  -S <count>      run against <count> simulated SUOTA receivers instead of <port> and <targets>. \n");
+    printf("  -e <n>          make every n-th simulated receiver fail. \n");
+}
+
+static int parse_cmd_line_args(int argc, char **argv)
+{
+    int opt;
+
+    fleet_options.baudrate = DEFAULT_BAUDRATE;
+    fleet_options.concurrency = DEFAULT_CONCURRENCY;
+    fleet_options.inflight_bytes = FLEET_INFLIGHT_BYTES;
+
+    while ((opt = getopt(argc, argv, "c:w:BW:b:o:S:e:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'c': fleet_options.concurrency = atoi(optarg); break;
+            case 'w': fleet_options.window = atoi(optarg); break;
+            case 'B': fleet_options.block_burst = true; break;
+            case 'W': fleet_options.inflight_bytes = atoi(optarg); break;
+            case 'b': fleet_options.baudrate = atoi(optarg); break;
+            case 'o': fleet_options.report_name = optarg; break;
+            case 'S': fleet_options.sim_count = atoi(optarg); break;
+            case 'e': fleet_options.sim_faulty_every = atoi(optarg); break;
+            default: return -1;
+        }
+    }
+
+    if (fleet_options.concurrency < 1 || fleet_options.concurrency > FLEET_MAX_CONNECTIONS)
+    {
+        printf("invalid number of sessions, 1 to %d \n", FLEET_MAX_CONNECTIONS);
+        return -1;
+    }
+    if (fleet_options.window > FLEET_WINDOW_MAX)
+    {
+        printf("invalid window, at most %d \n", FLEET_WINDOW_MAX);
+        return -1;
+    }
+    if (fleet_options.baudrate == 0 || fleet_options.inflight_bytes == 0)
+    {
+        printf("invalid baud rate or in flight bytes \n");
+        return -1;
+    }
+
+    argc -= optind;
+    argv += optind;
+
+    if (fleet_options.sim_count)
+    {
+        unsigned int i;
+
+        if (fleet_options.sim_count > FLEET_MAX_DEVICES)
+        {
+            printf("too many simulated devices, at most %d \n", FLEET_MAX_DEVICES);
+            return -1;
+        }
+        for (i = 0; i < fleet_options.sim_count; i++)
+        {
+            fleet_sim_bdaddr(i, &fleet_devices[i].addr);
+        }
+        fleet_device_count = fleet_options.sim_count;
+    }
+    else
+    {
+        if (argc < 2)
+        {
+            printf("missing arguments \n");
+            return -1;
+        }
+        fleet_options.port = argv[0];
+        if (parse_targets(argv[1]) != 0)
+        {
+            return -1;
+        }
+        argc -= 2;
+        argv += 2;
+    }
+
+    if (fleet_device_count == 0 || argc < 1)
+    {
+        printf("missing arguments \n");
+        return -1;
+    }
+    fleet_options.bin_file_name = argv[0];
+
+    return parse_mem_dev_opts(argc - 1, argv + 1);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Print the summary of the run and write the JSON report.
+ *
+ * @return number of devices not updated
+ ****************************************************************************************
+ */
+static unsigned int report(double t_total)
+{
+    unsigned int i, ok = 0;
+    double device_seconds = 0;
+    FILE *f = NULL;
+
+    if (fleet_options.report_name)
+    {
+        f = fopen(fleet_options.report_name, "w");
+        if (f == NULL)
+        {
+            printf("could not create \"%s\" \n", fleet_options.report_name);
+        }
+        else
+        {
+            fprintf(f, "{\n  \"image\": \"%s\",\n  \"image_size\": %u,\n  \"sessions\": %u,\n",
+                    fleet_options.bin_file_name, patch_length, fleet_options.concurrency);
+            fprintf(f, "  \"seconds\": %.3f,\n  \"devices\": [\n", t_total);
+        }
+    }
+
+    for (i = 0; i < fleet_device_count; i++)
+    {
+        const struct fleet_device *dev = &fleet_devices[i];
+        double t = (dev->result == FLEET_RES_OK) ? dev->t_end - dev->t_start : 0;
+
+        if (dev->result == FLEET_RES_OK)
+        {
+            ok++;
+            device_seconds += t;
+        }
+
+        if (f != NULL)
+        {
+            fprintf(f, "    {\"bdaddr\": \"%s\", \"result\": \"%s\", \"status\": %u, "
+                       "\"seconds\": %.3f, \"mtu\": %u, \"tx_octets\": %u, \"chunk\": %u, \"window\": %u}%s\n",
+                    fleet_bdaddr_str(&dev->addr), fleet_result_str(dev->result), dev->status,
+                    t, dev->mtu, dev->tx_octets, dev->chunk_size, dev->window,
+                    (i + 1 < fleet_device_count) ? "," : "");
+        }
+    }
+
+    if (f != NULL)
+    {
+        fprintf(f, "  ]\n}\n");
+        fclose(f);
+    }
+
+    printf("\n%u of %u devices updated in %.2f s", ok, fleet_device_count, t_total);
+    if (ok)
+    {
+        printf(", %.2f KB/s aggregate, %.2f s per device",
+               (double) ok * patch_length / t_total / 1024, device_seconds / ok);
+    }
+    printf("\n");
+
+    return fleet_device_count - ok;
+}
+
+int main(int argc, char **argv)
+{
+    char sim_port[64];
+    pid_t sim_pid = -1;
+    double t_begin;
+    unsigned int failed;
+
+    if (parse_cmd_line_args(argc, argv) != 0)
+    {
+        print_usage();
+        return 1;
+    }
+
+    if (patch_data_load_bin(fleet_options.bin_file_name) != 0)
+    {
+        return 1;
+    }
+
+    if (fleet_options.sim_count)
+    {
+        sim_pid = fleet_sim_start(fleet_options.sim_count, fleet_options.sim_faulty_every,
+                                  fleet_options.baudrate, sim_port, sizeof(sim_port));
+        if (sim_pid < 0)
+        {
+            printf("could not start the simulator \n");
+            return 1;
+        }
+        fleet_options.port = sim_port;
+    }
+
+    ht_transport_init(&fleet_transport, HT_FILTER(HT_PKT_GTL), NULL, NULL);
+    if (ht_port_open(&fleet_transport.port, fleet_options.port, fleet_options.baudrate, false) != 0)
+    {
+        printf("could not open \"%s\" \n", fleet_options.port);
+        failed = fleet_device_count;
+        goto exit;
+    }
+
+    printf("%u devices, image %s (%u bytes with checksum), %u sessions\n", fleet_device_count,
+           fleet_options.bin_file_name, patch_length, fleet_options.concurrency);
+
+    t_begin = fleet_now();
+    fleet_start();
+
+    while (!fleet_finished())
+    {
+        const ht_frame *frame;
+
+        if (ht_transport_rx_poll(&fleet_transport, FLEET_POLL_PERIOD_MS) < 0)
+        {
+            printf("could not read \"%s\" \n", fleet_options.port);
+            break;
+        }
+
+        while ((frame = ht_queue_peek(&fleet_transport.queue)) != NULL)
+        {
+            if (frame->length >= sizeof(ble_hdr))
+            {
+                fleet_handle_msg((const ble_hdr *) frame->data, frame->data + sizeof(ble_hdr));
+            }
+            ht_queue_release(&fleet_transport.queue);
+        }
+
+        fleet_poll();
+    }
+
+    failed = report(fleet_now() - t_begin);
+
+    ht_port_close(&fleet_transport.port);
+
+exit:
+    if (sim_pid > 0)
+    {
+        kill(sim_pid, SIGTERM);
+        waitpid(sim_pid, NULL, 0);
+    }
+
+    return failed ? 2 : 0;
+}
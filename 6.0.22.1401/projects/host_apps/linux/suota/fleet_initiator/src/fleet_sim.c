@@ -0,0 +1,1195 @@
+/**
+ ****************************************************************************************
+ *
+ * @file fleet_sim.c
+ *
+ * @brief Simulated DA14585 GTL firmware with SUOTA receivers for the fleet initiator.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "fleet.h"
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Message heap of the DA14585 GTL firmware for CFG_CON 8
+#define SIM_HEAP_SIZE           (6880)
+/// Kernel header of a message in the heap
+#define SIM_MSG_HEADER_SIZE     (12)
+/// GATTC operations queued per link
+#define SIM_LINK_OPS            (256)
+#define SIM_MAX_TIMERS          (2 * FLEET_MAX_DEVICES + 64)
+#define SIM_TX_BUFFER_SIZE      (256 * 1024)
+
+#define SIM_SCAN_DURATION_S     (1.0)
+#define SIM_CONNECT_DELAY_S     (0.03)
+
+/// Flash sector erase and page program times of the SUOTA receiver
+#define SIM_SECTOR_SIZE         (4096)
+#define SIM_SECTOR_ERASE_S      (0.045)
+#define SIM_PAGE_SIZE           (256)
+#define SIM_PAGE_PROGRAM_S      (0.0007)
+
+/// Image bytes after which a faulty receiver drops its link
+#define SIM_LINK_LOSS_BYTES     (8192)
+
+/// SUOTA receiver GATT database, see suotar.c
+enum
+{
+    SIM_SVC_START_HDL    = 0x20,
+    SIM_MEM_DEV_HDL      = 0x22,
+    SIM_GPIO_MAP_HDL     = 0x24,
+    SIM_MEM_INFO_HDL     = 0x26,
+    SIM_PATCH_LEN_HDL    = 0x28,
+    SIM_PATCH_DATA_HDL   = 0x2A,
+    SIM_SERV_STATUS_HDL  = 0x2C,
+    SIM_SERV_STATUS_CCCD = 0x2D,
+    SIM_VERSION_HDL      = 0x2F,
+    SIM_PD_CHAR_SIZE_HDL = 0x31,
+    SIM_MTU_HDL          = 0x33,
+    SIM_SVC_END_HDL      = 0x40,
+};
+
+#define SIM_PEER_MTU            (247)
+#define SIM_PEER_PD_CHAR_SIZE   (244)
+
+enum sim_fault
+{
+    SIM_FAULT_NONE,
+    /// Wrong image CRC at the end of SUOTA
+    SIM_FAULT_CRC,
+    /// Link lost in the middle of the image
+    SIM_FAULT_LINK_LOSS,
+};
+
+enum sim_timer_type
+{
+    SIM_T_ADV,
+    SIM_T_SCAN_END,
+    SIM_T_CONNECTED,
+    SIM_T_DISCONNECTED,
+    SIM_T_NOTIFY,
+};
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+struct sim_peer
+{
+    struct bd_addr addr;
+    uint8_t fault;
+};
+
+/// GATTC or GAPC operation of a link
+struct sim_op
+{
+    uint16_t msg_id;
+    uint8_t operation;
+    uint16_t handle;
+    uint16_t length;
+    uint8_t value[4];
+    /// Heap bytes of the message
+    uint16_t heap;
+    /// LL packets still to send
+    uint16_t pdus;
+    /// Time of the response of the peer, 0 before the request is sent
+    double resp_at;
+};
+
+struct sim_link
+{
+    bool used;
+    unsigned int peer;
+    uint16_t conhdl;
+
+    double interval;
+    double ce_len;
+    double next_event;
+    uint16_t tx_octets;
+
+    struct sim_op ops[SIM_LINK_OPS];
+    unsigned int head;
+    unsigned int count;
+
+    // SUOTA receiver
+    uint8_t mem_dev;
+    uint16_t patch_len;
+    uint16_t block_received;
+    uint32_t received;
+    uint8_t crc;
+    uint32_t erased_end;
+    double flash_free_at;
+};
+
+struct sim_timer
+{
+    double at;
+    uint8_t type;
+    uint8_t conidx;
+    uint8_t status;
+    uint16_t conhdl;
+    unsigned int peer;
+};
+
+/*
+ * LOCAL VARIABLE DEFINITIONS
+ ****************************************************************************************
+ */
+
+static struct sim_peer *sim_peers;
+static unsigned int sim_peer_count;
+static struct sim_link sim_links[FLEET_MAX_CONNECTIONS];
+static struct sim_timer sim_timers[SIM_MAX_TIMERS];
+static unsigned int sim_timer_count;
+
+static int sim_fd;
+static double sim_bytes_per_s;
+static double sim_rx_tokens;
+static double sim_tx_tokens;
+static double sim_last;
+static uint8_t sim_tx[SIM_TX_BUFFER_SIZE];
+static size_t sim_tx_head;
+static size_t sim_tx_len;
+
+static ht_parser sim_parser;
+static ht_queue sim_queue;
+static ht_stats sim_stats;
+
+static uint32_t sim_heap_used;
+static double sim_radio_free_at;
+static uint16_t sim_next_conhdl;
+static bool sim_scanning;
+static unsigned int sim_connecting_peer = ~0U;
+/// Connection interval and event length of the connection in progress
+static uint16_t sim_connecting_interval;
+static uint16_t sim_connecting_ce_len;
+
+static volatile sig_atomic_t sim_stop;
+
+/*
+ * FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+void fleet_sim_bdaddr(unsigned int index, struct bd_addr *addr)
+{
+    // 80:EA:CA:00:xx:xx
+    addr->addr[0] = index & 0xFF;
+    addr->addr[1] = (index >> 8) & 0xFF;
+    addr->addr[2] = 0x00;
+    addr->addr[3] = 0xCA;
+    addr->addr[4] = 0xEA;
+    addr->addr[5] = 0x80;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Queue a GTL message to the host. The UART drains the queue at its baud rate.
+ ****************************************************************************************
+ */
+static void sim_send(uint16_t id, uint16_t src_id, const void *param, uint16_t len)
+{
+    uint8_t hdr[9];
+    size_t i, total = sizeof(hdr) + len;
+
+    if (sim_tx_len + total > SIM_TX_BUFFER_SIZE)
+    {
+        fprintf(stderr, "simulator: UART TX overflow\n");
+        return;
+    }
+
+    hdr[0] = HT_PKT_GTL;
+    hdr[1] = id & 0xFF;
+    hdr[2] = id >> 8;
+    hdr[3] = TASK_ID_GTL;
+    hdr[4] = 0;
+    hdr[5] = src_id & 0xFF;
+    hdr[6] = src_id >> 8;
+    hdr[7] = len & 0xFF;
+    hdr[8] = len >> 8;
+
+    for (i = 0; i < total; i++)
+    {
+        sim_tx[(sim_tx_head + sim_tx_len + i) % SIM_TX_BUFFER_SIZE] =
+            (i < sizeof(hdr)) ? hdr[i] : ((const uint8_t *) param)[i - sizeof(hdr)];
+    }
+    sim_tx_len += total;
+}
+
+static void sim_timer_add(double at, uint8_t type, uint8_t conidx, uint8_t status, unsigned int peer)
+{
+    struct sim_timer *t;
+
+    if (sim_timer_count == SIM_MAX_TIMERS)
+    {
+        fprintf(stderr, "simulator: too many timers\n");
+        return;
+    }
+
+    t = &sim_timers[sim_timer_count++];
+    t->at = at;
+    t->type = type;
+    t->conidx = conidx;
+    t->status = status;
+    t->conhdl = (conidx < FLEET_MAX_CONNECTIONS) ? sim_links[conidx].conhdl : 0;
+    t->peer = peer;
+}
+
+static void sim_timer_remove_type(uint8_t type)
+{
+    unsigned int i = 0;
+
+    while (i < sim_timer_count)
+    {
+        if (sim_timers[i].type == type)
+        {
+            sim_timers[i] = sim_timers[--sim_timer_count];
+        }
+        else
+        {
+            i++;
+        }
+    }
+}
+
+static void sim_gapm_cmp_evt(uint8_t operation, uint8_t status)
+{
+    struct gapm_cmp_evt evt = {operation, status};
+
+    sim_send(GAPM_CMP_EVT, TASK_ID_GAPM, &evt, sizeof(evt));
+}
+
+static void sim_gapc_cmp_evt(uint8_t conidx, uint8_t operation, uint8_t status)
+{
+    struct gapc_cmp_evt evt = {operation, status};
+
+    sim_send(GAPC_CMP_EVT, KE_BUILD_ID(TASK_ID_GAPC, conidx), &evt, sizeof(evt));
+}
+
+static void sim_gattc_cmp_evt(uint8_t conidx, uint8_t operation, uint8_t status)
+{
+    struct gattc_cmp_evt evt;
+
+    memset(&evt, 0, sizeof(evt));
+    evt.operation = operation;
+    evt.status = status;
+
+    sim_send(GATTC_CMP_EVT, KE_BUILD_ID(TASK_ID_GATTC, conidx), &evt, sizeof(evt));
+}
+
+static void sim_notify(uint8_t conidx, uint8_t status)
+{
+    uint8_t buf[sizeof(struct gattc_event_ind) + 1];
+    struct gattc_event_ind *ind = (struct gattc_event_ind *) buf;
+
+    memset(buf, 0, sizeof(buf));
+    ind->type = GATTC_NOTIFY;
+    ind->length = 1;
+    ind->handle = SIM_SERV_STATUS_HDL;
+    ind->value[0] = status;
+
+    sim_send(GATTC_EVENT_IND, KE_BUILD_ID(TASK_ID_GATTC, conidx), buf, sizeof(buf));
+}
+
+/**
+ ****************************************************************************************
+ * @brief Drop a link: free its heap and tell the host.
+ ****************************************************************************************
+ */
+static void sim_link_lost(uint8_t conidx, uint8_t reason)
+{
+    struct sim_link *l = &sim_links[conidx];
+    struct gapc_disconnect_ind ind;
+
+    while (l->count)
+    {
+        sim_heap_used -= l->ops[l->head].heap;
+        l->head = (l->head + 1) % SIM_LINK_OPS;
+        l->count--;
+    }
+    l->used = false;
+
+    ind.conhdl = l->conhdl;
+    ind.reason = reason;
+    sim_send(GAPC_DISCONNECT_IND, KE_BUILD_ID(TASK_ID_GAPC, conidx), &ind, sizeof(ind));
+}
+
+/*
+ * SUOTA RECEIVER
+ ****************************************************************************************
+ */
+
+static void sim_suotar_write(uint8_t conidx, const struct sim_op *op)
+{
+    struct sim_link *l = &sim_links[conidx];
+    struct sim_peer *peer = &sim_peers[l->peer];
+
+    switch (op->handle)
+    {
+        case SIM_MEM_DEV_HDL:
+            switch (op->value[3])
+            {
+                case SUOTA_MEM_DEV_I2C:
+                case SUOTA_MEM_DEV_SPI:
+                    l->mem_dev = op->value[3];
+                    l->received = 0;
+                    l->crc = 0;
+                    l->erased_end = 0;
+                    sim_notify(conidx, SUOTA_STATUS_IMG_STARTED);
+                    break;
+
+                case SUOTA_END:
+                    // the image ends with its XOR checksum
+                    sim_notify(conidx, (l->crc == 0 && peer->fault != SIM_FAULT_CRC) ? SUOTA_STATUS_CMP_OK
+                                                                                   : SUOTA_STATUS_CRC_ERR);
+                    break;
+
+                case SUOTA_REBOOT:
+                    sim_timer_add(sim_last + l->interval, SIM_T_DISCONNECTED, conidx, CO_ERROR_REMOTE_USER_TERM_CON, 0);
+                    break;
+
+                default:
+                    sim_notify(conidx, SUOTA_STATUS_INVAL_MEM_TYPE);
+                    break;
+            }
+            break;
+
+        case SIM_PATCH_LEN_HDL:
+            l->patch_len = op->value[0] | (op->value[1] << 8);
+            l->block_received = 0;
+            break;
+
+        case SIM_PATCH_DATA_HDL:
+            l->received += op->length;
+            l->block_received += op->length;
+
+            if (peer->fault == SIM_FAULT_LINK_LOSS && l->received >= SIM_LINK_LOSS_BYTES)
+            {
+                sim_timer_add(sim_last, SIM_T_DISCONNECTED, conidx, CO_ERROR_CON_TIMEOUT, 0);
+            }
+            else if (l->block_received >= l->patch_len)
+            {
+                // store the block, erasing the sectors it enters
+                uint32_t end = l->received;
+                double t = (l->block_received + SIM_PAGE_SIZE - 1) / SIM_PAGE_SIZE * SIM_PAGE_PROGRAM_S;
+
+                while (l->erased_end < end)
+                {
+                    l->erased_end += SIM_SECTOR_SIZE;
+                    t += SIM_SECTOR_ERASE_S;
+                }
+                l->flash_free_at = ((l->flash_free_at > sim_last) ? l->flash_free_at : sim_last) + t;
+                l->block_received = 0;
+                sim_timer_add(l->flash_free_at, SIM_T_NOTIFY, conidx, SUOTA_STATUS_CMP_OK, 0);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+static void sim_suotar_read(uint8_t conidx, uint16_t handle)
+{
+    struct sim_link *l = &sim_links[conidx];
+    uint8_t buf[sizeof(struct gattc_read_ind) + 4];
+    struct gattc_read_ind *ind = (struct gattc_read_ind *) buf;
+
+    memset(buf, 0, sizeof(buf));
+    ind->handle = handle;
+
+    switch (handle)
+    {
+        case SIM_MEM_INFO_HDL:
+            ind->length = 4;
+            ind->value[0] = l->received & 0xFF;
+            ind->value[1] = (l->received >> 8) & 0xFF;
+            ind->value[2] = (l->received >> 16) & 0xFF;
+            ind->value[3] = (l->received >> 24) & 0xFF;
+            break;
+
+        case SIM_VERSION_HDL:
+            ind->length = 1;
+            ind->value[0] = SUOTA_VERSION_1_3;
+            break;
+
+        case SIM_PD_CHAR_SIZE_HDL:
+            ind->length = 2;
+            ind->value[0] = SIM_PEER_PD_CHAR_SIZE & 0xFF;
+            ind->value[1] = SIM_PEER_PD_CHAR_SIZE >> 8;
+            break;
+
+        case SIM_MTU_HDL:
+            ind->length = 2;
+            ind->value[0] = SIM_PEER_MTU & 0xFF;
+            ind->value[1] = SIM_PEER_MTU >> 8;
+            break;
+
+        default:
+            sim_gattc_cmp_evt(conidx, GATTC_READ, ATT_ERR_INVALID_HANDLE);
+            return;
+    }
+
+    sim_send(GATTC_READ_IND, KE_BUILD_ID(TASK_ID_GATTC, conidx), buf, sizeof(struct gattc_read_ind) + ind->length);
+    sim_gattc_cmp_evt(conidx, GATTC_READ, GAP_ERR_NO_ERROR);
+}
+
+static void sim_discover(uint8_t conidx, uint8_t operation)
+{
+    static const struct
+    {
+        uint16_t handle;
+        const uint8_t *uuid;
+    } chars[] = {
+        {SIM_MEM_DEV_HDL,      SUOTA_MEM_DEV_UUID},
+        {SIM_GPIO_MAP_HDL,     SUOTA_GPIO_MAP_UUID},
+        {SIM_MEM_INFO_HDL,     SUOTA_MEM_INFO_UUID},
+        {SIM_PATCH_LEN_HDL,    SUOTA_PATCH_LEN_UUID},
+        {SIM_PATCH_DATA_HDL,   SUOTA_PATCH_DATA_UUID},
+        {SIM_SERV_STATUS_HDL,  SUOTA_SERV_STATUS_UUID},
+        {SIM_VERSION_HDL,      SUOTA_VERSION_UUID},
+        {SIM_PD_CHAR_SIZE_HDL, SUOTA_PD_CHAR_SIZE_UUID},
+        {SIM_MTU_HDL,          SUOTA_MTU_UUID},
+    };
+    uint8_t buf[64];
+    unsigned int i;
+
+    memset(buf, 0, sizeof(buf));
+
+    switch (operation)
+    {
+        case GATTC_DISC_BY_UUID_SVC:
+        {
+            struct gattc_disc_svc_ind *ind = (struct gattc_disc_svc_ind *) buf;
+
+            ind->start_hdl = SIM_SVC_START_HDL;
+            ind->end_hdl = SIM_SVC_END_HDL;
+            ind->uuid_len = 2;
+            ind->uuid[0] = SUOTA_PRIMARY_SERVICE_UUID & 0xFF;
+            ind->uuid[1] = SUOTA_PRIMARY_SERVICE_UUID >> 8;
+            sim_send(GATTC_DISC_SVC_IND, KE_BUILD_ID(TASK_ID_GATTC, conidx), buf, sizeof(*ind) + 2);
+            break;
+        }
+
+        case GATTC_DISC_ALL_CHAR:
+            for (i = 0; i < sizeof(chars) / sizeof(chars[0]); i++)
+            {
+                struct gattc_disc_char_ind *ind = (struct gattc_disc_char_ind *) buf;
+
+                ind->attr_hdl = chars[i].handle - 1;
+                ind->pointer_hdl = chars[i].handle;
+                ind->prop = 0;
+                ind->uuid_len = 16;
+                memcpy(ind->uuid, chars[i].uuid, 16);
+                sim_send(GATTC_DISC_CHAR_IND, KE_BUILD_ID(TASK_ID_GATTC, conidx), buf, sizeof(*ind) + 16);
+            }
+            break;
+
+        case GATTC_DISC_DESC_CHAR:
+        {
+            struct gattc_disc_char_desc_ind *ind = (struct gattc_disc_char_desc_ind *) buf;
+
+            ind->attr_hdl = SIM_SERV_STATUS_CCCD;
+            ind->uuid_len = 2;
+            ind->uuid[0] = CLIENT_CHARACTERISTIC_CONFIGURATION_DESCRIPTOR_UUID & 0xFF;
+            ind->uuid[1] = CLIENT_CHARACTERISTIC_CONFIGURATION_DESCRIPTOR_UUID >> 8;
+            sim_send(GATTC_DISC_CHAR_DESC_IND, KE_BUILD_ID(TASK_ID_GATTC, conidx), buf, sizeof(*ind) + 2);
+            break;
+        }
+
+        default:
+            break;
+    }
+
+    sim_gattc_cmp_evt(conidx, operation, GAP_ERR_NO_ERROR);
+}
+
+/*
+ * LINK LAYER
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Complete the operation at the head of a link: a request gets its response, a
+ *        Write Command is delivered to the receiver.
+ ****************************************************************************************
+ */
+static void sim_op_complete(uint8_t conidx)
+{
+    struct sim_link *l = &sim_links[conidx];
+    struct sim_op op = l->ops[l->head];
+
+    sim_heap_used -= op.heap;
+    l->head = (l->head + 1) % SIM_LINK_OPS;
+    l->count--;
+
+    switch (op.msg_id)
+    {
+        case GATTC_WRITE_CMD:
+            sim_suotar_write(conidx, &op);
+            if (l->used)
+            {
+                sim_gattc_cmp_evt(conidx, op.operation, GAP_ERR_NO_ERROR);
+            }
+            break;
+
+        case GATTC_READ_CMD:
+            sim_suotar_read(conidx, op.handle);
+            break;
+
+        case GATTC_DISC_CMD:
+            sim_discover(conidx, op.operation);
+            break;
+
+        case GATTC_EXC_MTU_CMD:
+        {
+            struct gattc_mtu_changed_ind ind = {SIM_PEER_MTU, 0};
+
+            sim_send(GATTC_MTU_CHANGED_IND, KE_BUILD_ID(TASK_ID_GATTC, conidx), &ind, sizeof(ind));
+            sim_gattc_cmp_evt(conidx, GATTC_MTU_EXCH, GAP_ERR_NO_ERROR);
+            break;
+        }
+
+        case GAPC_SET_LE_PKT_SIZE_CMD:
+        {
+            struct gapc_le_pkt_size_ind ind;
+
+            l->tx_octets = op.length;
+            ind.max_tx_octets = l->tx_octets;
+            ind.max_tx_time = MAX_LE_TX_TIME;
+            ind.max_rx_octets = MAX_LE_PKT_SIZE;
+            ind.max_rx_time = MAX_LE_TX_TIME;
+            sim_send(GAPC_LE_PKT_SIZE_IND, KE_BUILD_ID(TASK_ID_GAPC, conidx), &ind, sizeof(ind));
+            sim_gapc_cmp_evt(conidx, GAPC_SET_LE_PKT_SIZE, GAP_ERR_NO_ERROR);
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+/// Air time of an LL data packet and its empty acknowledgement on the 1M PHY
+static double sim_pdu_time(uint16_t octets)
+{
+    return ((octets + 10) * 8 + 150 + 80 + 150) / 1e6;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Run a connection event of a link. The event starts when the radio is free and
+ *        lasts ce_len, but at least one packet is always sent. Operations are served in
+ *        order; a request blocks the link until its response in a later event.
+ ****************************************************************************************
+ */
+static void sim_conn_event(uint8_t conidx, double t)
+{
+    struct sim_link *l = &sim_links[conidx];
+    double at = (sim_radio_free_at > t) ? sim_radio_free_at : t;
+    double end = at + l->ce_len;
+    bool first = true;
+
+    if (at - t >= l->interval)
+    {
+        // no room for this event
+        return;
+    }
+
+    while (l->used && l->count)
+    {
+        struct sim_op *op = &l->ops[l->head];
+
+        if (op->resp_at != 0)
+        {
+            if (op->resp_at > t)
+            {
+                break;
+            }
+            sim_op_complete(conidx);
+            continue;
+        }
+
+        while (op->pdus && (first || at + sim_pdu_time(l->tx_octets) <= end))
+        {
+            at += sim_pdu_time(l->tx_octets);
+            op->pdus--;
+            first = false;
+        }
+        if (op->pdus)
+        {
+            break;
+        }
+
+        if (op->msg_id == GATTC_WRITE_CMD && op->operation == GATTC_WRITE_NO_RESPONSE)
+        {
+            sim_op_complete(conidx);
+        }
+        else
+        {
+            // the response comes in the next event
+            op->resp_at = t + l->interval / 2;
+            break;
+        }
+    }
+
+    if (at > sim_radio_free_at)
+    {
+        sim_radio_free_at = at;
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Queue an operation on a link, in the message heap.
+ ****************************************************************************************
+ */
+static void sim_op_push(uint8_t conidx, const ble_hdr *msg, uint8_t operation, uint16_t handle,
+                        uint16_t length, const uint8_t *value, uint16_t payload)
+{
+    struct sim_link *l = &sim_links[conidx];
+    struct sim_op *op;
+    uint16_t heap = SIM_MSG_HEADER_SIZE + msg->bLength;
+
+    if (l->count == SIM_LINK_OPS || sim_heap_used + heap > SIM_HEAP_SIZE)
+    {
+        if (msg->bType == GAPC_SET_LE_PKT_SIZE_CMD)
+        {
+            sim_gapc_cmp_evt(conidx, operation, GAP_ERR_INSUFF_RESOURCES);
+        }
+        else
+        {
+            sim_gattc_cmp_evt(conidx, operation, GAP_ERR_INSUFF_RESOURCES);
+        }
+        return;
+    }
+
+    op = &l->ops[(l->head + l->count) % SIM_LINK_OPS];
+    memset(op, 0, sizeof(*op));
+    op->msg_id = msg->bType;
+    op->operation = operation;
+    op->handle = handle;
+    op->length = length;
+    if (value != NULL)
+    {
+        memcpy(op->value, value, (length < sizeof(op->value)) ? length : sizeof(op->value));
+    }
+    op->heap = heap;
+    // ATT and L2CAP headers, at least one packet
+    op->pdus = (payload + ATT_HEADER_SIZE + L2CAP_HEADER_SIZE + l->tx_octets - 1) / l->tx_octets;
+
+    sim_heap_used += heap;
+    l->count++;
+}
+
+/*
+ * GTL MESSAGES FROM THE HOST
+ ****************************************************************************************
+ */
+
+static void sim_connect(const struct gapm_start_connection_cmd *cmd)
+{
+    unsigned int i;
+
+    for (i = 0; i < sim_peer_count; i++)
+    {
+        if (0 == memcmp(&sim_peers[i].addr, &cmd->peers[0].addr, sizeof(struct bd_addr)))
+        {
+            break;
+        }
+    }
+
+    // an unknown peer is never found: the host cancels the connection
+    sim_connecting_peer = i;
+    sim_connecting_interval = cmd->con_intv_max;
+    sim_connecting_ce_len = cmd->ce_len_max;
+    if (i < sim_peer_count)
+    {
+        sim_timer_add(sim_last + SIM_CONNECT_DELAY_S, SIM_T_CONNECTED, 0xFF, 0, i);
+    }
+}
+
+static void sim_handle(const ble_hdr *msg, const uint8_t *param)
+{
+    uint8_t conidx = KE_IDX_GET(msg->bDstid);
+
+    switch (msg->bType)
+    {
+        case GAPM_RESET_CMD:
+            sim_gapm_cmp_evt(GAPM_RESET, GAP_ERR_NO_ERROR);
+            break;
+
+        case GAPM_SET_DEV_CONFIG_CMD:
+            sim_gapm_cmp_evt(GAPM_SET_DEV_CONFIG, GAP_ERR_NO_ERROR);
+            break;
+
+        case GAPM_START_SCAN_CMD:
+        {
+            unsigned int i;
+
+            sim_scanning = true;
+            for (i = 0; i < sim_peer_count; i++)
+            {
+                sim_timer_add(sim_last + 0.002 + SIM_SCAN_DURATION_S * 0.8 * i / sim_peer_count,
+                              SIM_T_ADV, 0xFF, 0, i);
+            }
+            sim_timer_add(sim_last + SIM_SCAN_DURATION_S, SIM_T_SCAN_END, 0xFF, GAP_ERR_NO_ERROR, 0);
+            break;
+        }
+
+        case GAPM_START_CONNECTION_CMD:
+            sim_connect((const struct gapm_start_connection_cmd *) param);
+            break;
+
+        case GAPM_CANCEL_CMD:
+            if (sim_scanning)
+            {
+                sim_timer_remove_type(SIM_T_ADV);
+                sim_timer_remove_type(SIM_T_SCAN_END);
+                sim_scanning = false;
+                sim_gapm_cmp_evt(GAPM_SCAN_ACTIVE, GAP_ERR_CANCELED);
+            }
+            else if (sim_connecting_peer != ~0U)
+            {
+                sim_timer_remove_type(SIM_T_CONNECTED);
+                sim_connecting_peer = ~0U;
+                sim_gapm_cmp_evt(GAPM_CONNECTION_DIRECT, GAP_ERR_CANCELED);
+            }
+            break;
+
+        case GAPC_CONNECTION_CFM:
+            break;
+
+        case GAPC_DISCONNECT_CMD:
+            if (conidx < FLEET_MAX_CONNECTIONS && sim_links[conidx].used)
+            {
+                sim_timer_add(sim_last + sim_links[conidx].interval, SIM_T_DISCONNECTED, conidx,
+                              CO_ERROR_CON_TERM_BY_LOCAL_HOST, 0);
+            }
+            else
+            {
+                sim_gapc_cmp_evt(conidx, GAPC_DISCONNECT, GAP_ERR_INVALID_PARAM);
+            }
+            break;
+
+        case GAPC_SET_LE_PKT_SIZE_CMD:
+        {
+            const struct gapc_set_le_pkt_size_cmd *cmd = (const struct gapc_set_le_pkt_size_cmd *) param;
+            uint16_t octets = (cmd->tx_octets < MAX_LE_PKT_SIZE) ? cmd->tx_octets : MAX_LE_PKT_SIZE;
+
+            if (conidx < FLEET_MAX_CONNECTIONS && sim_links[conidx].used)
+            {
+                sim_op_push(conidx, msg, GAPC_SET_LE_PKT_SIZE, 0, octets, NULL, 0);
+            }
+            break;
+        }
+
+        case GATTC_EXC_MTU_CMD:
+        case GATTC_DISC_CMD:
+        case GATTC_READ_CMD:
+        case GATTC_WRITE_CMD:
+        {
+            if (conidx >= FLEET_MAX_CONNECTIONS || !sim_links[conidx].used)
+            {
+                break;
+            }
+
+            if (msg->bType == GATTC_WRITE_CMD)
+            {
+                const struct gattc_write_cmd *cmd = (const struct gattc_write_cmd *) param;
+                struct sim_link *l = &sim_links[conidx];
+
+                if (cmd->handle == SIM_PATCH_DATA_HDL)
+                {
+                    uint16_t i;
+
+                    for (i = 0; i < cmd->length; i++)
+                    {
+                        l->crc ^= cmd->value[i];
+                    }
+                }
+                sim_op_push(conidx, msg, cmd->operation, cmd->handle, cmd->length, cmd->value, cmd->length);
+            }
+            else if (msg->bType == GATTC_READ_CMD)
+            {
+                const struct gattc_read_cmd *cmd = (const struct gattc_read_cmd *) param;
+
+                sim_op_push(conidx, msg, GATTC_READ, cmd->req.simple.handle, 0, NULL, 2);
+            }
+            else
+            {
+                sim_op_push(conidx, msg, param[0], 0, 0, NULL, 4);
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+/*
+ * TIMERS
+ ****************************************************************************************
+ */
+
+static void sim_timer_fire(const struct sim_timer *t)
+{
+    switch (t->type)
+    {
+        case SIM_T_ADV:
+        {
+            struct gapm_adv_report_ind ind;
+
+            memset(&ind, 0, sizeof(ind));
+            ind.report.evt_type = ADV_CONN_UNDIR;
+            ind.report.adv_addr_type = ADDR_PUBLIC;
+            memcpy(&ind.report.adv_addr, &sim_peers[t->peer].addr, sizeof(struct bd_addr));
+            ind.report.rssi = -60;
+            sim_send(GAPM_ADV_REPORT_IND, TASK_ID_GAPM, &ind, sizeof(ind));
+            break;
+        }
+
+        case SIM_T_SCAN_END:
+            sim_scanning = false;
+            sim_gapm_cmp_evt(GAPM_SCAN_ACTIVE, t->status);
+            break;
+
+        case SIM_T_CONNECTED:
+        {
+            struct gapc_connection_req_ind ind;
+            struct sim_link *l;
+            uint8_t conidx;
+
+            sim_connecting_peer = ~0U;
+
+            for (conidx = 0; conidx < FLEET_MAX_CONNECTIONS && sim_links[conidx].used; conidx++)
+            {
+            }
+            if (conidx == FLEET_MAX_CONNECTIONS)
+            {
+                sim_gapm_cmp_evt(GAPM_CONNECTION_DIRECT, GAP_ERR_INSUFF_RESOURCES);
+                break;
+            }
+
+            l = &sim_links[conidx];
+            memset(l, 0, sizeof(*l));
+            l->used = true;
+            l->peer = t->peer;
+            l->conhdl = sim_next_conhdl++;
+            l->interval = sim_connecting_interval * 1.25e-3;
+            l->ce_len = sim_connecting_ce_len * 0.625e-3;
+            l->next_event = sim_last + l->interval;
+            l->tx_octets = LE_DEFAULT_PKT_SIZE;
+
+            memset(&ind, 0, sizeof(ind));
+            ind.conhdl = l->conhdl;
+            ind.con_interval = sim_connecting_interval;
+            ind.sup_to = 0x1F4;
+            ind.peer_addr_type = ADDR_PUBLIC;
+            memcpy(&ind.peer_addr, &sim_peers[t->peer].addr, sizeof(struct bd_addr));
+            sim_send(GAPC_CONNECTION_REQ_IND, KE_BUILD_ID(TASK_ID_GAPC, conidx), &ind, sizeof(ind));
+            sim_gapm_cmp_evt(GAPM_CONNECTION_DIRECT, GAP_ERR_NO_ERROR);
+            break;
+        }
+
+        case SIM_T_DISCONNECTED:
+            if (sim_links[t->conidx].used && sim_links[t->conidx].conhdl == t->conhdl)
+            {
+                sim_link_lost(t->conidx, t->status);
+                if (t->status == CO_ERROR_CON_TERM_BY_LOCAL_HOST)
+                {
+                    sim_gapc_cmp_evt(t->conidx, GAPC_DISCONNECT, GAP_ERR_NO_ERROR);
+                }
+            }
+            break;
+
+        case SIM_T_NOTIFY:
+            if (sim_links[t->conidx].used && sim_links[t->conidx].conhdl == t->conhdl)
+            {
+                sim_notify(t->conidx, t->status);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Run the timers and the connection events that are due, in time order.
+ *
+ * @return time of the next timer or connection event
+ ****************************************************************************************
+ */
+static double sim_run(double now)
+{
+    for (;;)
+    {
+        double next = now + 1;
+        int timer = -1, link = -1;
+        unsigned int i;
+
+        for (i = 0; i < sim_timer_count; i++)
+        {
+            if (sim_timers[i].at < next)
+            {
+                next = sim_timers[i].at;
+                timer = i;
+            }
+        }
+        for (i = 0; i < FLEET_MAX_CONNECTIONS; i++)
+        {
+            if (sim_links[i].used && sim_links[i].next_event < next)
+            {
+                next = sim_links[i].next_event;
+                link = i;
+                timer = -1;
+            }
+        }
+
+        if (next > now)
+        {
+            return next;
+        }
+
+        if (link >= 0)
+        {
+            sim_links[link].next_event += sim_links[link].interval;
+            sim_conn_event(link, next);
+        }
+        else
+        {
+            struct sim_timer t = sim_timers[timer];
+
+            sim_timers[timer] = sim_timers[--sim_timer_count];
+            sim_timer_fire(&t);
+        }
+    }
+}
+
+/*
+ * UART
+ ****************************************************************************************
+ */
+
+static double sim_now(void)
+{
+    return fleet_now();
+}
+
+static void sim_signal(int sig)
+{
+    sim_stop = 1;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Serve the host until a signal is received. Both UART directions move at most
+ *        baudrate / 10 bytes per second.
+ ****************************************************************************************
+ */
+static void sim_serve(void)
+{
+    signal(SIGTERM, sim_signal);
+    signal(SIGINT, sim_signal);
+
+    sim_last = sim_now();
+
+    while (!sim_stop)
+    {
+        struct pollfd pfd;
+        double now = sim_now(), next;
+        int timeout;
+
+        sim_rx_tokens += (now - sim_last) * sim_bytes_per_s;
+        sim_tx_tokens += (now - sim_last) * sim_bytes_per_s;
+        if (sim_rx_tokens > 64)
+        {
+            sim_rx_tokens = 64;
+        }
+        if (sim_tx_tokens > 64)
+        {
+            sim_tx_tokens = 64;
+        }
+        sim_last = now;
+
+        // host to DA14585
+        while (sim_rx_tokens >= 1)
+        {
+            uint8_t buf[64];
+            ssize_t n = read(sim_fd, buf, (size_t) sim_rx_tokens);
+            size_t done = 0;
+
+            if (n <= 0)
+            {
+                break;
+            }
+            sim_rx_tokens -= n;
+
+            while (done < (size_t) n)
+            {
+                const ht_frame *frame;
+
+                done += ht_parser_feed(&sim_parser, &sim_queue, &sim_stats, buf + done, n - done);
+                while ((frame = ht_queue_peek(&sim_queue)) != NULL)
+                {
+                    if (frame->length >= sizeof(ble_hdr))
+                    {
+                        sim_handle((const ble_hdr *) frame->data, frame->data + sizeof(ble_hdr));
+                    }
+                    ht_queue_release(&sim_queue);
+                }
+            }
+        }
+
+        next = sim_run(now);
+
+        // DA14585 to host
+        while (sim_tx_len && sim_tx_tokens >= 1)
+        {
+            size_t len = (size_t) sim_tx_tokens;
+            ssize_t n;
+
+            if (len > sim_tx_len)
+            {
+                len = sim_tx_len;
+            }
+            if (len > SIM_TX_BUFFER_SIZE - sim_tx_head)
+            {
+                len = SIM_TX_BUFFER_SIZE - sim_tx_head;
+            }
+
+            n = write(sim_fd, &sim_tx[sim_tx_head], len);
+            if (n <= 0)
+            {
+                break;
+            }
+            sim_tx_tokens -= n;
+            sim_tx_head = (sim_tx_head + n) % SIM_TX_BUFFER_SIZE;
+            sim_tx_len -= n;
+        }
+
+        // wait for data, the next event or the UART
+        timeout = (int) ((next - sim_now()) * 1000);
+        if (sim_tx_len || timeout < 1)
+        {
+            timeout = 1;
+        }
+
+        pfd.fd = sim_fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        if (sim_rx_tokens >= 1)
+        {
+            if (poll(&pfd, 1, timeout) < 0 && errno != EINTR)
+            {
+                break;
+            }
+        }
+        else
+        {
+            usleep(1000);
+        }
+    }
+}
+
+pid_t fleet_sim_start(unsigned int count, unsigned int faulty_every, uint32_t baudrate,
+                      char *port, size_t port_size)
+{
+    struct termios tio;
+    unsigned int i;
+    pid_t pid;
+    int fd;
+
+    sim_peers = calloc(count, sizeof(*sim_peers));
+    if (sim_peers == NULL)
+    {
+        return -1;
+    }
+    sim_peer_count = count;
+
+    for (i = 0; i < count; i++)
+    {
+        fleet_sim_bdaddr(i, &sim_peers[i].addr);
+        if (faulty_every && ((i + 1) % faulty_every) == 0)
+        {
+            sim_peers[i].fault = (((i + 1) / faulty_every) % 2) ? SIM_FAULT_CRC : SIM_FAULT_LINK_LOSS;
+        }
+    }
+
+    sim_fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (sim_fd < 0 || grantpt(sim_fd) || unlockpt(sim_fd))
+    {
+        perror("Could not create a pty");
+        return -1;
+    }
+    tcgetattr(sim_fd, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(sim_fd, TCSANOW, &tio);
+    fcntl(sim_fd, F_SETFL, O_NONBLOCK);
+    snprintf(port, port_size, "%s", ptsname(sim_fd));
+
+    // Keep a slave open so that the master does not hang up before the host opens it
+    fd = open(port, O_RDWR | O_NOCTTY);
+
+    pid = fork();
+    if (pid < 0)
+    {
+        perror("fork");
+        return -1;
+    }
+    if (pid == 0)
+    {
+        sim_bytes_per_s = baudrate / 10.0;
+        ht_parser_init(&sim_parser, HT_FILTER(HT_PKT_GTL));
+        ht_queue_init(&sim_queue);
+        sim_serve();
+        _exit(0);
+    }
+
+    (void) fd;
+    close(sim_fd);
+
+    return pid;
+}
@@ -146,6 +146,14 @@
 /****************************************************************************************************************/
 #undef CFG_BLE_METRICS
 
+/****************************************************************************************************************/
+/* Enables the per connection link telemetry (RSSI histogram, reception errors, packets per event and wake-up   */
+/* delay, in time buckets). See link_telemetry.h.                                                               */
+/* - CFG_LINK_TELEMETRY_BUCKETS: Buckets per connection (power of 2). Default 4.                                */
+/* - CFG_LINK_TELEMETRY_PERIOD: Time covered by a bucket in ms. Default 15000.                                  */
+/****************************************************************************************************************/
+#undef CFG_LINK_TELEMETRY
+
 /****************************************************************************************************************/
 /* Output the Hardfault arguments to serial/UART interface.                                                     */
 /****************************************************************************************************************/
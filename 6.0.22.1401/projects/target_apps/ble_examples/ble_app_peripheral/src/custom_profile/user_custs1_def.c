@@ -82,6 +82,14 @@ static const uint8_t SVC3_READ_VAL_2_UUID_128[ATT_UUID_128_LEN]       = DEF_SVC3
 static const uint8_t SVC3_READ_VAL_3_UUID_128[ATT_UUID_128_LEN]       = DEF_SVC3_READ_VAL_3_UUID_128;
 static const uint8_t SVC3_READ_VAL_4_UUID_128[ATT_UUID_128_LEN]       = DEF_SVC3_READ_VAL_4_UUID_128;
 
+#if defined (CFG_LINK_TELEMETRY)
+// Service 4 of the custom server 1
+static const att_svc_desc128_t custs1_svc4                      = DEF_SVC4_UUID_128;
+
+static const uint8_t SVC4_TLM_SELECT_UUID_128[ATT_UUID_128_LEN]       = DEF_SVC4_TLM_SELECT_UUID_128;
+static const uint8_t SVC4_TLM_RECORD_UUID_128[ATT_UUID_128_LEN]       = DEF_SVC4_TLM_RECORD_UUID_128;
+#endif
+
 // Attribute specifications
 static const uint16_t att_decl_svc       = ATT_DECL_PRIMARY_SERVICE;
 static const uint16_t att_decl_char      = ATT_DECL_CHARACTERISTIC;
@@ -93,7 +101,11 @@ static const uint16_t att_desc_user_desc = ATT_DESC_CHAR_USER_DESCRIPTION;
  ****************************************************************************************
  */
 
+#if defined (CFG_LINK_TELEMETRY)
+const uint8_t custs1_services[]  = {SVC1_IDX_SVC, SVC2_IDX_SVC, SVC3_IDX_SVC, SVC4_IDX_SVC, CUSTS1_IDX_NB};
+#else
 const uint8_t custs1_services[]  = {SVC1_IDX_SVC, SVC2_IDX_SVC, SVC3_IDX_SVC, CUSTS1_IDX_NB};
+#endif
 const uint8_t custs1_services_size = ARRAY_LEN(custs1_services) - 1;
 const uint16_t custs1_att_max_nb = CUSTS1_IDX_NB;
 
@@ -313,6 +325,41 @@ const struct attm_desc_128 custs1_att_db[CUSTS1_IDX_NB] =
     [SVC3_IDX_READ_4_USER_DESC]        = {(uint8_t*)&att_desc_user_desc, ATT_UUID_16_LEN, PERM(RD, ENABLE),
                                             sizeof(DEF_SVC3_READ_VAL_4_USER_DESC) - 1, sizeof(DEF_SVC3_READ_VAL_4_USER_DESC) - 1,
                                             (uint8_t *) DEF_SVC3_READ_VAL_4_USER_DESC},
+
+#if defined (CFG_LINK_TELEMETRY)
+    /*************************
+     * Service 4 configuration
+     *************************
+     */
+
+    // Service 4 Declaration
+    [SVC4_IDX_SVC]                     = {(uint8_t*)&att_decl_svc, ATT_UUID_128_LEN, PERM(RD, ENABLE),
+                                            sizeof(custs1_svc4), sizeof(custs1_svc4), (uint8_t*)&custs1_svc4},
+
+    // Telemetry Bucket Age Characteristic Declaration
+    [SVC4_IDX_TLM_SELECT_CHAR]         = {(uint8_t*)&att_decl_char, ATT_UUID_16_LEN, PERM(RD, ENABLE), 0, 0, NULL},
+
+    // Telemetry Bucket Age Characteristic Value
+    [SVC4_IDX_TLM_SELECT_VAL]          = {SVC4_TLM_SELECT_UUID_128, ATT_UUID_128_LEN, PERM(RD, ENABLE) | PERM(WR, ENABLE) | PERM(WRITE_REQ, ENABLE),
+                                            DEF_SVC4_TLM_SELECT_CHAR_LEN, 0, NULL},
+
+    // Telemetry Bucket Age Characteristic User Description
+    [SVC4_IDX_TLM_SELECT_USER_DESC]    = {(uint8_t*)&att_desc_user_desc, ATT_UUID_16_LEN, PERM(RD, ENABLE),
+                                            sizeof(DEF_SVC4_TLM_SELECT_USER_DESC) - 1, sizeof(DEF_SVC4_TLM_SELECT_USER_DESC) - 1,
+                                            (uint8_t *) DEF_SVC4_TLM_SELECT_USER_DESC},
+
+    // Telemetry Bucket Characteristic Declaration
+    [SVC4_IDX_TLM_RECORD_CHAR]         = {(uint8_t*)&att_decl_char, ATT_UUID_16_LEN, PERM(RD, ENABLE), 0, 0, NULL},
+
+    // Telemetry Bucket Characteristic Value
+    [SVC4_IDX_TLM_RECORD_VAL]          = {SVC4_TLM_RECORD_UUID_128, ATT_UUID_128_LEN, PERM(RD, ENABLE),
+                                            PERM(RI, ENABLE) | DEF_SVC4_TLM_RECORD_CHAR_LEN, 0, NULL},
+
+    // Telemetry Bucket Characteristic User Description
+    [SVC4_IDX_TLM_RECORD_USER_DESC]    = {(uint8_t*)&att_desc_user_desc, ATT_UUID_16_LEN, PERM(RD, ENABLE),
+                                            sizeof(DEF_SVC4_TLM_RECORD_USER_DESC) - 1, sizeof(DEF_SVC4_TLM_RECORD_USER_DESC) - 1,
+                                            (uint8_t *) DEF_SVC4_TLM_RECORD_USER_DESC},
+#endif
 };
 
 /// @} USER_CONFIG
@@ -50,6 +50,9 @@
  */
 
 #include "attm_db_128.h"
+#if defined (CFG_LINK_TELEMETRY)
+#include "link_telemetry.h"
+#endif
 
 /*
  * DEFINES
@@ -113,6 +116,20 @@
 #define DEF_SVC3_READ_VAL_3_USER_DESC    "Read me (indicate)"
 #define DEF_SVC3_READ_VAL_4_USER_DESC    "Read me (RI)"
 
+#if defined (CFG_LINK_TELEMETRY)
+// Service 4 of the custom server 1: link telemetry of the connection, see link_telemetry.h
+#define DEF_SVC4_UUID_128                {0x59, 0x5a, 0x08, 0xe4, 0x86, 0x2a, 0x9e, 0x8f, 0xe9, 0x11, 0xbc, 0x7c, 0x4e, 0x4a, 0x42, 0x18}
+
+#define DEF_SVC4_TLM_SELECT_UUID_128     {0x6B, 0x2D, 0x7A, 0x31, 0x0E, 0x55, 0x4F, 0x8B, 0x9C, 0x12, 0x47, 0xD3, 0x5A, 0x80, 0x1E, 0x3C}
+#define DEF_SVC4_TLM_RECORD_UUID_128     {0x6B, 0x2D, 0x7A, 0x31, 0x0E, 0x55, 0x4F, 0x8B, 0x9C, 0x12, 0x47, 0xD3, 0x5A, 0x80, 0x1E, 0x3D}
+
+#define DEF_SVC4_TLM_SELECT_CHAR_LEN     1
+#define DEF_SVC4_TLM_RECORD_CHAR_LEN     LINK_TELEMETRY_REC_LEN
+
+#define DEF_SVC4_TLM_SELECT_USER_DESC    "Telemetry Bucket Age"
+#define DEF_SVC4_TLM_RECORD_USER_DESC    "Telemetry Bucket (RI)"
+#endif
+
 /// Custom1 Service Data Base Characteristic enum
 enum
 {
@@ -183,6 +200,19 @@ enum
     SVC3_IDX_READ_4_VAL,
     SVC3_IDX_READ_4_USER_DESC,
 
+#if defined (CFG_LINK_TELEMETRY)
+    // Custom Service 4
+    SVC4_IDX_SVC,
+
+    SVC4_IDX_TLM_SELECT_CHAR,
+    SVC4_IDX_TLM_SELECT_VAL,
+    SVC4_IDX_TLM_SELECT_USER_DESC,
+
+    SVC4_IDX_TLM_RECORD_CHAR,
+    SVC4_IDX_TLM_RECORD_VAL,
+    SVC4_IDX_TLM_RECORD_USER_DESC,
+#endif
+
     CUSTS1_IDX_NB
 };
 
@@ -55,6 +55,9 @@
 ke_msg_id_t timer_used      __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
 uint16_t indication_counter __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
 uint16_t non_db_val_counter __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+#if defined (CFG_LINK_TELEMETRY)
+uint8_t link_telemetry_age  __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+#endif
 
 /*
  * FUNCTION DEFINITIONS
@@ -281,3 +284,48 @@ void user_svc3_read_non_db_val_handler(ke_msg_id_t const msgid,
     // Send message
     KE_MSG_SEND(rsp);
 }
+
+#if defined (CFG_LINK_TELEMETRY)
+void user_svc4_tlm_select_wr_ind_handler(ke_msg_id_t const msgid,
+                                          struct custs1_val_write_ind const *param,
+                                          ke_task_id_t const dest_id,
+                                          ke_task_id_t const src_id)
+{
+    if (param->length == DEF_SVC4_TLM_SELECT_CHAR_LEN)
+    {
+        link_telemetry_age = param->value[0];
+    }
+}
+
+void user_svc4_tlm_record_read_handler(ke_msg_id_t const msgid,
+                                        struct custs1_value_req_ind const *param,
+                                        ke_task_id_t const dest_id,
+                                        ke_task_id_t const src_id)
+{
+    struct custs1_value_req_rsp *rsp = KE_MSG_ALLOC_DYN(CUSTS1_VALUE_REQ_RSP,
+                                                        prf_get_task_from_id(TASK_ID_CUSTS1),
+                                                        TASK_APP,
+                                                        custs1_value_req_rsp,
+                                                        DEF_SVC4_TLM_RECORD_CHAR_LEN);
+
+    // Provide the connection index.
+    rsp->conidx  = app_env[param->conidx].conidx;
+    // Provide the attribute index.
+    rsp->att_idx = param->att_idx;
+
+    // Bucket of the selected age of the connection reading it
+    if (link_telemetry_read(app_env[param->conidx].conhdl, link_telemetry_age, rsp->value))
+    {
+        rsp->length = DEF_SVC4_TLM_RECORD_CHAR_LEN;
+        rsp->status = ATT_ERR_NO_ERROR;
+    }
+    else
+    {
+        // No bucket of this age yet
+        rsp->length = 0;
+        rsp->status = ATT_ERR_APP_ERROR;
+    }
+    // Send message
+    KE_MSG_SEND(rsp);
+}
+#endif // CFG_LINK_TELEMETRY
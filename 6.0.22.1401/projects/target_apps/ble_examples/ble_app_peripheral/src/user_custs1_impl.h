@@ -209,6 +209,36 @@ void user_svc3_read_non_db_val_handler(ke_msg_id_t const msgid,
                                            ke_task_id_t const dest_id,
                                            ke_task_id_t const src_id);
 
+#if defined (CFG_LINK_TELEMETRY)
+/**
+ ****************************************************************************************
+ * @brief Link telemetry bucket age write indication handler.
+ * @param[in] msgid   Id of the message received.
+ * @param[in] param   Pointer to the parameters of the message.
+ * @param[in] dest_id ID of the receiving task instance.
+ * @param[in] src_id  ID of the sending task instance.
+ ****************************************************************************************
+ */
+void user_svc4_tlm_select_wr_ind_handler(ke_msg_id_t const msgid,
+                                          struct custs1_val_write_ind const *param,
+                                          ke_task_id_t const dest_id,
+                                          ke_task_id_t const src_id);
+
+/**
+ ****************************************************************************************
+ * @brief Read the link telemetry bucket of the selected age handler.
+ * @param[in] msgid   Id of the message received.
+ * @param[in] param   Pointer to the parameters of the message.
+ * @param[in] dest_id ID of the receiving task instance.
+ * @param[in] src_id  ID of the sending task instance.
+ ****************************************************************************************
+ */
+void user_svc4_tlm_record_read_handler(ke_msg_id_t const msgid,
+                                        struct custs1_value_req_ind const *param,
+                                        ke_task_id_t const dest_id,
+                                        ke_task_id_t const src_id);
+#endif // CFG_LINK_TELEMETRY
+
 /// @} APP
 
 #endif // _USER_CUSTS1_IMPL_H_
@@ -336,6 +336,12 @@ void user_catch_rest_hndl(ke_msg_id_t const msgid,
                     user_svc1_long_val_wr_ind_handler(msgid, msg_param, dest_id, src_id);
                     break;
 
+#if defined (CFG_LINK_TELEMETRY)
+                case SVC4_IDX_TLM_SELECT_VAL:
+                    user_svc4_tlm_select_wr_ind_handler(msgid, msg_param, dest_id, src_id);
+                    break;
+#endif
+
                 default:
                     break;
             }
@@ -416,6 +422,13 @@ void user_catch_rest_hndl(ke_msg_id_t const msgid,
                     user_svc3_read_non_db_val_handler(msgid, msg_param, dest_id, src_id);
                 } break;
 
+#if defined (CFG_LINK_TELEMETRY)
+                case SVC4_IDX_TLM_RECORD_VAL:
+                {
+                    user_svc4_tlm_record_read_handler(msgid, msg_param, dest_id, src_id);
+                } break;
+#endif
+
                 default:
                 {
                     // Send Error message
@@ -130,6 +130,24 @@
 /****************************************************************************************************************/
 #undef CFG_BLE_METRICS
 
+/****************************************************************************************************************/
+/* Enables the per connection link telemetry (RSSI histogram, reception errors, packets per event and wake-up   */
+/* delay, in time buckets). See link_telemetry.h.                                                               */
+/* - CFG_LINK_TELEMETRY_BUCKETS: Buckets per connection (power of 2). Default 4.                                */
+/* - CFG_LINK_TELEMETRY_PERIOD: Time covered by a bucket in ms. Default 15000.                                  */
+/****************************************************************************************************************/
+#undef CFG_LINK_TELEMETRY
+
+/****************************************************************************************************************/
+/* Adapts the TX output power of every connection to the lowest level keeping the peer receiving it at          */
+/* CFG_ADAPTIVE_TX_PWR_TARGET dBm, from the RSSI of the peer and the acknowledgments of our packets. Requires   */
+/* CFG_ENHANCED_TX_PWR_CTRL. The application limits the levels with adaptive_tx_pwr_limit_set().                */
+/* See adaptive_tx_pwr.h.                                                                                       */
+/* - CFG_ADAPTIVE_TX_PWR_TARGET: RSSI the peer should receive our packets at, in dBm. Default -80.              */
+/* - CFG_ADAPTIVE_TX_PWR_PEER_TX: Assumed TX output power of the peer, in dBm. Default 0.                       */
+/****************************************************************************************************************/
+#undef CFG_ADAPTIVE_TX_PWR
+
 /****************************************************************************************************************/
 /* Output the Hardfault arguments to serial/UART interface.                                                     */
 /****************************************************************************************************************/
@@ -256,4 +274,15 @@
 /****************************************************************************************************************/
 #define CFG_DISABLE_QUADEC_ON_START_UP
 
+/****************************************************************************************************************/
+/* Samples the die temperature for the RF calibration and the XTAL32M trimming at an interval adapted to the    */
+/* temperature slope instead of every 2 seconds. Application temperature samples are passed with                */
+/* radio_cals_temp_sample(). See cal_sched.h.                                                                   */
+/* - CFG_CAL_SCHED_MIN_INTERVAL_MS: Shortest sampling interval in ms. Default 500.                              */
+/* - CFG_CAL_SCHED_MAX_INTERVAL_MS: Longest sampling interval in ms. Default 8000.                              */
+/* - CFG_CAL_SCHED_LAST_INTERVAL_MS: Longest sampling interval in the last degree before a threshold in ms.     */
+/*   Default 1000.                                                                                              */
+/****************************************************************************************************************/
+#undef CFG_PREDICTIVE_CAL
+
 #endif // _DA14531_CONFIG_ADVANCED_H_
@@ -40,11 +40,19 @@
 #include "hci.h"
 #include "co_utils.h"
 #include "dialog_commands.h"
+#if (LINK_TELEMETRY)
+#include <string.h>
+#include "rwip_config.h"
+#endif
 
 // HCI dialog command descriptors (OGF Vendor Specific)
 const struct hci_cmd_desc_tag hci_cmd_desc_tab_dialog_vs[] =
 {
     CMD(VS1_DIALOG     , DBG, 0, PK_GEN_GEN, "B"       , "BB"       ),
+#if (LINK_TELEMETRY)
+    CMD(LINK_TELEMETRY_GET  , DBG, 0, PK_GEN_GEN, "BB"  , "B70B"     ),
+    CMD(LINK_TELEMETRY_RESET, DBG, 0, PK_GEN_GEN, "B"   , "BB"       ),
+#endif
 };
 
 const uint8_t dialog_commands_num = ARRAY_LEN (hci_cmd_desc_tab_dialog_vs);
@@ -79,11 +87,86 @@ static int dialog_commands_vs1_handler(ke_msg_id_t const msgid,
     return (KE_MSG_CONSUMED);
 }
 
+#if (LINK_TELEMETRY)
+/**
+ ****************************************************************************************
+ * @brief Handles the reception of the link telemetry get hci command.
+ *
+ * @param[in] msgid Id of the message received (probably unused).
+ * @param[in] param Pointer to the parameters of the message.
+ * @param[in] dest_id ID of the receiving task instance (probably unused).
+ * @param[in] src_id ID of the sending task instance.
+ *
+ * @return If the message was consumed or not.
+ ****************************************************************************************
+ */
+static int dialog_commands_link_telemetry_get_handler(ke_msg_id_t const msgid,
+                                                      struct hci_link_telemetry_get_cmd const *param,
+                                                      ke_task_id_t const dest_id,
+                                                      ke_task_id_t const src_id)
+{
+    // structure type for the complete command event
+    struct hci_link_telemetry_get_cmd_cmp_evt *event = KE_MSG_ALLOC(HCI_CMD_CMP_EVENT, src_id, HCI_LINK_TELEMETRY_GET_CMD_OPCODE, hci_link_telemetry_get_cmd_cmp_evt);
+
+    if (link_telemetry_read(param->conhdl, param->age, event->record))
+    {
+        event->status = CO_ERROR_NO_ERROR;
+    }
+    else
+    {
+        // Unknown connection handle, or no bucket of this age yet
+        memset(event->record, 0, sizeof(event->record));
+        event->status = (param->conhdl < BLE_CONNECTION_MAX) ? CO_ERROR_INVALID_HCI_PARAM : CO_ERROR_UNKNOWN_CONNECTION_ID;
+    }
+    hci_send_2_host(event);
+
+    return (KE_MSG_CONSUMED);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Handles the reception of the link telemetry reset hci command.
+ *
+ * @param[in] msgid Id of the message received (probably unused).
+ * @param[in] param Pointer to the parameters of the message.
+ * @param[in] dest_id ID of the receiving task instance (probably unused).
+ * @param[in] src_id ID of the sending task instance.
+ *
+ * @return If the message was consumed or not.
+ ****************************************************************************************
+ */
+static int dialog_commands_link_telemetry_reset_handler(ke_msg_id_t const msgid,
+                                                        struct hci_link_telemetry_reset_cmd const *param,
+                                                        ke_task_id_t const dest_id,
+                                                        ke_task_id_t const src_id)
+{
+    // structure type for the complete command event
+    struct hci_link_telemetry_reset_cmd_cmp_evt *event = KE_MSG_ALLOC(HCI_CMD_CMP_EVENT, src_id, HCI_LINK_TELEMETRY_RESET_CMD_OPCODE, hci_link_telemetry_reset_cmd_cmp_evt);
+
+    if ((param->conhdl < BLE_CONNECTION_MAX) || (param->conhdl == LINK_TELEMETRY_ALL))
+    {
+        link_telemetry_reset(param->conhdl);
+        event->status = CO_ERROR_NO_ERROR;
+    }
+    else
+    {
+        event->status = CO_ERROR_UNKNOWN_CONNECTION_ID;
+    }
+    event->conhdl = param->conhdl;
+    hci_send_2_host(event);
+
+    return (KE_MSG_CONSUMED);
+}
+#endif // LINK_TELEMETRY
 
 // The message handlers for dialog HCI command complete events
 const struct ke_msg_handler dialog_commands_handler_tab[] =
 {
         {HCI_VS1_DIALOG_CMD_OPCODE,        (ke_msg_func_t)dialog_commands_vs1_handler},
+#if (LINK_TELEMETRY)
+        {HCI_LINK_TELEMETRY_GET_CMD_OPCODE,   (ke_msg_func_t)dialog_commands_link_telemetry_get_handler},
+        {HCI_LINK_TELEMETRY_RESET_CMD_OPCODE, (ke_msg_func_t)dialog_commands_link_telemetry_reset_handler},
+#endif
 };
 
 const uint8_t dialog_commands_handler_num = ARRAY_LEN (dialog_commands_handler_tab);
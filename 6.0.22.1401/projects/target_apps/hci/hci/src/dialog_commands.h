@@ -42,6 +42,11 @@
 #include <stdint.h>
 #include "hci_int.h"
 #include "ke_task.h"
+#include "arch.h"
+
+#if (LINK_TELEMETRY)
+#include "link_telemetry.h"
+#endif
 
 /*
  * DEFINES
@@ -54,6 +59,10 @@
 enum
 {
     HCI_VS1_DIALOG_CMD_OPCODE = HCI_VS_FIRST_DIALOG_CMD_OPCODE,
+#if (LINK_TELEMETRY)
+    HCI_LINK_TELEMETRY_GET_CMD_OPCODE,      //= 0xFE01,
+    HCI_LINK_TELEMETRY_RESET_CMD_OPCODE,    //= 0xFE02,
+#endif
     HCI_VS_LAST_DIALOG_CMD_OPCODE           // DO NOT MOVE. Must always be last and opcodes linear (00,01,02 ...)
 };
 
@@ -73,6 +82,42 @@ struct hci_vs1_dialog_cmd_cmp_evt
     uint8_t returnData;
 };
 
+#if (LINK_TELEMETRY)
+//HCI link telemetry get command parameters - vendor specific
+struct hci_link_telemetry_get_cmd
+{
+    //Connection handle
+    uint8_t    conhdl;
+    //Age of the bucket, 0 for the current one
+    uint8_t    age;
+};
+
+//HCI link telemetry get complete event parameters - vendor specific
+struct hci_link_telemetry_get_cmd_cmp_evt
+{
+    //Status of the command reception
+    uint8_t status;
+    //Bucket record, see link_telemetry.h
+    uint8_t record[LINK_TELEMETRY_REC_LEN];
+};
+
+//HCI link telemetry reset command parameters - vendor specific
+struct hci_link_telemetry_reset_cmd
+{
+    //Connection handle, or LINK_TELEMETRY_ALL
+    uint8_t    conhdl;
+};
+
+//HCI link telemetry reset complete event parameters - vendor specific
+struct hci_link_telemetry_reset_cmd_cmp_evt
+{
+    //Status of the command reception
+    uint8_t status;
+    //Connection handle
+    uint8_t conhdl;
+};
+#endif // LINK_TELEMETRY
+
 /*
  * GLOBAL VARIABLES
  ****************************************************************************************
@@ -177,6 +177,14 @@ enum APP_MSG
     APP_BASS_TIMER,
     APP_BASS_ALERT_TIMER,
 #endif //BLE_BATT_SERVER
+
+#if (BLE_SUOTA_RECEIVER) && defined (CFG_SUOTAR_PIPELINED)
+    APP_SUOTAR_PROGRAM,
+#endif
+
+#if defined (CFG_APP_EASY_TIMER_WHEEL)
+    APP_TIMER_WHEEL_MES,
+#endif
 };
 
 /// Application environment structure
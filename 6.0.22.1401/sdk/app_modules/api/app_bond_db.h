@@ -89,6 +89,28 @@
 #define APP_BOND_DB_MAX_BONDED_PEERS    (USER_CFG_BOND_DB_MAX_BONDED_PEERS)
 #endif // USER_CFG_BOND_DB_MAX_BONDED_PEERS
 
+/// Journal (log-structured) backend of the bond database in SPI flash. Every add or remove
+/// appends a small record instead of erasing and rewriting the whole database. When the
+/// active sector is full, the valid entries are compacted into the next sector of a ring
+/// of APP_BOND_DB_JOURNAL_SECTORS sectors starting at APP_BOND_DB_DATA_OFFSET.
+/// A database stored by the default backend is imported on the first boot with the
+/// journal, so existing bonds are kept. The ring must have at least one sector more than
+/// the database takes.
+#if defined (USER_CFG_APP_BOND_DB_USE_SPI_FLASH) && defined (USER_CFG_BOND_DB_JOURNAL)
+#define APP_BOND_DB_JOURNAL
+
+/// Number of SPI flash sectors used by the journal (at least 2)
+#ifndef USER_CFG_BOND_DB_JOURNAL_SECTORS
+#define APP_BOND_DB_JOURNAL_SECTORS     (2)
+#else
+#define APP_BOND_DB_JOURNAL_SECTORS     (USER_CFG_BOND_DB_JOURNAL_SECTORS)
+#endif // USER_CFG_BOND_DB_JOURNAL_SECTORS
+
+#if (APP_BOND_DB_JOURNAL_SECTORS < 2)
+#error "The bond database journal needs at least 2 SPI flash sectors."
+#endif
+#endif
+
 /// Database version
 #define BOND_DB_VERSION                 (0x0001)
 
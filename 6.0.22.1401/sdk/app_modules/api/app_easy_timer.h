@@ -68,6 +68,33 @@ typedef void (* timer_callback)(void);
 /// Value indicating an invalide timer operation
 #define EASY_TIMER_INVALID_TIMER    (0x0)
 
+/// Wheel timers: timers multiplexed over a single kernel timer
+#if defined (CFG_APP_EASY_TIMER_WHEEL)
+#define APP_EASY_TIMER_WHEEL            (1)
+#else
+#define APP_EASY_TIMER_WHEEL            (0)
+#endif
+
+/// Number of wheel timers
+#ifndef CFG_APP_EASY_TIMER_WHEEL_NUM
+#define APP_EASY_TIMER_WHEEL_NUM        (16)
+#else
+#define APP_EASY_TIMER_WHEEL_NUM        (CFG_APP_EASY_TIMER_WHEEL_NUM)
+#endif
+
+#if (APP_EASY_TIMER_WHEEL_NUM < 1) || (APP_EASY_TIMER_WHEEL_NUM > 255)
+    #error "APP_EASY_TIMER_WHEEL_NUM must be in the range 1 to 255."
+#endif
+
+/// Time (10 ms units) a wheel timer may expire late so that it expires together with other
+/// wheel timers, saving a wakeup for each of them. It must be shorter than the period of
+/// the periodic wheel timers.
+#ifndef CFG_APP_EASY_TIMER_WHEEL_SLACK
+#define APP_EASY_TIMER_WHEEL_SLACK      (0)
+#else
+#define APP_EASY_TIMER_WHEEL_SLACK      (CFG_APP_EASY_TIMER_WHEEL_SLACK)
+#endif
+
 /*
  * FUNCTION DECLARATIONS
  ****************************************************************************************
@@ -126,6 +153,41 @@ timer_hnd app_easy_timer_modify(const timer_hnd timer_id, const uint32_t delay);
  */
 void app_easy_timer_cancel_all(void);
 
+#if (APP_EASY_TIMER_WHEEL)
+/**
+ ****************************************************************************************
+ * @brief Create a new wheel timer.
+ * @details The wheel timers share a single kernel timer, which is set to the earliest
+ * expiration time plus APP_EASY_TIMER_WHEEL_SLACK. All the wheel timers that have expired
+ * by then are served by the same wakeup. The BLE is only activated if it is sleeping when
+ * the timer is created. The wheel timer handlers are not related to the handlers returned
+ * by app_easy_timer().
+ * @param[in] delay  The amount of timer slots (10 ms) to wait
+ * @param[in] period The period (10 ms units) of a periodic timer, 0 for a one-shot timer.
+ *                   It must be longer than APP_EASY_TIMER_WHEEL_SLACK.
+ * @param[in] fn     The callback to be called when the timer expires
+ * @return The handler of the timer for future reference. If there are not timers available
+ *         EASY_TIMER_INVALID_TIMER will be returned
+ ****************************************************************************************
+ */
+timer_hnd app_easy_wheel_timer(const uint32_t delay, const uint32_t period, timer_callback fn);
+
+/**
+ ****************************************************************************************
+ * @brief Cancel an active wheel timer.
+ * @param[in] timer_id The wheel timer handler to cancel
+ ****************************************************************************************
+ */
+void app_easy_wheel_timer_cancel(const timer_hnd timer_id);
+
+/**
+ ****************************************************************************************
+ * @brief Cancel all the active wheel timers.
+ ****************************************************************************************
+ */
+void app_easy_wheel_timer_cancel_all(void);
+#endif // APP_EASY_TIMER_WHEEL
+
 #endif // _APP_EASY_TIMER_H_
 
 ///@}
@@ -56,6 +56,21 @@
 /// Helper macro to identify a task
 #define KE_FIND_RELATED_TASK(task) ((ke_msg_id_t)((task) >> 10))
 
+/// Maximum number of message Ids in the index that maps a message Id to the process handler
+/// that handles it in app_entry_point_handler(). The index is built by app_entry_point_init()
+/// from the message handler tables of the process handlers. Every entry takes 4 bytes of
+/// retention RAM, so the index is disabled by default and all process handlers are searched
+/// for every message. Define CFG_APP_ENTRY_DISPATCH_INDEX_SIZE (e.g. 64) to enable it.
+#ifndef CFG_APP_ENTRY_DISPATCH_INDEX_SIZE
+#define APP_ENTRY_DISPATCH_INDEX_SIZE   (0)
+#else
+#define APP_ENTRY_DISPATCH_INDEX_SIZE   (CFG_APP_ENTRY_DISPATCH_INDEX_SIZE)
+#endif
+
+#if (APP_ENTRY_DISPATCH_INDEX_SIZE > 255)
+    #error "APP_ENTRY_DISPATCH_INDEX_SIZE must not be greater than 255."
+#endif
+
 #if defined (__DA14531__) && !defined (__EXCLUDE_ROM_APP_TASK__) && (APP_EASY_MAX_ACTIVE_CONNECTION > 1)
     #error "Cannot use ROM app task symbols if number of connections is greater than 1. \
 Workaround: Define the __EXCLUDE_ROM_APP_TASK__ flag and comment out the app task related symbols in ROM symbols file (da14531_symbols.txt)"
@@ -137,6 +152,16 @@ typedef struct
  ****************************************************************************************
  */
 
+#if !defined (__DA14531__) || defined (__EXCLUDE_ROM_APP_TASK__)
+/**
+ ****************************************************************************************
+ * @brief Build the index of the message Ids handled by the process handlers. Called once
+ *        from app_init(), before any message is dispatched.
+ ****************************************************************************************
+ */
+void app_entry_point_init(void);
+#endif
+
 /**
  ****************************************************************************************
  * @brief Application entry point handler.
@@ -159,7 +184,9 @@ int app_entry_point_handler(ke_msg_id_t const msgid,
  * @param[in] param       Pointer to message
  * @param[in] src_id      Source task Id
  * @param[in] dest_id     Destination task Id
- * @param[in] msg_ret     Message status returned
+ * @param[in] msg_ret     Message status returned. NULL when app_entry_point_init() probes
+ *                        the process handler for its message handler table: the table is
+ *                        recorded and no handler is called.
  * @param[in] handlers    Pointer to message handlers
    @param[in] handler_num Handler number
  * @return process_event_response PR_EVENT_HANDLED or PR_EVENT_UNHANDLED
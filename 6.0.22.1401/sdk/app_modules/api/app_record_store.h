@@ -0,0 +1,301 @@
+/**
+ ****************************************************************************************
+ * @addtogroup APP_Modules
+ * @{
+ * @addtogroup Record_Store Record Store
+ * @brief Persistent measurement record store API
+ * @{
+ *
+ * @file app_record_store.h
+ *
+ * @brief Flash-backed circular measurement record store header file.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _APP_RECORD_STORE_H_
+#define _APP_RECORD_STORE_H_
+
+/**
+ ****************************************************************************************
+ * @details The records are appended to a ring of SPI flash sectors. Every sector holds a
+ * fixed number of fixed size slots and the sequence number of a record is given by its
+ * slot, so a record is located from its sequence number without any search. A RAM index
+ * keeps the time range of every sector, so a time lookup is a binary search over the
+ * sectors followed by a binary search over the slots of one sector. When the ring is full
+ * the oldest sector is erased and reused.
+ *
+ * An append programs the record and then its commit byte. A record whose commit byte is
+ * not programmed, because of a power failure, is skipped when the store is loaded.
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "user_config.h"
+
+#if defined (CFG_SPI_FLASH_ENABLE)
+#include "spi_flash.h"
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// SPI flash offset of the first sector of the store (sector aligned). The default is past
+/// the first 1 Mbit, used by the images and the bond database, so it needs a larger flash.
+#ifndef USER_CFG_RECORD_STORE_DATA_OFFSET
+#define APP_RECORD_STORE_DATA_OFFSET        (0x20000)
+#else
+#define APP_RECORD_STORE_DATA_OFFSET        (USER_CFG_RECORD_STORE_DATA_OFFSET)
+#endif
+
+/// Number of SPI flash sectors of the store (at least 2)
+#ifndef USER_CFG_RECORD_STORE_SECTORS
+#define APP_RECORD_STORE_SECTORS            (16)
+#else
+#define APP_RECORD_STORE_SECTORS            (USER_CFG_RECORD_STORE_SECTORS)
+#endif
+
+/// Maximum payload of a record in bytes
+#ifndef USER_CFG_RECORD_STORE_PAYLOAD_SIZE
+#define APP_RECORD_STORE_PAYLOAD_SIZE       (20)
+#else
+#define APP_RECORD_STORE_PAYLOAD_SIZE       (USER_CFG_RECORD_STORE_PAYLOAD_SIZE)
+#endif
+
+#if (APP_RECORD_STORE_SECTORS < 2)
+#error "The record store needs at least 2 SPI flash sectors."
+#endif
+
+#if (APP_RECORD_STORE_DATA_OFFSET % SPI_FLASH_SECTOR_SIZE)
+#error "The record store must start at a sector boundary."
+#endif
+
+/// Size of a record slot in flash (word aligned)
+#define APP_RECORD_STORE_REC_SIZE           ((sizeof(struct app_record_store_rec_hdr) + \
+                                              APP_RECORD_STORE_PAYLOAD_SIZE + 3) & ~3)
+
+/// Number of record slots in a sector
+#define APP_RECORD_STORE_SLOTS              ((SPI_FLASH_SECTOR_SIZE - \
+                                              sizeof(struct app_record_store_sector_hdr)) / \
+                                             APP_RECORD_STORE_REC_SIZE)
+
+/// Number of records the store is guaranteed to hold. When a new sector is needed and all
+/// the sectors are used, the oldest sector is erased, so up to one sector more is kept.
+#define APP_RECORD_STORE_CAPACITY           ((APP_RECORD_STORE_SECTORS - 1) * APP_RECORD_STORE_SLOTS)
+
+/// Store format version
+#define APP_RECORD_STORE_VERSION            (0x0001)
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/// Status codes
+enum app_record_store_status
+{
+    APP_RECORD_STORE_OK,
+    /// Invalid parameter
+    APP_RECORD_STORE_ERR_INVALID_PARAM,
+    /// No record matches
+    APP_RECORD_STORE_ERR_NOT_FOUND,
+    /// SPI flash access failed
+    APP_RECORD_STORE_ERR_FLASH,
+};
+
+/// Record selection operators, as in the Record Access Control Point
+enum app_record_store_op
+{
+    /// All records
+    APP_RECORD_STORE_OP_ALL,
+    /// Key less than or equal to max
+    APP_RECORD_STORE_OP_LT_OR_EQ,
+    /// Key greater than or equal to min
+    APP_RECORD_STORE_OP_GT_OR_EQ,
+    /// Key within min and max (inclusive)
+    APP_RECORD_STORE_OP_WITHIN_RANGE,
+    /// Oldest record
+    APP_RECORD_STORE_OP_FIRST,
+    /// Most recent record
+    APP_RECORD_STORE_OP_LAST,
+};
+
+/// Header of a record slot
+struct app_record_store_rec_hdr
+{
+    /// Sequence number
+    uint32_t seq;
+    /// Time of the record, in units chosen by the application
+    uint32_t time;
+    /// Payload length
+    uint8_t len;
+    /// Programmed last, once the whole record is in flash
+    uint8_t commit;
+    /// Programmed when the record is deleted
+    uint8_t deleted;
+    uint8_t reserved;
+};
+
+/// Record, as stored in a slot
+struct app_record_store_rec
+{
+    struct app_record_store_rec_hdr hdr;
+    uint8_t data[APP_RECORD_STORE_REC_SIZE - sizeof(struct app_record_store_rec_hdr)];
+};
+
+/// Header at the start of every sector. The magic field is programmed last.
+struct app_record_store_sector_hdr
+{
+    uint16_t magic;
+    uint16_t version;
+    /// Position of the sector in the ring, increments by one per sector used
+    uint32_t sector_seq;
+    /// Sequence number of the record in the first slot
+    uint32_t first_seq;
+};
+
+/// Selection of records, for reading, counting or deleting them in sequence order
+struct app_record_store_cursor
+{
+    /// Sequence number of the next record
+    uint32_t seq;
+    /// Sequence number of the last record (inclusive)
+    uint32_t last_seq;
+    /// Time range, checked for every record if time_filter is set
+    uint32_t time_min;
+    uint32_t time_max;
+    bool time_filter;
+};
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Load the store from SPI flash and build the RAM index.
+ * @return APP_RECORD_STORE_OK or error code
+ ****************************************************************************************
+ */
+uint8_t app_record_store_init(void);
+
+/**
+ ****************************************************************************************
+ * @brief Append a record. When the store is full, the oldest sector is erased.
+ * @param[in] time          Time of the record, in units chosen by the application
+ * @param[in] data          Payload
+ * @param[in] len           Payload length, up to APP_RECORD_STORE_PAYLOAD_SIZE
+ * @param[in] scheduler_en  True: run rwip_schedule() while a sector is being erased
+ * @param[out] seq          Sequence number of the new record (may be NULL)
+ * @return APP_RECORD_STORE_OK or error code
+ ****************************************************************************************
+ */
+uint8_t app_record_store_append(uint32_t time, const void *data, uint8_t len,
+                                bool scheduler_en, uint32_t *seq);
+
+/**
+ ****************************************************************************************
+ * @brief Select records by sequence number.
+ * @param[out] cursor       Selection
+ * @param[in] op            Operator
+ * @param[in] min           Minimum sequence number (GT_OR_EQ, WITHIN_RANGE)
+ * @param[in] max           Maximum sequence number (LT_OR_EQ, WITHIN_RANGE)
+ * @return APP_RECORD_STORE_OK, APP_RECORD_STORE_ERR_NOT_FOUND if the selection is empty
+ ****************************************************************************************
+ */
+uint8_t app_record_store_select_seq(struct app_record_store_cursor *cursor, uint8_t op,
+                                    uint32_t min, uint32_t max);
+
+/**
+ ****************************************************************************************
+ * @brief Select records by time.
+ * @param[out] cursor       Selection
+ * @param[in] op            Operator
+ * @param[in] min           Minimum time (GT_OR_EQ, WITHIN_RANGE)
+ * @param[in] max           Maximum time (LT_OR_EQ, WITHIN_RANGE)
+ * @return APP_RECORD_STORE_OK, APP_RECORD_STORE_ERR_NOT_FOUND if the selection is empty
+ * @note As long as the records are appended in time order, the selection is found by
+ * binary search. Otherwise it covers the sectors whose time range overlaps and the
+ * records are filtered while they are read.
+ ****************************************************************************************
+ */
+uint8_t app_record_store_select_time(struct app_record_store_cursor *cursor, uint8_t op,
+                                     uint32_t min, uint32_t max);
+
+/**
+ ****************************************************************************************
+ * @brief Read the next records of a selection. The records of a sector are read with a
+ *        single SPI flash access.
+ * @param[in,out] cursor    Selection, advanced past the records read
+ * @param[out] recs         Records
+ * @param[in] max_recs      Size of recs
+ * @return Number of records read, 0 at the end of the selection
+ ****************************************************************************************
+ */
+uint16_t app_record_store_read(struct app_record_store_cursor *cursor,
+                               struct app_record_store_rec *recs, uint16_t max_recs);
+
+/**
+ ****************************************************************************************
+ * @brief Count the records of a selection.
+ * @param[in] cursor        Selection
+ * @return Number of records
+ ****************************************************************************************
+ */
+uint32_t app_record_store_count(const struct app_record_store_cursor *cursor);
+
+/**
+ ****************************************************************************************
+ * @brief Delete the records of a selection. Whole sectors are released, the records of
+ *        partly selected sectors are marked as deleted.
+ * @param[in] cursor        Selection
+ * @return APP_RECORD_STORE_OK or error code
+ ****************************************************************************************
+ */
+uint8_t app_record_store_delete(const struct app_record_store_cursor *cursor);
+
+/**
+ ****************************************************************************************
+ * @brief Get the number of records in the store.
+ * @return Number of records
+ ****************************************************************************************
+ */
+uint32_t app_record_store_get_count(void);
+
+#endif // CFG_SPI_FLASH_ENABLE
+
+#endif // _APP_RECORD_STORE_H_
+
+///@}
+///@}
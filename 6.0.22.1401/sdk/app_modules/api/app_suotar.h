@@ -97,6 +97,38 @@
     #error "SUOTA application is enabled but both I2C EEPROM and SPI Flash are disabled"
 #endif
 
+#if defined (CFG_SUOTAR_PIPELINED)
+    /// Image blocks are acknowledged when queued and programmed in the background
+    #define SUOTAR_PIPELINED                    1
+#else
+    /// Image blocks are programmed before they are acknowledged
+    #define SUOTAR_PIPELINED                    0
+#endif
+
+#if (SUOTAR_PIPELINED)
+/// Number of block buffers, including suota_all_pd (2: double buffering, 3: triple buffering)
+#if defined (CFG_SUOTAR_RX_BUFFERS)
+    #define SUOTAR_RX_BUFFERS                   (CFG_SUOTAR_RX_BUFFERS)
+#else
+    #define SUOTAR_RX_BUFFERS                   (2)
+#endif
+
+#if (SUOTAR_RX_BUFFERS < 2) || (SUOTAR_RX_BUFFERS > 3)
+    #error "SUOTAR_RX_BUFFERS must be 2 or 3."
+#endif
+
+/// Bytes programmed in one pass of the kernel scheduler (one SPI Flash page)
+#define SUOTAR_PROGRAM_CHUNK_SIZE               (256)
+#endif // SUOTAR_PIPELINED
+
+#if defined (CFG_SUOTAR_CRC32)
+    /// Unencrypted images are also checked against the CRC32 of their image header
+    #define SUOTAR_CRC32                        1
+#else
+    /// Images are checked only with the 8-bit XOR CRC
+    #define SUOTAR_CRC32                        0
+#endif
+
 /// @name SUOTAR status indications
 ///@{
 /** SUOTAR start indication */
@@ -203,6 +235,17 @@ typedef struct
 
     /// Reboot requested
     uint8_t     reboot_requested;
+
+#if (SUOTAR_CRC32)
+    /// CRC32 of the image code received so far
+    uint32_t    crc32_calc;
+
+    /// CRC32 of the image code taken from the image header
+    uint32_t    crc32_expected;
+
+    /// True if the image is not encrypted and crc32_expected can be checked
+    bool        crc32_check;
+#endif
 } app_suota_state;
 
 #if (!SUOTAR_SPI_DISABLE)
@@ -417,6 +460,16 @@ void suotar_send_mem_info_update_req(uint32_t mem_info);
  */
 void app_suotar_img_hdlr(void);
 
+#if (SUOTAR_PIPELINED)
+/**
+ ****************************************************************************************
+ * @brief Programs the next chunk of the queued image blocks to the external memory
+ *        device. Called from the APP_SUOTAR_PROGRAM message handler.
+ ****************************************************************************************
+ */
+void app_suotar_program_step(void);
+#endif
+
 #endif // BLE_SUOTA_RECEIVER
 
 #endif // APP_H_
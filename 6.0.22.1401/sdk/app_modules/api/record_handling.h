@@ -0,0 +1,170 @@
+/**
+ ****************************************************************************************
+ * @addtogroup APP_Modules
+ * @{
+ * @addtogroup Record_Handling Record Handling
+ * @brief Record Access Control Point handling over the record store
+ * @{
+ *
+ * @file record_handling.h
+ *
+ * @brief Record Access Control Point request handling header file.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _RECORD_HANDLING_H_
+#define _RECORD_HANDLING_H_
+
+/**
+ ****************************************************************************************
+ * @details Maps the filters of the Glucose and Continuous Glucose Monitoring Record Access
+ * Control Points to selections of the record store, and streams the selected records in
+ * batches: the records to notify are read from SPI flash a batch at a time and handed out
+ * one per notification.
+ *
+ * The time of a Glucose record is the user facing time in seconds, as returned by
+ * record_handling_date_time_to_sec(), and its sequence number is the low 16 bits of the
+ * sequence number in the store. The time of a CGM record is its time offset.
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include "rwip_config.h"
+#include "app_record_store.h"
+
+#if (BLE_GL_SENSOR)
+#include "glp_common.h"
+#endif
+
+#if (BLE_CGM_SERVER)
+#include "cgm_common.h"
+#endif
+
+#if defined (CFG_SPI_FLASH_ENABLE)
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Records read from SPI flash with one access while reporting
+#ifndef USER_CFG_RECORD_HANDLING_BATCH
+#define RECORD_HANDLING_BATCH               (8)
+#else
+#define RECORD_HANDLING_BATCH               (USER_CFG_RECORD_HANDLING_BATCH)
+#endif
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+#if (BLE_GL_SENSOR)
+/**
+ ****************************************************************************************
+ * @brief Convert a date and time to seconds since 1 January 1970.
+ * @param[in] date_time     Date and time
+ * @return Seconds
+ ****************************************************************************************
+ */
+uint32_t record_handling_date_time_to_sec(const struct prf_date_time *date_time);
+
+/**
+ ****************************************************************************************
+ * @brief Select the records of a Glucose RACP filter. The 16-bit sequence numbers of the
+ *        filter are those of the most recent records.
+ * @param[in] filter        RACP filter
+ * @param[out] cursor       Selection
+ * @return GLP_RSP_SUCCESS or the RACP response code
+ ****************************************************************************************
+ */
+uint8_t record_handling_glp_select(const struct glp_filter *filter,
+                                   struct app_record_store_cursor *cursor);
+#endif // BLE_GL_SENSOR
+
+#if (BLE_CGM_SERVER)
+/**
+ ****************************************************************************************
+ * @brief Select the records of a CGM RACP filter.
+ * @param[in] filter        RACP filter
+ * @param[out] cursor       Selection
+ * @return CGM_RSP_SUCCESS or the RACP response code
+ ****************************************************************************************
+ */
+uint8_t record_handling_cgm_select(const struct cgm_filter *filter,
+                                   struct app_record_store_cursor *cursor);
+#endif // BLE_CGM_SERVER
+
+/**
+ ****************************************************************************************
+ * @brief Count the records of a selection, for the Number of Stored Records response.
+ * @param[in] cursor        Selection
+ * @return Number of records, saturated to 16 bits
+ ****************************************************************************************
+ */
+uint16_t record_handling_count(const struct app_record_store_cursor *cursor);
+
+/**
+ ****************************************************************************************
+ * @brief Start reporting the records of a selection.
+ * @param[in] cursor        Selection
+ ****************************************************************************************
+ */
+void record_handling_report_start(const struct app_record_store_cursor *cursor);
+
+/**
+ ****************************************************************************************
+ * @brief Get the next record to report. Call it once the previous record has been sent.
+ * @return Record, NULL when the report is complete or aborted
+ ****************************************************************************************
+ */
+const struct app_record_store_rec *record_handling_report_next(void);
+
+/**
+ ****************************************************************************************
+ * @brief Abort the report in progress.
+ ****************************************************************************************
+ */
+void record_handling_report_abort(void);
+
+#endif // CFG_SPI_FLASH_ENABLE
+
+/**
+ ****************************************************************************************
+ * @brief Load the stored records. Nothing is stored without SPI flash.
+ ****************************************************************************************
+ */
+void default_set_stored_records(void);
+
+#endif // _RECORD_HANDLING_H_
+
+///@}
+///@}
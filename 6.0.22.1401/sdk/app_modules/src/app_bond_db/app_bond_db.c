@@ -60,6 +60,23 @@
 #define BOND_DB_EMPTY_SLOT              (0)
 #define BOND_DB_SLOT_NOT_FOUND          (0xFF)
 
+#if defined (APP_BOND_DB_JOURNAL)
+/// First sector of the journal ring
+#define BOND_DB_JRNL_BASE               ((APP_BOND_DB_DATA_OFFSET / SPI_FLASH_SECTOR_SIZE) * SPI_FLASH_SECTOR_SIZE)
+/// Journal sector signature
+#define BOND_DB_JRNL_MAGIC              (0x4A42)
+/// Sequence number of a sector whose header has not been written yet
+#define BOND_DB_JRNL_SEQ_NONE           (0xFFFFFFFF)
+/// Record types
+#define BOND_DB_JRNL_REC_ADD            (0x01)
+#define BOND_DB_JRNL_REC_REMOVE         (0x02)
+#define BOND_DB_JRNL_REC_FREE           (0xFF)
+/// Value of the commit field of a completely written record
+#define BOND_DB_JRNL_COMMITTED          (0x5A)
+/// Size of the bond data payload of an ADD record (word aligned)
+#define BOND_DB_JRNL_DATA_SIZE          ((sizeof(struct app_sec_bond_data_env_tag) + 3) & ~3)
+#endif
+
 /*
  * TYPE DEFINITIONS
  ****************************************************************************************
@@ -75,6 +92,53 @@ struct bond_db
     uint16_t end_hdr;
 };
 
+#if defined (APP_BOND_DB_JOURNAL)
+/// Header at the start of every journal sector. It is written after the snapshot of
+/// the database that follows it, so a sector with a valid header is always complete.
+/// The magic is programmed last, so that an interrupted header is not valid.
+struct bond_db_jrnl_sector_hdr
+{
+    uint16_t magic;
+    uint16_t version;
+    uint32_t seq;
+    /// Timestamp counter of the database when the snapshot was taken
+    uint32_t timestamp_counter;
+};
+
+/// Header of a journal record. ADD records are followed by the bond data of the slot.
+/// The timestamp of an ADD record is the timestamp of the slot, the one of a REMOVE
+/// record is the timestamp counter of the database after the removal.
+struct bond_db_jrnl_rec_hdr
+{
+    uint8_t type;
+    uint8_t slot;
+    uint8_t commit;
+    uint8_t reserved;
+    uint32_t timestamp;
+};
+
+/// Position of the journal in SPI flash
+struct bond_db_jrnl_env
+{
+    uint32_t seq;
+    uint32_t wr_offset;
+    uint8_t sector;
+};
+
+/// A snapshot of a full database must always fit in one sector
+typedef uint8_t bond_db_jrnl_snapshot_size_check[(sizeof(struct bond_db_jrnl_sector_hdr) +
+    APP_BOND_DB_MAX_BONDED_PEERS * (sizeof(struct bond_db_jrnl_rec_hdr) + BOND_DB_JRNL_DATA_SIZE)
+    <= SPI_FLASH_SECTOR_SIZE) ? 1 : -1];
+
+/// Number of journal sectors taken by a database stored by the default backend
+#define BOND_DB_JRNL_LEGACY_SECTORS     (((APP_BOND_DB_DATA_OFFSET + sizeof(struct bond_db) - 1) / \
+                                          SPI_FLASH_SECTOR_SIZE) - (BOND_DB_JRNL_BASE / SPI_FLASH_SECTOR_SIZE) + 1)
+
+/// A database stored by the default backend is imported into a sector it does not use
+typedef uint8_t bond_db_jrnl_legacy_size_check[(BOND_DB_JRNL_LEGACY_SECTORS <
+    APP_BOND_DB_JOURNAL_SECTORS) ? 1 : -1];
+#endif
+
 /*
  * LOCAL VARIABLE DEFINITIONS
  ****************************************************************************************
@@ -82,6 +146,10 @@ struct bond_db
 
 static struct bond_db bdb __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
 
+#if defined (APP_BOND_DB_JOURNAL)
+static struct bond_db_jrnl_env bdb_jrnl __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+#endif
+
 /*
  * GLOBAL VARIABLE DEFINITIONS
  ****************************************************************************************
@@ -109,18 +177,56 @@ static void bond_db_spi_flash_init(void)
     spi_flash_configure_memory_protection(SPI_FLASH_MEM_PROT_NONE);
 }
 
-static void bond_db_load_flash(void)
+/**
+ ****************************************************************************************
+ * @brief Erase a Flash sector
+ * @param[in] offset        Offset of the sector
+ * @param[in] scheduler_en  True: Enable rwip_scheduler while Flash is being erased
+ *                          False: Do not enable rwip_scheduler. Blocking mode
+ * @return ret              Error code or success (ERR_OK)
+ ****************************************************************************************
+ */
+static int8_t bond_db_erase_flash_sector(uint32_t offset, bool scheduler_en)
 {
-    uint32_t actual_size;
-    bond_db_spi_flash_init();
+    int8_t ret;
+    uint32_t timeout_cnt;
 
-    spi_flash_read_data((uint8_t *)&bdb, APP_BOND_DB_DATA_OFFSET, sizeof(struct bond_db),
-                        &actual_size);
+    if (scheduler_en)
+    {
+        // Non-Blocking Erase of a Flash sector
+        ret = spi_flash_block_erase_no_wait(offset, SPI_FLASH_OP_SE);
+        if (ret != SPI_FLASH_ERR_OK)
+            return ret;
 
-    // Power down flash
-    spi_flash_power_down();
+        timeout_cnt = 0;
+
+        while ((spi_flash_read_status_reg() & SPI_FLASH_SR_BUSY) != 0)
+        {
+            // Check if BLE is on and not in deep sleep and call rwip_schedule()
+            if ((GetBits16(CLK_RADIO_REG, BLE_ENABLE) == 1) &&
+               (GetBits32(BLE_DEEPSLCNTL_REG, DEEP_SLEEP_STAT) == 0))
+            {
+                // Assuming that the WDG is not active, timeout will be reached in case of a Flash erase error.
+                // NOTE: In case the WDG is active, the WDG timer will expire (much) earlier than the timeout
+                // is reached and therefore an NMI will be triggered.
+                if (++timeout_cnt > SPI_FLASH_WAIT)
+                {
+                    return SPI_FLASH_ERR_TIMEOUT;
+                }
+                rwip_schedule();
+            }
+        }
+    }
+    else
+    {
+        // Blocking Erase of a Flash sector
+        ret = spi_flash_block_erase(offset, SPI_FLASH_OP_SE);
+    }
+
+    return ret;
 }
 
+#if !defined (APP_BOND_DB_JOURNAL)
 /**
  ****************************************************************************************
  * @brief Erase Flash sectors where bond database is stored
@@ -133,9 +239,8 @@ static int8_t bond_db_erase_flash_sectors(bool scheduler_en)
 {
     uint32_t sector_nb;
     uint32_t offset;
-    int8_t ret;
+    int8_t ret = SPI_FLASH_ERR_OK;
     int i;
-    uint32_t timeout_cnt;
 
     // Calculate the starting sector offset
     offset = (APP_BOND_DB_DATA_OFFSET / SPI_FLASH_SECTOR_SIZE) * SPI_FLASH_SECTOR_SIZE;
@@ -147,70 +252,401 @@ static int8_t bond_db_erase_flash_sectors(bool scheduler_en)
 
     for (i = 0; i < sector_nb; i++)
     {
-        if (scheduler_en)
+        ret = bond_db_erase_flash_sector(offset, scheduler_en);
+        if (ret != SPI_FLASH_ERR_OK)
+            break;
+        offset += SPI_FLASH_SECTOR_SIZE;
+    }
+
+    return ret;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Store Bond Database to Flash memory
+ * @param[in] scheduler_en  True: Enable rwip_scheduler while Flash is being erased
+ *                          False: Do not enable rwip_scheduler. Blocking mode
+ * @return ret              Error code or success (ERR_OK)
+ ****************************************************************************************
+ */
+static int8_t bond_db_store_flash(bool scheduler_en)
+{
+    uint32_t actual_size;
+    int8_t ret;
+
+    bond_db_spi_flash_init();
+
+    ret = bond_db_erase_flash_sectors(scheduler_en);
+    if (ret == SPI_FLASH_ERR_OK)
+    {
+        ret = spi_flash_write_data((uint8_t *)&bdb, APP_BOND_DB_DATA_OFFSET,
+                                   sizeof(struct bond_db), &actual_size);
+    }
+
+    // Power down flash
+    spi_flash_power_down();
+
+    return ret;
+}
+
+static void bond_db_load_flash(void)
+{
+    uint32_t actual_size;
+    bond_db_spi_flash_init();
+
+    spi_flash_read_data((uint8_t *)&bdb, APP_BOND_DB_DATA_OFFSET, sizeof(struct bond_db),
+                        &actual_size);
+
+    // Power down flash
+    spi_flash_power_down();
+}
+
+#else // APP_BOND_DB_JOURNAL
+
+/**
+ ****************************************************************************************
+ * @brief Get the Flash offset of a journal sector
+ * @param[in] sector        Index of the sector in the journal ring
+ * @return Offset of the sector
+ ****************************************************************************************
+ */
+__STATIC_INLINE uint32_t bond_db_jrnl_sector_offset(uint8_t sector)
+{
+    return BOND_DB_JRNL_BASE + sector * SPI_FLASH_SECTOR_SIZE;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Get the size of a journal record
+ * @param[in] type          Record type
+ * @return Record size, 0 if the type is unknown
+ ****************************************************************************************
+ */
+static uint32_t bond_db_jrnl_rec_size(uint8_t type)
+{
+    switch (type)
+    {
+        case BOND_DB_JRNL_REC_ADD:
+            return sizeof(struct bond_db_jrnl_rec_hdr) + BOND_DB_JRNL_DATA_SIZE;
+        case BOND_DB_JRNL_REC_REMOVE:
+            return sizeof(struct bond_db_jrnl_rec_hdr);
+        default:
+            return 0;
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Write a record to the journal. The commit field is programmed last, so that a
+ *        record interrupted by a power failure is ignored when the journal is replayed.
+ * @param[in] offset        Flash offset of the record
+ * @param[in] slot          Bond database slot. An ADD record is written if the slot is
+ *                          valid, otherwise a REMOVE record.
+ * @return Error code or success (ERR_OK)
+ ****************************************************************************************
+ */
+static int8_t bond_db_jrnl_write_rec(uint32_t offset, uint8_t slot)
+{
+    uint8_t buf[sizeof(struct bond_db_jrnl_rec_hdr) + BOND_DB_JRNL_DATA_SIZE];
+    struct bond_db_jrnl_rec_hdr *rec = (struct bond_db_jrnl_rec_hdr *)buf;
+    uint32_t actual_size;
+    uint32_t size;
+    uint8_t commit = BOND_DB_JRNL_COMMITTED;
+    int8_t ret;
+
+    memset(buf, 0xFF, sizeof(buf));
+    rec->type = (bdb.valid_slot[slot] == BOND_DB_VALID_ENTRY) ? BOND_DB_JRNL_REC_ADD :
+                                                                  BOND_DB_JRNL_REC_REMOVE;
+    rec->slot = slot;
+    rec->timestamp = (rec->type == BOND_DB_JRNL_REC_ADD) ? bdb.timestamp[slot] :
+                                                          bdb.timestamp_counter;
+    if (rec->type == BOND_DB_JRNL_REC_ADD)
+    {
+        memcpy(&buf[sizeof(struct bond_db_jrnl_rec_hdr)], &bdb.data[slot],
+               sizeof(struct app_sec_bond_data_env_tag));
+    }
+    size = bond_db_jrnl_rec_size(rec->type);
+
+    ret = spi_flash_write_data(buf, offset, size, &actual_size);
+    if (ret != SPI_FLASH_ERR_OK)
+        return ret;
+
+    return spi_flash_write_data(&commit, offset + offsetof(struct bond_db_jrnl_rec_hdr, commit),
+                                sizeof(commit), &actual_size);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Compact the bond database into the next sector of the journal ring. The next
+ *        sector is erased, a snapshot of all valid entries is written and the sector
+ *        header is written last. The current sector stays intact until then, so a power
+ *        failure during compaction keeps the previous state of the database.
+ * @param[in] scheduler_en  True: Enable rwip_scheduler while Flash is being erased
+ *                          False: Do not enable rwip_scheduler. Blocking mode
+ * @return Error code or success (ERR_OK). On error the journal stays in the current
+ *         sector and the next update retries the compaction.
+ ****************************************************************************************
+ */
+static int8_t bond_db_jrnl_compact(bool scheduler_en)
+{
+    struct bond_db_jrnl_sector_hdr hdr;
+    uint8_t sector = (bdb_jrnl.sector + 1) % APP_BOND_DB_JOURNAL_SECTORS;
+    uint32_t base = bond_db_jrnl_sector_offset(sector);
+    uint32_t offset = sizeof(struct bond_db_jrnl_sector_hdr);
+    uint32_t actual_size;
+    int8_t ret;
+
+    ret = bond_db_erase_flash_sector(base, scheduler_en);
+    if (ret != SPI_FLASH_ERR_OK)
+        return ret;
+
+    for (uint8_t i = 0; i < APP_BOND_DB_MAX_BONDED_PEERS; i++)
+    {
+        if (bdb.valid_slot[i] == BOND_DB_VALID_ENTRY)
         {
-            // Non-Blocking Erase of a Flash sector
-            ret = spi_flash_block_erase_no_wait(offset, SPI_FLASH_OP_SE);
+            ret = bond_db_jrnl_write_rec(base + offset, i);
             if (ret != SPI_FLASH_ERR_OK)
-                break;
+                return ret;
+            offset += bond_db_jrnl_rec_size(BOND_DB_JRNL_REC_ADD);
+        }
+    }
+
+    hdr.magic = BOND_DB_JRNL_MAGIC;
+    hdr.version = BOND_DB_VERSION;
+    hdr.seq = bdb_jrnl.seq + 1;
+    hdr.timestamp_counter = bdb.timestamp_counter;
+    ret = spi_flash_write_data((uint8_t *)&hdr + sizeof(hdr.magic), base + sizeof(hdr.magic),
+                               sizeof(hdr) - sizeof(hdr.magic), &actual_size);
+    if (ret != SPI_FLASH_ERR_OK)
+        return ret;
+
+    ret = spi_flash_write_data((uint8_t *)&hdr.magic, base, sizeof(hdr.magic), &actual_size);
+    if (ret != SPI_FLASH_ERR_OK)
+        return ret;
+
+    bdb_jrnl.sector = sector;
+    bdb_jrnl.seq = hdr.seq;
+    bdb_jrnl.wr_offset = offset;
+
+    return SPI_FLASH_ERR_OK;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Append the current state of a slot to the journal. Compacts the database into
+ *        the next sector if the record does not fit in the active one.
+ * @param[in] slot          Bond database slot
+ * @param[in] scheduler_en  True: Enable rwip_scheduler while Flash is being erased
+ *                          False: Do not enable rwip_scheduler. Blocking mode
+ * @return Error code or success (ERR_OK)
+ ****************************************************************************************
+ */
+static int8_t bond_db_jrnl_append(uint8_t slot, bool scheduler_en)
+{
+    uint32_t size = (bdb.valid_slot[slot] == BOND_DB_VALID_ENTRY) ?
+                    bond_db_jrnl_rec_size(BOND_DB_JRNL_REC_ADD) :
+                    bond_db_jrnl_rec_size(BOND_DB_JRNL_REC_REMOVE);
+    int8_t ret;
+
+    bond_db_spi_flash_init();
+
+    if ((bdb_jrnl.seq == BOND_DB_JRNL_SEQ_NONE) ||
+        (bdb_jrnl.wr_offset + size > SPI_FLASH_SECTOR_SIZE))
+    {
+        // The snapshot already contains the new state of the slot
+        ret = bond_db_jrnl_compact(scheduler_en);
+    }
+    else
+    {
+        ret = bond_db_jrnl_write_rec(bond_db_jrnl_sector_offset(bdb_jrnl.sector) + bdb_jrnl.wr_offset,
+                                     slot);
+        if (ret == SPI_FLASH_ERR_OK)
+        {
+            bdb_jrnl.wr_offset += size;
+        }
+        else
+        {
+            // Leave the damaged sector behind on the next update
+            bdb_jrnl.wr_offset = SPI_FLASH_SECTOR_SIZE;
+        }
+    }
+
+    // Power down flash
+    spi_flash_power_down();
 
-            timeout_cnt = 0;
+    return ret;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Replay the records of a journal sector into the bond database cache. The
+ *        timestamp counter restarts from the one of the snapshot and is advanced by the
+ *        records, so it never goes back across a reset.
+ * @param[in] sector        Index of the sector in the journal ring
+ ****************************************************************************************
+ */
+static void bond_db_jrnl_replay(uint8_t sector)
+{
+    struct bond_db_jrnl_rec_hdr rec;
+    uint32_t base = bond_db_jrnl_sector_offset(sector);
+    uint32_t offset = sizeof(struct bond_db_jrnl_sector_hdr);
+    uint32_t actual_size;
+    uint32_t size;
+
+    while (offset + sizeof(rec) <= SPI_FLASH_SECTOR_SIZE)
+    {
+        spi_flash_read_data((uint8_t *)&rec, base + offset, sizeof(rec), &actual_size);
+        if (rec.type == BOND_DB_JRNL_REC_FREE)
+            break;
 
-            while ((spi_flash_read_status_reg() & SPI_FLASH_SR_BUSY) != 0)
+        size = bond_db_jrnl_rec_size(rec.type);
+        if ((size == 0) || (offset + size > SPI_FLASH_SECTOR_SIZE))
+        {
+            // Corrupted record: the rest of the sector cannot be parsed
+            offset = SPI_FLASH_SECTOR_SIZE;
+            break;
+        }
+
+        // Skip records that were interrupted by a power failure
+        if ((rec.commit == BOND_DB_JRNL_COMMITTED) && (rec.slot < APP_BOND_DB_MAX_BONDED_PEERS))
+        {
+            if (rec.type == BOND_DB_JRNL_REC_ADD)
+            {
+                spi_flash_read_data((uint8_t *)&bdb.data[rec.slot], base + offset + sizeof(rec),
+                                    sizeof(struct app_sec_bond_data_env_tag), &actual_size);
+                bdb.valid_slot[rec.slot] = BOND_DB_VALID_ENTRY;
+                bdb.timestamp[rec.slot] = rec.timestamp;
+                if (rec.timestamp >= bdb.timestamp_counter)
+                {
+                    bdb.timestamp_counter = rec.timestamp + 1;
+                }
+            }
+            else
             {
-                // Check if BLE is on and not in deep sleep and call rwip_schedule()
-                if ((GetBits16(CLK_RADIO_REG, BLE_ENABLE) == 1) &&
-                   (GetBits32(BLE_DEEPSLCNTL_REG, DEEP_SLEEP_STAT) == 0))
+                memset((void *)&bdb.data[rec.slot], 0, sizeof(struct app_sec_bond_data_env_tag));
+                bdb.timestamp[rec.slot] = 0;
+                bdb.valid_slot[rec.slot] = BOND_DB_EMPTY_SLOT;
+                if (rec.timestamp > bdb.timestamp_counter)
                 {
-                    // Assuming that the WDG is not active, timeout will be reached in case of a Flash erase error.
-                    // NOTE: In case the WDG is active, the WDG timer will expire (much) earlier than the timeout
-                    // is reached and therefore an NMI will be triggered.
-                    if (++timeout_cnt > SPI_FLASH_WAIT)
-                    {
-                        return SPI_FLASH_ERR_TIMEOUT;
-                    }
-                    rwip_schedule();
+                    bdb.timestamp_counter = rec.timestamp;
                 }
             }
         }
-        else
+        offset += size;
+    }
+
+    bdb_jrnl.wr_offset = offset;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Import a database stored by the default backend, when the journal is enabled on
+ *        a device that already has bonds. The database is compacted into the first
+ *        journal sector after the ones it takes, so it stays intact until the snapshot
+ *        is complete. A failed import is retried by the next update or the next boot.
+ * @return True if a valid database was found
+ ****************************************************************************************
+ */
+static bool bond_db_jrnl_import_legacy(void)
+{
+    uint32_t actual_size;
+    int8_t ret;
+
+    spi_flash_read_data((uint8_t *)&bdb, APP_BOND_DB_DATA_OFFSET, sizeof(struct bond_db),
+                        &actual_size);
+
+    if ((bdb.start_hdr != BOND_DB_HEADER_START) || (bdb.end_hdr != BOND_DB_HEADER_END))
+    {
+        return false;
+    }
+
+    for (uint8_t i = 0; i < APP_BOND_DB_MAX_BONDED_PEERS; i++)
+    {
+        if (bdb.valid_slot[i] != BOND_DB_VALID_ENTRY)
         {
-            // Blocking Erase of a Flash sector
-            ret = spi_flash_block_erase(offset, SPI_FLASH_OP_SE);
-            if (ret != SPI_FLASH_ERR_OK)
-                break;
+            bdb.valid_slot[i] = BOND_DB_EMPTY_SLOT;
         }
-        offset += SPI_FLASH_SECTOR_SIZE;
     }
 
-    return ret;
+    bdb_jrnl.sector = BOND_DB_JRNL_LEGACY_SECTORS - 1;
+    ret = bond_db_jrnl_compact(false);
+    // The database in Flash is not converted yet. The next update compacts it again.
+    ASSERT_WARNING(ret == SPI_FLASH_ERR_OK);
+
+    return true;
 }
 
 /**
  ****************************************************************************************
- * @brief Store Bond Database to Flash memory
- * @param[in] scheduler_en  True: Enable rwip_scheduler while Flash is being erased
- *                          False: Do not enable rwip_scheduler. Blocking mode
+ * @brief Rebuild the bond database cache from the journal. The sector with the highest
+ *        sequence number holds the latest snapshot followed by the later updates. If no
+ *        sector is valid, a database stored by the default backend is imported.
  ****************************************************************************************
  */
-static void bond_db_store_flash(bool scheduler_en)
+static void bond_db_load_flash(void)
 {
+    struct bond_db_jrnl_sector_hdr hdr;
     uint32_t actual_size;
-    int8_t ret;
+    bool found = false;
 
     bond_db_spi_flash_init();
 
-    ret = bond_db_erase_flash_sectors(scheduler_en);
-    if (ret == SPI_FLASH_ERR_OK)
+    memset((void *)&bdb, 0, sizeof(struct bond_db));
+    bdb_jrnl.seq = BOND_DB_JRNL_SEQ_NONE;
+    bdb_jrnl.sector = APP_BOND_DB_JOURNAL_SECTORS - 1;
+    bdb_jrnl.wr_offset = SPI_FLASH_SECTOR_SIZE;
+
+    for (uint8_t i = 0; i < APP_BOND_DB_JOURNAL_SECTORS; i++)
+    {
+        spi_flash_read_data((uint8_t *)&hdr, bond_db_jrnl_sector_offset(i), sizeof(hdr), &actual_size);
+        if ((hdr.magic == BOND_DB_JRNL_MAGIC) && (hdr.version == BOND_DB_VERSION) &&
+            (hdr.seq != BOND_DB_JRNL_SEQ_NONE) && (!found || (hdr.seq > bdb_jrnl.seq)))
+        {
+            found = true;
+            bdb_jrnl.seq = hdr.seq;
+            bdb_jrnl.sector = i;
+            bdb.timestamp_counter = hdr.timestamp_counter;
+        }
+    }
+
+    if (found)
+    {
+        bond_db_jrnl_replay(bdb_jrnl.sector);
+        bdb.start_hdr = BOND_DB_HEADER_START;
+        bdb.end_hdr = BOND_DB_HEADER_END;
+    }
+    else if (!bond_db_jrnl_import_legacy())
     {
-        spi_flash_write_data((uint8_t *)&bdb, APP_BOND_DB_DATA_OFFSET,
-                             sizeof(struct bond_db), &actual_size);
+        memset((void *)&bdb, 0, sizeof(struct bond_db));
     }
 
     // Power down flash
     spi_flash_power_down();
 }
 
+/**
+ ****************************************************************************************
+ * @brief Store Bond Database to Flash memory (compacted into the next journal sector)
+ * @param[in] scheduler_en  True: Enable rwip_scheduler while Flash is being erased
+ *                          False: Do not enable rwip_scheduler. Blocking mode
+ * @return Error code or success (ERR_OK)
+ ****************************************************************************************
+ */
+static int8_t bond_db_store_flash(bool scheduler_en)
+{
+    int8_t ret;
+
+    bond_db_spi_flash_init();
+
+    ret = bond_db_jrnl_compact(scheduler_en);
+
+    // Power down flash
+    spi_flash_power_down();
+
+    return ret;
+}
+#endif // APP_BOND_DB_JOURNAL
+
 #elif defined (USER_CFG_APP_BOND_DB_USE_I2C_EEPROM)
 
 static void bond_db_load_eeprom(void)
@@ -265,12 +701,34 @@ __STATIC_INLINE void bond_db_load_ext(void)
 __STATIC_INLINE void bond_db_store_ext(bool scheduler_en)
 {
     #if defined (USER_CFG_APP_BOND_DB_USE_SPI_FLASH)
-    bond_db_store_flash(scheduler_en);
+    int8_t ret = bond_db_store_flash(scheduler_en);
+    // The database in Flash is out of date. The next update stores it again.
+    ASSERT_WARNING(ret == SPI_FLASH_ERR_OK);
     #elif defined (USER_CFG_APP_BOND_DB_USE_I2C_EEPROM)
     bond_db_store_eeprom();
     #endif
 }
 
+/**
+ ****************************************************************************************
+ * @brief Store the current state of one slot of the Bond Database to external memory
+ * @param[in] slot          Slot that has been added, replaced or removed
+ * @param[in] scheduler_en  Only used if external memory is Flash
+                            True: Enable rwip_scheduler while Flash is being erased
+ *                          False: Do not enable rwip_scheduler. Blocking mode
+ ****************************************************************************************
+ */
+__STATIC_INLINE void bond_db_store_slot_ext(uint8_t slot, bool scheduler_en)
+{
+    #if defined (APP_BOND_DB_JOURNAL)
+    int8_t ret = bond_db_jrnl_append(slot, scheduler_en);
+    // The journal is out of date. The next update compacts the database into Flash.
+    ASSERT_WARNING(ret == SPI_FLASH_ERR_OK);
+    #else
+    bond_db_store_ext(scheduler_en);
+    #endif
+}
+
 /**
  ****************************************************************************************
  * @brief Store Bond data entry to external memory
@@ -285,7 +743,7 @@ static void bond_db_store_at_idx(struct app_sec_bond_data_env_tag *data, int idx
     memcpy(&bdb.data[idx], data, sizeof(struct app_sec_bond_data_env_tag));
     // Store new bond data to external memory
     // In case of Flash (erase then write) enable the scheduler
-    bond_db_store_ext(true);
+    bond_db_store_slot_ext(idx, true);
 }
 
 /**
@@ -457,6 +915,8 @@ void default_app_bdb_remove_entry(enum bdb_search_by_type search_type, enum bdb_
             memset((void *)&bdb.data[slot_found], 0, sizeof(struct app_sec_bond_data_env_tag));
             bdb.timestamp[slot_found] = 0;
             bdb.valid_slot[slot_found] = BOND_DB_EMPTY_SLOT;
+            // Store the removal to the external non volatile memory
+            bond_db_store_slot_ext(slot_found, true);
         }
         else
         {
@@ -470,9 +930,9 @@ void default_app_bdb_remove_entry(enum bdb_search_by_type search_type, enum bdb_
                     bdb.valid_slot[i] = BOND_DB_EMPTY_SLOT;
                 }
             }
+            // Store the updated cache to the external non volatile memory
+            bond_db_store_ext(true);
         }
-        // Store the updated cache to the external non volatile memory
-        bond_db_store_ext(true);
     }
 }
 
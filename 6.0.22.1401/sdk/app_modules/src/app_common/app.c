@@ -783,6 +783,11 @@ void app_init(void)
     memcpy(device_info.dev_name.name, USER_DEVICE_NAME, device_info.dev_name.length);
     device_info.appearance = 0x0000;
 
+#if !defined (__DA14531__) || defined (__EXCLUDE_ROM_APP_TASK__)
+    // Index the messages handled by the process handlers
+    app_entry_point_init();
+#endif
+
     // Create APP task
     ke_task_create(TASK_APP, &TASK_DESC_APP);
 
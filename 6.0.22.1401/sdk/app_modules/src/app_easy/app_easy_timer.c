@@ -54,6 +54,11 @@
 #include "app_entry_point.h"
 #include "app_easy_timer.h"
 
+#if (APP_EASY_TIMER_WHEEL)
+#include "co_math.h"
+#include "lld_evt.h"
+#endif
+
 /*
  * DEFINES
  ****************************************************************************************
@@ -102,6 +107,81 @@ static timer_callback timer_callbacks[APP_TIMER_MAX_NUM]          __SECTION_ZERO
 // Array that holds the callback function of the active timers, whose delay period is to be modified
 static timer_callback modified_timer_callbacks[APP_TIMER_MAX_NUM] __SECTION_ZERO("retention_mem_area0");
 
+#if (APP_EASY_TIMER_WHEEL)
+/*
+    The wheel timers are kept in a hierarchical timer wheel of WHEEL_LEVELS levels of
+    WHEEL_SLOTS slots each. A slot of level 0 holds the timers that expire at one tick
+    (10 ms) of the current block of WHEEL_SLOTS ticks. A slot of level 1 holds the timers of
+    one of the next blocks of the current superblock, and so on. The timers beyond the last
+    level are kept in an overflow list. When the wheel enters a new block (superblock), the
+    timers of the respective slot are moved to the lower levels. The timers are kept in
+    doubly linked lists, so that they are inserted and cancelled in constant time.
+    All the links are timer handlers, so that zero is the empty value of the retained data.
+ */
+#define WHEEL_SLOT_BITS         (5)
+#define WHEEL_SLOTS             (1UL << WHEEL_SLOT_BITS)
+#define WHEEL_LEVELS            (3)
+
+/// List of the timers beyond the range of the last level
+#define WHEEL_LIST_OVERFLOW     (WHEEL_LEVELS * WHEEL_SLOTS)
+/// List of the timers created while the BLE was sleeping, not started yet
+#define WHEEL_LIST_PENDING      (WHEEL_LIST_OVERFLOW + 1)
+#define WHEEL_LISTS             (WHEEL_LIST_PENDING + 1)
+
+/// BLE time slots (625 us) per tick (10 ms)
+#define WHEEL_BLE_SLOTS_PER_TICK    (16)
+
+#define WHEEL_HND_IS_VALID(timer_id)    ((timer_id > 0) && (timer_id <= APP_EASY_TIMER_WHEEL_NUM))
+
+struct wheel_timer
+{
+    /// Callback function, NULL if the timer is not active
+    timer_callback fn;
+    /// Expiration tick (the delay while in the pending list)
+    uint32_t expiry;
+    /// Period in ticks, 0 for one-shot timers
+    uint32_t period;
+    /// Next timer in the same list (next free timer if not active)
+    timer_hnd next;
+    /// Previous timer in the same list
+    timer_hnd prev;
+    /// List the timer is in
+    uint8_t list;
+};
+
+struct wheel_env_tag
+{
+    /// Current tick
+    uint32_t now;
+    /// Next tick to be processed
+    uint32_t cursor;
+    /// BLE time of the current tick
+    uint32_t ble_time;
+    /// Tick the kernel timer is set to
+    uint32_t armed_tick;
+    /// Bitmap of the non empty slots of each level
+    uint32_t occupied[WHEEL_LEVELS];
+    /// First timer of each list
+    timer_hnd head[WHEEL_LISTS];
+    /// First free timer
+    timer_hnd free;
+    /// Number of timers that have been used at least once
+    uint8_t used;
+    /// Number of active timers
+    uint8_t active;
+    /// Kernel timer is set
+    bool armed;
+    /// Time base is valid (set when the first timer of an empty wheel is started)
+    bool synced;
+    /// Timers are being processed
+    bool processing;
+};
+
+static struct wheel_timer wheel_timers[APP_EASY_TIMER_WHEEL_NUM] __SECTION_ZERO("retention_mem_area0");
+
+static struct wheel_env_tag wheel_env                           __SECTION_ZERO("retention_mem_area0");
+#endif // APP_EASY_TIMER_WHEEL
+
 /*
  * FUNCTION DEFINITIONS
  ****************************************************************************************
@@ -339,6 +419,462 @@ static int call_callback_handler(ke_msg_id_t const msgid,
     return KE_MSG_CONSUMED;
 }
 
+#if (APP_EASY_TIMER_WHEEL)
+/**
+ ****************************************************************************************
+ * @brief Add a wheel timer at the head of a list.
+ * @param[in] list     The list
+ * @param[in] timer_id The wheel timer handler
+ ****************************************************************************************
+ */
+static void wheel_list_add(uint8_t list, timer_hnd timer_id)
+{
+    struct wheel_timer *timer = &wheel_timers[timer_id - 1];
+
+    timer->list = list;
+    timer->prev = EASY_TIMER_INVALID_TIMER;
+    timer->next = wheel_env.head[list];
+    if (timer->next != EASY_TIMER_INVALID_TIMER)
+    {
+        wheel_timers[timer->next - 1].prev = timer_id;
+    }
+    wheel_env.head[list] = timer_id;
+
+    if (list < WHEEL_LIST_OVERFLOW)
+    {
+        wheel_env.occupied[list / WHEEL_SLOTS] |= 1UL << (list % WHEEL_SLOTS);
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Remove a wheel timer from its list.
+ * @param[in] timer_id The wheel timer handler
+ ****************************************************************************************
+ */
+static void wheel_list_remove(timer_hnd timer_id)
+{
+    struct wheel_timer *timer = &wheel_timers[timer_id - 1];
+
+    if (timer->prev != EASY_TIMER_INVALID_TIMER)
+    {
+        wheel_timers[timer->prev - 1].next = timer->next;
+    }
+    else
+    {
+        wheel_env.head[timer->list] = timer->next;
+    }
+    if (timer->next != EASY_TIMER_INVALID_TIMER)
+    {
+        wheel_timers[timer->next - 1].prev = timer->prev;
+    }
+
+    if ((timer->list < WHEEL_LIST_OVERFLOW) && (wheel_env.head[timer->list] == EASY_TIMER_INVALID_TIMER))
+    {
+        wheel_env.occupied[timer->list / WHEEL_SLOTS] &= ~(1UL << (timer->list % WHEEL_SLOTS));
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Place a wheel timer in the slot of its expiration tick.
+ * @param[in] timer_id The wheel timer handler
+ ****************************************************************************************
+ */
+static void wheel_place(timer_hnd timer_id)
+{
+    struct wheel_timer *timer = &wheel_timers[timer_id - 1];
+    uint32_t cursor = wheel_env.cursor;
+
+    // A timer that has already expired is processed at the next tick
+    if ((int32_t)(timer->expiry - cursor) < 0)
+    {
+        timer->expiry = cursor;
+    }
+
+    for (uint8_t level = 0; level < WHEEL_LEVELS; level++)
+    {
+        uint8_t shift = level * WHEEL_SLOT_BITS;
+
+        // Check if the timer expires within the current block of this level
+        if ((timer->expiry >> (shift + WHEEL_SLOT_BITS)) == (cursor >> (shift + WHEEL_SLOT_BITS)))
+        {
+            wheel_list_add(level * WHEEL_SLOTS + ((timer->expiry >> shift) & (WHEEL_SLOTS - 1)), timer_id);
+            return;
+        }
+    }
+
+    wheel_list_add(WHEEL_LIST_OVERFLOW, timer_id);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Move the timers of a list to the slots of their expiration ticks.
+ * @param[in] list The list
+ ****************************************************************************************
+ */
+static void wheel_cascade(uint8_t list)
+{
+    timer_hnd timer_id = wheel_env.head[list];
+
+    while (timer_id != EASY_TIMER_INVALID_TIMER)
+    {
+        timer_hnd next = wheel_timers[timer_id - 1].next;
+
+        // Timers added back to the same list go to its head, so they are not met again
+        wheel_list_remove(timer_id);
+        wheel_place(timer_id);
+        timer_id = next;
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Find the first non empty slot of a level, starting from a given slot.
+ * @param[in] level The level
+ * @param[in] slot  The first slot to check
+ * @return The slot index, WHEEL_SLOTS if all slots from the given one on are empty
+ ****************************************************************************************
+ */
+static uint32_t wheel_first_slot(uint8_t level, uint32_t slot)
+{
+    uint32_t occupied;
+
+    if (slot >= WHEEL_SLOTS)
+    {
+        return WHEEL_SLOTS;
+    }
+
+    occupied = wheel_env.occupied[level] & ~((1UL << slot) - 1);
+    if (occupied == 0)
+    {
+        return WHEEL_SLOTS;
+    }
+
+    // Index of the lowest bit set
+    return 31 - co_clz(occupied & (~occupied + 1));
+}
+
+/**
+ ****************************************************************************************
+ * @brief Find the earliest expiration tick of a list.
+ * @param[in] list The list
+ * @return The earliest expiration tick
+ ****************************************************************************************
+ */
+static uint32_t wheel_list_first_expiry(uint8_t list)
+{
+    timer_hnd timer_id = wheel_env.head[list];
+    uint32_t expiry = wheel_timers[timer_id - 1].expiry;
+
+    for (timer_id = wheel_timers[timer_id - 1].next; timer_id != EASY_TIMER_INVALID_TIMER;
+         timer_id = wheel_timers[timer_id - 1].next)
+    {
+        if ((int32_t)(wheel_timers[timer_id - 1].expiry - expiry) < 0)
+        {
+            expiry = wheel_timers[timer_id - 1].expiry;
+        }
+    }
+
+    return expiry;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Find the earliest expiration tick of the wheel.
+ * @details The first non empty slot of a level holds its earliest timers. The timers of
+ * a block the cursor has entered are only moved to the lower levels when the block is
+ * processed, so they may expire before the timers of the lower levels and the earliest
+ * timer of every level is taken.
+ * @param[out] expiry The earliest expiration tick
+ * @return false if the wheel is empty
+ ****************************************************************************************
+ */
+static bool wheel_first_expiry(uint32_t *expiry)
+{
+    uint32_t slot = wheel_first_slot(0, wheel_env.cursor & (WHEEL_SLOTS - 1));
+    uint32_t earliest = 0;
+    uint32_t first;
+    bool found = false;
+
+    if (slot < WHEEL_SLOTS)
+    {
+        earliest = (wheel_env.cursor & ~(WHEEL_SLOTS - 1)) | slot;
+        found = true;
+    }
+
+    for (uint8_t level = 1; level < WHEEL_LEVELS; level++)
+    {
+        slot = wheel_first_slot(level, 0);
+        if (slot < WHEEL_SLOTS)
+        {
+            first = wheel_list_first_expiry(level * WHEEL_SLOTS + slot);
+            if (!found || ((int32_t)(first - earliest) < 0))
+            {
+                earliest = first;
+                found = true;
+            }
+        }
+    }
+
+    if (wheel_env.head[WHEEL_LIST_OVERFLOW] != EASY_TIMER_INVALID_TIMER)
+    {
+        first = wheel_list_first_expiry(WHEEL_LIST_OVERFLOW);
+        if (!found || ((int32_t)(first - earliest) < 0))
+        {
+            earliest = first;
+            found = true;
+        }
+    }
+
+    *expiry = earliest;
+    return found;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Find the next tick at which a slot has to be served or cascaded.
+ * @param[in] cursor The tick that has just been processed
+ * @return The next tick to be processed
+ ****************************************************************************************
+ */
+static uint32_t wheel_next_tick(uint32_t cursor)
+{
+    uint32_t slot = wheel_first_slot(0, (cursor & (WHEEL_SLOTS - 1)) + 1);
+    uint32_t tick;
+
+    if (slot < WHEEL_SLOTS)
+    {
+        return (cursor & ~(WHEEL_SLOTS - 1)) | slot;
+    }
+
+    // Start of the next block
+    tick = (cursor | (WHEEL_SLOTS - 1)) + 1;
+
+    for (uint8_t level = 1; level < WHEEL_LEVELS; level++)
+    {
+        uint8_t shift = level * WHEEL_SLOT_BITS;
+
+        slot = (tick >> shift) & (WHEEL_SLOTS - 1);
+        if (slot == 0)
+        {
+            // Start of a block of this level, the upper level slot has to be cascaded
+            return tick;
+        }
+
+        slot = wheel_first_slot(level, slot);
+        if (slot < WHEEL_SLOTS)
+        {
+            return (tick & ~((WHEEL_SLOTS << shift) - 1)) | (slot << shift);
+        }
+
+        // Start of the next block of this level
+        tick = (tick | ((WHEEL_SLOTS << shift) - 1)) + 1;
+    }
+
+    return tick;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Bring the current tick of the wheel up to date with the BLE time.
+ * @note The BLE must be active.
+ ****************************************************************************************
+ */
+static void wheel_update_time(void)
+{
+    uint32_t ble_time = lld_evt_time_get();
+
+    if (wheel_env.synced)
+    {
+        uint32_t ticks = ((ble_time - wheel_env.ble_time) & BLE_BASETIMECNT_MASK) / WHEEL_BLE_SLOTS_PER_TICK;
+
+        wheel_env.now += ticks;
+        wheel_env.ble_time = (wheel_env.ble_time + ticks * WHEEL_BLE_SLOTS_PER_TICK) & BLE_BASETIMECNT_MASK;
+    }
+    else
+    {
+        // No timer has been started, restart the time base
+        wheel_env.now = 0;
+        wheel_env.cursor = 0;
+        wheel_env.ble_time = ble_time;
+        wheel_env.synced = true;
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Set the kernel timer to the earliest expiration tick plus the slack.
+ * @details The kernel timer is left as is if it expires earlier.
+ ****************************************************************************************
+ */
+static void wheel_arm(void)
+{
+    uint32_t expiry;
+    uint32_t delay;
+
+    if (wheel_env.processing)
+    {
+        // The kernel timer will be set when processing is done
+        return;
+    }
+
+    if (!wheel_first_expiry(&expiry))
+    {
+        return;
+    }
+
+    expiry += APP_EASY_TIMER_WHEEL_SLACK;
+    if ((int32_t)(expiry - wheel_env.now) <= 0)
+    {
+        expiry = wheel_env.now + 1;
+    }
+
+    if (wheel_env.armed && ((int32_t)(wheel_env.armed_tick - expiry) <= 0))
+    {
+        return;
+    }
+
+    delay = expiry - wheel_env.now;
+    if (delay > KE_TIMER_DELAY_MAX)
+    {
+        delay = KE_TIMER_DELAY_MAX;
+    }
+
+    KE_TIMER_SET(APP_TIMER_WHEEL_MES, TASK_APP, delay);
+    wheel_env.armed_tick = wheel_env.now + delay;
+    wheel_env.armed = true;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Release a wheel timer.
+ * @param[in] timer_id The wheel timer handler
+ ****************************************************************************************
+ */
+static void wheel_free(timer_hnd timer_id)
+{
+    wheel_timers[timer_id - 1].fn = NULL;
+    wheel_timers[timer_id - 1].next = wheel_env.free;
+    wheel_env.free = timer_id;
+
+    wheel_env.active--;
+    if (wheel_env.active == 0)
+    {
+        if (wheel_env.armed)
+        {
+            KE_TIMER_CLEAR(APP_TIMER_WHEEL_MES, TASK_APP);
+            wheel_env.armed = false;
+        }
+        // The time base is restarted by the next timer, unless the wheel is being processed
+        if (!wheel_env.processing)
+        {
+            wheel_env.synced = false;
+        }
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Call the callback of an expired wheel timer and restart it if it is periodic.
+ * @param[in] timer_id The wheel timer handler
+ ****************************************************************************************
+ */
+static void wheel_expire(timer_hnd timer_id)
+{
+    struct wheel_timer *timer = &wheel_timers[timer_id - 1];
+    timer_callback fn = timer->fn;
+    void (*return_timer_cb)(timer_hnd timer_id);
+
+    if (timer->period > 0)
+    {
+        timer->expiry += timer->period;
+        // Skip the periods that have been missed, keeping the phase of the timer
+        if ((int32_t)(timer->expiry - wheel_env.now) <= 0)
+        {
+            timer->expiry += ((wheel_env.now - timer->expiry) / timer->period + 1) * timer->period;
+        }
+        wheel_place(timer_id);
+    }
+    else
+    {
+        wheel_free(timer_id);
+    }
+
+    return_timer_cb = (void (*)(timer_hnd))fn;
+    return_timer_cb(timer_id);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Start the pending wheel timers and serve the expired ones.
+ ****************************************************************************************
+ */
+static void wheel_process(void)
+{
+    timer_hnd timer_id;
+
+    // The kernel timer has expired, or it is about to be set again
+    wheel_env.armed = false;
+
+    if (wheel_env.active == 0)
+    {
+        return;
+    }
+
+    wheel_update_time();
+
+    // Start the timers that were created while the BLE was sleeping
+    while ((timer_id = wheel_env.head[WHEEL_LIST_PENDING]) != EASY_TIMER_INVALID_TIMER)
+    {
+        wheel_list_remove(timer_id);
+        wheel_timers[timer_id - 1].expiry += wheel_env.now;
+        wheel_place(timer_id);
+    }
+
+    wheel_env.processing = true;
+
+    while ((int32_t)(wheel_env.now - wheel_env.cursor) >= 0)
+    {
+        uint32_t cursor = wheel_env.cursor;
+
+        // Entering a new block, move its timers from the upper levels (top level first)
+        for (uint8_t level = WHEEL_LEVELS; level > 0; level--)
+        {
+            uint8_t shift = level * WHEEL_SLOT_BITS;
+
+            if ((cursor & ((1UL << shift) - 1)) == 0)
+            {
+                wheel_cascade((level == WHEEL_LEVELS) ? WHEEL_LIST_OVERFLOW :
+                              level * WHEEL_SLOTS + ((cursor >> shift) & (WHEEL_SLOTS - 1)));
+            }
+        }
+
+        // The callbacks may add or cancel timers, so take them one at a time
+        while ((timer_id = wheel_env.head[cursor & (WHEEL_SLOTS - 1)]) != EASY_TIMER_INVALID_TIMER)
+        {
+            wheel_list_remove(timer_id);
+            wheel_expire(timer_id);
+        }
+
+        wheel_env.cursor = wheel_next_tick(cursor);
+        if ((int32_t)(wheel_env.cursor - wheel_env.now) > 0)
+        {
+            wheel_env.cursor = wheel_env.now + 1;
+        }
+    }
+
+    wheel_env.processing = false;
+
+    if (wheel_env.active == 0)
+    {
+        wheel_env.synced = false;
+    }
+
+    wheel_arm();
+}
+#endif // APP_EASY_TIMER_WHEEL
+
 enum process_event_response app_timer_api_process_handler(ke_msg_id_t const msgid,
                                                           void const *param,
                                                           ke_task_id_t const dest_id,
@@ -359,6 +895,13 @@ enum process_event_response app_timer_api_process_handler(ke_msg_id_t const msgi
             *msg_ret = (enum ke_msg_status_tag)create_timer_handler(msgid, param, dest_id, src_id);
             return PR_EVENT_HANDLED;
 
+#if (APP_EASY_TIMER_WHEEL)
+        case APP_TIMER_WHEEL_MES:
+            wheel_process();
+            *msg_ret = KE_MSG_CONSUMED;
+            return PR_EVENT_HANDLED;
+#endif
+
         default:
             if ((msgid < APP_TIMER_API_MES0) || (msgid > APP_TIMER_API_LAST_MES))
             {
@@ -483,6 +1026,86 @@ void app_easy_timer_cancel_all(void)
     }
 }
 
+#if (APP_EASY_TIMER_WHEEL)
+timer_hnd app_easy_wheel_timer(const uint32_t delay, const uint32_t period, timer_callback fn)
+{
+    timer_hnd timer_id;
+    struct wheel_timer *timer;
+
+    // Sanity checks
+    ASSERT_ERROR(delay > 0);                   // Delay should not be zero
+    ASSERT_ERROR(delay <= KE_TIMER_DELAY_MAX);  // Delay should not be more than maximum allowed
+    ASSERT_ERROR(period <= KE_TIMER_DELAY_MAX); // Period should not be more than maximum allowed
+    // A period within the slack would be served late by a whole period, which is skipped
+    ASSERT_WARNING((period == 0) || (period > APP_EASY_TIMER_WHEEL_SLACK));
+    ASSERT_ERROR(fn != NULL);
+
+    if (wheel_env.free != EASY_TIMER_INVALID_TIMER)
+    {
+        timer_id = wheel_env.free;
+        wheel_env.free = wheel_timers[timer_id - 1].next;
+    }
+    else if (wheel_env.used < APP_EASY_TIMER_WHEEL_NUM)
+    {
+        timer_id = ++wheel_env.used;
+    }
+    else
+    {
+        return EASY_TIMER_INVALID_TIMER; //No timers available
+    }
+
+    timer = &wheel_timers[timer_id - 1];
+    timer->fn = fn;
+    timer->period = period;
+    wheel_env.active++;
+
+    if (app_check_BLE_active())
+    {
+        wheel_update_time();
+        timer->expiry = wheel_env.now + delay;
+        wheel_place(timer_id);
+        wheel_arm();
+    }
+    else
+    {
+        // The BLE time cannot be read, start the timer when the BLE has woken up
+        timer->expiry = delay;
+        if (wheel_env.head[WHEEL_LIST_PENDING] == EASY_TIMER_INVALID_TIMER)
+        {
+            arch_ble_force_wakeup(); //wake_up BLE
+            KE_MSG_SEND_BASIC(APP_TIMER_WHEEL_MES, TASK_APP, TASK_APP);
+        }
+        wheel_list_add(WHEEL_LIST_PENDING, timer_id);
+    }
+
+    return timer_id;
+}
+
+void app_easy_wheel_timer_cancel(const timer_hnd timer_id)
+{
+    if (WHEEL_HND_IS_VALID(timer_id) && (wheel_timers[timer_id - 1].fn != NULL))
+    {
+        wheel_list_remove(timer_id);
+        wheel_free(timer_id);
+    }
+    else
+    {
+        ASSERT_WARNING(0);
+    }
+}
+
+void app_easy_wheel_timer_cancel_all(void)
+{
+    for (timer_hnd timer_id = 1; timer_id <= wheel_env.used; timer_id++)
+    {
+        if (wheel_timers[timer_id - 1].fn != NULL)
+        {
+            app_easy_wheel_timer_cancel(timer_id);
+        }
+    }
+}
+#endif // APP_EASY_TIMER_WHEEL
+
 #endif // (BLE_APP_PRESENT)
 
 /// @} APP
@@ -36,6 +36,7 @@
  ****************************************************************************************
  */
 
+#include <string.h>
 #include "rwip_config.h"
 #include "app_api.h"
 #include "user_callback_config.h"
@@ -228,11 +229,200 @@ const struct app_entry_catch_rest catch_rest = {
 
 #if !defined (__DA14531__) || defined (__EXCLUDE_ROM_APP_TASK__)
 
+/// Number of process handlers
+#define APP_PROCESS_HANDLERS_NUM        (sizeof(app_process_handlers) / sizeof(process_event_func_t))
+
+#if (APP_ENTRY_DISPATCH_INDEX_SIZE > 0)
+/*
+ * Whether a process handler handles a message depends only on the message Id, so the
+ * process handler of every message Id is known from the message handler tables.
+ * app_entry_point_init() gets the table of each process handler through
+ * app_std_process_event() and builds an index of the message Ids, sorted by Id, which
+ * app_entry_point_handler() looks up with a binary search. APP_PROCESS_HANDLERS_NUM as
+ * handler index stands for the catch rest callback.
+ */
+struct app_dispatch_index_entry
+{
+    /// Message Id
+    ke_msg_id_t msgid;
+    /// Index of the first process handler that handles the message Id
+    uint8_t handler;
+};
+
+/// Message Id range of a process handler that does not use a message handler table
+struct app_dispatch_range
+{
+    /// Process handler
+    process_event_func_t handler;
+    /// First message Id
+    ke_msg_id_t first;
+    /// Last message Id
+    ke_msg_id_t last;
+};
+
+static const struct app_dispatch_range app_dispatch_ranges[] = {
+
+#if (!EXCLUDE_DLG_TIMER)
+    {(process_event_func_t) app_timer_api_process_handler, APP_CREATE_TIMER, APP_TIMER_API_LAST_MES},
+#if (APP_EASY_TIMER_WHEEL)
+    {(process_event_func_t) app_timer_api_process_handler, APP_TIMER_WHEEL_MES, APP_TIMER_WHEEL_MES},
+#endif
+#endif
+
+#if (!EXCLUDE_DLG_MSG)
+    {(process_event_func_t) app_msg_utils_api_process_handler, APP_MSG_UTIL_API_MES0, APP_MSG_UTIL_API_LAST_MES},
+#endif
+
+    {NULL, 0, 0},
+};
+
+static struct app_dispatch_index_entry app_dispatch_index[APP_ENTRY_DISPATCH_INDEX_SIZE] __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+
+/// Number of message Ids in the index
+static uint8_t app_dispatch_index_num __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+
+/// First process handler with a KE_MSG_DEFAULT_HANDLER entry. It handles the message Ids
+/// that are not in the index.
+static uint8_t app_dispatch_default __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+
+/// The index could not be built: the process handlers are tried in turn
+static bool app_dispatch_no_index __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+
+/// Message handler table reported by the process handler under probe (num < 0: none)
+static const struct ke_msg_handler *app_dispatch_probe_handlers;
+static int app_dispatch_probe_handler_num;
+
+/**
+ ****************************************************************************************
+ * @brief Add a message Id to the dispatch index, unless an earlier process handler
+ *        already handles it.
+ * @param[in] msgid         Message Id
+ * @param[in] handler       Index of the process handler
+ * @return False if the index is full
+ ****************************************************************************************
+ */
+static bool app_dispatch_index_add(ke_msg_id_t const msgid, uint8_t handler)
+{
+    int pos = app_dispatch_index_num;
+
+    while ((pos > 0) && (app_dispatch_index[pos - 1].msgid >= msgid))
+    {
+        if (app_dispatch_index[pos - 1].msgid == msgid)
+        {
+            return true;
+        }
+        pos--;
+    }
+
+    if (app_dispatch_index_num == APP_ENTRY_DISPATCH_INDEX_SIZE)
+    {
+        return false;
+    }
+
+    memmove(&app_dispatch_index[pos + 1], &app_dispatch_index[pos],
+            (app_dispatch_index_num - pos) * sizeof(struct app_dispatch_index_entry));
+    app_dispatch_index[pos].msgid = msgid;
+    app_dispatch_index[pos].handler = handler;
+    app_dispatch_index_num++;
+
+    return true;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Find the process handler of a message Id in the dispatch index.
+ * @param[in] msgid         Message Id
+ * @return Index of the process handler, APP_PROCESS_HANDLERS_NUM for the catch rest callback
+ ****************************************************************************************
+ */
+__STATIC_INLINE uint8_t app_dispatch_index_search(ke_msg_id_t const msgid)
+{
+    int low = 0;
+    int high = app_dispatch_index_num - 1;
+
+    while (low <= high)
+    {
+        int mid = (low + high) >> 1;
+
+        if (app_dispatch_index[mid].msgid == msgid)
+        {
+            return app_dispatch_index[mid].handler;
+        }
+        else if (app_dispatch_index[mid].msgid < msgid)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid - 1;
+        }
+    }
+
+    return app_dispatch_default;
+}
+#endif
+
 /*
  * FUNCTION DEFINITIONS
  ****************************************************************************************
  */
 
+void app_entry_point_init(void)
+{
+#if (APP_ENTRY_DISPATCH_INDEX_SIZE > 0)
+    const struct app_dispatch_range *range;
+    bool indexed;
+    bool full = false;
+
+    app_dispatch_index_num = 0;
+    app_dispatch_default = APP_PROCESS_HANDLERS_NUM;
+
+    for (uint8_t i = 0; (i < APP_PROCESS_HANDLERS_NUM) && (app_dispatch_default == APP_PROCESS_HANDLERS_NUM); i++)
+    {
+        ASSERT_ERROR(app_process_handlers[i]);
+
+        // Probe the process handler for its message handler table
+        app_dispatch_probe_handler_num = -1;
+        app_process_handlers[i](KE_MSG_DEFAULT_HANDLER, NULL, TASK_APP, TASK_APP, NULL);
+
+        indexed = (app_dispatch_probe_handler_num >= 0);
+        for (int j = 0; j < app_dispatch_probe_handler_num; j++)
+        {
+            if (app_dispatch_probe_handlers[j].id == KE_MSG_DEFAULT_HANDLER)
+            {
+                app_dispatch_default = i;
+            }
+            else if (!app_dispatch_index_add(app_dispatch_probe_handlers[j].id, i))
+            {
+                full = true;
+            }
+        }
+
+        for (range = app_dispatch_ranges; range->handler != NULL; range++)
+        {
+            if (range->handler == app_process_handlers[i])
+            {
+                indexed = true;
+                for (uint32_t id = range->first; id <= range->last; id++)
+                {
+                    if (!app_dispatch_index_add(id, i))
+                    {
+                        full = true;
+                    }
+                }
+            }
+        }
+
+        // A process handler whose messages are unknown cannot be indexed
+        full |= !indexed;
+    }
+
+    // Increase CFG_APP_ENTRY_DISPATCH_INDEX_SIZE
+    ASSERT_ERROR(!full);
+    app_dispatch_no_index = full;
+#endif
+}
+
 int app_entry_point_handler(ke_msg_id_t const msgid,
                             void const *param,
                             ke_task_id_t const dest_id,
@@ -241,7 +431,24 @@ int app_entry_point_handler(ke_msg_id_t const msgid,
     int i = 0;
     enum ke_msg_status_tag process_msg_handling_result;
 
-    while (i < (sizeof(app_process_handlers) / sizeof(process_event_func_t)))
+#if (APP_ENTRY_DISPATCH_INDEX_SIZE > 0)
+    if (!app_dispatch_no_index)
+    {
+        i = app_dispatch_index_search(msgid);
+        if ((i < APP_PROCESS_HANDLERS_NUM) &&
+            (app_process_handlers[i](msgid, param, dest_id, src_id, &process_msg_handling_result) == PR_EVENT_HANDLED))
+        {
+            return (process_msg_handling_result);
+        }
+
+        //user cannot do anything else than consume the message
+        CALLBACK_ARGS_4(catch_rest.cb, msgid, param, dest_id, src_id);
+
+        return (KE_MSG_CONSUMED);
+    }
+#endif
+
+    while (i < APP_PROCESS_HANDLERS_NUM)
     {
         ASSERT_ERROR(app_process_handlers[i]);
          if (app_process_handlers[i](msgid, param, dest_id, src_id, &process_msg_handling_result) == PR_EVENT_HANDLED)
@@ -302,6 +509,17 @@ enum process_event_response app_std_process_event(ke_msg_id_t const msgid,
                                                   const int handler_num)
 {
     ke_msg_func_t func = NULL;
+
+#if (APP_ENTRY_DISPATCH_INDEX_SIZE > 0)
+    if (msg_ret == NULL)
+    {
+        // Probe of app_entry_point_init(): report the message handler table
+        app_dispatch_probe_handlers = handlers;
+        app_dispatch_probe_handler_num = handler_num;
+        return PR_EVENT_UNHANDLED;
+    }
+#endif
+
     func = handler_search(msgid, handlers, handler_num);
 
     if (func != NULL)
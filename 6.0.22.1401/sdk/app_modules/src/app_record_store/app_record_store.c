@@ -0,0 +1,1097 @@
+/**
+ *****************************************************************************************
+ *
+ * @file app_record_store.c
+ *
+ * @brief Flash-backed circular measurement record store code file.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ *****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @addtogroup APP_RECORD_STORE
+ * @{
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "app_record_store.h"
+
+#if defined (CFG_SPI_FLASH_ENABLE)
+
+#include "rwip.h"
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Sector signature
+#define RS_MAGIC                        (0x5352)
+/// Value of the commit field of a completely written record
+#define RS_COMMITTED                    (0x5A)
+/// Value of the deleted field of a live record (erased flash)
+#define RS_LIVE                         (0xFF)
+/// Value of the deleted field of a deleted record
+#define RS_DELETED                      (0x00)
+/// Erased 32-bit word
+#define RS_ERASED                       (0xFFFFFFFF)
+/// Records read with one SPI flash access when the store is loaded or records are counted
+#define RS_SCAN_BATCH                   (4)
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/// RAM index entry of a sector
+struct rs_sector_idx
+{
+    /// Time range of the records of the sector
+    uint32_t min_time;
+    uint32_t max_time;
+    /// Number of records that are not deleted
+    uint16_t live;
+    /// Number of slots used, including the ones a power failure left unreadable
+    uint16_t slots;
+};
+
+/// Position of the store in SPI flash
+struct rs_env
+{
+    /// Sequence number of the first slot of the oldest sector
+    uint32_t first_seq;
+    /// Sequence number of the next record
+    uint32_t next_seq;
+    /// sector_seq of the newest sector
+    uint32_t sector_seq;
+    /// Time of the last record appended
+    uint32_t last_time;
+    /// Number of records that are not deleted
+    uint32_t live;
+    /// Next free slot in the newest sector
+    uint16_t wr_slot;
+    /// Oldest sector
+    uint8_t tail;
+    /// Number of sectors in use
+    uint8_t used;
+    /// True while the records have been appended in time order
+    bool ordered;
+};
+
+/*
+ * LOCAL VARIABLE DEFINITIONS
+ ****************************************************************************************
+ */
+
+static struct rs_env rs __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+static struct rs_sector_idx rs_idx[APP_RECORD_STORE_SECTORS] __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+
+/*
+ * STATIC FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Wake up the SPI flash and allow writes
+ ****************************************************************************************
+ */
+static void rs_spi_flash_init(void)
+{
+    uint8_t dev_id;
+
+    // Release the SPI flash from power down
+    spi_flash_release_from_power_down();
+
+    // Try to auto-detect the SPI flash memory
+    spi_flash_auto_detect(&dev_id);
+
+    // Disable the SPI flash memory protection (unprotect all sectors)
+    spi_flash_configure_memory_protection(SPI_FLASH_MEM_PROT_NONE);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Get the sector of the ring at a given position
+ * @param[in] k             Position from the oldest sector
+ * @return Sector index
+ ****************************************************************************************
+ */
+__STATIC_INLINE uint8_t rs_ring(uint32_t k)
+{
+    return (rs.tail + k) % APP_RECORD_STORE_SECTORS;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Get the Flash offset of a sector
+ * @param[in] sector        Sector index
+ * @return Offset of the sector
+ ****************************************************************************************
+ */
+__STATIC_INLINE uint32_t rs_sector_offset(uint8_t sector)
+{
+    return APP_RECORD_STORE_DATA_OFFSET + sector * SPI_FLASH_SECTOR_SIZE;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Get the Flash offset of the slot of a record
+ * @param[in] seq           Sequence number, within the store
+ * @return Offset of the slot
+ ****************************************************************************************
+ */
+static uint32_t rs_slot_offset(uint32_t seq)
+{
+    uint32_t pos = seq - rs.first_seq;
+
+    return rs_sector_offset(rs_ring(pos / APP_RECORD_STORE_SLOTS)) +
+           sizeof(struct app_record_store_sector_hdr) +
+           (pos % APP_RECORD_STORE_SLOTS) * APP_RECORD_STORE_REC_SIZE;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Check if a slot holds a record that is not deleted
+ * @param[in] hdr           Header read from the slot
+ * @param[in] seq           Sequence number of the slot
+ * @return True if the record is valid and not deleted
+ ****************************************************************************************
+ */
+__STATIC_INLINE bool rs_is_live(const struct app_record_store_rec_hdr *hdr, uint32_t seq)
+{
+    return (hdr->commit == RS_COMMITTED) && (hdr->deleted == RS_LIVE) && (hdr->seq == seq);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Erase a Flash sector
+ * @param[in] offset        Offset of the sector
+ * @param[in] scheduler_en  True: Enable rwip_scheduler while Flash is being erased
+ *                          False: Do not enable rwip_scheduler. Blocking mode
+ * @return ret              Error code or success (ERR_OK)
+ ****************************************************************************************
+ */
+static int8_t rs_erase_sector(uint32_t offset, bool scheduler_en)
+{
+    int8_t ret;
+    uint32_t timeout_cnt;
+
+    if (scheduler_en)
+    {
+        // Non-Blocking Erase of a Flash sector
+        ret = spi_flash_block_erase_no_wait(offset, SPI_FLASH_OP_SE);
+        if (ret != SPI_FLASH_ERR_OK)
+            return ret;
+
+        timeout_cnt = 0;
+
+        while ((spi_flash_read_status_reg() & SPI_FLASH_SR_BUSY) != 0)
+        {
+            // Check if BLE is on and not in deep sleep and call rwip_schedule()
+            if ((GetBits16(CLK_RADIO_REG, BLE_ENABLE) == 1) &&
+               (GetBits32(BLE_DEEPSLCNTL_REG, DEEP_SLEEP_STAT) == 0))
+            {
+                if (++timeout_cnt > SPI_FLASH_WAIT)
+                {
+                    return SPI_FLASH_ERR_TIMEOUT;
+                }
+                rwip_schedule();
+            }
+        }
+    }
+    else
+    {
+        // Blocking Erase of a Flash sector
+        ret = spi_flash_block_erase(offset, SPI_FLASH_OP_SE);
+    }
+
+    return ret;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Start a new sector after the newest one. If all the sectors are used, the
+ *        oldest one is dropped. The sector is erased and its header is written with the
+ *        magic field last, so a sector interrupted by a power failure is not loaded.
+ * @param[in] scheduler_en  True: Enable rwip_scheduler while Flash is being erased
+ * @return Error code or success (ERR_OK)
+ ****************************************************************************************
+ */
+static int8_t rs_open_sector(bool scheduler_en)
+{
+    struct app_record_store_sector_hdr hdr;
+    uint32_t actual_size;
+    uint8_t sector;
+    int8_t ret;
+
+    if (rs.used == APP_RECORD_STORE_SECTORS)
+    {
+        // Drop the oldest sector
+        rs.live -= rs_idx[rs.tail].live;
+        rs.tail = rs_ring(1);
+        rs.first_seq += APP_RECORD_STORE_SLOTS;
+        rs.used--;
+    }
+
+    sector = rs_ring(rs.used);
+    // Sequence numbers follow the slots, also after a sector closed early
+    rs.next_seq = rs.first_seq + rs.used * APP_RECORD_STORE_SLOTS;
+
+    ret = rs_erase_sector(rs_sector_offset(sector), scheduler_en);
+    if (ret != SPI_FLASH_ERR_OK)
+        return ret;
+
+    hdr.sector_seq = rs.sector_seq + 1;
+    hdr.first_seq = rs.next_seq;
+    ret = spi_flash_write_data((uint8_t *)&hdr.sector_seq,
+                               rs_sector_offset(sector) + offsetof(struct app_record_store_sector_hdr, sector_seq),
+                               sizeof(hdr) - offsetof(struct app_record_store_sector_hdr, sector_seq),
+                               &actual_size);
+    if (ret != SPI_FLASH_ERR_OK)
+        return ret;
+
+    hdr.magic = RS_MAGIC;
+    hdr.version = APP_RECORD_STORE_VERSION;
+    ret = spi_flash_write_data((uint8_t *)&hdr, rs_sector_offset(sector),
+                               offsetof(struct app_record_store_sector_hdr, sector_seq), &actual_size);
+    if (ret != SPI_FLASH_ERR_OK)
+        return ret;
+
+    rs.sector_seq = hdr.sector_seq;
+    rs.used++;
+    rs.wr_slot = 0;
+    rs_idx[sector].min_time = RS_ERASED;
+    rs_idx[sector].max_time = 0;
+    rs_idx[sector].live = 0;
+    rs_idx[sector].slots = 0;
+
+    return SPI_FLASH_ERR_OK;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Add a record to the RAM index
+ * @param[in] sector        Sector of the record
+ * @param[in] time          Time of the record
+ ****************************************************************************************
+ */
+static void rs_index_add(uint8_t sector, uint32_t time)
+{
+    struct rs_sector_idx *idx = &rs_idx[sector];
+
+    if (time < idx->min_time)
+    {
+        idx->min_time = time;
+    }
+    if (time > idx->max_time)
+    {
+        idx->max_time = time;
+    }
+    idx->live++;
+
+    if ((rs.live != 0) && (time < rs.last_time))
+    {
+        rs.ordered = false;
+    }
+    rs.last_time = time;
+    rs.live++;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Scan the records of a sector into the RAM index
+ * @param[in] k             Position of the sector in the ring
+ * @return Number of slots written, including the ones interrupted by a power failure
+ ****************************************************************************************
+ */
+static uint16_t rs_load_sector(uint32_t k)
+{
+    struct app_record_store_rec recs[RS_SCAN_BATCH];
+    uint8_t sector = rs_ring(k);
+    uint32_t seq = rs.first_seq + k * APP_RECORD_STORE_SLOTS;
+    uint32_t offset = rs_sector_offset(sector) + sizeof(struct app_record_store_sector_hdr);
+    uint32_t actual_size;
+    uint16_t written = 0;
+
+    rs_idx[sector].min_time = RS_ERASED;
+    rs_idx[sector].max_time = 0;
+    rs_idx[sector].live = 0;
+
+    for (uint16_t slot = 0; slot < APP_RECORD_STORE_SLOTS; slot += RS_SCAN_BATCH)
+    {
+        uint16_t n = APP_RECORD_STORE_SLOTS - slot;
+
+        if (n > RS_SCAN_BATCH)
+        {
+            n = RS_SCAN_BATCH;
+        }
+        spi_flash_read_data((uint8_t *)recs, offset + slot * APP_RECORD_STORE_REC_SIZE,
+                            n * APP_RECORD_STORE_REC_SIZE, &actual_size);
+
+        for (uint16_t i = 0; i < n; i++)
+        {
+            const struct app_record_store_rec_hdr *hdr = &recs[i].hdr;
+
+            if ((hdr->seq != RS_ERASED) || (hdr->time != RS_ERASED) || (hdr->len != 0xFF) ||
+                (hdr->commit != 0xFF))
+            {
+                written = slot + i + 1;
+            }
+            if (rs_is_live(hdr, seq + slot + i))
+            {
+                rs_index_add(sector, hdr->time);
+            }
+        }
+    }
+
+    rs_idx[sector].slots = written;
+
+    return written;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Check that a slot is fully erased
+ * @param[in] offset        Offset of the slot
+ * @return True if all the bytes of the slot are erased
+ ****************************************************************************************
+ */
+static bool rs_slot_erased(uint32_t offset)
+{
+    struct app_record_store_rec rec;
+    const uint8_t *p = (const uint8_t *)&rec;
+    uint32_t actual_size;
+
+    spi_flash_read_data((uint8_t *)&rec, offset, sizeof(rec), &actual_size);
+    for (uint32_t i = 0; i < sizeof(rec); i++)
+    {
+        if (p[i] != 0xFF)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Find a record of one sector by time, with a binary search over its slots.
+ *        Requires the records to be in time order.
+ * @param[in] k             Position of the sector in the ring
+ * @param[in] time          Time to search
+ * @param[in] strict        False: first record with time >= time
+ *                          True: first record with time > time
+ * @return Sequence number of the record, or of the first slot of the next sector
+ ****************************************************************************************
+ */
+static uint32_t rs_sector_time_bound(uint32_t k, uint32_t time, bool strict)
+{
+    struct app_record_store_rec_hdr hdr;
+    uint32_t first = rs.first_seq + k * APP_RECORD_STORE_SLOTS;
+    uint32_t offset = rs_sector_offset(rs_ring(k)) + sizeof(struct app_record_store_sector_hdr);
+    uint32_t actual_size;
+    uint16_t lo = 0;
+    uint16_t hi = APP_RECORD_STORE_SLOTS;
+
+    while (lo < hi)
+    {
+        uint16_t mid = (lo + hi) / 2;
+        uint16_t m = mid;
+
+        // Deleted and unwritten slots carry no time: probe the next record instead
+        for (;;)
+        {
+            spi_flash_read_data((uint8_t *)&hdr, offset + m * APP_RECORD_STORE_REC_SIZE,
+                                sizeof(hdr), &actual_size);
+            if (rs_is_live(&hdr, first + m) || (++m == hi))
+            {
+                break;
+            }
+        }
+
+        if (m == hi)
+        {
+            hi = mid;
+        }
+        else if (strict ? (hdr.time > time) : (hdr.time >= time))
+        {
+            hi = m;
+        }
+        else
+        {
+            lo = m + 1;
+        }
+    }
+
+    return first + lo;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Find a record by time, with a binary search over the sectors in the RAM index
+ *        followed by a binary search over the slots of one sector. Requires the records
+ *        to be in time order.
+ * @param[in] time          Time to search
+ * @param[in] strict        False: first record with time >= time
+ *                          True: first record with time > time
+ * @return Sequence number of the record, rs.next_seq if there is none
+ ****************************************************************************************
+ */
+static uint32_t rs_time_bound(uint32_t time, bool strict)
+{
+    uint32_t lo = 0;
+    uint32_t hi = rs.used;
+
+    while (lo < hi)
+    {
+        uint32_t mid = (lo + hi) / 2;
+        uint32_t m = mid;
+
+        // Sectors without records carry no time: probe the next sector instead
+        while ((m < hi) && (rs_idx[rs_ring(m)].live == 0))
+        {
+            m++;
+        }
+
+        if (m == hi)
+        {
+            hi = mid;
+        }
+        else if (strict ? (rs_idx[rs_ring(m)].max_time > time) :
+                          (rs_idx[rs_ring(m)].max_time >= time))
+        {
+            hi = m;
+        }
+        else
+        {
+            lo = m + 1;
+        }
+    }
+
+    if (lo == rs.used)
+    {
+        return rs.next_seq;
+    }
+
+    return rs_sector_time_bound(lo, time, strict);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Find the first or the last record of a sequence number range
+ * @param[in] from          First sequence number of the range
+ * @param[in] to            Last sequence number of the range
+ * @param[in] last          True: search the last record, False: the first one
+ * @param[out] seq          Sequence number of the record
+ * @return True if a record was found
+ ****************************************************************************************
+ */
+static bool rs_find_end(uint32_t from, uint32_t to, bool last, uint32_t *seq)
+{
+    struct app_record_store_rec_hdr hdr;
+    uint32_t actual_size;
+    uint32_t s = last ? to : from;
+
+    while ((s >= from) && (s <= to))
+    {
+        uint32_t k = (s - rs.first_seq) / APP_RECORD_STORE_SLOTS;
+
+        if (rs_idx[rs_ring(k)].live == 0)
+        {
+            // Skip the whole sector
+            s = last ? rs.first_seq + k * APP_RECORD_STORE_SLOTS - 1 :
+                       rs.first_seq + (k + 1) * APP_RECORD_STORE_SLOTS;
+            continue;
+        }
+
+        spi_flash_read_data((uint8_t *)&hdr, rs_slot_offset(s), sizeof(hdr), &actual_size);
+        if (rs_is_live(&hdr, s))
+        {
+            *seq = s;
+            return true;
+        }
+        s = last ? s - 1 : s + 1;
+    }
+
+    return false;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Mark a record as deleted
+ * @param[in] seq           Sequence number of the record
+ * @return Error code or success (ERR_OK)
+ ****************************************************************************************
+ */
+static int8_t rs_mark_deleted(uint32_t seq)
+{
+    uint8_t deleted = RS_DELETED;
+    uint32_t actual_size;
+    int8_t ret;
+
+    ret = spi_flash_write_data(&deleted, rs_slot_offset(seq) + offsetof(struct app_record_store_rec_hdr, deleted),
+                               sizeof(deleted), &actual_size);
+    if (ret == SPI_FLASH_ERR_OK)
+    {
+        rs_idx[rs_ring((seq - rs.first_seq) / APP_RECORD_STORE_SLOTS)].live--;
+        rs.live--;
+    }
+
+    return ret;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Drop the oldest sector. Its magic field is cleared, so it is not loaded again.
+ * @return Error code or success (ERR_OK)
+ ****************************************************************************************
+ */
+static int8_t rs_drop_tail(void)
+{
+    uint16_t magic = 0;
+    uint32_t actual_size;
+    int8_t ret;
+
+    ret = spi_flash_write_data((uint8_t *)&magic, rs_sector_offset(rs.tail), sizeof(magic),
+                               &actual_size);
+    if (ret != SPI_FLASH_ERR_OK)
+        return ret;
+
+    rs.live -= rs_idx[rs.tail].live;
+    rs_idx[rs.tail].live = 0;
+    rs.tail = rs_ring(1);
+    rs.first_seq += APP_RECORD_STORE_SLOTS;
+    rs.used--;
+
+    if (rs.used == 0)
+    {
+        // Keep the sequence numbers increasing
+        rs.next_seq = rs.first_seq;
+    }
+
+    return SPI_FLASH_ERR_OK;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Clip a cursor to the records of the store
+ * @param[in,out] cursor    Selection
+ * @return True if the selection is not empty
+ ****************************************************************************************
+ */
+static bool rs_clip(struct app_record_store_cursor *cursor)
+{
+    if (cursor->seq < rs.first_seq)
+    {
+        cursor->seq = rs.first_seq;
+    }
+    if (cursor->last_seq >= rs.next_seq)
+    {
+        cursor->last_seq = rs.next_seq - 1;
+    }
+
+    return (rs.live != 0) && (cursor->seq <= cursor->last_seq);
+}
+
+/*
+ * GLOBAL FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+uint8_t app_record_store_init(void)
+{
+    struct app_record_store_sector_hdr hdr;
+    struct app_record_store_sector_hdr newest;
+    uint32_t actual_size;
+    uint8_t head = 0;
+    bool found = false;
+    uint16_t written = 0;
+
+    rs_spi_flash_init();
+
+    memset(&rs, 0, sizeof(rs));
+    memset(rs_idx, 0, sizeof(rs_idx));
+    rs.ordered = true;
+    memset(&newest, 0, sizeof(newest));
+
+    // The newest sector has the highest sector_seq
+    for (uint8_t i = 0; i < APP_RECORD_STORE_SECTORS; i++)
+    {
+        spi_flash_read_data((uint8_t *)&hdr, rs_sector_offset(i), sizeof(hdr), &actual_size);
+        if ((hdr.magic == RS_MAGIC) && (hdr.version == APP_RECORD_STORE_VERSION) &&
+            (!found || (hdr.sector_seq > newest.sector_seq)))
+        {
+            found = true;
+            newest = hdr;
+            head = i;
+        }
+    }
+
+    if (found)
+    {
+        // Walk back through the ring while the sectors follow each other
+        rs.used = 1;
+        while (rs.used < APP_RECORD_STORE_SECTORS)
+        {
+            uint8_t prev = (head + APP_RECORD_STORE_SECTORS - rs.used) % APP_RECORD_STORE_SECTORS;
+
+            spi_flash_read_data((uint8_t *)&hdr, rs_sector_offset(prev), sizeof(hdr), &actual_size);
+            if ((hdr.magic != RS_MAGIC) || (hdr.version != APP_RECORD_STORE_VERSION) ||
+                (hdr.sector_seq != newest.sector_seq - rs.used) ||
+                (hdr.first_seq != newest.first_seq - rs.used * APP_RECORD_STORE_SLOTS))
+            {
+                break;
+            }
+            rs.used++;
+        }
+
+        rs.tail = (head + APP_RECORD_STORE_SECTORS + 1 - rs.used) % APP_RECORD_STORE_SECTORS;
+        rs.first_seq = newest.first_seq - (rs.used - 1) * APP_RECORD_STORE_SLOTS;
+        rs.sector_seq = newest.sector_seq;
+
+        for (uint32_t k = 0; k < rs.used; k++)
+        {
+            written = rs_load_sector(k);
+        }
+
+        // Skip a slot that a power failure left partly programmed
+        rs.wr_slot = written;
+        if ((rs.wr_slot < APP_RECORD_STORE_SLOTS) &&
+            !rs_slot_erased(rs_sector_offset(head) + sizeof(struct app_record_store_sector_hdr) +
+                            rs.wr_slot * APP_RECORD_STORE_REC_SIZE))
+        {
+            rs.wr_slot++;
+        }
+        rs_idx[head].slots = rs.wr_slot;
+        rs.next_seq = newest.first_seq + rs.wr_slot;
+    }
+
+    // Power down flash
+    spi_flash_power_down();
+
+    return APP_RECORD_STORE_OK;
+}
+
+uint8_t app_record_store_append(uint32_t time, const void *data, uint8_t len,
+                                bool scheduler_en, uint32_t *seq)
+{
+    struct app_record_store_rec rec;
+    uint8_t commit = RS_COMMITTED;
+    uint32_t actual_size;
+    uint32_t offset;
+    int8_t ret = SPI_FLASH_ERR_OK;
+
+    if ((len > APP_RECORD_STORE_PAYLOAD_SIZE) || ((data == NULL) && (len != 0)))
+    {
+        return APP_RECORD_STORE_ERR_INVALID_PARAM;
+    }
+
+    rs_spi_flash_init();
+
+    if ((rs.used == 0) || (rs.wr_slot >= APP_RECORD_STORE_SLOTS))
+    {
+        ret = rs_open_sector(scheduler_en);
+    }
+
+    if (ret == SPI_FLASH_ERR_OK)
+    {
+        memset(&rec, 0xFF, sizeof(rec));
+        rec.hdr.seq = rs.next_seq;
+        rec.hdr.time = time;
+        rec.hdr.len = len;
+        memcpy(rec.data, data, len);
+
+        offset = rs_slot_offset(rec.hdr.seq);
+        ret = spi_flash_write_data((uint8_t *)&rec, offset, sizeof(rec), &actual_size);
+        if (ret == SPI_FLASH_ERR_OK)
+        {
+            ret = spi_flash_write_data(&commit, offset + offsetof(struct app_record_store_rec_hdr, commit),
+                                       sizeof(commit), &actual_size);
+        }
+
+        if (ret == SPI_FLASH_ERR_OK)
+        {
+            rs_index_add(rs_ring(rs.used - 1), time);
+            rs.wr_slot++;
+            rs_idx[rs_ring(rs.used - 1)].slots = rs.wr_slot;
+            rs.next_seq++;
+            if (seq != NULL)
+            {
+                *seq = rec.hdr.seq;
+            }
+        }
+        else
+        {
+            // Leave the damaged sector behind on the next append
+            rs.wr_slot = APP_RECORD_STORE_SLOTS;
+            rs_idx[rs_ring(rs.used - 1)].slots = APP_RECORD_STORE_SLOTS;
+        }
+    }
+
+    // Power down flash
+    spi_flash_power_down();
+
+    return (ret == SPI_FLASH_ERR_OK) ? APP_RECORD_STORE_OK : APP_RECORD_STORE_ERR_FLASH;
+}
+
+uint8_t app_record_store_select_seq(struct app_record_store_cursor *cursor, uint8_t op,
+                                    uint32_t min, uint32_t max)
+{
+    uint32_t seq;
+    bool found;
+
+    cursor->seq = rs.first_seq;
+    cursor->last_seq = rs.next_seq - 1;
+    cursor->time_filter = false;
+
+    switch (op)
+    {
+        case APP_RECORD_STORE_OP_ALL:
+            break;
+        case APP_RECORD_STORE_OP_LT_OR_EQ:
+            if (max < cursor->last_seq)
+            {
+                cursor->last_seq = max;
+            }
+            break;
+        case APP_RECORD_STORE_OP_GT_OR_EQ:
+            if (min > cursor->seq)
+            {
+                cursor->seq = min;
+            }
+            break;
+        case APP_RECORD_STORE_OP_WITHIN_RANGE:
+            if (min > max)
+            {
+                return APP_RECORD_STORE_ERR_INVALID_PARAM;
+            }
+            if (min > cursor->seq)
+            {
+                cursor->seq = min;
+            }
+            if (max < cursor->last_seq)
+            {
+                cursor->last_seq = max;
+            }
+            break;
+        case APP_RECORD_STORE_OP_FIRST:
+        case APP_RECORD_STORE_OP_LAST:
+            if (!rs_clip(cursor))
+            {
+                return APP_RECORD_STORE_ERR_NOT_FOUND;
+            }
+            rs_spi_flash_init();
+            found = rs_find_end(cursor->seq, cursor->last_seq, op == APP_RECORD_STORE_OP_LAST, &seq);
+            spi_flash_power_down();
+            if (!found)
+            {
+                return APP_RECORD_STORE_ERR_NOT_FOUND;
+            }
+            cursor->seq = seq;
+            cursor->last_seq = seq;
+            break;
+        default:
+            return APP_RECORD_STORE_ERR_INVALID_PARAM;
+    }
+
+    return rs_clip(cursor) ? APP_RECORD_STORE_OK : APP_RECORD_STORE_ERR_NOT_FOUND;
+}
+
+uint8_t app_record_store_select_time(struct app_record_store_cursor *cursor, uint8_t op,
+                                     uint32_t min, uint32_t max)
+{
+    uint8_t status;
+
+    switch (op)
+    {
+        case APP_RECORD_STORE_OP_LT_OR_EQ:
+            min = 0;
+            break;
+        case APP_RECORD_STORE_OP_GT_OR_EQ:
+            max = RS_ERASED;
+            break;
+        case APP_RECORD_STORE_OP_WITHIN_RANGE:
+            if (min > max)
+            {
+                return APP_RECORD_STORE_ERR_INVALID_PARAM;
+            }
+            break;
+        default:
+            // Not time based
+            return app_record_store_select_seq(cursor, op, 0, 0);
+    }
+
+    status = app_record_store_select_seq(cursor, APP_RECORD_STORE_OP_ALL, 0, 0);
+    if (status != APP_RECORD_STORE_OK)
+    {
+        return status;
+    }
+
+    cursor->time_min = min;
+    cursor->time_max = max;
+
+    if (rs.ordered)
+    {
+        rs_spi_flash_init();
+        cursor->seq = rs_time_bound(min, false);
+        cursor->last_seq = (max == RS_ERASED) ? rs.next_seq - 1 : rs_time_bound(max, true) - 1;
+        spi_flash_power_down();
+        cursor->time_filter = false;
+    }
+    else
+    {
+        // Limit the selection to the sectors whose time range overlaps, and check the
+        // time of every record while reading
+        uint32_t k_first = rs.used;
+        uint32_t k_last = 0;
+
+        for (uint32_t k = 0; k < rs.used; k++)
+        {
+            const struct rs_sector_idx *idx = &rs_idx[rs_ring(k)];
+
+            if ((idx->live != 0) && (idx->min_time <= max) && (idx->max_time >= min))
+            {
+                if (k_first == rs.used)
+                {
+                    k_first = k;
+                }
+                k_last = k;
+            }
+        }
+
+        if (k_first == rs.used)
+        {
+            return APP_RECORD_STORE_ERR_NOT_FOUND;
+        }
+
+        cursor->seq = rs.first_seq + k_first * APP_RECORD_STORE_SLOTS;
+        cursor->last_seq = rs.first_seq + (k_last + 1) * APP_RECORD_STORE_SLOTS - 1;
+        cursor->time_filter = true;
+    }
+
+    return rs_clip(cursor) ? APP_RECORD_STORE_OK : APP_RECORD_STORE_ERR_NOT_FOUND;
+}
+
+uint16_t app_record_store_read(struct app_record_store_cursor *cursor,
+                               struct app_record_store_rec *recs, uint16_t max_recs)
+{
+    uint32_t actual_size;
+    uint16_t n = 0;
+
+    if (!rs_clip(cursor))
+    {
+        return 0;
+    }
+
+    rs_spi_flash_init();
+
+    while ((n < max_recs) && (cursor->seq <= cursor->last_seq))
+    {
+        uint32_t pos = cursor->seq - rs.first_seq;
+        uint32_t k = pos / APP_RECORD_STORE_SLOTS;
+        uint32_t chunk = APP_RECORD_STORE_SLOTS - pos % APP_RECORD_STORE_SLOTS;
+
+        if (rs_idx[rs_ring(k)].live == 0)
+        {
+            // Skip the whole sector
+            cursor->seq += chunk;
+            continue;
+        }
+
+        if (chunk > (uint32_t)(max_recs - n))
+        {
+            chunk = max_recs - n;
+        }
+        if (chunk > cursor->last_seq - cursor->seq + 1)
+        {
+            chunk = cursor->last_seq - cursor->seq + 1;
+        }
+
+        // Consecutive slots of one sector in one access, then keep the matching records
+        spi_flash_read_data((uint8_t *)&recs[n], rs_slot_offset(cursor->seq),
+                            chunk * APP_RECORD_STORE_REC_SIZE, &actual_size);
+
+        for (uint32_t i = 0, base = n; i < chunk; i++)
+        {
+            const struct app_record_store_rec_hdr *hdr = &recs[base + i].hdr;
+
+            if (rs_is_live(hdr, cursor->seq + i) &&
+                (!cursor->time_filter ||
+                 ((hdr->time >= cursor->time_min) && (hdr->time <= cursor->time_max))))
+            {
+                if (base + i != n)
+                {
+                    memcpy(&recs[n], &recs[base + i], sizeof(struct app_record_store_rec));
+                }
+                n++;
+            }
+        }
+        cursor->seq += chunk;
+    }
+
+    // Power down flash
+    spi_flash_power_down();
+
+    return n;
+}
+
+uint32_t app_record_store_count(const struct app_record_store_cursor *cursor)
+{
+    struct app_record_store_cursor c = *cursor;
+    struct app_record_store_rec recs[RS_SCAN_BATCH];
+    uint32_t count = 0;
+
+    if (!rs_clip(&c))
+    {
+        return 0;
+    }
+
+    while (c.seq <= c.last_seq)
+    {
+        uint32_t k = (c.seq - rs.first_seq) / APP_RECORD_STORE_SLOTS;
+        uint32_t first = rs.first_seq + k * APP_RECORD_STORE_SLOTS;
+        uint32_t last = first + APP_RECORD_STORE_SLOTS - 1;
+        const struct rs_sector_idx *idx = &rs_idx[rs_ring(k)];
+        struct app_record_store_cursor part = c;
+        uint16_t n;
+
+        if (last >= rs.next_seq)
+        {
+            last = rs.next_seq - 1;
+        }
+
+        if (!c.time_filter && (c.seq == first) && (c.last_seq >= last))
+        {
+            // Fully selected sector, counted from the RAM index
+            count += idx->live;
+        }
+        else if (!c.time_filter && (idx->live == idx->slots))
+        {
+            // No deleted record and no gap, all the selected slots that are used count
+            uint32_t end = (c.last_seq < last) ? c.last_seq : last;
+
+            if (end >= first + idx->slots)
+            {
+                end = first + idx->slots - 1;
+            }
+            if (end + 1 > c.seq)
+            {
+                count += end + 1 - c.seq;
+            }
+        }
+        else if (idx->live != 0)
+        {
+            if (part.last_seq > last)
+            {
+                part.last_seq = last;
+            }
+            while ((n = app_record_store_read(&part, recs, RS_SCAN_BATCH)) != 0)
+            {
+                count += n;
+            }
+        }
+
+        if (last >= c.last_seq)
+        {
+            break;
+        }
+        c.seq = last + 1;
+    }
+
+    return count;
+}
+
+uint8_t app_record_store_delete(const struct app_record_store_cursor *cursor)
+{
+    struct app_record_store_cursor c = *cursor;
+    struct app_record_store_rec recs[RS_SCAN_BATCH];
+    int8_t ret = SPI_FLASH_ERR_OK;
+    uint16_t n;
+
+    if (!rs_clip(&c))
+    {
+        return APP_RECORD_STORE_ERR_NOT_FOUND;
+    }
+
+    rs_spi_flash_init();
+
+    // Oldest sectors that are fully selected are released
+    while (!c.time_filter && (rs.used != 0) && (c.seq == rs.first_seq))
+    {
+        uint32_t last = rs.first_seq + APP_RECORD_STORE_SLOTS - 1;
+
+        if (last >= rs.next_seq)
+        {
+            last = rs.next_seq - 1;
+        }
+        if (c.last_seq < last)
+        {
+            break;
+        }
+
+        ret = rs_drop_tail();
+        if ((ret != SPI_FLASH_ERR_OK) || (c.last_seq == last))
+        {
+            break;
+        }
+        c.seq = rs.first_seq;
+    }
+
+    // Records of the other sectors are marked as deleted
+    while ((ret == SPI_FLASH_ERR_OK) && (rs.used != 0) && rs_clip(&c) &&
+           ((n = app_record_store_read(&c, recs, RS_SCAN_BATCH)) != 0))
+    {
+        rs_spi_flash_init();
+        for (uint16_t i = 0; (i < n) && (ret == SPI_FLASH_ERR_OK); i++)
+        {
+            ret = rs_mark_deleted(recs[i].hdr.seq);
+        }
+    }
+
+    // Power down flash
+    spi_flash_power_down();
+
+    return (ret == SPI_FLASH_ERR_OK) ? APP_RECORD_STORE_OK : APP_RECORD_STORE_ERR_FLASH;
+}
+
+uint32_t app_record_store_get_count(void)
+{
+    return rs.live;
+}
+
+#endif // CFG_SPI_FLASH_ENABLE
+
+/// @} APP_RECORD_STORE
@@ -0,0 +1,301 @@
+/**
+ *****************************************************************************************
+ *
+ * @file record_handling.c
+ *
+ * @brief Record Access Control Point request handling code file.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ *****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @addtogroup RECORD_HANDLING
+ * @{
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stddef.h>
+#include "record_handling.h"
+
+#if defined (CFG_SPI_FLASH_ENABLE)
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/// Report in progress
+struct record_handling_report
+{
+    /// Records not read yet
+    struct app_record_store_cursor cursor;
+    /// Records read with the last SPI flash access
+    struct app_record_store_rec batch[RECORD_HANDLING_BATCH];
+    /// Number of records in batch
+    uint16_t count;
+    /// Next record of batch
+    uint16_t next;
+    /// True while a report is in progress
+    bool active;
+};
+
+/*
+ * LOCAL VARIABLE DEFINITIONS
+ ****************************************************************************************
+ */
+
+static struct record_handling_report report __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+
+/*
+ * STATIC FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Map a RACP operator to a record store operator.
+ * @param[in] op            RACP operator (common to Glucose and CGM)
+ * @return Record store operator, 0xFF if the operator is invalid
+ ****************************************************************************************
+ */
+static uint8_t rh_store_op(uint8_t op)
+{
+    // RACP operators 1 to 6 are in the order of enum app_record_store_op
+    if ((op == 0) || (op > APP_RECORD_STORE_OP_LAST + 1))
+    {
+        return 0xFF;
+    }
+
+    return op - 1;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Check if a record store operator takes a filter.
+ * @param[in] op            Record store operator
+ * @return True if the operator takes a filter
+ ****************************************************************************************
+ */
+__STATIC_INLINE bool rh_op_filtered(uint8_t op)
+{
+    return (op >= APP_RECORD_STORE_OP_LT_OR_EQ) && (op <= APP_RECORD_STORE_OP_WITHIN_RANGE);
+}
+
+#if (BLE_GL_SENSOR)
+/**
+ ****************************************************************************************
+ * @brief Get the sequence number in the store of the most recent record with the given
+ *        16-bit sequence number.
+ * @param[in] seq16         16-bit sequence number
+ * @param[in] last          Sequence number of the most recent record
+ * @return Sequence number in the store
+ ****************************************************************************************
+ */
+static uint32_t rh_seq_from_16(uint16_t seq16, uint32_t last)
+{
+    uint32_t seq = (last & 0xFFFF0000) | seq16;
+
+    if ((seq > last) && (seq >= 0x10000))
+    {
+        seq -= 0x10000;
+    }
+
+    return seq;
+}
+#endif // BLE_GL_SENSOR
+
+/*
+ * GLOBAL FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+#if (BLE_GL_SENSOR)
+uint32_t record_handling_date_time_to_sec(const struct prf_date_time *date_time)
+{
+    // Days from civil date, with March as the first month of the year
+    uint32_t y = date_time->year - (date_time->month <= 2);
+    uint32_t era = y / 400;
+    uint32_t yoe = y - era * 400;
+    uint32_t m = date_time->month;
+    uint32_t doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + date_time->day - 1;
+    uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    uint32_t days = era * 146097 + doe - 719468;
+
+    return days * 86400 + date_time->hour * 3600 + date_time->min * 60 + date_time->sec;
+}
+
+uint8_t record_handling_glp_select(const struct glp_filter *filter,
+                                   struct app_record_store_cursor *cursor)
+{
+    uint8_t op = rh_store_op(filter->operator);
+    uint8_t status;
+
+    if (op == 0xFF)
+    {
+        return GLP_RSP_INVALID_OPERATOR;
+    }
+
+    if (!rh_op_filtered(op))
+    {
+        status = app_record_store_select_seq(cursor, op, 0, 0);
+    }
+    else if (filter->filter_type == GLP_FILTER_SEQ_NUMBER)
+    {
+        // Map the 16-bit sequence numbers to the most recent records
+        status = app_record_store_select_seq(cursor, APP_RECORD_STORE_OP_ALL, 0, 0);
+        if (status == APP_RECORD_STORE_OK)
+        {
+            uint32_t min = rh_seq_from_16(filter->val.seq_num.min, cursor->last_seq);
+            uint32_t max = rh_seq_from_16(filter->val.seq_num.max, cursor->last_seq);
+
+            if ((op == APP_RECORD_STORE_OP_WITHIN_RANGE) &&
+                (filter->val.seq_num.min > filter->val.seq_num.max))
+            {
+                return GLP_RSP_INVALID_OPERAND;
+            }
+            status = app_record_store_select_seq(cursor, op, min, max);
+        }
+    }
+    else if (filter->filter_type == GLP_FILTER_USER_FACING_TIME)
+    {
+        status = app_record_store_select_time(cursor, op,
+                                              record_handling_date_time_to_sec(&filter->val.time.facetime_min),
+                                              record_handling_date_time_to_sec(&filter->val.time.facetime_max));
+    }
+    else
+    {
+        return GLP_RSP_OPERAND_NOT_SUP;
+    }
+
+    switch (status)
+    {
+        case APP_RECORD_STORE_OK:
+            return GLP_RSP_SUCCESS;
+        case APP_RECORD_STORE_ERR_INVALID_PARAM:
+            return GLP_RSP_INVALID_OPERAND;
+        default:
+            return GLP_RSP_NO_RECS_FOUND;
+    }
+}
+#endif // BLE_GL_SENSOR
+
+#if (BLE_CGM_SERVER)
+uint8_t record_handling_cgm_select(const struct cgm_filter *filter,
+                                   struct app_record_store_cursor *cursor)
+{
+    uint8_t op = rh_store_op(filter->operator);
+    uint8_t status;
+
+    if (op == 0xFF)
+    {
+        return CGM_RSP_INVALID_OPERATOR;
+    }
+
+    if (!rh_op_filtered(op))
+    {
+        status = app_record_store_select_seq(cursor, op, 0, 0);
+    }
+    else if (filter->filter_type == CGM_FILTER_TIME_OFFSET)
+    {
+        status = app_record_store_select_time(cursor, op, filter->val.time_offset.min,
+                                              filter->val.time_offset.max);
+    }
+    else
+    {
+        return CGM_RSP_OPERAND_NOT_SUP;
+    }
+
+    switch (status)
+    {
+        case APP_RECORD_STORE_OK:
+            return CGM_RSP_SUCCESS;
+        case APP_RECORD_STORE_ERR_INVALID_PARAM:
+            return CGM_RSP_INVALID_OPERAND;
+        default:
+            return CGM_RSP_NO_RECS_FOUND;
+    }
+}
+#endif // BLE_CGM_SERVER
+
+uint16_t record_handling_count(const struct app_record_store_cursor *cursor)
+{
+    uint32_t count = app_record_store_count(cursor);
+
+    return (count > 0xFFFF) ? 0xFFFF : count;
+}
+
+void record_handling_report_start(const struct app_record_store_cursor *cursor)
+{
+    report.cursor = *cursor;
+    report.count = 0;
+    report.next = 0;
+    report.active = true;
+}
+
+const struct app_record_store_rec *record_handling_report_next(void)
+{
+    if (!report.active)
+    {
+        return NULL;
+    }
+
+    if (report.next == report.count)
+    {
+        // One SPI flash access for the next batch
+        report.count = app_record_store_read(&report.cursor, report.batch, RECORD_HANDLING_BATCH);
+        report.next = 0;
+        if (report.count == 0)
+        {
+            report.active = false;
+            return NULL;
+        }
+    }
+
+    return &report.batch[report.next++];
+}
+
+void record_handling_report_abort(void)
+{
+    report.active = false;
+}
+
+#endif // CFG_SPI_FLASH_ENABLE
+
+void default_set_stored_records(void)
+{
+#if defined (CFG_SPI_FLASH_ENABLE)
+    report.active = false;
+    app_record_store_init();
+#endif
+}
+
+/// @} RECORD_HANDLING
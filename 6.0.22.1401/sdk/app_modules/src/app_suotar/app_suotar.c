@@ -84,6 +84,33 @@ app_suota_state suota_state __SECTION_ZERO("retention_mem_area0"); //@RETENTION
 
 __ALIGNED(4) uint8_t suota_all_pd[SUOTA_OVERALL_PD_SIZE] __SECTION_ZERO("retention_mem_area0"); // word aligned buffer to read the patch to before patch execute
 
+#if (SUOTAR_PIPELINED)
+/// Number of image blocks that can wait to be programmed
+#define SUOTAR_PIPE_SLOTS       (SUOTAR_RX_BUFFERS - 1)
+
+/// Image block waiting to be programmed
+typedef struct
+{
+    /// Destination address in the external memory
+    uint32_t    addr;
+
+    /// Block length
+    uint16_t    len;
+
+    /// Number of bytes already programmed
+    uint16_t    done;
+} suotar_pipe_blk_t;
+
+__ALIGNED(4) static uint8_t suota_pipe_pd[SUOTAR_PIPE_SLOTS][SUOTA_OVERALL_PD_SIZE] __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+static suotar_pipe_blk_t suota_pipe_blk[SUOTAR_PIPE_SLOTS]  __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+static uint8_t suota_pipe_head                              __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+static uint8_t suota_pipe_cnt                               __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+static uint8_t suota_pipe_status                            __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+static bool suota_pipe_msg_pending                          __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+static bool suota_pipe_stalled                              __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+static bool suota_pipe_end_pending                          __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+#endif
+
 /*
  * FUNCTION DEFINITIONS
  ****************************************************************************************
@@ -106,6 +133,11 @@ uint8_t app_get_image_id(uint8_t);
 uint8_t app_find_old_img(uint8_t, uint8_t);
 
 extern void platform_reset(uint32_t error);
+
+#if (SUOTAR_PIPELINED)
+static void app_suotar_pipe_reset(void);
+#endif
+static void app_suotar_img_end(void);
  /**
  ****************************************************************************************
  * SUOTAR Application Functions
@@ -122,6 +154,9 @@ void app_suotar_init(void)
     suota_state.crc_calc = 0;
     memset( suota_all_pd, 0x00, sizeof(uint32_t)); // Set first WORD to 0x00
     suota_state.mem_dev = SUOTAR_MEM_INVAL_DEV;
+#if (SUOTAR_PIPELINED)
+    app_suotar_pipe_reset();
+#endif
 }
 
 void app_suotar_reset(void)
@@ -129,6 +164,9 @@ void app_suotar_reset(void)
     suota_state.suota_pd_idx = 0;
     suota_state.suota_block_idx = 0;
     suota_state.new_patch_len = 0;
+#if (SUOTAR_PIPELINED)
+    app_suotar_pipe_reset();
+#endif
 }
 
 void app_suotar_create_db(void)
@@ -217,19 +255,15 @@ void app_suotar_read_mem(uint32_t mem_dev, uint32_t* mem_info)
 
         case SUOTAR_IMG_END:
         {
-            uint8_t ret;
-            // Initiator requested to exit service. Calculate CRC if succesfull, send notification to initiator
-            if(  suota_state.crc_calc != 0 )
-            {
-                suotar_send_status_update_req((uint8_t) SUOTAR_CRC_ERR);
-            }
-            else
+#if (SUOTAR_PIPELINED)
+            // Blocks are still being programmed. Finish when the last one is done.
+            if (suota_pipe_cnt != 0)
             {
-                ret = app_set_image_valid_flag();
-                suotar_send_status_update_req((uint8_t) ret);
+                suota_pipe_end_pending = true;
+                break;
             }
-            app_suotar_stop();
-            app_suotar_reset();
+#endif
+            app_suotar_img_end();
             break;
         }
 
@@ -281,6 +315,13 @@ void app_suotar_start(void)
     suota_state.suota_img_idx = 0;
     suota_state.new_patch_len = 0;
     suota_state.crc_calc = 0;
+#if (SUOTAR_CRC32)
+    suota_state.crc32_calc = 0;
+    suota_state.crc32_check = false;
+#endif
+#if (SUOTAR_PIPELINED)
+    app_suotar_pipe_reset();
+#endif
 }
 
 void app_suotar_stop(void)
@@ -330,6 +371,346 @@ void suotar_send_mem_info_update_req(uint32_t mem_info)
     KE_MSG_SEND(req);
 }
 
+/**
+ ****************************************************************************************
+ * @brief Checks the CRCs of the received image, marks it valid on success and stops
+ *        the SUOTAR service. Called when the initiator has sent the whole image.
+ ****************************************************************************************
+ */
+static void app_suotar_img_end(void)
+{
+    uint8_t ret;
+
+    // Initiator requested to exit service. Calculate CRC if succesfull, send notification to initiator
+    if(  suota_state.crc_calc != 0 )
+    {
+        suotar_send_status_update_req((uint8_t) SUOTAR_CRC_ERR);
+    }
+#if (SUOTAR_CRC32)
+    else if (suota_state.crc32_check && (suota_state.crc32_calc != suota_state.crc32_expected))
+    {
+        suotar_send_status_update_req((uint8_t) SUOTAR_CRC_ERR);
+    }
+#endif
+#if (SUOTAR_PIPELINED)
+    else if (suota_pipe_status != SUOTAR_CMP_OK)
+    {
+        suotar_send_status_update_req(suota_pipe_status);
+    }
+#endif
+    else
+    {
+        ret = app_set_image_valid_flag();
+        suotar_send_status_update_req((uint8_t) ret);
+    }
+    app_suotar_stop();
+    app_suotar_reset();
+}
+
+#if (SUOTAR_CRC32)
+/**
+ ****************************************************************************************
+ * @brief CRC32 with the polynomial of third_party/crc32 and mkimage, using a 16 entry
+ *        table to keep the code and data footprint small.
+ *
+ * @param[in] crc:   CRC of the preceding data (0 for the first call)
+ * @param[in] data:  Data
+ * @param[in] len:   Data length
+ *
+ * @return The updated CRC
+ ****************************************************************************************
+ */
+static uint32_t app_suotar_crc32(uint32_t crc, const uint8_t *data, uint32_t len)
+{
+    static const uint32_t crc32_nibble_tab[16] =
+    {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+        0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+        0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+    };
+
+    crc = ~crc;
+    while (len--)
+    {
+        crc ^= *data++;
+        crc = crc32_nibble_tab[crc & 0x0F] ^ (crc >> 4);
+        crc = crc32_nibble_tab[crc & 0x0F] ^ (crc >> 4);
+    }
+
+    return ~crc;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Adds the image code of the block in suota_all_pd to the image CRC32. The CRC32
+ *        of the first block starts after the image header, which also provides the
+ *        expected CRC32. Bytes beyond the image (i.e. the XOR CRC byte) are skipped.
+ ****************************************************************************************
+ */
+static void app_suotar_crc32_update(void)
+{
+    uint32_t start = 0;
+    uint32_t end = suota_state.suota_block_idx;
+    uint32_t image_len = suota_state.suota_image_len;
+
+    if (suota_state.suota_img_idx == 0)
+    {
+        image_header_t *pfwHeader = (image_header_t *) suota_all_pd;
+
+        // A block shorter than the header is rejected by app_read_image_headers()
+        if (end < sizeof(image_header_t))
+        {
+            return;
+        }
+
+        suota_state.crc32_calc = 0;
+        suota_state.crc32_expected = pfwHeader->CRC;
+        // The CRC of encrypted images is calculated over the clear image
+        suota_state.crc32_check = (pfwHeader->encryption == 0);
+        image_len = pfwHeader->code_size + sizeof(image_header_t);
+        start = CODE_OFFSET;
+    }
+
+    if (suota_state.suota_img_idx + end > image_len)
+    {
+        end = (image_len > suota_state.suota_img_idx) ? (image_len - suota_state.suota_img_idx) : 0;
+    }
+
+    if (end > start)
+    {
+        suota_state.crc32_calc = app_suotar_crc32(suota_state.crc32_calc, &suota_all_pd[start], end - start);
+    }
+}
+#endif // SUOTAR_CRC32
+
+#if (SUOTAR_PIPELINED)
+/**
+ ****************************************************************************************
+ * @brief Drops the queued image blocks.
+ ****************************************************************************************
+ */
+static void app_suotar_pipe_reset(void)
+{
+    suota_pipe_head = 0;
+    suota_pipe_cnt = 0;
+    suota_pipe_status = SUOTAR_CMP_OK;
+    suota_pipe_stalled = false;
+    suota_pipe_end_pending = false;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Configures the GPIOs and initializes the external memory device.
+ ****************************************************************************************
+ */
+static void app_suotar_ext_mem_init(void)
+{
+    if (suota_state.mem_dev == SUOTAR_IMG_SPI_FLASH)
+    {
+#if (!SUOTAR_SPI_DISABLE)
+        spi_gpio_config_t spi_conf;
+
+        app_suotar_spi_config(&spi_conf);
+        app_spi_flash_init(&spi_conf.cs);
+#endif
+    }
+    else
+    {
+#if (!SUOTAR_I2C_DISABLE)
+        i2c_gpio_config_t i2c_conf;
+
+        app_suotar_i2c_config(&i2c_conf);
+
+        // Update address from received message
+        i2c_eeprom_update_slave_address(i2c_conf.slave_addr);
+
+        // Initialize I2C EEPROM
+        i2c_eeprom_initialize();
+#endif
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Writes data to the external memory device.
+ *
+ * @param[in] data:     Data to be written
+ * @param[in] address:  Destination address
+ * @param[in] size:     Size of the data
+ *
+ * @return SUOTAR_CMP_OK on success, SUOTAR_EXT_MEM_WRITE_ERR otherwise
+ ****************************************************************************************
+ */
+static uint8_t app_suotar_write_ext_mem(uint8_t *data, uint32_t address, uint32_t size)
+{
+    if (suota_state.mem_dev == SUOTAR_IMG_SPI_FLASH)
+    {
+#if (!SUOTAR_SPI_DISABLE)
+        if (app_flash_write_data(data, address, size) >= 0)
+        {
+            return SUOTAR_CMP_OK;
+        }
+#endif
+    }
+    else
+    {
+#if (!SUOTAR_I2C_DISABLE)
+        uint32_t ret_i2c;
+
+        if ((i2c_eeprom_write_data(data, address, size, &ret_i2c) == I2C_NO_ERROR) && (ret_i2c == size))
+        {
+            return SUOTAR_CMP_OK;
+        }
+#endif
+    }
+
+    return SUOTAR_EXT_MEM_WRITE_ERR;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Moves the block in suota_all_pd to a free pipeline slot and acknowledges it,
+ *        so that the initiator can send the next block while this one is programmed.
+ ****************************************************************************************
+ */
+static void app_suotar_pipe_accept_block(void)
+{
+    uint32_t len = suota_state.suota_block_idx;
+
+    if (len != 0)
+    {
+        uint8_t slot = (suota_pipe_head + suota_pipe_cnt) % SUOTAR_PIPE_SLOTS;
+
+        memcpy(suota_pipe_pd[slot], suota_all_pd, len);
+        suota_pipe_blk[slot].addr = suota_state.mem_base_add + suota_state.suota_img_idx;
+        suota_pipe_blk[slot].len = len;
+        suota_pipe_blk[slot].done = 0;
+        suota_pipe_cnt++;
+
+        if (!suota_pipe_msg_pending)
+        {
+            suota_pipe_msg_pending = true;
+            KE_MSG_SEND_BASIC(APP_SUOTAR_PROGRAM, TASK_APP, TASK_APP);
+        }
+    }
+
+    // Update block index
+    suota_state.suota_img_idx += len;
+    suota_state.suota_block_idx = 0;
+
+    suotar_send_mem_info_update_req(suota_state.suota_img_idx);
+    suotar_send_status_update_req((uint8_t) SUOTAR_CMP_OK);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Queues an image block (any block after the one holding the image header).
+ *        If all slots are busy the block stays in suota_all_pd and is acknowledged
+ *        when a slot becomes free. The initiator does not send the next block before
+ *        the acknowledgement.
+ ****************************************************************************************
+ */
+static void app_suotar_pipe_queue_block(void)
+{
+    uint8_t status = suota_pipe_status;
+
+    if (status == SUOTAR_CMP_OK)
+    {
+        //check file size
+        if (( suota_state.suota_image_len+ADDITINAL_CRC_SIZE ) >= ( suota_state.suota_img_idx + suota_state.suota_block_idx ))
+        {
+            if (suota_state.suota_image_len < (suota_state.suota_img_idx + suota_state.suota_block_idx))
+                suota_state.suota_block_idx = suota_state.suota_image_len - suota_state.suota_img_idx;
+
+            if (suota_pipe_cnt == SUOTAR_PIPE_SLOTS)
+            {
+                suota_pipe_stalled = true;
+            }
+            else
+            {
+                app_suotar_pipe_accept_block();
+            }
+            return;
+        }
+
+        status = SUOTAR_EXT_MEM_WRITE_ERR;
+    }
+
+    suota_state.suota_block_idx = 0;
+    suotar_send_mem_info_update_req(suota_state.suota_img_idx);
+    suotar_send_status_update_req(status);
+}
+
+void app_suotar_program_step(void)
+{
+    if (suota_pipe_cnt != 0)
+    {
+        uint8_t head = suota_pipe_head;
+        suotar_pipe_blk_t *blk = &suota_pipe_blk[head];
+        uint32_t len;
+        uint8_t status;
+
+        if (blk->done == 0)
+        {
+            app_suotar_ext_mem_init();
+        }
+
+        // Program up to the end of the current page
+        len = SUOTAR_PROGRAM_CHUNK_SIZE - ((blk->addr + blk->done) % SUOTAR_PROGRAM_CHUNK_SIZE);
+        if (len > (uint32_t)(blk->len - blk->done))
+        {
+            len = blk->len - blk->done;
+        }
+
+        status = app_suotar_write_ext_mem(&suota_pipe_pd[head][blk->done], blk->addr + blk->done, len);
+
+        // The SUOTAR service may have been reset while the scheduler ran during a sector erase
+        if (suota_pipe_cnt != 0)
+        {
+            if (status != SUOTAR_CMP_OK)
+            {
+                // Drop the queued blocks and report the error now and at the end of the image
+                suota_pipe_status = status;
+                suota_pipe_cnt = 0;
+                suota_pipe_stalled = false;
+                suotar_send_status_update_req(status);
+            }
+            else
+            {
+                blk->done += len;
+                if (blk->done == blk->len)
+                {
+                    suota_pipe_head = (head + 1) % SUOTAR_PIPE_SLOTS;
+                    suota_pipe_cnt--;
+                }
+            }
+
+            if (suota_pipe_stalled && (suota_pipe_cnt < SUOTAR_PIPE_SLOTS))
+            {
+                suota_pipe_stalled = false;
+                app_suotar_pipe_accept_block();
+            }
+
+            if (suota_pipe_end_pending && (suota_pipe_cnt == 0))
+            {
+                suota_pipe_end_pending = false;
+                app_suotar_img_end();
+            }
+        }
+    }
+
+    if (suota_pipe_cnt != 0)
+    {
+        KE_MSG_SEND_BASIC(APP_SUOTAR_PROGRAM, TASK_APP, TASK_APP);
+    }
+    else
+    {
+        suota_pipe_msg_pending = false;
+    }
+}
+#endif // SUOTAR_PIPELINED
+
 void app_suotar_img_hdlr(void)
 {
     uint32_t mem_info;
@@ -349,6 +730,20 @@ void app_suotar_img_hdlr(void)
         suota_state.crc_calc ^= suota_all_pd[i];
     }
 
+#if (SUOTAR_CRC32)
+    app_suotar_crc32_update();
+#endif
+
+#if (SUOTAR_PIPELINED)
+    // The block with the image header is handled below. The rest are programmed in the background.
+    if ((suota_state.suota_img_idx != 0) &&
+        ((suota_state.mem_dev == SUOTAR_IMG_SPI_FLASH) || (suota_state.mem_dev == SUOTAR_IMG_I2C_EEPROM)))
+    {
+        app_suotar_pipe_queue_block();
+        return;
+    }
+#endif
+
     // Check mem dev.
     switch (suota_state.mem_dev)
     {
@@ -978,8 +1373,9 @@ int32_t app_flash_write_data (uint8_t *data, uint32_t address, uint32_t size)
     {
         // We start at a place where new sector starts - erase from here.
         app_erase_flash_sectors(address, size, true);
-    } else if ((upper_limit/SPI_FLASH_SECTOR_SIZE) != (address/SPI_FLASH_SECTOR_SIZE)) {
+    } else if (((upper_limit - 1)/SPI_FLASH_SECTOR_SIZE) != (address/SPI_FLASH_SECTOR_SIZE)) {
         // We start in the middle of already erased sector - start erase from next one.
+        // The upper limit is excluded: data ending at a sector boundary erases nothing.
         next_sector_start = starting_sector + SPI_FLASH_SECTOR_SIZE;
 
         app_erase_flash_sectors(next_sector_start, upper_limit - next_sector_start, true);
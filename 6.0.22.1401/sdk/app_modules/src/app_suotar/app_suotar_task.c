@@ -250,6 +250,28 @@ static int suotar_patch_len_ind_handler(ke_msg_id_t const msgid,
     return (KE_MSG_CONSUMED);
 }
 
+#if (SUOTAR_PIPELINED)
+/**
+ ****************************************************************************************
+ * @brief Programs the next chunk of the queued SUOTA image blocks.
+ * @param[in] msgid     Id of the message received.
+ * @param[in] param     Pointer to the parameters of the message.
+ * @param[in] dest_id   ID of the receiving task instance (TASK_APP).
+ * @param[in] src_id    ID of the sending task instance.
+ * @return If the message was consumed or not.
+ ****************************************************************************************
+ */
+static int app_suotar_program_handler(ke_msg_id_t const msgid,
+                                      void const *param,
+                                      ke_task_id_t const dest_id,
+                                      ke_task_id_t const src_id)
+{
+    app_suotar_program_step();
+
+    return (KE_MSG_CONSUMED);
+}
+#endif
+
 /*
  * GLOBAL VARIABLES DEFINITION
  ****************************************************************************************
@@ -261,6 +283,9 @@ static const struct ke_msg_handler app_suotar_process_handlers[]=
     {SUOTAR_GPIO_MAP_IND,                   (ke_msg_func_t)suotar_gpio_map_ind_handler},
     {SUOTAR_PATCH_LEN_IND,                  (ke_msg_func_t)suotar_patch_len_ind_handler},
     {SUOTAR_PATCH_DATA_IND,                 (ke_msg_func_t)suotar_patch_data_ind_handler},
+#if (SUOTAR_PIPELINED)
+    {APP_SUOTAR_PROGRAM,                    (ke_msg_func_t)app_suotar_program_handler},
+#endif
 };
 
 /*
@@ -37,6 +37,7 @@
  */
 #include "rwble_config.h"              // SW configuration
 #if (BLE_CUSTOM_SERVER)
+#include <string.h>
 #include "custom_common.h"
 #if (BLE_CUSTOM1_SERVER)
 #include "custs1.h"
@@ -50,6 +51,7 @@
 #include "prf_types.h"
 #include "prf_utils.h"
 #include "arch.h"
+#include "ke_mem.h"
 
 /*
  * DEFINES
@@ -222,4 +224,175 @@ uint8_t custs2_get_att_idx(uint16_t handle, uint8_t *att_idx)
 }
 #endif // (BLE_CUSTOM2_SERVER)
 
+/**
+ ****************************************************************************************
+ * @brief Get the capacity of the value slot of an attribute.
+ * @param[in] att_desc    Attribute description
+ * @return Slot capacity, 0 if the attribute has no value in the store
+ ****************************************************************************************
+ */
+static uint8_t custs_val_slot_size(const struct attm_desc_128 *att_desc)
+{
+    // Client Characteristic CFG values are kept per connection
+    if (att_desc->uuid_size == ATT_UUID_16_LEN &&
+        *(uint16_t *)att_desc->uuid == ATT_DESC_CLIENT_CHAR_CFG)
+    {
+        return BLE_CONNECTION_MAX;
+    }
+
+    return 0;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Find the value slot of an attribute.
+ * @param[in] store       Value store
+ * @param[in] att_idx     Custom attribute index
+ * @return Pointer to the slot, NULL if the attribute has no value in the store
+ ****************************************************************************************
+ */
+static struct custs_val_slot *custs_val_slot_find(const struct custs_val_store *store, uint8_t att_idx)
+{
+    uint8_t low = 0;
+    uint8_t high = store->nb_slot;
+
+    // The slots are sorted by attribute index
+    while (low < high)
+    {
+        uint8_t mid = (low + high) / 2;
+
+        if (store->slot[mid].att_idx == att_idx)
+        {
+            return &store->slot[mid];
+        }
+
+        if (store->slot[mid].att_idx < att_idx)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    return NULL;
+}
+
+bool custs_val_store_init(struct custs_val_store *store, const struct attm_desc_128 *att_db, uint8_t nb_att)
+{
+    uint16_t arena_size = 0;
+    uint8_t nb_slot = 0;
+    uint8_t i;
+
+    memset(store, 0, sizeof(struct custs_val_store));
+
+    // Size the slot table and the arena in a first pass
+    for (i = 0; i < nb_att; i++)
+    {
+        if (custs_val_slot_size(&att_db[i]))
+        {
+            arena_size += custs_val_slot_size(&att_db[i]);
+            nb_slot++;
+        }
+    }
+
+    if (nb_slot == 0)
+    {
+        return true;
+    }
+
+    store->slot = (struct custs_val_slot *) ke_malloc(nb_slot * sizeof(struct custs_val_slot) + arena_size,
+                                                      KE_MEM_ATT_DB);
+    if (store->slot == NULL)
+    {
+        return false;
+    }
+
+    store->nb_slot = nb_slot;
+    store->data = (uint8_t *)&store->slot[nb_slot];
+    memset(store->data, 0, arena_size);
+
+    arena_size = 0;
+    nb_slot = 0;
+    for (i = 0; i < nb_att; i++)
+    {
+        if (custs_val_slot_size(&att_db[i]))
+        {
+            store->slot[nb_slot].offset = arena_size;
+            store->slot[nb_slot].att_idx = i;
+            store->slot[nb_slot].max_length = custs_val_slot_size(&att_db[i]);
+            store->slot[nb_slot].length = 0;
+            arena_size += store->slot[nb_slot].max_length;
+            nb_slot++;
+        }
+    }
+
+    return true;
+}
+
+void custs_val_store_free(struct custs_val_store *store)
+{
+    if (store->slot != NULL)
+    {
+        ke_free(store->slot);
+    }
+    memset(store, 0, sizeof(struct custs_val_store));
+}
+
+int custs_val_store_set(struct custs_val_store *store, uint8_t att_idx, uint16_t length, const uint8_t *data)
+{
+    struct custs_val_slot *slot = custs_val_slot_find(store, att_idx);
+
+    if (slot == NULL)
+    {
+        return ATT_ERR_ATTRIBUTE_NOT_FOUND;
+    }
+
+    if (length > slot->max_length)
+    {
+        return ATT_ERR_INVALID_ATTRIBUTE_VAL_LEN;
+    }
+
+    slot->length = length;
+    memcpy(&store->data[slot->offset], data, length);
+
+    return 0;
+}
+
+int custs_val_store_get(const struct custs_val_store *store, uint8_t att_idx, uint16_t *length, const uint8_t **data)
+{
+    const struct custs_val_slot *slot = custs_val_slot_find(store, att_idx);
+
+    ASSERT_ERROR(data);
+    ASSERT_ERROR(length);
+
+    if ((slot == NULL) || (slot->length == 0))
+    {
+        *length = 0;
+        *data = NULL;
+        return ATT_ERR_ATTRIBUTE_NOT_FOUND;
+    }
+
+    *length = slot->length;
+    *data = &store->data[slot->offset];
+
+    return 0;
+}
+
+uint8_t *custs_val_store_get_buf(struct custs_val_store *store, uint8_t att_idx, uint16_t *length)
+{
+    struct custs_val_slot *slot = custs_val_slot_find(store, att_idx);
+
+    if ((slot == NULL) || (slot->length == 0))
+    {
+        *length = 0;
+        return NULL;
+    }
+
+    *length = slot->length;
+
+    return &store->data[slot->offset];
+}
+
 #endif // (BLE_CUSTOM_SERVER)
@@ -35,6 +35,33 @@
 #define __CUSTOM_COMMON_H
 
 #include "gattc_task.h"
+#include "attm_db_128.h"
+
+/// Value slot of an attribute in the value store
+struct custs_val_slot
+{
+    /// Offset of the value in the value arena
+    uint16_t offset;
+    /// Attribute index
+    uint8_t att_idx;
+    /// Capacity of the slot
+    uint8_t max_length;
+    /// Current value length (0: value not set)
+    uint8_t length;
+};
+
+/// Characteristic value store of a custom service. There is one slot for each attribute
+/// that holds a value, sorted by attribute index. The slot table and all the values are
+/// preallocated in one arena when the service is created.
+struct custs_val_store
+{
+    /// Number of slots
+    uint8_t nb_slot;
+    /// Value slots
+    struct custs_val_slot *slot;
+    /// Value arena
+    uint8_t *data;
+};
 
 /**
  ****************************************************************************************
@@ -64,6 +91,63 @@ uint16_t get_value_handle(uint16_t cfg_handle);
  */
 uint16_t get_cfg_handle(uint16_t value_handle);
 
+/**
+ ****************************************************************************************
+ * @brief Create the value store of a custom service. A slot is reserved for every
+ *        Client Characteristic CFG attribute, holding one value per connection.
+ * @param[out] store      Value store
+ * @param[in]  att_db     Custom service attribute definition table
+ * @param[in]  nb_att     Number of elements in att_db
+ * @return true on success, false if the arena could not be allocated
+ ****************************************************************************************
+ */
+bool custs_val_store_init(struct custs_val_store *store, const struct attm_desc_128 *att_db, uint8_t nb_att);
+
+/**
+ ****************************************************************************************
+ * @brief Free the arena of a value store.
+ * @param[in] store       Value store
+ ****************************************************************************************
+ */
+void custs_val_store_free(struct custs_val_store *store);
+
+/**
+ ****************************************************************************************
+ * @brief Store the value of an attribute.
+ * @param[in] store       Value store
+ * @param[in] att_idx     Custom attribute index
+ * @param[in] length      Value length
+ * @param[in] data        Pointer to value data
+ * @return 0 on success, ATT_ERR_ATTRIBUTE_NOT_FOUND if the attribute has no slot,
+ *         ATT_ERR_INVALID_ATTRIBUTE_VAL_LEN if the value does not fit in the slot.
+ ****************************************************************************************
+ */
+int custs_val_store_set(struct custs_val_store *store, uint8_t att_idx, uint16_t length, const uint8_t *data);
+
+/**
+ ****************************************************************************************
+ * @brief Get the value of an attribute. The returned pointer refers to the value in the
+ *        store (no copy) and stays valid until the service is destroyed.
+ * @param[in]  store      Value store
+ * @param[in]  att_idx    Custom attribute index
+ * @param[out] length     Pointer to variable that receives length of the value
+ * @param[out] data       Pointer to variable that receives pointer to the value
+ * @return 0 on success, ATT_ERR_ATTRIBUTE_NOT_FOUND if there is no value for such attribute.
+ ****************************************************************************************
+ */
+int custs_val_store_get(const struct custs_val_store *store, uint8_t att_idx, uint16_t *length, const uint8_t **data);
+
+/**
+ ****************************************************************************************
+ * @brief Get a writable pointer to the value of an attribute, to update it in place.
+ * @param[in]  store      Value store
+ * @param[in]  att_idx    Custom attribute index
+ * @param[out] length     Pointer to variable that receives length of the value
+ * @return Pointer to the value, NULL if there is no value for such attribute.
+ ****************************************************************************************
+ */
+uint8_t *custs_val_store_get_buf(struct custs_val_store *store, uint8_t att_idx, uint16_t *length);
+
 #if (BLE_CUSTOM1_SERVER)
 /**
  ****************************************************************************************
@@ -64,6 +64,8 @@
  */
 
 /// Value element
+/// @deprecated The values are kept in a custs_val_store (see custom_common.h) and this
+///             element is no longer used by the profile. Kept for source compatibility.
 struct custs1_val_elmt
 {
     /// list element header
@@ -93,8 +95,13 @@ struct custs1_env_tag
     /// CCC handle index, used during notification/indication busy state
     uint8_t ccc_idx;
 
+#if !defined (__DA14531__) || defined (__EXCLUDE_ROM_CUSTS1__)
+    /// Values set by application, indexed by attribute index
+    struct custs_val_store values;
+#else
     /// List of values set by application
     struct co_list values;
+#endif
     /// CUSTS1 task state
     ke_state_t state[CUSTS1_IDX_MAX];
 };
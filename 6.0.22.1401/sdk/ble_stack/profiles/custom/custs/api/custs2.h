@@ -64,6 +64,8 @@
  */
 
 /// Value element
+/// @deprecated The values are kept in a custs_val_store (see custom_common.h) and this
+///             element is no longer used by the profile. Kept for source compatibility.
 struct custs2_val_elmt
 {
     /// list element header
@@ -93,8 +95,8 @@ struct custs2_env_tag
     /// CCC handle index, used during notification/indication busy state
     uint8_t ccc_idx;
 
-    /// List of values set by application
-    struct co_list values;
+    /// Values set by application, indexed by attribute index
+    struct custs_val_store values;
     /// CUSTS2 task state
     ke_state_t state[CUSTS2_IDX_MAX];
 };
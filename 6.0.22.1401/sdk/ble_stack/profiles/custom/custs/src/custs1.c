@@ -140,8 +140,15 @@ static uint8_t custs1_init(struct prf_task_env *env, uint16_t *start_hdl, uint16
         env->desc.idx_max           = CUSTS1_IDX_MAX;
         env->desc.state             = custs1_env->state;
         env->desc.default_handler   = &custs1_default_handler;
-        co_list_init(&(custs1_env->values));
-        custs1_init_ccc_values(custs1_att_db, custs1_att_max_nb);
+        if (!custs_val_store_init(&(custs1_env->values), custs1_att_db, custs1_att_max_nb))
+        {
+            ASSERT_WARNING(0);
+            status = ATT_ERR_INSUFF_RESOURCE;
+        }
+        else
+        {
+            custs1_init_ccc_values(custs1_att_db, custs1_att_max_nb);
+        }
 
         // profile is ready, go into an Idle state
         ke_state_set(env->task, CUSTS1_IDLE);
@@ -162,12 +169,8 @@ static void custs1_destroy(struct prf_task_env *env)
 {
     struct custs1_env_tag *custs1_env = (struct custs1_env_tag *)env->env;
 
-    // remove all values present in list
-    while (!co_list_is_empty(&(custs1_env->values)))
-    {
-        struct co_list_hdr *hdr = co_list_pop_front(&(custs1_env->values));
-        ke_free(hdr);
-    }
+    // free the value store
+    custs_val_store_free(&(custs1_env->values));
 
     // free profile environment variables
     env->env = NULL;
@@ -71,40 +71,8 @@ static int custs1_att_set_value(uint8_t att_idx, uint16_t length, const uint8_t
 {
     struct custs1_env_tag *custs1_env = PRF_ENV_GET(CUSTS1, custs1);
     ASSERT_ERROR(custs1_env);
-    // Check value if already present in service
-    struct custs1_val_elmt *val = (struct custs1_val_elmt *)co_list_pick(&(custs1_env->values));
-    // loop until value found
-    while (val != NULL)
-    {
-        // value is present in service
-        if (val->att_idx == att_idx)
-        {
-            // Value present but size changed, free old value
-            if (length != val->length)
-            {
-                co_list_extract(&custs1_env->values, &val->hdr, 0);
-                ke_free(val);
-                val = NULL;
-            }
-            break;
-        }
-
-        val = (struct custs1_val_elmt *)val->hdr.next;
-    }
-
-    if (val == NULL)
-    {
-        // allocate value data
-        val = (struct custs1_val_elmt *) ke_malloc(sizeof(struct custs1_val_elmt) + length, KE_MEM_ATT_DB);
-        memset(val, 0, sizeof(struct custs1_val_elmt) + length);
-        // insert value into the list
-        co_list_push_back(&custs1_env->values, &val->hdr);
-    }
-    val->att_idx = att_idx;
-    val->length = length;
-    memcpy(val->data, data, length);
 
-    return 0;
+    return custs_val_store_set(&custs1_env->values, att_idx, length, data);
 }
 
 /**
@@ -121,31 +89,8 @@ static int custs1_att_get_value(uint8_t att_idx, uint16_t *length, const uint8_t
 {
     struct custs1_env_tag *custs1_env = PRF_ENV_GET(CUSTS1, custs1);
     ASSERT_ERROR(custs1_env);
-    // Check value if already present in service
-    struct custs1_val_elmt *val = (struct custs1_val_elmt *)co_list_pick(&custs1_env->values);
-    ASSERT_ERROR(data);
-    ASSERT_ERROR(length);
 
-    // loop until value found
-    while (val != NULL)
-    {
-        // value is present in service
-        if (val->att_idx == att_idx)
-        {
-            *length = val->length;
-            *data = val->data;
-            break;
-        }
-
-        val = (struct custs1_val_elmt *)val->hdr.next;
-    }
-
-    if (val == NULL)
-    {
-        *length = 0;
-        *data = NULL;
-    }
-    return val ? 0 : ATT_ERR_ATTRIBUTE_NOT_FOUND;
+    return custs_val_store_get(&custs1_env->values, att_idx, length, data);
 }
 
 /**
@@ -184,18 +129,18 @@ void custs1_init_ccc_values(const struct attm_desc_128 *att_db, int max_nb_att)
  */
 void custs1_set_ccc_value(uint8_t conidx, uint8_t att_idx, uint16_t ccc)
 {
+    struct custs1_env_tag *custs1_env = PRF_ENV_GET(CUSTS1, custs1);
     uint16_t length;
-    const uint8_t *value;
-    uint8_t new_value[BLE_CONNECTION_MAX];
+    uint8_t *value;
+    ASSERT_ERROR(custs1_env);
     ASSERT_ERROR(conidx < BLE_CONNECTION_MAX);
 
-    custs1_att_get_value(att_idx, &length, &value);
+    // Update the stored value in place
+    value = custs_val_store_get_buf(&custs1_env->values, att_idx, &length);
     ASSERT_ERROR(length);
     ASSERT_ERROR(value);
-    memcpy(new_value, value, length);
     // For now there are only two valid values for ccc, store just one byte other is 0 anyway
-    new_value[conidx] = (uint8_t)ccc;
-    custs1_att_set_value(att_idx, length, new_value);
+    value[conidx] = (uint8_t)ccc;
 }
 
 /**
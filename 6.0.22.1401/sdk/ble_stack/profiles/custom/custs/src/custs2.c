@@ -138,8 +138,15 @@ static uint8_t custs2_init(struct prf_task_env *env, uint16_t *start_hdl, uint16
         env->desc.idx_max           = CUSTS2_IDX_MAX;
         env->desc.state             = custs2_env->state;
         env->desc.default_handler   = &custs2_default_handler;
-        co_list_init(&(custs2_env->values));
-        custs2_init_ccc_values(custs2_att_db, custs2_att_max_nb);
+        if (!custs_val_store_init(&(custs2_env->values), custs2_att_db, custs2_att_max_nb))
+        {
+            ASSERT_WARNING(0);
+            status = ATT_ERR_INSUFF_RESOURCE;
+        }
+        else
+        {
+            custs2_init_ccc_values(custs2_att_db, custs2_att_max_nb);
+        }
 
         // profile is ready, go into an Idle state
         ke_state_set(env->task, CUSTS2_IDLE);
@@ -160,12 +167,8 @@ static void custs2_destroy(struct prf_task_env *env)
 {
     struct custs2_env_tag *custs2_env = (struct custs2_env_tag *)env->env;
 
-    // remove all values present in list
-    while (!co_list_is_empty(&(custs2_env->values)))
-    {
-        struct co_list_hdr *hdr = co_list_pop_front(&(custs2_env->values));
-        ke_free(hdr);
-    }
+    // free the value store
+    custs_val_store_free(&(custs2_env->values));
 
     // free profile environment variables
     env->env = NULL;
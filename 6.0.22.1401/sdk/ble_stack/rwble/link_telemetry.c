@@ -0,0 +1,414 @@
+/**
+ ****************************************************************************************
+ * @addtogroup LINK_TELEMETRY
+ * @{
+ *
+ * @file link_telemetry.c
+ *
+ * @brief Per connection link quality telemetry.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include "arch.h"
+
+#if (LINK_TELEMETRY)
+
+#include <string.h>
+#include "rwip_config.h"
+#include "reg_ble_em_rx_desc.h"
+#include "link_telemetry.h"
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Bucket length in BLE slots (625 us)
+#define LINK_TELEMETRY_PERIOD_SLOTS     ((uint32_t)LINK_TELEMETRY_PERIOD * 8 / 5)
+
+/// Gap between two events of a connection after which it is taken for a new one, in
+/// BLE slots: the largest supervision timeout (32 s)
+#define LINK_TELEMETRY_IDLE_SLOTS       (51200)
+
+/// BLE time counter mask
+#define LINK_TELEMETRY_TIME_MASK        (0x07FFFFFF)
+
+/// Reception errors other than CRC and sync
+#define LINK_TELEMETRY_OTHER_ERR        (BLE_MIC_ERR_BIT | BLE_LEN_ERR_BIT | BLE_TYPE_ERR_BIT)
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/// Bucket, laid out without padding
+struct link_telemetry_bucket
+{
+    /// Time of the first event
+    uint32_t start;
+    /// Time of the last event
+    uint32_t last;
+    /// Sequence number
+    uint16_t seq;
+    /// Connection interval
+    uint16_t interval;
+    /// Slave latency
+    uint16_t latency;
+    /// Connection events
+    uint16_t events;
+    /// Packets received without error
+    uint16_t rx_ok;
+    /// Packets received with a CRC error
+    uint16_t rx_crc;
+    /// Receive windows without a packet
+    uint16_t rx_sync;
+    /// Packets received with another error
+    uint16_t rx_other;
+    /// RSSI histogram
+    uint16_t rssi[LINK_TELEMETRY_RSSI_BINS];
+    /// Packets per event histogram
+    uint16_t pkts[LINK_TELEMETRY_PKTS_BINS];
+    /// Wake-up delay histogram
+    uint16_t wakeup[LINK_TELEMETRY_WAKEUP_BINS];
+};
+
+/// Telemetry of a connection
+struct link_telemetry_link
+{
+    /// Ring of buckets
+    struct link_telemetry_bucket bucket[LINK_TELEMETRY_BUCKETS];
+    /// Time of the last event
+    uint32_t last;
+    /// Event counter of the last event
+    uint16_t counter;
+    /// Current bucket
+    uint8_t head;
+    /// Buckets holding data
+    uint8_t used;
+    /// Connection number
+    uint8_t conn;
+    /// Packets received in the current event
+    uint8_t event_rx;
+    /// Saturation flags of the buckets, one bit per bucket
+    uint8_t saturated[(LINK_TELEMETRY_BUCKETS + 7) / 8];
+};
+
+/*
+ * LOCAL VARIABLE DEFINITIONS
+ ****************************************************************************************
+ */
+
+static struct link_telemetry_link links[BLE_CONNECTION_MAX]  __SECTION_ZERO("retention_mem_area0");
+
+/// Lowest RSSI, as read from a RX descriptor, of the RSSI histogram bins 1 and up
+static uint8_t rssi_thr[LINK_TELEMETRY_RSSI_BINS - 1]        __SECTION_ZERO("retention_mem_area0");
+
+/// Wake-up delay histogram bin of the next connection event, 0xFF if none
+static uint8_t wakeup_bin                                     __SECTION_ZERO("retention_mem_area0");
+
+static uint16_t bucket_seq                                    __SECTION_ZERO("retention_mem_area0");
+
+static const uint16_t wakeup_edges[LINK_TELEMETRY_WAKEUP_BINS - 2] = LINK_TELEMETRY_WAKEUP_EDGES_US;
+
+/*
+ * LOCAL FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+static void inc(struct link_telemetry_link *link, uint16_t *counter)
+{
+    if (*counter != 0xFFFF)
+    {
+        (*counter)++;
+    }
+    else
+    {
+        link->saturated[link->head >> 3] |= 1 << (link->head & 7);
+    }
+}
+
+static void start_bucket(struct link_telemetry_link *link)
+{
+    struct link_telemetry_bucket *b;
+
+    if (link->used)
+    {
+        link->head = (link->head + 1) & (LINK_TELEMETRY_BUCKETS - 1);
+    }
+    if (link->used < LINK_TELEMETRY_BUCKETS)
+    {
+        link->used++;
+    }
+
+    b = &link->bucket[link->head];
+    memset(b, 0, sizeof(*b));
+    link->saturated[link->head >> 3] &= ~(1 << (link->head & 7));
+    b->seq = bucket_seq++;
+}
+
+static uint8_t *put16(uint8_t *p, uint16_t val)
+{
+    p[0] = val;
+    p[1] = val >> 8;
+    return p + 2;
+}
+
+static uint8_t *put32(uint8_t *p, uint32_t val)
+{
+    p = put16(p, val);
+    return put16(p, val >> 16);
+}
+
+/*
+ * EXPORTED FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+void link_telemetry_init(uint8_t (*rssi_convert)(uint8_t))
+{
+    uint8_t bin = 0;
+    uint16_t rssi;
+
+    memset(links, 0, sizeof(links));
+    wakeup_bin = 0xFF;
+
+    // The conversion is monotonic: the threshold of a bin is the first raw RSSI at or
+    // above its lower edge, so the interrupts only compare the raw value
+    for (rssi = 0; rssi <= 0xFF; rssi++)
+    {
+        int8_t dbm = (int8_t)rssi_convert((uint8_t)rssi);
+
+        while ((bin < LINK_TELEMETRY_RSSI_BINS - 1) && (dbm >= LINK_TELEMETRY_RSSI_EDGE(bin)))
+        {
+            rssi_thr[bin++] = (uint8_t)rssi;
+        }
+    }
+    while (bin < LINK_TELEMETRY_RSSI_BINS - 1)
+    {
+        rssi_thr[bin++] = 0xFF;
+    }
+}
+
+void link_telemetry_rx(uint8_t link_id, uint16_t status, uint8_t rssi)
+{
+    struct link_telemetry_link *link;
+    struct link_telemetry_bucket *b;
+
+    if ((link_id >= BLE_CONNECTION_MAX) || !links[link_id].used)
+    {
+        return;
+    }
+
+    link = &links[link_id];
+    b = &link->bucket[link->head];
+
+    if (status & BLE_SYNC_ERR_BIT)
+    {
+        inc(link, &b->rx_sync);
+        return;
+    }
+
+    if (link->event_rx != 0xFF)
+    {
+        link->event_rx++;
+    }
+
+    if (status & BLE_CRC_ERR_BIT)
+    {
+        inc(link, &b->rx_crc);
+    }
+    else if (status & LINK_TELEMETRY_OTHER_ERR)
+    {
+        inc(link, &b->rx_other);
+    }
+    else
+    {
+        uint8_t bin = 0;
+
+        while ((bin < LINK_TELEMETRY_RSSI_BINS - 1) && (rssi >= rssi_thr[bin]))
+        {
+            bin++;
+        }
+        inc(link, &b->rx_ok);
+        inc(link, &b->rssi[bin]);
+    }
+}
+
+void link_telemetry_event_end(uint8_t conhdl, uint16_t counter, uint16_t interval,
+                              uint16_t latency, uint32_t time)
+{
+    struct link_telemetry_link *link;
+    struct link_telemetry_bucket *b;
+    uint8_t pkts;
+
+    if (conhdl >= BLE_CONNECTION_MAX)
+    {
+        wakeup_bin = 0xFF;
+        return;
+    }
+
+    link = &links[conhdl];
+    b = &link->bucket[link->head];
+
+    if (!link->used
+        || ((counter < link->counter) && !((link->counter >= 0xF000) && (counter < 0x1000)))
+        || (((time - link->last) & LINK_TELEMETRY_TIME_MASK) > LINK_TELEMETRY_IDLE_SLOTS))
+    {
+        // New connection on this handle. Its first packets, received before this
+        // event ended, are lost.
+        uint8_t conn = link->conn + 1;
+
+        memset(link, 0, sizeof(*link));
+        link->conn = conn;
+        start_bucket(link);
+        b = &link->bucket[link->head];
+    }
+
+    if (!b->events)
+    {
+        b->start = time;
+    }
+
+    link->counter = counter;
+    link->last = time;
+    b->last = time;
+    b->interval = interval;
+    b->latency = latency;
+    inc(link, &b->events);
+
+    pkts = link->event_rx;
+    link->event_rx = 0;
+    inc(link, &b->pkts[(pkts < 2) ? pkts : (pkts < 4) ? 2 : 3]);
+
+    if (wakeup_bin != 0xFF)
+    {
+        inc(link, &b->wakeup[wakeup_bin]);
+        wakeup_bin = 0xFF;
+    }
+
+    // The bucket is full: the packets of the next event go to the next bucket
+    if (((time - b->start) & LINK_TELEMETRY_TIME_MASK) >= LINK_TELEMETRY_PERIOD_SLOTS)
+    {
+        start_bucket(link);
+    }
+}
+
+void link_telemetry_wakeup(uint32_t delay_us)
+{
+    uint8_t bin = 0;
+
+    if (delay_us)
+    {
+        for (bin = 1; (bin < LINK_TELEMETRY_WAKEUP_BINS - 1) && (delay_us >= wakeup_edges[bin - 1]); bin++)
+            ;
+    }
+
+    wakeup_bin = bin;
+}
+
+bool link_telemetry_read(uint8_t conhdl, uint8_t age, uint8_t *rec)
+{
+    const struct link_telemetry_link *link;
+    struct link_telemetry_bucket b;
+    uint8_t *p = rec;
+    uint8_t idx;
+    uint8_t flags;
+    int i;
+
+    if ((conhdl >= BLE_CONNECTION_MAX) || (age >= links[conhdl].used))
+    {
+        return false;
+    }
+
+    link = &links[conhdl];
+    idx = (link->head - age) & (LINK_TELEMETRY_BUCKETS - 1);
+
+    // The current bucket is updated by the BLE interrupts
+    GLOBAL_INT_DISABLE();
+    b = link->bucket[idx];
+    flags = (age == 0) ? LINK_TELEMETRY_OPEN : 0;
+    if (link->saturated[idx >> 3] & (1 << (idx & 7)))
+    {
+        flags |= LINK_TELEMETRY_SATURATED;
+    }
+    *p++ = LINK_TELEMETRY_REC_VERSION;
+    *p++ = conhdl;
+    *p++ = flags;
+    *p++ = age;
+    *p++ = link->conn;
+    *p++ = LINK_TELEMETRY_BUCKETS;
+    GLOBAL_INT_RESTORE();
+
+    p = put16(p, b.seq);
+    p = put16(p, b.interval);
+    p = put16(p, b.latency);
+    p = put32(p, b.start);
+    p = put32(p, b.last);
+    p = put16(p, b.events);
+    p = put16(p, b.rx_ok);
+    p = put16(p, b.rx_crc);
+    p = put16(p, b.rx_sync);
+    p = put16(p, b.rx_other);
+    for (i = 0; i < LINK_TELEMETRY_RSSI_BINS; i++)
+    {
+        p = put16(p, b.rssi[i]);
+    }
+    for (i = 0; i < LINK_TELEMETRY_PKTS_BINS; i++)
+    {
+        p = put16(p, b.pkts[i]);
+    }
+    for (i = 0; i < LINK_TELEMETRY_WAKEUP_BINS; i++)
+    {
+        p = put16(p, b.wakeup[i]);
+    }
+
+    return true;
+}
+
+void link_telemetry_reset(uint8_t conhdl)
+{
+    uint8_t i;
+
+    for (i = 0; i < BLE_CONNECTION_MAX; i++)
+    {
+        if ((conhdl == LINK_TELEMETRY_ALL) || (conhdl == i))
+        {
+            GLOBAL_INT_DISABLE();
+            links[i].used = 0;
+            GLOBAL_INT_RESTORE();
+        }
+    }
+}
+
+#endif // LINK_TELEMETRY
+
+///@}
@@ -0,0 +1,206 @@
+/**
+ ****************************************************************************************
+ * @addtogroup ROOT
+ * @{
+ * @addtogroup LINK_TELEMETRY Link Telemetry
+ * @brief Per connection link quality telemetry
+ * @{
+ *
+ * @file link_telemetry.h
+ *
+ * @brief Per connection link quality telemetry header file.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _LINK_TELEMETRY_H_
+#define _LINK_TELEMETRY_H_
+
+/*
+ * Link telemetry (CFG_LINK_TELEMETRY)
+ *
+ * Every connection owns a ring of LINK_TELEMETRY_BUCKETS buckets. A bucket covers the
+ * connection events of LINK_TELEMETRY_PERIOD ms from its first event and holds the
+ * received packets, the CRC, sync and other reception errors, a RSSI histogram, a
+ * packets per event histogram and a histogram of the wake-up delay before the event.
+ * The packets of an event are always accounted in the bucket of the event. The
+ * counters are updated from the BLE RX and end of event interrupts with a few compares
+ * and increments each; they saturate instead of wrapping.
+ *
+ * A new connection on a handle is detected from its event counter restarting, or from
+ * no event for longer than the largest supervision timeout, and clears the ring of the
+ * handle. The wake-up delay is only measured when USE_POWER_OPTIMIZATIONS is set.
+ *
+ * The buckets are read as LINK_TELEMETRY_REC_LEN bytes records, through the
+ * vendor HCI commands of the hci project or the link telemetry service of the
+ * ble_app_peripheral project, and collected on the host by
+ * utilities/link_telemetry_collector.
+ *
+ * Record layout (little endian):
+ *   [0]      LINK_TELEMETRY_REC_VERSION
+ *   [1]      connection handle
+ *   [2]      flags (enum link_telemetry_flags)
+ *   [3]      age of the bucket, 0 is the current one
+ *   [4]      connection number, increments with every new connection on the handle
+ *   [5]      number of buckets of the ring
+ *   [6..7]   bucket sequence number, increments with every new bucket
+ *   [8..9]   connection interval (625 us)
+ *   [10..11] slave latency
+ *   [12..15] time of the first event of the bucket (625 us)
+ *   [16..19] time of the last event of the bucket (625 us)
+ *   [20..21] connection events
+ *   [22..23] packets received without error
+ *   [24..25] packets received with a CRC error
+ *   [26..27] receive windows without a packet (sync error)
+ *   [28..29] packets received with another error (length, type, MIC)
+ *   [30..45] RSSI histogram, LINK_TELEMETRY_RSSI_BINS counters
+ *   [46..53] packets per event histogram, LINK_TELEMETRY_PKTS_BINS counters
+ *   [54..69] wake-up delay histogram, LINK_TELEMETRY_WAKEUP_BINS counters
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Number of buckets per connection (power of 2)
+#ifndef CFG_LINK_TELEMETRY_BUCKETS
+#define LINK_TELEMETRY_BUCKETS              (4)
+#else
+#define LINK_TELEMETRY_BUCKETS              (CFG_LINK_TELEMETRY_BUCKETS)
+#endif
+
+/// Time covered by a bucket in ms
+#ifndef CFG_LINK_TELEMETRY_PERIOD
+#define LINK_TELEMETRY_PERIOD               (15000)
+#else
+#define LINK_TELEMETRY_PERIOD               (CFG_LINK_TELEMETRY_PERIOD)
+#endif
+
+#if (LINK_TELEMETRY_BUCKETS & (LINK_TELEMETRY_BUCKETS - 1)) || (LINK_TELEMETRY_BUCKETS > 128)
+    #error "CFG_LINK_TELEMETRY_BUCKETS must be a power of 2, up to 128."
+#endif
+
+/// RSSI histogram: bin 0 is below LINK_TELEMETRY_RSSI_EDGE(0), bin n is from
+/// LINK_TELEMETRY_RSSI_EDGE(n-1) up to LINK_TELEMETRY_RSSI_EDGE(n) (dBm)
+#define LINK_TELEMETRY_RSSI_BINS            (8)
+#define LINK_TELEMETRY_RSSI_EDGE(n)         (-92 + 8 * (n))
+
+/// Packets per event histogram: 0, 1, 2 to 3 and 4 or more packets
+#define LINK_TELEMETRY_PKTS_BINS            (4)
+
+/// Wake-up delay histogram: bin 0 is an on time wake-up, bin n is a delay below
+/// the n-th edge, the last bin is a delay of 3 ms or more
+#define LINK_TELEMETRY_WAKEUP_BINS          (8)
+#define LINK_TELEMETRY_WAKEUP_EDGES_US      {500, 1000, 1250, 1500, 2000, 3000}
+
+/// Record format
+#define LINK_TELEMETRY_REC_VERSION          (1)
+#define LINK_TELEMETRY_REC_LEN              (70)
+
+/// All the connections, for link_telemetry_reset()
+#define LINK_TELEMETRY_ALL                  (0xFF)
+
+/// Record flags
+enum link_telemetry_flags
+{
+    /// Current bucket, still being filled
+    LINK_TELEMETRY_OPEN         = 0x01,
+    /// A counter of the bucket has saturated
+    LINK_TELEMETRY_SATURATED    = 0x02,
+};
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Initialize the telemetry and the RSSI histogram thresholds.
+ * @param[in] rssi_convert  Conversion of the RSSI read from a RX descriptor to dBm
+ ****************************************************************************************
+ */
+void link_telemetry_init(uint8_t (*rssi_convert)(uint8_t));
+
+/**
+ ****************************************************************************************
+ * @brief Account a RX descriptor. Called from the BLE interrupts.
+ * @param[in] link          Link label of the descriptor
+ * @param[in] status        Reception status of the descriptor
+ * @param[in] rssi          RSSI of the descriptor, as read from it
+ ****************************************************************************************
+ */
+void link_telemetry_rx(uint8_t link, uint16_t status, uint8_t rssi);
+
+/**
+ ****************************************************************************************
+ * @brief Account the end of a BLE event. Called from the BLE end of event interrupt,
+ * after the RX descriptors of the event.
+ * @param[in] conhdl        Connection handle, or LLD_ADV_HDL
+ * @param[in] counter       Connection event counter
+ * @param[in] interval      Connection interval (625 us)
+ * @param[in] latency       Slave latency
+ * @param[in] time          BLE time (625 us)
+ ****************************************************************************************
+ */
+void link_telemetry_event_end(uint8_t conhdl, uint16_t counter, uint16_t interval,
+                              uint16_t latency, uint32_t time);
+
+/**
+ ****************************************************************************************
+ * @brief Account the delay of a wake-up. It is added to the next connection event.
+ * @param[in] delay_us      Time the wake-up was late, 0 if on time
+ ****************************************************************************************
+ */
+void link_telemetry_wakeup(uint32_t delay_us);
+
+/**
+ ****************************************************************************************
+ * @brief Read a bucket of a connection as a record.
+ * @param[in] conhdl        Connection handle
+ * @param[in] age           Age of the bucket, 0 for the current one
+ * @param[out] rec          Record, LINK_TELEMETRY_REC_LEN bytes
+ * @return false if the connection handle is invalid or the bucket holds no data
+ ****************************************************************************************
+ */
+bool link_telemetry_read(uint8_t conhdl, uint8_t age, uint8_t *rec);
+
+/**
+ ****************************************************************************************
+ * @brief Clear the buckets of a connection. The next event starts a new series.
+ * @param[in] conhdl        Connection handle, or LINK_TELEMETRY_ALL
+ ****************************************************************************************
+ */
+void link_telemetry_reset(uint8_t conhdl);
+
+#endif // _LINK_TELEMETRY_H_
+
+///@}
+///@}
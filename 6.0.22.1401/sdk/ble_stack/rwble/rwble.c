@@ -75,6 +75,14 @@
 #include "wlan_coex.h"
 #endif
 
+#if (LINK_TELEMETRY)
+#include "link_telemetry.h"
+#endif
+
+#if (ADAPTIVE_TX_PWR)
+#include "adaptive_tx_pwr.h"
+#endif
+
 last_ble_evt        arch_rwble_last_event           __SECTION_ZERO("retention_mem_area0");
 boost_overhead_st   set_boost_low_vbat1v_overhead   __SECTION_ZERO("retention_mem_area0");
 
@@ -243,11 +251,11 @@ extern void rwble_isr_ROM(const ble_irq_t *ble_irq);
  */
 
 
-#if (BLE_METRICS)
+#if (BLE_METRICS || LINK_TELEMETRY || ADAPTIVE_TX_PWR)
 
 /**
  ****************************************************************************************
- * @brief Updates BLE packet metrics.
+ * @brief Updates BLE packet metrics, link telemetry and adaptive TX power.
  *
  * @param[in] pkts  Number of received packets.
  ****************************************************************************************
@@ -262,6 +270,15 @@ static void update_ble_metrics(uint8_t pkts)
         struct co_buf_rx_desc *rxdesc = co_buf_rx_get(rx_hdl);
         uint8_t status = rxdesc->rxstatus & 0x7F;
 
+#if (LINK_TELEMETRY)
+        link_telemetry_rx(llc_util_rxlink_getf(rxdesc), status, llc_util_rxrssi_getf(rxdesc));
+#endif
+
+#if (ADAPTIVE_TX_PWR)
+        adaptive_tx_pwr_rx(llc_util_rxlink_getf(rxdesc), status, rxdesc->rxheader, llc_util_rxrssi_getf(rxdesc));
+#endif
+
+#if (BLE_METRICS)
         if (status & (BLE_MIC_ERR_BIT | BLE_CRC_ERR_BIT | BLE_LEN_ERR_BIT | BLE_TYPE_ERR_BIT | BLE_SYNC_ERR_BIT))
         {
             metrics.rx_err++;
@@ -272,24 +289,25 @@ static void update_ble_metrics(uint8_t pkts)
         {
             uint16_t rx_rssi = (uint16_t) llc_util_rxrssi_getf(rxdesc);
 
-            if (!metrics.rx_pkt)
-            {
-                metrics.rx_rssi = rx_rssi;
-                metrics.rx_pkt++;
-            }
-            else
+            metrics.rx_pkt++;
+
+            // Average over the last 32768 to 65535 packets: the sum and the count are
+            // halved together instead of overflowing
+            if (metrics.rx_rssi_cnt == 0xFFFF)
             {
-                // Reminder: overflow if 32-bit boundary is exceeded
-                uint32_t tmp_sum = metrics.rx_rssi * metrics.rx_pkt;
-                metrics.rx_pkt++;
-                metrics.rx_rssi = (uint16_t)((tmp_sum + rx_rssi)/(metrics.rx_pkt));
+                metrics.rx_rssi_sum >>= 1;
+                metrics.rx_rssi_cnt >>= 1;
             }
+            metrics.rx_rssi_sum += rx_rssi;
+            metrics.rx_rssi_cnt++;
+            metrics.rx_rssi = (uint16_t)(metrics.rx_rssi_sum / metrics.rx_rssi_cnt);
         }
+#endif // BLE_METRICS
         rx_hdl = co_buf_rx_next(rx_hdl);
     }
 }
 
-#endif // BLE_METRICS
+#endif // BLE_METRICS || LINK_TELEMETRY || ADAPTIVE_TX_PWR
 
 uint32_t ble_finetim_corr __SECTION_ZERO("retention_mem_area0");
 
@@ -339,6 +357,11 @@ void lld_sleep_compensate_func(void)
 #if (USE_POWER_OPTIMIZATIONS)
     slp_period_retained = slp_period;
 
+#if (LINK_TELEMETRY)
+    link_telemetry_wakeup((sleep_lp_cycles && (sleep_lp_cycles < slp_period)) ?
+                          lld_sleep_lpcycles_2_us_sel_func(slp_period - sleep_lp_cycles) : 0);
+#endif
+
 #if (USE_XTAL16M_ADAPTIVE_SETTLING)
     if ((sleep_lp_cycles && (sleep_lp_cycles < slp_period)) && (!cal_failed))
     {
@@ -926,9 +949,9 @@ __STATIC_INLINE void dlg_finetgtim_isr(void)
  ***/
 __STATIC_INLINE void dlg_rx_isr(void)
 {
-#if (BLE_METRICS)
+#if (BLE_METRICS || LINK_TELEMETRY || ADAPTIVE_TX_PWR)
     update_ble_metrics(LLD_RX_IRQ_THRES);
-#endif // (BLE_METRICS)
+#endif // (BLE_METRICS || LINK_TELEMETRY || ADAPTIVE_TX_PWR)
 
     lld_evt_rx_isr();
 }
@@ -940,7 +963,7 @@ __STATIC_INLINE void dlg_event_isr(void)
 {
     DLG_EVENT_HANDLER_ENTER();
 
-#if (BLE_METRICS)
+#if (BLE_METRICS || LINK_TELEMETRY || ADAPTIVE_TX_PWR)
     {
         // Get the current event programmed
         struct ea_elt_tag *elt = (struct ea_elt_tag *)co_list_pick(&lld_evt_env.elt_prog);
@@ -951,8 +974,16 @@ __STATIC_INLINE void dlg_event_isr(void)
         uint8_t rx_cnt = ble_rxdesccnt_getf(evt->conhdl);
 
         update_ble_metrics(rx_cnt - evt->rx_cnt);
+
+#if (LINK_TELEMETRY)
+        link_telemetry_event_end(evt->conhdl, evt->counter, evt->interval, evt->latency, lld_evt_time_get());
+#endif
+
+#if (ADAPTIVE_TX_PWR)
+        adaptive_tx_pwr_event_end(evt->conhdl, evt->counter);
+#endif
     }
-#endif // (BLE_METRICS)
+#endif // (BLE_METRICS || LINK_TELEMETRY || ADAPTIVE_TX_PWR)
 
 #if defined (__DA14531_01__) || defined (__DA14535__)
     // fix included in ROM
@@ -279,6 +279,18 @@ extern uint32_t *rom_cfg_table;
 #define BLE_METRICS                                     0
 #endif
 
+#if defined(CFG_LINK_TELEMETRY)
+#define LINK_TELEMETRY                                  1
+#else
+#define LINK_TELEMETRY                                  0
+#endif
+
+#if defined(CFG_ADAPTIVE_TX_PWR)
+#define ADAPTIVE_TX_PWR                                 1
+#else
+#define ADAPTIVE_TX_PWR                                 0
+#endif
+
 #if defined(CFG_PRODUCTION_DEBUG_OUTPUT)
 #define PRODUCTION_DEBUG_OUTPUT                         1
 #else
@@ -432,6 +444,13 @@ extern uint32_t *rom_cfg_table;
 #define USE_XTAL32M_DYN_FREQ_TRIMMING                         (0)
 #endif
 
+// Applicable only to DA14531 family silicon
+#if defined (CFG_PREDICTIVE_CAL)
+#define USE_PREDICTIVE_CAL                                    (1)
+#else
+#define USE_PREDICTIVE_CAL                                    (0)
+#endif
+
 // Macro used to build the characterization s/w for the module (the chip connected to SPI flash memory).
 #if defined (CFG_CHARACTERIZATION_SW_FOR_MODULE)
 #define USE_CHARACTERIZATION_SW_FOR_MODULE                    (1)
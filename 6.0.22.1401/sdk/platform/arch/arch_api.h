@@ -384,6 +384,8 @@ typedef struct
     uint32_t    rx_err_crc;
     uint32_t    rx_err_sync;
     uint16_t    rx_rssi;
+    uint16_t    rx_rssi_cnt;    // Packets in rx_rssi_sum
+    uint32_t    rx_rssi_sum;    // Sum of the RSSI of the last rx_rssi_cnt packets
 }arch_ble_metrics_t;
 
 extern arch_ble_metrics_t            metrics;
@@ -95,6 +95,10 @@
 #include "wlan_coex.h"
 #endif
 
+#if defined (CFG_KE_MEM_PROF)
+#include "ke_mem_prof.h"
+#endif
+
 /**
  * @addtogroup DRIVERS
  * @{
@@ -530,6 +534,9 @@ __STATIC_INLINE void schedule_while_ble_on(void)
         }
         else
         {
+#if defined (CFG_KE_MEM_PROF)
+            ke_mem_prof_process();
+#endif
             arch_printf_process();
             break;
         }
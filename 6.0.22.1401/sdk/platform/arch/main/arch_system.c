@@ -94,6 +94,18 @@
 #include "spi_flash.h"
 #endif
 
+#if (LINK_TELEMETRY)
+#include "link_telemetry.h"
+#endif
+
+#if (ADAPTIVE_TX_PWR)
+#include "adaptive_tx_pwr.h"
+#endif
+
+#if (USE_PREDICTIVE_CAL)
+#include "cal_sched.h"
+#endif
+
 /*
  * DEFINES
  ****************************************************************************************
@@ -169,6 +181,15 @@ static const int16_t adc_min = -149;
 #endif // __DA14533__
 int8_t xtal32m_trim_last_temp   __SECTION_ZERO("retention_mem_area0");
 #endif
+#if (USE_PREDICTIVE_CAL)
+/// Temperature sampling schedule of the RF calibration and the XTAL32M trimming
+static cal_sched_t radio_cals_sched         __SECTION_ZERO("retention_mem_area0");
+/// Temperature sample of the application, waiting for conditionally_run_radio_cals()
+static bool radio_cals_pending              __SECTION_ZERO("retention_mem_area0");
+static int8_t radio_cals_pending_temp       __SECTION_ZERO("retention_mem_area0");
+static uint16_t radio_cals_pending_adc      __SECTION_ZERO("retention_mem_area0");
+static uint32_t radio_cals_pending_time     __SECTION_ZERO("retention_mem_area0");
+#endif
 #else
 uint16_t last_temp_count    __SECTION_ZERO("retention_mem_area0"); // temperature counter
 #endif
@@ -746,6 +767,122 @@ static uint8_t xtal32m_calc_trim(uint16_t adc_val)
 }
 #endif // USE_XTAL32M_DYN_FREQ_TRIMMING
 
+#if defined (__DA14531__) && !defined (__FPGA__)
+/// Radio calibrations run on temperature changes, in the bit order of cal_sched_sample()
+#define RADIO_CAL_RF            (0x01)
+#define RADIO_CAL_XTAL32M       (0x02)
+
+/**
+ ****************************************************************************************
+ * @brief Decide which radio calibrations must run at a die temperature sample. The
+ * first sample after a reset of the references only sets them.
+ * @param[in] current_temp  Die temperature
+ * @param[in] current_time  BLE time of the sample
+ * @return RADIO_CAL_RF and RADIO_CAL_XTAL32M bits
+ ****************************************************************************************
+ */
+static uint8_t radio_cals_check(int8_t current_temp, uint32_t current_time)
+{
+    uint8_t cals = 0;
+
+    if (rf_cal_last_temp == 127)
+    {
+        rf_cal_last_temp = current_temp;
+    }
+#if (USE_XTAL32M_DYN_FREQ_TRIMMING)
+    if (xtal32m_trim_last_temp == 127)
+    {
+        xtal32m_trim_last_temp = current_temp;
+    }
+#endif
+
+#if (USE_PREDICTIVE_CAL)
+#if (USE_XTAL32M_DYN_FREQ_TRIMMING)
+    const int8_t ref[] = {rf_cal_last_temp, xtal32m_trim_last_temp};
+    static const uint8_t diff[] = {CFG_CALIBRATION_TEMP_DIFF, CFG_XTAL32M_TRIM_TEMP_DIFF};
+#else
+    const int8_t ref[] = {rf_cal_last_temp};
+    static const uint8_t diff[] = {CFG_CALIBRATION_TEMP_DIFF};
+#endif
+
+    // Calibrate at the same thresholds, the scheduler only decides when to sample
+    cals = cal_sched_sample(&radio_cals_sched, current_temp, current_time, ref, diff, sizeof(diff));
+#else
+    int8_t calibration_temp_diff = current_temp - rf_cal_last_temp;
+
+    if (calibration_temp_diff < 0)
+    {
+        calibration_temp_diff = -calibration_temp_diff;
+    }
+
+    // Calibrate the RF if the temperature difference is greater than
+    // (or equal to) CFG_CALIBRATION_TEMP_DIFF degrees Celsius
+    if (calibration_temp_diff >= CFG_CALIBRATION_TEMP_DIFF)
+    {
+        cals |= RADIO_CAL_RF;
+    }
+#if (USE_XTAL32M_DYN_FREQ_TRIMMING)
+    int8_t xtal32m_trim_temp_diff = current_temp - xtal32m_trim_last_temp;
+
+    if (xtal32m_trim_temp_diff < 0)
+    {
+        xtal32m_trim_temp_diff = -xtal32m_trim_temp_diff;
+    }
+
+    if (xtal32m_trim_temp_diff >= CFG_XTAL32M_TRIM_TEMP_DIFF)
+    {
+        cals |= RADIO_CAL_XTAL32M;
+    }
+#endif // USE_XTAL32M_DYN_FREQ_TRIMMING
+#endif // USE_PREDICTIVE_CAL
+
+    return cals;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Run radio calibrations at a die temperature sample.
+ * @param[in] cals          RADIO_CAL_RF and RADIO_CAL_XTAL32M bits
+ * @param[in] current_temp  Die temperature
+ * @param[in] adc_raw_val   Raw GP ADC sample of the temperature sensor
+ ****************************************************************************************
+ */
+static void radio_cals_run(uint8_t cals, int8_t current_temp, uint16_t adc_raw_val)
+{
+    if (cals & RADIO_CAL_RF)
+    {
+        rf_cal_count++;
+        rf_recalibration();
+        rf_cal_last_temp = current_temp;
+    }
+#if (USE_XTAL32M_DYN_FREQ_TRIMMING)
+    if (cals & RADIO_CAL_XTAL32M)
+    {
+        clk_freq_trim_reg_value = xtal32m_calc_trim(adc_raw_val);
+        // Apply Trim value
+        SetWord16(CLK_FREQ_TRIM_REG, clk_freq_trim_reg_value);
+        xtal32m_trim_last_temp = current_temp;
+    }
+#endif
+}
+
+#if (USE_PREDICTIVE_CAL)
+void radio_cals_temp_sample(int8_t temp, uint16_t adc_raw)
+{
+    uint32_t current_time = lld_evt_time_get();
+
+    // A sample close to the previous one brings nothing
+    if (!radio_cals_pending && cal_sched_accepts(&radio_cals_sched, current_time))
+    {
+        radio_cals_pending_temp = temp;
+        radio_cals_pending_adc = adc_raw;
+        radio_cals_pending_time = current_time;
+        radio_cals_pending = true;
+    }
+}
+#endif
+#endif // __DA14531__ && !__FPGA__
+
 void conditionally_run_radio_cals(void)
 {
 #if !defined (__FPGA__)
@@ -758,10 +895,18 @@ void conditionally_run_radio_cals(void)
         last_time = 0;
     }
 
+#if (USE_PREDICTIVE_CAL)
+    // The references are reset on wake-up from hibernation
+    bool sample_due = radio_cals_pending || (rf_cal_last_temp == 127) ||
+                      cal_sched_due(&radio_cals_sched, current_time);
+#else
+    bool sample_due = ((current_time - last_time) >= 3200); //2 sec
+#endif
+
 #if (USE_RF_LDO_CALIBRATION)
-    if (((current_time - last_time) >= 3200) || rf_ldo_calibration_pending)
+    if (sample_due || rf_ldo_calibration_pending)
 #else
-    if ((current_time - last_time) >= 3200) //2 sec
+    if (sample_due)
 #endif
     {
 #if (USE_RF_LDO_CALIBRATION)
@@ -771,6 +916,17 @@ void conditionally_run_radio_cals(void)
             rf_recalibration();
         }
         else
+#endif
+#if (USE_PREDICTIVE_CAL)
+        if (radio_cals_pending)
+        {
+            // The sample of the application saves a GP ADC conversion
+            radio_cals_pending = false;
+            last_time = current_time;
+            radio_cals_run(radio_cals_check(radio_cals_pending_temp, radio_cals_pending_time),
+                           radio_cals_pending_temp, radio_cals_pending_adc);
+        }
+        else
 #endif
         {
             last_time = current_time;
@@ -800,54 +956,12 @@ void conditionally_run_radio_cals(void)
             int8_t current_temp = adc_get_temp();
 #if (USE_XTAL32M_DYN_FREQ_TRIMMING)
             uint16_t adc_raw_val = adc_get_sample();
+#else
+            uint16_t adc_raw_val = 0;
 #endif
             adc_load_offsets();
 
-            if (rf_cal_last_temp == 127)
-            {
-                rf_cal_last_temp = current_temp;
-            }
-            else
-            {
-                int8_t calibration_temp_diff = current_temp - rf_cal_last_temp;
-
-                if (calibration_temp_diff < 0)
-                {
-                    calibration_temp_diff = -calibration_temp_diff;
-                }
-
-                if (calibration_temp_diff >= CFG_CALIBRATION_TEMP_DIFF)
-                {
-                    // Calibrate the RF if the temperature difference is greater than
-                    // (or equal to) CFG_CALIBRATION_TEMP_DIFF degrees Celsius
-                    rf_cal_count++;
-                    rf_recalibration();
-                    rf_cal_last_temp = current_temp;
-                }
-            }
-#if (USE_XTAL32M_DYN_FREQ_TRIMMING)
-            if (xtal32m_trim_last_temp == 127)
-            {
-                xtal32m_trim_last_temp = current_temp;
-            }
-            else
-            {
-                int8_t xtal32m_trim_temp_diff = current_temp - xtal32m_trim_last_temp;
-
-                if (xtal32m_trim_temp_diff < 0)
-                {
-                    xtal32m_trim_temp_diff = -xtal32m_trim_temp_diff;
-                }
-
-                if (xtal32m_trim_temp_diff >= CFG_XTAL32M_TRIM_TEMP_DIFF)
-                {
-                    clk_freq_trim_reg_value = xtal32m_calc_trim(adc_raw_val);
-                    // Apply Trim value
-                    SetWord16(CLK_FREQ_TRIM_REG, clk_freq_trim_reg_value);
-                    xtal32m_trim_last_temp = current_temp;
-                }
-            }
-#endif // USE_XTAL32M_DYN_FREQ_TRIMMING
+            radio_cals_run(radio_cals_check(current_temp, current_time), current_temp, adc_raw_val);
 
             // Restore the content of the ADC CTRL and SEL registers
             SetWord16(GP_ADC_CTRL2_REG, tmp_adc_ctrl2_reg);
@@ -1550,6 +1664,14 @@ void system_init(void)
      */
     ble_init(_ble_base);
 
+#if (LINK_TELEMETRY)
+    link_telemetry_init(rwip_rf.rssi_convert);
+#endif
+
+#if (ADAPTIVE_TX_PWR)
+    adaptive_tx_pwr_init(rwip_rf.rssi_convert);
+#endif
+
 #if (USE_RANGE_EXT)
     // Enable range extender
     range_ext.enable(MAX_POWER, NULL);
@@ -169,6 +169,22 @@ uint16_t get_rc16m_count(void);
  *****************************************************************************************
  */
 void conditionally_run_radio_cals(void);
+
+#if defined (__DA14531__) && (USE_PREDICTIVE_CAL)
+/**
+ ****************************************************************************************
+ * @brief Pass a die temperature sample taken by the application to the radio
+ * calibrations. It replaces the next GP ADC conversion of conditionally_run_radio_cals()
+ * if at least half of the sampling interval has elapsed, and is ignored otherwise.
+ * @note The sample must be taken as conditionally_run_radio_cals() does: single ended
+ * ADC_INPUT_SE_TEMP_SENS input with the offsets reset. Not to be called from interrupts.
+ * @param[in] temp      Die temperature, as returned by adc_get_temp()
+ * @param[in] adc_raw   Raw sample, as returned by adc_get_sample(), for the XTAL32M
+ *                      trimming
+ ****************************************************************************************
+ */
+void radio_cals_temp_sample(int8_t temp, uint16_t adc_raw);
+#endif
 #endif // (__NON_BLE_EXAMPLE__)
 
 #if !defined (__DA14531__)
@@ -62,17 +62,38 @@
 
 #endif // USE_UART_SDK
 
+#define PRINT_SZ 256
+
+#if defined (CFG_PRINTF_RING_BUFFER)
+
+#define RING_MASK   (CFG_PRINTF_RING_BUFFER_SIZE - 1)
+
+#if ((CFG_PRINTF_RING_BUFFER_SIZE & RING_MASK) != 0) || (CFG_PRINTF_RING_BUFFER_SIZE > 32768)
+    #error "CFG_PRINTF_RING_BUFFER_SIZE must be a power of two, not larger than 32768."
+#endif
+
+static uint8_t console_ring[CFG_PRINTF_RING_BUFFER_SIZE]; // not retained - system is kept active until it is drained
+static uint16_t ring_head               __SECTION_ZERO("retention_mem_area0"); // free running write index
+static uint16_t ring_tail               __SECTION_ZERO("retention_mem_area0"); // free running read index
+static uint16_t ring_tx_len             __SECTION_ZERO("retention_mem_area0"); // length of the span being sent
+static uint32_t ring_dropped            __SECTION_ZERO("retention_mem_area0");
+
+#else
+
 static printf_msg *printf_msg_list      __SECTION_ZERO("retention_mem_area0");
 static bool defer_sending               __SECTION_ZERO("retention_mem_area0");
 
-#define PRINT_SZ 256
-
 static char current_msg_buffer[PRINT_SZ]; // not retained - flushed at end of each main loop iteration
 static uint8_t current_msg_offset       __SECTION_ZERO("retention_mem_area0");
+
+#endif // CFG_PRINTF_RING_BUFFER
+
 static volatile bool uart_busy          __SECTION_ZERO("retention_mem_area0");
 
 #if !defined (__DA14531__) || defined (__EXCLUDE_ROM_ARCH_CONSOLE__)
 
+#if !defined (CFG_PRINTF_RING_BUFFER)
+
 /*
  * List management functions
  */
@@ -137,6 +158,7 @@ static int delete_msg(printf_msg *node)
 
     return 1;
 }
+#endif // CFG_PRINTF_RING_BUFFER
 
 
 /*
@@ -152,6 +174,7 @@ static uint32_t arch_strlen(const char *s)
     return length;
 }
 
+#if !defined (CFG_PRINTF_DEFERRED)
 
 static uint32_t arch_itoa(int32_t value, uint32_t radix, uint32_t uppercase,
                           char *buf, int32_t pad)
@@ -361,6 +384,286 @@ static int32_t arch_snprintf(char* buffer, uint32_t buffer_len, const char *fmt,
     return ret;
 }
 
+#else
+
+__STATIC_INLINE void put_le32(uint8_t *p, uint32_t val)
+{
+    p[0] = (uint8_t) val;
+    p[1] = (uint8_t)(val >> 8);
+    p[2] = (uint8_t)(val >> 16);
+    p[3] = (uint8_t)(val >> 24);
+}
+
+/*
+ * Builds a deferred printf record. The format string is parsed exactly like
+ * arch_vsnprintf() does, but only the arguments are stored.
+ */
+static int32_t arch_vencode(uint8_t *buffer, uint32_t buffer_len, const char *fmt, va_list va)
+{
+    uint8_t *pbuffer = buffer + ARCH_PRINTF_DEFERRED_HDR_LEN;
+    uint8_t *end = buffer + buffer_len;
+    const char *fmt_id = fmt;
+    char ch;
+
+    while ((ch = *(fmt++)) != '\0')
+    {
+        if (ch != '%')
+            continue;
+
+        ch = *(fmt++);
+
+        /* Zero padding requested */
+        if (ch == '0')
+        {
+            ch = *(fmt++);
+            if (ch == '\0')
+                break;
+            ch = *(fmt++);
+        }
+
+        if (ch == 'l' || ch == 'h')
+            ch = *(fmt++);
+
+        switch (ch) {
+        case 0:
+            goto end;
+
+        case 'i':
+        case 'd':
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'c':
+        {
+            uint32_t val = va_arg(va, uint32_t);
+
+            if (end - pbuffer < 4)
+                goto end;
+
+            put_le32(pbuffer, val);
+            pbuffer += 4;
+            break;
+        }
+
+        case 's':
+        {
+            const char *ptr = va_arg(va, const char*);
+            uint32_t len = arch_strlen(ptr);
+
+            if (end - pbuffer < 1)
+                goto end;
+
+            if (len > (uint32_t)(end - pbuffer - 1))
+                len = end - pbuffer - 1;
+            if (len > 0xFF)
+                len = 0xFF;
+
+            *(pbuffer++) = (uint8_t) len;
+            memcpy(pbuffer, ptr, len);
+            pbuffer += len;
+            break;
+        }
+
+        default:
+            // Unsupported conversion - the decoder reports it
+            break;
+        }
+    }
+end:
+    buffer[0] = ARCH_PRINTF_DEFERRED_MARKER;
+    put_le32(&buffer[1], (uint32_t)(uintptr_t) fmt_id);
+    buffer[5] = (uint8_t)(pbuffer - buffer - ARCH_PRINTF_DEFERRED_HDR_LEN);
+
+    return pbuffer - buffer;
+}
+
+#endif // CFG_PRINTF_DEFERRED
+
+#if defined (CFG_PRINTF_RING_BUFFER)
+
+/*
+ * Ring buffer functions
+ */
+
+// copy a complete message to the ring - callable from any context
+static bool ring_put(const uint8_t *data, uint16_t len)
+{
+    bool stored = false;
+
+    GLOBAL_INT_DISABLE();
+
+    if ((uint16_t)(CFG_PRINTF_RING_BUFFER_SIZE - (uint16_t)(ring_head - ring_tail)) >= len)
+    {
+        uint16_t idx = ring_head & RING_MASK;
+        uint16_t first = CFG_PRINTF_RING_BUFFER_SIZE - idx;
+
+        if (first > len)
+            first = len;
+
+        memcpy(&console_ring[idx], data, first);
+        memcpy(console_ring, data + first, len - first);
+        ring_head += len;
+        stored = true;
+    }
+    else
+    {
+        ring_dropped++;
+    }
+
+    GLOBAL_INT_RESTORE();
+
+    return stored;
+}
+
+static void uart_callback(uint8_t res);
+
+// send the oldest contiguous span of the ring
+static void ring_send(void)
+{
+    uint16_t idx = ring_tail & RING_MASK;
+    uint16_t len = ring_head - ring_tail;
+
+    if (len > CFG_PRINTF_RING_BUFFER_SIZE - idx)
+        len = CFG_PRINTF_RING_BUFFER_SIZE - idx;
+
+    ring_tx_len = len;
+    uart_busy = true;
+
+#if USE_UART1_ROM
+    uart_write(&console_ring[idx], len, uart_callback);
+#else
+    uart_send(UART, &console_ring[idx], len, UART_OP);
+#endif
+}
+
+/* Note: App should not modify the sleep mode until all messages have been printed out */
+static void uart_callback(uint8_t res)
+{
+    ring_tail += ring_tx_len;
+    ring_tx_len = 0;
+
+    uart_busy = false;
+
+#if USE_UART1_ROM
+    uart_finish_transfers();
+#else
+    uart_wait_tx_finish(UART);
+#endif
+
+    if (ring_head != ring_tail)
+    {
+        ring_send();
+    }
+    else
+    {
+        arch_restore_sleep_mode();
+    }
+}
+
+void arch_printf_flush(void)
+{
+    bool start = false;
+
+    // Critical section
+    GLOBAL_INT_DISABLE();
+
+    if (!uart_busy && (ring_head != ring_tail))
+    {
+        uart_busy = true;
+        start = true;
+    }
+
+    // End of critical section
+    GLOBAL_INT_RESTORE();
+
+    if (start)
+    {
+        arch_force_active_mode();
+#if !USE_UART1_ROM
+        uart_register_tx_cb(UART, (uart_cb_t) uart_callback);
+#endif
+        ring_send();
+    }
+}
+
+uint32_t arch_printf_dropped(void)
+{
+    return ring_dropped;
+}
+
+bool arch_printf_write(const uint8_t *data, uint16_t len)
+{
+    return ring_put(data, len);
+}
+
+void arch_printf_drain(void)
+{
+    GLOBAL_INT_DISABLE();
+
+    if (uart_busy)
+    {
+#if USE_UART_SDK && UART_DMA_SUPPORT
+        // The DMA transfer in flight completes without the CPU
+        while (dma_channel_active());
+        ring_tail += ring_tx_len;
+#endif
+        // An interrupt driven transfer in flight cannot progress. Its span is sent again
+        // from the start. The pending callback finds nothing more to release.
+        ring_tx_len = 0;
+    }
+
+    while (ring_head != ring_tail)
+    {
+        uint16_t idx = ring_tail & RING_MASK;
+        uint16_t len = ring_head - ring_tail;
+
+        if (len > CFG_PRINTF_RING_BUFFER_SIZE - idx)
+            len = CFG_PRINTF_RING_BUFFER_SIZE - idx;
+
+#if USE_UART1_ROM
+        uart_write_buffer(UART1, &console_ring[idx], len);
+#else
+        uart_send(UART, &console_ring[idx], len, UART_OP_BLOCKING);
+#endif
+        ring_tail += len;
+    }
+
+#if USE_UART1_ROM
+    uart_wait_tx_finish(UART1);
+#else
+    // Ends the interrupt driven transfer in flight, if any: its isr finds no byte left
+    uart_send(UART, console_ring, 0, UART_OP_BLOCKING);
+    uart_wait_tx_finish(UART);
+#endif
+
+    GLOBAL_INT_RESTORE();
+}
+
+int arch_vprintf(const char *fmt, va_list args)
+{
+    char my_buf[PRINT_SZ];
+
+#if defined (CFG_PRINTF_DEFERRED)
+    int32_t written = arch_vencode((uint8_t *)my_buf, sizeof(my_buf), fmt, args);
+#else
+    int32_t written = arch_snprintf(my_buf, sizeof(my_buf), fmt, args);
+#endif
+
+    if (written > 0)
+    {
+        ring_put((uint8_t *)my_buf, written);
+    }
+
+    return 1;
+}
+
+void arch_printf_process(void)
+{
+    arch_printf_flush();
+}
+
+#else
+
 /* Note: App should not modify the sleep mode until all messages have been printed out */
 static void uart_callback(uint8_t res)
 {
@@ -423,17 +726,6 @@ void arch_printf_flush(void)
     current_msg_offset = 0;
 }
 
-int arch_printf(const char *fmt, ...)
-{
-    va_list args;
-
-    va_start(args, fmt);
-    int res = arch_vprintf(fmt, args);
-    va_end(args);
-
-    return res;
-}
-
 int arch_vprintf(const char *fmt, va_list args)
 {
     char my_buf[PRINT_SZ];
@@ -456,11 +748,6 @@ int arch_vprintf(const char *fmt, va_list args)
     return 1;
 }
 
-void arch_puts(const char *s)
-{
-    arch_printf("%s", s);
-}
-
 void arch_printf_process(void)
 {
     // Submit pending message
@@ -485,6 +772,24 @@ void arch_printf_process(void)
     }
 }
 
+#endif // CFG_PRINTF_RING_BUFFER
+
+int arch_printf(const char *fmt, ...)
+{
+    va_list args;
+
+    va_start(args, fmt);
+    int res = arch_vprintf(fmt, args);
+    va_end(args);
+
+    return res;
+}
+
+void arch_puts(const char *s)
+{
+    arch_printf("%s", s);
+}
+
 #else
 
 static void uart_write_adapt(uint8_t *bufptr, uint32_t size, void (*callback) (uint8_t))
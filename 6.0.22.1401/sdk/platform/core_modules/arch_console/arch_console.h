@@ -46,6 +46,56 @@
 #include <stdarg.h>
 #include "compiler.h"
 
+/*
+ * Ring buffer backend (CFG_PRINTF_RING_BUFFER)
+ *
+ * Messages are copied into a statically allocated ring buffer instead of being
+ * queued as heap allocated nodes. arch_printf() may be called from interrupt
+ * context. arch_printf_process() hands the oldest contiguous span of the ring to the
+ * UART (DMA if available) and the UART callback keeps draining it until it is empty.
+ * Messages that do not fit in the ring are dropped.
+ *
+ * Deferred formatting (CFG_PRINTF_DEFERRED)
+ *
+ * Requires CFG_PRINTF_RING_BUFFER. arch_printf() does not format the message. It
+ * stores a binary record that holds the address of the format string and the raw
+ * arguments. The record is expanded on the host by utilities/log_decoder using the
+ * binary image of the application.
+ *
+ * Record layout (little endian):
+ *   [0]     ARCH_PRINTF_DEFERRED_MARKER
+ *   [1..4]  address of the format string
+ *   [5]     payload length
+ *   [6..]   payload. Four bytes for each %d, %i, %u, %x, %X and %c argument.
+ *           A length byte followed by the characters for each %s argument.
+ */
+#if defined (CFG_PRINTF_RING_BUFFER)
+
+#if defined (__DA14531__) && !defined (__EXCLUDE_ROM_ARCH_CONSOLE__)
+    #error "CFG_PRINTF_RING_BUFFER requires __EXCLUDE_ROM_ARCH_CONSOLE__ to be defined."
+#endif
+
+/// Ring buffer size in bytes. It must be a power of two and not larger than 32768.
+#ifndef CFG_PRINTF_RING_BUFFER_SIZE
+#define CFG_PRINTF_RING_BUFFER_SIZE         (1024)
+#endif
+
+#endif // CFG_PRINTF_RING_BUFFER
+
+#if defined (CFG_PRINTF_DEFERRED)
+
+#if !defined (CFG_PRINTF_RING_BUFFER)
+    #error "CFG_PRINTF_DEFERRED requires CFG_PRINTF_RING_BUFFER to be defined."
+#endif
+
+/// First byte of a deferred printf record
+#define ARCH_PRINTF_DEFERRED_MARKER         (0x1E)
+
+/// Length of the deferred printf record header
+#define ARCH_PRINTF_DEFERRED_HDR_LEN        (6)
+
+#endif // CFG_PRINTF_DEFERRED
+
 /// Print message node
 typedef struct __print_msg {
     /// Pointer to the next message
@@ -110,10 +160,47 @@ int arch_printf(const char *fmt, ...);
 /**
  ****************************************************************************************
  * @brief Flush printf.
+ * @note With CFG_PRINTF_RING_BUFFER the messages are already queued in the ring buffer,
+ *       so this function only starts the transmission if the UART is idle.
  ****************************************************************************************
  */
 void arch_printf_flush(void);
 
+#if defined (CFG_PRINTF_RING_BUFFER)
+/**
+ ****************************************************************************************
+ * @brief Get the number of messages dropped because the ring buffer was full.
+ * @return Number of dropped messages
+ ****************************************************************************************
+ */
+uint32_t arch_printf_dropped(void);
+
+/**
+ ****************************************************************************************
+ * @brief Queue a binary record in the ring buffer. May be called from interrupt context.
+ * @param[in] data   Record
+ * @param[in] len    Record length
+ * @return True if the record was queued, false if it was dropped because the ring
+ *         buffer was full
+ * @note The record is sent as is, between the printf messages. Its first byte must be a
+ *       marker that does not appear in the text, so that the host can extract it.
+ ****************************************************************************************
+ */
+bool arch_printf_write(const uint8_t *data, uint16_t len);
+
+/**
+ ****************************************************************************************
+ * @brief Send the contents of the ring buffer with blocking UART writes and return when
+ *        the UART has sent the last byte. May be called from interrupt context.
+ * @note Interrupts are disabled until the ring buffer is empty, which takes about 90 ms
+ *       for a full 1 KB ring at 115200 baud. Meant for the last output before the system
+ *       halts. A transfer that was in progress is sent again from the start, except
+ *       with DMA.
+ ****************************************************************************************
+ */
+void arch_printf_drain(void);
+#endif
+
 /**
  ****************************************************************************************
  * @brief This function is called periodically from the main loop to
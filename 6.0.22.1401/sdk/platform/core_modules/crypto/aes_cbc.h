@@ -41,6 +41,14 @@
 #ifndef AES_CBC_H_
 #define AES_CBC_H_
 
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stdint.h>
+#include "aes_engine.h"
+
 /*
  * DEFINES
  ****************************************************************************************
@@ -57,8 +65,25 @@
 /// Status codes
 enum
 {
-    AES_CBC_ERR_NO_ERR,
-    AES_CBC_ERR_INVALID_PARAM,
+    AES_CBC_ERR_NO_ERR          = AES_ENGINE_ERR_NO_ERR,
+    AES_CBC_ERR_INVALID_PARAM   = AES_ENGINE_ERR_INVALID_PARAM,
+    AES_CBC_ERR_BUSY            = AES_ENGINE_ERR_BUSY,
+    AES_CBC_ERR_NOT_SUPPORTED   = AES_ENGINE_ERR_NOT_SUPPORTED,
+};
+
+/*
+ * STRUCTURES
+ ****************************************************************************************
+ */
+
+/// CBC context, for data processed in several calls with the same key
+struct aes_cbc_ctx
+{
+    /// Engine context holding the expanded key
+    struct aes_engine eng;
+
+    /// Chaining value: the IV, then the last ciphertext block
+    uint8_t iv[AES_CBC_BLK_SIZE];
 };
 
 /*
@@ -105,6 +130,35 @@ uint8_t aes_cbc_decrypt(const uint8_t *blocks_128, uint8_t *out_blocks_128,
                         const uint8_t block_count, const uint8_t *key,
                         const uint8_t key_size, const uint8_t *IV_128);
 
+/**
+ ****************************************************************************************
+ * @brief Set up a CBC context. The key is expanded once for all the following
+ * aes_cbc_update() calls.
+ * @param[out] ctx              CBC context
+ * @param[in] key               Key
+ * @param[in] key_size          Key length (in bytes)
+ * @param[in] IV_128            Input vector for 128-bit data block cypher, NULL for zero
+ * @param[in] enc_dec           AES_ENCRYPT or AES_DECRYPT
+ * @return                      error code if something goes wrong, 0 otherwise
+ ****************************************************************************************
+ */
+uint8_t aes_cbc_init(struct aes_cbc_ctx *ctx, const uint8_t *key, const uint8_t key_size,
+                     const uint8_t *IV_128, uint8_t enc_dec);
+
+/**
+ ****************************************************************************************
+ * @brief Encrypt or decrypt the next blocks of a CBC stream.
+ * @param[in] ctx               CBC context
+ * @param[in] blocks_128        Input data blocks
+ * @param[out] out_blocks_128   Output data blocks, may be equal to blocks_128. When
+ * encrypting, NULL keeps only the last ciphertext block in ctx->iv (CBC-MAC mode).
+ * @param[in] block_count       Number of blocks
+ * @return                      error code if something goes wrong, 0 otherwise
+ ****************************************************************************************
+ */
+uint8_t aes_cbc_update(struct aes_cbc_ctx *ctx, const uint8_t *blocks_128,
+                       uint8_t *out_blocks_128, uint32_t block_count);
+
 /**
  ****************************************************************************************
  * @brief Calculate number of blocks given the payload size.
@@ -53,9 +53,6 @@
  ****************************************************************************************
  */
 
-#define HW_ENCODE 1
-#define HW_DECODE 0
-
 // Flags for input data formatting
 // [Sec. A.2.1 in NIST_SP_800-38C]
 #define CCM_FLAG_Q
@@ -94,48 +91,20 @@
 
 #define CCM_FLAG_SET(dst, flag, value) (dst = (dst & ~(flag##_MASK << flag##_OFFSET)) | ((value & flag##_MASK) << flag##_OFFSET))
 
-/*
- * STRUCTURES
- ****************************************************************************************
- */
-
-// Associated data encoding struct
+// Associated data lengths from this value on are encoded in 6 bytes
 // [Sec. A.2.2 in NIST_SP_800-38C]
-struct Alen_encoding2 {
-    uint8_t data[2];
-};
-
-struct Alen_encoding6 {
-    uint8_t magic[2];
-    uint8_t data[4];
-};
-
-struct Alen_encoding10 {
-    uint8_t magic[2];
-    uint8_t data[8];
-};
-
-union Alen_encoding {
-    struct Alen_encoding2 alen2;
-    struct Alen_encoding6 alen6;
-    struct Alen_encoding10 alen10;
-};
+#define CCM_ADATA_LEN_ENC6      (0xFF00)
 
 /*
  * GLOBAL VARIABLE DEFINITIONS
  ****************************************************************************************
  */
 
-// Data block
-struct aes_ccm_env_tag AES128_ccm_blk;
-
-// Memory block allocation
-uint8_t blk_mem_type        __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+// Context of aes_ccm_encrypt() and aes_ccm_decrypt()
+struct aes_ccm_ctx AES128_ccm_ctx;
 
 // Length of Auth Bytes (TAG/MAC), options are 4,6,8,10,12,14 and 16
 uint8_t CCM_T               __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
-// Length of the encoded Plain Text length field, options are 2~8
-uint8_t CCM_Q               __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
 // The nonce length
 uint8_t CCM_N               __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
 
@@ -149,489 +118,469 @@ uint8_t key_aes[KEY_LEN]    __SECTION_ZERO("retention_mem_area0"); //@RETENTION
 
 /**
  ****************************************************************************************
- * @brief AES Encryption
- * @param[in] input     Plain data to be encrypted
- * @param[out] output   Encrypted Data
- * @param[in] size      Data length
+ * @brief Write a value in big endian order
+ * @param[out] dest         Destination buffer
+ * @param[in] value         Value to encode
+ * @param[in] bytecount     Number of bytes, leading bytes beyond 4 are zeroed
  ****************************************************************************************
  */
-static void aes_encrypt(uint8_t *input, uint8_t *output, uint16_t size)
+static void aes_ccm_put_be(uint8_t *dest, uint32_t value, uint8_t bytecount)
 {
-    uint8_t num_blk = aes_get_blk_num(size);
-
-    aes_cbc_encrypt(input, num_blk, output, num_blk, key_aes, sizeof(key_aes), NULL);
+    while (bytecount)
+    {
+        dest[--bytecount] = (uint8_t) value;
+        value >>= 8;
+    }
 }
 
 /**
  ****************************************************************************************
- * @brief Set AES key for later use
- * @param[in] key   key to be used, should be 16 bytes
+ * @brief Add the buffered partial block, zero padded, to the CBC-MAC
+ * @param[in,out] ctx       CCM context
+ * @return                  AES_CCM_ERR_NO_ERR on success, error code otherwise
  ****************************************************************************************
  */
-__STATIC_INLINE void aes_key_init(uint8_t *key)
+static uint8_t aes_ccm_mac_flush(struct aes_ccm_ctx *ctx)
 {
-    memcpy(&key_aes, key, 16);
+    uint8_t status = AES_CCM_ERR_NO_ERR;
+
+    if (ctx->buf_len)
+    {
+        memset(&ctx->buf[ctx->buf_len], 0, CCM_BLK_SIZE - ctx->buf_len);
+        status = aes_engine_encrypt(&ctx->eng, ctx->buf, NULL, 1, ctx->mac);
+        ctx->buf_len = 0;
+    }
+
+    return status;
 }
 
 /**
  ****************************************************************************************
- * @brief Allocate data blocks
- * @param[out] dest             pointer to store allocated blocks
- * @param[in] old_blk_count     current number of blocks
- * @param[in] new_blk_count     new number of blocks
+ * @brief Generate the next key stream block and increment the counter
+ * @param[in,out] ctx       CCM context
+ * @return                  AES_CCM_ERR_NO_ERR on success, error code otherwise
  ****************************************************************************************
  */
-static void blk_malloc(uint8_t (**dest)[CCM_BLK_SIZE], uint8_t old_blk_count,
-                       uint8_t new_blk_count)
+static uint8_t aes_ccm_next_ks(struct aes_ccm_ctx *ctx)
 {
-    // Free old buffer if larger one is needed
-    if (*dest != NULL)
+    uint8_t status = aes_engine_encrypt(&ctx->eng, ctx->ctr, ctx->ks, 1, NULL);
+
+    // Increment the counter field (big endian, last q bytes)
+    for (uint8_t i = CCM_BLK_SIZE - 1; i >= CCM_BLK_SIZE - ctx->q; i--)
     {
-        if (old_blk_count < new_blk_count)
+        if (++ctx->ctr[i])
         {
-            ke_free(*dest);
-            *dest = ke_malloc(new_blk_count * CCM_BLK_SIZE, blk_mem_type);
+            break;
         }
     }
-    else
-    {
-        *dest = ke_malloc(new_blk_count * CCM_BLK_SIZE, blk_mem_type);
-    }
 
-    memset(*dest, 0, new_blk_count * CCM_BLK_SIZE);
+    return status;
 }
 
 /**
  ****************************************************************************************
- * @brief Format associated data block
- * @param[in] blk           Predefined AES_CCM structure,
- * @param[in] adata         Associated data,
- * @param[in] adata_len     Associated data length.
+ * @brief End the associated data before the payload or the tag
+ * @param[in,out] ctx       CCM context
+ * @return                  AES_CCM_ERR_NO_ERR on success, error code otherwise
  ****************************************************************************************
  */
-__STATIC_INLINE void aes_format_ccm_adata(struct aes_ccm_env_tag *blk, const uint8_t *adata,
-                                        const uint64_t adata_len)
+static uint8_t aes_ccm_enter_payload(struct aes_ccm_ctx *ctx)
 {
-    union Alen_encoding *alenc;
-    uint8_t enclen;
+    if (ctx->payload_phase)
+    {
+        return AES_CCM_ERR_NO_ERR;
+    }
 
-    // Length for adata length encoding
-    // [Sec. A.2.2 in NIST_SP_800-38C]
-    enclen = adata_len < 65280 ? 2 : adata_len < 4294967296 ? 6 : 10;
+    if (ctx->adata_left)
+    {
+        return AES_CCM_ERR_INVALID_PARAM;
+    }
 
-    // Encode the Adata length
-    // [Sec. A.2.2 in NIST_SP_800-38C]
-    switch (enclen) {
-    case 2:
-        blk_malloc(&(blk->adata_blk), blk->adata_blk_cnt,
-                   aes_get_blk_num(adata_len + enclen));
-        alenc = (union Alen_encoding *) blk->adata_blk;
-
-        // Encoding in 2 bytes
-        memcpy(&(alenc->alen2.data[0]), (uint8_t *) &adata_len + 1, 1);
-        memcpy(&(alenc->alen2.data[1]), &adata_len, 1);
-        break;
-
-    case 6:
-        ASSERT_ERROR(0);
-        break;
-
-    case 10:
-        ASSERT_ERROR(0);
-        break;
-
-#if 0 // left for reference only - we support up to 255 blocks -> 4080 bytes
-    case 6:
-        blk_malloc(&(blk->adata_blk), blk->adata_blk_cnt,
-                   aes_get_blk_num(adata_len + enclen));
-        alenc = (union Alen_encoding *) blk->adata_blk;
-
-        // 2 Magic bytes
-        SetWord8(&(alenc->alen6.magic[0]), 0xff);
-        SetWord8(&(alenc->alen6.magic[1]), 0xfe);
-
-        // Encoding in 4 bytes
-        memcpy(&(alenc->alen6.data[0]), (uint8_t *) &adata_len + 3, 1);
-        memcpy(&(alenc->alen6.data[1]), (uint8_t *) &adata_len + 2, 1);
-        memcpy(&(alenc->alen6.data[2]), (uint8_t *) &adata_len + 1, 1);
-        memcpy(&(alenc->alen6.data[3]), &adata_len, 1);
-        break;
-
-    case 10:
-        blk_malloc(&(blk->adata_blk), blk->adata_blk_cnt,
-                   aes_get_blk_num(adata_len + enclen));
-        alenc = (union Alen_encoding *) blk->adata_blk;
-
-        // 2 Magic bytes
-        SetWord8(&(alenc->alen10.magic[0]), 0xff);
-        SetWord8(&(alenc->alen10.magic[1]), 0xff);
-
-        // Encoding in 8 bytes
-        memcpy(&(alenc->alen10.data[0]), (uint8_t *) &adata_len + 7, 1);
-        memcpy(&(alenc->alen10.data[1]), (uint8_t *) &adata_len + 6, 1);
-        memcpy(&(alenc->alen10.data[2]), (uint8_t *) &adata_len + 5, 1);
-        memcpy(&(alenc->alen10.data[3]), (uint8_t *) &adata_len + 4, 1);
-        memcpy(&(alenc->alen10.data[4]), (uint8_t *) &adata_len + 3, 1);
-        memcpy(&(alenc->alen10.data[5]), (uint8_t *) &adata_len + 2, 1);
-        memcpy(&(alenc->alen10.data[6]), (uint8_t *) &adata_len + 1, 1);
-        memcpy(&(alenc->alen10.data[7]), &adata_len, 1);
-        break;
-#endif
-    }
-
-    // Concatenate Adata
-    memcpy(((uint8_t*) blk->adata_blk) + enclen, adata, adata_len);
-
-    // Update data length and block count
-    blk->adata_len = adata_len + enclen;
-    blk->adata_blk_cnt = aes_get_blk_num(blk->adata_len);
+    ctx->payload_phase = true;
+
+    return aes_ccm_mac_flush(ctx);
 }
 
 /**
- *****************************************************************************************
- * @brief Set up AES CCM operation parameters
- * @param[in] blk           Predefined AES_CCM structure
- * @param[in] payload       Data to be encrypted/decrypted
- * @param[in] payload_len   payload length in bytes,up to 32
- * @param[in] Nonce         Nonce array, should be unique for each AES-CCM operation
- * @param[in] Adata         Adata, or header, up to 32 bytes
- * @param[in] Adata_len     Adata length in bytes, up to 32
- * @param[in] type          choose ENCRYPT_PROCESS or DECRYPT_PROCESS
+ ****************************************************************************************
+ * @brief Compute the tag: CBC-MAC of the last block, encrypted with the counter 0 block
+ * @param[in,out] ctx       CCM context
+ * @param[out] tag          Tag, T bytes
+ * @return                  AES_CCM_ERR_NO_ERR on success, error code otherwise
  ****************************************************************************************
  */
-static void aes_set_ccm_param(struct aes_ccm_env_tag *blk, uint8_t *payload,
-                              uint16_t payload_len, uint8_t *Nonce, uint8_t *Adata,
-                              uint16_t Adata_len, uint8_t type)
+static uint8_t aes_ccm_tag(struct aes_ccm_ctx *ctx, uint8_t *tag)
 {
-    // Set payload and nonce const pointers
-    blk->payload_input = payload;
-    blk->Nonce = Nonce;
+    uint8_t status = aes_ccm_enter_payload(ctx);
 
-    if (Adata)
+    if (status != AES_CCM_ERR_NO_ERR)
     {
-        aes_format_ccm_adata(blk, Adata, Adata_len);
+        return status;
     }
 
-    if (type == ENCRYPT_PROCESS)
+    if (ctx->payload_left)
     {
-        blk->payload_len = payload_len;
-        blk->payload_blk_cnt = aes_get_blk_num(payload_len);
+        return AES_CCM_ERR_INVALID_PARAM;
     }
-    else
+
+    status = aes_ccm_mac_flush(ctx);
+    if (status != AES_CCM_ERR_NO_ERR)
     {
-        blk->payload_len = payload_len - CCM_T;
-        blk->payload_blk_cnt = aes_get_blk_num(blk->payload_len);
+        return status;
     }
+
+    // S0 [Sec. 6.1 in NIST_SP_800-38C, step 8]
+    memset(&ctx->ctr[CCM_BLK_SIZE - ctx->q], 0, ctx->q);
+    status = aes_engine_encrypt(&ctx->eng, ctx->ctr, ctx->ks, 1, NULL);
+
+    aes_array_xor(ctx->mac, ctx->ks, ctx->t, tag);
+
+    return status;
 }
 
-/**
- ****************************************************************************************
- * @brief Format payload length in Q number of bytes
- * @param[out] dest         Destination buffer,
- * @param[in] source        Payload length,
- * @param[in] bytecount     Number of bytes to encode the payload length.
+/*
+ * PUBLIC FUNCTION DEFINITIONS
  ****************************************************************************************
  */
-static void aes_format_qfield(uint8_t *dest, const uint8_t *source, uint8_t bytecount)
+
+uint8_t aes_ccm_start(struct aes_ccm_ctx *ctx, const uint8_t *key, uint8_t T, uint8_t N,
+                      const uint8_t *Nonce, uint32_t Adata_len, uint32_t payload_len,
+                      uint8_t process)
 {
-    // Set padding bytes to 0
-    memset(dest, 0, CCM_Q - bytecount);
+    uint8_t b0[CCM_BLK_SIZE] = {0};
+    uint8_t q = 15 - N;
+    uint8_t status;
 
-    while (bytecount)
+    if ((ctx == NULL) || (Nonce == NULL) || (T < AES_CCM_T4) || (T > AES_CCM_T16) || (T & 1) ||
+        (N < AES_CCM_N7) || (N > AES_CCM_N13) ||
+        ((process != ENCRYPT_PROCESS) && (process != DECRYPT_PROCESS)))
     {
-        // Reverse byte order
-        memcpy(dest + CCM_Q - bytecount, source + bytecount - 1, 1);
-        bytecount--;
+        return AES_CCM_ERR_INVALID_PARAM;
     }
-}
 
-/**
- ****************************************************************************************
- * @brief Generate first B block with flags and formatting info.
- * @param[in,out] blk   Predefined AES_CCM structure
- ****************************************************************************************
- */
-static void aes_gen_ccm_bblk0(struct aes_ccm_env_tag *blk)
-{
-    uint8_t bytecount = 0;
-
-    // Get minimum number of octets to encode blk->payload_len
-    while (blk->payload_len >> (bytecount * 8))
+    // The payload length must fit in the q bytes field
+    if ((q < 4) && (payload_len >> (q * 8)))
     {
-        bytecount++;
+        return AES_CCM_ERR_INVALID_PARAM;
     }
 
-    // Check if there is enough space for all significant bytes
-    ASSERT_ERROR(CCM_Q >= bytecount);
+    // The forward cipher is used in both directions
+    status = aes_engine_init(&ctx->eng, key, AES_ENCRYPT, 0);
+    if (status != AES_CCM_ERR_NO_ERR)
+    {
+        return status;
+    }
 
-    // Set flags [according to Sec. A.2.1 in NIST_SP_800-38C]
-    if (blk->adata_len)
+    ctx->t = T;
+    ctx->q = q;
+    ctx->process = process;
+    ctx->payload_phase = false;
+    ctx->adata_left = Adata_len;
+    ctx->payload_left = payload_len;
+    memset(ctx->mac, 0, CCM_BLK_SIZE);
+
+    // Flags, nonce and payload length [Sec. A.2.1 in NIST_SP_800-38C]
+    CCM_FLAG_SET(b0[0], CCM_FLAG_ADATA, (Adata_len ? 1 : 0));
+    CCM_FLAG_SET(b0[0], CCM_FLAG_T, ((T - 2) / 2));
+    CCM_FLAG_SET(b0[0], CCM_FLAG_Q, (q - 1));
+    memcpy(&b0[1], Nonce, N);
+    aes_ccm_put_be(&b0[1 + N], payload_len, q);
+
+    status = aes_engine_encrypt(&ctx->eng, b0, NULL, 1, ctx->mac);
+    if (status != AES_CCM_ERR_NO_ERR)
     {
-        CCM_FLAG_SET(blk->b_blk[0][0], CCM_FLAG_ADATA, 1);
+        return status;
     }
 
-    CCM_FLAG_SET(blk->b_blk[0][0], CCM_FLAG_T, (CCM_T - 2) / 2);
-    CCM_FLAG_SET(blk->b_blk[0][0], CCM_FLAG_Q, CCM_Q - 1);
-    CCM_FLAG_SET(blk->b_blk[0][0], CCM_FLAG_RES, 0);
+    // Counter block 1 [Sec. A.3 in NIST_SP_800-38C]
+    memset(ctx->ctr, 0, CCM_BLK_SIZE);
+    CCM_FLAG_SET(ctx->ctr[0], CTR_FLAG_Q, (q - 1));
+    memcpy(&ctx->ctr[1], Nonce, N);
+    ctx->ctr[CCM_BLK_SIZE - 1] = 1;
 
-    // Put Nounce after the flags
-    memcpy(&blk->b_blk[0][1], blk->Nonce, CCM_N);
+    // Encoded associated data length, the start of the first associated data block
+    // [Sec. A.2.2 in NIST_SP_800-38C]
+    if (Adata_len == 0)
+    {
+        ctx->buf_len = 0;
+    }
+    else if (Adata_len < CCM_ADATA_LEN_ENC6)
+    {
+        aes_ccm_put_be(ctx->buf, Adata_len, 2);
+        ctx->buf_len = 2;
+    }
+    else
+    {
+        ctx->buf[0] = 0xFF;
+        ctx->buf[1] = 0xFE;
+        aes_ccm_put_be(&ctx->buf[2], Adata_len, 4);
+        ctx->buf_len = 6;
+    }
 
-    // Encode payload length in CCM_Q bytes after the nonce (BE order)
-    aes_format_qfield(&blk->b_blk[0][1] + CCM_N,
-                      (const uint8_t *) &blk->payload_len, bytecount);
+    return AES_CCM_ERR_NO_ERR;
 }
 
-/**
- ****************************************************************************************
- * @brief Generate B block for AES CCM operation
- * @details Prepares all B blocks for the CBC-MAC pass
- * @param[in,out] blk   Predefined AES_CCM structure
- * @param[in] type      choose ENCRYPT_PROCESS or DECRYPT_PROCESS
- ****************************************************************************************
- */
-static void aes_gen_ccm_bblk(struct aes_ccm_env_tag *blk, uint8_t type)
+uint8_t aes_ccm_update_adata(struct aes_ccm_ctx *ctx, const uint8_t *Adata, uint32_t len)
 {
-    uint8_t blk_cnt = 1 + (blk->adata_blk_cnt) + (blk->payload_blk_cnt);
-    uint8_t* s;
+    uint32_t blocks;
+    uint8_t status;
 
-    // Allocate blocks for formatted data and the CBC-MAC results
-    blk_malloc(&(blk->b_blk), blk->b_blk_cnt, blk_cnt);
-    blk_malloc(&(blk->x_blk), blk->b_blk_cnt, blk_cnt);
-    blk->b_blk_cnt = blk_cnt;
+    if (ctx->payload_phase || (len > ctx->adata_left))
+    {
+        return AES_CCM_ERR_INVALID_PARAM;
+    }
 
-    // Put flags, Nounce and payload length into the very first block
-    aes_gen_ccm_bblk0(blk);
+    ctx->adata_left -= len;
 
-    // Put Associated Data in consecutive blocks. Additionally append
-    // it's encoded length [according to Sec. A.2.2 in NIST_SP_800-38C].
-    if (blk->adata_len)
+    // Complete the buffered block
+    if (ctx->buf_len)
     {
-        // Adata length should already be encoded by Aes_Set_Ccm_Param(...)
-        s = blk->b_blk[1];
-        memcpy(s, blk->adata_blk, blk->adata_len);
+        uint8_t n = CCM_BLK_SIZE - ctx->buf_len;
+
+        if (n > len)
+        {
+            n = len;
+        }
+        memcpy(&ctx->buf[ctx->buf_len], Adata, n);
+        ctx->buf_len += n;
+        Adata += n;
+        len -= n;
+
+        if (ctx->buf_len < CCM_BLK_SIZE)
+        {
+            return AES_CCM_ERR_NO_ERR;
+        }
+
+        status = aes_engine_encrypt(&ctx->eng, ctx->buf, NULL, 1, ctx->mac);
+        if (status != AES_CCM_ERR_NO_ERR)
+        {
+            return status;
+        }
+        ctx->buf_len = 0;
     }
 
-    // Put Input Payload in consecutive blocks
-    if (type == ENCRYPT_PROCESS)
+    // Whole blocks straight from the input buffer
+    blocks = len / CCM_BLK_SIZE;
+    if (blocks)
     {
-        s = blk->b_blk[1 + blk->adata_blk_cnt];
-        memcpy(s, blk->payload_input, blk->payload_len);
+        status = aes_engine_encrypt(&ctx->eng, Adata, NULL, blocks, ctx->mac);
+        if (status != AES_CCM_ERR_NO_ERR)
+        {
+            return status;
+        }
+        Adata += blocks * CCM_BLK_SIZE;
+        len -= blocks * CCM_BLK_SIZE;
     }
+
+    memcpy(ctx->buf, Adata, len);
+    ctx->buf_len = len;
+
+    return AES_CCM_ERR_NO_ERR;
 }
 
-/**
- ****************************************************************************************
- * @brief Generate A block for AES CCM operation
- * @details Prepares all A blocks for the CTR pass
- * @param[in,out] blk   Predefined AES_CCM structure
- ****************************************************************************************
- */
-static void aes_gen_ccm_ablk(struct aes_ccm_env_tag *blk)
+uint8_t aes_ccm_update(struct aes_ccm_ctx *ctx, const uint8_t *input, uint8_t *output,
+                       uint32_t len)
 {
-    uint8_t bytecount = 0;
+    uint8_t status = aes_ccm_enter_payload(ctx);
 
-    // Allocate blocks for counter formatted data and the CTR results
-    blk_malloc(&(blk->a_blk), blk->a_blk_cnt, blk->b_blk_cnt);
-    blk_malloc(&(blk->s_blk), blk->a_blk_cnt, blk->b_blk_cnt);
-    blk->a_blk_cnt = blk->b_blk_cnt;
+    if (status != AES_CCM_ERR_NO_ERR)
+    {
+        return status;
+    }
 
-    // Get minimum number of octets to encode counter for for A blocks
-    while (blk->a_blk_cnt >> (bytecount * 8))
+    if (len > ctx->payload_left)
     {
-        bytecount++;
+        return AES_CCM_ERR_INVALID_PARAM;
     }
 
-    // Check if there is enough space for all significant bytes
-    ASSERT_ERROR(CCM_Q >= bytecount);
+    ctx->payload_left -= len;
 
-    for (int i = 0; i < blk->a_blk_cnt; i++)
+    while (len)
     {
-        // Set flags [according to Sec. A.3 in NIST_SP_800-38C]
-        CCM_FLAG_SET(blk->a_blk[i][0], CTR_FLAG_Q, CCM_Q - 1);
-        CCM_FLAG_SET(blk->a_blk[i][0], CTR_FLAG_ZERO, 0);
-        CCM_FLAG_SET(blk->a_blk[i][0], CTR_FLAG_RES1, 0);
-        CCM_FLAG_SET(blk->a_blk[i][0], CTR_FLAG_RES2, 0);
+        if ((ctx->buf_len == 0) && (len >= CCM_BLK_SIZE))
+        {
+            // Whole blocks: the plaintext goes straight from the buffer into the CBC-MAC,
+            // with the key loaded once for all of them. On encryption before it is
+            // overwritten (in place operation), on decryption once it is available.
+            uint32_t blocks = len / CCM_BLK_SIZE;
+
+            if (ctx->process == ENCRYPT_PROCESS)
+            {
+                status = aes_engine_encrypt(&ctx->eng, input, NULL, blocks, ctx->mac);
+            }
+
+            for (uint32_t i = 0; (i < blocks) && (status == AES_CCM_ERR_NO_ERR); i++)
+            {
+                status = aes_ccm_next_ks(ctx);
+                aes_array_xor(&input[i * CCM_BLK_SIZE], ctx->ks, CCM_BLK_SIZE,
+                              &output[i * CCM_BLK_SIZE]);
+            }
+
+            if ((ctx->process == DECRYPT_PROCESS) && (status == AES_CCM_ERR_NO_ERR))
+            {
+                status = aes_engine_encrypt(&ctx->eng, output, NULL, blocks, ctx->mac);
+            }
+
+            if (status != AES_CCM_ERR_NO_ERR)
+            {
+                return status;
+            }
+
+            input += blocks * CCM_BLK_SIZE;
+            output += blocks * CCM_BLK_SIZE;
+            len -= blocks * CCM_BLK_SIZE;
+            continue;
+        }
 
-        // Put Nounce after the flags
-        memcpy(&blk->a_blk[i][1], blk->Nonce, CCM_N);
+        // Partial block, byte by byte
+        if (ctx->buf_len == 0)
+        {
+            status = aes_ccm_next_ks(ctx);
+            if (status != AES_CCM_ERR_NO_ERR)
+            {
+                return status;
+            }
+        }
 
-        // Put counter after nonce
-        aes_format_qfield(&blk->a_blk[i][1] + CCM_N,
-                          (const uint8_t *) &i, bytecount);
-    }
-}
+        {
+            uint8_t in = *input++;
+            uint8_t out = in ^ ctx->ks[ctx->buf_len];
 
-/**
- ****************************************************************************************
- * @brief Generate S block for AES CCM operation
- * @details Calculates S blocks in CTR mode
- * @param[in,out] blk   Predefined AES_CCM structure
- ****************************************************************************************
- */
-static void aes_gen_ccm_sblk(struct aes_ccm_env_tag *blk)
-{
-    for (int i = 0; i < blk->a_blk_cnt; i++)
-    {
-        aes_encrypt(blk->a_blk[i], blk->s_blk[i], CCM_BLK_SIZE);
+            ctx->buf[ctx->buf_len++] = (ctx->process == ENCRYPT_PROCESS) ? in : out;
+            *output++ = out;
+            len--;
+        }
+
+        if (ctx->buf_len == CCM_BLK_SIZE)
+        {
+            status = aes_engine_encrypt(&ctx->eng, ctx->buf, NULL, 1, ctx->mac);
+            if (status != AES_CCM_ERR_NO_ERR)
+            {
+                return status;
+            }
+            ctx->buf_len = 0;
+        }
     }
-}
 
-/**
- ****************************************************************************************
- * @brief Generate X block for AES CCM operation
- * @details Calculates tag in CBC-MAC mode (fills the X block)
- * @param[in,out] blk   Predefined AES_CCM structure
- ****************************************************************************************
- */
-__STATIC_INLINE void aes_gen_ccm_xblk(struct aes_ccm_env_tag *blk)
-{
-    aes_cbc_encrypt(blk->b_blk[0], blk->b_blk_cnt,      // Input
-                    blk->x_blk[0], blk->b_blk_cnt,      // Output
-                    key_aes, sizeof(key_aes), NULL);    // Key, IV=0
+    return AES_CCM_ERR_NO_ERR;
 }
 
-/**
- ****************************************************************************************
- * @brief Generate Output Array for AES CCM operation
- * @details Combines CBC-MAC with the CTR results into the final cyphertext
- * @param[in,out] blk       Predefined AES_CCM structure
- * @param[out] output       where output array to be placed
- ****************************************************************************************
- */
-static void aes_gen_ccm_output(struct aes_ccm_env_tag *blk, uint8_t *output)
+uint8_t aes_ccm_finish(struct aes_ccm_ctx *ctx, uint8_t *tag)
 {
-    uint8_t index = blk->b_blk_cnt - 1;
-    uint8_t payload_index = blk->adata_blk_cnt + 1;
+    if (ctx->process != ENCRYPT_PROCESS)
+    {
+        return AES_CCM_ERR_INVALID_PARAM;
+    }
 
-    aes_array_xor(blk->x_blk[index], blk->s_blk[0], CCM_T, output + blk->payload_len);
-    aes_array_xor(blk->b_blk[payload_index], blk->s_blk[1], blk->payload_len, output);
+    return aes_ccm_tag(ctx, tag);
 }
 
-/**
- ****************************************************************************************
- * @brief Check if decrypted data match up with the authenticate data and provide the result
- * @param[in,out] blk       Predefined AES_CCM structure
- * @param[out] output       Decrypted data
- * @return                  0 if auth data matches up. 1 if something goes wrong
- ****************************************************************************************
- */
-static uint8_t aes_check_ccm_payload(struct aes_ccm_env_tag *blk, uint8_t *output)
+uint8_t aes_ccm_check_tag(struct aes_ccm_ctx *ctx, const uint8_t *tag)
 {
-    uint8_t index = blk->b_blk_cnt - 1;
-    uint8_t payload_index = blk->adata_blk_cnt + 1;
-    uint8_t *temp_mic = ke_malloc(CCM_T, KE_MEM_NON_RETENTION);
-    uint8_t ret = 1;
+    uint8_t expected[AES_CCM_T16];
+    uint8_t diff = 0;
+    uint8_t status;
 
-    memset(temp_mic, 0, CCM_T);
+    if (ctx->process != DECRYPT_PROCESS)
+    {
+        return AES_CCM_ERR_INVALID_PARAM;
+    }
 
-    aes_array_xor(blk->payload_input, blk->s_blk[1], blk->payload_len,
-              blk->b_blk[payload_index]);
-    aes_gen_ccm_xblk(blk);
-    aes_array_xor(blk->x_blk[index], blk->s_blk[0], CCM_T, temp_mic);
+    status = aes_ccm_tag(ctx, expected);
+    if (status != AES_CCM_ERR_NO_ERR)
+    {
+        return status;
+    }
 
-    if (!memcmp(blk->payload_input + blk->payload_len, temp_mic, CCM_T))
+    // Compare all the bytes, whatever the first difference
+    for (uint8_t i = 0; i < ctx->t; i++)
     {
-        memcpy(output, blk->b_blk[payload_index], blk->payload_len);
-        ret = 0;
+        diff |= expected[i] ^ tag[i];
     }
 
-    ke_free(temp_mic);
-    return ret;
+    return diff ? AES_CCM_ERR_AUTH_FAIL : AES_CCM_ERR_NO_ERR;
 }
 
-/*
- * PUBLIC FUNCTION DEFINITIONS
- ****************************************************************************************
- */
-
 void aes_ccm_init(uint8_t *key, uint8_t T, uint8_t N, uint8_t ke_mem_type)
 {
-    struct aes_ccm_env_tag *blk = &AES128_ccm_blk;
-
-    aes_key_init(key);
-
-    blk_mem_type = ke_mem_type;
+    memcpy(key_aes, key, sizeof(key_aes));
 
     CCM_T = T;      // Length of Auth Bytes (TAG/MAC), options are 4,6,8,10,12,14 and 16
-    CCM_Q = 15 - N; // Length of the encoded Plain Text length field, options are 2~8
     CCM_N = N;      // The nonce length
-
-    blk->adata_blk = 0;
-    blk->adata_len = 0;
-    blk->adata_blk_cnt = 0;
-    blk->b_blk = 0;
-    blk->b_blk_cnt = 0;
-    blk->x_blk = 0;
-    blk->a_blk = 0;
-    blk->a_blk_cnt = 0;
-    blk->s_blk = 0;
 }
 
 void aes_ccm_cleanup(void)
 {
-    struct aes_ccm_env_tag *blk = &AES128_ccm_blk;
+}
 
-    if (blk->adata_blk)
-    {
-        ke_free(blk->adata_blk);
-        blk->adata_blk = 0;
-        blk->adata_len = 0;
-        blk->adata_blk_cnt = 0;
-    }
+void aes_ccm_encrypt(uint8_t *payload, uint16_t payload_len, uint8_t *Nonce,
+                     uint8_t *Adata, uint16_t Adata_len, uint8_t *output)
+{
+    struct aes_ccm_ctx *ctx = &AES128_ccm_ctx;
+    uint8_t status;
 
-    if (blk->b_blk)
-    {
-        ke_free(blk->b_blk);
-        blk->b_blk = 0;
-        blk->b_blk_cnt = 0;
-    }
+    status = aes_ccm_start(ctx, key_aes, CCM_T, CCM_N, Nonce, Adata ? Adata_len : 0,
+                           payload_len, ENCRYPT_PROCESS);
 
-    if (blk->x_blk)
+    if ((status == AES_CCM_ERR_NO_ERR) && Adata)
     {
-        ke_free(blk->x_blk);
-        blk->x_blk = 0;
+        status = aes_ccm_update_adata(ctx, Adata, Adata_len);
     }
 
-    if (blk->a_blk)
+    if (status == AES_CCM_ERR_NO_ERR)
     {
-        ke_free(blk->a_blk);
-        blk->a_blk = 0;
-        blk->a_blk_cnt = 0;
+        status = aes_ccm_update(ctx, payload, output, payload_len);
     }
 
-    if (blk->s_blk)
+    if (status == AES_CCM_ERR_NO_ERR)
     {
-        ke_free(blk->s_blk);
-        blk->s_blk = 0;
+        status = aes_ccm_finish(ctx, output + payload_len);
     }
-}
-
-void aes_ccm_encrypt(uint8_t *payload, uint16_t payload_len, uint8_t *Nonce,
-                     uint8_t *Adata, uint16_t Adata_len, uint8_t *output)
-{
-    struct aes_ccm_env_tag *blk = &AES128_ccm_blk;
 
-    aes_set_ccm_param(blk, payload, payload_len, Nonce, Adata, Adata_len, ENCRYPT_PROCESS);
-    aes_gen_ccm_bblk(blk, ENCRYPT_PROCESS);
-
-    aes_gen_ccm_ablk(blk);
-    aes_gen_ccm_sblk(blk);
-    aes_gen_ccm_xblk(blk);
-    aes_gen_ccm_output(blk, output);
+    ASSERT_WARNING(status == AES_CCM_ERR_NO_ERR);
 }
 
 uint8_t aes_ccm_decrypt(uint8_t *payload, uint16_t payload_len, uint8_t *Nonce,
                         uint8_t *Adata, uint16_t Adata_len, uint8_t *output)
 {
-    struct aes_ccm_env_tag *blk = &AES128_ccm_blk;
+    struct aes_ccm_ctx *ctx = &AES128_ccm_ctx;
+    uint16_t len;
+    uint8_t status;
+
+    if (payload_len < CCM_T)
+    {
+        return 1;
+    }
+
+    len = payload_len - CCM_T;
 
-    aes_set_ccm_param(blk, payload, payload_len, Nonce, Adata, Adata_len, DECRYPT_PROCESS);
-    aes_gen_ccm_bblk(blk, DECRYPT_PROCESS);
+    status = aes_ccm_start(ctx, key_aes, CCM_T, CCM_N, Nonce, Adata ? Adata_len : 0,
+                           len, DECRYPT_PROCESS);
 
-    aes_gen_ccm_ablk(blk);
-    aes_gen_ccm_sblk(blk);
+    if ((status == AES_CCM_ERR_NO_ERR) && Adata)
+    {
+        status = aes_ccm_update_adata(ctx, Adata, Adata_len);
+    }
+
+    if (status == AES_CCM_ERR_NO_ERR)
+    {
+        status = aes_ccm_update(ctx, payload, output, len);
+    }
+
+    if (status == AES_CCM_ERR_NO_ERR)
+    {
+        // The tag follows the ciphertext, which may have just been overwritten
+        // by the plaintext if output is payload
+        status = aes_ccm_check_tag(ctx, payload + len);
+    }
+
+    if (status != AES_CCM_ERR_NO_ERR)
+    {
+        // Do not release unauthenticated data
+        memset(output, 0, len);
+        return 1;
+    }
 
-    return aes_check_ccm_payload(blk, output);
+    return 0;
 }
 /// @} aes_ccm
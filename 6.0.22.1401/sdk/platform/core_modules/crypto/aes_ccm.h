@@ -41,6 +41,15 @@
 #ifndef AES_CCM_H_
 #define AES_CCM_H_
 
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "aes_engine.h"
+
 /*
  * DEFINES
  ****************************************************************************************
@@ -90,45 +99,51 @@ enum {
     AES_CCM_N13 = 15 - AES_CCM_Q2,
 };
 
+/// AES CCM status codes
+enum {
+    AES_CCM_ERR_NO_ERR          = AES_ENGINE_ERR_NO_ERR,
+    AES_CCM_ERR_INVALID_PARAM   = AES_ENGINE_ERR_INVALID_PARAM,
+    AES_CCM_ERR_BUSY            = AES_ENGINE_ERR_BUSY,
+    AES_CCM_ERR_NOT_SUPPORTED   = AES_ENGINE_ERR_NOT_SUPPORTED,
+    /// The tag does not match
+    AES_CCM_ERR_AUTH_FAIL,
+};
+
 /*
  * STRUCTURES
  ****************************************************************************************
  */
 
-
-/// AES_CCM environment structure
-struct aes_ccm_env_tag
+/// AES-CCM context, for a message processed in several calls without any allocation
+struct aes_ccm_ctx
 {
-    /// Nonce array
-    const uint8_t *Nonce;
-
-    /// Payload length
-    uint16_t payload_len;
-    /// Number of payload blocks
-    uint8_t payload_blk_cnt;
-    /// Payload input
-    const uint8_t *payload_input;
-
-    /// Adata block length
-    uint16_t adata_len;
-    /// Number of adata blocks
-    uint8_t adata_blk_cnt;
-    /// Adata array
-    uint8_t (*adata_blk)[CCM_BLK_SIZE];
-
-    /// CBC-MAC blocks
-    uint8_t b_blk_cnt;
-    /// B block array
-    uint8_t (*b_blk)[CCM_BLK_SIZE];
-    /// X block array
-    uint8_t (*x_blk)[CCM_BLK_SIZE];
-
-    /// CTR blocks
-    uint32_t a_blk_cnt;
-    /// A block array
-    uint8_t (*a_blk)[CCM_BLK_SIZE];
-    /// S block array
-    uint8_t (*s_blk)[CCM_BLK_SIZE];
+    /// Key (encryption only, CCM uses the forward cipher in both directions)
+    struct aes_engine eng;
+
+    /// CBC-MAC state
+    uint8_t mac[CCM_BLK_SIZE];
+    /// Counter block of the next key stream block
+    uint8_t ctr[CCM_BLK_SIZE];
+    /// Key stream block of the current payload block
+    uint8_t ks[CCM_BLK_SIZE];
+    /// Partial associated data or plaintext block, not yet in the CBC-MAC
+    uint8_t buf[CCM_BLK_SIZE];
+    /// Number of bytes in buf
+    uint8_t buf_len;
+
+    /// Tag length
+    uint8_t t;
+    /// Length of the counter and payload length fields
+    uint8_t q;
+    /// ENCRYPT_PROCESS or DECRYPT_PROCESS
+    uint8_t process;
+    /// True once the associated data is complete
+    bool payload_phase;
+
+    /// Associated data bytes still expected
+    uint32_t adata_left;
+    /// Payload bytes still expected
+    uint32_t payload_left;
 };
 
 /*
@@ -138,13 +153,81 @@ struct aes_ccm_env_tag
 
 /**
  ****************************************************************************************
- * @brief AES CCM encryption
+ * @brief Start an AES-CCM operation: expand the key, authenticate the B0 block and set
+ * up the counter.
+ * @param[out] ctx          CCM context
+ * @param[in] key           Key (128 bits)
+ * @param[in] T             Tag length, 4, 6, ..., 16
+ * @param[in] N             Nonce length, 7 to 13
+ * @param[in] Nonce         Nonce, should be unique for each AES-CCM operation
+ * @param[in] Adata_len     Total associated data length in bytes
+ * @param[in] payload_len   Total payload length in bytes, without the tag
+ * @param[in] process       ENCRYPT_PROCESS or DECRYPT_PROCESS
+ * @return                  AES_CCM_ERR_NO_ERR on success, error code otherwise
+ * @note The lengths are part of B0, so they must be known in advance, the data need not.
+ ****************************************************************************************
+ */
+uint8_t aes_ccm_start(struct aes_ccm_ctx *ctx, const uint8_t *key, uint8_t T, uint8_t N,
+                      const uint8_t *Nonce, uint32_t Adata_len, uint32_t payload_len,
+                      uint8_t process);
+
+/**
+ ****************************************************************************************
+ * @brief Add associated data to an AES-CCM operation.
+ * @param[in] ctx           CCM context
+ * @param[in] Adata         Associated data bytes, of any length
+ * @param[in] len           Number of bytes
+ * @return                  AES_CCM_ERR_NO_ERR on success, error code otherwise
+ ****************************************************************************************
+ */
+uint8_t aes_ccm_update_adata(struct aes_ccm_ctx *ctx, const uint8_t *Adata, uint32_t len);
+
+/**
+ ****************************************************************************************
+ * @brief Encrypt or decrypt the next payload bytes of an AES-CCM operation. All the
+ * associated data must have been added before.
+ * @param[in] ctx           CCM context
+ * @param[in] input         Plaintext (encryption) or ciphertext (decryption) bytes
+ * @param[out] output       Output bytes, may be equal to input
+ * @param[in] len           Number of bytes, of any length
+ * @return                  AES_CCM_ERR_NO_ERR on success, error code otherwise
+ * @note On decryption the plaintext is released before the tag is checked. It must not
+ * be used unless aes_ccm_check_tag() succeeds.
+ ****************************************************************************************
+ */
+uint8_t aes_ccm_update(struct aes_ccm_ctx *ctx, const uint8_t *input, uint8_t *output,
+                       uint32_t len);
+
+/**
+ ****************************************************************************************
+ * @brief Finish an AES-CCM encryption.
+ * @param[in] ctx           CCM context
+ * @param[out] tag          Tag, T bytes
+ * @return                  AES_CCM_ERR_NO_ERR on success, error code otherwise
+ ****************************************************************************************
+ */
+uint8_t aes_ccm_finish(struct aes_ccm_ctx *ctx, uint8_t *tag);
+
+/**
+ ****************************************************************************************
+ * @brief Finish an AES-CCM decryption.
+ * @param[in] ctx           CCM context
+ * @param[in] tag           Received tag, T bytes
+ * @return                  AES_CCM_ERR_NO_ERR if the tag matches, error code otherwise
+ ****************************************************************************************
+ */
+uint8_t aes_ccm_check_tag(struct aes_ccm_ctx *ctx, const uint8_t *tag);
+
+/**
+ ****************************************************************************************
+ * @brief AES CCM encryption, with the parameters of aes_ccm_init()
  * @param[in] payload      Data to be encrypted/decrypted
- * @param[in] payload_len  payload length in bytes, up to 32
+ * @param[in] payload_len  payload length in bytes
  * @param[in] Nonce        Nonce array, should be unique for each AES-CCM operation
- * @param[in] Adata        Adata, or header, up to 32 bytes
- * @param[in] Adata_len    Adata length in bytes, up to 32
- * @param[out] output      where encrypted cipher to be placed. Header is not included
+ * @param[in] Adata        Adata, or header
+ * @param[in] Adata_len    Adata length in bytes
+ * @param[out] output      where encrypted cipher to be placed, followed by the tag.
+ *                         Header is not included. May be equal to payload.
  ****************************************************************************************
  */
 void aes_ccm_encrypt(uint8_t *payload, uint16_t payload_len, uint8_t *Nonce,
@@ -152,13 +235,14 @@ void aes_ccm_encrypt(uint8_t *payload, uint16_t payload_len, uint8_t *Nonce,
 
 /**
  ****************************************************************************************
- * @brief AES CCM decryption
- * @param[in] payload      Data to be encrypted/decrypted
- * @param[in] payload_len  payload length in bytes, up to 32
+ * @brief AES CCM decryption, with the parameters of aes_ccm_init()
+ * @param[in] payload      Data to be encrypted/decrypted, followed by the tag
+ * @param[in] payload_len  payload length in bytes, tag included
  * @param[in] Nonce        Nonce array, should be unique for each AES-CCM operation
- * @param[in] Adata        Adata, or header, up to 32 bytes
- * @param[in] Adata_len    Adata length in bytes, up to 32
- * @param[out] output      where encrypted cipher to be placed. Header is not included
+ * @param[in] Adata        Adata, or header
+ * @param[in] Adata_len    Adata length in bytes
+ * @param[out] output      where decrypted data to be placed, zeroed if the tag does
+ *                         not match. Header is not included. May be equal to payload.
  * @return    0 if auth data matches up. 1 if something goes wrong
  ****************************************************************************************
  */
@@ -171,14 +255,14 @@ uint8_t aes_ccm_decrypt(uint8_t *payload, uint16_t payload_len, uint8_t *Nonce,
  * @param[in] key           key to be used, should be 16 bytes
  * @param[in] T             Tag length
  * @param[in] N             Nonce length
- * @param[in] ke_mem_type   memory pool type used for buffer allocation
+ * @param[in] ke_mem_type   not used, nothing is allocated
  ****************************************************************************************
  */
 void aes_ccm_init(uint8_t *key, uint8_t T, uint8_t N, uint8_t ke_mem_type);
 
 /**
  ****************************************************************************************
- * @brief Deinitialize AES-CCM data block
+ * @brief Deinitialize AES-CCM data block. Nothing to release, kept for compatibility.
  ****************************************************************************************
  */
 void aes_ccm_cleanup(void);
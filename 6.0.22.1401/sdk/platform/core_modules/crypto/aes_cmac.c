@@ -43,8 +43,8 @@
  ****************************************************************************************
  */
 
+#include <string.h>
 #include "aes_cmac.h"
-#include "aes_cbc.h"
 
 /*
  * DEFINES
@@ -54,16 +54,6 @@
 #define R128_LSB (0x87)          // according to NIST SP 800-38b: 120*0 || 10000111
 #define MSb_MASK (0x80)
 
-/*
- * STRUCTURES
- ****************************************************************************************
- */
-
-struct aes_cmac_subkeys {
-    uint8_t k1[AES_CMAC_BLK_SIZE_128];
-    uint8_t k2[AES_CMAC_BLK_SIZE_128];
-};
-
 /*
  * STATIC FUNCTION DEFINITIONS
  ****************************************************************************************
@@ -96,97 +86,150 @@ static void subkey_prepare(uint8_t *dst, const uint8_t *src, const uint8_t *xor)
     }
 }
 
-/**
- ****************************************************************************************
- * @brief Generate subkeys
- * @details Sec 6.1 of NIST SP 800-38b
- * @param[in] key           Input AES key
- * @param[out] subkeys      Subkeys structure for the output data,
+/*
+ * PUBLIC FUNCTION DEFINITIONS
  ****************************************************************************************
  */
-static void generate_subkeys(const uint8_t *key, struct aes_cmac_subkeys *subkeys)
+
+uint8_t aes_cmac_init(struct aes_cmac_ctx *ctx, const uint8_t *key)
 {
-    uint8_t z_blk[AES_CMAC_BLK_SIZE_128] = {0};
     uint8_t l_blk[AES_CMAC_BLK_SIZE_128] = {0};
     uint8_t r_blk[AES_CMAC_BLK_SIZE_128] = {0};
+    uint8_t status;
+
+    // IV = C0 = 0
+    status = aes_cbc_init(&ctx->cbc, key, AES_CMAC_BLK_SIZE_128, NULL, AES_ENCRYPT);
+    if (status != AES_CBC_ERR_NO_ERR)
+    {
+        return status;
+    }
 
     // Prepare R block
     r_blk[AES_CMAC_BLK_SIZE_128 - 1] = R128_LSB;
 
     // Prepare L block [Step 1, Sec 6.1 of NIST SP 800-38b]
-    aes_cbc_encrypt(z_blk, 1, l_blk, 1, key, AES_CMAC_BLK_SIZE_128, NULL);
+    status = aes_engine_encrypt(&ctx->cbc.eng, l_blk, l_blk, 1, NULL);
 
     // Generate K1 [Step 2, Sec 6.1 of NIST SP 800-38b]
-    subkey_prepare(subkeys->k1, l_blk, r_blk);
+    subkey_prepare(ctx->k1, l_blk, r_blk);
 
     // Generate K2 [Step 3, Sec 6.1 of NIST SP 800-38b]
-    subkey_prepare(subkeys->k2, subkeys->k1, r_blk);
-}
+    subkey_prepare(ctx->k2, ctx->k1, r_blk);
 
-/*
- * PUBLIC FUNCTION DEFINITIONS
- ****************************************************************************************
- */
+    ctx->last_len = 0;
 
-uint8_t aes_cmac_generate(const uint8_t *payload, uint16_t payload_len,
-                          const uint8_t *key, uint8_t *mac, uint8_t mac_len)
+    return status;
+}
+
+uint8_t aes_cmac_update(struct aes_cmac_ctx *ctx, const uint8_t *data, uint32_t len)
 {
-    uint8_t n = payload_len ? aes_get_blk_num(payload_len) : 1; // [NIST SP 800-38b sec. 6.2, step 2]
-    struct aes_cmac_subkeys subkeys;
-    uint8_t status = AES_CBC_ERR_NO_ERR;
+    uint32_t blocks;
+    uint8_t status;
 
-    // Temporary MAC storage
-    uint8_t temp_mac[AES_CBC_BLK_SIZE] = {0};
+    if (len == 0)
+    {
+        return AES_CBC_ERR_NO_ERR;
+    }
 
-    // We use the provided input buffer in 128-bit wide blocks to correctly feed the AES
-    // block encryption routine. We need an intermediate buffer only for the last chunk.
-    uint8_t temp_mn[AES_CBC_BLK_SIZE] = {0};
+    // Complete the held back block. It is encrypted only once more data follows,
+    // since the last block is processed with a subkey.
+    if (ctx->last_len)
+    {
+        uint8_t n = AES_CMAC_BLK_SIZE_128 - ctx->last_len;
 
-    // Generate subkeys [NIST SP 800-38b sec. 6.2, step 1]
-    generate_subkeys(key, &subkeys);
+        if (n > len)
+        {
+            n = len;
+        }
+        memcpy(&ctx->last[ctx->last_len], data, n);
+        ctx->last_len += n;
+        data += n;
+        len -= n;
 
-    // Prepare last block [NIST SP 800-38b sec. 6.2, step 4]
-    if ((payload_len == 0) || (payload_len % AES_CBC_BLK_SIZE))
-    {
-        // Mn is an incomplete block (or there is no payload at all)
-        uint8_t rem_len = payload_len ? payload_len - ((n - 1) * AES_CBC_BLK_SIZE) : 0;
+        if (len == 0)
+        {
+            return AES_CBC_ERR_NO_ERR;
+        }
 
-        if (rem_len)
+        status = aes_cbc_update(&ctx->cbc, ctx->last, NULL, 1);
+        if (status != AES_CBC_ERR_NO_ERR)
         {
-            memcpy(temp_mn, &payload[(n - 1) * AES_CBC_BLK_SIZE], rem_len);
+            return status;
         }
-        // Fill the empty space with 10^j pattern (single 1 and the rest of bits are 0).
-        // Since buffer was zeroed, we set just the most significant bit in the first byte.
-        temp_mn[rem_len] = (1 << 7);
+        ctx->last_len = 0;
+    }
+
+    // [NIST SP 800-38b sec. 6.2, steps 6,7,8] for all the blocks but the last one,
+    // straight from the input buffer
+    blocks = (len - 1) / AES_CMAC_BLK_SIZE_128;
+    if (blocks)
+    {
+        status = aes_cbc_update(&ctx->cbc, data, NULL, blocks);
+        if (status != AES_CBC_ERR_NO_ERR)
+        {
+            return status;
+        }
+        data += blocks * AES_CMAC_BLK_SIZE_128;
+        len -= blocks * AES_CMAC_BLK_SIZE_128;
+    }
+
+    memcpy(ctx->last, data, len);
+    ctx->last_len = len;
+
+    return AES_CBC_ERR_NO_ERR;
+}
+
+uint8_t aes_cmac_final(struct aes_cmac_ctx *ctx, uint8_t *mac, uint8_t mac_len)
+{
+    uint8_t status;
 
-        aes_array_xor(subkeys.k2, temp_mn, AES_CBC_BLK_SIZE, temp_mn);
+    if (mac_len > AES_CMAC_BLK_SIZE_128)
+    {
+        return AES_CBC_ERR_INVALID_PARAM;
     }
-    else
+
+    // Prepare last block [NIST SP 800-38b sec. 6.2, step 4]
+    if (ctx->last_len == AES_CMAC_BLK_SIZE_128)
     {
         // Mn is a complete block
-        memcpy(temp_mn, &payload[(n - 1) * AES_CBC_BLK_SIZE],
-               AES_CBC_BLK_SIZE);
+        aes_array_xor(ctx->k1, ctx->last, AES_CMAC_BLK_SIZE_128, ctx->last);
+    }
+    else
+    {
+        // Mn is an incomplete block (or there is no payload at all).
+        // Fill the empty space with 10^j pattern (single 1 and the rest of bits are 0).
+        memset(&ctx->last[ctx->last_len], 0, AES_CMAC_BLK_SIZE_128 - ctx->last_len);
+        ctx->last[ctx->last_len] = (1 << 7);
+
+        aes_array_xor(ctx->k2, ctx->last, AES_CMAC_BLK_SIZE_128, ctx->last);
+    }
 
-        aes_array_xor(subkeys.k1, temp_mn, AES_CBC_BLK_SIZE, temp_mn);
+    // Encrypt the last block (get the final ciphertext block Cn)
+    status = aes_cbc_update(&ctx->cbc, ctx->last, NULL, 1);
+    if (status == AES_CBC_ERR_NO_ERR)
+    {
+        memcpy(mac, ctx->cbc.iv, mac_len);
     }
 
-    // [NIST SP 800-38b sec. 6.2, steps 6,7,8]
-    // Encrypt all but the last block which is stored in temp_mn
-    if (n > 1)
+    return status;
+}
+
+uint8_t aes_cmac_generate(const uint8_t *payload, uint16_t payload_len,
+                          const uint8_t *key, uint8_t *mac, uint8_t mac_len)
+{
+    struct aes_cmac_ctx ctx;
+    uint8_t status;
+
+    status = aes_cmac_init(&ctx, key);
+
+    if (status == AES_CBC_ERR_NO_ERR)
     {
-        status = aes_cbc_encrypt(payload, n - 1, temp_mac, 1, key, AES_CMAC_BLK_SIZE_128,
-                                 NULL); // IV = C0 = 0
+        status = aes_cmac_update(&ctx, payload, payload_len);
     }
 
-    // Encrypt the last block (get the final ciphertext block Cn)
     if (status == AES_CBC_ERR_NO_ERR)
     {
-        status = aes_cbc_encrypt(temp_mn, 1, temp_mac, 1, key, AES_CMAC_BLK_SIZE_128,
-                                 temp_mac); // IV = Cn-1
-        if (status == AES_CBC_ERR_NO_ERR)
-        {
-            memcpy(mac, temp_mac, mac_len);
-        }
+        status = aes_cmac_final(&ctx, mac, mac_len);
     }
 
     return status;
@@ -197,7 +240,10 @@ bool aes_cmac_verify(const uint8_t *payload, uint16_t payload_len,
 {
     uint8_t cmac[AES_CMAC_BLK_SIZE_128];
 
-    aes_cmac_generate(payload, payload_len, key, cmac, mac_len);
+    if (aes_cmac_generate(payload, payload_len, key, cmac, mac_len) != AES_CBC_ERR_NO_ERR)
+    {
+        return false;
+    }
 
     return (memcmp(cmac, mac, mac_len) ? false : true);
 }
@@ -41,6 +41,15 @@
 #ifndef AES_CMAC_H_
 #define AES_CMAC_H_
 
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "aes_cbc.h"
+
 /*
  * DEFINES
  ****************************************************************************************
@@ -49,11 +58,65 @@
 /// Input block size (128 bits)
 #define AES_CMAC_BLK_SIZE_128 (16)
 
+/*
+ * STRUCTURES
+ ****************************************************************************************
+ */
+
+/// CMAC context, for a message processed in several calls
+struct aes_cmac_ctx
+{
+    /// CBC-MAC state
+    struct aes_cbc_ctx cbc;
+
+    /// Subkeys K1 and K2
+    uint8_t k1[AES_CMAC_BLK_SIZE_128];
+    uint8_t k2[AES_CMAC_BLK_SIZE_128];
+
+    /// Last message block, held back until the end of the message is known
+    uint8_t last[AES_CMAC_BLK_SIZE_128];
+
+    /// Number of bytes in last
+    uint8_t last_len;
+};
+
 /*
  * PUBLIC FUNCTIONS DECLARATION
  ****************************************************************************************
  */
 
+/**
+ ****************************************************************************************
+ * @brief Start an AES-CMAC computation: expand the key and generate the subkeys.
+ * @param[out] ctx              CMAC context
+ * @param[in] key               Key (128bit)
+ * @return                      Error code if something goes wrong, 0 otherwise
+ ****************************************************************************************
+ */
+uint8_t aes_cmac_init(struct aes_cmac_ctx *ctx, const uint8_t *key);
+
+/**
+ ****************************************************************************************
+ * @brief Add the next bytes of the message to an AES-CMAC computation.
+ * @param[in] ctx               CMAC context
+ * @param[in] data              Message bytes, of any length
+ * @param[in] len               Number of bytes
+ * @return                      Error code if something goes wrong, 0 otherwise
+ ****************************************************************************************
+ */
+uint8_t aes_cmac_update(struct aes_cmac_ctx *ctx, const uint8_t *data, uint32_t len);
+
+/**
+ ****************************************************************************************
+ * @brief Finish an AES-CMAC computation.
+ * @param[in] ctx               CMAC context
+ * @param[out] mac              MAC output buffer
+ * @param[in] mac_len           MAC buffer length (in bytes), at most 16
+ * @return                      Error code if something goes wrong, 0 otherwise
+ ****************************************************************************************
+ */
+uint8_t aes_cmac_final(struct aes_cmac_ctx *ctx, uint8_t *mac, uint8_t mac_len);
+
 /**
  ****************************************************************************************
  * @brief Generate tag using AES-CMAC
@@ -0,0 +1,282 @@
+/**
+ ****************************************************************************************
+ *
+ * @file aes_engine.c
+ *
+ * @brief AES multi-block engine implementation.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @addtogroup aes_engine
+ * @{
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <string.h>
+#include "aes_engine.h"
+
+#if !USE_AES_SW_BACKEND
+#include "aes_api.h"
+#include "llm.h"
+#include "reg_blecore.h"
+#include "rwip.h"
+#endif
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+#ifndef GETU32
+/// GETU32 helper macro
+#define GETU32(pt)     (((uint32_t)(pt)[0] << 24) ^ ((uint32_t)(pt)[1] << 16) ^ ((uint32_t)(pt)[2] <<  8) ^ ((uint32_t)(pt)[3]))
+/// PUTU32 helper macro
+#define PUTU32(ct, st) { (ct)[0] = (uint8_t)((st) >> 24); (ct)[1] = (uint8_t)((st) >> 16); (ct)[2] = (uint8_t)((st) >>  8); (ct)[3] = (uint8_t)(st); }
+#endif
+
+#if !USE_AES_SW_BACKEND && !USE_AES_DECRYPT
+#define AES_ENGINE_DECRYPT      0
+#else
+#define AES_ENGINE_DECRYPT      1
+#endif
+
+#if AES_ENGINE_DECRYPT && !AES_ENGINE_SW_KEY
+#error "Decryption needs the key expanded in software"
+#endif
+
+/*
+ * STATIC FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+#if !USE_AES_SW_BACKEND
+/**
+ ****************************************************************************************
+ * @brief Load the key into the BLE core AES block.
+ * @param[in] eng               Engine context
+ ****************************************************************************************
+ */
+static void aes_engine_load_key(const struct aes_engine *eng)
+{
+    ble_aeskey31_0_set(eng->key.ks[3]);
+    ble_aeskey63_32_set(eng->key.ks[2]);
+    ble_aeskey95_64_set(eng->key.ks[1]);
+    ble_aeskey127_96_set(eng->key.ks[0]);
+
+    ble_aesptr_set(EM_BLE_ENC_PLAIN_OFFSET);
+}
+#endif
+
+/*
+ * PUBLIC FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+uint8_t aes_engine_init(struct aes_engine *eng, const uint8_t *key, uint8_t enc_dec,
+                        uint8_t ble_flags)
+{
+    static const uint8_t zero_iv[AES_IV_SIZE] = {0};
+
+    if ((eng == NULL) || (key == NULL) ||
+        ((enc_dec != AES_ENCRYPT) && (enc_dec != AES_DECRYPT)))
+    {
+        return AES_ENGINE_ERR_INVALID_PARAM;
+    }
+
+    eng->enc_dec = enc_dec;
+    eng->ble_flags = ble_flags;
+
+    if (enc_dec == AES_ENCRYPT)
+    {
+#if USE_AES_SW_BACKEND
+        AES_set_key(&eng->key, key, zero_iv, AES_MODE_128);
+#else
+        // The BLE core AES block expands the key itself
+        eng->key.ks[0] = GETU32(key);
+        eng->key.ks[1] = GETU32(key + 4);
+        eng->key.ks[2] = GETU32(key + 8);
+        eng->key.ks[3] = GETU32(key + 12);
+#endif
+        return AES_ENGINE_ERR_NO_ERR;
+    }
+
+#if AES_ENGINE_DECRYPT
+    AES_set_key(&eng->key, key, zero_iv, AES_MODE_128);
+    AES_convert_key(&eng->key);
+
+    return AES_ENGINE_ERR_NO_ERR;
+#else
+    return AES_ENGINE_ERR_NOT_SUPPORTED;
+#endif
+}
+
+uint8_t aes_engine_encrypt(const struct aes_engine *eng, const uint8_t *in, uint8_t *out,
+                           uint32_t block_count, uint8_t *chain)
+{
+    uint32_t i;
+    uint8_t j;
+
+    if ((eng == NULL) || (eng->enc_dec != AES_ENCRYPT) || (in == NULL) ||
+        ((out == NULL) && (chain == NULL)))
+    {
+        return AES_ENGINE_ERR_INVALID_PARAM;
+    }
+
+#if USE_AES_SW_BACKEND
+    for (i = 0; i < block_count; i++, in += AES_ENGINE_BLK_SIZE)
+    {
+        uint8_t *dst = (out != NULL) ? &out[i * AES_ENGINE_BLK_SIZE] : chain;
+        uint32_t data[4];
+
+        for (j = 0; j < 4; j++)
+        {
+            data[j] = GETU32(&in[j * 4]);
+            if (chain != NULL)
+            {
+                data[j] ^= GETU32(&chain[j * 4]);
+            }
+        }
+
+        AES_encrypt(&eng->key, data);
+
+        for (j = 0; j < 4; j++)
+        {
+            PUTU32(&dst[j * 4], data[j]);
+        }
+
+        if ((chain != NULL) && (dst != chain))
+        {
+            memcpy(chain, dst, AES_ENGINE_BLK_SIZE);
+        }
+    }
+#else
+    {
+        uint8_t *plain = (uint8_t *)(EM_BLE_ENC_PLAIN_OFFSET + EM_BASE_ADDR);
+        bool reload = true;
+
+        for (i = 0; i < block_count; i++, in += AES_ENGINE_BLK_SIZE)
+        {
+            uint8_t *dst = (out != NULL) ? &out[i * AES_ENGINE_BLK_SIZE] : chain;
+
+            if (reload)
+            {
+                // Check if an encryption is pending
+                if (llm_le_env.enc_pend)
+                {
+                    return AES_ENGINE_ERR_BUSY;
+                }
+                aes_engine_load_key(eng);
+                reload = false;
+            }
+
+            // Copy the (chained) block to exchange memory, in reverse order
+            for (j = 0; j < AES_ENGINE_BLK_SIZE; j++)
+            {
+                plain[AES_ENGINE_BLK_SIZE - 1 - j] = (chain != NULL) ? (in[j] ^ chain[j]) : in[j];
+            }
+
+            // start the encryption
+            ble_aescntl_set(BLE_AES_START_BIT);
+
+            while (GetWord32(BLE_AESCNTL_REG) == 1)
+            {
+                if (eng->ble_flags & BLE_SAFE_MASK)
+                {
+                    // The link layer may use the AES block in the meantime
+                    rwip_schedule();
+                    reload = true;
+                }
+            }
+
+            // copy data from em to sys ram
+            em_rd(dst, EM_BLE_ENC_CIPHER_OFFSET, AES_ENGINE_BLK_SIZE);
+
+            if ((chain != NULL) && (dst != chain))
+            {
+                memcpy(chain, dst, AES_ENGINE_BLK_SIZE);
+            }
+        }
+    }
+#endif
+
+    return AES_ENGINE_ERR_NO_ERR;
+}
+
+uint8_t aes_engine_decrypt(const struct aes_engine *eng, const uint8_t *in, uint8_t *out,
+                           uint32_t block_count, uint8_t *chain)
+{
+#if AES_ENGINE_DECRYPT
+    uint32_t i;
+    uint8_t j;
+
+    if ((eng == NULL) || (eng->enc_dec != AES_DECRYPT) || (in == NULL) || (out == NULL))
+    {
+        return AES_ENGINE_ERR_INVALID_PARAM;
+    }
+
+    for (i = 0; i < block_count; i++, in += AES_ENGINE_BLK_SIZE, out += AES_ENGINE_BLK_SIZE)
+    {
+        uint32_t data[4];
+
+        for (j = 0; j < 4; j++)
+        {
+            data[j] = GETU32(&in[j * 4]);
+        }
+
+        AES_decrypt(&eng->key, data);
+
+        if (chain != NULL)
+        {
+            // The ciphertext block is the next chaining value; in may be equal to out
+            for (j = 0; j < 4; j++)
+            {
+                uint32_t c = GETU32(&in[j * 4]);
+
+                data[j] ^= GETU32(&chain[j * 4]);
+                PUTU32(&chain[j * 4], c);
+            }
+        }
+
+        for (j = 0; j < 4; j++)
+        {
+            PUTU32(&out[j * 4], data[j]);
+        }
+    }
+
+    return AES_ENGINE_ERR_NO_ERR;
+#else
+    return AES_ENGINE_ERR_NOT_SUPPORTED;
+#endif
+}
+/// @} aes_engine
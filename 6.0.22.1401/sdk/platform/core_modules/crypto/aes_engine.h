@@ -0,0 +1,173 @@
+/**
+ ****************************************************************************************
+ * @addtogroup Core_Modules
+ * @{
+ * @addtogroup Crypto
+ * @{
+ * @addtogroup AES_ENGINE AES Engine
+ * @brief Advanced Encryption Standard multi-block engine API.
+ * @{
+ *
+ * @file aes_engine.h
+ *
+ * @brief AES multi-block engine header file.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef AES_ENGINE_H_
+#define AES_ENGINE_H_
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stdint.h>
+#include "sw_aes.h"
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Use the software AES (sw_aes.c) for encryption instead of the BLE core AES block,
+/// e.g. for host builds
+#if defined (CFG_AES_SW_BACKEND)
+#define USE_AES_SW_BACKEND      1
+#else
+#define USE_AES_SW_BACKEND      0
+#endif
+
+/// Keep the key expanded by the software AES: for the software backend, and for
+/// decryption, which the BLE core AES block does not support
+#if USE_AES_SW_BACKEND || defined (CFG_AES_DECRYPT)
+#define AES_ENGINE_SW_KEY       1
+#else
+#define AES_ENGINE_SW_KEY       0
+#endif
+
+/// Block size (128 bits)
+#define AES_ENGINE_BLK_SIZE     (16)
+
+/*
+ * ENUMERATIONS
+ ****************************************************************************************
+ */
+
+/// Status codes
+enum
+{
+    AES_ENGINE_ERR_NO_ERR,
+    AES_ENGINE_ERR_INVALID_PARAM,
+    /// The BLE core AES block is used by the link layer
+    AES_ENGINE_ERR_BUSY,
+    /// Decryption is not supported (CFG_AES_DECRYPT not defined)
+    AES_ENGINE_ERR_NOT_SUPPORTED,
+};
+
+/*
+ * STRUCTURES
+ ****************************************************************************************
+ */
+
+/// AES engine context: the key, expanded once for all the blocks processed with it
+struct aes_engine
+{
+#if AES_ENGINE_SW_KEY
+    /// Expanded key. Only the first four words are used by the BLE core AES block.
+    AES_CTX key;
+#else
+    /// Key, expanded by the BLE core AES block itself
+    struct
+    {
+        uint32_t ks[4];
+    } key;
+#endif
+
+    /// AES_ENCRYPT or AES_DECRYPT
+    uint8_t enc_dec;
+
+    /// BLE_SAFE_MASK to let rwip_schedule() run while waiting for the BLE core AES block
+    uint8_t ble_flags;
+};
+
+/*
+ * PUBLIC FUNCTIONS DECLARATION
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Set up the key of an AES engine context.
+ * @param[out] eng              Engine context
+ * @param[in] key               Key (128 bits)
+ * @param[in] enc_dec           AES_ENCRYPT or AES_DECRYPT
+ * @param[in] ble_flags         BLE_SAFE_MASK or 0, see aes_enc_dec()
+ * @return                      AES_ENGINE_ERR_NO_ERR on success, error code otherwise
+ ****************************************************************************************
+ */
+uint8_t aes_engine_init(struct aes_engine *eng, const uint8_t *key, uint8_t enc_dec,
+                        uint8_t ble_flags);
+
+/**
+ ****************************************************************************************
+ * @brief Encrypt consecutive blocks, in ECB or in CBC mode.
+ * @param[in] eng               Engine context set up for AES_ENCRYPT
+ * @param[in] in                Input blocks
+ * @param[out] out              Output blocks, may be equal to in. NULL to keep only the
+ *                              last ciphertext block in chain (CBC-MAC).
+ * @param[in] block_count       Number of blocks
+ * @param[in,out] chain         NULL for ECB. For CBC, the IV on input and the last
+ *                              ciphertext block on output.
+ * @return                      AES_ENGINE_ERR_NO_ERR on success, error code otherwise
+ * @note The key is loaded once per call into the BLE core AES block and reloaded only
+ * if rwip_schedule() has run in between.
+ ****************************************************************************************
+ */
+uint8_t aes_engine_encrypt(const struct aes_engine *eng, const uint8_t *in, uint8_t *out,
+                           uint32_t block_count, uint8_t *chain);
+
+/**
+ ****************************************************************************************
+ * @brief Decrypt consecutive blocks, in ECB or in CBC mode.
+ * @param[in] eng               Engine context set up for AES_DECRYPT
+ * @param[in] in                Input blocks
+ * @param[out] out              Output blocks, may be equal to in
+ * @param[in] block_count       Number of blocks
+ * @param[in,out] chain         NULL for ECB. For CBC, the IV on input and the last
+ *                              ciphertext block on output.
+ * @return                      AES_ENGINE_ERR_NO_ERR on success, error code otherwise
+ ****************************************************************************************
+ */
+uint8_t aes_engine_decrypt(const struct aes_engine *eng, const uint8_t *in, uint8_t *out,
+                           uint32_t block_count, uint8_t *chain);
+
+#endif // AES_ENGINE_H_
+
+/// @}
+/// @}
+/// @}
@@ -0,0 +1,214 @@
+/**
+ ****************************************************************************************
+ * @addtogroup Core_Modules
+ * @{
+ * @addtogroup KERNEL
+ * @{
+ * @addtogroup KE_MEM_PROF Kernel Heap Profiler
+ * @brief Allocation profiler and free block snapshots of the kernel heaps
+ * @{
+ *
+ * @file ke_mem_prof.h
+ *
+ * @brief Kernel heap profiler header file.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _KE_MEM_PROF_H_
+#define _KE_MEM_PROF_H_
+
+/*
+ * Kernel heap profiler (CFG_KE_MEM_PROF)
+ *
+ * ke_malloc() and ke_free() are redirected by the ROM patch tables of the system library
+ * to ke_mem_prof_malloc() and ke_mem_prof_free(), so the allocations made by the ROM
+ * stack are profiled as well as those of the application. Every allocation and free is
+ * written as a binary record to the console ring buffer, with the address the caller
+ * returns to. On DA14531 ke_msg_alloc() is patched too, so that a message is owned by the
+ * code that allocates it rather than by ke_msg_alloc(). DA14585/586 has no patch entry
+ * left for it. ke_mem_prof_process(), called from the main loop, writes a snapshot of the
+ * free list of every heap once per KE_MEM_PROF_PERIOD. A snapshot is also written just
+ * before an allocation that cannot be served. That snapshot is sent with blocking UART
+ * writes, because the heap manager asserts right after it.
+ *
+ * The stream is decoded on the host by utilities/heap_prof_decoder. The allocator can be
+ * replayed on the host by utilities/heap_replay.
+ *
+ * Enabled in system_library.h. Requires CFG_PRINTF_RING_BUFFER. The profiler calls the
+ * RAM copies of ke_malloc() and ke_free() of the system library, which log the heap usage
+ * only if CFG_USE_HEAP_LOG is set too. Without CFG_USE_HEAP_LOG it can be used in
+ * production builds. ke_mem_prof.c must be added to the project.
+ *
+ * Record layout (little endian):
+ *   [0]     KE_MEM_PROF_MARKER
+ *   [1]     record type (enum ke_mem_prof_rec)
+ *   [2]     sequence number, increments by one per record, to detect dropped records
+ *   [3]     payload length
+ *   [4..]   payload
+ *
+ * Payloads:
+ *   KE_MEM_PROF_REC_INFO:  time(4) heap_count(1), then per heap base(4) size(2)
+ *   KE_MEM_PROF_REC_ALLOC: time(4) site(4) size(2) heap(1) offset(2) block(2)
+ *   KE_MEM_PROF_REC_FREE:  time(4) site(4) heap(1) offset(2) block(2)
+ *   KE_MEM_PROF_REC_FAIL:  time(4) site(4) size(2) type(1)
+ *   KE_MEM_PROF_REC_HEAP:  time(4) heap(1) flags(1) free(2) largest(2) blocks(2)
+ *                          count(1), then per listed free block offset(2) size(2)
+ *
+ * Times are in units of 625 us. Offsets are from the base of the heap. The size of an
+ * allocation is the requested size and block is the size taken from the heap, block
+ * descriptor included.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "system_library.h"
+#include "ke_msg.h"
+
+#if defined (CFG_KE_MEM_PROF)
+
+#if !defined (CFG_PRINTF_RING_BUFFER)
+    #error "CFG_KE_MEM_PROF requires CFG_PRINTF_RING_BUFFER to be defined."
+#endif
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Snapshot period in ms
+#ifndef CFG_KE_MEM_PROF_PERIOD
+#define KE_MEM_PROF_PERIOD                  (1000)
+#else
+#define KE_MEM_PROF_PERIOD                  (CFG_KE_MEM_PROF_PERIOD)
+#endif
+
+/// Maximum number of free blocks listed in a heap snapshot (up to 60)
+#ifndef CFG_KE_MEM_PROF_BLOCKS
+#define KE_MEM_PROF_BLOCKS                  (32)
+#else
+#define KE_MEM_PROF_BLOCKS                  (CFG_KE_MEM_PROF_BLOCKS)
+#endif
+
+#if (KE_MEM_PROF_BLOCKS > 60)
+    #error "CFG_KE_MEM_PROF_BLOCKS must not be larger than 60."
+#endif
+
+#endif // CFG_KE_MEM_PROF
+
+/// First byte of a heap profiler record
+#define KE_MEM_PROF_MARKER                  (0x1D)
+
+/// Length of the heap profiler record header
+#define KE_MEM_PROF_HDR_LEN                 (4)
+
+/// Heap snapshot flags
+enum ke_mem_prof_heap_flags
+{
+    /// More free blocks than KE_MEM_PROF_BLOCKS, only the first ones are listed
+    KE_MEM_PROF_HEAP_TRUNCATED = 0x01,
+    /// A free block descriptor is corrupted, the list stops before it
+    KE_MEM_PROF_HEAP_CORRUPTED = 0x02,
+    /// Snapshot written because an allocation failed
+    KE_MEM_PROF_HEAP_ON_FAIL   = 0x04,
+};
+
+/// Heap profiler record types
+enum ke_mem_prof_rec
+{
+    /// Heap bases and sizes
+    KE_MEM_PROF_REC_INFO = 1,
+    /// Allocation
+    KE_MEM_PROF_REC_ALLOC,
+    /// Free
+    KE_MEM_PROF_REC_FREE,
+    /// Allocation that cannot be served
+    KE_MEM_PROF_REC_FAIL,
+    /// Free list of a heap
+    KE_MEM_PROF_REC_HEAP,
+};
+
+#if defined (CFG_KE_MEM_PROF)
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Profiled ke_malloc(). Patched in place of the ROM ke_malloc().
+ * @param[in] size          Size of the memory area to allocate
+ * @param[in] type          Type of memory block
+ * @return Pointer to the allocated memory area
+ ****************************************************************************************
+ */
+void *ke_mem_prof_malloc(uint32_t size, uint8_t type);
+
+/**
+ ****************************************************************************************
+ * @brief Profiled ke_free(). Patched in place of the ROM ke_free().
+ * @param[in] mem_ptr       Pointer to the memory area to free
+ ****************************************************************************************
+ */
+void ke_mem_prof_free(void *mem_ptr);
+
+#if defined (__DA14531__)
+/**
+ ****************************************************************************************
+ * @brief Profiled ke_msg_alloc(). Patched in place of the ROM ke_msg_alloc().
+ * @param[in] id            Message identifier
+ * @param[in] dest_id       Destination task identifier
+ * @param[in] src_id        Source task identifier
+ * @param[in] param_len     Size of the message parameters
+ * @return Pointer to the message parameters, set to zero
+ ****************************************************************************************
+ */
+void *ke_mem_prof_msg_alloc(ke_msg_id_t const id, ke_task_id_t const dest_id,
+                            ke_task_id_t const src_id, uint16_t const param_len);
+#endif
+
+/**
+ ****************************************************************************************
+ * @brief Write the heap bases and sizes and a snapshot of every heap.
+ ****************************************************************************************
+ */
+void ke_mem_prof_snapshot(void);
+
+/**
+ ****************************************************************************************
+ * @brief Write the periodic snapshots. Called from the main loop.
+ ****************************************************************************************
+ */
+void ke_mem_prof_process(void);
+
+#endif // CFG_KE_MEM_PROF
+
+#endif // _KE_MEM_PROF_H_
+
+///@}
+///@}
+///@}
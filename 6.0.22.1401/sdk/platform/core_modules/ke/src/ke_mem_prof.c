@@ -0,0 +1,457 @@
+/**
+ ****************************************************************************************
+ *
+ * @file ke_mem_prof.c
+ *
+ * @brief Kernel heap profiler source file.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @addtogroup KE_MEM_PROF
+ * @{
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include "ke_mem_prof.h"
+
+#if defined (CFG_KE_MEM_PROF)
+
+#include <string.h>
+#include "compiler.h"
+#include "datasheet.h"
+#include "arch.h"
+#include "ll.h"
+#include "user_config_defs.h"
+#include "co_math.h"
+#include "ke_mem.h"
+#include "ke_env.h"
+#include "lld_evt.h"
+#include "arch_console.h"
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Patterns of the block descriptors of the ROM heap manager
+#define KE_MEM_PROF_LIST_PATTERN            (0xA55A)
+#define KE_MEM_PROF_ALLOCATED_PATTERN       (0x8338)
+
+/// Snapshot period in units of 625 us
+#define KE_MEM_PROF_PERIOD_SLOTS            ((KE_MEM_PROF_PERIOD * 8) / 5)
+
+/// Largest payload of a record
+#define KE_MEM_PROF_HEAP_HDR_LEN            (13)
+#define KE_MEM_PROF_PAYLOAD_MAX             (KE_MEM_PROF_HEAP_HDR_LEN + 4 * KE_MEM_PROF_BLOCKS)
+
+/// Address the profiled function returns to
+#if defined (__CC_ARM)
+#define KE_MEM_PROF_CALLER()                ((uint32_t)__return_address())
+#elif defined (__ICCARM__)
+#define KE_MEM_PROF_CALLER()                ((uint32_t)__get_LR())
+#else
+#define KE_MEM_PROF_CALLER()                ((uint32_t)__builtin_return_address(0))
+#endif
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/// Free block descriptor of the ROM heap manager
+struct ke_mem_prof_free_blk
+{
+    struct ke_mem_prof_free_blk *next;
+    struct ke_mem_prof_free_blk *previous;
+    uint16_t free_size;
+    uint16_t corrupt_check;
+};
+
+/// Used block descriptor of the ROM heap manager, just before the allocated area
+struct ke_mem_prof_used_blk
+{
+    uint16_t size;
+    uint16_t corrupt_check;
+};
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+// RAM copies of the heap manager, in the system library. They log the heap usage only
+// if CFG_USE_HEAP_LOG is set too.
+void PATCHED_ke_free(void* mem_ptr);
+void *PATCHED_ke_malloc(uint32_t size, uint8_t type);
+
+/*
+ * LOCAL VARIABLE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/// Position of the heaps in the ROM configuration table, in the order of the heap types
+static const uint8_t heap_cfg_pos[KE_MEM_BLOCK_MAX] =
+{
+    rwip_heap_env_pos,
+    rwip_heap_db_pos,
+    rwip_heap_msg_pos,
+    rwip_heap_non_ret_pos,
+};
+
+static uint8_t prof_seq                 __SECTION_ZERO("retention_mem_area0");
+static uint32_t prof_last_time          __SECTION_ZERO("retention_mem_area0");
+static uint32_t prof_snapshot_time      __SECTION_ZERO("retention_mem_area0");
+static bool prof_drain                  __SECTION_ZERO("retention_mem_area0"); // records are sent before prof_put() returns
+
+/*
+ * STATIC FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+static uint8_t *put16(uint8_t *p, uint16_t val)
+{
+    p[0] = (uint8_t)val;
+    p[1] = (uint8_t)(val >> 8);
+    return p + 2;
+}
+
+static uint8_t *put32(uint8_t *p, uint32_t val)
+{
+    p = put16(p, (uint16_t)val);
+    return put16(p, (uint16_t)(val >> 16));
+}
+
+/**
+ ****************************************************************************************
+ * @brief Get the current time. The base time counter of the BLE core is only read while
+ *        the radio power domain is up, otherwise the last time is returned.
+ * @return Time in units of 625 us
+ ****************************************************************************************
+ */
+static uint32_t prof_time(void)
+{
+    if (GetBits16(SYS_STAT_REG, RAD_IS_UP))
+    {
+        prof_last_time = lld_evt_time_get();
+    }
+
+    return prof_last_time;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Write a record to the console ring buffer.
+ * @param[in] rec           Record, payload at KE_MEM_PROF_HDR_LEN
+ * @param[in] type          Record type
+ * @param[in] end           End of the payload
+ ****************************************************************************************
+ */
+static void prof_put(uint8_t *rec, uint8_t type, const uint8_t *end)
+{
+    uint8_t len = end - rec - KE_MEM_PROF_HDR_LEN;
+
+    rec[0] = KE_MEM_PROF_MARKER;
+    rec[1] = type;
+    rec[3] = len;
+
+    GLOBAL_INT_DISABLE();
+    // A dropped record still takes its sequence number, so the host sees the gap
+    rec[2] = prof_seq++;
+    arch_printf_write(rec, KE_MEM_PROF_HDR_LEN + len);
+    GLOBAL_INT_RESTORE();
+
+    if (prof_drain)
+    {
+        arch_printf_drain();
+    }
+}
+
+static uint32_t prof_heap_base(uint8_t type)
+{
+    return CO_ALIGN4_HI(rom_cfg_table[heap_cfg_pos[type]]);
+}
+
+static uint16_t prof_heap_size(uint8_t type)
+{
+    return rom_cfg_table[heap_cfg_pos[type] + 1] - (prof_heap_base(type) - rom_cfg_table[heap_cfg_pos[type]]);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Find the heap of an allocated area.
+ * @param[in] ptr           Allocated area
+ * @param[out] offset       Offset of the area from the base of the heap
+ * @return Heap type, KE_MEM_BLOCK_MAX if the area is in no heap
+ ****************************************************************************************
+ */
+static uint8_t prof_heap_of(const void *ptr, uint16_t *offset)
+{
+    for (uint8_t type = 0; type < KE_MEM_BLOCK_MAX; type++)
+    {
+        uint32_t base = prof_heap_base(type);
+
+        if (((uint32_t)ptr >= base) && ((uint32_t)ptr < base + prof_heap_size(type)))
+        {
+            *offset = (uint32_t)ptr - base;
+            return type;
+        }
+    }
+
+    *offset = 0;
+    return KE_MEM_BLOCK_MAX;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Get the size of the block of an allocated area.
+ * @param[in] ptr           Allocated area
+ * @return Block size, descriptor included, 0 if the descriptor is corrupted
+ ****************************************************************************************
+ */
+static uint16_t prof_block_size(const void *ptr)
+{
+    const struct ke_mem_prof_used_blk *used = (const struct ke_mem_prof_used_blk *)ptr - 1;
+
+    return (used->corrupt_check == KE_MEM_PROF_ALLOCATED_PATTERN) ? used->size : 0;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Write the free list of a heap. The descriptors are checked while the list is
+ *        walked and the walk stops at the first corrupted one.
+ * @param[in] type          Heap type
+ * @param[in] time          Time of the snapshot
+ * @param[in] flags         Initial snapshot flags
+ ****************************************************************************************
+ */
+static void prof_heap_snapshot(uint8_t type, uint32_t time, uint8_t flags)
+{
+    uint8_t rec[KE_MEM_PROF_HDR_LEN + KE_MEM_PROF_PAYLOAD_MAX];
+    uint8_t *list = rec + KE_MEM_PROF_HDR_LEN + KE_MEM_PROF_HEAP_HDR_LEN;
+    uint32_t base = prof_heap_base(type);
+    uint32_t end = base + prof_heap_size(type);
+    uint32_t total = 0;
+    uint16_t largest = 0;
+    uint16_t blocks = 0;
+    uint8_t count = 0;
+    uint8_t *p;
+
+    GLOBAL_INT_DISABLE();
+
+    for (const struct ke_mem_prof_free_blk *node = (const struct ke_mem_prof_free_blk *)ke_env.heap[type];
+         node != NULL; node = node->next)
+    {
+        if (((uint32_t)node < base) || ((uint32_t)node + sizeof(*node) > end) ||
+            (node->corrupt_check != KE_MEM_PROF_LIST_PATTERN) ||
+            ((uint32_t)node + node->free_size > end) ||
+            (blocks >= (end - base) / sizeof(*node)))
+        {
+            flags |= KE_MEM_PROF_HEAP_CORRUPTED;
+            break;
+        }
+
+        if (count < KE_MEM_PROF_BLOCKS)
+        {
+            list = put16(list, (uint32_t)node - base);
+            list = put16(list, node->free_size);
+            count++;
+        }
+        else
+        {
+            flags |= KE_MEM_PROF_HEAP_TRUNCATED;
+        }
+
+        total += node->free_size;
+        largest = co_max(largest, node->free_size);
+        blocks++;
+    }
+
+    GLOBAL_INT_RESTORE();
+
+    p = put32(rec + KE_MEM_PROF_HDR_LEN, time);
+    *p++ = type;
+    *p++ = flags;
+    p = put16(p, total);
+    p = put16(p, largest);
+    p = put16(p, blocks);
+    *p++ = count;
+
+    prof_put(rec, KE_MEM_PROF_REC_HEAP, list);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Write the heap bases and sizes and a snapshot of every heap.
+ * @param[in] time          Time of the snapshot
+ * @param[in] flags         Snapshot flags
+ ****************************************************************************************
+ */
+static void prof_snapshot_all(uint32_t time, uint8_t flags)
+{
+    uint8_t rec[KE_MEM_PROF_HDR_LEN + 5 + 6 * KE_MEM_BLOCK_MAX];
+    uint8_t *p = put32(rec + KE_MEM_PROF_HDR_LEN, time);
+
+    *p++ = KE_MEM_BLOCK_MAX;
+    for (uint8_t type = 0; type < KE_MEM_BLOCK_MAX; type++)
+    {
+        p = put32(p, prof_heap_base(type));
+        p = put16(p, prof_heap_size(type));
+    }
+    prof_put(rec, KE_MEM_PROF_REC_INFO, p);
+
+    for (uint8_t type = 0; type < KE_MEM_BLOCK_MAX; type++)
+    {
+        prof_heap_snapshot(type, time, flags);
+    }
+
+    prof_snapshot_time = time;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Allocate and write the allocation record.
+ * @param[in] size          Size of the memory area to allocate
+ * @param[in] type          Type of memory block
+ * @param[in] site          Address the allocating function returns to
+ * @return Pointer to the allocated memory area
+ ****************************************************************************************
+ */
+static void *prof_malloc(uint32_t size, uint8_t type, uint32_t site)
+{
+    uint8_t rec[KE_MEM_PROF_HDR_LEN + 15];
+    uint32_t time = prof_time();
+    uint8_t *p = put32(rec + KE_MEM_PROF_HDR_LEN, time);
+    uint16_t offset;
+    uint8_t heap;
+    void *ptr;
+
+    p = put32(p, site);
+    p = put16(p, size);
+
+    // The heap manager asserts when it runs out of memory, so the failure is reported
+    // before the allocation is attempted. Nothing runs after the assertion to empty the
+    // console ring, so the records are sent with blocking writes, one by one, so that
+    // a snapshot larger than the ring is not dropped.
+    if (!ke_check_malloc(size, type))
+    {
+        *p++ = type;
+        prof_drain = true;
+        arch_printf_drain();
+        prof_put(rec, KE_MEM_PROF_REC_FAIL, p);
+        prof_snapshot_all(time, KE_MEM_PROF_HEAP_ON_FAIL);
+        prof_drain = false;
+    }
+
+    ptr = PATCHED_ke_malloc(size, type);
+
+    if (ptr != NULL)
+    {
+        heap = prof_heap_of(ptr, &offset);
+        *p++ = heap;
+        p = put16(p, offset);
+        p = put16(p, prof_block_size(ptr));
+        prof_put(rec, KE_MEM_PROF_REC_ALLOC, p);
+    }
+
+    return ptr;
+}
+
+/*
+ * GLOBAL FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+void *ke_mem_prof_malloc(uint32_t size, uint8_t type)
+{
+    return prof_malloc(size, type, KE_MEM_PROF_CALLER());
+}
+
+void ke_mem_prof_free(void *mem_ptr)
+{
+    uint8_t rec[KE_MEM_PROF_HDR_LEN + 13];
+    uint8_t *p = put32(rec + KE_MEM_PROF_HDR_LEN, prof_time());
+    uint16_t offset;
+
+    p = put32(p, KE_MEM_PROF_CALLER());
+    *p++ = prof_heap_of(mem_ptr, &offset);
+    p = put16(p, offset);
+    // The block size is read before the descriptor is merged into the free list
+    p = put16(p, prof_block_size(mem_ptr));
+    prof_put(rec, KE_MEM_PROF_REC_FREE, p);
+
+    PATCHED_ke_free(mem_ptr);
+}
+
+#if defined (__DA14531__)
+void *ke_mem_prof_msg_alloc(ke_msg_id_t const id, ke_task_id_t const dest_id,
+                            ke_task_id_t const src_id, uint16_t const param_len)
+{
+    struct ke_msg *msg = (struct ke_msg *)prof_malloc(sizeof(struct ke_msg) + param_len - sizeof(uint32_t),
+                                                      KE_MEM_KE_MSG, KE_MEM_PROF_CALLER());
+    void *param_ptr;
+
+    ASSERT_ERROR(msg != NULL);
+
+    msg->hdr.next = NULL;
+    msg->saved = 0;
+    msg->id = id;
+    msg->dest_id = dest_id;
+    msg->src_id = src_id;
+    msg->param_len = param_len;
+
+    param_ptr = ke_msg2param(msg);
+    memset(param_ptr, 0, param_len);
+
+    return param_ptr;
+}
+#endif
+
+void ke_mem_prof_snapshot(void)
+{
+    prof_snapshot_all(prof_time(), 0);
+}
+
+void ke_mem_prof_process(void)
+{
+    uint32_t time = prof_time();
+
+    if (((time - prof_snapshot_time) & BLE_BASETIMECNT_MASK) >= KE_MEM_PROF_PERIOD_SLOTS)
+    {
+        prof_snapshot_all(time, 0);
+    }
+}
+
+#endif // CFG_KE_MEM_PROF
+
+/// @} KE_MEM_PROF
@@ -0,0 +1,168 @@
+/**
+ ****************************************************************************************
+ * @addtogroup Core_Modules
+ * @{
+ * @addtogroup ADAPTIVE_TX_PWR Adaptive TX power
+ * @brief Per connection adaptive TX output power control
+ * @{
+ *
+ * @file adaptive_tx_pwr.h
+ *
+ * @brief Per connection adaptive TX output power control header file.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _ADAPTIVE_TX_PWR_H_
+#define _ADAPTIVE_TX_PWR_H_
+
+/*
+ * Adaptive TX power (CFG_ADAPTIVE_TX_PWR, with CFG_ENHANCED_TX_PWR_CTRL, DA14531 family)
+ *
+ * Every connection transmits at the lowest level of rf_tx_pwr_lvl_t that keeps the peer
+ * receiving it at ADAPTIVE_TX_PWR_TARGET dBm. The path loss is taken from the RSSI of the
+ * packets of the peer, assumed to transmit at ADAPTIVE_TX_PWR_PEER_TX dBm, since the link
+ * is reciprocal. The loop is closed on the acknowledgments of the peer: a packet of the
+ * peer whose NESN bit does not toggle reports that our previous packet was lost. Losses
+ * and receive errors above ADAPTIVE_TX_PWR_LOSS_HIGH raise a correction of the target,
+ * which decays back while the link is clean, so a wrong assumption on the peer or an
+ * asymmetric link is compensated.
+ *
+ * The RSSI and the loss ratio are filtered per packet. A decision is taken every
+ * ADAPTIVE_TX_PWR_PERIOD connection events: the level rises at once to the required one
+ * and falls by one step at a time, once the required level is ADAPTIVE_TX_PWR_HYST_DB
+ * below the current one.
+ *
+ * The level stays within the limits of the application, by default from the lowest level
+ * up to the level of the connection when it starts (rf_pa_pwr_adv_set()).
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "rf_531.h"
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// RSSI the peer should receive our packets at (dBm)
+#ifndef CFG_ADAPTIVE_TX_PWR_TARGET
+#define ADAPTIVE_TX_PWR_TARGET              (-80)
+#else
+#define ADAPTIVE_TX_PWR_TARGET              (CFG_ADAPTIVE_TX_PWR_TARGET)
+#endif
+
+/// Assumed TX output power of the peer (dBm)
+#ifndef CFG_ADAPTIVE_TX_PWR_PEER_TX
+#define ADAPTIVE_TX_PWR_PEER_TX             (0)
+#else
+#define ADAPTIVE_TX_PWR_PEER_TX             (CFG_ADAPTIVE_TX_PWR_PEER_TX)
+#endif
+
+/// Connection events between two decisions
+#define ADAPTIVE_TX_PWR_PERIOD              (8)
+
+/// Margin above the required level before stepping down (dB)
+#define ADAPTIVE_TX_PWR_HYST_DB             (3)
+
+/// Loss ratios raising and lowering the correction (1/65536)
+#define ADAPTIVE_TX_PWR_LOSS_HIGH           (6554)      // 10%
+#define ADAPTIVE_TX_PWR_LOSS_LOW            (1311)      // 2%
+
+/// Status of a connection
+struct adaptive_tx_pwr_status
+{
+    /// Current level
+    rf_tx_pwr_lvl_t level;
+    /// Filtered RSSI of the peer (dBm)
+    int8_t rssi;
+    /// Correction of the target (0.5 dB)
+    int8_t offset;
+    /// Filtered loss ratio (1/65536)
+    uint16_t loss;
+};
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Initialize the adaptive TX power control. The limits are reset.
+ * @param[in] rssi_convert  Conversion of the RSSI read from a RX descriptor to dBm
+ ****************************************************************************************
+ */
+void adaptive_tx_pwr_init(uint8_t (*rssi_convert)(uint8_t));
+
+/**
+ ****************************************************************************************
+ * @brief Account a RX descriptor. Called from the BLE interrupts.
+ * @param[in] link          Link label of the descriptor
+ * @param[in] status        Reception status of the descriptor
+ * @param[in] header        Header of the received packet
+ * @param[in] rssi          RSSI of the descriptor, as read from it
+ ****************************************************************************************
+ */
+void adaptive_tx_pwr_rx(uint8_t link, uint16_t status, uint16_t header, uint8_t rssi);
+
+/**
+ ****************************************************************************************
+ * @brief Account the end of a BLE event and adapt the level of its connection. Called
+ * from the BLE end of event interrupt, after the RX descriptors of the event.
+ * @param[in] conhdl        Connection handle, or LLD_ADV_HDL
+ * @param[in] counter       Connection event counter
+ ****************************************************************************************
+ */
+void adaptive_tx_pwr_event_end(uint8_t conhdl, uint16_t counter);
+
+/**
+ ****************************************************************************************
+ * @brief Limit the levels of a connection, e.g. to cap the peak current or to meet a
+ * regulatory limit. The limits hold for the next connections on the index, until
+ * changed. With min_lvl equal to max_lvl the level is fixed.
+ * @param[in] conidx        Connection index
+ * @param[in] min_lvl       Lowest level
+ * @param[in] max_lvl       Highest level, 0 for the level of the connection when it starts
+ ****************************************************************************************
+ */
+void adaptive_tx_pwr_limit_set(uint8_t conidx, rf_tx_pwr_lvl_t min_lvl, rf_tx_pwr_lvl_t max_lvl);
+
+/**
+ ****************************************************************************************
+ * @brief Read the status of a connection.
+ * @param[in] conidx        Connection index
+ * @param[out] status       Status
+ * @return false if the connection index is invalid or the connection has no RSSI yet
+ ****************************************************************************************
+ */
+bool adaptive_tx_pwr_status_get(uint8_t conidx, struct adaptive_tx_pwr_status *status);
+
+#endif // _ADAPTIVE_TX_PWR_H_
+
+///@}
+///@}
@@ -0,0 +1,346 @@
+/**
+ ****************************************************************************************
+ * @addtogroup ADAPTIVE_TX_PWR
+ * @{
+ *
+ * @file adaptive_tx_pwr.c
+ *
+ * @brief Per connection adaptive TX output power control.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include "arch.h"
+
+#if (ADAPTIVE_TX_PWR)
+
+#if !defined (__DA14531__) || !defined (CFG_ENHANCED_TX_PWR_CTRL)
+    #error "CFG_ADAPTIVE_TX_PWR requires the DA14531 family and CFG_ENHANCED_TX_PWR_CTRL."
+#endif
+
+#include <string.h>
+#include "rwip_config.h"
+#include "reg_ble_em_rx_desc.h"
+#include "adaptive_tx_pwr.h"
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Bounds of the correction of the target (0.5 dB)
+#define ADAPTIVE_TX_PWR_OFFSET_MAX      (40)
+#define ADAPTIVE_TX_PWR_OFFSET_MIN      (-20)
+
+/// Correction steps (0.5 dB)
+#define ADAPTIVE_TX_PWR_OFFSET_UP       (6)
+#define ADAPTIVE_TX_PWR_OFFSET_DOWN     (1)
+
+/// Decisions without a raise of the correction after one, for the loss filter to settle
+#define ADAPTIVE_TX_PWR_HOLD            (4)
+
+/// Clean decisions before each lowering of the correction
+#define ADAPTIVE_TX_PWR_CLEAN           (8)
+
+/// RSSI and loss filter weights of a new sample (1/2^n)
+#define ADAPTIVE_TX_PWR_RSSI_SHIFT      (3)
+#define ADAPTIVE_TX_PWR_LOSS_SHIFT      (5)
+
+/// No NESN received yet
+#define ADAPTIVE_TX_PWR_NO_NESN         (0xFF)
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/// Control state of a connection
+struct adaptive_tx_pwr_link
+{
+    /// Filtered RSSI (1/16 dBm)
+    int16_t rssi;
+    /// Filtered loss ratio (1/65536)
+    uint16_t loss;
+    /// Event counter of the last event
+    uint16_t counter;
+    /// Correction of the target (0.5 dB)
+    int8_t offset;
+    /// Highest level of the connection
+    uint8_t max_lvl;
+    /// Events since the last decision
+    uint8_t events;
+    /// Decisions left before the correction may rise again
+    uint8_t hold;
+    /// Consecutive decisions below ADAPTIVE_TX_PWR_LOSS_LOW
+    uint8_t clean;
+    /// NESN of the last packet received without error
+    uint8_t nesn;
+    /// The connection has had an event
+    bool used;
+    /// The RSSI has a sample
+    bool rssi_valid;
+};
+
+/*
+ * LOCAL VARIABLE DEFINITIONS
+ ****************************************************************************************
+ */
+
+static struct adaptive_tx_pwr_link links[BLE_CONNECTION_MAX]     __SECTION_ZERO("retention_mem_area0");
+
+/// Limits of the application, 0 for the default
+static uint8_t limit_min[BLE_CONNECTION_MAX]                      __SECTION_ZERO("retention_mem_area0");
+static uint8_t limit_max[BLE_CONNECTION_MAX]                      __SECTION_ZERO("retention_mem_area0");
+
+static uint8_t (*rssi_to_dbm)(uint8_t)                            __SECTION_ZERO("retention_mem_area0");
+
+/// Output power of the levels, from RF_TX_PWR_LVL_MIN_DBM (0.5 dB)
+#if defined (__DA14535__)
+static const int8_t level_dbm[RF_TX_PWR_LVL_TOTAL_VALUES] = {-36, -24, -18, -12, -8, -5, -2, 0, 3, 5, 6, 8};
+#else
+static const int8_t level_dbm[RF_TX_PWR_LVL_TOTAL_VALUES] = {-39, -27, -20, -14, -10, -7, -4, -2, 0, 2, 3, 5};
+#endif
+
+/*
+ * LOCAL FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+static void start(uint8_t conidx, uint16_t counter)
+{
+    struct adaptive_tx_pwr_link *link = &links[conidx];
+
+    memset(link, 0, sizeof(*link));
+    link->used = true;
+    link->counter = counter;
+    link->nesn = ADAPTIVE_TX_PWR_NO_NESN;
+    link->max_lvl = limit_max[conidx] ? limit_max[conidx] : rf_pa_pwr_adv_get();
+
+    // Start from the highest level: the first decision lowers it if the link allows
+    rf_pa_pwr_conn_set((rf_tx_pwr_lvl_t) link->max_lvl, conidx);
+}
+
+static void adapt(uint8_t conidx, struct adaptive_tx_pwr_link *link)
+{
+    uint8_t min_lvl = limit_min[conidx] ? limit_min[conidx] : RF_TX_PWR_LVL_MIN_DBM;
+    uint8_t level = rf_pa_pwr_conn_get(conidx);
+    uint8_t target = min_lvl;
+    int16_t required;
+
+    // Close the loop on the losses
+    if (link->hold)
+    {
+        link->hold--;
+    }
+    if (link->loss > ADAPTIVE_TX_PWR_LOSS_HIGH)
+    {
+        if (!link->hold && (link->offset < ADAPTIVE_TX_PWR_OFFSET_MAX))
+        {
+            link->offset += ADAPTIVE_TX_PWR_OFFSET_UP;
+            link->hold = ADAPTIVE_TX_PWR_HOLD;
+        }
+        link->clean = 0;
+    }
+    else if (link->loss < ADAPTIVE_TX_PWR_LOSS_LOW)
+    {
+        if ((++link->clean >= ADAPTIVE_TX_PWR_CLEAN) && (link->offset > ADAPTIVE_TX_PWR_OFFSET_MIN))
+        {
+            link->offset -= ADAPTIVE_TX_PWR_OFFSET_DOWN;
+            link->clean = 0;
+        }
+    }
+    else
+    {
+        link->clean = 0;
+    }
+
+    // Output power giving the target at the peer through the path loss (0.5 dB)
+    required = 2 * (ADAPTIVE_TX_PWR_TARGET + ADAPTIVE_TX_PWR_PEER_TX) - link->rssi / 8 + link->offset;
+
+    while ((target < link->max_lvl) && (level_dbm[target - 1] < required))
+    {
+        target++;
+    }
+
+    if (target > level)
+    {
+        level = target;
+    }
+    else if ((target < level) && (level_dbm[level - 2] >= required + 2 * ADAPTIVE_TX_PWR_HYST_DB))
+    {
+        level--;
+    }
+
+    if (level > link->max_lvl)
+    {
+        level = link->max_lvl;
+    }
+    if (level < min_lvl)
+    {
+        level = min_lvl;
+    }
+
+    if (level != rf_pa_pwr_conn_get(conidx))
+    {
+        rf_pa_pwr_conn_set((rf_tx_pwr_lvl_t) level, conidx);
+    }
+}
+
+/*
+ * EXPORTED FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+void adaptive_tx_pwr_init(uint8_t (*rssi_convert)(uint8_t))
+{
+    memset(links, 0, sizeof(links));
+    memset(limit_min, 0, sizeof(limit_min));
+    memset(limit_max, 0, sizeof(limit_max));
+    rssi_to_dbm = rssi_convert;
+}
+
+void adaptive_tx_pwr_rx(uint8_t link_id, uint16_t status, uint16_t header, uint8_t rssi)
+{
+    struct adaptive_tx_pwr_link *link;
+    int32_t loss;
+    bool lost;
+
+    if ((link_id >= BLE_CONNECTION_MAX) || !links[link_id].used)
+    {
+        return;
+    }
+
+    link = &links[link_id];
+
+    if (status & BLE_SYNC_ERR_BIT)
+    {
+        // No answer: as a master, mostly our packet was not received
+        lost = true;
+    }
+    else if (status & (BLE_CRC_ERR_BIT | BLE_MIC_ERR_BIT | BLE_LEN_ERR_BIT | BLE_TYPE_ERR_BIT))
+    {
+        // Our packet was received, the answer of the peer was not: not our link budget
+        return;
+    }
+    else
+    {
+        int16_t dbm = (int8_t) rssi_to_dbm(rssi);
+        uint8_t nesn = (header & BLE_RXNESN_BIT) ? 1 : 0;
+
+        // The peer acknowledges our previous packet by toggling its NESN
+        lost = (nesn == link->nesn);
+        link->nesn = nesn;
+
+        if (link->rssi_valid)
+        {
+            link->rssi += ((dbm << 4) - link->rssi) / (1 << ADAPTIVE_TX_PWR_RSSI_SHIFT);
+        }
+        else
+        {
+            link->rssi = dbm << 4;
+            link->rssi_valid = true;
+        }
+    }
+
+    loss = link->loss;
+    loss += ((lost ? 0xFFFF : 0) - loss) / (1 << ADAPTIVE_TX_PWR_LOSS_SHIFT);
+    link->loss = (uint16_t) loss;
+}
+
+void adaptive_tx_pwr_event_end(uint8_t conhdl, uint16_t counter)
+{
+    struct adaptive_tx_pwr_link *link;
+
+    if (conhdl >= BLE_CONNECTION_MAX)
+    {
+        return;
+    }
+
+    link = &links[conhdl];
+
+    // The event counter restarts with a new connection on the handle
+    if (!link->used
+        || ((counter <= link->counter) && !((link->counter >= 0xF000) && (counter < 0x1000))))
+    {
+        start(conhdl, counter);
+        return;
+    }
+
+    link->counter = counter;
+
+    if ((++link->events >= ADAPTIVE_TX_PWR_PERIOD) && link->rssi_valid)
+    {
+        link->events = 0;
+        adapt(conhdl, link);
+    }
+}
+
+void adaptive_tx_pwr_limit_set(uint8_t conidx, rf_tx_pwr_lvl_t min_lvl, rf_tx_pwr_lvl_t max_lvl)
+{
+    ASSERT_WARNING(conidx < BLE_CONNECTION_MAX);
+    ASSERT_WARNING(!max_lvl || (min_lvl <= max_lvl));
+
+    GLOBAL_INT_DISABLE();
+    limit_min[conidx] = min_lvl;
+    limit_max[conidx] = max_lvl;
+
+    // Applied at the next event of a running connection
+    if (links[conidx].used)
+    {
+        links[conidx].max_lvl = max_lvl ? max_lvl : rf_pa_pwr_adv_get();
+        links[conidx].events = ADAPTIVE_TX_PWR_PERIOD;
+    }
+    GLOBAL_INT_RESTORE();
+}
+
+bool adaptive_tx_pwr_status_get(uint8_t conidx, struct adaptive_tx_pwr_status *status)
+{
+    struct adaptive_tx_pwr_link *link;
+
+    if ((conidx >= BLE_CONNECTION_MAX) || !links[conidx].used || !links[conidx].rssi_valid)
+    {
+        return false;
+    }
+
+    link = &links[conidx];
+    GLOBAL_INT_DISABLE();
+    status->level = rf_pa_pwr_conn_get(conidx);
+    status->rssi = (int8_t) ((link->rssi + 8) >> 4);
+    status->offset = link->offset;
+    status->loss = link->loss;
+    GLOBAL_INT_RESTORE();
+
+    return true;
+}
+
+#endif // ADAPTIVE_TX_PWR
+
+///@}
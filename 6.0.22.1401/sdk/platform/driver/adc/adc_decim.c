@@ -0,0 +1,227 @@
+/**
+ ****************************************************************************************
+ *
+ * @file adc_decim.c
+ *
+ * @brief GP ADC decimation and correction stage.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stddef.h>
+#include "compiler.h"
+#include "arch.h"
+#include "adc_decim.h"
+
+/*
+ * LOCAL FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Run the integrators over samples.
+ * @param[in,out] decim     Decimator
+ * @param[in] in            Raw samples
+ * @param[in] nb            Number of samples
+ ****************************************************************************************
+ */
+__STATIC_INLINE void adc_decim_integrate(adc_decim_t *decim, const uint16_t *in, uint16_t nb)
+{
+    uint32_t i0 = decim->integ[0];
+    uint32_t i1 = decim->integ[1];
+    uint32_t i2 = decim->integ[2];
+
+    // One loop per order, the integrators stay in registers
+    switch (decim->order)
+    {
+        case 1:
+            while (nb--)
+            {
+                i0 += *in++;
+            }
+            break;
+
+        case 2:
+            while (nb--)
+            {
+                i0 += *in++;
+                i1 += i0;
+            }
+            break;
+
+        default:
+            while (nb--)
+            {
+                i0 += *in++;
+                i1 += i0;
+                i2 += i1;
+            }
+            break;
+    }
+
+    decim->integ[0] = i0;
+    decim->integ[1] = i1;
+    decim->integ[2] = i2;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Run the combs and scale the result to 16 bits.
+ * @param[in,out] decim     Decimator
+ * @return the filter output
+ ****************************************************************************************
+ */
+__STATIC_INLINE uint32_t adc_decim_comb(adc_decim_t *decim)
+{
+    uint8_t shift = decim->order * decim->ratio_log2;
+    uint32_t y = decim->integ[decim->order - 1];
+
+    for (uint8_t k = 0; k < decim->order; k++)
+    {
+        uint32_t x = y;
+
+        y -= decim->comb[k];
+        decim->comb[k] = x;
+    }
+
+    // y <= 0xFFFF << shift, the rounding term cannot overflow for shift <= 16
+    return shift ? ((y + (1UL << (shift - 1))) >> shift) : y;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Apply the gain error and offset compensation.
+ * @param[in] decim         Decimator
+ * @param[in] value         Filter output
+ * @return the corrected value
+ ****************************************************************************************
+ */
+__STATIC_INLINE uint16_t adc_decim_correct(const adc_decim_t *decim, uint32_t value)
+{
+    int32_t res;
+
+    if (decim->gain == 0)
+    {
+        return (uint16_t) value;
+    }
+
+    // value * gain in two parts, the gain being up to 2^17 in Q16
+    res = (int32_t) (((value * (decim->gain & 0xFFFF)) >> 16) + value * (decim->gain >> 16)) -
+          decim->offset;
+
+    if (res < 0)
+    {
+        return 0;
+    }
+
+    if (res > UINT16_MAX)
+    {
+        return UINT16_MAX;
+    }
+
+    return (uint16_t) res;
+}
+
+/*
+ * EXPORTED FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+void adc_decim_init(adc_decim_t *decim, uint8_t order, uint8_t ratio_log2)
+{
+    ASSERT_WARNING((order >= 1) && (order <= ADC_DECIM_ORDER_MAX));
+    ASSERT_WARNING(order * ratio_log2 <= ADC_DECIM_GAIN_BITS_MAX);
+
+    for (uint8_t k = 0; k < ADC_DECIM_ORDER_MAX; k++)
+    {
+        decim->integ[k] = 0;
+        decim->comb[k] = 0;
+    }
+
+    decim->gain = 0;
+    decim->offset = 0;
+    decim->count = 0;
+    decim->order = order;
+    decim->ratio_log2 = ratio_log2;
+    decim->warmup = order - 1;
+}
+
+void adc_decim_set_correction(adc_decim_t *decim, int16_t gain_error, int16_t offset)
+{
+    int32_t div = UINT16_MAX + gain_error;
+
+    // Keeps the Q16 gain below 2^17
+    ASSERT_WARNING(div > UINT16_MAX / 2);
+
+    // Same terms as adc_correction_apply(), computed once
+    decim->gain = (((uint32_t) UINT16_MAX << 16) + (uint32_t) div / 2) / (uint32_t) div;
+    decim->offset = (UINT16_MAX * (int32_t) offset) / div;
+}
+
+uint16_t adc_decim_process(adc_decim_t *decim, const uint16_t *in, uint16_t nb, uint16_t *out)
+{
+    uint32_t ratio = 1UL << decim->ratio_log2;
+    uint16_t nb_out = 0;
+
+    while (nb)
+    {
+        // Samples up to the next output
+        uint32_t n = ratio - decim->count;
+
+        if (n > nb)
+        {
+            n = nb;
+        }
+
+        adc_decim_integrate(decim, in, (uint16_t) n);
+        in += n;
+        nb -= n;
+        decim->count += n;
+
+        if (decim->count == ratio)
+        {
+            uint32_t y = adc_decim_comb(decim);
+
+            decim->count = 0;
+            if (decim->warmup)
+            {
+                decim->warmup--;
+            }
+            else
+            {
+                out[nb_out++] = adc_decim_correct(decim, y);
+            }
+        }
+    }
+
+    return nb_out;
+}
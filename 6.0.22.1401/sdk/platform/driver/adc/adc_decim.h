@@ -0,0 +1,163 @@
+/**
+ ****************************************************************************************
+ * @addtogroup Drivers
+ * @{
+ * @addtogroup ADC
+ * @{
+ * @addtogroup ADC_DECIM ADC decimation
+ * @brief Block decimation and correction of raw GP ADC samples
+ * @{
+ *
+ * @file adc_decim.h
+ *
+ * @brief GP ADC decimation and correction stage API.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _ADC_DECIM_H_
+#define _ADC_DECIM_H_
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/*
+ * The stage turns blocks of raw 16 bit GP ADC results into decimated, corrected values:
+ *
+ * - Decimation: a CIC filter of order N (1 to ADC_DECIM_ORDER_MAX) and ratio R = 2^r.
+ *   N = 1 is the plain average of R samples; higher orders attenuate the aliases more
+ *   and the first N - 1 outputs, which only see part of the filter, are discarded. The
+ *   gain R^N is removed by a rounded shift of N * r bits, so the output keeps the 16 bit
+ *   full scale of the input. The integrators wrap modulo 2^32, which is exact as long as
+ *   16 + N * r <= 32.
+ *
+ * - Correction: the OTP gain error and offset compensation of adc_correct_sample(),
+ *   applied once per output instead of once per sample. The correction is affine, so it
+ *   commutes with the filter; its divisions are done once by adc_decim_set_correction()
+ *   and each output only takes two multiplies and shifts. The result is within 1 LSB of
+ *   the filtered adc_correct_sample() values, away from the clamping at the rails.
+ *
+ * The output is the 16 bit full scale value. Shift it right by (6 - oversampling mode)
+ * for the scale of adc_correct_sample() at lower hardware oversampling modes.
+ *
+ * The stage has no hardware dependency and is built on the host by
+ * utilities/adc_scan_bench.
+ */
+
+/// Highest CIC filter order
+#define ADC_DECIM_ORDER_MAX         (3)
+
+/// Largest total gain of the filter, in bits
+#define ADC_DECIM_GAIN_BITS_MAX     (16)
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/// Decimator state
+typedef struct
+{
+    /// Integrators
+    uint32_t integ[ADC_DECIM_ORDER_MAX];
+
+    /// Comb delays
+    uint32_t comb[ADC_DECIM_ORDER_MAX];
+
+    /// Correction gain, Q16; 0 when the correction is off
+    uint32_t gain;
+
+    /// Corrected offset
+    int32_t offset;
+
+    /// Samples of the output being computed
+    uint32_t count;
+
+    /// Filter order
+    uint8_t order;
+
+    /// log2 of the decimation ratio
+    uint8_t ratio_log2;
+
+    /// Outputs still to discard
+    uint8_t warmup;
+} adc_decim_t;
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Reset a decimator. The correction is off.
+ * @param[out] decim        Decimator
+ * @param[in] order         CIC filter order, 1 to ADC_DECIM_ORDER_MAX
+ * @param[in] ratio_log2    log2 of the decimation ratio, with
+ *                          order * ratio_log2 <= ADC_DECIM_GAIN_BITS_MAX
+ ****************************************************************************************
+ */
+void adc_decim_init(adc_decim_t *decim, uint8_t order, uint8_t ratio_log2);
+
+/**
+ ****************************************************************************************
+ * @brief Set the gain error and offset compensation of the outputs.
+ * @param[in,out] decim     Decimator
+ * @param[in] gain_error    Gain error, from OTP (e.g. otp_cs_get_adc_single_ge())
+ * @param[in] offset        Offset, from OTP (e.g. otp_cs_get_adc_single_offset())
+ ****************************************************************************************
+ */
+void adc_decim_set_correction(adc_decim_t *decim, int16_t gain_error, int16_t offset);
+
+/**
+ ****************************************************************************************
+ * @brief Filter a block of raw samples.
+ * @details The block may end in the middle of an output; the samples are kept in the
+ * filter state and the output is produced by a following call.
+ * @param[in,out] decim     Decimator
+ * @param[in] in            Raw samples, as read from GP_ADC_RESULT_REG
+ * @param[in] nb            Number of samples
+ * @param[out] out          Outputs, room for (nb + R - 1) / R values
+ * @return the number of outputs written
+ ****************************************************************************************
+ */
+uint16_t adc_decim_process(adc_decim_t *decim, const uint16_t *in, uint16_t nb, uint16_t *out);
+
+#endif // _ADC_DECIM_H_
+
+///@}
+///@}
+///@}
@@ -0,0 +1,539 @@
+/**
+ ****************************************************************************************
+ *
+ * @file adc_scan.c
+ *
+ * @brief DA14531/535 GP ADC multi-channel scan engine.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+#if defined (__DA14531__) && defined (CFG_ADC_DMA_SUPPORT)
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "compiler.h"
+#include "datasheet.h"
+#include "otp_cs.h"
+#include "arch.h"
+#include "dma.h"
+#include "adc.h"
+#include "adc_scan.h"
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+#define ADC_SCAN_RING_MASK          (ADC_SCAN_RING_LEN - 1)
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/// Output ring of a channel
+typedef struct
+{
+    /// Outputs
+    volatile uint16_t data[ADC_SCAN_RING_LEN];
+
+    /// Free running write index, written by the DMA interrupt only
+    volatile uint8_t head;
+
+    /// Free running read index, written by adc_scan_read() only
+    volatile uint8_t tail;
+
+    /// Outputs dropped because the ring was full
+    uint16_t overflows;
+} adc_scan_ring_t;
+
+/// Engine environment
+typedef struct
+{
+    /// Scan configuration
+    adc_scan_cfg_t cfg;
+
+    /// Decimator of every channel
+    adc_decim_t decim[ADC_SCAN_CHANNELS];
+
+    /// Output ring of every channel
+    adc_scan_ring_t ring[ADC_SCAN_CHANNELS];
+
+    /// Completed scans
+    uint32_t scans;
+
+    /// DMA channel
+    DMA_ID dma;
+
+    /// Channel being converted
+    uint8_t cur;
+
+    /// Raw buffer being filled
+    uint8_t buf;
+
+    /// The scan list reads the temperature sensor
+    bool temp;
+
+    /// A list is started
+    bool started;
+
+    /// A scan is in progress
+    volatile bool busy;
+} adc_scan_env_t;
+
+/*
+ * LOCAL VARIABLES
+ ****************************************************************************************
+ */
+
+/// Kept across extended sleep between scans
+static adc_scan_env_t adc_scan_env                  __SECTION_ZERO("retention_mem_area0");
+
+/// Raw buffers, one filled by the DMA while the other is decimated
+static uint16_t adc_scan_raw[2][ADC_SCAN_BURST_MAX];
+
+/// Decimator outputs of a burst
+static uint16_t adc_scan_out[ADC_SCAN_BURST_MAX];
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+static void adc_scan_dma_cb(void *user_data, uint16_t len);
+
+/*
+ * LOCAL FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Check whether a channel reads the temperature sensor.
+ * @param[in] ch            Scan list entry
+ * @return true for the temperature sensor
+ ****************************************************************************************
+ */
+__STATIC_INLINE bool adc_scan_is_temp(const adc_scan_channel_t *ch)
+{
+    return (ch->input_mode == ADC_INPUT_MODE_SINGLE_ENDED) && (ch->input == ADC_INPUT_SE_TEMP_SENS);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Set the correction of a channel from the OTP values its settings select, as
+ * adc_correction_apply() does.
+ * @param[in,out] decim     Decimator of the channel
+ * @param[in] ch            Scan list entry
+ ****************************************************************************************
+ */
+static void adc_scan_set_correction(adc_decim_t *decim, const adc_scan_channel_t *ch)
+{
+#if defined (__DA14535__)
+    if (ch->input_attenuator == ADC_INPUT_ATTN_2X)
+    {
+        // Attenuator x2 is used instead of the input shifter
+        adc_decim_set_correction(decim, otp_cs_get_adc_offsh_ge(), otp_cs_get_adc_offsh_offset());
+    }
+    else
+#endif
+    if (ch->input_mode == ADC_INPUT_MODE_SINGLE_ENDED)
+    {
+        adc_decim_set_correction(decim, otp_cs_get_adc_single_ge(), otp_cs_get_adc_single_offset());
+    }
+    else
+    {
+        adc_decim_set_correction(decim, otp_cs_get_adc_diff_ge(), otp_cs_get_adc_diff_offset());
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Select the input and the settings of a channel. The ADC must be idle.
+ * @param[in] ch            Scan list entry
+ ****************************************************************************************
+ */
+static void adc_scan_configure(const adc_scan_channel_t *ch)
+{
+    adc_set_input_mode(ch->input_mode);
+    adc_set_se_input((adc_input_se_t) ch->input);
+    if (ch->input_mode == ADC_INPUT_MODE_DIFFERENTIAL)
+    {
+        adc_set_diff_input((adc_input_diff_t) (ch->input >> 4U));
+    }
+
+    if (adc_scan_is_temp(ch))
+    {
+        // Same settings as adc_init() for the temperature sensor, enabled at scan start
+        adc_chopper_enable();
+        adc_ldo_const_current_enable();
+        SetBits16(GP_ADC_CTRL2_REG, GP_ADC_STORE_DEL, 0);
+#if defined (__DA14535__)
+        adc_set_sample_time(5);
+        adc_set_oversampling(2);
+#else
+        adc_set_sample_time(15);
+        adc_set_oversampling(6);
+#endif
+        adc_attn_config(ADC_INPUT_ATTN_NO);
+    }
+    else
+    {
+        adc_ldo_const_current_disable();
+        SetBits16(GP_ADC_CTRL2_REG, GP_ADC_STORE_DEL,
+                  (GP_ADC_CTRL2_REG_RESET & GP_ADC_STORE_DEL) >> SHIF16(GP_ADC_STORE_DEL));
+        adc_set_sample_time(ch->smpl_time_mult);
+        adc_attn_config(ch->input_attenuator);
+        (ch->chopping == true) ? adc_chopper_enable() : adc_chopper_disable();
+        adc_set_oversampling(ch->oversampling);
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Point the DMA to a raw buffer for the burst of a channel and start the
+ * conversions.
+ * @param[in] ch            Scan list entry
+ * @param[in] buf           Raw buffer
+ ****************************************************************************************
+ */
+static void adc_scan_convert(const adc_scan_channel_t *ch, uint8_t buf)
+{
+    uint16_t len = ch->samples + ADC_SCAN_DISCARD;
+
+    dma_set_dst(adc_scan_env.dma, (uint32_t) adc_scan_raw[buf]);
+    dma_set_len(adc_scan_env.dma, len);
+    dma_set_int(adc_scan_env.dma, len);
+    dma_channel_start(adc_scan_env.dma, DMA_IRQ_STATE_ENABLED);
+
+    adc_continuous_enable();
+    SetBits16(GP_ADC_CTRL_REG, GP_ADC_START, 1);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Stop the continuous conversions and wait for the pending one.
+ ****************************************************************************************
+ */
+static void adc_scan_halt(void)
+{
+    adc_continuous_disable();
+    while (adc_in_progress())
+        ;
+    adc_clear_interrupt();
+}
+
+/**
+ ****************************************************************************************
+ * @brief Power the ADC up, set up the DMA and start a scan from the first channel.
+ ****************************************************************************************
+ */
+static void adc_scan_run(void)
+{
+    const adc_scan_channel_t *first = &adc_scan_env.cfg.channels[0];
+
+    // adc_init() enables and settles the temperature sensor, and reads its calibration
+    // value for adc_get_temp_async(). Every channel is set up again below.
+    adc_config_t adc_cfg =
+    {
+        .input_mode       = adc_scan_env.temp ? ADC_INPUT_MODE_SINGLE_ENDED : first->input_mode,
+        .input            = adc_scan_env.temp ? ADC_INPUT_SE_TEMP_SENS : first->input,
+        .smpl_time_mult   = first->smpl_time_mult,
+        .continuous       = false,
+        .interval_mult    = 0,
+        .input_attenuator = first->input_attenuator,
+        .chopping         = first->chopping,
+        .oversampling     = first->oversampling,
+        .dst_addr         = (uint32_t) adc_scan_raw[0],
+        .len              = first->samples + ADC_SCAN_DISCARD,
+        .rx_cb            = adc_scan_dma_cb,
+        .user_data        = NULL,
+        .dma_channel      = adc_scan_env.cfg.dma_channel,
+        .dma_priority     = adc_scan_env.cfg.dma_priority,
+    };
+
+    // Same DMA set up as adc_init(), done here as well for the ROM builds of adc_init()
+    dma_cfg_t dma_cfg =
+    {
+        .bus_width       = DMA_BW_HALFWORD,
+        .irq_enable      = DMA_IRQ_STATE_ENABLED,
+        .dreq_mode       = DMA_DREQ_TRIGGERED,
+        .src_inc         = DMA_INC_FALSE,
+        .dst_inc         = DMA_INC_TRUE,
+        .circular        = DMA_MODE_NORMAL,
+        .dma_prio        = adc_scan_env.cfg.dma_priority,
+        .dma_idle        = DMA_IDLE_BLOCKING_MODE,
+        .dma_init        = DMA_INIT_AX_BX_AY_BY,
+        .dma_sense       = DMA_SENSE_LEVEL_SENSITIVE,
+        .dma_req_mux     = DMA_TRIG_ADC_RX,
+        .src_address     = (uint32_t) GP_ADC_RESULT_REG,
+        .dst_address     = adc_cfg.dst_addr,
+        .irq_nr_of_trans = 0,
+        .length          = adc_cfg.len,
+        .cb              = adc_scan_dma_cb,
+        .user_data       = NULL
+    };
+
+    adc_init(&adc_cfg);
+    adc_dma_enable();
+    dma_initialize(adc_scan_env.dma, &dma_cfg);
+
+    adc_scan_env.cur = 0;
+    adc_scan_env.buf = 0;
+    adc_scan_env.busy = true;
+
+    adc_scan_configure(first);
+    adc_scan_convert(first, 0);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Stop the DMA and power the ADC and the temperature sensor down.
+ ****************************************************************************************
+ */
+static void adc_scan_power_down(void)
+{
+    adc_scan_env.busy = false;
+
+    adc_scan_halt();
+    dma_channel_stop(adc_scan_env.dma);
+    adc_dma_disable();
+    adc_temp_sensor_disable();
+    adc_disable();
+}
+
+/**
+ ****************************************************************************************
+ * @brief Decimate the burst of a channel and push the outputs into its ring.
+ * @param[in] ch            Channel index
+ * @param[in] raw           Raw buffer
+ * @param[in] len           Samples in the buffer, ADC_SCAN_DISCARD included
+ ****************************************************************************************
+ */
+static void adc_scan_publish(uint8_t ch, const uint16_t *raw, uint16_t len)
+{
+    adc_scan_ring_t *ring = &adc_scan_env.ring[ch];
+    uint8_t head = ring->head;
+    uint16_t nb;
+
+    if (len <= ADC_SCAN_DISCARD)
+    {
+        return;
+    }
+
+    nb = adc_decim_process(&adc_scan_env.decim[ch], raw + ADC_SCAN_DISCARD, len - ADC_SCAN_DISCARD,
+                           adc_scan_out);
+
+    for (uint16_t i = 0; i < nb; i++)
+    {
+        if ((uint8_t) (head - ring->tail) == ADC_SCAN_RING_LEN)
+        {
+            ring->overflows++;
+            continue;
+        }
+
+        ring->data[head & ADC_SCAN_RING_MASK] = adc_scan_out[i];
+        head++;
+        // Publish the value only once it is written
+        ring->head = head;
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief DMA callback at the end of a burst.
+ * @param[in] user_data     Not used
+ * @param[in] len           Samples transferred
+ ****************************************************************************************
+ */
+static void adc_scan_dma_cb(void *user_data, uint16_t len)
+{
+    uint8_t done = adc_scan_env.cur;
+    const uint16_t *raw = adc_scan_raw[adc_scan_env.buf];
+    bool last = (done + 1 == adc_scan_env.cfg.nb_channels);
+
+    if (!adc_scan_env.busy)
+    {
+        // Stopped while the interrupt was pending
+        return;
+    }
+
+    if (!last || adc_scan_env.cfg.repeat)
+    {
+        uint8_t next = last ? 0 : done + 1;
+
+        // Move the ADC on to the next channel before the decimation below
+        adc_scan_halt();
+        adc_scan_env.cur = next;
+        adc_scan_env.buf ^= 1;
+        adc_scan_configure(&adc_scan_env.cfg.channels[next]);
+        adc_scan_convert(&adc_scan_env.cfg.channels[next], adc_scan_env.buf);
+    }
+    else
+    {
+        adc_scan_power_down();
+    }
+
+    adc_scan_publish(done, raw, len);
+
+    if (last)
+    {
+        adc_scan_env.scans++;
+        if (adc_scan_env.cfg.scan_cb != NULL)
+        {
+            adc_scan_env.cfg.scan_cb();
+        }
+    }
+}
+
+/*
+ * EXPORTED FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+void adc_scan_start(const adc_scan_cfg_t *cfg)
+{
+    ASSERT_ERROR(cfg != NULL);
+    ASSERT_ERROR((cfg->nb_channels >= 1) && (cfg->nb_channels <= ADC_SCAN_CHANNELS));
+
+    adc_scan_stop();
+
+    GLOBAL_INT_DISABLE();
+    adc_scan_env.cfg = *cfg;
+    adc_scan_env.dma = (cfg->dma_channel == ADC_DMA_CHANNEL_01) ? DMA_CHANNEL_0 : DMA_CHANNEL_2;
+    adc_scan_env.scans = 0;
+    adc_scan_env.temp = false;
+
+    for (uint8_t i = 0; i < cfg->nb_channels; i++)
+    {
+        const adc_scan_channel_t *ch = &cfg->channels[i];
+
+        ASSERT_ERROR((ch->samples >= 1) && (ch->samples + ADC_SCAN_DISCARD <= ADC_SCAN_BURST_MAX));
+
+        adc_decim_init(&adc_scan_env.decim[i], ch->order, ch->ratio_log2);
+        if (adc_scan_is_temp(ch))
+        {
+            adc_scan_env.temp = true;
+        }
+        else if (ch->correct)
+        {
+            adc_scan_set_correction(&adc_scan_env.decim[i], ch);
+        }
+
+        adc_scan_env.ring[i].head = 0;
+        adc_scan_env.ring[i].tail = 0;
+        adc_scan_env.ring[i].overflows = 0;
+    }
+
+    adc_scan_env.started = true;
+    adc_scan_run();
+    GLOBAL_INT_RESTORE();
+}
+
+bool adc_scan_trigger(void)
+{
+    bool ok = false;
+
+    GLOBAL_INT_DISABLE();
+    if (adc_scan_env.started && !adc_scan_env.busy)
+    {
+        adc_scan_run();
+        ok = true;
+    }
+    GLOBAL_INT_RESTORE();
+
+    return ok;
+}
+
+void adc_scan_stop(void)
+{
+    GLOBAL_INT_DISABLE();
+    if (adc_scan_env.busy)
+    {
+        adc_scan_power_down();
+    }
+    adc_scan_env.started = false;
+    GLOBAL_INT_RESTORE();
+}
+
+bool adc_scan_read(uint8_t ch, uint16_t *value)
+{
+    adc_scan_ring_t *ring = &adc_scan_env.ring[ch];
+    uint8_t tail = ring->tail;
+
+    ASSERT_WARNING(ch < ADC_SCAN_CHANNELS);
+
+    if (tail == ring->head)
+    {
+        return false;
+    }
+
+    *value = ring->data[tail & ADC_SCAN_RING_MASK];
+    // Free the slot only once it is read
+    ring->tail = tail + 1;
+
+    return true;
+}
+
+uint8_t adc_scan_available(uint8_t ch)
+{
+    ASSERT_WARNING(ch < ADC_SCAN_CHANNELS);
+
+    return (uint8_t) (adc_scan_env.ring[ch].head - adc_scan_env.ring[ch].tail);
+}
+
+uint16_t adc_scan_overflows(uint8_t ch)
+{
+    ASSERT_WARNING(ch < ADC_SCAN_CHANNELS);
+
+    return adc_scan_env.ring[ch].overflows;
+}
+
+uint32_t adc_scan_count(void)
+{
+    return adc_scan_env.scans;
+}
+
+sleep_mode_t adc_scan_validate_sleep(sleep_mode_t sleep_mode)
+{
+    // The ADC and the DMA stop in extended sleep
+    if (adc_scan_env.busy && (sleep_mode > mode_idle))
+    {
+        return mode_idle;
+    }
+
+    return sleep_mode;
+}
+
+#endif // __DA14531__ && CFG_ADC_DMA_SUPPORT
@@ -0,0 +1,295 @@
+/**
+ ****************************************************************************************
+ * @addtogroup Drivers
+ * @{
+ * @addtogroup ADC
+ * @{
+ * @addtogroup ADC_SCAN ADC scan
+ * @brief Multi-channel GP ADC scan engine
+ * @{
+ *
+ * @file adc_scan.h
+ *
+ * @brief DA14531/535 GP ADC multi-channel scan engine API.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+#if defined (__DA14531__)
+
+#ifndef _ADC_SCAN_H_
+#define _ADC_SCAN_H_
+
+/*
+ * Multi-channel scan (requires CFG_ADC_DMA_SUPPORT)
+ *
+ * The GP ADC has a single input selection and no hardware sequencer, so a scan list is
+ * run as a chain of DMA bursts in one session: the ADC converts in continuous mode, one
+ * channel at a time, and the DMA copies a burst of raw results per channel. From the
+ * DMA interrupt at the end of a burst, the engine stops the continuous mode, waits for
+ * the pending conversion (at most one conversion time), selects the next input, re-arms
+ * the DMA into the other raw buffer and restarts the ADC. Only then is the finished
+ * burst passed through the channel's decimator (adc_decim.h), which corrects and
+ * decimates it while the next channel converts.
+ *
+ * The first ADC_SCAN_DISCARD results of every burst are dropped: they may belong to the
+ * previous input or to the input multiplexer settling.
+ *
+ * The outputs are pushed into one ring per channel, ADC_SCAN_RING_LEN values deep. The
+ * ring is lock-free, the DMA interrupt being the only writer and adc_scan_read() the
+ * only reader; when it is full, new outputs are dropped and counted
+ * (adc_scan_overflows()).
+ *
+ * A channel reading ADC_INPUT_SE_TEMP_SENS uses the fixed temperature sensor settings of
+ * adc_init() and is not corrected: its outputs are averaged raw values for
+ * adc_get_temp_async(). The sensor is enabled once, when the scan starts, and stays on
+ * until the scan ends, so it only settles once per scan. The input shifter is not
+ * supported.
+ *
+ * Usage:
+ *
+ *   static const adc_scan_channel_t chans[] =
+ *   {
+ *       // P0_6, averaged by 16 (two outputs per scan)
+ *       {ADC_INPUT_MODE_SINGLE_ENDED, ADC_INPUT_SE_P0_6, 2, ADC_INPUT_ATTN_4X, true, 2, 32, 1, 4, true},
+ *       // VBAT, CIC order 2, ratio 8
+ *       {ADC_INPUT_MODE_SINGLE_ENDED, ADC_INPUT_SE_VBAT_HIGH, 2, ADC_INPUT_ATTN_4X, true, 2, 16, 2, 3, true},
+ *       // Temperature, 8 raw samples averaged
+ *       {ADC_INPUT_MODE_SINGLE_ENDED, ADC_INPUT_SE_TEMP_SENS, 0, ADC_INPUT_ATTN_NO, true, 0, 8, 1, 3, false},
+ *   };
+ *   static const adc_scan_cfg_t scan = {chans, 3, false, ADC_DMA_CHANNEL_01, DMA_PRIO_0, app_scan_done};
+ *
+ *   adc_scan_start(&scan);      // first scan
+ *   ...
+ *   adc_scan_trigger();         // e.g. from a timer, for the next ones
+ *
+ * and from the app_on_system_powered or app_validate_sleep callback, so that the
+ * system does not enter extended sleep during a scan:
+ *
+ *   sleep_mode = adc_scan_validate_sleep(sleep_mode);
+ *
+ * The ADC is powered down between scans, so extended sleep is allowed there. With
+ * repeat set, scans follow each other until adc_scan_stop().
+ */
+
+#if defined (CFG_ADC_DMA_SUPPORT)
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "arch.h"
+#include "adc.h"
+#include "adc_decim.h"
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Largest number of channels in a scan list
+#ifndef CFG_ADC_SCAN_CHANNELS
+#define ADC_SCAN_CHANNELS           (8)
+#else
+#define ADC_SCAN_CHANNELS           (CFG_ADC_SCAN_CHANNELS)
+#endif
+
+/// Largest number of samples per channel and scan, ADC_SCAN_DISCARD included
+#ifndef CFG_ADC_SCAN_BURST_MAX
+#define ADC_SCAN_BURST_MAX          (64)
+#else
+#define ADC_SCAN_BURST_MAX          (CFG_ADC_SCAN_BURST_MAX)
+#endif
+
+/// Outputs per channel ring, a power of 2 up to 128
+#ifndef CFG_ADC_SCAN_RING_LEN
+#define ADC_SCAN_RING_LEN           (8)
+#else
+#define ADC_SCAN_RING_LEN           (CFG_ADC_SCAN_RING_LEN)
+#endif
+
+/// Samples dropped at the start of every burst
+#ifndef CFG_ADC_SCAN_DISCARD
+#define ADC_SCAN_DISCARD            (1)
+#else
+#define ADC_SCAN_DISCARD            (CFG_ADC_SCAN_DISCARD)
+#endif
+
+#if (ADC_SCAN_CHANNELS < 1) || (ADC_SCAN_CHANNELS > 255) || \
+    (ADC_SCAN_RING_LEN < 2) || (ADC_SCAN_RING_LEN > 128) || \
+    (ADC_SCAN_RING_LEN & (ADC_SCAN_RING_LEN - 1)) || (ADC_SCAN_BURST_MAX <= ADC_SCAN_DISCARD)
+    #error "Invalid ADC scan configuration."
+#endif
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/// Scan list entry
+typedef struct
+{
+    /// Input channel mode
+    adc_input_mode_t    input_mode;
+
+    /// Input channel, as in adc_config_t
+    uint8_t             input;
+
+    /// Sample time
+    uint8_t             smpl_time_mult;
+
+    /// Attenuator
+    adc_input_attn_t    input_attenuator;
+
+    /// Chopper mode off/on
+    bool                chopping;
+
+    /// Hardware oversampling mode
+    uint8_t             oversampling;
+
+    /// Samples per scan, ADC_SCAN_DISCARD excluded
+    uint16_t            samples;
+
+    /// CIC filter order, 1 to ADC_DECIM_ORDER_MAX
+    uint8_t             order;
+
+    /// log2 of the decimation ratio
+    uint8_t             ratio_log2;
+
+    /// Gain error and offset correction off/on
+    bool                correct;
+} adc_scan_channel_t;
+
+/// Scan configuration
+typedef struct
+{
+    /// Scan list, kept by the engine until adc_scan_stop()
+    const adc_scan_channel_t    *channels;
+
+    /// Number of channels
+    uint8_t                     nb_channels;
+
+    /// Scan again as soon as a scan ends
+    bool                        repeat;
+
+    /// DMA channel for ADC RX
+    adc_dma_channel_t           dma_channel;
+
+    /// DMA channel priority for ADC RX
+    DMA_PRIO_CFG                dma_priority;
+
+    /// Called from the DMA interrupt at the end of every scan; may be NULL
+    void                        (*scan_cb)(void);
+} adc_scan_cfg_t;
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Reset the decimators and rings and start the first scan of a list.
+ * @param[in] cfg           Scan configuration, kept by the engine until adc_scan_stop()
+ ****************************************************************************************
+ */
+void adc_scan_start(const adc_scan_cfg_t *cfg);
+
+/**
+ ****************************************************************************************
+ * @brief Start the next scan of the list. The decimators carry on from the previous
+ * scan.
+ * @return false if a scan is in progress or no list is started
+ ****************************************************************************************
+ */
+bool adc_scan_trigger(void);
+
+/**
+ ****************************************************************************************
+ * @brief Abort the scan in progress and power the ADC down. The outputs already in the
+ * rings can still be read.
+ ****************************************************************************************
+ */
+void adc_scan_stop(void);
+
+/**
+ ****************************************************************************************
+ * @brief Read the oldest output of a channel.
+ * @param[in] ch            Channel index in the scan list
+ * @param[out] value        Output
+ * @return false if the ring is empty
+ ****************************************************************************************
+ */
+bool adc_scan_read(uint8_t ch, uint16_t *value);
+
+/**
+ ****************************************************************************************
+ * @brief Number of outputs waiting in the ring of a channel.
+ * @param[in] ch            Channel index in the scan list
+ * @return the number of outputs
+ ****************************************************************************************
+ */
+uint8_t adc_scan_available(uint8_t ch);
+
+/**
+ ****************************************************************************************
+ * @brief Number of outputs dropped because the ring of a channel was full.
+ * @param[in] ch            Channel index in the scan list
+ * @return the number of outputs dropped since adc_scan_start()
+ ****************************************************************************************
+ */
+uint16_t adc_scan_overflows(uint8_t ch);
+
+/**
+ ****************************************************************************************
+ * @brief Number of completed scans since adc_scan_start().
+ * @return the number of scans
+ ****************************************************************************************
+ */
+uint32_t adc_scan_count(void);
+
+/**
+ ****************************************************************************************
+ * @brief Limit the sleep mode while a scan is in progress. The ADC and the DMA keep
+ * running in idle mode only.
+ * @param[in] sleep_mode    Sleep mode the system would enter
+ * @return the sleep mode allowed
+ ****************************************************************************************
+ */
+sleep_mode_t adc_scan_validate_sleep(sleep_mode_t sleep_mode);
+
+#endif // CFG_ADC_DMA_SUPPORT
+
+#endif // _ADC_SCAN_H_
+
+#endif // __DA14531__
+
+///@}
+///@}
+///@}
@@ -109,7 +109,13 @@ typedef enum
     I2C_7B_ADDR_NOACK_ERROR,
 
     /// Invalid EEPROM address
-    I2C_INVALID_EEPROM_ADDRESS
+    I2C_INVALID_EEPROM_ADDRESS,
+
+    /// Transfer aborted after the address byte was acknowledged
+    I2C_TRANSFER_ERROR,
+
+    /// Asynchronous request queue is full
+    I2C_QUEUE_FULL_ERROR
 } i2c_error_code;
 
 
@@ -0,0 +1,498 @@
+/**
+ ****************************************************************************************
+ *
+ * @file i2c_eeprom_async.c
+ *
+ * @brief Non-blocking I2C EEPROM engine.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+#if defined (CFG_I2C_DMA_SUPPORT)
+
+#include <stdint.h>
+#include <stddef.h>
+#include "compiler.h"
+#include "arch.h"
+#include "ll.h"
+#include "dma.h"
+#include "systick.h"
+#include "i2c_eeprom_async.h"
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Engine state
+enum i2c_eeprom_async_state
+{
+    /// No request pending
+    I2C_EEPROM_ASYNC_IDLE,
+
+    /// Transfer in progress on the bus
+    I2C_EEPROM_ASYNC_TRANSFER,
+
+    /// Waiting for the SysTick to start the next transfer
+    I2C_EEPROM_ASYNC_WAIT,
+};
+
+/*
+ * LOCAL VARIABLE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/// Queued request
+struct i2c_eeprom_async_req
+{
+    /// Data to read to or to write from
+    uint8_t *data;
+
+    /// Starting memory address
+    uint32_t address;
+
+    /// Bytes to transfer
+    uint32_t size;
+
+    /// Bytes transferred
+    uint32_t done;
+
+    /// Completion callback
+    i2c_eeprom_async_cb_t cb;
+
+    /// Data to pass to cb
+    void *cb_data;
+
+    /// Write request
+    bool write;
+};
+
+/// Asynchronous engine environment
+typedef struct
+{
+    /// Engine configuration
+    i2c_eeprom_async_cfg_t cfg;
+
+    /// I2C configuration
+    i2c_cfg_t i2c;
+
+    /// I2C EEPROM configuration
+    i2c_eeprom_cfg_t eeprom;
+
+    /// Request queue
+    struct i2c_eeprom_async_req queue[I2C_EEPROM_ASYNC_QUEUE_LEN];
+
+    /// Index of the request in progress
+    uint8_t head;
+
+    /// Queued requests
+    uint8_t count;
+
+    /// enum i2c_eeprom_async_state
+    uint8_t state;
+
+    /// ACK polls of the write cycle in progress
+    uint16_t polls;
+
+    /// Bytes of the transfer in progress
+    uint32_t chunk;
+} i2c_eeprom_async_env_t;
+
+static i2c_eeprom_async_env_t i2c_eeprom_async_env     __SECTION_ZERO("retention_mem_area0");
+
+/// DMA buffer of a page write: memory address and data, the high bytes are the I2C commands.
+/// Only used while a request is pending, when the system does not sleep.
+static uint16_t wr_buf[3 + I2C_EEPROM_ASYNC_PAGE_MAX];
+
+/// Dummy byte of an ACK poll (the driver sets its STOP bit)
+static uint16_t poll_cmd = 0x08;
+
+#if defined (__DA14531__)
+#define I2C_EEPROM_ASYNC_STOP   (I2C_F_ADD_STOP)
+#else
+#define I2C_EEPROM_ASYNC_STOP   (I2C_F_NONE)
+#endif
+
+/*
+ * FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+static void transfer(void);
+
+/**
+ ****************************************************************************************
+ * @brief Start the next transfer from the SysTick.
+ * @param[in] usec  Delay
+ ****************************************************************************************
+ */
+static void schedule(uint32_t usec)
+{
+    i2c_eeprom_async_env.state = I2C_EEPROM_ASYNC_WAIT;
+    systick_start(usec, true);
+}
+
+static void systick_cb(void)
+{
+    systick_stop();
+
+    if (i2c_eeprom_async_env.state == I2C_EEPROM_ASYNC_WAIT)
+    {
+        transfer();
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Complete the request in progress and start the next one.
+ * @param[in] status    Status passed to the callback
+ ****************************************************************************************
+ */
+static void complete(i2c_error_code status)
+{
+    struct i2c_eeprom_async_req req = i2c_eeprom_async_env.queue[i2c_eeprom_async_env.head];
+
+    i2c_eeprom_async_env.head = (i2c_eeprom_async_env.head + 1) % I2C_EEPROM_ASYNC_QUEUE_LEN;
+    i2c_eeprom_async_env.count--;
+    i2c_eeprom_async_env.state = I2C_EEPROM_ASYNC_IDLE;
+
+    // The callback may queue a new request, which starts the engine
+    if (req.cb != NULL)
+    {
+        req.cb(req.cb_data, status, req.done);
+    }
+
+    if ((i2c_eeprom_async_env.state == I2C_EEPROM_ASYNC_IDLE) && i2c_eeprom_async_env.count)
+    {
+        transfer();
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief End of a transfer, called by the I2C driver.
+ * @param[in] cb_data   Not used
+ * @param[in] len       Length passed to the DMA
+ * @param[in] success   false if the transfer was aborted
+ ****************************************************************************************
+ */
+static void transfer_cb(void *cb_data, uint16_t len, bool success)
+{
+    struct i2c_eeprom_async_req *req = &i2c_eeprom_async_env.queue[i2c_eeprom_async_env.head];
+
+    if (!success)
+    {
+        uint16_t abort_source = i2c_get_abort_source();
+
+        // Channels of the aborted direction may still be armed
+        dma_channel_stop(DMA_ID_GET(i2c_eeprom_async_env.cfg.dma_channel_pair));
+        dma_channel_stop(DMA_ID_GET(i2c_eeprom_async_env.cfg.dma_channel_pair + 1));
+
+        if ((abort_source & ABRT_7B_ADDR_NOACK) == 0)
+        {
+            complete(I2C_TRANSFER_ERROR);
+        }
+        // Not acknowledged: write cycle in progress, retry
+        else if (++i2c_eeprom_async_env.polls < i2c_eeprom_async_env.cfg.poll_max)
+        {
+            schedule(i2c_eeprom_async_env.cfg.poll_us);
+        }
+        else
+        {
+            complete(I2C_7B_ADDR_NOACK_ERROR);
+        }
+        return;
+    }
+
+    i2c_eeprom_async_env.polls = 0;
+
+    if (!req->write)
+    {
+        req->done += i2c_eeprom_async_env.chunk;
+        if (req->done < req->size)
+        {
+            transfer();
+        }
+        else
+        {
+            complete(I2C_NO_ERROR);
+        }
+    }
+    else if (i2c_eeprom_async_env.chunk != 0)
+    {
+        // Page written: the EEPROM is busy for its write cycle
+        req->done += i2c_eeprom_async_env.chunk;
+        schedule(i2c_eeprom_async_env.cfg.twr_us);
+    }
+    else
+    {
+        // ACK poll acknowledged: the last page is written
+        complete(I2C_NO_ERROR);
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Select the slave address of the memory address.
+ * @param[in] address   The I2C EEPROM memory address
+ ****************************************************************************************
+ */
+static void set_target(uint32_t address)
+{
+    if (i2c_eeprom_async_env.eeprom.address_size == I2C_2BYTES_ADDR)
+    {
+        i2c_set_controller_status(I2C_CONTROLLER_DISABLE);
+        i2c_set_target_address(i2c_eeprom_async_env.i2c.address | ((address & 0x30000) >> 16));
+        i2c_set_controller_status(I2C_CONTROLLER_ENABLE);
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Fill the memory address bytes.
+ * @param[out] buf      Buffer
+ * @param[in] address   The I2C EEPROM memory address
+ * @return Number of bytes
+ ****************************************************************************************
+ */
+static uint8_t address_bytes(uint16_t *buf, uint32_t address)
+{
+    uint8_t n = 0;
+
+    switch (i2c_eeprom_async_env.eeprom.address_size)
+    {
+        case I2C_3BYTES_ADDR:
+            buf[n++] = (address >> 16) & 0xFF;
+            // fall through
+        case I2C_2BYTES_ADDR:
+            buf[n++] = (address >> 8) & 0xFF;
+            break;
+    }
+    buf[n++] = address & 0xFF;
+
+    return n;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Start the next transfer of the request in progress.
+ ****************************************************************************************
+ */
+static void transfer(void)
+{
+    struct i2c_eeprom_async_req *req = &i2c_eeprom_async_env.queue[i2c_eeprom_async_env.head];
+    uint32_t address = req->address + req->done;
+    uint32_t n = req->size - req->done;
+    uint16_t addr_buf[3];
+    uint8_t addr_len;
+
+    if (req->size == 0)
+    {
+        // Nothing to transfer
+        complete(I2C_NO_ERROR);
+        return;
+    }
+
+    i2c_eeprom_async_env.state = I2C_EEPROM_ASYNC_TRANSFER;
+
+    // The STOP of the previous transfer may still be on the bus
+    while (i2c_is_master_busy());
+
+    set_target(address);
+
+    if (req->write)
+    {
+        if (n == 0)
+        {
+            // Last page sent, poll until it is written
+            i2c_eeprom_async_env.chunk = 0;
+            i2c_master_transmit_buffer_dma(i2c_eeprom_async_env.cfg.dma_channel_pair, &poll_cmd, 1,
+                                           transfer_cb, NULL, I2C_F_WAIT_FOR_STOP);
+            return;
+        }
+
+        // Up to the end of the page
+        if (n > i2c_eeprom_async_env.eeprom.page_size - (address % i2c_eeprom_async_env.eeprom.page_size))
+        {
+            n = i2c_eeprom_async_env.eeprom.page_size - (address % i2c_eeprom_async_env.eeprom.page_size);
+        }
+        i2c_eeprom_async_env.chunk = n;
+
+        addr_len = address_bytes(wr_buf, address);
+        for (uint32_t i = 0; i < n; i++)
+        {
+            wr_buf[addr_len + i] = req->data[req->done + i];
+        }
+
+        i2c_master_transmit_buffer_dma(i2c_eeprom_async_env.cfg.dma_channel_pair, wr_buf, addr_len + n,
+                                       transfer_cb, NULL, I2C_F_WAIT_FOR_STOP);
+        return;
+    }
+
+    // Sequential read, up to the DMA limit and the 64 KB block of the slave address
+    if (n > I2C_EEPROM_ASYNC_READ_MAX)
+    {
+        n = I2C_EEPROM_ASYNC_READ_MAX;
+    }
+    if ((i2c_eeprom_async_env.eeprom.address_size == I2C_2BYTES_ADDR) && (n > 0x10000 - (address & 0xFFFF)))
+    {
+        n = 0x10000 - (address & 0xFFFF);
+    }
+    i2c_eeprom_async_env.chunk = n;
+
+    addr_len = address_bytes(addr_buf, address);
+
+    // Critical section: the memory address must reach the FIFO before the read commands,
+    // and after the driver has cleared the previous abort
+    GLOBAL_INT_DISABLE();
+
+    if (n == 1)
+    {
+        // The DMA needs at least 2 bytes to add the STOP, a single byte goes through the FIFO
+        i2c_master_receive_buffer_async(&req->data[req->done], 1, transfer_cb, NULL, I2C_EEPROM_ASYNC_STOP);
+    }
+    else
+    {
+        i2c_prepare_dma(i2c_eeprom_async_env.cfg.dma_channel_pair, &req->data[req->done], n,
+                        I2C_DMA_TRANSFER_MASTER_READ, transfer_cb, NULL, I2C_EEPROM_ASYNC_STOP);
+    }
+
+    for (uint8_t i = 0; i < addr_len; i++)
+    {
+        i2c_write_byte(addr_buf[i]);
+    }
+
+    if (n != 1)
+    {
+        i2c_dma_start();
+    }
+
+    // End of critical section
+    GLOBAL_INT_RESTORE();
+}
+
+/**
+ ****************************************************************************************
+ * @brief Queue a request.
+ * @return i2c_error_code Enumeration type that defines the returned error code
+ ****************************************************************************************
+ */
+static i2c_error_code submit(uint8_t *data, uint32_t address, uint32_t size, bool write,
+                             i2c_eeprom_async_cb_t cb, void *cb_data)
+{
+    struct i2c_eeprom_async_req *req;
+    i2c_error_code status = I2C_NO_ERROR;
+
+    if (address >= i2c_eeprom_async_env.eeprom.size)
+    {
+        return I2C_INVALID_EEPROM_ADDRESS;
+    }
+
+    // Limit to the memory size
+    if (size > i2c_eeprom_async_env.eeprom.size - address)
+    {
+        size = i2c_eeprom_async_env.eeprom.size - address;
+    }
+
+    GLOBAL_INT_DISABLE();
+
+    if (i2c_eeprom_async_env.count == I2C_EEPROM_ASYNC_QUEUE_LEN)
+    {
+        status = I2C_QUEUE_FULL_ERROR;
+    }
+    else
+    {
+        req = &i2c_eeprom_async_env.queue[(i2c_eeprom_async_env.head + i2c_eeprom_async_env.count) %
+                                          I2C_EEPROM_ASYNC_QUEUE_LEN];
+        req->data = data;
+        req->address = address;
+        req->size = size;
+        req->done = 0;
+        req->cb = cb;
+        req->cb_data = cb_data;
+        req->write = write;
+        i2c_eeprom_async_env.count++;
+
+        if (i2c_eeprom_async_env.state == I2C_EEPROM_ASYNC_IDLE)
+        {
+            transfer();
+        }
+    }
+
+    GLOBAL_INT_RESTORE();
+
+    return status;
+}
+
+void i2c_eeprom_async_init(const i2c_eeprom_async_cfg_t *cfg)
+{
+    GLOBAL_INT_DISABLE();
+
+    systick_stop();
+    i2c_eeprom_async_env.cfg = *cfg;
+    i2c_eeprom_get_configuration(&i2c_eeprom_async_env.i2c, &i2c_eeprom_async_env.eeprom);
+    i2c_eeprom_async_env.head = 0;
+    i2c_eeprom_async_env.count = 0;
+    i2c_eeprom_async_env.polls = 0;
+    i2c_eeprom_async_env.state = I2C_EEPROM_ASYNC_IDLE;
+    systick_register_callback(systick_cb);
+
+    GLOBAL_INT_RESTORE();
+
+    // Pages must fit the DMA buffer
+    ASSERT_ERROR(i2c_eeprom_async_env.eeprom.page_size <= I2C_EEPROM_ASYNC_PAGE_MAX);
+    ASSERT_ERROR(cfg->twr_us && cfg->poll_us);
+}
+
+i2c_error_code i2c_eeprom_read_data_async(uint8_t *rd_data_ptr, uint32_t address, uint32_t size,
+                                          i2c_eeprom_async_cb_t cb, void *cb_data)
+{
+    return submit(rd_data_ptr, address, size, false, cb, cb_data);
+}
+
+i2c_error_code i2c_eeprom_write_data_async(const uint8_t *wr_data_ptr, uint32_t address, uint32_t size,
+                                           i2c_eeprom_async_cb_t cb, void *cb_data)
+{
+    return submit((uint8_t *)wr_data_ptr, address, size, true, cb, cb_data);
+}
+
+bool i2c_eeprom_async_busy(void)
+{
+    return i2c_eeprom_async_env.count != 0;
+}
+
+sleep_mode_t i2c_eeprom_async_validate_sleep(sleep_mode_t current_sleep_mode)
+{
+    // The I2C controller, the DMA and the SysTick stop in extended sleep
+    if (i2c_eeprom_async_busy() && (current_sleep_mode > mode_idle))
+    {
+        return mode_idle;
+    }
+
+    return current_sleep_mode;
+}
+
+#endif // CFG_I2C_DMA_SUPPORT
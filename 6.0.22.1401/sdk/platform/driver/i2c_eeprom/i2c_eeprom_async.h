@@ -0,0 +1,183 @@
+/**
+ ****************************************************************************************
+ * @addtogroup Drivers
+ * @{
+ * @addtogroup I2C_EEPROM_ASYNC I2C EEPROM asynchronous engine
+ * @brief Non-blocking I2C EEPROM access over DMA
+ * @{
+ *
+ * @file i2c_eeprom_async.h
+ *
+ * @brief Non-blocking I2C EEPROM engine header file.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _I2C_EEPROM_ASYNC_H_
+#define _I2C_EEPROM_ASYNC_H_
+
+/*
+ * Asynchronous I2C EEPROM engine (requires CFG_I2C_DMA_SUPPORT)
+ *
+ * Reads and writes are queued and run from the DMA, I2C and SysTick interrupts; the
+ * calling code never waits on the bus.
+ *
+ * A read is one sequential read of any length: the memory address is sent once and the
+ * EEPROM increments it internally. It is only split at the 32 KB limit of a DMA transfer
+ * and, with 2 bytes addresses, at the 64 KB blocks selected through the slave address.
+ *
+ * A write is split at page boundaries. Each page is one DMA transfer of the memory
+ * address and the data. The EEPROM does not acknowledge its slave address during the
+ * internal write cycle that follows, so instead of spinning, the next transfer is started
+ * twr_us later from a SysTick one shot and, while it is not acknowledged, retried every
+ * poll_us. The first page of the next write or read therefore doubles as the ACK poll. A
+ * write request completes once the last page is acknowledged as written.
+ *
+ * The callbacks are called from interrupt context. SysTick is used by the engine while a
+ * request is pending, and the system must not enter sleep: see
+ * i2c_eeprom_async_validate_sleep(). i2c_eeprom_configure() and i2c_eeprom_initialize()
+ * must have been called, and the synchronous i2c_eeprom_* functions must not be used
+ * while a request is pending.
+ */
+
+#if defined (CFG_I2C_DMA_SUPPORT)
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "arch.h"
+#include "i2c.h"
+#include "i2c_eeprom.h"
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Number of requests that can be queued
+#ifndef I2C_EEPROM_ASYNC_QUEUE_LEN
+#define I2C_EEPROM_ASYNC_QUEUE_LEN      (4)
+#endif
+
+/// Largest page size supported, sets the size of the write DMA buffer
+#ifndef I2C_EEPROM_ASYNC_PAGE_MAX
+#define I2C_EEPROM_ASYNC_PAGE_MAX       (64)
+#endif
+
+/// Largest DMA transfer of a read
+#define I2C_EEPROM_ASYNC_READ_MAX       (0x8000)
+
+/// Request completion callback, called from interrupt context
+typedef void (*i2c_eeprom_async_cb_t)(void *cb_data, i2c_error_code status, uint32_t len);
+
+/// Asynchronous engine configuration struct
+typedef struct
+{
+    /// DMA channel pair used for the transfers
+    i2c_dma_channel_pair_t dma_channel_pair;
+
+    /// Time from the end of a page write to the first ACK poll (us)
+    uint16_t twr_us;
+
+    /// Time between two ACK polls (us)
+    uint16_t poll_us;
+
+    /// ACK polls before a write cycle is reported as I2C_7B_ADDR_NOACK_ERROR
+    uint16_t poll_max;
+
+} i2c_eeprom_async_cfg_t;
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Initialize the asynchronous engine. Pending requests are dropped.
+ * @param[in] cfg               Engine configuration
+ ****************************************************************************************
+ */
+void i2c_eeprom_async_init(const i2c_eeprom_async_cfg_t *cfg);
+
+/**
+ ****************************************************************************************
+ * @brief Queue a read from I2C EEPROM.
+ * @param[out] rd_data_ptr      Read data pointer, must remain valid until the callback
+ * @param[in] address           Starting memory address
+ * @param[in] size              Size of the data to be read, limited to the memory size
+ * @param[in] cb                Completion callback, with the bytes actually read
+ * @param[in] cb_data           Data to pass to cb
+ * @return I2C_NO_ERROR if the request is queued, I2C_INVALID_EEPROM_ADDRESS or
+ * I2C_QUEUE_FULL_ERROR otherwise (cb is not called)
+ ****************************************************************************************
+ */
+i2c_error_code i2c_eeprom_read_data_async(uint8_t *rd_data_ptr, uint32_t address, uint32_t size,
+                                          i2c_eeprom_async_cb_t cb, void *cb_data);
+
+/**
+ ****************************************************************************************
+ * @brief Queue a write to I2C EEPROM.
+ * @param[in] wr_data_ptr       Pointer to the data, must remain valid until the callback
+ * @param[in] address           Starting address of the write process
+ * @param[in] size              Size of the data to be written, limited to the memory size
+ * @param[in] cb                Completion callback, with the bytes actually written
+ * @param[in] cb_data           Data to pass to cb
+ * @return I2C_NO_ERROR if the request is queued, I2C_INVALID_EEPROM_ADDRESS or
+ * I2C_QUEUE_FULL_ERROR otherwise (cb is not called)
+ ****************************************************************************************
+ */
+i2c_error_code i2c_eeprom_write_data_async(const uint8_t *wr_data_ptr, uint32_t address, uint32_t size,
+                                           i2c_eeprom_async_cb_t cb, void *cb_data);
+
+/**
+ ****************************************************************************************
+ * @brief Check if requests are pending.
+ * @return true if a request is queued or in progress
+ ****************************************************************************************
+ */
+bool i2c_eeprom_async_busy(void);
+
+/**
+ ****************************************************************************************
+ * @brief Keep the system active while requests are pending. To be called from the
+ * app_validate_sleep callback.
+ * @param[in] current_sleep_mode  Current sleep mode.
+ * @return Actual sleep mode.
+ ****************************************************************************************
+ */
+sleep_mode_t i2c_eeprom_async_validate_sleep(sleep_mode_t current_sleep_mode);
+
+#endif // CFG_I2C_DMA_SUPPORT
+
+#endif // _I2C_EEPROM_ASYNC_H_
+
+///@}
+///@}
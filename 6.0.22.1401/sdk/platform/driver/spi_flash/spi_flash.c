@@ -1115,8 +1115,20 @@ int8_t spi_flash_program_fail(void)
  ****************************************************************************************
  */
 
-int8_t spi_flash_read_data(uint8_t *rd_data_ptr, uint32_t address,
-                           uint32_t size, uint32_t *actual_size)
+// Maximum number of data items of a single spi_receive() call
+#define MAX_SPI_RECEIVE         (0xFFFF)
+
+/**
+ ****************************************************************************************
+ * @brief Check the requested size against the flash size and send the read command.
+ * @details The SPI is left in 8-bit mode.
+ * @param[in] address       Starting address of data to be read
+ * @param[in] size          Size of the data to be read
+ * @param[out] actual_size  Actual size of data to be read
+ * @return Error code
+ ****************************************************************************************
+ */
+static int8_t spi_flash_read_start(uint32_t address, uint32_t size, uint32_t *actual_size)
 {
     SPI_FLASH_ENABLE_POWER_PIN();
 
@@ -1145,61 +1157,113 @@ int8_t spi_flash_read_data(uint8_t *rd_data_ptr, uint32_t address,
 
     spi_set_bitmode(SPI_MODE_8BIT);
 
-    // Read data
-    for (uint32_t i = 0; i < *actual_size; i++)
-    {
-        *rd_data_ptr++ = (uint8_t) spi_access(0x0000);
-    }
-
-    spi_cs_high();
-
     return SPI_FLASH_ERR_OK;
 }
 
-int8_t spi_flash_read_data_buffer(uint8_t *rd_data_ptr, uint32_t address,
-                                  uint32_t size, uint32_t *actual_size)
+/**
+ ****************************************************************************************
+ * @brief Receive data items in the current SPI bitmode.
+ * @param[in] rd_data_ptr   Points to the position the read data will be stored
+ * @param[in] items         Number of data items to be read
+ * @param[in] item_size     Size of a data item in bytes (1, 2 or 4)
+ * @param[in] op            SPI_OP_BLOCKING or SPI_OP_DMA
+ ****************************************************************************************
+ */
+static void spi_flash_receive_items(uint8_t *rd_data_ptr, uint32_t items,
+                                    uint8_t item_size, SPI_OP_CFG op)
 {
-    SPI_FLASH_ENABLE_POWER_PIN();
-
-    // Check if SPI Flash is ready
-    int8_t status = spi_flash_is_busy();
-    if (status != SPI_FLASH_ERR_OK)
+    while (items > 0)
     {
-        return status;
+        uint16_t len = (items > MAX_SPI_RECEIVE) ? MAX_SPI_RECEIVE : items;
+
+        spi_receive(rd_data_ptr, len, op);
+#if defined (CFG_SPI_DMA_SUPPORT)
+        if (op == SPI_OP_DMA)
+        {
+            // Wait for DMA to finish
+            spi_wait_dma_read_to_finish();
+        }
+#endif
+        rd_data_ptr += len * item_size;
+        items -= len;
     }
+}
 
-    // Check that all bytes to be read are located in a valid Flash memory address space
-    if (size + address > spi_flash_cfg_env.chip_size)
+/**
+ ****************************************************************************************
+ * @brief Receive the data of a read command that has been started.
+ * @details The bytes up to the first word aligned position and after the last one are
+ * received in 8-bit mode. The words in between are received in 32-bit mode, or in 16-bit
+ * mode with DMA, which cuts the number of SPI accesses (or DMA transfers). The SPI
+ * shifts words in MSB first, so the received words are byte swapped in place.
+ * @param[in] rd_data_ptr   Points to the position the read data will be stored
+ * @param[in] size          Size of the data to be read
+ * @param[in] op            SPI_OP_BLOCKING or SPI_OP_DMA
+ ****************************************************************************************
+ */
+static void spi_flash_receive_data(uint8_t *rd_data_ptr, uint32_t size, SPI_OP_CFG op)
+{
+    uint32_t head = (4 - ((uint32_t) rd_data_ptr & 0x3)) & 0x3;
+    uint32_t words;
+
+    if (head > size)
     {
-        *actual_size = spi_flash_cfg_env.chip_size - address;
+        head = size;
     }
-    else
+
+    spi_flash_receive_items(rd_data_ptr, head, 1, op);
+    rd_data_ptr += head;
+    size -= head;
+
+    words = size / 4;
+    if (words > 0)
     {
-        *actual_size = size;
-    }
+        uint32_t *word_ptr = (uint32_t *) rd_data_ptr;
 
-    // Send Command
-    spi_set_bitmode(SPI_MODE_32BIT);
-    spi_cs_low();
-    // Send sequencial read from memory Command
-    spi_access((SPI_FLASH_OP_READ << 24) | address);
+#if defined (CFG_SPI_DMA_SUPPORT)
+        if (op == SPI_OP_DMA)
+        {
+            spi_set_bitmode(SPI_MODE_16BIT);
+            spi_flash_receive_items(rd_data_ptr, words * 2, 2, op);
 
-    spi_set_bitmode(SPI_MODE_8BIT);
+            for (uint32_t i = 0; i < words; i++)
+            {
+                word_ptr[i] = __REV16(word_ptr[i]);
+            }
+        }
+        else
+#endif
+        {
+            spi_set_bitmode(SPI_MODE_32BIT);
+            spi_flash_receive_items(rd_data_ptr, words, 4, op);
 
-    // Read data
-    const uint16_t MAX_SPI_RECEIVE = 0xFFFF;
+            for (uint32_t i = 0; i < words; i++)
+            {
+                word_ptr[i] = __REV(word_ptr[i]);
+            }
+        }
 
-    for (int i = 0; i < *actual_size / MAX_SPI_RECEIVE; i++)
-    {
-        spi_receive(rd_data_ptr, MAX_SPI_RECEIVE, SPI_OP_BLOCKING);
-        rd_data_ptr += MAX_SPI_RECEIVE;
+        spi_set_bitmode(SPI_MODE_8BIT);
+        rd_data_ptr += words * 4;
+        size -= words * 4;
     }
 
-    uint16_t remaining_len = *actual_size % MAX_SPI_RECEIVE;
+    spi_flash_receive_items(rd_data_ptr, size, 1, op);
+}
 
-    if (remaining_len > 0)
+int8_t spi_flash_read_data(uint8_t *rd_data_ptr, uint32_t address,
+                           uint32_t size, uint32_t *actual_size)
+{
+    int8_t status = spi_flash_read_start(address, size, actual_size);
+    if (status != SPI_FLASH_ERR_OK)
     {
-        spi_receive(rd_data_ptr, remaining_len, SPI_OP_BLOCKING);
+        return status;
+    }
+
+    // Read data
+    for (uint32_t i = 0; i < *actual_size; i++)
+    {
+        *rd_data_ptr++ = (uint8_t) spi_access(0x0000);
     }
 
     spi_cs_high();
@@ -1207,56 +1271,35 @@ int8_t spi_flash_read_data_buffer(uint8_t *rd_data_ptr, uint32_t address,
     return SPI_FLASH_ERR_OK;
 }
 
-#if defined (CFG_SPI_DMA_SUPPORT)
-int8_t spi_flash_read_data_dma(uint8_t *rd_data_ptr, uint32_t address,
-                               uint32_t size, uint32_t *actual_size)
+int8_t spi_flash_read_data_buffer(uint8_t *rd_data_ptr, uint32_t address,
+                                  uint32_t size, uint32_t *actual_size)
 {
-    SPI_FLASH_ENABLE_POWER_PIN();
-
-    // Check if SPI Flash is ready
-    int8_t status = spi_flash_is_busy();
+    int8_t status = spi_flash_read_start(address, size, actual_size);
     if (status != SPI_FLASH_ERR_OK)
     {
         return status;
     }
 
-    // Check that all bytes to be read are located in a valid Flash memory address space
-    if (size + address > spi_flash_cfg_env.chip_size)
-    {
-        *actual_size = spi_flash_cfg_env.chip_size - address;
-    }
-    else
-    {
-        *actual_size = size;
-    }
-
-    // Send Command
-    spi_set_bitmode(SPI_MODE_32BIT);
-    spi_cs_low();
-    // Send sequencial read from memory Command
-    spi_access((SPI_FLASH_OP_READ << 24) | address);
+    // Read data
+    spi_flash_receive_data(rd_data_ptr, *actual_size, SPI_OP_BLOCKING);
 
-    spi_set_bitmode(SPI_MODE_8BIT);
+    spi_cs_high();
 
-    const uint16_t MAX_SPI_RECEIVE = 0xFFFF;
+    return SPI_FLASH_ERR_OK;
+}
 
-    // Read data
-    for (int i = 0; i < *actual_size / MAX_SPI_RECEIVE; i++)
+#if defined (CFG_SPI_DMA_SUPPORT)
+int8_t spi_flash_read_data_dma(uint8_t *rd_data_ptr, uint32_t address,
+                               uint32_t size, uint32_t *actual_size)
+{
+    int8_t status = spi_flash_read_start(address, size, actual_size);
+    if (status != SPI_FLASH_ERR_OK)
     {
-        spi_receive(rd_data_ptr, MAX_SPI_RECEIVE, SPI_OP_DMA);
-        // Wait for DMA to finish
-        spi_wait_dma_read_to_finish();
-        rd_data_ptr += MAX_SPI_RECEIVE;
+        return status;
     }
 
-    uint16_t remaining_len = *actual_size % MAX_SPI_RECEIVE;
-
-    if (remaining_len > 0)
-    {
-        spi_receive(rd_data_ptr, remaining_len, SPI_OP_DMA);
-        // Wait for DMA to finish
-        spi_wait_dma_read_to_finish();
-    }
+    // Read data
+    spi_flash_receive_data(rd_data_ptr, *actual_size, SPI_OP_DMA);
 
     spi_cs_high();
 
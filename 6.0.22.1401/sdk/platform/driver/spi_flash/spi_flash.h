@@ -1080,6 +1080,8 @@ int8_t spi_flash_read_data(uint8_t *rd_data_ptr, uint32_t address,
  * @brief Read data from a given starting address (up to the end of the flash)
  * @details This operation performs SPI transfers on a buffer level using spi_receive().
  * It is recommended to use this function when performance is critical to the application.
+ * The word aligned part of the destination buffer is read in 32-bit mode, which needs
+ * a quarter of the SPI accesses, the bytes before and after it in 8-bit mode.
  * @param[in] rd_data_ptr   Points to the position the read data will be stored
  * @param[in] address       Starting address of data to be read
  * @param[in] size          Size of the data to be read
@@ -1096,6 +1098,8 @@ int8_t spi_flash_read_data_buffer(uint8_t *rd_data_ptr, uint32_t address,
  * @brief Read data from a given starting address (up to the end of the flash)
  * @details This operation performs SPI transfers using the DMA engine.
  * It is recommended to use this function when performance is critical to the application.
+ * The word aligned part of the destination buffer is transferred in 16-bit DMA mode,
+ * the widest mode supported by the SPI DMA, the bytes before and after it in 8-bit mode.
  * @param[in] rd_data_ptr   Points to the position the read data will be stored
  * @param[in] address       Starting address of data to be read
  * @param[in] size          Size of the data to be read
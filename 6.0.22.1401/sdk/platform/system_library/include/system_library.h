@@ -132,6 +132,18 @@
 /*              window.                                                                                         */
 /****************************************************************************************************************/
 
+/****************************************************************************************************************/
+/* Function patch for heap profiling.                                                                           */
+/*                                                                                                              */
+/* Macro:                                                                                                       */
+/* CFG_KE_MEM_PROF                                                                                              */
+/*                                                                                                              */
+/* Description: Profiles the allocations of the kernel heaps (see ke_mem_prof.h). Every allocation and free is  */
+/*              written with its call site to the console UART, with periodic snapshots of the free blocks of   */
+/*              every heap. The stream is decoded by utilities/heap_prof_decoder. Requires                      */
+/*              CFG_PRINTF_RING_BUFFER. The feature can be used in production mode.                             */
+/****************************************************************************************************************/
+
 /****************************************************************************************************************/
 /* Data patch 1.                                                                                                */
 /*                                                                                                              */
@@ -154,6 +166,7 @@
 
 #undef CFG_SKIP_SLAVE_LATENCY
 #undef CFG_USE_HEAP_LOG
+#undef CFG_KE_MEM_PROF
 #undef CFG_USE_DATA_PATCH_1
 #undef CFG_USE_DATA_PATCH_2
 
@@ -161,6 +174,7 @@
 
 #undef CFG_SKIP_SLAVE_LATENCY
 #undef CFG_USE_HEAP_LOG
+#undef CFG_KE_MEM_PROF
 #undef CFG_USE_DATA_PATCH_1
 #undef CFG_USE_DATA_PATCH_2
 
@@ -168,6 +182,7 @@
 
 #undef CFG_SKIP_SLAVE_LATENCY
 #undef CFG_USE_HEAP_LOG
+#undef CFG_KE_MEM_PROF
 #define CFG_USE_DATA_PATCH_1
 #undef CFG_USE_DATA_PATCH_2
 
@@ -176,6 +191,7 @@
 #define CFG_START_SMP_TIMEOUT_TIMER_UPON_TX_SEC_REQ_CMD
 #undef CFG_SKIP_SLAVE_LATENCY
 #undef CFG_USE_HEAP_LOG
+#undef CFG_KE_MEM_PROF
 #define CFG_USE_DATA_PATCH_1
 #undef CFG_USE_DATA_PATCH_2
 
@@ -46,6 +46,7 @@
 #include "lld_evt.h"
 #include "ke_task.h"
 #include "ke_mem.h"
+#include "ke_mem_prof.h"
 #include "gapc_task.h"
 
 /*
@@ -65,7 +66,20 @@
 #define USE_HEAP_LOG                                    (0)
 #endif
 
-#if (USE_HEAP_LOG) || (USE_SKIP_SLAVE_LATENCY)
+#if defined (CFG_KE_MEM_PROF)
+#define USE_KE_MEM_PROF                                 (1)
+#else
+#define USE_KE_MEM_PROF                                 (0)
+#endif
+
+// ke_malloc() and ke_free() are patched with the RAM copies of the heap manager
+#if (USE_HEAP_LOG) || (USE_KE_MEM_PROF)
+#define USE_HEAP_PATCH                                  (1)
+#else
+#define USE_HEAP_PATCH                                  (0)
+#endif
+
+#if (USE_HEAP_PATCH) || (USE_SKIP_SLAVE_LATENCY)
 #define USE_FUNCTION_PATCH                              (1)
 #else
 #define USE_FUNCTION_PATCH                              (0)
@@ -140,12 +154,17 @@ static const void * const patch_orig_table[] = {
      0, // reserved
 #endif
 
-#if (USE_HEAP_LOG)
+#if (USE_HEAP_PATCH)
     (void *) ke_free,                           // original function 2
     0, // reserved
 
     (void *) ke_malloc,                         // original function 3
     0, // reserved
+
+#if (USE_KE_MEM_PROF)
+    (void *) ke_msg_alloc,                      // original function 4
+    0, // reserved
+#endif
 #endif
 
 //    (void *) NULL,        // original function 4
@@ -205,10 +224,16 @@ static const void * const patch_new_table[] = {
 #if (USE_SKIP_SLAVE_LATENCY)
     (void *) PATCHED_lld_evt_schedule_next,
 #endif
-#if (USE_HEAP_LOG)
+#if (USE_HEAP_PATCH)
+#if (USE_KE_MEM_PROF)
+    (void *) ke_mem_prof_free,
+    (void *) ke_mem_prof_malloc,
+    (void *) ke_mem_prof_msg_alloc,
+#else
     (void *) PATCHED_ke_free,
     (void *) PATCHED_ke_malloc,
 #endif
+#endif
 //    (void *) NULL,
 //    (void *) NULL,
 //    (void *) NULL,
@@ -54,6 +54,7 @@
 #include "l2cc_pdu.h"
 #include "hci.h"
 #include "ke_mem.h"
+#include "ke_mem_prof.h"
 #include "gapc_task.h"
 #include "l2cc_task.h"
 
@@ -80,6 +81,19 @@
 #define USE_HEAP_LOG                                                (0)
 #endif
 
+#if defined (CFG_KE_MEM_PROF)
+#define USE_KE_MEM_PROF                                             (1)
+#else
+#define USE_KE_MEM_PROF                                             (0)
+#endif
+
+// ke_malloc() and ke_free() are patched with the RAM copies of the heap manager
+#if (USE_HEAP_LOG) || (USE_KE_MEM_PROF)
+#define USE_HEAP_PATCH                                              (1)
+#else
+#define USE_HEAP_PATCH                                              (0)
+#endif
+
 #define USE_FUNCTION_PATCH                                          (1)
 
 #if defined (CFG_USE_DATA_PATCH_1)
@@ -261,12 +275,12 @@ static const void * const patch_orig_table[] = {
     0, // reserved
 #endif
 
-#if ((USE_SKIP_SLAVE_LATENCY) && (USE_HEAP_LOG))
-    #error "USE_SKIP_SLAVE_LATENCY and USE_HEAP_LOG cannot be enabled at the same build."
+#if ((USE_SKIP_SLAVE_LATENCY) && (USE_HEAP_PATCH))
+    #error "USE_SKIP_SLAVE_LATENCY and USE_HEAP_LOG or USE_KE_MEM_PROF cannot be enabled at the same build."
 #elif (USE_SKIP_SLAVE_LATENCY)
     (void *) lld_evt_schedule_next,             // original function 19
      0, // reserved
-#elif (USE_HEAP_LOG)
+#elif (USE_HEAP_PATCH)
     (void *) ke_free,                           // original function 19
     0, // reserved
 
@@ -306,13 +320,18 @@ static const void * const patch_new_table[] = {
     (void *) PATCHED_smpc_recv_pair_req_pdu,
     (void *) PATCHED_smpc_recv_pair_fail_pdu,
 #endif
-#if ((USE_SKIP_SLAVE_LATENCY) && (USE_HEAP_LOG))
-    #error "USE_SKIP_SLAVE_LATENCY and USE_HEAP_LOG cannot be enabled at the same build."
+#if ((USE_SKIP_SLAVE_LATENCY) && (USE_HEAP_PATCH))
+    #error "USE_SKIP_SLAVE_LATENCY and USE_HEAP_LOG or USE_KE_MEM_PROF cannot be enabled at the same build."
 #elif (USE_SKIP_SLAVE_LATENCY)
     (void *) PATCHED_lld_evt_schedule_next,
-#elif (USE_HEAP_LOG)
+#elif (USE_HEAP_PATCH)
+#if (USE_KE_MEM_PROF)
+    (void *) ke_mem_prof_free,
+    (void *) ke_mem_prof_malloc,
+#else
     (void *) PATCHED_ke_free,
     (void *) PATCHED_ke_malloc,
+#endif
 #else
 //    (void *) NULL,
 //    (void *) NULL,
@@ -0,0 +1,328 @@
+/**
+ ****************************************************************************************
+ *
+ * @file audio_stream.c
+ *
+ * @brief Audio streaming pipeline.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <string.h>
+#include "compiler.h"
+#include "arch.h"
+#include "ll.h"
+#include "audio_stream.h"
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+#if (AUDIO_STREAM_DMA_LEN < 2) || (AUDIO_STREAM_DMA_LEN & 1)
+    #error "CFG_AUDIO_STREAM_DMA_LEN must be an even number of samples."
+#endif
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/// Pipeline environment
+typedef struct
+{
+    /// Send callback
+    audio_stream_send_cb_t send;
+    /// Encoder state
+    ima_adpcm_state_t codec;
+    /// Counters
+    audio_stream_stats_t stats;
+    /// Packet length
+    uint16_t payload_len;
+    /// Bytes of the packet being encoded, 0 until its header is written
+    uint16_t pkt_fill;
+    /// Length of every packet
+    uint16_t pkt_len[AUDIO_STREAM_PKTS];
+    /// Oldest queued packet
+    uint8_t pkt_head;
+    /// Queued packets, the one being encoded follows them
+    uint8_t pkt_count;
+    /// Sequence number of the next packet
+    uint8_t seq;
+    /// A stream is running or has packets left to send
+    bool running;
+    /// The capture has been stopped
+    bool stopping;
+    /// DMA buffer being filled
+    volatile uint8_t dma_fill;
+    /// Filled DMA buffers, before dma_fill
+    volatile uint8_t dma_ready;
+} audio_stream_env_t;
+
+/*
+ * LOCAL VARIABLES
+ ****************************************************************************************
+ */
+
+static audio_stream_env_t audio_stream_env;
+
+/// DMA buffers
+static uint32_t audio_stream_dma_buf[AUDIO_STREAM_DMA_BUFS][AUDIO_STREAM_DMA_LEN];
+
+/// Packets
+static uint8_t audio_stream_pkt[AUDIO_STREAM_PKTS][AUDIO_STREAM_PAYLOAD_MAX];
+
+/*
+ * LOCAL FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Packet at a position of the queue.
+ * @param[in] pos       Position from the oldest queued packet
+ * @return the packet index
+ ****************************************************************************************
+ */
+__STATIC_INLINE uint8_t audio_stream_pkt_idx(uint8_t pos)
+{
+    uint16_t idx = audio_stream_env.pkt_head + pos;
+
+    return (idx >= AUDIO_STREAM_PKTS) ? (idx - AUDIO_STREAM_PKTS) : idx;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Send the queued packets until the send callback refuses one.
+ ****************************************************************************************
+ */
+static void audio_stream_send(void)
+{
+    while (audio_stream_env.pkt_count)
+    {
+        uint8_t idx = audio_stream_env.pkt_head;
+
+        if (!audio_stream_env.send(audio_stream_pkt[idx], audio_stream_env.pkt_len[idx]))
+        {
+            audio_stream_env.stats.send_busy++;
+            break;
+        }
+
+        audio_stream_env.pkt_head = audio_stream_pkt_idx(1);
+        audio_stream_env.pkt_count--;
+        audio_stream_env.stats.pkts_sent++;
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Queue the packet being encoded. The oldest packet is dropped when no packet
+ * is left to encode the next one.
+ ****************************************************************************************
+ */
+static void audio_stream_commit(void)
+{
+    audio_stream_env.pkt_len[audio_stream_pkt_idx(audio_stream_env.pkt_count)] = audio_stream_env.pkt_fill;
+    audio_stream_env.pkt_fill = 0;
+    audio_stream_env.pkt_count++;
+
+    // Try first, the link may have room since the last call
+    audio_stream_send();
+
+    if (audio_stream_env.pkt_count == AUDIO_STREAM_PKTS)
+    {
+        audio_stream_env.pkt_head = audio_stream_pkt_idx(1);
+        audio_stream_env.pkt_count--;
+        audio_stream_env.stats.pkts_dropped++;
+    }
+
+    if (audio_stream_env.pkt_count > audio_stream_env.stats.queue_max)
+    {
+        audio_stream_env.stats.queue_max = audio_stream_env.pkt_count;
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Encode a DMA buffer into packets.
+ * @param[in] src       DMA buffer
+ ****************************************************************************************
+ */
+static void audio_stream_encode(const uint32_t *src)
+{
+    uint16_t left = AUDIO_STREAM_DMA_LEN;
+
+    while (left)
+    {
+        uint8_t *pkt = audio_stream_pkt[audio_stream_pkt_idx(audio_stream_env.pkt_count)];
+        uint16_t nb;
+
+        if (audio_stream_env.pkt_fill == 0)
+        {
+            pkt[0] = audio_stream_env.seq++;
+            pkt[1] = (uint8_t)audio_stream_env.codec.predictor;
+            pkt[2] = (uint8_t)((uint16_t)audio_stream_env.codec.predictor >> 8);
+            pkt[3] = audio_stream_env.codec.index;
+            audio_stream_env.pkt_fill = AUDIO_STREAM_HDR_LEN;
+        }
+
+        nb = AUDIO_STREAM_PKT_SAMPLES(audio_stream_env.payload_len) -
+             2 * (audio_stream_env.pkt_fill - AUDIO_STREAM_HDR_LEN);
+        if (nb > left)
+        {
+            nb = left;
+        }
+
+        ima_adpcm_encode_src(&audio_stream_env.codec, src, &pkt[audio_stream_env.pkt_fill], nb);
+        audio_stream_env.pkt_fill += nb / 2;
+        src += nb;
+        left -= nb;
+
+        if (audio_stream_env.pkt_fill == audio_stream_env.payload_len)
+        {
+            audio_stream_commit();
+        }
+    }
+
+    audio_stream_env.stats.samples += AUDIO_STREAM_DMA_LEN;
+}
+
+/*
+ * EXPORTED FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+uint32_t *audio_stream_start(uint16_t payload_len, audio_stream_send_cb_t send)
+{
+    ASSERT_ERROR((payload_len > AUDIO_STREAM_HDR_LEN) && (payload_len <= AUDIO_STREAM_PAYLOAD_MAX));
+    ASSERT_ERROR(send != NULL);
+
+    GLOBAL_INT_DISABLE();
+    memset(&audio_stream_env, 0, sizeof(audio_stream_env));
+    audio_stream_env.send = send;
+    audio_stream_env.payload_len = payload_len;
+    audio_stream_env.running = true;
+    GLOBAL_INT_RESTORE();
+
+    return audio_stream_dma_buf[0];
+}
+
+void audio_stream_stop(void)
+{
+    audio_stream_env.stopping = true;
+}
+
+uint32_t *audio_stream_dma_cb(uint16_t length)
+{
+    uint8_t fill = audio_stream_env.dma_fill;
+    uint8_t ready = audio_stream_env.dma_ready;
+
+    ASSERT_WARNING(length == AUDIO_STREAM_DMA_LEN);
+
+    if (ready < AUDIO_STREAM_DMA_BUFS - 1)
+    {
+        ready++;
+        audio_stream_env.dma_ready = ready;
+        if (ready > audio_stream_env.stats.dma_max)
+        {
+            audio_stream_env.stats.dma_max = ready;
+        }
+
+        fill = (fill == AUDIO_STREAM_DMA_BUFS - 1) ? 0 : fill + 1;
+        audio_stream_env.dma_fill = fill;
+    }
+    else
+    {
+        // Fill the same buffer again, its samples are lost
+        audio_stream_env.stats.dma_overruns++;
+    }
+
+    return audio_stream_dma_buf[fill];
+}
+
+bool audio_stream_process(void)
+{
+    if (!audio_stream_env.running)
+    {
+        return false;
+    }
+
+    while (audio_stream_env.dma_ready)
+    {
+        uint8_t idx;
+
+        GLOBAL_INT_DISABLE();
+        idx = audio_stream_env.dma_fill + AUDIO_STREAM_DMA_BUFS - audio_stream_env.dma_ready;
+        GLOBAL_INT_RESTORE();
+        if (idx >= AUDIO_STREAM_DMA_BUFS)
+        {
+            idx -= AUDIO_STREAM_DMA_BUFS;
+        }
+
+        // The buffer stays out of the DMA's reach until it is released
+        audio_stream_encode(audio_stream_dma_buf[idx]);
+
+        GLOBAL_INT_DISABLE();
+        audio_stream_env.dma_ready--;
+        GLOBAL_INT_RESTORE();
+    }
+
+    if (audio_stream_env.stopping && (audio_stream_env.pkt_fill > AUDIO_STREAM_HDR_LEN))
+    {
+        audio_stream_commit();
+    }
+
+    audio_stream_send();
+
+    if (audio_stream_env.stopping && !audio_stream_env.pkt_count)
+    {
+        audio_stream_env.running = false;
+    }
+
+    // Packets refused by the link wait for the next call, without keeping the CPU busy
+    return audio_stream_env.dma_ready != 0;
+}
+
+const audio_stream_stats_t *audio_stream_stats(void)
+{
+    return &audio_stream_env.stats;
+}
+
+sleep_mode_t audio_stream_validate_sleep(sleep_mode_t sleep_mode)
+{
+    // The PDM interface and the DMA stop in extended sleep
+    if (audio_stream_env.running && (sleep_mode > mode_idle))
+    {
+        return mode_idle;
+    }
+
+    return sleep_mode;
+}
@@ -0,0 +1,239 @@
+/**
+ ****************************************************************************************
+ * @addtogroup UTILITIES Utilities
+ * @{
+ * @addtogroup AUDIO_STREAM Audio Stream
+ * @brief Microphone to BLE notifications audio pipeline
+ * @{
+ *
+ * @file audio_stream.h
+ *
+ * @brief Audio streaming pipeline API.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _AUDIO_STREAM_H_
+#define _AUDIO_STREAM_H_
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "arch.h"
+#include "ima_adpcm.h"
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/*
+ * The pipeline has three stages:
+ *
+ * - Capture: AUDIO_STREAM_DMA_BUFS buffers of AUDIO_STREAM_DMA_LEN words are filled in
+ *   turn by the DMA. audio_stream_dma_cb() is the pdm_mic callback of the normal (not
+ *   circular) buffer mode: it hands the filled buffer to the encoder and returns the
+ *   next free one. When the encoder has not freed one, the buffer just filled is
+ *   filled again and its samples are lost (dma_overruns).
+ *
+ * - Encoding: audio_stream_process(), called from the main loop, encodes the filled
+ *   buffers to IMA ADPCM straight into packets of the payload size given to
+ *   audio_stream_start(). A packet is sent as soon as it is complete.
+ *
+ * - Sending: complete packets wait in a queue of AUDIO_STREAM_PKTS - 1 packets until the
+ *   send callback accepts them. When the queue is full the oldest packet is dropped
+ *   (pkts_dropped), so the queue bounds the latency added by a slow link to
+ *   (AUDIO_STREAM_PKTS - 1) packets.
+ *
+ * A packet is a notification payload, decodable on its own:
+ *   [0]      sequence number, increments with every packet, dropped ones included
+ *   [1..2]   predictor before the first sample (int16, little endian)
+ *   [3]      step index before the first sample
+ *   [4..]    IMA ADPCM codes, two samples per byte, the first one in the low nibble
+ *
+ * Use with pdm_mic (DA14585/586, CFG_PDM_DMA_SUPPORT), the payload length being the
+ * ATT MTU - 3:
+ *
+ *   pdm_mic_setup_t mic = {
+ *       .buffer = audio_stream_start(mtu - 3, app_audio_send),
+ *       .buffer_length = AUDIO_STREAM_DMA_LEN,
+ *       .buffer_circular = false,
+ *       .int_thresold = 0,
+ *       .sampling_rate = PDM_16000,
+ *       .callback = audio_stream_dma_cb,
+ *       ...
+ *   };
+ *   pdm_mic_start(&mic);
+ *
+ * and from the app_on_system_powered callback:
+ *
+ *   return audio_stream_process() ? KEEP_POWERED : GOTO_SLEEP;
+ *
+ * A packet refused by the send callback is offered again at the next
+ * audio_stream_process(), which should also be called when a notification completes.
+ */
+
+/// Number of DMA buffers, 2 at least
+#ifndef CFG_AUDIO_STREAM_DMA_BUFS
+#define AUDIO_STREAM_DMA_BUFS           (3)
+#else
+#define AUDIO_STREAM_DMA_BUFS           (CFG_AUDIO_STREAM_DMA_BUFS)
+#endif
+
+/// Samples (words) per DMA buffer, 4 ms at 16 kHz
+#ifndef CFG_AUDIO_STREAM_DMA_LEN
+#define AUDIO_STREAM_DMA_LEN            (64)
+#else
+#define AUDIO_STREAM_DMA_LEN            (CFG_AUDIO_STREAM_DMA_LEN)
+#endif
+
+/// Number of packets, the one being encoded included
+#ifndef CFG_AUDIO_STREAM_PKTS
+#define AUDIO_STREAM_PKTS               (6)
+#else
+#define AUDIO_STREAM_PKTS               (CFG_AUDIO_STREAM_PKTS)
+#endif
+
+/// Largest packet, 256 samples
+#ifndef CFG_AUDIO_STREAM_PAYLOAD_MAX
+#define AUDIO_STREAM_PAYLOAD_MAX        (132)
+#else
+#define AUDIO_STREAM_PAYLOAD_MAX        (CFG_AUDIO_STREAM_PAYLOAD_MAX)
+#endif
+
+/// Packet header length
+#define AUDIO_STREAM_HDR_LEN            (4)
+
+/// Samples of a packet of a payload length
+#define AUDIO_STREAM_PKT_SAMPLES(len)   (2 * ((len) - AUDIO_STREAM_HDR_LEN))
+
+#if (AUDIO_STREAM_DMA_BUFS < 2) || (AUDIO_STREAM_DMA_BUFS > 255) || (AUDIO_STREAM_PKTS < 2) || \
+    (AUDIO_STREAM_PKTS > 255) || (AUDIO_STREAM_PAYLOAD_MAX <= AUDIO_STREAM_HDR_LEN) || \
+    (AUDIO_STREAM_PAYLOAD_MAX > 512)
+    #error "Invalid audio stream configuration."
+#endif
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Send a packet, e.g. as a notification. The data are only valid during the call.
+ * @param[in] data      Packet
+ * @param[in] len       Packet length
+ * @return false if the packet could not be sent now
+ ****************************************************************************************
+ */
+typedef bool (*audio_stream_send_cb_t)(const uint8_t *data, uint16_t len);
+
+/// Pipeline counters, cleared by audio_stream_start()
+typedef struct
+{
+    /// Samples encoded
+    uint32_t samples;
+    /// Packets accepted by the send callback
+    uint32_t pkts_sent;
+    /// Packets dropped because the queue was full
+    uint32_t pkts_dropped;
+    /// DMA buffers lost because the encoder had not freed one
+    uint32_t dma_overruns;
+    /// Sends refused by the send callback
+    uint32_t send_busy;
+    /// Largest number of packets waiting in the queue
+    uint8_t queue_max;
+    /// Largest number of filled DMA buffers waiting for the encoder
+    uint8_t dma_max;
+} audio_stream_stats_t;
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Reset the pipeline and start a new stream.
+ * @param[in] payload_len   Packet length, up to AUDIO_STREAM_PAYLOAD_MAX
+ * @param[in] send          Send callback
+ * @return the first DMA buffer, of AUDIO_STREAM_DMA_LEN words
+ ****************************************************************************************
+ */
+uint32_t *audio_stream_start(uint16_t payload_len, audio_stream_send_cb_t send);
+
+/**
+ ****************************************************************************************
+ * @brief Stop the stream after the capture has been stopped. The filled buffers are
+ * encoded, the last packet is completed with the samples it holds and the queued
+ * packets are sent by the following calls to audio_stream_process().
+ ****************************************************************************************
+ */
+void audio_stream_stop(void);
+
+/**
+ ****************************************************************************************
+ * @brief Hand a filled DMA buffer to the encoder. Called from the DMA interrupt.
+ * @param[in] length    Buffer length, AUDIO_STREAM_DMA_LEN
+ * @return the buffer to fill next
+ ****************************************************************************************
+ */
+uint32_t *audio_stream_dma_cb(uint16_t length);
+
+/**
+ ****************************************************************************************
+ * @brief Encode the filled buffers and send the queued packets.
+ * @return true if filled buffers are already waiting again
+ ****************************************************************************************
+ */
+bool audio_stream_process(void);
+
+/**
+ ****************************************************************************************
+ * @brief Read the pipeline counters.
+ * @return the counters
+ ****************************************************************************************
+ */
+const audio_stream_stats_t *audio_stream_stats(void);
+
+/**
+ ****************************************************************************************
+ * @brief Limit the sleep mode while a stream is running. The microphone DMA keeps
+ * running in idle mode only.
+ * @param[in] sleep_mode    Sleep mode the system would enter
+ * @return the sleep mode allowed
+ ****************************************************************************************
+ */
+sleep_mode_t audio_stream_validate_sleep(sleep_mode_t sleep_mode);
+
+#endif // _AUDIO_STREAM_H_
+
+///@}
+///@}
@@ -0,0 +1,220 @@
+/**
+ ****************************************************************************************
+ *
+ * @file ima_adpcm.c
+ *
+ * @brief IMA ADPCM encoder and decoder.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include "compiler.h"
+#include "ima_adpcm.h"
+
+/*
+ * LOCAL VARIABLES
+ ****************************************************************************************
+ */
+
+/// Step size of every index
+static const uint16_t ima_adpcm_steps[IMA_ADPCM_INDEX_MAX + 1] =
+{
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45, 50, 55,
+    60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+    337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963, 1060, 1166, 1282, 1411,
+    1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+    5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500,
+    20350, 22385, 24623, 27086, 29794, 32767
+};
+
+/// Index change of every code magnitude
+static const int8_t ima_adpcm_index_adj[8] = {-1, -1, -1, -1, 2, 4, 6, 8};
+
+/*
+ * LOCAL FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Apply a code to the state, the same way in the encoder and the decoder.
+ * @param[in,out] pred  Predicted sample
+ * @param[in,out] index Step size index
+ * @param[in] code      4 bit code
+ ****************************************************************************************
+ */
+__STATIC_INLINE void ima_adpcm_update(int32_t *pred, int32_t *index, uint8_t code)
+{
+    int32_t step = ima_adpcm_steps[*index];
+    int32_t diff = step >> 3;
+
+    if (code & 4)
+    {
+        diff += step;
+    }
+    if (code & 2)
+    {
+        diff += step >> 1;
+    }
+    if (code & 1)
+    {
+        diff += step >> 2;
+    }
+
+    *pred += (code & 8) ? -diff : diff;
+    if (*pred > INT16_MAX)
+    {
+        *pred = INT16_MAX;
+    }
+    else if (*pred < INT16_MIN)
+    {
+        *pred = INT16_MIN;
+    }
+
+    *index += ima_adpcm_index_adj[code & 7];
+    if (*index < 0)
+    {
+        *index = 0;
+    }
+    else if (*index > IMA_ADPCM_INDEX_MAX)
+    {
+        *index = IMA_ADPCM_INDEX_MAX;
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Code a sample.
+ * @param[in,out] pred  Predicted sample
+ * @param[in,out] index Step size index
+ * @param[in] sample    Sample
+ * @return 4 bit code
+ ****************************************************************************************
+ */
+__STATIC_INLINE uint8_t ima_adpcm_code(int32_t *pred, int32_t *index, int32_t sample)
+{
+    int32_t step = ima_adpcm_steps[*index];
+    int32_t diff = sample - *pred;
+    uint8_t code = 0;
+
+    if (diff < 0)
+    {
+        code = 8;
+        diff = -diff;
+    }
+
+    // Successive approximation of diff / step on 3 bits
+    if (diff >= step)
+    {
+        code |= 4;
+        diff -= step;
+    }
+    step >>= 1;
+    if (diff >= step)
+    {
+        code |= 2;
+        diff -= step;
+    }
+    step >>= 1;
+    if (diff >= step)
+    {
+        code |= 1;
+    }
+
+    ima_adpcm_update(pred, index, code);
+
+    return code;
+}
+
+/*
+ * EXPORTED FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+void ima_adpcm_encode(ima_adpcm_state_t *state, const int16_t *pcm, uint8_t *out, uint16_t nb)
+{
+    int32_t pred = state->predictor;
+    int32_t index = state->index;
+    uint16_t i;
+
+    for (i = 0; i + 1 < nb; i += 2)
+    {
+        uint8_t code = ima_adpcm_code(&pred, &index, pcm[i]);
+
+        *out++ = code | (ima_adpcm_code(&pred, &index, pcm[i + 1]) << 4);
+    }
+    if (i < nb)
+    {
+        *out = ima_adpcm_code(&pred, &index, pcm[i]);
+    }
+
+    state->predictor = (int16_t)pred;
+    state->index = (uint8_t)index;
+}
+
+void ima_adpcm_encode_src(ima_adpcm_state_t *state, const uint32_t *src, uint8_t *out, uint16_t nb)
+{
+    int32_t pred = state->predictor;
+    int32_t index = state->index;
+    uint16_t i;
+
+    for (i = 0; i + 1 < nb; i += 2)
+    {
+        uint8_t code = ima_adpcm_code(&pred, &index, (int16_t)(src[i] >> 16));
+
+        *out++ = code | (ima_adpcm_code(&pred, &index, (int16_t)(src[i + 1] >> 16)) << 4);
+    }
+    if (i < nb)
+    {
+        *out = ima_adpcm_code(&pred, &index, (int16_t)(src[i] >> 16));
+    }
+
+    state->predictor = (int16_t)pred;
+    state->index = (uint8_t)index;
+}
+
+void ima_adpcm_decode(ima_adpcm_state_t *state, const uint8_t *in, int16_t *pcm, uint16_t nb)
+{
+    int32_t pred = state->predictor;
+    int32_t index = state->index;
+    uint16_t i;
+
+    for (i = 0; i < nb; i++)
+    {
+        uint8_t code = (i & 1) ? (in[i >> 1] >> 4) : (in[i >> 1] & 0x0F);
+
+        ima_adpcm_update(&pred, &index, code);
+        pcm[i] = (int16_t)pred;
+    }
+
+    state->predictor = (int16_t)pred;
+    state->index = (uint8_t)index;
+}
@@ -0,0 +1,122 @@
+/**
+ ****************************************************************************************
+ * @addtogroup UTILITIES Utilities
+ * @{
+ * @addtogroup IMA_ADPCM IMA ADPCM
+ * @brief 4 bit IMA ADPCM audio codec
+ * @{
+ *
+ * @file ima_adpcm.h
+ *
+ * @brief IMA ADPCM encoder and decoder API.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _IMA_ADPCM_H_
+#define _IMA_ADPCM_H_
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stdint.h>
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/*
+ * Integer only IMA/DVI ADPCM: every 16 bit sample is coded as a 4 bit difference from
+ * a prediction, with an adaptive step size. Two samples are packed per byte, the first
+ * one in the low nibble, as in the IMA ADPCM WAV format. The encoder and the decoder
+ * keep the same state, so a stream can be decoded from any point where the state has
+ * been sent along.
+ */
+
+/// Largest step index
+#define IMA_ADPCM_INDEX_MAX         (88)
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/// Codec state
+typedef struct
+{
+    /// Predicted sample
+    int16_t predictor;
+    /// Step size index, 0 to IMA_ADPCM_INDEX_MAX
+    uint8_t index;
+} ima_adpcm_state_t;
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Encode 16 bit samples.
+ * @param[in,out] state Codec state
+ * @param[in] pcm       Samples
+ * @param[out] out      Codes, (nb + 1) / 2 bytes. The high nibble of the last byte is
+ *                      zero when nb is odd.
+ * @param[in] nb        Number of samples
+ ****************************************************************************************
+ */
+void ima_adpcm_encode(ima_adpcm_state_t *state, const int16_t *pcm, uint8_t *out, uint16_t nb);
+
+/**
+ ****************************************************************************************
+ * @brief Encode the samples of 32 bit words holding the sample in their upper half, as
+ * read from the sample rate converter output register.
+ * @param[in,out] state Codec state
+ * @param[in] src       Words
+ * @param[out] out      Codes, (nb + 1) / 2 bytes
+ * @param[in] nb        Number of samples
+ ****************************************************************************************
+ */
+void ima_adpcm_encode_src(ima_adpcm_state_t *state, const uint32_t *src, uint8_t *out, uint16_t nb);
+
+/**
+ ****************************************************************************************
+ * @brief Decode samples.
+ * @param[in,out] state Codec state
+ * @param[in] in        Codes, two per byte
+ * @param[out] pcm      Samples
+ * @param[in] nb        Number of samples
+ ****************************************************************************************
+ */
+void ima_adpcm_decode(ima_adpcm_state_t *state, const uint8_t *in, int16_t *pcm, uint16_t nb);
+
+#endif // _IMA_ADPCM_H_
+
+///@}
+///@}
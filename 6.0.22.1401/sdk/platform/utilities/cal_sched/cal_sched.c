@@ -0,0 +1,203 @@
+/**
+ ****************************************************************************************
+ *
+ * @file cal_sched.c
+ *
+ * @brief Predictive calibration scheduler.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include "cal_sched.h"
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// BLE time counter mask
+#define CAL_SCHED_TIME_MASK     (0x07FFFFFF)
+
+/// BLE slots (625 us) per second
+#define CAL_SCHED_SLOTS_PER_S   (1600)
+
+#define CAL_SCHED_MIN_SLOTS     ((uint32_t)CAL_SCHED_MIN_INTERVAL_MS * 8 / 5)
+#define CAL_SCHED_MAX_SLOTS     ((uint32_t)CAL_SCHED_MAX_INTERVAL_MS * 8 / 5)
+#define CAL_SCHED_LAST_SLOTS    ((uint32_t)CAL_SCHED_LAST_INTERVAL_MS * 8 / 5)
+
+/// Gap after which the previous samples are not used, e.g. after hibernation
+#define CAL_SCHED_STALE_SLOTS   (4 * CAL_SCHED_MAX_SLOTS)
+
+/// One degree, in slope units
+#define CAL_SCHED_ONE_DEG       (1 << CAL_SCHED_SLOPE_SHIFT)
+
+/// Largest drift between two samples in the last degree before a threshold (slope units)
+#define CAL_SCHED_LAST_DRIFT    (CAL_SCHED_ONE_DEG / 8)
+
+#if (CAL_SCHED_MIN_INTERVAL_MS < 100) || (CAL_SCHED_MAX_INTERVAL_MS > 600000) || \
+    (CAL_SCHED_MIN_INTERVAL_MS > CAL_SCHED_LAST_INTERVAL_MS) || \
+    (CAL_SCHED_LAST_INTERVAL_MS > CAL_SCHED_MAX_INTERVAL_MS)
+    #error "The calibration scheduler intervals must be within 100 ms and 10 min, in order."
+#endif
+
+/*
+ * EXPORTED FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+bool cal_sched_due(const cal_sched_t *sched, uint32_t time)
+{
+    return !sched->valid || (((time - sched->last) & CAL_SCHED_TIME_MASK) >= sched->interval);
+}
+
+bool cal_sched_accepts(const cal_sched_t *sched, uint32_t time)
+{
+    return !sched->valid || (((time - sched->last) & CAL_SCHED_TIME_MASK) >= sched->interval / 2);
+}
+
+uint8_t cal_sched_sample(cal_sched_t *sched, int8_t temp, uint32_t time,
+                         const int8_t *ref, const uint8_t *diff, uint8_t nb)
+{
+    uint32_t elapsed = (time - sched->last) & CAL_SCHED_TIME_MASK;
+    uint32_t slope;
+    uint32_t interval = CAL_SCHED_MAX_SLOTS;
+    bool moved = false;
+    uint8_t cals = 0;
+    uint8_t i;
+
+    if (!sched->valid || (elapsed > CAL_SCHED_STALE_SLOTS))
+    {
+        // Sample again soon to learn the slope
+        sched->valid = true;
+        sched->slope = 0;
+        sched->change = time;
+        sched->interval = CAL_SCHED_MIN_SLOTS;
+    }
+    else if (temp != sched->temp)
+    {
+        int32_t d = temp - sched->temp;
+        // A one degree step ends the plateau it is spread over, a larger step is fast
+        uint32_t span = ((d == 1) || (d == -1)) ? ((time - sched->change) & CAL_SCHED_TIME_MASK) : elapsed;
+
+        sched->slope = (d * CAL_SCHED_ONE_DEG * CAL_SCHED_SLOTS_PER_S) / (int32_t)(span ? span : 1);
+        sched->change = time;
+        moved = true;
+    }
+    else
+    {
+        // Still on the same degree: the slope is below one degree over the plateau
+        uint32_t plateau = (time - sched->change) & CAL_SCHED_TIME_MASK;
+
+        if (plateau)
+        {
+            int32_t bound = (CAL_SCHED_ONE_DEG * CAL_SCHED_SLOTS_PER_S) / plateau;
+
+            if (sched->slope > bound)
+            {
+                sched->slope = bound;
+            }
+            else if (sched->slope < -bound)
+            {
+                sched->slope = -bound;
+            }
+        }
+    }
+    slope = (sched->slope < 0) ? -sched->slope : sched->slope;
+
+    for (i = 0; (i < nb) && (i < CAL_SCHED_MAX_CALS); i++)
+    {
+        int32_t dev;
+        uint32_t room, limit;
+
+        if (ref[i] == CAL_SCHED_NO_REF)
+        {
+            continue;
+        }
+
+        dev = temp - ref[i];
+        if ((dev >= diff[i]) || (-dev >= diff[i]))
+        {
+            cals |= 1 << i;
+            dev = 0;
+        }
+
+        // Whole degrees to the last one before the nearest threshold. The slope sign is
+        // not trusted: a sample toggling between two degrees flips it.
+        room = (diff[i] - ((dev < 0) ? -dev : dev) - 1) << CAL_SCHED_SLOPE_SHIFT;
+
+        if (room)
+        {
+            // Half of the time to the last degree, so that the predicted crossing falls
+            // after the next sample
+            limit = slope ? (room * CAL_SCHED_SLOTS_PER_S / slope) / 2 : CAL_SCHED_MAX_SLOTS;
+        }
+        else
+        {
+            // The rounding hides where the threshold is within the last degree: sample it
+            // at least every CAL_SCHED_LAST_INTERVAL_MS, and often enough to bound the
+            // drift between two samples
+            limit = slope ? (CAL_SCHED_LAST_DRIFT * CAL_SCHED_SLOTS_PER_S / slope)
+                          : CAL_SCHED_LAST_SLOTS;
+            if (limit > CAL_SCHED_LAST_SLOTS)
+            {
+                limit = CAL_SCHED_LAST_SLOTS;
+            }
+        }
+
+        if (limit < interval)
+        {
+            interval = limit;
+        }
+    }
+
+    if (interval > 2 * sched->interval)
+    {
+        interval = 2 * sched->interval;
+    }
+    if (moved && (interval > sched->interval))
+    {
+        interval = sched->interval;
+    }
+    if (interval < CAL_SCHED_MIN_SLOTS)
+    {
+        interval = CAL_SCHED_MIN_SLOTS;
+    }
+    else if (interval > CAL_SCHED_MAX_SLOTS)
+    {
+        interval = CAL_SCHED_MAX_SLOTS;
+    }
+
+    sched->interval = interval;
+    sched->last = time;
+    sched->temp = temp;
+
+    return cals;
+}
@@ -0,0 +1,170 @@
+/**
+ ****************************************************************************************
+ * @addtogroup UTILITIES Utilities
+ * @{
+ * @addtogroup CAL_SCHED Calibration Scheduler
+ * @brief Temperature driven scheduling of the RF calibration and XTAL32M trimming
+ * @{
+ *
+ * @file cal_sched.h
+ *
+ * @brief Predictive calibration scheduler API.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _CAL_SCHED_H_
+#define _CAL_SCHED_H_
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/*
+ * The scheduler decides when the die temperature is sampled and which of the temperature
+ * compensated calibrations must run. Every calibration has a reference, the temperature
+ * it last ran at, and a threshold: it runs again when the temperature has moved by the
+ * threshold from its reference.
+ *
+ * The temperature samples are whole degrees, so the slope is estimated from the time
+ * the temperature takes to move by one degree, and bounded by the time it has stayed on
+ * the same degree. The next sample is taken after half the time the temperature is
+ * predicted to take to reach the last degree before the nearest threshold, between
+ * CAL_SCHED_MIN_INTERVAL_MS and CAL_SCHED_MAX_INTERVAL_MS, and at most twice the
+ * previous interval. Within the last degree the rounding hides how close the threshold
+ * is: the temperature is sampled at least every CAL_SCHED_LAST_INTERVAL_MS, and more
+ * often when it moves fast. The calibrations run at their thresholds only.
+ *
+ * Samples taken by other users of the GP ADC are used when at least half of the
+ * interval has elapsed, and restart it.
+ */
+
+/// Shortest sampling interval (ms)
+#ifndef CFG_CAL_SCHED_MIN_INTERVAL_MS
+#define CAL_SCHED_MIN_INTERVAL_MS       (500)
+#else
+#define CAL_SCHED_MIN_INTERVAL_MS       (CFG_CAL_SCHED_MIN_INTERVAL_MS)
+#endif
+
+/// Longest sampling interval (ms). A heating onset is only seen at the next sample: the
+/// interval times the fastest expected slope must stay below the smallest threshold.
+#ifndef CFG_CAL_SCHED_MAX_INTERVAL_MS
+#define CAL_SCHED_MAX_INTERVAL_MS       (8000)
+#else
+#define CAL_SCHED_MAX_INTERVAL_MS       (CFG_CAL_SCHED_MAX_INTERVAL_MS)
+#endif
+
+/// Longest sampling interval in the last degree before a threshold (ms)
+#ifndef CFG_CAL_SCHED_LAST_INTERVAL_MS
+#define CAL_SCHED_LAST_INTERVAL_MS      (1000)
+#else
+#define CAL_SCHED_LAST_INTERVAL_MS      (CFG_CAL_SCHED_LAST_INTERVAL_MS)
+#endif
+
+/// Largest number of calibrations handled by a scheduler
+#define CAL_SCHED_MAX_CALS              (8)
+
+/// Reference of a calibration that has not run yet
+#define CAL_SCHED_NO_REF                (127)
+
+/// Slope fractional bits
+#define CAL_SCHED_SLOPE_SHIFT           (8)
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/// Scheduler state, all zero when it has not sampled yet
+typedef struct
+{
+    /// Time of the last sample (BLE slots)
+    uint32_t last;
+    /// Time the temperature moved to its current degree (BLE slots)
+    uint32_t change;
+    /// Time from the last sample to the next one (BLE slots)
+    uint32_t interval;
+    /// Temperature slope (1/256 degC per second)
+    int32_t slope;
+    /// Last sample (degC)
+    int8_t temp;
+    /// A sample has been taken
+    bool valid;
+} cal_sched_t;
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Check if the temperature must be sampled.
+ * @param[in] sched     Scheduler
+ * @param[in] time      BLE time (slots)
+ * @return true if a sample is due
+ ****************************************************************************************
+ */
+bool cal_sched_due(const cal_sched_t *sched, uint32_t time);
+
+/**
+ ****************************************************************************************
+ * @brief Check if a sample taken by another user of the GP ADC is worth using.
+ * @param[in] sched     Scheduler
+ * @param[in] time      BLE time (slots)
+ * @return true if at least half of the sampling interval has elapsed
+ ****************************************************************************************
+ */
+bool cal_sched_accepts(const cal_sched_t *sched, uint32_t time);
+
+/**
+ ****************************************************************************************
+ * @brief Account a temperature sample and schedule the next one.
+ * @param[in] sched     Scheduler
+ * @param[in] temp      Die temperature (degC)
+ * @param[in] time      BLE time of the sample (slots)
+ * @param[in] ref       Reference of every calibration, CAL_SCHED_NO_REF to skip one
+ * @param[in] diff      Threshold of every calibration (degC)
+ * @param[in] nb        Number of calibrations, up to CAL_SCHED_MAX_CALS
+ * @return bit n set if calibration n must run now, at this temperature
+ ****************************************************************************************
+ */
+uint8_t cal_sched_sample(cal_sched_t *sched, int8_t temp, uint32_t time,
+                         const int8_t *ref, const uint8_t *diff, uint8_t nb);
+
+#endif // _CAL_SCHED_H_
+
+///@}
+///@}
@@ -0,0 +1,249 @@
+/**
+ ****************************************************************************************
+ *
+ * @file lzss.c
+ *
+ * @brief Streaming decoder of LZSS compressed images.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stddef.h>
+#include "lzss.h"
+
+extern uint32_t crc32(uint32_t crc, const void *buf, size_t size);
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Decoder states
+enum
+{
+    LZSS_ST_HEADER,
+    LZSS_ST_TAG,
+    LZSS_ST_LITERAL,
+    LZSS_ST_BACKREF,
+    LZSS_ST_COPY,
+    LZSS_ST_DONE,
+    LZSS_ST_ERROR,
+};
+
+/*
+ * LOCAL FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+static uint32_t get_le32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Read n bits (n <= 23) from the input.
+ * @return false if the input ran out first; the bits read so far are kept.
+ ****************************************************************************************
+ */
+static bool get_bits(lzss_dec_t *dec, uint8_t n, const uint8_t *in, uint32_t in_len,
+                     uint32_t *in_pos, uint32_t *value)
+{
+    while (dec->bit_count < n)
+    {
+        if (*in_pos == in_len)
+        {
+            return false;
+        }
+        dec->bits = (dec->bits << 8) | in[(*in_pos)++];
+        dec->bit_count += 8;
+    }
+    dec->bit_count -= n;
+    *value = (dec->bits >> dec->bit_count) & ((1UL << n) - 1);
+    return true;
+}
+
+static void put_byte(lzss_dec_t *dec, uint8_t *out, uint32_t *out_pos, uint8_t byte, uint16_t mask)
+{
+    out[(*out_pos)++] = byte;
+    dec->out_total++;
+    if (dec->window != NULL)
+    {
+        dec->window[dec->head] = byte;
+        dec->head = (dec->head + 1) & mask;
+    }
+}
+
+static int parse_header(lzss_dec_t *dec)
+{
+    const uint8_t *h = dec->header;
+
+    if ((h[0] != LZSS_MAGIC0) || (h[1] != LZSS_MAGIC1) ||
+        (h[2] < LZSS_WINDOW_LOG2_MIN) || (h[2] > LZSS_WINDOW_LOG2_MAX) ||
+        (h[3] < LZSS_LOOKAHEAD_LOG2_MIN) || (h[3] >= h[2]))
+    {
+        return LZSS_ERR_HEADER;
+    }
+    if ((dec->window != NULL) && (dec->window_size < (1U << h[2])))
+    {
+        return LZSS_ERR_WINDOW;
+    }
+
+    dec->window_log2 = h[2];
+    dec->lookahead_log2 = h[3];
+    dec->size = get_le32(&h[4]);
+    dec->expected_crc = get_le32(&h[8]);
+    return LZSS_OK;
+}
+
+/*
+ * EXPORTED FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+void lzss_init(lzss_dec_t *dec, uint8_t *window, uint16_t window_size)
+{
+    dec->window = window;
+    dec->window_size = window_size;
+    dec->head = 0;
+    dec->bits = 0;
+    dec->bit_count = 0;
+    dec->state = LZSS_ST_HEADER;
+    dec->header_len = 0;
+    dec->size = 0;
+    dec->out_total = 0;
+    dec->crc = 0;
+}
+
+bool lzss_header_done(const lzss_dec_t *dec)
+{
+    return dec->state != LZSS_ST_HEADER;
+}
+
+int lzss_decode(lzss_dec_t *dec, const uint8_t *in, uint32_t in_len, uint32_t *in_used,
+                uint8_t *out, uint32_t out_len, uint32_t *out_used)
+{
+    uint32_t in_pos = 0;
+    uint32_t out_pos = 0;
+    uint16_t mask = (1U << dec->window_log2) - 1;
+    uint32_t value;
+    int ret = LZSS_OK;
+
+    while ((ret == LZSS_OK) && (dec->state != LZSS_ST_DONE))
+    {
+        if (dec->state == LZSS_ST_HEADER)
+        {
+            if (in_pos == in_len)
+            {
+                break;
+            }
+            dec->header[dec->header_len++] = in[in_pos++];
+            if (dec->header_len == LZSS_HEADER_SIZE)
+            {
+                ret = parse_header(dec);
+                mask = (1U << dec->window_log2) - 1;
+                dec->state = LZSS_ST_TAG;
+            }
+        }
+        else if (dec->out_total == dec->size)
+        {
+            dec->state = LZSS_ST_DONE;
+        }
+        else if (dec->state == LZSS_ST_TAG)
+        {
+            if (!get_bits(dec, 1, in, in_len, &in_pos, &value))
+            {
+                break;
+            }
+            dec->state = value ? LZSS_ST_LITERAL : LZSS_ST_BACKREF;
+        }
+        else if (dec->state == LZSS_ST_LITERAL)
+        {
+            if ((out_pos == out_len) || !get_bits(dec, 8, in, in_len, &in_pos, &value))
+            {
+                break;
+            }
+            put_byte(dec, out, &out_pos, (uint8_t) value, mask);
+            dec->state = LZSS_ST_TAG;
+        }
+        else if (dec->state == LZSS_ST_BACKREF)
+        {
+            if (!get_bits(dec, dec->window_log2 + dec->lookahead_log2, in, in_len, &in_pos, &value))
+            {
+                break;
+            }
+            dec->distance = (value >> dec->lookahead_log2) + 1;
+            dec->count = (value & ((1U << dec->lookahead_log2) - 1)) +
+                         LZSS_MIN_MATCH(dec->window_log2, dec->lookahead_log2);
+            if ((dec->distance > dec->out_total) || (dec->count > (dec->size - dec->out_total)))
+            {
+                ret = LZSS_ERR_DATA;
+                break;
+            }
+            dec->state = LZSS_ST_COPY;
+        }
+        else // LZSS_ST_COPY
+        {
+            if (out_pos == out_len)
+            {
+                break;
+            }
+            if (dec->window != NULL)
+            {
+                put_byte(dec, out, &out_pos, dec->window[(dec->head - dec->distance) & mask], mask);
+            }
+            else
+            {
+                // The output buffers are contiguous, the history precedes out[out_pos]
+                put_byte(dec, out, &out_pos, *(out + out_pos - dec->distance), mask);
+            }
+            if (--dec->count == 0)
+            {
+                dec->state = LZSS_ST_TAG;
+            }
+        }
+    }
+
+    dec->crc = crc32(dec->crc, out, out_pos);
+
+    if ((ret == LZSS_OK) && (dec->state == LZSS_ST_DONE))
+    {
+        ret = (dec->crc == dec->expected_crc) ? LZSS_DONE : LZSS_ERR_CRC;
+    }
+    if (ret < 0)
+    {
+        dec->state = LZSS_ST_ERROR;
+    }
+
+    *in_used = in_pos;
+    *out_used = out_pos;
+    return ret;
+}
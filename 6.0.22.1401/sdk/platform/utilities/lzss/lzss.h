@@ -0,0 +1,180 @@
+/**
+ ****************************************************************************************
+ * @addtogroup UTILITIES Utilities
+ * @{
+ * @addtogroup LZSS LZSS Decoder
+ * @brief Streaming decoder of LZSS compressed images
+ * @{
+ *
+ * @file lzss.h
+ *
+ * @brief Compressed image format and streaming decoder API.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _LZSS_H_
+#define _LZSS_H_
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/*
+ * Compressed image format (created by mkimage compress):
+ *     magic[2] window_log2[1] lookahead_log2[1] size[4] crc[4] bitstream
+ * size and crc (CRC32, zlib compatible) describe the decompressed data, little endian.
+ * The first magic byte is odd, so a compressed image cannot be mistaken for a raw one,
+ * which starts with the initial stack pointer.
+ * The bitstream is read MSB first. Each item starts with a tag bit:
+ * - 1: literal, followed by the 8-bit byte,
+ * - 0: back-reference, followed by (distance - 1) on window_log2 bits and
+ *      (length - LZSS_MIN_MATCH()) on lookahead_log2 bits, copying length bytes of the
+ *      output from distance bytes back.
+ * Trailing bits of the last byte are ignored.
+ */
+#define LZSS_MAGIC0                 (0xA5)
+#define LZSS_MAGIC1                 (0x4C)
+#define LZSS_HEADER_SIZE            (12)
+
+/// Window size limits (log2). The decoder needs a window of (1 << window_log2) bytes.
+#define LZSS_WINDOW_LOG2_MIN        (8)
+#define LZSS_WINDOW_LOG2_MAX        (12)
+
+/// Lookahead limits (log2); the lookahead must also be smaller than the window
+#define LZSS_LOOKAHEAD_LOG2_MIN     (3)
+
+/// Shortest back-reference, the first length that takes fewer bits than literals
+#define LZSS_MIN_MATCH(w, l)        (((1 + (w) + (l)) / 9) + 1)
+
+/// lzss_decode() return values
+enum
+{
+    /// More input is needed or the output buffer is full
+    LZSS_OK = 0,
+    /// All the data have been decoded and their CRC matches
+    LZSS_DONE = 1,
+    /// Not a compressed image or unsupported parameters
+    LZSS_ERR_HEADER = -1,
+    /// The window given to lzss_init() is too small for the image
+    LZSS_ERR_WINDOW = -2,
+    /// Corrupted bitstream
+    LZSS_ERR_DATA = -3,
+    /// The CRC of the decoded data does not match
+    LZSS_ERR_CRC = -4,
+};
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/// Decoder state
+typedef struct
+{
+    /// History window, NULL when the output is one contiguous buffer
+    uint8_t *window;
+    /// Window size given to lzss_init()
+    uint16_t window_size;
+    /// Next write position in the window
+    uint16_t head;
+    /// Back-reference being copied
+    uint16_t distance;
+    uint16_t count;
+    /// Bits read ahead from the input
+    uint32_t bits;
+    uint8_t bit_count;
+    uint8_t state;
+    uint8_t window_log2;
+    uint8_t lookahead_log2;
+    uint8_t header_len;
+    uint8_t header[LZSS_HEADER_SIZE];
+    /// Decompressed size, valid once the header has been decoded
+    uint32_t size;
+    /// Bytes decoded so far
+    uint32_t out_total;
+    /// CRC32 of the bytes decoded so far and the expected one
+    uint32_t crc;
+    uint32_t expected_crc;
+} lzss_dec_t;
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Prepare the decoding of a compressed image.
+ * @param[in] dec           Decoder state
+ * @param[in] window        History buffer of at least (1 << window_log2) bytes of the image,
+ *                          or NULL if the output of all the lzss_decode() calls is one
+ *                          contiguous buffer, in which case the history is read from it
+ * @param[in] window_size   Size of the history buffer
+ ****************************************************************************************
+ */
+void lzss_init(lzss_dec_t *dec, uint8_t *window, uint16_t window_size);
+
+/**
+ ****************************************************************************************
+ * @brief Decode a part of a compressed image.
+ * @details The function consumes input until it runs out of it, the output buffer is full
+ *          or the image is complete, so it can be fed with chunks of any size.
+ * @param[in] dec           Decoder state
+ * @param[in] in            Compressed data
+ * @param[in] in_len        Number of compressed bytes
+ * @param[out] in_used      Number of compressed bytes consumed
+ * @param[out] out          Output buffer
+ * @param[in] out_len       Size of the output buffer
+ * @param[out] out_used     Number of bytes written to the output buffer
+ * @return LZSS_OK, LZSS_DONE or a negative LZSS_ERR_xxx value
+ ****************************************************************************************
+ */
+int lzss_decode(lzss_dec_t *dec, const uint8_t *in, uint32_t in_len, uint32_t *in_used,
+                uint8_t *out, uint32_t out_len, uint32_t *out_used);
+
+/**
+ ****************************************************************************************
+ * @brief Check if the header of the image has been decoded, which makes dec->size valid.
+ * @param[in] dec           Decoder state
+ * @return true if the header has been decoded
+ ****************************************************************************************
+ */
+bool lzss_header_done(const lzss_dec_t *dec);
+
+#endif // _LZSS_H_
+
+///@}
+///@}
@@ -0,0 +1,428 @@
+/**
+ ****************************************************************************************
+ *
+ * @file adc_scan_bench.c
+ *
+ * @brief Host benchmark of the GP ADC block correction and decimation stage.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+#define _DEFAULT_SOURCE
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC
+#endif
+
+#include "arch.h"
+#include "datasheet.h"
+#include "otp_cs.h"
+#include "adc.h"
+#include "adc_decim.h"
+
+#define ADC_SCAN_BENCH_VERSION	"v_1.0"
+
+#define GP_ADC_BASE		GP_ADC_CTRL_REG
+#define GP_ADC_REGS		0x10		/* 16 bit registers from GP_ADC_CTRL_REG */
+#define CHUNK			0x8000		/* largest block of a single call */
+
+#define MIN(a, b)		((a) < (b) ? (a) : (b))
+
+/* OTP configuration script, read by the driver */
+otp_cs_t otp_cs;
+
+static uint16_t regs[GP_ADC_REGS];
+static uint32_t seed = 1;
+
+/* Register model: plain storage, the bench only needs the configuration registers */
+uint32_t host_reg_read(uint32_t addr)
+{
+	uint32_t idx = (addr - GP_ADC_BASE) / 2;
+
+	if (addr < GP_ADC_BASE || idx >= GP_ADC_REGS || (addr & 1)) {
+		fprintf(stderr, "read of unknown register 0x%08x\n", addr);
+		exit(EXIT_FAILURE);
+	}
+	return regs[idx];
+}
+
+void host_reg_write(uint32_t addr, uint32_t value)
+{
+	uint32_t idx = (addr - GP_ADC_BASE) / 2;
+
+	if (addr < GP_ADC_BASE || idx >= GP_ADC_REGS || (addr & 1)) {
+		fprintf(stderr, "write of unknown register 0x%08x\n", addr);
+		exit(EXIT_FAILURE);
+	}
+	/* Conversions complete at once */
+	if (addr == GP_ADC_CTRL_REG)
+		value &= ~GP_ADC_START;
+	regs[idx] = (uint16_t) value;
+}
+
+void arch_asm_delay_us(int nof_us)
+{
+}
+
+static uint32_t rnd(void)
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	return seed;
+}
+
+static double rnd_gauss(void)
+{
+	double u1 = ((rnd() >> 8) + 0.5) / (double)(1 << 24);
+	double u2 = ((rnd() >> 8) + 0.5) / (double)(1 << 24);
+
+	return sqrt(-2 * log(u1)) * cos(2 * M_PI * u2);
+}
+
+static uint64_t cycles(void)
+{
+#ifdef HAVE_TSC
+	return __rdtsc();
+#else
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+#endif
+}
+
+static double seconds(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+ * Slowly varying sensor reading with white noise, kept away from the rails where the
+ * per-sample clamping of adc_correct_sample() makes the average differ anyway.
+ */
+static void synth(uint16_t *raw, uint32_t nb, double noise)
+{
+	uint32_t i;
+
+	for (i = 0; i < nb; i++) {
+		double v = 32768 + 24000 * sin(2 * M_PI * i / 200000.0) +
+			   3000 * sin(2 * M_PI * i / 3100.0) + noise * rnd_gauss();
+
+		if (v < 0)
+			v = 0;
+		if (v > 65535)
+			v = 65535;
+		raw[i] = (uint16_t)lrint(v);
+	}
+}
+
+/*
+ * Direct form of the CIC filter: the impulse response is N boxcars of R ones
+ * convolved. Output k is taken after input sample (k + 1) R - 1, the first N - 1
+ * outputs are dropped as by the decimator.
+ */
+static uint32_t cic_direct(const uint16_t *x, uint32_t nb, int order, int r, uint16_t *out)
+{
+	uint32_t ratio = 1u << r, len = 1, k, j, nb_out = 0;
+	int shift = order * r;
+	uint64_t *h, *t;
+	int n;
+
+	h = calloc(order * (ratio - 1) + 1, sizeof(*h));
+	t = calloc(order * (ratio - 1) + 1, sizeof(*t));
+	h[0] = 1;
+	for (n = 0; n < order; n++) {
+		memset(t, 0, (len + ratio - 1) * sizeof(*t));
+		for (k = 0; k < len; k++)
+			for (j = 0; j < ratio; j++)
+				t[k + j] += h[k];
+		len += ratio - 1;
+		memcpy(h, t, len * sizeof(*h));
+	}
+
+	for (k = order - 1; (k + 1) * ratio <= nb; k++) {
+		uint32_t last = (k + 1) * ratio - 1;
+		uint64_t acc = 0;
+
+		for (j = 0; j < len && j <= last; j++)
+			acc += h[j] * x[last - j];
+		out[nb_out++] = shift ? (acc + (1ull << (shift - 1))) >> shift : acc;
+	}
+
+	free(h);
+	free(t);
+	return nb_out;
+}
+
+/* Decimator over a whole buffer, in blocks of block samples */
+static uint32_t decimate(adc_decim_t *d, const uint16_t *in, uint32_t nb, uint32_t block,
+			 uint16_t *out)
+{
+	uint32_t i, nb_out = 0;
+
+	for (i = 0; i < nb; i += block)
+		nb_out += adc_decim_process(d, &in[i], MIN(block, nb - i), &out[nb_out]);
+	return nb_out;
+}
+
+static void usage(const char* my_name)
+{
+	fprintf(stderr,
+		"Version: " ADC_SCAN_BENCH_VERSION "\n"
+		"\n"
+		"Usage: %s [-n samples] [-N order] [-r ratio_log2] [-b block] [-m oversampling]\n"
+		"          [-g gain_error] [-o offset] [-d] [-w noise] [-s seed]\n"
+		"\n"
+		"  Compares the per-sample correction of the GP ADC driver, adc_correct_sample()\n"
+		"  (adc_531.c, built for the host) followed by decimation, with the block pass\n"
+		"  of adc_decim.c that decimates the raw samples and corrects each output once.\n"
+		"  The decimator is first checked against a direct form of the CIC filter and\n"
+		"  against a run in one block. The cycles are host cycles; the target has no\n"
+		"  hardware divider, so the two divisions of every adc_correct_sample() call\n"
+		"  weigh more there.\n"
+		"\n"
+		"  -n samples         raw samples (default 1048576)\n"
+		"  -N order           CIC filter order, 1 to %d (default 1)\n"
+		"  -r ratio_log2      decimation ratio 2^r, order * r <= %d (default 4)\n"
+		"  -b block           samples per block pass, i.e. DMA burst (default 64)\n"
+		"  -m oversampling    hardware oversampling mode 0 to 7 (default 6)\n"
+		"  -g gain_error      OTP gain error (default 350)\n"
+		"  -o offset          OTP offset (default -120)\n"
+		"  -d                 differential mode (default single ended)\n"
+		"  -w noise           input noise, LSB rms (default 200)\n"
+		"  -s seed            random seed\n",
+		my_name, ADC_DECIM_ORDER_MAX, ADC_DECIM_GAIN_BITS_MAX);
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t nb = 1 << 20, block = 64, i, nb_ref, nb_a, nb_b, nb_c, hist[3] = { 0 };
+	uint32_t span, compared = 0, *clamped;
+	int order = 1, r = 4, os = 6, ge = 350, off = -120, opt, shift, fail = 0, max_err = 0;
+	bool diff = false;
+	double noise = 200, t_a, t_b, sum_err = 0;
+	uint64_t c_a, c_b;
+	uint16_t *raw, *corr, *ref, *out_a, *out_b, *out_c;
+	adc_decim_t da, db, dc, dr;
+	adc_config_t cfg = {
+		.input_mode = ADC_INPUT_MODE_SINGLE_ENDED,
+		.input = ADC_INPUT_SE_P0_6,
+		.smpl_time_mult = 2,
+		.input_attenuator = ADC_INPUT_ATTN_4X,
+		.chopping = true,
+	};
+
+	while ((opt = getopt(argc, argv, "n:N:r:b:m:g:o:dw:s:")) != -1) {
+		switch (opt) {
+		case 'n':
+			nb = strtoul(optarg, NULL, 0);
+			break;
+		case 'N':
+			order = atoi(optarg);
+			break;
+		case 'r':
+			r = atoi(optarg);
+			break;
+		case 'b':
+			block = strtoul(optarg, NULL, 0);
+			break;
+		case 'm':
+			os = atoi(optarg);
+			break;
+		case 'g':
+			ge = atoi(optarg);
+			break;
+		case 'o':
+			off = atoi(optarg);
+			break;
+		case 'd':
+			diff = true;
+			break;
+		case 'w':
+			noise = atof(optarg);
+			break;
+		case 's':
+			seed = strtoul(optarg, NULL, 0) | 1;
+			break;
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	if (nb < 1 || order < 1 || order > ADC_DECIM_ORDER_MAX || r < 0 ||
+	    order * r > ADC_DECIM_GAIN_BITS_MAX || block < 1 || block > 0xFFFF || os < 0 ||
+	    os > 7 || ge <= -UINT16_MAX / 2 || ge > INT16_MAX || off < INT16_MIN ||
+	    off > INT16_MAX || noise < 0) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	/* The driver reads the OTP values and the register settings */
+	if (diff) {
+		otp_cs.trim_values.gp_adc_diff_ge = ge;
+		otp_cs.trim_values.gp_adc_diff_offset = off;
+		cfg.input_mode = ADC_INPUT_MODE_DIFFERENTIAL;
+		cfg.input = ADC_INPUT_SE_P0_6 | (ADC_INPUT_DIFF_P0_7 << 4);
+	} else {
+		otp_cs.trim_values.gp_adc_single_ge = ge;
+		otp_cs.trim_values.gp_adc_single_offset = off;
+	}
+	cfg.oversampling = os;
+	adc_init(&cfg);
+	shift = 6 - MIN(6, os);
+
+	raw = malloc(nb * sizeof(*raw));
+	corr = malloc(nb * sizeof(*corr));
+	ref = malloc(nb * sizeof(*ref));
+	out_a = malloc(nb * sizeof(*out_a));
+	out_b = malloc(nb * sizeof(*out_b));
+	out_c = malloc(nb * sizeof(*out_c));
+	clamped = malloc((nb + 1) * sizeof(*clamped));
+	if (!raw || !corr || !ref || !out_a || !out_b || !out_c || !clamped) {
+		fprintf(stderr, "out of memory\n");
+		return EXIT_FAILURE;
+	}
+	synth(raw, nb, noise);
+
+	printf("%u samples, CIC order %d, ratio %u, block %u, oversampling %d, %s,\n"
+	       "gain error %d, offset %d\n\n", nb, order, 1u << r, block, os,
+	       diff ? "differential" : "single ended", ge, off);
+
+	/* Decimator against the direct form, no correction */
+	adc_decim_init(&dr, order, r);
+	nb_ref = cic_direct(raw, nb, order, r, ref);
+	nb_c = decimate(&dr, raw, nb, block, out_c);
+	if (nb_c != nb_ref || memcmp(ref, out_c, nb_ref * sizeof(*ref))) {
+		for (i = 0; i < MIN(nb_c, nb_ref) && ref[i] == out_c[i]; i++)
+			;
+		printf("CIC check          FAILED, %u/%u outputs, first mismatch at %u\n",
+		       nb_c, nb_ref, i);
+		fail = 1;
+	} else {
+		printf("CIC check          %u outputs equal to the direct form\n", nb_ref);
+	}
+
+	/* Per-sample path: adc_correct_sample() on every sample, then decimation */
+	adc_decim_init(&da, order, r);
+	t_a = seconds();
+	c_a = cycles();
+	for (i = 0, nb_a = 0; i < nb; i += block) {
+		uint32_t n = MIN(block, nb - i), j;
+
+		for (j = 0; j < n; j++)
+			corr[i + j] = adc_correct_sample(raw[i + j]);
+		nb_a += adc_decim_process(&da, &corr[i], n, &out_a[nb_a]);
+	}
+	c_a = cycles() - c_a;
+	t_a = seconds() - t_a;
+
+	/* Block pass: decimation of the raw samples, one correction per output */
+	adc_decim_init(&db, order, r);
+	adc_decim_set_correction(&db, ge, off);
+	t_b = seconds();
+	c_b = cycles();
+	nb_b = decimate(&db, raw, nb, block, out_b);
+	c_b = cycles() - c_b;
+	t_b = seconds() - t_b;
+
+	/* The same in as few calls as possible: the block boundaries must not matter */
+	adc_decim_init(&dc, order, r);
+	adc_decim_set_correction(&dc, ge, off);
+	nb_c = decimate(&dc, raw, nb, CHUNK, out_c);
+	if (nb_c != nb_b || memcmp(out_b, out_c, nb_b * sizeof(*out_b))) {
+		printf("block split check  FAILED\n");
+		fail = 1;
+	} else {
+		printf("block split check  %u outputs equal in blocks of %u and %u\n",
+		       nb_b, block, CHUNK);
+	}
+
+	if (nb_a != nb_b) {
+		printf("output count       FAILED, %u per-sample, %u block\n", nb_a, nb_b);
+		return EXIT_FAILURE;
+	}
+
+	/* Samples clamped by adc_correct_sample(), up to every index */
+	clamped[0] = 0;
+	for (i = 0; i < nb; i++)
+		clamped[i + 1] = clamped[i] + (corr[i] == 0 || corr[i] == (UINT16_MAX >> shift));
+
+	/*
+	 * Both in the scale of adc_correct_sample(), leaving out the outputs of filter
+	 * spans holding a clamped sample: the average of clamped samples is not the
+	 * clamped average.
+	 */
+	span = order * ((1u << r) - 1) + 1;
+	for (i = 0; i < nb_a; i++) {
+		uint32_t last = (i + order) * (1u << r) - 1;
+		uint32_t first = last + 1 > span ? last + 1 - span : 0;
+		int e = (int)(out_b[i] >> shift) - out_a[i];
+
+		if (clamped[last + 1] != clamped[first])
+			continue;
+		compared++;
+
+		if (abs(e) > max_err)
+			max_err = abs(e);
+		if (e >= -1 && e <= 1)
+			hist[e + 1]++;
+		sum_err += e;
+	}
+
+	printf("\n%-18s %8.2f cycles/sample %8.1f Msample/s\n", "per-sample path",
+	       (double)c_a / nb, nb / t_a * 1e-6);
+	printf("%-18s %8.2f cycles/sample %8.1f Msample/s  x%.1f\n", "block pass",
+	       (double)c_b / nb, nb / t_b * 1e-6, t_a / t_b);
+	printf("\nblock - per-sample %u outputs (%u near the rails left out)\n", compared,
+	       nb_a - compared);
+	if (compared)
+		printf("  max %d LSB, mean %+.3f LSB, -1: %.1f%% 0: %.1f%% +1: %.1f%%\n", max_err,
+		       sum_err / compared, 100.0 * hist[0] / compared, 100.0 * hist[1] / compared,
+		       100.0 * hist[2] / compared);
+
+	if (max_err > 2)
+		fail = 1;
+
+	free(raw);
+	free(corr);
+	free(ref);
+	free(out_a);
+	free(out_b);
+	free(out_c);
+	free(clamped);
+
+	return fail ? EXIT_FAILURE : EXIT_SUCCESS;
+}
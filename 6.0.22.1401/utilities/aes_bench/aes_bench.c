@@ -0,0 +1,558 @@
+/**
+ ****************************************************************************************
+ *
+ * @file aes_bench.c
+ *
+ * @brief AES-CBC/CMAC/CCM test vectors and benchmark.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sw_aes.h"
+#include "aes_cbc.h"
+#include "aes_cmac.h"
+#include "aes_ccm.h"
+
+#define AES_BENCH_VERSION	"v_1.0"
+
+#define BLK			16
+
+/* NIST SP 800-38A / SP 800-38B example key and data */
+static const uint8_t nist_key[BLK] = {
+	0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c,
+};
+
+static const uint8_t nist_iv[BLK] = {
+	0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+};
+
+static const uint8_t nist_msg[4 * BLK] = {
+	0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+	0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c, 0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+	0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11, 0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef,
+	0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17, 0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10,
+};
+
+/* SP 800-38A F.2.1 CBC-AES128.Encrypt */
+static const uint8_t nist_cbc[4 * BLK] = {
+	0x76, 0x49, 0xab, 0xac, 0x81, 0x19, 0xb2, 0x46, 0xce, 0xe9, 0x8e, 0x9b, 0x12, 0xe9, 0x19, 0x7d,
+	0x50, 0x86, 0xcb, 0x9b, 0x50, 0x72, 0x19, 0xee, 0x95, 0xdb, 0x11, 0x3a, 0x91, 0x76, 0x78, 0xb2,
+	0x73, 0xbe, 0xd6, 0xb8, 0xe3, 0xc1, 0x74, 0x3b, 0x71, 0x16, 0xe6, 0x9e, 0x22, 0x22, 0x95, 0x16,
+	0x3f, 0xf1, 0xca, 0xa1, 0x68, 0x1f, 0xac, 0x09, 0x12, 0x0e, 0xca, 0x30, 0x75, 0x86, 0xe1, 0xa7,
+};
+
+/* SP 800-38B D.1 / RFC 4493 AES-CMAC examples */
+static const struct {
+	uint16_t len;
+	uint8_t mac[BLK];
+} nist_cmac[] = {
+	{ 0,  { 0xbb, 0x1d, 0x69, 0x29, 0xe9, 0x59, 0x37, 0x28, 0x7f, 0xa3, 0x7d, 0x12, 0x9b, 0x75, 0x67, 0x46 } },
+	{ 16, { 0x07, 0x0a, 0x16, 0xb4, 0x6b, 0x4d, 0x41, 0x44, 0xf7, 0x9b, 0xdd, 0x9d, 0xd0, 0x4a, 0x28, 0x7c } },
+	{ 40, { 0xdf, 0xa6, 0x67, 0x47, 0xde, 0x9a, 0xe6, 0x30, 0x30, 0xca, 0x32, 0x61, 0x14, 0x97, 0xc8, 0x27 } },
+	{ 64, { 0x51, 0xf0, 0xbe, 0xbf, 0x7e, 0x3b, 0x9d, 0x92, 0xfc, 0x49, 0x74, 0x17, 0x79, 0x36, 0x3c, 0xfe } },
+};
+
+/* SP 800-38C Appendix C examples: key 40..4f, nonce 10.., A 00.., P 20.. */
+static const struct {
+	uint8_t t, n;
+	uint32_t alen;
+	uint8_t plen;
+	uint8_t c[48];
+} nist_ccm[] = {
+	{ 4, 7, 8, 4, {
+		0x71, 0x62, 0x01, 0x5b, 0x4d, 0xac, 0x25, 0x5d } },
+	{ 6, 8, 16, 16, {
+		0xd2, 0xa1, 0xf0, 0xe0, 0x51, 0xea, 0x5f, 0x62, 0x08, 0x1a, 0x77, 0x92, 0x07, 0x3d, 0x59, 0x3d,
+		0x1f, 0xc6, 0x4f, 0xbf, 0xac, 0xcd } },
+	{ 8, 12, 20, 24, {
+		0xe3, 0xb2, 0x01, 0xa9, 0xf5, 0xb7, 0x1a, 0x7a, 0x9b, 0x1c, 0xea, 0xec, 0xcd, 0x97, 0xe7, 0x0b,
+		0x61, 0x76, 0xaa, 0xd9, 0xa4, 0x42, 0x8a, 0xa5, 0x48, 0x43, 0x92, 0xfb, 0xc1, 0xb0, 0x99, 0x51 } },
+	{ 14, 13, 65536, 32, {
+		0x69, 0x91, 0x5d, 0xad, 0x1e, 0x84, 0xc6, 0x37, 0x6a, 0x68, 0xc2, 0x96, 0x7e, 0x4d, 0xab, 0x61,
+		0x5a, 0xe0, 0xfd, 0x1f, 0xae, 0xc4, 0x4c, 0xc4, 0x84, 0x82, 0x85, 0x29, 0x46, 0x3c, 0xcf, 0x72,
+		0xb4, 0xac, 0x6b, 0xec, 0x93, 0xe8, 0x59, 0x8e, 0x7f, 0x0d, 0xad, 0xbc, 0xea, 0x5b } },
+};
+
+static uint8_t ccm_key[BLK], ccm_nonce[13], ccm_adata[65536], ccm_payload[32];
+
+static unsigned int bench_size = 4096;
+static unsigned int bench_loops = 2000;
+
+static void usage(const char* my_name)
+{
+	fprintf(stderr,
+		"Version: " AES_BENCH_VERSION "\n"
+		"\n"
+		"Usage: %s [-s size] [-n loops]\n"
+		"\n"
+		"  Checks the AES-CBC, AES-CMAC and AES-CCM implementation of the SDK\n"
+		"  against the NIST SP 800-38A/B/C examples, then compares the time per\n"
+		"  byte of CMAC generation and CBC decryption with the key expanded once\n"
+		"  per message and with the key expanded for every block, and of CCM\n"
+		"  encryption streamed and through heap blocks. The software AES is used\n"
+		"  in all cases.\n"
+		"\n"
+		"  -s size      message size in bytes, multiple of 16 (default 4096)\n"
+		"  -n loops     messages per measurement (default 2000)\n",
+		my_name);
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint64_t now_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __builtin_ia32_rdtsc();
+#else
+	return 0;
+#endif
+}
+
+static int check(const char *name, const uint8_t *got, const uint8_t *exp, unsigned int len)
+{
+	int ok = !memcmp(got, exp, len);
+
+	printf("  %-36s %s\n", name, ok ? "ok" : "FAILED");
+	return ok ? 0 : 1;
+}
+
+static int ccm_streamed(unsigned int v, unsigned int chunk, uint8_t process, uint8_t *buf)
+{
+	struct aes_ccm_ctx ctx;
+	unsigned int pos, n;
+	uint8_t tag[16];
+	int err = 0;
+
+	err |= aes_ccm_start(&ctx, ccm_key, nist_ccm[v].t, nist_ccm[v].n, ccm_nonce,
+			     nist_ccm[v].alen, nist_ccm[v].plen, process);
+	for (pos = 0; pos < nist_ccm[v].alen; pos += n) {
+		n = nist_ccm[v].alen - pos < chunk ? nist_ccm[v].alen - pos : chunk;
+		err |= aes_ccm_update_adata(&ctx, &ccm_adata[pos], n);
+	}
+	/* In place */
+	for (pos = 0; pos < nist_ccm[v].plen; pos += n) {
+		n = nist_ccm[v].plen - pos < chunk ? nist_ccm[v].plen - pos : chunk;
+		err |= aes_ccm_update(&ctx, &buf[pos], &buf[pos], n);
+	}
+	if (process == ENCRYPT_PROCESS) {
+		err |= aes_ccm_finish(&ctx, tag);
+		memcpy(&buf[nist_ccm[v].plen], tag, nist_ccm[v].t);
+	} else {
+		err |= aes_ccm_check_tag(&ctx, &buf[nist_ccm[v].plen]);
+	}
+
+	return err;
+}
+
+static int run_ccm_vectors(void)
+{
+	uint8_t buf[48];
+	char name[40];
+	unsigned int v, i, chunk, len;
+	int errors = 0;
+
+	for (i = 0; i < sizeof(ccm_key); i++)
+		ccm_key[i] = 0x40 + i;
+	for (i = 0; i < sizeof(ccm_nonce); i++)
+		ccm_nonce[i] = 0x10 + i;
+	for (i = 0; i < sizeof(ccm_adata); i++)
+		ccm_adata[i] = i;
+	for (i = 0; i < sizeof(ccm_payload); i++)
+		ccm_payload[i] = 0x20 + i;
+
+	for (v = 0; v < sizeof(nist_ccm) / sizeof(nist_ccm[0]); v++) {
+		len = nist_ccm[v].plen + nist_ccm[v].t;
+
+		if (nist_ccm[v].alen <= 0xFFFF) {
+			aes_ccm_init(ccm_key, nist_ccm[v].t, nist_ccm[v].n, 0);
+
+			aes_ccm_encrypt(ccm_payload, nist_ccm[v].plen, ccm_nonce, ccm_adata,
+					nist_ccm[v].alen, buf);
+			snprintf(name, sizeof(name), "CCM example %u encrypt", v + 1);
+			errors += check(name, buf, nist_ccm[v].c, len);
+
+			snprintf(name, sizeof(name), "CCM example %u decrypt", v + 1);
+			if (aes_ccm_decrypt(buf, len, ccm_nonce, ccm_adata, nist_ccm[v].alen, buf))
+				memset(buf, 0xFF, nist_ccm[v].plen);
+			errors += check(name, buf, ccm_payload, nist_ccm[v].plen);
+
+			memcpy(buf, nist_ccm[v].c, len);
+			buf[len - 1] ^= 1;
+			snprintf(name, sizeof(name), "CCM example %u wrong tag", v + 1);
+			if (!aes_ccm_decrypt(buf, len, ccm_nonce, ccm_adata, nist_ccm[v].alen, buf))
+				buf[0] ^= 0xFF;
+			errors += check(name, buf, (const uint8_t [32]) {0}, nist_ccm[v].plen);
+		}
+
+		/* Odd sized chunks, so that blocks are split across calls */
+		for (chunk = 1; chunk <= 17; chunk += 4) {
+			memcpy(buf, ccm_payload, nist_ccm[v].plen);
+			snprintf(name, sizeof(name), "CCM example %u, %u byte chunks", v + 1, chunk);
+			if (ccm_streamed(v, chunk, ENCRYPT_PROCESS, buf) ||
+			    memcmp(buf, nist_ccm[v].c, len) ||
+			    ccm_streamed(v, chunk, DECRYPT_PROCESS, buf) ||
+			    memcmp(buf, ccm_payload, nist_ccm[v].plen)) {
+				printf("  %-36s FAILED\n", name);
+				errors++;
+			}
+		}
+	}
+	printf("  %-36s %s\n", "CCM streamed, in place", errors ? "see above" : "ok");
+
+	return errors;
+}
+
+static int run_vectors(void)
+{
+	struct aes_cbc_ctx cbc;
+	struct aes_cmac_ctx cmac;
+	uint8_t buf[4 * BLK], mac[BLK];
+	char name[40];
+	unsigned int i, pos, chunk;
+	int errors = 0;
+
+	printf("NIST vectors:\n");
+
+	aes_cbc_encrypt(nist_msg, 4, buf, 4, nist_key, BLK, nist_iv);
+	errors += check("CBC encrypt", buf, nist_cbc, sizeof(nist_cbc));
+
+	aes_cbc_decrypt(nist_cbc, buf, 4, nist_key, BLK, nist_iv);
+	errors += check("CBC decrypt", buf, nist_msg, sizeof(nist_msg));
+
+	/* One block per call, in place */
+	memcpy(buf, nist_cbc, sizeof(buf));
+	aes_cbc_init(&cbc, nist_key, BLK, nist_iv, AES_DECRYPT);
+	for (i = 0; i < 4; i++)
+		aes_cbc_update(&cbc, &buf[i * BLK], &buf[i * BLK], 1);
+	errors += check("CBC decrypt, streamed, in place", buf, nist_msg, sizeof(nist_msg));
+
+	memcpy(buf, nist_msg, sizeof(buf));
+	aes_cbc_init(&cbc, nist_key, BLK, nist_iv, AES_ENCRYPT);
+	aes_cbc_update(&cbc, buf, buf, 1);
+	aes_cbc_update(&cbc, &buf[BLK], &buf[BLK], 3);
+	errors += check("CBC encrypt, streamed, in place", buf, nist_cbc, sizeof(nist_cbc));
+
+	for (i = 0; i < sizeof(nist_cmac) / sizeof(nist_cmac[0]); i++) {
+		aes_cmac_generate(nist_msg, nist_cmac[i].len, nist_key, mac, BLK);
+		snprintf(name, sizeof(name), "CMAC, %u bytes", nist_cmac[i].len);
+		errors += check(name, mac, nist_cmac[i].mac, BLK);
+
+		/* Odd sized chunks, so that blocks are split across calls */
+		for (chunk = 1; chunk <= 17; chunk += 4) {
+			aes_cmac_init(&cmac, nist_key);
+			for (pos = 0; pos < nist_cmac[i].len; pos += chunk)
+				aes_cmac_update(&cmac, &nist_msg[pos],
+						nist_cmac[i].len - pos < chunk ? nist_cmac[i].len - pos : chunk);
+			aes_cmac_final(&cmac, mac, BLK);
+			snprintf(name, sizeof(name), "CMAC, %u bytes, %u byte chunks", nist_cmac[i].len, chunk);
+			errors += check(name, mac, nist_cmac[i].mac, BLK);
+		}
+	}
+
+	if (!aes_cmac_verify(nist_msg, 40, nist_key, nist_cmac[2].mac, 8) ||
+	    aes_cmac_verify(nist_msg, 40, nist_key, nist_cmac[1].mac, 8)) {
+		printf("  %-36s FAILED\n", "CMAC verify");
+		errors++;
+	} else {
+		printf("  %-36s ok\n", "CMAC verify");
+	}
+
+	return errors + run_ccm_vectors();
+}
+
+/*
+ * The block routines used before the engine context: aes_set_key() expands the key
+ * and aes_enc_dec() copies the block reversed to and from the exchange memory, for
+ * every block.
+ */
+static void legacy_block(const uint8_t *key, const uint8_t *in, uint8_t *out, int enc_dec)
+{
+	static const uint8_t zero_iv[BLK];
+	AES_CTX ctx;
+	uint8_t em[BLK];
+	uint32_t data[4];
+	int j;
+
+	AES_set_key(&ctx, key, zero_iv, AES_MODE_128);
+	if (enc_dec == AES_DECRYPT)
+		AES_convert_key(&ctx);
+
+	for (j = 0; j < BLK; j++)
+		em[BLK - 1 - j] = in[j];
+	for (j = 0; j < 4; j++)
+		data[j] = (uint32_t)em[15 - 4 * j] << 24 | (uint32_t)em[14 - 4 * j] << 16 |
+			  (uint32_t)em[13 - 4 * j] << 8 | em[12 - 4 * j];
+
+	if (enc_dec == AES_DECRYPT)
+		AES_decrypt(&ctx, data);
+	else
+		AES_encrypt(&ctx, data);
+
+	for (j = 0; j < 4; j++) {
+		em[15 - 4 * j] = data[j] >> 24;
+		em[14 - 4 * j] = data[j] >> 16;
+		em[13 - 4 * j] = data[j] >> 8;
+		em[12 - 4 * j] = data[j];
+	}
+	for (j = 0; j < BLK; j++)
+		out[j] = em[BLK - 1 - j];
+}
+
+/* CBC-MAC part of the former aes_cmac_generate(): one aes_cbc_encrypt() block at a time */
+static void legacy_cbc_mac(const uint8_t *msg, unsigned int len, uint8_t *mac)
+{
+	uint8_t x[BLK];
+	unsigned int i;
+
+	memset(mac, 0, BLK);
+	for (i = 0; i < len; i += BLK) {
+		aes_array_xor(&msg[i], mac, BLK, x);
+		legacy_block(nist_key, x, mac, AES_ENCRYPT);
+	}
+}
+
+static void legacy_cbc_decrypt(const uint8_t *in, unsigned int len, uint8_t *out)
+{
+	const uint8_t *chain = nist_iv;
+	unsigned int i;
+
+	for (i = 0; i < len; i += BLK) {
+		legacy_block(nist_key, &in[i], &out[i], AES_DECRYPT);
+		aes_array_xor(&out[i], chain, BLK, &out[i]);
+		chain = &in[i];
+	}
+}
+
+static void report(const char *name, uint64_t ns, uint64_t cycles, uint64_t bytes, double *cpb)
+{
+	*cpb = cycles ? (double)cycles / bytes : (double)ns / bytes;
+	printf("  %-36s %8.2f ns/byte", name, (double)ns / bytes);
+	if (cycles)
+		printf("  %8.2f cycles/byte", *cpb);
+	printf("\n");
+}
+
+/*
+ * The former aes_ccm_encrypt(): B0, the formatted associated data and the payload are
+ * copied in heap blocks (kept between calls, reallocated when a packet needs more),
+ * then CBC-MAC and CTR run one aes_cbc_encrypt() block at a time.
+ */
+static uint8_t (*legacy_adata)[BLK], (*legacy_b)[BLK], (*legacy_x)[BLK], (*legacy_a)[BLK], (*legacy_s)[BLK];
+static unsigned int legacy_adata_cnt, legacy_cnt, legacy_heap;
+
+static void *legacy_blk_malloc(void *p, unsigned int old_cnt, unsigned int new_cnt)
+{
+	if (p == NULL || old_cnt < new_cnt) {
+		free(p);
+		p = malloc(new_cnt * BLK);
+	}
+	memset(p, 0, new_cnt * BLK);
+	return p;
+}
+
+static void legacy_ccm_encrypt(const uint8_t *key, uint8_t t, uint8_t n, const uint8_t *nonce,
+			       const uint8_t *adata, uint16_t alen, const uint8_t *payload,
+			       uint16_t plen, uint8_t *out)
+{
+	unsigned int a_cnt = (alen + 2 + BLK - 1) / BLK, p_cnt = (plen + BLK - 1) / BLK;
+	unsigned int cnt = 1 + a_cnt + p_cnt, i, q = 15 - n;
+	uint8_t x[BLK];
+
+	legacy_adata = legacy_blk_malloc(legacy_adata, legacy_adata_cnt, a_cnt);
+	legacy_adata_cnt = a_cnt;
+	legacy_adata[0][0] = alen >> 8;
+	legacy_adata[0][1] = alen;
+	memcpy(&legacy_adata[0][2], adata, alen);
+
+	legacy_b = legacy_blk_malloc(legacy_b, legacy_cnt, cnt);
+	legacy_x = legacy_blk_malloc(legacy_x, legacy_cnt, cnt);
+	legacy_a = legacy_blk_malloc(legacy_a, legacy_cnt, cnt);
+	legacy_s = legacy_blk_malloc(legacy_s, legacy_cnt, cnt);
+	legacy_cnt = cnt;
+	if (legacy_heap < (a_cnt + 4 * cnt) * BLK)
+		legacy_heap = (a_cnt + 4 * cnt) * BLK;
+
+	legacy_b[0][0] = 0x40 | ((t - 2) / 2) << 3 | (q - 1);
+	memcpy(&legacy_b[0][1], nonce, n);
+	legacy_b[0][14] = plen >> 8;
+	legacy_b[0][15] = plen;
+	memcpy(legacy_b[1], legacy_adata, alen + 2);
+	memcpy(legacy_b[1 + a_cnt], payload, plen);
+
+	memset(x, 0, BLK);
+	for (i = 0; i < cnt; i++) {
+		aes_array_xor(legacy_b[i], x, BLK, x);
+		legacy_block(key, x, legacy_x[i], AES_ENCRYPT);
+		memcpy(x, legacy_x[i], BLK);
+	}
+
+	for (i = 0; i < cnt; i++) {
+		legacy_a[i][0] = q - 1;
+		memcpy(&legacy_a[i][1], nonce, n);
+		legacy_a[i][14] = i >> 8;
+		legacy_a[i][15] = i;
+		legacy_block(key, legacy_a[i], legacy_s[i], AES_ENCRYPT);
+	}
+
+	aes_array_xor(legacy_x[cnt - 1], legacy_s[0], t, out + plen);
+	aes_array_xor(legacy_b[1 + a_cnt], legacy_s[1], plen, out);
+}
+
+static void run_ccm_bench(void)
+{
+	static const uint16_t sizes[] = { 16, 64, 256, 1024, 4080 };
+	static uint8_t payload[4080], out[4080 + 16], ref[4080 + 16];
+	struct aes_ccm_ctx ctx;
+	unsigned int i, s, loops;
+	uint64_t t, c, bytes;
+	double legacy_cpb, engine_cpb;
+	char name[40];
+
+	for (i = 0; i < sizeof(payload); i++)
+		payload[i] = i * 131 + 7;
+
+	printf("\nCCM encryption, 8 byte header, 8 byte tag, 13 byte nonce:\n");
+	for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+		loops = (uint64_t)bench_loops * bench_size / sizes[s];
+		bytes = (uint64_t)loops * sizes[s];
+		legacy_heap = 0;
+
+		t = now_ns(); c = now_cycles();
+		for (i = 0; i < loops; i++)
+			legacy_ccm_encrypt(ccm_key, 8, 13, ccm_nonce, ccm_adata, 8, payload, sizes[s], ref);
+		snprintf(name, sizeof(name), "%4u bytes, heap blocks", sizes[s]);
+		report(name, now_ns() - t, now_cycles() - c, bytes, &legacy_cpb);
+
+		t = now_ns(); c = now_cycles();
+		for (i = 0; i < loops; i++) {
+			aes_ccm_start(&ctx, ccm_key, 8, 13, ccm_nonce, 8, sizes[s], ENCRYPT_PROCESS);
+			aes_ccm_update_adata(&ctx, ccm_adata, 8);
+			aes_ccm_update(&ctx, payload, out, sizes[s]);
+			aes_ccm_finish(&ctx, out + sizes[s]);
+		}
+		snprintf(name, sizeof(name), "%4u bytes, streamed", sizes[s]);
+		report(name, now_ns() - t, now_cycles() - c, bytes, &engine_cpb);
+
+		printf("  %-36s %8.2fx, heap %u -> 0 bytes (context %u bytes)%s\n", "speedup",
+		       legacy_cpb / engine_cpb, legacy_heap, (unsigned int)sizeof(ctx),
+		       memcmp(out, ref, sizes[s] + 8) ? ", OUTPUT MISMATCH" : "");
+	}
+}
+
+static void run_bench(void)
+{
+	struct aes_cbc_ctx cbc;
+	uint8_t *msg, *out, mac[BLK];
+	uint64_t bytes = (uint64_t)bench_size * bench_loops;
+	uint64_t t, c;
+	double legacy_cpb, engine_cpb;
+	unsigned int i;
+
+	msg = malloc(bench_size);
+	out = malloc(bench_size);
+	if (msg == NULL || out == NULL)
+		exit(EXIT_FAILURE);
+	for (i = 0; i < bench_size; i++)
+		msg[i] = i * 131 + 7;
+
+	printf("\n%u byte messages, %u messages:\n", bench_size, bench_loops);
+
+	t = now_ns(); c = now_cycles();
+	for (i = 0; i < bench_loops; i++)
+		legacy_cbc_mac(msg, bench_size, mac);
+	report("CMAC, key expanded per block", now_ns() - t, now_cycles() - c, bytes, &legacy_cpb);
+
+	t = now_ns(); c = now_cycles();
+	for (i = 0; i < bench_loops; i++)
+		aes_cmac_generate(msg, bench_size, nist_key, mac, BLK);
+	report("CMAC, key expanded once", now_ns() - t, now_cycles() - c, bytes, &engine_cpb);
+	printf("  %-36s %8.2fx\n", "speedup", legacy_cpb / engine_cpb);
+
+	t = now_ns(); c = now_cycles();
+	for (i = 0; i < bench_loops; i++)
+		legacy_cbc_decrypt(msg, bench_size, out);
+	report("CBC decrypt, key expanded per block", now_ns() - t, now_cycles() - c, bytes, &legacy_cpb);
+
+	t = now_ns(); c = now_cycles();
+	for (i = 0; i < bench_loops; i++) {
+		aes_cbc_init(&cbc, nist_key, BLK, nist_iv, AES_DECRYPT);
+		aes_cbc_update(&cbc, msg, out, bench_size / BLK);
+	}
+	report("CBC decrypt, key expanded once", now_ns() - t, now_cycles() - c, bytes, &engine_cpb);
+	printf("  %-36s %8.2fx\n", "speedup", legacy_cpb / engine_cpb);
+
+	free(msg);
+	free(out);
+
+	run_ccm_bench();
+}
+
+int main(int argc, char **argv)
+{
+	int opt;
+
+	while ((opt = getopt(argc, argv, "s:n:")) != -1) {
+		switch (opt) {
+		case 's':
+			bench_size = strtoul(optarg, NULL, 0);
+			break;
+		case 'n':
+			bench_loops = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	if (optind != argc || bench_size == 0 || bench_size % BLK || bench_size > 0xFFF0 ||
+	    bench_loops == 0) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if (run_vectors()) {
+		printf("\nFAILED\n");
+		return EXIT_FAILURE;
+	}
+
+	run_bench();
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,570 @@
+/**
+ ****************************************************************************************
+ *
+ * @file app_dispatch_bench.c
+ *
+ * @brief Application message dispatch checks and trace replay benchmark.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "app_api.h"
+#include "user_callback_config.h"
+#include "app_task.h"
+#include "app_easy_timer.h"
+#include "app_easy_msg_utils.h"
+#include "app_security_task.h"
+#include "app_diss_task.h"
+#include "app_bass_task.h"
+#include "app_suotar_task.h"
+#include "app_customs_task.h"
+
+#define APP_DISPATCH_BENCH_VERSION	"v_1.0"
+
+#define ARRAY_LEN(a)		(sizeof(a) / sizeof(a[0]))
+
+/* The dispatcher of REF_REV: app_entry_point.c of that revision, its symbols renamed */
+int ref_app_entry_point_handler(ke_msg_id_t const msgid, void const *param,
+				ke_task_id_t const dest_id, ke_task_id_t const src_id);
+enum process_event_response ref_app_std_process_event(ke_msg_id_t const msgid, void const *param,
+						      ke_task_id_t const src_id, ke_task_id_t const dest_id,
+						      enum ke_msg_status_tag *msg_ret,
+						      const struct ke_msg_handler *handlers,
+						      const int handler_num);
+
+/* Message Ids of the benchmark profiles: distinct and in the range of their task */
+enum {
+	GATTC_SVC_CHANGED_CFG_IND = KE_FIRST_MSG(TASK_ID_GATTC) + 0x1D,
+	GATTC_MTU_CHANGED_IND = KE_FIRST_MSG(TASK_ID_GATTC) + 0x0A,
+
+	GAPM_CMP_EVT = KE_FIRST_MSG(TASK_ID_GAPM),
+	GAPM_DEVICE_READY_IND,
+	GAPM_PROFILE_ADDED_IND = KE_FIRST_MSG(TASK_ID_GAPM) + 0x0C,
+	GAPM_ADV_REPORT_IND = KE_FIRST_MSG(TASK_ID_GAPM) + 0x11,
+	GAPM_ADDR_SOLVED_IND = KE_FIRST_MSG(TASK_ID_GAPM) + 0x15,
+	GAPM_RAL_SIZE_IND = KE_FIRST_MSG(TASK_ID_GAPM) + 0x1E,
+	GAPM_RAL_ADDR_IND,
+
+	GAPC_CMP_EVT = KE_FIRST_MSG(TASK_ID_GAPC),
+	GAPC_CONNECTION_REQ_IND,
+	GAPC_DISCONNECT_IND = KE_FIRST_MSG(TASK_ID_GAPC) + 0x04,
+	GAPC_PEER_FEATURES_IND = KE_FIRST_MSG(TASK_ID_GAPC) + 0x0B,
+	GAPC_GET_DEV_INFO_REQ_IND = KE_FIRST_MSG(TASK_ID_GAPC) + 0x13,
+	GAPC_SET_DEV_INFO_REQ_IND = KE_FIRST_MSG(TASK_ID_GAPC) + 0x15,
+	GAPC_PARAM_UPDATE_REQ_IND = KE_FIRST_MSG(TASK_ID_GAPC) + 0x18,
+	GAPC_PARAM_UPDATED_IND = KE_FIRST_MSG(TASK_ID_GAPC) + 0x1A,
+	GAPC_BOND_REQ_IND = KE_FIRST_MSG(TASK_ID_GAPC) + 0x1C,
+	GAPC_BOND_IND = KE_FIRST_MSG(TASK_ID_GAPC) + 0x1E,
+	GAPC_ENCRYPT_REQ_IND = KE_FIRST_MSG(TASK_ID_GAPC) + 0x20,
+	GAPC_ENCRYPT_IND = KE_FIRST_MSG(TASK_ID_GAPC) + 0x22,
+	GAPC_SECURITY_IND = KE_FIRST_MSG(TASK_ID_GAPC) + 0x24,
+	GAPC_LE_PKT_SIZE_IND = KE_FIRST_MSG(TASK_ID_GAPC) + 0x2A,
+
+	DISS_VALUE_REQ_IND = KE_FIRST_MSG(TASK_ID_DISS) + 0x04,
+
+	BASS_ENABLE_RSP = KE_FIRST_MSG(TASK_ID_BASS) + 0x01,
+	BASS_BATT_LEVEL_UPD_RSP = KE_FIRST_MSG(TASK_ID_BASS) + 0x03,
+	BASS_BATT_LEVEL_NTF_CFG_IND,
+
+	SUOTAR_PATCH_MEM_DEV_IND = KE_FIRST_MSG(TASK_ID_SUOTAR) + 0x03,
+	SUOTAR_GPIO_MAP_IND,
+	SUOTAR_PATCH_LEN_IND,
+	SUOTAR_PATCH_DATA_IND,
+
+	CUSTS1_VAL_WRITE_IND = KE_FIRST_MSG(TASK_ID_CUSTS1) + 0x0A,
+	CUSTS1_VAL_NTF_CFM = KE_FIRST_MSG(TASK_ID_CUSTS1) + 0x07,
+	CUSTS1_ATT_INFO_REQ = KE_FIRST_MSG(TASK_ID_CUSTS1) + 0x0D,
+};
+
+/* Receivers a message can be routed to: the process handlers, then the catch rest callback */
+enum {
+	RX_GAP,
+	RX_TIMER,
+	RX_MSG,
+	RX_SEC,
+	RX_DISS,
+	RX_BASS,
+	RX_SUOTAR,
+	RX_CUSTS1,
+	RX_CATCH_REST,
+	RX_NUM
+};
+
+static const char * const rx_names[RX_NUM] = {
+	"gap", "timer", "msg_utils", "sec", "diss", "bass", "suotar", "custs1", "catch_rest"
+};
+
+/* The receiver of the last dispatched message and the calls it took */
+static int routed;
+static int current;
+static uint64_t process_calls;
+static uint64_t table_entries;
+
+static int msg_handler(ke_msg_id_t const msgid, void const *param,
+		       ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+	routed = current;
+	return KE_MSG_CONSUMED;
+}
+
+static int save_handler(ke_msg_id_t const msgid, void const *param,
+			ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+	routed = current;
+	return KE_MSG_SAVED;
+}
+
+void user_catch_rest_hndl(ke_msg_id_t const msgid, void const *param,
+			  ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+	routed = RX_CATCH_REST;
+}
+
+/* The message handler tables of the SDK process handlers */
+static const struct ke_msg_handler gap_handlers[] = {
+	{GAPM_DEVICE_READY_IND, msg_handler},
+	{GAPM_CMP_EVT, msg_handler},
+	{GAPC_CMP_EVT, msg_handler},
+	{GAPC_CONNECTION_REQ_IND, msg_handler},
+	{GAPC_DISCONNECT_IND, msg_handler},
+	{GAPC_GET_DEV_INFO_REQ_IND, msg_handler},
+	{GAPC_SET_DEV_INFO_REQ_IND, msg_handler},
+	{GAPM_PROFILE_ADDED_IND, msg_handler},
+	{GAPM_ADV_REPORT_IND, msg_handler},
+	{GAPC_PARAM_UPDATE_REQ_IND, msg_handler},
+	{GAPC_LE_PKT_SIZE_IND, msg_handler},
+	{GATTC_SVC_CHANGED_CFG_IND, msg_handler},
+	{GAPC_PEER_FEATURES_IND, msg_handler},
+	{GAPC_SECURITY_IND, msg_handler},
+};
+
+static const struct ke_msg_handler sec_handlers[] = {
+	{GAPC_BOND_REQ_IND, msg_handler},
+	{GAPC_BOND_IND, msg_handler},
+	{GAPC_ENCRYPT_REQ_IND, msg_handler},
+	{GAPC_ENCRYPT_IND, msg_handler},
+	{GAPM_ADDR_SOLVED_IND, msg_handler},
+	{GAPM_RAL_SIZE_IND, msg_handler},
+	{GAPM_RAL_ADDR_IND, msg_handler},
+};
+
+static const struct ke_msg_handler diss_handlers[] = {
+	{DISS_VALUE_REQ_IND, msg_handler},
+};
+
+static const struct ke_msg_handler bass_handlers[] = {
+	{BASS_ENABLE_RSP, msg_handler},
+	{BASS_BATT_LEVEL_UPD_RSP, msg_handler},
+	{BASS_BATT_LEVEL_NTF_CFG_IND, msg_handler},
+	{APP_BASS_TIMER, msg_handler},
+	{APP_BASS_ALERT_TIMER, msg_handler},
+};
+
+static const struct ke_msg_handler suotar_handlers[] = {
+	{SUOTAR_PATCH_MEM_DEV_IND, msg_handler},
+	{SUOTAR_GPIO_MAP_IND, msg_handler},
+	{SUOTAR_PATCH_LEN_IND, save_handler},
+	{SUOTAR_PATCH_DATA_IND, msg_handler},
+};
+
+/* The app_std_process_event() of the dispatcher under test */
+static enum process_event_response (*std_process_event)(ke_msg_id_t const msgid, void const *param,
+							ke_task_id_t const src_id, ke_task_id_t const dest_id,
+							enum ke_msg_status_tag *msg_ret,
+							const struct ke_msg_handler *handlers,
+							const int handler_num);
+
+/* Counts the process handler call and the table entries its handler_search() compares */
+static enum process_event_response table_process(int rx, ke_msg_id_t const msgid, void const *param,
+						 ke_task_id_t const dest_id, ke_task_id_t const src_id,
+						 enum ke_msg_status_tag *msg_ret,
+						 const struct ke_msg_handler *handlers, int handler_num)
+{
+	int i;
+
+	if (msg_ret != NULL) {
+		process_calls++;
+		for (i = handler_num - 1; i >= 0 && handlers[i].id != msgid; i--)
+			;
+		table_entries += handler_num - (i < 0 ? 0 : i);
+	}
+	current = rx;
+
+	return std_process_event(msgid, param, src_id, dest_id, msg_ret, handlers, handler_num);
+}
+
+#define TABLE_PROCESS_HANDLER(name, rx, table)							\
+enum process_event_response name(ke_msg_id_t const msgid, void const *param,			\
+				 ke_task_id_t const dest_id, ke_task_id_t const src_id,		\
+				 enum ke_msg_status_tag *msg_ret)				\
+{												\
+	return table_process(rx, msgid, param, dest_id, src_id, msg_ret, table, ARRAY_LEN(table)); \
+}
+
+TABLE_PROCESS_HANDLER(app_gap_process_handler, RX_GAP, gap_handlers)
+TABLE_PROCESS_HANDLER(app_sec_process_handler, RX_SEC, sec_handlers)
+TABLE_PROCESS_HANDLER(app_diss_process_handler, RX_DISS, diss_handlers)
+TABLE_PROCESS_HANDLER(app_bass_process_handler, RX_BASS, bass_handlers)
+TABLE_PROCESS_HANDLER(app_suotar_process_handler, RX_SUOTAR, suotar_handlers)
+
+/* As app_custs1_process_handler() of the SDK: no table, the user handles the messages */
+enum process_event_response app_custs1_process_handler(ke_msg_id_t const msgid, void const *param,
+						       ke_task_id_t const dest_id, ke_task_id_t const src_id,
+						       enum ke_msg_status_tag *msg_ret)
+{
+	return table_process(RX_CUSTS1, msgid, param, dest_id, src_id, msg_ret, NULL, 0);
+}
+
+/* As the range checks of app_timer_api_process_handler() and app_msg_utils_api_process_handler() */
+enum process_event_response app_timer_api_process_handler(ke_msg_id_t const msgid, void const *param,
+							  ke_task_id_t const dest_id, ke_task_id_t const src_id,
+							  enum ke_msg_status_tag *msg_ret)
+{
+	if (msg_ret != NULL)
+		process_calls++;
+	if (msgid < APP_CREATE_TIMER || msgid > APP_TIMER_API_LAST_MES)
+		return PR_EVENT_UNHANDLED;
+	routed = RX_TIMER;
+	*msg_ret = KE_MSG_CONSUMED;
+	return PR_EVENT_HANDLED;
+}
+
+enum process_event_response app_msg_utils_api_process_handler(ke_msg_id_t const msgid, void const *param,
+							      ke_task_id_t const dest_id, ke_task_id_t const src_id,
+							      enum ke_msg_status_tag *msg_ret)
+{
+	if (msg_ret != NULL)
+		process_calls++;
+	if (msgid < APP_MSG_UTIL_API_MES0 || msgid > APP_MSG_UTIL_API_LAST_MES)
+		return PR_EVENT_UNHANDLED;
+	routed = RX_MSG;
+	*msg_ret = KE_MSG_CONSUMED;
+	return PR_EVENT_HANDLED;
+}
+
+/* Message mix of a connected peripheral with a custom service, battery service and SUOTA */
+static const struct {
+	ke_msg_id_t id;
+	unsigned int weight;
+} mix[] = {
+	{CUSTS1_VAL_WRITE_IND, 200},
+	{CUSTS1_VAL_NTF_CFM, 200},
+	{CUSTS1_ATT_INFO_REQ, 10},
+	{APP_TIMER_API_MES0, 120},
+	{APP_TIMER_API_MES0 + 1, 40},
+	{APP_CREATE_TIMER, 30},
+	{APP_CANCEL_TIMER, 20},
+	{APP_MSG_UTIL_API_MES0, 40},
+	{SUOTAR_PATCH_DATA_IND, 120},
+	{SUOTAR_PATCH_LEN_IND, 2},
+	{BASS_BATT_LEVEL_UPD_RSP, 40},
+	{APP_BASS_TIMER, 40},
+	{GAPC_PARAM_UPDATED_IND, 10},
+	{GATTC_MTU_CHANGED_IND, 5},
+	{GAPC_CMP_EVT, 30},
+	{GAPM_CMP_EVT, 20},
+	{GAPC_LE_PKT_SIZE_IND, 5},
+	{GAPC_PARAM_UPDATE_REQ_IND, 5},
+	{GAPC_CONNECTION_REQ_IND, 5},
+	{GAPC_DISCONNECT_IND, 5},
+	{GAPC_ENCRYPT_IND, 5},
+	{GAPC_ENCRYPT_REQ_IND, 5},
+	{GAPC_BOND_IND, 2},
+	{DISS_VALUE_REQ_IND, 10},
+	{APP_MODULE_INIT_CMP_EVT, 1},
+};
+
+static unsigned int trace_len = 100000;
+static unsigned int repeat = 20;
+static ke_msg_id_t *trace;
+static uint32_t seed = 1;
+static int errors;
+
+static void usage(const char* my_name)
+{
+	fprintf(stderr,
+		"Version: " APP_DISPATCH_BENCH_VERSION "\n"
+		"\n"
+		"Usage: %s [-n messages] [-r repeat] [-S seed] [-f trace_file]\n"
+		"\n"
+		"  Replays a trace of application message Ids through app_entry_point_handler()\n"
+		"  of this tree, which looks up the process handler in the index built by\n"
+		"  app_entry_point_init(), and through the one of the reference revision (see\n"
+		"  'make bench'), which tries the process handlers in turn. Checks that both\n"
+		"  route every message to the same process handler or to the catch rest\n"
+		"  callback with the same status, then reports per message the process\n"
+		"  handler calls, the message table entries compared and the host time.\n"
+		"\n"
+		"  The process handlers are those of an application with GAP, timers, message\n"
+		"  utilities, security, DISS, BASS, SUOTAR and a custom profile, with the\n"
+		"  message tables of the SDK. The synthetic trace is a mix of the messages of\n"
+		"  a connected peripheral; most custom profile messages go to catch rest.\n"
+		"\n"
+		"  -n messages   messages of the synthetic trace (default 100000)\n"
+		"  -r repeat     replays of the trace for the host time (default 20)\n"
+		"  -S seed       seed of the synthetic trace (default 1)\n"
+		"  -f trace_file replay the message Ids of trace_file instead, one per\n"
+		"                line in C notation (e.g. 0xFD0A)\n",
+		my_name);
+}
+
+static uint32_t rnd(void)
+{
+	seed = seed * 1103515245 + 12345;
+	return seed >> 1;
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void expect(bool ok, const char *what)
+{
+	if (!ok) {
+		fprintf(stderr, "FAILED: %s\n", what);
+		errors++;
+	}
+}
+
+static void make_trace(void)
+{
+	unsigned int total = 0;
+
+	for (unsigned int i = 0; i < ARRAY_LEN(mix); i++)
+		total += mix[i].weight;
+
+	for (unsigned int n = 0; n < trace_len; n++) {
+		unsigned int r = rnd() % total;
+		unsigned int i = 0;
+
+		while (r >= mix[i].weight)
+			r -= mix[i++].weight;
+		trace[n] = mix[i].id;
+	}
+}
+
+static int read_trace(const char *filename)
+{
+	long id;
+	FILE *f;
+
+	f = fopen(filename, "r");
+	if (f == NULL) {
+		fprintf(stderr, "cannot open %s\n", filename);
+		return -1;
+	}
+	for (trace_len = 0; trace_len < UINT16_MAX * 16 && fscanf(f, "%li", &id) == 1; trace_len++) {
+		trace = realloc(trace, (trace_len + 1) * sizeof(*trace));
+		if (trace == NULL) {
+			fclose(f);
+			return -1;
+		}
+		trace[trace_len] = (ke_msg_id_t) id;
+	}
+	fclose(f);
+	if (trace_len == 0) {
+		fprintf(stderr, "no message Ids in %s\n", filename);
+		return -1;
+	}
+
+	return 0;
+}
+
+/* Dispatch every message of the trace with both dispatchers */
+static void check_trace(void)
+{
+	unsigned int mismatches = 0;
+	uint64_t per_rx[RX_NUM] = { 0 };
+
+	for (unsigned int n = 0; n < trace_len; n++) {
+		int ref_rx, new_rx, ref_ret, new_ret;
+
+		routed = -1;
+		std_process_event = ref_app_std_process_event;
+		ref_ret = ref_app_entry_point_handler(trace[n], NULL, TASK_APP, TASK_APP);
+		ref_rx = routed;
+
+		routed = -1;
+		std_process_event = app_std_process_event;
+		new_ret = app_entry_point_handler(trace[n], NULL, TASK_APP, TASK_APP);
+		new_rx = routed;
+
+		if (new_rx != ref_rx || new_ret != ref_ret || new_rx < 0) {
+			if (mismatches++ < 10)
+				fprintf(stderr, "message 0x%04X: reference %s/%d, new %s/%d\n", trace[n],
+					ref_rx < 0 ? "none" : rx_names[ref_rx], ref_ret,
+					new_rx < 0 ? "none" : rx_names[new_rx], new_ret);
+		} else {
+			per_rx[new_rx]++;
+		}
+	}
+	expect(mismatches == 0, "same routing of the trace by both dispatchers");
+
+	printf("Routing of %u messages:", trace_len);
+	for (int i = 0; i < RX_NUM; i++)
+		if (per_rx[i])
+			printf(" %s %.1f%%", rx_names[i], 100.0 * per_rx[i] / trace_len);
+	printf("\n");
+}
+
+/* Every message Id of the process handlers and a window around them */
+static void check_all_ids(void)
+{
+	unsigned int mismatches = 0;
+
+	for (uint32_t id = 0; id < 0x10000; id++) {
+		int ref_rx, ref_ret, new_ret;
+
+		if (id == KE_MSG_DEFAULT_HANDLER)
+			continue;
+
+		routed = -1;
+		std_process_event = ref_app_std_process_event;
+		ref_ret = ref_app_entry_point_handler(id, NULL, TASK_APP, TASK_APP);
+		ref_rx = routed;
+
+		std_process_event = app_std_process_event;
+		routed = -1;
+		new_ret = app_entry_point_handler(id, NULL, TASK_APP, TASK_APP);
+
+		if (routed != ref_rx || new_ret != ref_ret)
+			mismatches++;
+	}
+	expect(mismatches == 0, "same routing of all message Ids by both dispatchers");
+	printf("Checks: routing of all 65535 message Ids by both dispatchers\n");
+}
+
+struct result {
+	double calls;
+	double entries;
+	double ns;
+};
+
+static void measure(bool ref, struct result *r)
+{
+	int (*dispatch)(ke_msg_id_t const msgid, void const *param,
+			ke_task_id_t const dest_id, ke_task_id_t const src_id);
+	uint64_t start, best = UINT64_MAX;
+
+	std_process_event = ref ? ref_app_std_process_event : app_std_process_event;
+	dispatch = ref ? ref_app_entry_point_handler : app_entry_point_handler;
+
+	process_calls = 0;
+	table_entries = 0;
+	for (unsigned int n = 0; n < trace_len; n++)
+		dispatch(trace[n], NULL, TASK_APP, TASK_APP);
+	r->calls = (double) process_calls / trace_len;
+	r->entries = (double) table_entries / trace_len;
+
+	for (unsigned int i = 0; i < repeat; i++) {
+		start = now_ns();
+		for (unsigned int n = 0; n < trace_len; n++)
+			dispatch(trace[n], NULL, TASK_APP, TASK_APP);
+		start = now_ns() - start;
+		if (start < best)
+			best = start;
+	}
+	r->ns = (double) best / trace_len;
+}
+
+int main(int argc, char **argv)
+{
+	const char *in_file = NULL;
+	struct result ref, res;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:r:S:f:")) != -1) {
+		switch (opt) {
+		case 'n':
+			trace_len = strtoul(optarg, NULL, 0);
+			break;
+		case 'r':
+			repeat = strtoul(optarg, NULL, 0);
+			break;
+		case 'S':
+			seed = strtoul(optarg, NULL, 0);
+			break;
+		case 'f':
+			in_file = optarg;
+			break;
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	if (optind != argc || trace_len == 0 || repeat == 0) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	/* app_entry_point_init() probes the process handlers through app_std_process_event() */
+	std_process_event = app_std_process_event;
+	app_entry_point_init();
+
+	if (in_file) {
+		if (read_trace(in_file) != 0)
+			return EXIT_FAILURE;
+	} else {
+		trace = malloc(trace_len * sizeof(*trace));
+		if (trace == NULL)
+			return EXIT_FAILURE;
+		make_trace();
+	}
+
+	check_all_ids();
+	check_trace();
+
+	measure(true, &ref);
+	measure(false, &res);
+	printf("\n%-10s %18s %18s %12s\n", "dispatcher", "process calls/msg", "table entries/msg", "host ns/msg");
+	printf("%-10s %18.2f %18.2f %12.1f\n", "reference", ref.calls, ref.entries, ref.ns);
+	printf("%-10s %18.2f %18.2f %12.1f\n", "index", res.calls, res.entries, res.ns);
+	printf("%-10s %17.1f%% %17.1f%% %11.1f%%\n", "change",
+	       100.0 * (res.calls - ref.calls) / ref.calls,
+	       100.0 * (res.entries - ref.entries) / ref.entries,
+	       100.0 * (res.ns - ref.ns) / ref.ns);
+
+	free(trace);
+
+	if (errors) {
+		printf("\nFAILED, %d errors\n", errors);
+		return EXIT_FAILURE;
+	}
+	printf("\nOK\n");
+
+	return EXIT_SUCCESS;
+}
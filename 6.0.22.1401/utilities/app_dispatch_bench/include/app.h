@@ -0,0 +1,62 @@
+/**
+ ****************************************************************************************
+ *
+ * @file app.h
+ *
+ * @brief Application messages of the dispatch benchmark.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _APP_H_
+#define _APP_H_
+
+#include "ke_task.h"
+
+/* As in sdk/app_modules/api/app.h, for the profiles of the benchmark */
+enum APP_MSG
+{
+	APP_MODULE_INIT_CMP_EVT = KE_FIRST_MSG(TASK_ID_APP),
+
+	APP_CREATE_TIMER,
+	APP_CANCEL_TIMER,
+	APP_MODIFY_TIMER,
+
+	APP_TIMER_API_MES0,
+	APP_TIMER_API_LAST_MES = APP_TIMER_API_MES0 + 9,
+
+	APP_MSG_UTIL_API_MES0,
+	APP_MSG_UTIL_API_LAST_MES = APP_MSG_UTIL_API_MES0 + 4,
+
+	APP_BASS_TIMER,
+	APP_BASS_ALERT_TIMER,
+
+#if defined (CFG_APP_EASY_TIMER_WHEEL)
+	APP_TIMER_WHEEL_MES,
+#endif
+};
+
+#endif /* _APP_H_ */
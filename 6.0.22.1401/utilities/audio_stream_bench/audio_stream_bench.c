@@ -0,0 +1,674 @@
+/**
+ ****************************************************************************************
+ *
+ * @file audio_stream_bench.c
+ *
+ * @brief Host harness of the audio stream pipeline: WAV input, DMA, main loop and BLE
+ * link models, decoder and latency measurement.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+#define _DEFAULT_SOURCE
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC
+#endif
+
+#include "arch.h"
+#include "ima_adpcm.h"
+#include "audio_stream.h"
+
+#define AUDIO_STREAM_BENCH_VERSION	"v_1.0"
+
+#define INF			1e30
+#define CTRL_MAX		16		/* controller TX buffers */
+#define SYNTH_SECONDS		10
+
+#define MIN(a, b)		((a) < (b) ? (a) : (b))
+
+static uint32_t seed = 1;
+
+/* Input */
+static int16_t *pcm;
+static uint32_t pcm_len;
+static uint32_t rate = 16000;
+
+/* First source sample of every DMA buffer handed to the encoder, in order */
+static uint32_t *stream_map;
+static uint32_t stream_blocks;
+
+/* BLE link model */
+static struct {
+	double interval_ms;
+	int per_event;			/* packets per connection event */
+	int buffers;			/* controller TX buffers */
+	double loss;			/* probability of a packet not being acknowledged */
+	double outage_ms;		/* no packet goes through from outage_ms ... */
+	double outage_len_ms;		/* ... for outage_len_ms */
+} ble = { 7.5, 4, 4, 0, 0, 0 };
+
+static struct {
+	uint8_t data[AUDIO_STREAM_PAYLOAD_MAX];
+	uint16_t len;
+} ctrl[CTRL_MAX];
+static int ctrl_head, ctrl_count;
+
+/* Main loop model: the CPU is busy with other work busy_len_ms every busy_ms */
+static double busy_ms, busy_len_ms;
+
+static double now;			/* s */
+
+/* Receiver */
+static uint16_t payload_len;
+static int16_t *rx_pcm;
+static uint8_t *rx_got;
+static uint32_t rx_pkts, rx_gaps, rx_last_idx;
+static int rx_last_seq = -1;
+static double *lat_old, *lat_new;	/* ms, oldest and newest sample of every packet */
+static uint32_t lat_nb, lat_size;
+static int errors;
+
+static uint32_t rnd(void)
+{
+	/* xorshift32 */
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	return seed;
+}
+
+static double rnd_uniform(void)
+{
+	return ((rnd() >> 8) + 0.5) / (double)(1 << 24);
+}
+
+static uint64_t cycles(void)
+{
+#ifdef HAVE_TSC
+	return __rdtsc();
+#else
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+#endif
+}
+
+static double seconds(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+ ****************************************************************************************
+ * WAV files
+ ****************************************************************************************
+ */
+
+static uint32_t le32(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t le16(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+static int wav_read(const char *name)
+{
+	uint8_t hdr[12], chunk[8], fmt[16];
+	uint16_t channels = 0, bits = 0, format = 0;
+	FILE *f = fopen(name, "rb");
+	uint32_t i, len;
+
+	if (!f) {
+		perror(name);
+		return -1;
+	}
+	if (fread(hdr, 1, 12, f) != 12 || memcmp(hdr, "RIFF", 4) || memcmp(hdr + 8, "WAVE", 4))
+		goto bad;
+
+	while (fread(chunk, 1, 8, f) == 8) {
+		len = le32(chunk + 4);
+		if (!memcmp(chunk, "fmt ", 4)) {
+			if (len < 16 || fread(fmt, 1, 16, f) != 16)
+				goto bad;
+			format = le16(fmt);
+			channels = le16(fmt + 2);
+			rate = le32(fmt + 4);
+			bits = le16(fmt + 14);
+			fseek(f, (len - 16 + 1) & ~1u, SEEK_CUR);
+		} else if (!memcmp(chunk, "data", 4)) {
+			uint8_t *raw;
+
+			/* PCM or WAVE_FORMAT_EXTENSIBLE, 16 bits, the first channel only */
+			if ((format != 1 && format != 0xFFFE) || bits != 16 || !channels || !rate)
+				goto bad;
+			raw = malloc(len);
+			if (!raw)
+				goto bad;
+			len = fread(raw, 1, len, f);
+			pcm_len = len / (2 * channels);
+			pcm = malloc(pcm_len * sizeof(*pcm) + 1);
+			for (i = 0; i < pcm_len; i++)
+				pcm[i] = (int16_t)le16(raw + 2 * channels * i);
+			free(raw);
+			fclose(f);
+			return 0;
+		} else {
+			fseek(f, (len + 1) & ~1u, SEEK_CUR);
+		}
+	}
+bad:
+	fprintf(stderr, "%s: not a 16 bit PCM WAV file\n", name);
+	fclose(f);
+	return -1;
+}
+
+static void put32(FILE *f, uint32_t v)
+{
+	uint8_t b[4] = { v, v >> 8, v >> 16, v >> 24 };
+
+	fwrite(b, 1, 4, f);
+}
+
+static void put16(FILE *f, uint16_t v)
+{
+	uint8_t b[2] = { v, v >> 8 };
+
+	fwrite(b, 1, 2, f);
+}
+
+static int wav_write(const char *name, const int16_t *data, uint32_t nb)
+{
+	FILE *f = fopen(name, "wb");
+	uint32_t i;
+
+	if (!f) {
+		perror(name);
+		return -1;
+	}
+	fwrite("RIFF", 1, 4, f);
+	put32(f, 36 + 2 * nb);
+	fwrite("WAVEfmt ", 1, 8, f);
+	put32(f, 16);
+	put16(f, 1);
+	put16(f, 1);
+	put32(f, rate);
+	put32(f, 2 * rate);
+	put16(f, 2);
+	put16(f, 16);
+	fwrite("data", 1, 4, f);
+	put32(f, 2 * nb);
+	for (i = 0; i < nb; i++)
+		put16(f, data[i]);
+	fclose(f);
+	return 0;
+}
+
+/*
+ * Voice like test signal: voiced segments with a gliding pitch and decaying harmonics,
+ * separated by low level noise
+ */
+static void synth(void)
+{
+	double phase = 0, f0 = 140;
+	uint32_t i, seg = 0, seg_len = 0;
+	bool voiced = false;
+	int k;
+
+	pcm_len = SYNTH_SECONDS * rate;
+	pcm = malloc(pcm_len * sizeof(*pcm));
+	for (i = 0; i < pcm_len; i++) {
+		double s = 0, env;
+
+		if (seg == seg_len) {
+			voiced = !voiced;
+			seg = 0;
+			seg_len = rate * (voiced ? 0.25 + 0.3 * rnd_uniform() : 0.05 + 0.15 * rnd_uniform());
+			f0 = 100 + 120 * rnd_uniform();
+		}
+		if (voiced) {
+			env = sin(M_PI * seg / seg_len);
+			phase += 2 * M_PI * (f0 * (1 + 0.1 * sin(M_PI * seg / seg_len))) / rate;
+			/* Glottal source slope and three formants */
+			for (k = 1; k * f0 < rate / 2 && k <= 40; k++)
+				s += sin(k * phase) / (k * k) * (1 + 8 * exp(-fabs(k * f0 - 500) / 150) +
+								 4 * exp(-fabs(k * f0 - 1500) / 200) +
+								 2 * exp(-fabs(k * f0 - 2500) / 250));
+			s *= 2500 * env;
+		}
+		s += 60 * (rnd_uniform() - 0.5);
+		pcm[i] = (int16_t)(s > 32767 ? 32767 : s < -32768 ? -32768 : s);
+		seg++;
+	}
+}
+
+/*
+ ****************************************************************************************
+ * Receiver
+ ****************************************************************************************
+ */
+
+static uint32_t src_index(uint32_t k)
+{
+	return stream_map[k / AUDIO_STREAM_DMA_LEN] + k % AUDIO_STREAM_DMA_LEN;
+}
+
+static void receive(const uint8_t *data, uint16_t len)
+{
+	uint32_t pkt_samples = AUDIO_STREAM_PKT_SAMPLES(payload_len);
+	uint32_t idx, expect, pos, nb, i;
+	ima_adpcm_state_t state;
+
+	expect = (rx_last_seq < 0) ? 0 : rx_last_idx + 1;
+	idx = (rx_last_seq < 0) ? data[0] : rx_last_idx + ((data[0] - rx_last_seq) & 0xFF);
+	rx_gaps += idx - expect;
+	rx_last_seq = data[0];
+	rx_last_idx = idx;
+	rx_pkts++;
+
+	pos = idx * pkt_samples;
+	nb = AUDIO_STREAM_PKT_SAMPLES(len);
+	if (len < AUDIO_STREAM_HDR_LEN || pos + nb > stream_blocks * AUDIO_STREAM_DMA_LEN) {
+		fprintf(stderr, "Packet %u of %u bytes out of the stream\n", idx, len);
+		errors++;
+		return;
+	}
+
+	state.predictor = (int16_t)le16(data + 1);
+	state.index = data[3];
+	ima_adpcm_decode(&state, data + AUDIO_STREAM_HDR_LEN, &rx_pcm[pos], nb);
+	for (i = 0; i < nb; i++)
+		rx_got[pos + i] = 1;
+
+	/* A sample is captured at the end of its period */
+	if (lat_nb == lat_size) {
+		lat_size = lat_size ? 2 * lat_size : 1024;
+		lat_old = realloc(lat_old, lat_size * sizeof(double));
+		lat_new = realloc(lat_new, lat_size * sizeof(double));
+	}
+	lat_old[lat_nb] = 1000 * (now - (src_index(pos) + 1.0) / rate);
+	lat_new[lat_nb] = 1000 * (now - (src_index(pos + nb - 1) + 1.0) / rate);
+	lat_nb++;
+}
+
+/*
+ ****************************************************************************************
+ * BLE link
+ ****************************************************************************************
+ */
+
+static bool send_cb(const uint8_t *data, uint16_t len)
+{
+	int i = (ctrl_head + ctrl_count) % CTRL_MAX;
+
+	if (ctrl_count == ble.buffers)
+		return false;
+
+	memcpy(ctrl[i].data, data, len);
+	ctrl[i].len = len;
+	ctrl_count++;
+	return true;
+}
+
+/* Returns true if a buffer has been freed */
+static bool connection_event(void)
+{
+	double t_ms = 1000 * now;
+	bool freed = false;
+	int n;
+
+	if (ble.outage_len_ms && t_ms >= ble.outage_ms && t_ms < ble.outage_ms + ble.outage_len_ms)
+		return false;
+
+	for (n = 0; n < ble.per_event && ctrl_count; n++) {
+		/* A packet not acknowledged closes the event, it is sent again at the next one */
+		if (rnd_uniform() < ble.loss)
+			break;
+		receive(ctrl[ctrl_head].data, ctrl[ctrl_head].len);
+		ctrl_head = (ctrl_head + 1) % CTRL_MAX;
+		ctrl_count--;
+		freed = true;
+	}
+	return freed;
+}
+
+/*
+ ****************************************************************************************
+ * Main
+ ****************************************************************************************
+ */
+
+static int cmp_double(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+
+	return (x > y) - (x < y);
+}
+
+static void print_latency(const char *name, double *v, uint32_t nb)
+{
+	double sum = 0;
+	uint32_t i;
+
+	if (!nb)
+		return;
+	qsort(v, nb, sizeof(*v), cmp_double);
+	for (i = 0; i < nb; i++)
+		sum += v[i];
+	printf("  %-15s mean %6.1f  p50 %6.1f  p99 %6.1f  max %6.1f ms\n", name, sum / nb,
+	       v[nb / 2], v[(uint32_t)(0.99 * (nb - 1))], v[nb - 1]);
+}
+
+/* Cycles of the encoder alone per packet, on the host */
+static void bench_encoder(uint32_t pkt_samples)
+{
+	uint32_t nb = pcm_len - pcm_len % pkt_samples;
+	uint32_t *words = malloc(nb * sizeof(uint32_t));
+	uint8_t out[AUDIO_STREAM_PAYLOAD_MAX];
+	uint64_t c0, c = 0;
+	double t0, t = 0;
+	uint32_t i, pkts = 0;
+
+	for (i = 0; i < nb; i++)
+		words[i] = (uint32_t)pcm[i] << 16;
+
+	do {
+		ima_adpcm_state_t state = { 0, 0 };
+
+		t0 = seconds();
+		c0 = cycles();
+		for (i = 0; i < nb; i += pkt_samples) {
+			ima_adpcm_encode_src(&state, &words[i], out, pkt_samples);
+			/* Keep the result alive */
+			words[i] ^= out[0] & 0;
+		}
+		c += cycles() - c0;
+		t += seconds() - t0;
+		pkts += nb / pkt_samples;
+	} while (t < 0.2 && nb);
+
+	if (pkts)
+		printf("  %-15s %8.0f per packet  %6.2f per sample  %8.0f ns per packet\n",
+		       "encoder", (double)c / pkts, (double)c / pkts / pkt_samples, 1e9 * t / pkts);
+	free(words);
+}
+
+static void usage(const char* my_name)
+{
+	fprintf(stderr,
+		"Version: " AUDIO_STREAM_BENCH_VERSION "\n"
+		"\n"
+		"Usage: %s [-w in.wav] [-o out.wav] [-m mtu] [-i interval_ms] [-n packets]\n"
+		"          [-b buffers] [-l loss] [-O start_ms,len_ms] [-B period_ms,len_ms] [-s seed]\n"
+		"\n"
+		"  Pushes a WAV file, or a synthetic voice signal, through the audio stream\n"
+		"  pipeline (audio_stream.c, ima_adpcm.c): the samples fill the DMA buffers\n"
+		"  in real time, the main loop encodes them into packets and the packets are\n"
+		"  notified over a BLE link model. The receiver decodes every packet on its\n"
+		"  own, checks the result against a reference decoder and measures the\n"
+		"  latency from the capture of the oldest and newest sample of a packet to\n"
+		"  its reception. The cycles are host cycles.\n"
+		"\n"
+		"  -w in.wav          16 bit PCM input, first channel (default %d s synthetic)\n"
+		"  -o out.wav         decoded output, missing samples as silence\n"
+		"  -m mtu             ATT MTU, payload mtu - 3 up to %d (default 247)\n"
+		"  BLE link:\n"
+		"  -i interval_ms     connection interval (default 7.5)\n"
+		"  -n packets         packets per connection event (default 4)\n"
+		"  -b buffers         controller TX buffers, up to %d (default 4)\n"
+		"  -l loss            probability of a packet not being acknowledged (default 0)\n"
+		"  -O start_ms,len_ms link outage (default none)\n"
+		"  Main loop:\n"
+		"  -B period_ms,len_ms CPU busy with other work len_ms every period_ms (default none)\n",
+		my_name, SYNTH_SECONDS, AUDIO_STREAM_PAYLOAD_MAX, CTRL_MAX);
+}
+
+int main(int argc, char **argv)
+{
+	const char *in_name = NULL, *out_name = NULL;
+	const audio_stream_stats_t *stats;
+	uint32_t *buf, blocks, b = 0, i, stream_len, pkt_samples;
+	double t_block, t_conn, block_s, sig = 0, noise = 0;
+	uint64_t proc_cycles = 0;
+	int mtu = 247, opt, mismatch = 0, received = 0;
+	bool pending = false, stopped = false;
+	int16_t *ref;
+	uint8_t *codes;
+	ima_adpcm_state_t state = { 0, 0 };
+
+	while ((opt = getopt(argc, argv, "w:o:m:i:n:b:l:O:B:s:")) != -1) {
+		switch (opt) {
+		case 'w':
+			in_name = optarg;
+			break;
+		case 'o':
+			out_name = optarg;
+			break;
+		case 'm':
+			mtu = atoi(optarg);
+			break;
+		case 'i':
+			ble.interval_ms = atof(optarg);
+			break;
+		case 'n':
+			ble.per_event = atoi(optarg);
+			break;
+		case 'b':
+			ble.buffers = atoi(optarg);
+			break;
+		case 'l':
+			ble.loss = atof(optarg);
+			break;
+		case 'O':
+			if (sscanf(optarg, "%lf,%lf", &ble.outage_ms, &ble.outage_len_ms) != 2)
+				ble.outage_len_ms = -1;
+			break;
+		case 'B':
+			if (sscanf(optarg, "%lf,%lf", &busy_ms, &busy_len_ms) != 2)
+				busy_ms = -1;
+			break;
+		case 's':
+			seed = strtoul(optarg, NULL, 0) | 1;
+			break;
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	if (mtu < 23 || ble.interval_ms < 7.5 || ble.per_event < 1 || ble.buffers < 1 ||
+	    ble.buffers > CTRL_MAX || ble.loss < 0 || ble.loss >= 1 || ble.outage_len_ms < 0 ||
+	    busy_ms < 0 || busy_len_ms < 0 || (busy_ms && busy_len_ms >= busy_ms)) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if (in_name ? wav_read(in_name) : (synth(), 0))
+		return EXIT_FAILURE;
+
+	payload_len = (mtu - 3 < AUDIO_STREAM_PAYLOAD_MAX) ? mtu - 3 : AUDIO_STREAM_PAYLOAD_MAX;
+	pkt_samples = AUDIO_STREAM_PKT_SAMPLES(payload_len);
+	blocks = pcm_len / AUDIO_STREAM_DMA_LEN;
+	stream_map = malloc((blocks + 1) * sizeof(*stream_map));
+	rx_pcm = calloc(blocks + 1, AUDIO_STREAM_DMA_LEN * sizeof(*rx_pcm));
+	rx_got = calloc(blocks + 1, AUDIO_STREAM_DMA_LEN);
+
+	printf("Input %s, %u Hz, %.2f s\n", in_name ? in_name : "synthetic", rate, (double)pcm_len / rate);
+	printf("Packets of %u bytes, %u samples (%.1f ms), queue of %d packets, "
+	       "%d DMA buffers of %d samples (%.1f ms)\n",
+	       payload_len, pkt_samples, 1000.0 * pkt_samples / rate, AUDIO_STREAM_PKTS - 1,
+	       AUDIO_STREAM_DMA_BUFS, AUDIO_STREAM_DMA_LEN, 1000.0 * AUDIO_STREAM_DMA_LEN / rate);
+	printf("Link interval %.2f ms, %d packets per event, %d buffers, loss %.2f",
+	       ble.interval_ms, ble.per_event, ble.buffers, ble.loss);
+	if (ble.outage_len_ms)
+		printf(", outage %.0f ms at %.0f ms", ble.outage_len_ms, ble.outage_ms);
+	if (busy_ms)
+		printf(", CPU busy %.1f ms every %.1f ms", busy_len_ms, busy_ms);
+	printf("\n\n");
+
+	/*
+	 * Event loop: DMA buffer completions, main loop runs and connection events. The
+	 * main loop runs after every interrupt, unless the CPU is busy.
+	 */
+	buf = audio_stream_start(payload_len, send_cb);
+	block_s = (double)AUDIO_STREAM_DMA_LEN / rate;
+	t_block = block_s;
+	t_conn = ble.interval_ms / 2000;
+	for (;;) {
+		double t_proc = INF, t_next;
+
+		if (b == blocks && !stopped) {
+			audio_stream_stop();
+			stopped = true;
+			pending = true;
+		}
+		if (stopped && !pending && !ctrl_count &&
+		    audio_stream_validate_sleep(mode_ext_sleep) == mode_ext_sleep)
+			break;
+
+		if (pending) {
+			double m = busy_ms ? fmod(1000 * now, busy_ms) : INF;
+
+			t_proc = (m < busy_len_ms) ? now + (busy_len_ms - m) / 1000 : now;
+		}
+		t_next = (b < blocks) ? t_block : INF;
+		if (t_proc < t_next)
+			t_next = t_proc;
+		if (t_conn < t_next)
+			t_next = t_conn;
+
+		if (t_next > (double)pcm_len / rate + 60) {
+			fprintf(stderr, "Stalled at %.3f s: %d packets in the controller\n", now, ctrl_count);
+			return EXIT_FAILURE;
+		}
+		now = t_next;
+
+		if (b < blocks && t_block == now) {
+			uint32_t *next;
+
+			for (i = 0; i < AUDIO_STREAM_DMA_LEN; i++)
+				buf[i] = (uint32_t)pcm[b * AUDIO_STREAM_DMA_LEN + i] << 16;
+			next = audio_stream_dma_cb(AUDIO_STREAM_DMA_LEN);
+			if (next != buf)
+				stream_map[stream_blocks++] = b * AUDIO_STREAM_DMA_LEN;
+			buf = next;
+			b++;
+			t_block += block_s;
+			pending = true;
+		} else if (t_proc == now) {
+			uint64_t c0 = cycles();
+
+			pending = audio_stream_process();
+			proc_cycles += cycles() - c0;
+		} else {
+			if (connection_event())
+				pending = true;
+			t_conn += ble.interval_ms / 1000;
+		}
+	}
+
+	stats = audio_stream_stats();
+
+	/* Reference: the stream encoded and decoded at once */
+	stream_len = stream_blocks * AUDIO_STREAM_DMA_LEN;
+	ref = malloc((stream_len + 1) * sizeof(*ref));
+	codes = malloc(stream_len / 2 + 1);
+	for (i = 0; i < stream_len; i++)
+		ref[i] = pcm[src_index(i)];
+	/* In chunks of an even number of samples, the codec takes up to 65535 at once */
+	for (i = 0; i < stream_len; i += 0x8000)
+		ima_adpcm_encode(&state, &ref[i], &codes[i / 2], MIN(stream_len - i, 0x8000));
+	state = (ima_adpcm_state_t){ 0, 0 };
+	for (i = 0; i < stream_len; i += 0x8000)
+		ima_adpcm_decode(&state, &codes[i / 2], &ref[i], MIN(stream_len - i, 0x8000));
+	for (i = 0; i < stream_len; i++) {
+		double e;
+
+		if (!rx_got[i])
+			continue;
+		received++;
+		if (rx_pcm[i] != ref[i])
+			mismatch++;
+		e = rx_pcm[i] - pcm[src_index(i)];
+		sig += (double)pcm[src_index(i)] * pcm[src_index(i)];
+		noise += e * e;
+	}
+
+	printf("Host cycles\n");
+	bench_encoder(pkt_samples);
+	if (stats->pkts_sent + stats->pkts_dropped)
+		printf("  %-15s %8.0f per packet\n", "pipeline",
+		       (double)proc_cycles / (stats->pkts_sent + stats->pkts_dropped));
+	printf("Packets\n");
+	printf("  sent %u, dropped %u, received %u, lost in reception %u\n",
+	       stats->pkts_sent, stats->pkts_dropped, rx_pkts, rx_gaps);
+	printf("  queue max %u, send refused %u\n", stats->queue_max, stats->send_busy);
+	printf("DMA buffers\n");
+	printf("  %u, overruns %u, waiting max %u\n", blocks, stats->dma_overruns, stats->dma_max);
+	printf("Latency from capture to reception\n");
+	print_latency("oldest sample", lat_old, lat_nb);
+	print_latency("newest sample", lat_new, lat_nb);
+	printf("Quality\n");
+	printf("  %.1f%% of the samples received, SNR %.1f dB, %d samples differ from the reference\n",
+	       100.0 * received / (blocks * AUDIO_STREAM_DMA_LEN),
+	       noise ? 10 * log10(sig / noise) : INF, mismatch);
+
+	/* The drops seen by the receiver must be the ones accounted by the pipeline */
+	if (rx_gaps != stats->pkts_dropped || rx_pkts != stats->pkts_sent ||
+	    stats->samples != stream_len || stream_blocks + stats->dma_overruns != blocks) {
+		fprintf(stderr, "Accounting mismatch\n");
+		errors++;
+	}
+	if (mismatch)
+		errors++;
+	free(ref);
+	free(codes);
+
+	if (out_name) {
+		int16_t *out = calloc(pcm_len + 1, sizeof(*out));
+
+		for (i = 0; i < stream_len; i++)
+			if (rx_got[i])
+				out[src_index(i)] = rx_pcm[i];
+		if (wav_write(out_name, out, pcm_len))
+			errors++;
+		free(out);
+	}
+
+	return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
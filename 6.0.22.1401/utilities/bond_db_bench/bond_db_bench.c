@@ -0,0 +1,585 @@
+/**
+ ****************************************************************************************
+ *
+ * @file bond_db_bench.c
+ *
+ * @brief Bond database checks and flash cost benchmark on simulated SPI flash.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "spi_flash.h"
+#include "app_security.h"
+
+#define BOND_DB_BENCH_VERSION	"v_1.0"
+
+/* APP_BOND_DB_MAX_BONDED_PEERS of the SDK */
+#define SLOTS		5
+#define MAX_PEERS	32
+#define FLASH_SIZE	(0x40000)
+
+/* The bond database built twice by the Makefile, its public functions renamed */
+#define BACKEND_API(p) \
+	void p##_bdb_init(void); \
+	void p##_bdb_add_entry(struct app_sec_bond_data_env_tag *data); \
+	void p##_bdb_remove_entry(enum bdb_search_by_type search_type, enum bdb_remove_type remove_type, \
+				  void *search_param, uint8_t search_param_length); \
+	const struct app_sec_bond_data_env_tag *p##_bdb_search_entry(enum bdb_search_by_type search_type, \
+								     void *search_param, \
+								     uint8_t search_param_length); \
+	uint32_t p##_bdb_timestamp_counter(void);
+
+BACKEND_API(flat)
+BACKEND_API(jrnl)
+
+struct backend {
+	const char *name;
+	bool power_safe;
+	void (*init)(void);
+	void (*add_entry)(struct app_sec_bond_data_env_tag *data);
+	void (*remove_entry)(enum bdb_search_by_type search_type, enum bdb_remove_type remove_type,
+			     void *search_param, uint8_t search_param_length);
+	const struct app_sec_bond_data_env_tag *(*search_entry)(enum bdb_search_by_type search_type,
+								void *search_param,
+								uint8_t search_param_length);
+	uint32_t (*timestamp_counter)(void);
+};
+
+#define BACKEND(p, desc, safe) \
+	{ desc, safe, p##_bdb_init, p##_bdb_add_entry, p##_bdb_remove_entry, \
+	  p##_bdb_search_entry, p##_bdb_timestamp_counter }
+
+static const struct backend backends[] = {
+	BACKEND(flat, "erase and rewrite", false),
+	BACKEND(jrnl, "journal", true),
+};
+
+#define NB_BACKENDS	(sizeof(backends) / sizeof(backends[0]))
+
+static unsigned int num_ops = 2000;
+static unsigned int num_peers = 8;
+static unsigned int remove_pct = 20;
+static unsigned int endurance = 100000;
+static uint32_t seed = 1;
+
+static void usage(const char* my_name)
+{
+	fprintf(stderr,
+		"Version: " BOND_DB_BENCH_VERSION "\n"
+		"\n"
+		"Usage: %s [-n ops] [-p peers] [-r remove_pct] [-e cycles] [-s seed]\n"
+		"\n"
+		"  Runs the bond database of the SDK on a simulated SPI flash, with the\n"
+		"  default (erase and rewrite) and the journal backend. Checks the state\n"
+		"  and the timestamp counter after a reset, after power failures at every\n"
+		"  programmed byte and after a failed sector erase, checks that the\n"
+		"  journal imports a database stored by the default backend, then reports\n"
+		"  the erases, the programmed bytes and the flash time per update.\n"
+		"\n"
+		"  -n ops          Bond updates of the workload (default 2000)\n"
+		"  -p peers        Peers bonding in turn, more than the %u slots\n"
+		"                  (default 8, at most %u)\n"
+		"  -r remove_pct   Share of the updates that remove a bond (default 20)\n"
+		"  -e cycles       Erase cycles of a sector, for the wear estimate\n"
+		"                  (default 100000)\n"
+		"  -s seed         Seed of the workload (default 1)\n",
+		my_name, SLOTS, MAX_PEERS);
+}
+
+/*
+ * Helpers
+ */
+
+static int errors;
+
+static void expect(bool ok, const char *what)
+{
+	if (!ok) {
+		printf("FAIL  %s\n", what);
+		errors++;
+	}
+}
+
+static unsigned int warnings;
+
+/* ASSERT_WARNING() of the bond database */
+void host_assert_warning(bool cond, const char *expr)
+{
+	if (!cond)
+		warnings++;
+}
+
+static uint32_t rnd_state;
+
+static uint32_t rnd(void)
+{
+	/* xorshift32 */
+	rnd_state ^= rnd_state << 13;
+	rnd_state ^= rnd_state >> 17;
+	rnd_state ^= rnd_state << 5;
+	return rnd_state;
+}
+
+/*
+ * Reference model of the database: the bonded peers, the version of their bond data,
+ * and the order in which they were written for the least recently written eviction
+ */
+
+struct model {
+	uint32_t version[MAX_PEERS];	/* 0: not bonded */
+	uint32_t written[MAX_PEERS];
+	uint32_t counter;		/* timestamp counter of the database */
+	uint32_t next_version;
+};
+
+struct op {
+	bool remove;
+	unsigned int peer;
+	uint32_t version;
+};
+
+static void peer_addr(unsigned int peer, uint8_t *addr)
+{
+	addr[0] = 0xB0;
+	addr[1] = peer + 1;
+	addr[2] = 0x11;
+	addr[3] = 0x22;
+	addr[4] = 0x33;
+	addr[5] = 0xC4;
+}
+
+static void bond_data(unsigned int peer, uint32_t version, struct app_sec_bond_data_env_tag *data)
+{
+	memset(data, 0, sizeof(*data));
+	data->valid_keys = LTK_PRESENT;
+	memcpy(data->ltk.ltk.key, &version, sizeof(version));
+	data->ltk.ltk.key[15] = peer;
+	data->ltk.ediv = version;
+	data->ltk.key_size = 16;
+	peer_addr(peer, data->peer_bdaddr.addr.addr);
+	data->auth = 1;
+}
+
+static unsigned int model_bonded(const struct model *m)
+{
+	unsigned int i, n = 0;
+
+	for (i = 0; i < num_peers; i++)
+		if (m->version[i])
+			n++;
+	return n;
+}
+
+static void next_op(struct model *m, struct op *op)
+{
+	unsigned int n = model_bonded(m);
+	unsigned int i;
+
+	op->remove = n && (rnd() % 100 < remove_pct);
+	if (op->remove) {
+		n = rnd() % n;
+		for (i = 0; i < num_peers; i++)
+			if (m->version[i] && n-- == 0)
+				break;
+		op->peer = i;
+	} else {
+		op->peer = rnd() % num_peers;
+		op->version = ++m->next_version;
+	}
+}
+
+static void model_apply(struct model *m, const struct op *op)
+{
+	unsigned int i, oldest = MAX_PEERS;
+
+	if (op->remove) {
+		m->version[op->peer] = 0;
+		return;
+	}
+	if (!m->version[op->peer] && model_bonded(m) == SLOTS) {
+		for (i = 0; i < num_peers; i++)
+			if (m->version[i] && (oldest == MAX_PEERS || m->written[i] < m->written[oldest]))
+				oldest = i;
+		m->version[oldest] = 0;
+	}
+	m->version[op->peer] = op->version;
+	m->written[op->peer] = m->counter++;
+}
+
+static void run_op(const struct backend *b, const struct op *op)
+{
+	struct app_sec_bond_data_env_tag data;
+	uint8_t addr[BD_ADDR_LEN];
+
+	if (op->remove) {
+		peer_addr(op->peer, addr);
+		b->remove_entry(SEARCH_BY_BDA_TYPE, REMOVE_THIS_ENTRY, addr, BD_ADDR_LEN);
+	} else {
+		bond_data(op->peer, op->version, &data);
+		b->add_entry(&data);
+	}
+}
+
+/* The content of the database matches the model */
+static bool state_matches(const struct backend *b, const struct model *m)
+{
+	const struct app_sec_bond_data_env_tag *e;
+	struct app_sec_bond_data_env_tag data;
+	uint8_t addr[BD_ADDR_LEN];
+	unsigned int i;
+
+	for (i = 0; i < num_peers; i++) {
+		peer_addr(i, addr);
+		e = b->search_entry(SEARCH_BY_BDA_TYPE, addr, BD_ADDR_LEN);
+		if (!m->version[i]) {
+			if (e != NULL)
+				return false;
+			continue;
+		}
+		bond_data(i, m->version[i], &data);
+		if (e == NULL || memcmp(&e->ltk, &data.ltk, sizeof(data.ltk)))
+			return false;
+	}
+	return true;
+}
+
+static void reset(const struct backend *b)
+{
+	spi_flash_sim_power_up();
+	b->init();
+}
+
+static void start(const struct backend *b, struct model *m)
+{
+	spi_flash_sim_format();
+	memset(m, 0, sizeof(*m));
+	rnd_state = seed;
+	warnings = 0;
+	b->init();
+}
+
+/*
+ * Checks
+ */
+
+/* Every update survives a reset, with the timestamp counter */
+static void check_reset(const struct backend *b)
+{
+	struct model m;
+	struct op op;
+	unsigned int i;
+	char what[128];
+
+	start(b, &m);
+	for (i = 0; i < num_ops; i++) {
+		next_op(&m, &op);
+		run_op(b, &op);
+		model_apply(&m, &op);
+		reset(b);
+		snprintf(what, sizeof(what), "%s: update %u lost by a reset", b->name, i);
+		expect(state_matches(b, &m), what);
+		snprintf(what, sizeof(what), "%s: timestamp counter %u after update %u and a reset, expected %u",
+			 b->name, b->timestamp_counter(), i, m.counter);
+		expect(b->timestamp_counter() == m.counter, what);
+		if (errors)
+			break;
+	}
+	expect(warnings == 0, "unexpected ASSERT_WARNING");
+}
+
+/*
+ * The newest bond is dropped when the database is stored as a whole: the timestamp
+ * counter still survives a reset
+ */
+static void check_timestamp_counter(const struct backend *b)
+{
+	struct model m;
+	struct op op = { .remove = false };
+	uint8_t addr[BD_ADDR_LEN];
+	char what[128];
+
+	start(b, &m);
+	for (op.peer = 0; op.peer < 2; op.peer++) {
+		op.version = ++m.next_version;
+		run_op(b, &op);
+		model_apply(&m, &op);
+	}
+	peer_addr(0, addr);
+	b->remove_entry(SEARCH_BY_BDA_TYPE, REMOVE_ALL_BUT_THIS_ENTRY, addr, BD_ADDR_LEN);
+	m.version[1] = 0;
+	reset(b);
+	snprintf(what, sizeof(what), "%s: timestamp counter %u after a reset, expected %u",
+		 b->name, b->timestamp_counter(), m.counter);
+	expect(state_matches(b, &m) && b->timestamp_counter() == m.counter, what);
+}
+
+/*
+ * Power fails after every number of programmed bytes of an update: after the reset the
+ * database holds either the state before or the state after the update
+ */
+static void check_power_fail(const struct backend *b, unsigned int updates)
+{
+	static uint8_t saved[FLASH_SIZE];
+	struct model m, next;
+	struct op op;
+	unsigned int i, runs = 0, before = 0, after = 0, lost = 0;
+	long k;
+
+	start(b, &m);
+	for (i = 0; i < updates; i++) {
+		next = m;
+		next_op(&next, &op);
+		model_apply(&next, &op);
+		memcpy(saved, spi_flash_sim_mem(), FLASH_SIZE);
+		for (k = 0; ; k++) {
+			spi_flash_sim_fail_after(k);
+			run_op(b, &op);
+			if (!spi_flash_sim_failed())
+				break;
+			runs++;
+			reset(b);
+			if (state_matches(b, &m) && b->timestamp_counter() == m.counter)
+				before++;
+			else if (state_matches(b, &next) && b->timestamp_counter() == next.counter)
+				after++;
+			else
+				lost++;
+			/* back to the state before the update */
+			memcpy(spi_flash_sim_mem(), saved, FLASH_SIZE);
+			reset(b);
+		}
+		spi_flash_sim_fail_after(-1);
+		m = next;
+	}
+	printf("%-18s %u power failures in %u updates: %u before, %u after, %u lost\n",
+	       b->name, runs, updates, before, after, lost);
+	if (b->power_safe)
+		expect(lost == 0, "power failure lost the database");
+}
+
+/*
+ * A sector erase fails: the update is reported, the flash keeps the previous state and
+ * the next update stores both
+ */
+static void check_erase_error(const struct backend *b)
+{
+	static uint8_t saved[FLASH_SIZE];
+	struct model m, next, last;
+	struct op op, op2;
+	unsigned int i;
+	char what[128];
+
+	start(b, &m);
+	for (i = 0; i < num_ops; i++) {
+		next = m;
+		next_op(&next, &op);
+		model_apply(&next, &op);
+		memcpy(saved, spi_flash_sim_mem(), FLASH_SIZE);
+		spi_flash_sim_erase_error_at(1);
+		run_op(b, &op);
+		spi_flash_sim_erase_error_at(0);
+		if (warnings)
+			break;
+		m = next;
+	}
+	if (i == num_ops) {
+		expect(false, "no update erased a sector");
+		return;
+	}
+	snprintf(what, sizeof(what), "%s: %u warnings for a failed erase", b->name, warnings);
+	expect(warnings == 1, what);
+
+	/* a reset now returns the previous state */
+	reset(b);
+	snprintf(what, sizeof(what), "%s: failed erase of update %u changed the database", b->name, i);
+	expect(state_matches(b, &m) && b->timestamp_counter() == m.counter, what);
+
+	/* the same failure, then one more update without a reset */
+	memcpy(spi_flash_sim_mem(), saved, FLASH_SIZE);
+	reset(b);
+	spi_flash_sim_erase_error_at(1);
+	run_op(b, &op);
+	spi_flash_sim_erase_error_at(0);
+	last = next;
+	next_op(&last, &op2);
+	model_apply(&last, &op2);
+	run_op(b, &op2);
+	reset(b);
+	snprintf(what, sizeof(what), "%s: update after a failed erase not stored", b->name);
+	expect(state_matches(b, &last) && b->timestamp_counter() == last.counter, what);
+	expect(warnings == 2, "failed erase reported once per update");
+
+	printf("%-18s erase failure of update %u reported and recovered\n", b->name, i);
+}
+
+/*
+ * The journal is enabled on a device with bonds stored by the default backend: the first
+ * boot imports them, also when power fails during the import, and later updates and
+ * resets keep them
+ */
+static void check_legacy_import(const struct backend *from, const struct backend *to)
+{
+	static uint8_t saved[FLASH_SIZE];
+	struct model m;
+	struct op op;
+	unsigned int i, runs = 0;
+	char what[128];
+	long k;
+
+	start(from, &m);
+	for (i = 0; i < num_ops / 10; i++) {
+		next_op(&m, &op);
+		run_op(from, &op);
+		model_apply(&m, &op);
+	}
+	memcpy(saved, spi_flash_sim_mem(), FLASH_SIZE);
+
+	for (k = 0; ; k++) {
+		spi_flash_sim_power_up();
+		spi_flash_sim_fail_after(k);
+		to->init();
+		if (!spi_flash_sim_failed())
+			break;
+		runs++;
+		reset(to);
+		snprintf(what, sizeof(what), "%s: import lost by a power failure after %ld bytes",
+			 to->name, k);
+		expect(state_matches(to, &m) && to->timestamp_counter() == m.counter, what);
+		memcpy(spi_flash_sim_mem(), saved, FLASH_SIZE);
+	}
+	spi_flash_sim_fail_after(-1);
+	snprintf(what, sizeof(what), "%s: database of %s not imported", to->name, from->name);
+	expect(state_matches(to, &m) && to->timestamp_counter() == m.counter, what);
+
+	for (i = 0; i < num_ops / 10; i++) {
+		next_op(&m, &op);
+		run_op(to, &op);
+		model_apply(&m, &op);
+		reset(to);
+	}
+	snprintf(what, sizeof(what), "%s: update after the import lost by a reset", to->name);
+	expect(state_matches(to, &m) && to->timestamp_counter() == m.counter, what);
+	expect(warnings == 0, "unexpected ASSERT_WARNING");
+
+	printf("%-18s imports %s, %u power failures during the import\n", to->name, from->name,
+	       runs);
+}
+
+/*
+ * Benchmark
+ */
+
+static void run_bench(const struct backend *b)
+{
+	const spi_flash_sim_stats_t *s = spi_flash_sim_stats();
+	struct model m;
+	struct op op;
+	unsigned int i, max_erases;
+
+	start(b, &m);
+	spi_flash_sim_clear_stats();
+	for (i = 0; i < num_ops; i++) {
+		next_op(&m, &op);
+		run_op(b, &op);
+		model_apply(&m, &op);
+	}
+	max_erases = spi_flash_sim_max_sector_erases();
+	printf("%-18s %8.3f %9.1f %9.2f %11u %13.0f\n", b->name,
+	       (double) s->erase_ops / num_ops, (double) s->wr_bytes / num_ops,
+	       (s->bus_us + s->busy_us) / num_ops / 1000, max_erases,
+	       max_erases ? (double) endurance * num_ops / max_erases : 0);
+
+	reset(b);
+	expect(state_matches(b, &m), "database after the benchmark");
+	expect(warnings == 0, "unexpected ASSERT_WARNING");
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int i;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:p:r:e:s:")) != -1) {
+		switch (opt) {
+		case 'n':
+			num_ops = strtoul(optarg, NULL, 0);
+			break;
+		case 'p':
+			num_peers = strtoul(optarg, NULL, 0);
+			break;
+		case 'r':
+			remove_pct = strtoul(optarg, NULL, 0);
+			break;
+		case 'e':
+			endurance = strtoul(optarg, NULL, 0);
+			break;
+		case 's':
+			seed = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	if (optind != argc || num_ops < 100 || num_peers <= SLOTS || num_peers > MAX_PEERS ||
+	    remove_pct > 90 || endurance == 0 || seed == 0) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	spi_flash_sim_init(FLASH_SIZE);
+
+	for (i = 0; i < NB_BACKENDS; i++)
+		check_reset(&backends[i]);
+	for (i = 0; i < NB_BACKENDS; i++)
+		check_timestamp_counter(&backends[i]);
+	for (i = 0; i < NB_BACKENDS; i++)
+		check_power_fail(&backends[i], 60);
+	for (i = 0; i < NB_BACKENDS; i++)
+		check_erase_error(&backends[i]);
+	check_legacy_import(&backends[0], &backends[1]);
+
+	printf("\n%u updates, %u peers on %u slots, %u%% removals, SPI clock %g MHz\n",
+	       num_ops, num_peers, SLOTS, remove_pct, spi_flash_sim_timing()->spi_mhz);
+	printf("%-18s %8s %9s %9s %11s %13s\n", "per update", "erases", "prog. B", "flash ms",
+	       "max erases", "updates/wear");
+	for (i = 0; i < NB_BACKENDS; i++)
+		run_bench(&backends[i]);
+
+	if (errors) {
+		printf("\nFAILED, %d errors\n", errors);
+		return EXIT_FAILURE;
+	}
+	printf("\nOK\n");
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,84 @@
+/**
+ ****************************************************************************************
+ *
+ * @file app_security.h
+ *
+ * @brief Bond data of the bond database benchmark.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _APP_SECURITY_H_
+#define _APP_SECURITY_H_
+
+#include <stdint.h>
+#include "co_bt.h"
+#include "gap.h"
+#include "gapc_task.h"
+
+/* As in sdk/app_modules/api/app_security.h */
+enum bdb_search_by_type
+{
+	SEARCH_BY_EDIV_TYPE,
+	SEARCH_BY_BDA_TYPE,
+	SEARCH_BY_IRK_TYPE,
+	SEARCH_BY_ID_TYPE,
+	SEARCH_BY_SLOT_TYPE,
+	SEARCH_BY_CUSTOM_TYPE,
+	NO_SEARCH_TYPE,
+};
+
+enum bdb_remove_type
+{
+	REMOVE_THIS_ENTRY,
+	REMOVE_ALL_BUT_THIS_ENTRY,
+	REMOVE_ALL,
+};
+
+enum keys_present
+{
+	NOKEY_PRESENT	= 0,
+	LTK_PRESENT	= (1 << 0),
+	RLTK_PRESENT	= (1 << 1),
+	RIRK_PRESENT	= (1 << 2),
+	LCSRK_PRESENT	= (1 << 3),
+	RCSRK_PRESENT	= (1 << 4),
+};
+
+struct app_sec_bond_data_env_tag
+{
+	enum keys_present valid_keys;
+	struct gapc_ltk ltk;
+	struct gapc_ltk rltk;
+	struct gapc_irk rirk;
+	struct gap_sec_key lcsrk;
+	struct gap_sec_key rcsrk;
+	struct gap_bdaddr peer_bdaddr;
+	uint8_t auth;
+	uint8_t bdb_slot;
+};
+
+#endif /* _APP_SECURITY_H_ */
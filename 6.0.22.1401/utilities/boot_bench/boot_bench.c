@@ -0,0 +1,470 @@
+/**
+ ****************************************************************************************
+ *
+ * @file boot_bench.c
+ *
+ * @brief Secondary bootloader checks and boot time benchmark on a simulated SPI flash.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "spi_flash.h"
+#include "sw_aes.h"
+#include "user_periph_setup.h"
+#include "bootloader.h"
+
+#define BOOT_BENCH_VERSION	"v_1.0"
+
+/* Image banks of the synthesized flash, the product header is at PRODUCT_HEADER_POSITION */
+#define BANK1_OFFSET		0x02000
+#define BANK2_OFFSET		0x1C000
+#define BANK_SIZE		(BANK2_OFFSET - BANK1_OFFSET)
+
+/* The SYSRAM the images are loaded to */
+uint8_t host_sysram[SPI_FLASH_DEV_SIZE];
+
+/* The loaders: bootloader.c built with each configuration, from this tree and from REF_REV */
+#define LOADERS(X)		X(ref_cpu, 0, 0) X(new_cpu, 0, 0) X(ref_dma, 1, 0) X(new_dma, 1, 0) \
+				X(ref_cpu_aes, 0, 1) X(new_cpu_aes, 0, 1) X(ref_dma_aes, 1, 1) X(new_dma_aes, 1, 1)
+#define LOADER_DECL(v, dma, aes)	int v##_spi_loadActiveImage(void);
+LOADERS(LOADER_DECL)
+
+struct loader {
+	const char *name;
+	int (*load)(void);
+	bool dma;
+	bool aes;
+};
+
+#define LOADER_ENTRY(v, dma, aes)	{ #v, v##_spi_loadActiveImage, dma, aes },
+
+static const struct loader loaders[] = {
+	LOADERS(LOADER_ENTRY)
+};
+
+#define NUM_LOADERS		(sizeof(loaders) / sizeof(loaders[0]))
+
+/* Key and IV of the bootloader, in decrypt.c */
+extern const uint8_t Key[16];
+extern const uint8_t IV[16];
+
+static uint32_t image_size = 32 * 1024;
+static unsigned int boots = 100;
+static double cpu_mhz = 16;
+static double crc_cycles = 14;
+static double aes_cycles = 180;
+
+/* CPU work of the current boot, charged to the simulated time by the wrappers */
+static uint64_t crc_bytes;
+static uint64_t aes_bytes;
+
+static uint8_t *pristine;
+static uint8_t plain[2][BANK_SIZE];
+static uint32_t seed = 1;
+static int errors;
+
+static void usage(const char* my_name)
+{
+	fprintf(stderr,
+		"Version: " BOOT_BENCH_VERSION "\n"
+		"\n"
+		"Usage: %s [-s size] [-n boots] [-c spi_mhz] [-m cpu_mhz] [-C cycles]\n"
+		"          [-A cycles] [-f flash_file] [-o flash_file]\n"
+		"\n"
+		"  Boots the dual image secondary bootloader from a simulated SPI flash,\n"
+		"  with the bootloader.c of this tree and the one of the reference\n"
+		"  revision (see 'make bench'), with and without SPI DMA and AES.\n"
+		"  Checks the loaded image and the fallback to the other bank when the\n"
+		"  active image is corrupted, then reports per boot the flash commands,\n"
+		"  the bytes read, checked and decrypted, the boot time of the target\n"
+		"  from the timing model and the host time.\n"
+		"\n"
+		"  The model counts the SPI bus time and the CPU time of the CRC and of\n"
+		"  the decryption, in cycles per byte; other CPU time is not counted.\n"
+		"  The host time is given for the loaders without DMA only: the others\n"
+		"  drive the SPI bus, which the host simulates byte by byte.\n"
+		"\n"
+		"  -s size       image size in bytes (default 32768)\n"
+		"  -n boots      boots per measurement (default 100)\n"
+		"  -c spi_mhz    SPI clock (default 8, as set by the bootloader)\n"
+		"  -m cpu_mhz    CPU clock (default 16)\n"
+		"  -C cycles     CRC32 cycles per byte (default 14)\n"
+		"  -A cycles     AES-128 CBC decryption cycles per byte (default 180,\n"
+		"                an estimate for the software AES on Cortex-M0+)\n"
+		"  -f flash_file boot the flash image in flash_file (e.g. made by\n"
+		"                'mkimage multi spi') instead of the synthesized one\n"
+		"  -o flash_file save the synthesized flash to flash_file\n",
+		my_name);
+}
+
+/*
+ * CPU time of the target, charged by the wrappers of the functions called by the loaders
+ */
+
+uint32_t __real_crc32(uint32_t crc, const void *buf, size_t size);
+void __real_AES_cbc_decrypt(AES_CTX *ks, const uint8_t *in, uint8_t *out, int length);
+
+uint32_t __wrap_crc32(uint32_t crc, const void *buf, size_t size)
+{
+	crc_bytes += size;
+	spi_flash_sim_advance(size * crc_cycles / cpu_mhz);
+	return __real_crc32(crc, buf, size);
+}
+
+void __wrap_AES_cbc_decrypt(AES_CTX *ks, const uint8_t *in, uint8_t *out, int length)
+{
+	aes_bytes += length;
+	spi_flash_sim_advance(length * aes_cycles / cpu_mhz);
+	__real_AES_cbc_decrypt(ks, in, out, length);
+}
+
+/*
+ * Flash
+ */
+
+static uint32_t rnd(void)
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	return seed;
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void write_image(uint32_t offset, uint8_t id, const uint8_t *code, uint32_t size, bool encrypt)
+{
+	uint8_t *mem = spi_flash_sim_mem();
+	s_imageHeader hdr;
+
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.signature[0] = IMAGE_HEADER_SIGNATURE1;
+	hdr.signature[1] = IMAGE_HEADER_SIGNATURE2;
+	hdr.validflag = STATUS_VALID_IMAGE;
+	hdr.imageid = id;
+	hdr.code_size = size;
+	hdr.CRC = __real_crc32(0, code, size);
+	snprintf((char *) hdr.version, sizeof(hdr.version), "v_1.0.%u", id);
+	hdr.timestamp = 1700000000 + id;
+	hdr.encryption = encrypt;
+	memcpy(&mem[offset], &hdr, sizeof(hdr));
+
+	if (encrypt) {
+		AES_CTX ctx;
+
+		AES_set_key(&ctx, Key, IV, AES_MODE_128);
+		AES_cbc_encrypt(&ctx, code, &mem[offset + CODE_OFFSET], size);
+	} else {
+		memcpy(&mem[offset + CODE_OFFSET], code, size);
+	}
+}
+
+/* Two images, the one in bank 2 is the newer */
+static void make_flash(bool encrypt)
+{
+	s_productHeader ph;
+
+	memset(spi_flash_sim_mem(), 0xFF, spi_flash_sim_size());
+	memset(&ph, 0, sizeof(ph));
+	ph.signature[0] = PRODUCT_HEADER_SIGNATURE1;
+	ph.signature[1] = PRODUCT_HEADER_SIGNATURE2;
+	ph.offset1 = BANK1_OFFSET;
+	ph.offset2 = BANK2_OFFSET;
+	memcpy(&spi_flash_sim_mem()[PRODUCT_HEADER_POSITION], &ph, sizeof(ph));
+
+	write_image(BANK1_OFFSET, 1, plain[0], image_size, encrypt);
+	write_image(BANK2_OFFSET, 2, plain[1], image_size, encrypt);
+	memcpy(pristine, spi_flash_sim_mem(), spi_flash_sim_size());
+}
+
+static void restore_flash(void)
+{
+	memcpy(spi_flash_sim_mem(), pristine, spi_flash_sim_size());
+	spi_flash_sim_power_up();
+}
+
+static void expect(bool ok, const char *what)
+{
+	if (!ok) {
+		printf("FAIL  %s\n", what);
+		errors++;
+	}
+}
+
+/*
+ * Checks
+ */
+
+static void check_boot(const struct loader *l)
+{
+	char what[96];
+	int ret;
+
+	/* both images valid: the newer one, in bank 2, is booted */
+	restore_flash();
+	memset(host_sysram, 0, sizeof(host_sysram));
+	ret = l->load();
+	snprintf(what, sizeof(what), "%s: boot of the newer image", l->name);
+	expect(ret == 0 && !memcmp(host_sysram, plain[1], image_size), what);
+
+	/* the newer image is corrupted: it is invalidated and the older one is booted */
+	restore_flash();
+	spi_flash_sim_mem()[BANK2_OFFSET + CODE_OFFSET + image_size / 2] ^= 0x01;
+	memset(host_sysram, 0, sizeof(host_sysram));
+	ret = l->load();
+	snprintf(what, sizeof(what), "%s: fallback to the older image", l->name);
+	expect(ret == 0 && !memcmp(host_sysram, plain[0], image_size), what);
+	snprintf(what, sizeof(what), "%s: corrupted image invalidated", l->name);
+	expect(spi_flash_sim_mem()[BANK2_OFFSET + offsetof(s_imageHeader, validflag)] != STATUS_VALID_IMAGE,
+	       what);
+
+	/* both images corrupted */
+	restore_flash();
+	spi_flash_sim_mem()[BANK1_OFFSET + CODE_OFFSET] ^= 0x80;
+	spi_flash_sim_mem()[BANK2_OFFSET + CODE_OFFSET + image_size - 1] ^= 0x80;
+	snprintf(what, sizeof(what), "%s: no valid image", l->name);
+	expect(l->load() != 0, what);
+
+	/* no product header */
+	restore_flash();
+	spi_flash_sim_mem()[PRODUCT_HEADER_POSITION] = 0xFF;
+	snprintf(what, sizeof(what), "%s: no product header", l->name);
+	expect(l->load() != 0, what);
+
+	/* no valid image header: the reference reads past its image offsets, skip it */
+	if (!strncmp(l->name, "ref", 3))
+		return;
+	restore_flash();
+	spi_flash_sim_mem()[BANK1_OFFSET + offsetof(s_imageHeader, validflag)] = STATUS_INVALID_IMAGE;
+	spi_flash_sim_mem()[BANK2_OFFSET + offsetof(s_imageHeader, validflag)] = STATUS_INVALID_IMAGE;
+	snprintf(what, sizeof(what), "%s: no valid image header", l->name);
+	expect(l->load() != 0, what);
+}
+
+/*
+ * Benchmark
+ */
+
+struct result {
+	double model_us;
+	double host_us;
+	spi_flash_sim_stats_t io;
+	uint64_t crc_bytes;
+	uint64_t aes_bytes;
+	int ret;
+};
+
+static void measure(const struct loader *l, struct result *r)
+{
+	double t0;
+	uint64_t t;
+
+	restore_flash();
+	spi_flash_sim_clear_stats();
+	crc_bytes = 0;
+	aes_bytes = 0;
+	t0 = spi_flash_sim_time_us();
+	r->ret = l->load();
+	r->model_us = spi_flash_sim_time_us() - t0;
+	r->io = *spi_flash_sim_stats();
+	r->crc_bytes = crc_bytes;
+	r->aes_bytes = aes_bytes;
+
+	r->host_us = -1;
+	if (l->dma)
+		return;
+	t = now_ns();
+	for (unsigned int i = 0; i < boots; i++)
+		l->load();
+	r->host_us = (now_ns() - t) / 1000.0 / boots;
+}
+
+static void report(const char *name, const struct result *r, const struct result *ref)
+{
+	printf("%-12s %4d %6llu %8llu %8llu %8llu %9.2f", name, r->ret,
+	       (unsigned long long) r->io.transactions, (unsigned long long) r->io.rd_bytes,
+	       (unsigned long long) r->crc_bytes, (unsigned long long) r->aes_bytes,
+	       r->model_us / 1000);
+	if (ref)
+		printf(" %5.2fx", ref->model_us / r->model_us);
+	else
+		printf("       ");
+	/* The DMA loaders drive the bus, which is simulated byte by byte on the host */
+	if (r->host_us < 0)
+		printf(" %9s", "-");
+	else
+		printf(" %9.1f", r->host_us);
+	if (ref && r->host_us >= 0)
+		printf(" %5.2fx", ref->host_us / r->host_us);
+	printf("\n");
+}
+
+static void run_bench(bool aes)
+{
+	struct result ref, res;
+
+	make_flash(aes);
+	printf("\n%s image of %u bytes, SPI %.0f MHz, CPU %.0f MHz, CRC %.0f, AES %.0f cycles/byte\n",
+	       aes ? "Encrypted" : "Plain", image_size, spi_flash_sim_timing()->spi_mhz, cpu_mhz,
+	       crc_cycles, aes_cycles);
+	printf("%-12s %4s %6s %8s %8s %8s %9s %6s %9s %6s\n", "loader", "ret", "cmds", "read",
+	       "crc", "aes", "model ms", "", "host us", "");
+	for (unsigned int i = 0; i < NUM_LOADERS; i += 2) {
+		if (loaders[i].aes != aes)
+			continue;
+		measure(&loaders[i], &ref);
+		measure(&loaders[i + 1], &res);
+		report(loaders[i].name, &ref, NULL);
+		report(loaders[i + 1].name, &res, &ref);
+		expect(ref.ret == 0 && res.ret == 0, "benchmark boots");
+	}
+}
+
+/* Boot a flash image file with every plain and AES loader of this tree */
+static int boot_file(const char *filename)
+{
+	if (spi_flash_sim_load(filename) != 0) {
+		fprintf(stderr, "cannot read %s\n", filename);
+		return EXIT_FAILURE;
+	}
+	memcpy(pristine, spi_flash_sim_mem(), spi_flash_sim_size());
+
+	printf("%-12s %4s %6s %8s %8s %8s %9s\n", "loader", "ret", "cmds", "read", "crc", "aes",
+	       "model ms");
+	for (unsigned int i = 0; i < NUM_LOADERS; i++) {
+		struct result r;
+
+		if (!strncmp(loaders[i].name, "ref", 3))
+			continue;
+		measure(&loaders[i], &r);
+		report(loaders[i].name, &r, NULL);
+	}
+	return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv)
+{
+	spi_flash_sim_timing_t timing;
+	const char *in_file = NULL;
+	const char *out_file = NULL;
+	double spi_mhz = 8;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "s:n:c:m:C:A:f:o:")) != -1) {
+		switch (opt) {
+		case 's':
+			image_size = strtoul(optarg, NULL, 0);
+			break;
+		case 'n':
+			boots = strtoul(optarg, NULL, 0);
+			break;
+		case 'c':
+			spi_mhz = strtod(optarg, NULL);
+			break;
+		case 'm':
+			cpu_mhz = strtod(optarg, NULL);
+			break;
+		case 'C':
+			crc_cycles = strtod(optarg, NULL);
+			break;
+		case 'A':
+			aes_cycles = strtod(optarg, NULL);
+			break;
+		case 'f':
+			in_file = optarg;
+			break;
+		case 'o':
+			out_file = optarg;
+			break;
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	/* AES-CBC works on whole blocks */
+	image_size = (image_size + AES_BLOCKSIZE - 1) & ~(AES_BLOCKSIZE - 1);
+	if (optind != argc || image_size == 0 || image_size > BANK_SIZE - CODE_OFFSET || boots == 0 ||
+	    spi_mhz <= 0 || cpu_mhz <= 0) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	spi_flash_sim_init(SPI_FLASH_DEV_SIZE);
+	timing = *spi_flash_sim_timing();
+	timing.spi_mhz = spi_mhz;
+	spi_flash_sim_set_timing(&timing);
+	pristine = malloc(spi_flash_sim_size());
+	if (pristine == NULL)
+		return EXIT_FAILURE;
+
+	if (in_file)
+		return boot_file(in_file);
+
+	for (int b = 0; b < 2; b++)
+		for (uint32_t i = 0; i < image_size; i++)
+			plain[b][i] = (uint8_t) (rnd() >> 8);
+
+	for (int aes = 0; aes < 2; aes++) {
+		make_flash(aes);
+		for (unsigned int i = 0; i < NUM_LOADERS; i++)
+			if (loaders[i].aes == aes)
+				check_boot(&loaders[i]);
+	}
+	printf("Checks: boot, fallback, invalidation and errors of %u loaders\n", (unsigned int) NUM_LOADERS);
+
+	if (out_file) {
+		make_flash(false);
+		if (spi_flash_sim_save(out_file) != 0) {
+			fprintf(stderr, "cannot write %s\n", out_file);
+			return EXIT_FAILURE;
+		}
+	}
+
+	run_bench(false);
+	run_bench(true);
+
+	if (errors) {
+		printf("\nFAILED, %d errors\n", errors);
+		return EXIT_FAILURE;
+	}
+	printf("\nOK\n");
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,541 @@
+/**
+ ****************************************************************************************
+ *
+ * @file cal_sched_sim.c
+ *
+ * @brief Thermal profile simulation of the radio calibration scheduling.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+#define _DEFAULT_SOURCE
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <unistd.h>
+#include "cal_sched.h"
+
+#define CAL_SCHED_SIM_VERSION	"v_1.0"
+
+/* Simulation step: the calibrations are checked at every BLE wake-up */
+#define STEP_SLOTS		160		/* 100 ms */
+#define SLOTS_PER_S		1600
+#define TIME_MASK		0x07FFFFFF
+
+/* Fixed policy of conditionally_run_radio_cals() */
+#define FIXED_SLOTS		3200
+
+/* Default thresholds of arch_system.c */
+#define RF_DIFF			8		/* CFG_CALIBRATION_TEMP_DIFF */
+#define XTAL_DIFF		5		/* CFG_XTAL32M_TRIM_TEMP_DIFF */
+
+enum { CAL_RF, CAL_XTAL, CALS };
+
+/* Temperature profile, one point per step */
+struct profile {
+	char name[64];
+	float *temp;
+	unsigned int len;
+};
+
+struct result {
+	unsigned int adc;		/* conversions of the scheduler */
+	unsigned int shared;		/* samples of other ADC users used */
+	unsigned int cals[CALS];
+	double rf_err;			/* worst |T - T at the last RF calibration| */
+	double trim_err;		/* worst XTAL32M trim error (trim LSB) */
+	double over_s;			/* time beyond the RF threshold */
+};
+
+/* DA14535 XTAL32M trim curve of xtal32m_calc_trim() (arch_system.c) */
+static const int16_t trimfit_dt[] = {-429, 89, 494, 777, 853, 791, 647, 439, 213, -21, -259, -501,
+	-750, -982, -1179, -1321, -1310, -1158, -855, -386, 319, 1305, 2497};
+static const int trim_delta = 4;
+static const int adc_min = -149;
+/* ADC steps (>> 6) per degree of the DA14535 temperature sensor (adc_531.c) */
+#define ADC_PER_DEG		2.3
+
+static double noise = 0.3;
+static unsigned int share_s;
+static unsigned int runs = 16;
+static uint32_t seed = 1;
+static uint32_t rnd_state = 1;
+
+static void usage(const char* my_name)
+{
+	fprintf(stderr,
+		"Version: " CAL_SCHED_SIM_VERSION "\n"
+		"\n"
+		"Usage: %s [-n noise] [-a seconds] [-r runs] [-s seed] [profile.csv...]\n"
+		"\n"
+		"  Runs the temperature driven radio calibrations of the DA14531 family\n"
+		"  over thermal profiles with the fixed 2 s sampling of\n"
+		"  conditionally_run_radio_cals() and with the predictive scheduler\n"
+		"  (CFG_PREDICTIVE_CAL), and reports the GP ADC conversions, the RF\n"
+		"  calibrations and XTAL32M trimmings, the worst temperature drift since\n"
+		"  the last RF calibration, the worst XTAL32M trim error (DA14535 curve)\n"
+		"  and the time spent beyond the RF calibration threshold, as the means of\n"
+		"  runs with different sensor noise. Fails if the predictive scheduler is\n"
+		"  worse than the fixed sampling on any of them for any profile.\n"
+		"\n"
+		"  A profile is a recorded CSV file of 'seconds,celsius' lines, '#' starts\n"
+		"  a comment. Without files, built-in profiles are used.\n"
+		"\n"
+		"  -n noise     temperature sensor noise, degrees peak (default 0.3)\n"
+		"  -a seconds   another GP ADC user samples the temperature with this\n"
+		"               period; its samples are offered to the scheduler\n"
+		"  -r runs      runs per profile (default 16)\n"
+		"  -s seed      noise seed of the first run (default 1)\n",
+		my_name);
+}
+
+static double rnd_uniform(void)
+{
+	/* xorshift32 */
+	rnd_state ^= rnd_state << 13;
+	rnd_state ^= rnd_state >> 17;
+	rnd_state ^= rnd_state << 5;
+	return (rnd_state >> 8) / (double)(1 << 24);
+}
+
+/*
+ ****************************************************************************************
+ * Profiles
+ ****************************************************************************************
+ */
+
+static void profile_alloc(struct profile *p, const char *name, double seconds)
+{
+	snprintf(p->name, sizeof(p->name), "%s", name);
+	p->len = seconds * SLOTS_PER_S / STEP_SLOTS;
+	p->temp = calloc(p->len, sizeof(*p->temp));
+	if (!p->temp) {
+		perror("calloc");
+		exit(EXIT_FAILURE);
+	}
+}
+
+static double step_s(unsigned int i)
+{
+	return (double)i * STEP_SLOTS / SLOTS_PER_S;
+}
+
+/* Two hours at room temperature */
+static void profile_stable(struct profile *p)
+{
+	unsigned int i;
+
+	profile_alloc(p, "stable", 7200);
+	for (i = 0; i < p->len; i++)
+		p->temp[i] = 25 + 0.4 * sin(2 * M_PI * step_s(i) / 600);
+}
+
+/* Outdoor day: 12 to 38 degrees over four hours */
+static void profile_diurnal(struct profile *p)
+{
+	unsigned int i;
+
+	profile_alloc(p, "diurnal", 14400);
+	for (i = 0; i < p->len; i++)
+		p->temp[i] = 25 - 13 * cos(2 * M_PI * step_s(i) / 14400);
+}
+
+/* Device put on a heat source, then taken away */
+static void profile_transient(struct profile *p)
+{
+	unsigned int i;
+	double t;
+
+	profile_alloc(p, "transient", 3600);
+	for (i = 0; i < p->len; i++) {
+		t = step_s(i);
+		if (t < 600)
+			p->temp[i] = 25;
+		else if (t < 1800)
+			p->temp[i] = 75 - 50 * exp(-(t - 600) / 90);
+		else
+			p->temp[i] = 25 + (75 - 50 * exp(-1200.0 / 90) - 25) * exp(-(t - 1800) / 300);
+	}
+}
+
+/* Thermal chamber: -10 to 60 degrees at 5 degrees per minute, 10 minutes soaks */
+static void profile_cycling(struct profile *p)
+{
+	const double ramp = 70 * 60 / 5, soak = 600, cycle = 2 * (ramp + soak);
+	unsigned int i;
+	double t;
+
+	profile_alloc(p, "cycling", 2 * cycle);
+	for (i = 0; i < p->len; i++) {
+		t = fmod(step_s(i), cycle);
+		if (t < soak)
+			p->temp[i] = -10;
+		else if (t < soak + ramp)
+			p->temp[i] = -10 + 70 * (t - soak) / ramp;
+		else if (t < 2 * soak + ramp)
+			p->temp[i] = 60;
+		else
+			p->temp[i] = 60 - 70 * (t - 2 * soak - ramp) / ramp;
+	}
+}
+
+/* Recorded profile: the points are linearly interpolated */
+static int profile_load(struct profile *p, const char *filename)
+{
+	double *ts = NULL, *temps = NULL, t, temp;
+	unsigned int n = 0, max = 0, i, k = 0;
+	char line[256];
+	const char *base;
+	FILE *f;
+
+	f = fopen(filename, "r");
+	if (!f) {
+		fprintf(stderr, "Could not open %s: %s\n", filename, strerror(errno));
+		return -1;
+	}
+	while (fgets(line, sizeof(line), f)) {
+		if (line[0] == '#' || sscanf(line, "%lf,%lf", &t, &temp) != 2)
+			continue;
+		if (n && t <= ts[n - 1]) {
+			fprintf(stderr, "%s: time not increasing at %g s\n", filename, t);
+			fclose(f);
+			return -1;
+		}
+		if (n == max) {
+			max = max ? 2 * max : 1024;
+			ts = realloc(ts, max * sizeof(*ts));
+			temps = realloc(temps, max * sizeof(*temps));
+			if (!ts || !temps) {
+				perror("realloc");
+				exit(EXIT_FAILURE);
+			}
+		}
+		ts[n] = t;
+		temps[n++] = temp;
+	}
+	fclose(f);
+	if (n < 2) {
+		fprintf(stderr, "%s: less than two points\n", filename);
+		return -1;
+	}
+
+	base = strrchr(filename, '/');
+	profile_alloc(p, base ? base + 1 : filename, ts[n - 1] - ts[0]);
+	for (i = 0; i < p->len; i++) {
+		t = ts[0] + step_s(i);
+		while (k < n - 2 && ts[k + 1] < t)
+			k++;
+		p->temp[i] = temps[k] + (temps[k + 1] - temps[k]) * (t - ts[k]) / (ts[k + 1] - ts[k]);
+	}
+	free(ts);
+	free(temps);
+	return 0;
+}
+
+/*
+ ****************************************************************************************
+ * Device model
+ ****************************************************************************************
+ */
+
+/* Trim offset (LSB) from the room temperature value, as xtal32m_calc_trim() computes it
+ * without the integer truncation */
+static double trim(double temp)
+{
+	double x = ADC_PER_DEG * (temp - 25);
+	int i = (int)floor((x - adc_min) / (1 << trim_delta));
+	int last = sizeof(trimfit_dt) / sizeof(trimfit_dt[0]) - 2;
+
+	if (i < 0)
+		i = 0;
+	if (i > last)
+		i = last;
+	return (trimfit_dt[i] + (trimfit_dt[i + 1] - trimfit_dt[i]) *
+		(x - (adc_min + i * (1 << trim_delta))) / (1 << trim_delta)) / 64;
+}
+
+/* Sensor reading: the temperature is read with noise and rounded to a degree */
+static double sense(double temp)
+{
+	return temp + noise * (2 * rnd_uniform() - 1);
+}
+
+struct device {
+	int8_t ref[CALS];		/* rf_cal_last_temp, xtal32m_trim_last_temp */
+	double ref_true[CALS];		/* true temperature at the last calibration */
+	double trim_temp;		/* sensed temperature the trim was computed for */
+};
+
+static void device_init(struct device *d)
+{
+	int i;
+
+	for (i = 0; i < CALS; i++)
+		d->ref[i] = CAL_SCHED_NO_REF;
+	d->trim_temp = 25;
+}
+
+static void device_calibrate(struct device *d, struct result *r, unsigned int cals,
+			     int8_t temp, double sensed, double true_temp)
+{
+	int i;
+
+	for (i = 0; i < CALS; i++) {
+		if (d->ref[i] == CAL_SCHED_NO_REF) {
+			/* First sample: the calibrations of the initialization hold */
+			d->ref[i] = temp;
+			d->ref_true[i] = true_temp;
+			if (i == CAL_XTAL)
+				d->trim_temp = sensed;
+			continue;
+		}
+		if (!(cals & (1 << i)))
+			continue;
+		r->cals[i]++;
+		d->ref[i] = temp;
+		d->ref_true[i] = true_temp;
+		if (i == CAL_XTAL)
+			d->trim_temp = sensed;
+	}
+}
+
+/* Errors of the calibrations at a step */
+static void device_errors(struct device *d, struct result *r, double true_temp)
+{
+	double err;
+
+	if (d->ref[CAL_RF] == CAL_SCHED_NO_REF)
+		return;
+
+	err = fabs(true_temp - d->ref_true[CAL_RF]);
+	if (err > r->rf_err)
+		r->rf_err = err;
+	if (err > RF_DIFF + 0.5)
+		r->over_s += (double)STEP_SLOTS / SLOTS_PER_S;
+
+	err = fabs(trim(true_temp) - trim(d->trim_temp));
+	if (err > r->trim_err)
+		r->trim_err = err;
+}
+
+/* conditionally_run_radio_cals() sampling every 2 s */
+static void run_fixed(const struct profile *p, struct result *r)
+{
+	static const uint8_t diff[CALS] = { RF_DIFF, XTAL_DIFF };
+	struct device d;
+	uint32_t last = 0;
+	unsigned int i, k, cals;
+
+	device_init(&d);
+	memset(r, 0, sizeof(*r));
+	for (i = 0; i < p->len; i++) {
+		uint32_t time = i * STEP_SLOTS;
+
+		if (i == 0 || time - last >= FIXED_SLOTS) {
+			double sensed = sense(p->temp[i]);
+			int8_t temp = (int8_t)lround(sensed);
+
+			last = time;
+			r->adc++;
+			cals = 0;
+			for (k = 0; k < CALS; k++)
+				if (d.ref[k] != CAL_SCHED_NO_REF && abs(temp - d.ref[k]) >= diff[k])
+					cals |= 1 << k;
+			device_calibrate(&d, r, cals, temp, sensed, p->temp[i]);
+		}
+		device_errors(&d, r, p->temp[i]);
+	}
+}
+
+/* Predictive scheduler; the BLE time starts close to its wrap */
+static void run_predictive(const struct profile *p, struct result *r)
+{
+	static const uint8_t diff[CALS] = { RF_DIFF, XTAL_DIFF };
+	const uint32_t base = TIME_MASK + 1 - 600 * SLOTS_PER_S;
+	unsigned int share = share_s * SLOTS_PER_S / STEP_SLOTS;
+	cal_sched_t sched;
+	struct device d;
+	unsigned int i, cals;
+
+	device_init(&d);
+	memset(&sched, 0, sizeof(sched));
+	memset(r, 0, sizeof(*r));
+	for (i = 0; i < p->len; i++) {
+		uint32_t time = (base + i * STEP_SLOTS) & TIME_MASK;
+		int due = cal_sched_due(&sched, time);
+
+		/* The sample of the other ADC user comes first and may make ours useless */
+		if (share && !(i % share) && cal_sched_accepts(&sched, time)) {
+			r->shared++;
+			due = 1;
+		} else if (due) {
+			r->adc++;
+		}
+		if (due) {
+			double sensed = sense(p->temp[i]);
+			int8_t temp = (int8_t)lround(sensed);
+
+			/* The first sample sets the references, as in radio_cals_check() */
+			device_calibrate(&d, r, 0, temp, sensed, p->temp[i]);
+			cals = cal_sched_sample(&sched, temp, time, d.ref, diff, CALS);
+			device_calibrate(&d, r, cals, temp, sensed, p->temp[i]);
+		}
+		device_errors(&d, r, p->temp[i]);
+	}
+}
+
+/* Sum the results of the runs */
+static void result_add(struct result *sum, const struct result *r)
+{
+	int i;
+
+	sum->adc += r->adc;
+	sum->shared += r->shared;
+	for (i = 0; i < CALS; i++)
+		sum->cals[i] += r->cals[i];
+	sum->rf_err += r->rf_err;
+	sum->trim_err += r->trim_err;
+	sum->over_s += r->over_s;
+}
+
+static void print_result(const char *profile, const char *policy, const struct result *r,
+			 double hours)
+{
+	printf("%-14s %-10s %8.0f %6.0f/h %6.0f %6.0f %6.0f %8.1f %8.2f %8.1f\n",
+	       profile, policy, (double)r->adc / runs, r->adc / hours / runs,
+	       (double)r->shared / runs, (double)r->cals[CAL_RF] / runs,
+	       (double)r->cals[CAL_XTAL] / runs, r->rf_err / runs, r->trim_err / runs,
+	       r->over_s / runs);
+}
+
+/*
+ * The predictive scheduler is worse than the fixed sampling if one of the means is worse
+ * at the resolution of the report. The worst errors come from the sensor noise as much
+ * as from the sampling, hence the means of several runs.
+ */
+static int check_result(const char *profile, const struct result *fixed,
+			const struct result *pred)
+{
+	int errors = 0;
+	int i;
+
+	if (pred->rf_err > fixed->rf_err + 0.05 * runs) {
+		printf("%-14s predictive RF drift worse than fixed\n", profile);
+		errors++;
+	}
+	if (pred->over_s > fixed->over_s + 0.05 * runs) {
+		printf("%-14s predictive longer beyond the RF threshold than fixed\n", profile);
+		errors++;
+	}
+	for (i = 0; i < CALS; i++) {
+		if (pred->cals[i] > fixed->cals[i] + runs / 2) {
+			printf("%-14s predictive runs more %s calibrations than fixed\n", profile,
+			       (i == CAL_RF) ? "RF" : "XTAL32M");
+			errors++;
+		}
+	}
+	return errors;
+}
+
+int main(int argc, char **argv)
+{
+	struct profile *profiles;
+	struct result fixed, pred, r;
+	unsigned int nb, i, k;
+	int opt, errors = 0;
+
+	while ((opt = getopt(argc, argv, "n:a:r:s:")) != -1) {
+		switch (opt) {
+		case 'n':
+			noise = atof(optarg);
+			break;
+		case 'a':
+			share_s = strtoul(optarg, NULL, 0);
+			break;
+		case 'r':
+			runs = strtoul(optarg, NULL, 0);
+			if (!runs)
+				runs = 1;
+			break;
+		case 's':
+			seed = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	nb = (optind < argc) ? argc - optind : 4;
+	profiles = calloc(nb, sizeof(*profiles));
+	if (!profiles) {
+		perror("calloc");
+		return EXIT_FAILURE;
+	}
+	if (optind < argc) {
+		for (i = 0; i < nb; i++)
+			if (profile_load(&profiles[i], argv[optind + i]))
+				return EXIT_FAILURE;
+	} else {
+		profile_stable(&profiles[0]);
+		profile_diurnal(&profiles[1]);
+		profile_transient(&profiles[2]);
+		profile_cycling(&profiles[3]);
+	}
+
+	printf("Intervals %u..%u ms, %u ms in the last degree, RF threshold %u C, "
+	       "XTAL32M threshold %u C\nnoise %.2f C, means of %u runs\n\n",
+	       CAL_SCHED_MIN_INTERVAL_MS, CAL_SCHED_MAX_INTERVAL_MS, CAL_SCHED_LAST_INTERVAL_MS,
+	       RF_DIFF, XTAL_DIFF, noise, runs);
+	printf("%-14s %-10s %8s %8s %6s %6s %6s %8s %8s %8s\n", "profile", "policy", "adc", "",
+	       "shared", "rf", "xtal", "rf_err C", "trim_err", "over s");
+	for (i = 0; i < nb; i++) {
+		double hours = (double)profiles[i].len * STEP_SLOTS / SLOTS_PER_S / 3600;
+
+		memset(&fixed, 0, sizeof(fixed));
+		memset(&pred, 0, sizeof(pred));
+		for (k = 0; k < runs; k++) {
+			/* Both policies read the sensor with the same noise sequence */
+			rnd_state = (seed + k) ? (seed + k) : 1;
+			run_fixed(&profiles[i], &r);
+			result_add(&fixed, &r);
+			rnd_state = (seed + k) ? (seed + k) : 1;
+			run_predictive(&profiles[i], &r);
+			result_add(&pred, &r);
+		}
+		print_result(profiles[i].name, "fixed 2s", &fixed, hours);
+		print_result(profiles[i].name, "predictive", &pred, hours);
+		errors += check_result(profiles[i].name, &fixed, &pred);
+		free(profiles[i].temp);
+	}
+	free(profiles);
+
+	return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,686 @@
+/**
+ ****************************************************************************************
+ *
+ * @file console_bench.c
+ *
+ * @brief Console backend checks and throughput benchmark.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "arch_api.h"
+#include "arch_console.h"
+#include "ke_mem.h"
+#include "uart.h"
+
+#define CONSOLE_BENCH_VERSION	"v_1.0"
+
+/* Kernel heap model, as in heap_replay: block descriptors and first fit from the end */
+#define USED_DESC_SIZE		4
+#define FREE_DESC_SIZE		12
+#define HEAP_SIZE_MAX		0x10000
+#define DEFAULT_HEAP_SIZE	1024
+
+#define STEP_US			1000
+#define DRAIN_STEPS_MAX		100000
+#define MSG_MAX			64
+
+/* The backends: arch_console.c built with one configuration, its entry points renamed */
+int list_arch_printf(const char *fmt, ...);
+void list_arch_printf_process(void);
+int ring_arch_printf(const char *fmt, ...);
+void ring_arch_printf_process(void);
+uint32_t ring_arch_printf_dropped(void);
+int deferred_arch_printf(const char *fmt, ...);
+void deferred_arch_printf_process(void);
+uint32_t deferred_arch_printf_dropped(void);
+
+struct backend {
+	const char *name;
+	int (*printf)(const char *fmt, ...);
+	void (*process)(void);
+	uint32_t (*dropped)(void);
+	bool deferred;
+};
+
+static const struct backend backends[] = {
+	{ "list", list_arch_printf, list_arch_printf_process, NULL, false },
+	{ "ring", ring_arch_printf, ring_arch_printf_process, ring_arch_printf_dropped, false },
+	{ "deferred", deferred_arch_printf, deferred_arch_printf_process, deferred_arch_printf_dropped, true },
+};
+
+#define BACKEND_NUM		(sizeof(backends) / sizeof(backends[0]))
+
+/* The messages of the workload: typical application traces */
+struct msg {
+	int type;
+	uint32_t arg[2];
+	const char *str;
+};
+
+static const char * const formats[] = {
+	"rssi %d dBm\n",
+	"conn %u evt %u\n",
+	"adc %04x %04x\n",
+	"%s: state %d\n",
+	"bond %08x %08x\n",
+};
+
+#define FORMAT_NUM		(sizeof(formats) / sizeof(formats[0]))
+
+static const char * const names[] = { "app", "suotar", "custs1" };
+
+struct blk {
+	uint16_t offset;
+	uint16_t size;
+};
+
+/* Model of the non retained heap. Its free list is in address order, its first block is never unlinked. */
+struct heap {
+	uint32_t size;
+	struct blk free[HEAP_SIZE_MAX / FREE_DESC_SIZE + 1];
+	int nb_free;
+};
+
+/* A message accepted by the console, until its last byte is on the line */
+struct pending {
+	uint64_t end;
+	uint64_t time_us;
+};
+
+struct result {
+	uint32_t msgs;
+	uint32_t dropped;
+	double producer_ns;
+	uint32_t mallocs;
+	uint32_t heap_peak;
+	uint32_t blocks_peak;
+	uint32_t heap_over;
+	uint32_t transfers;
+	double bytes_per_msg;
+	double latency_ms;
+	double latency_max_ms;
+	double active;
+};
+
+static uint32_t rate = 400;
+static uint32_t burst = 32;
+static uint32_t duration_ms = 10000;
+static uint32_t baud = 115200;
+static uint32_t heap_size = DEFAULT_HEAP_SIZE;
+static uint32_t seed = 1;
+static int errors;
+
+static uint64_t sim_us;
+
+/* Simulated UART: one transfer at a time, 10 bits per byte */
+uart_t host_uart1, host_uart2;
+static uart_cb_t tx_cb;
+static bool tx_active;
+static uint64_t tx_start_us;
+static uint64_t tx_start_offset;
+static uint64_t tx_end_us;
+static uint16_t tx_len;
+static uint32_t transfers;
+
+/* What the UART sent, and what it should have sent */
+static uint8_t *out;
+static uint64_t out_len;
+static uint8_t *expected;
+static uint64_t expected_len;
+static uint64_t buf_size;
+
+static struct pending *pendings;
+static uint32_t pending_head, pending_tail, pending_size;
+static double latency_sum;
+static uint64_t latency_max;
+static uint32_t latency_cnt;
+
+/* Sleep mode */
+static bool forced_active;
+static uint64_t active_since;
+static uint64_t active_us;
+
+/* Non retained heap */
+static struct heap heap;
+static uint8_t heap_mem[HEAP_SIZE_MAX] __attribute__((aligned(8)));
+static uint32_t heap_used, heap_blocks;
+static uint32_t heap_peak, blocks_peak;
+static uint32_t mallocs, heap_over;
+
+static void usage(const char* my_name)
+{
+	fprintf(stderr,
+		"Version: " CONSOLE_BENCH_VERSION "\n"
+		"\n"
+		"Usage: %s [-r msgs_per_s] [-B burst] [-t ms] [-b baud] [-s heap_size] [-S seed]\n"
+		"\n"
+		"  Runs the console of this tree with its three backends: the list of heap\n"
+		"  allocated messages (default), the ring buffer (CFG_PRINTF_RING_BUFFER) and the\n"
+		"  deferred records (CFG_PRINTF_DEFERRED). The application prints 'msgs_per_s'\n"
+		"  messages per second, plus a burst of 'burst' messages every second, for 'ms'\n"
+		"  milliseconds, and calls arch_printf_process() every millisecond. The UART is\n"
+		"  simulated at 'baud', the non retained heap is modelled with 'heap_size' bytes.\n"
+		"\n"
+		"  Checks that every message accepted is sent once, in order, and reports the\n"
+		"  host time of arch_printf(), the heap use, the messages dropped, the UART\n"
+		"  transfers, the bytes per message, the latency to the line and the share of\n"
+		"  the time the system is kept active.\n"
+		"\n"
+		"  The heap sizes are the ones of this host, whose pointers may be wider than\n"
+		"  the ones of the target.\n"
+		"\n", my_name);
+}
+
+static uint32_t rnd(void)
+{
+	seed = seed * 1103515245 + 12345;
+	return seed >> 1;
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void expect(bool ok, const char *what)
+{
+	if (!ok) {
+		fprintf(stderr, "FAILED: %s\n", what);
+		errors++;
+	}
+}
+
+/*
+ * Non retained heap model
+ */
+
+static void heap_init(struct heap *heap, uint32_t size)
+{
+	memset(heap, 0, sizeof(*heap));
+	heap->size = size & ~3u;
+	heap->free[0].offset = 0;
+	heap->free[0].size = heap->size;
+	heap->nb_free = 1;
+}
+
+/* Take a block of 'total' bytes from a heap, return its offset or -1 */
+static int heap_take(struct heap *heap, uint16_t total, uint16_t *block)
+{
+	int i;
+
+	for (i = 0; i < heap->nb_free; i++) {
+		struct blk *b = &heap->free[i];
+
+		if (b->size >= total + FREE_DESC_SIZE) {
+			/* the free block keeps its descriptor, the block is cut from its end */
+			b->size -= total;
+			*block = total;
+			return b->offset + b->size;
+		}
+
+		if (i && b->size >= total) {
+			/* the whole free block is taken */
+			int offset = b->offset;
+
+			*block = b->size;
+			memmove(b, b + 1, (heap->nb_free - i - 1) * sizeof(*b));
+			heap->nb_free--;
+			return offset;
+		}
+	}
+
+	return -1;
+}
+
+static void heap_give(struct heap *heap, uint16_t offset, uint16_t size)
+{
+	struct blk *prev, *next;
+	int i;
+
+	/* the first free block is at the base, so every block has a previous free block */
+	for (i = 1; i < heap->nb_free && heap->free[i].offset < offset; i++)
+		;
+
+	prev = &heap->free[i - 1];
+	next = i < heap->nb_free ? &heap->free[i] : NULL;
+
+	if (prev->offset + prev->size == offset) {
+		prev->size += size;
+		if (next && prev->offset + prev->size == next->offset) {
+			prev->size += next->size;
+			memmove(next, next + 1, (heap->nb_free - i - 1) * sizeof(*next));
+			heap->nb_free--;
+		}
+		return;
+	}
+
+	if (next && offset + size == next->offset) {
+		next->offset = offset;
+		next->size += size;
+		return;
+	}
+
+	memmove(&heap->free[i + 1], &heap->free[i], (heap->nb_free - i) * sizeof(*next));
+	heap->free[i].offset = offset;
+	heap->free[i].size = size;
+	heap->nb_free++;
+}
+
+/*
+ * Platform
+ */
+
+void *ke_malloc(uint32_t size, uint8_t type)
+{
+	uint16_t total = ((size + 3) & ~3u) + USED_DESC_SIZE;
+	uint16_t block;
+	int offset;
+
+	mallocs++;
+
+	if (total < FREE_DESC_SIZE)
+		total = FREE_DESC_SIZE;
+
+	offset = heap_take(&heap, total, &block);
+	if (offset < 0) {
+		/* the kernel takes it from another heap, the block is not in the model */
+		heap_over++;
+		return malloc(size);
+	}
+
+	*(uint16_t *) &heap_mem[offset] = block;
+	heap_used += block;
+	heap_blocks++;
+	if (heap_used > heap_peak)
+		heap_peak = heap_used;
+	if (heap_blocks > blocks_peak)
+		blocks_peak = heap_blocks;
+
+	return &heap_mem[offset + USED_DESC_SIZE];
+}
+
+void ke_free(void *mem_ptr)
+{
+	uint16_t offset;
+	uint16_t block;
+
+	if ((uint8_t *) mem_ptr < heap_mem || (uint8_t *) mem_ptr >= heap_mem + sizeof(heap_mem)) {
+		free(mem_ptr);
+		return;
+	}
+
+	offset = (uint8_t *) mem_ptr - heap_mem - USED_DESC_SIZE;
+	block = *(uint16_t *) &heap_mem[offset];
+	heap_used -= block;
+	heap_blocks--;
+	heap_give(&heap, offset, block);
+}
+
+void arch_force_active_mode(void)
+{
+	if (!forced_active) {
+		forced_active = true;
+		active_since = sim_us;
+	}
+}
+
+void arch_restore_sleep_mode(void)
+{
+	if (forced_active) {
+		forced_active = false;
+		active_us += sim_us - active_since;
+	}
+}
+
+void uart_register_tx_cb(uart_t *uart_id, uart_cb_t cb)
+{
+	tx_cb = cb;
+}
+
+void uart_send(uart_t *uart_id, const uint8_t *data, uint16_t len, UART_OP_CFG op)
+{
+	expect(uart_id == UART2, "console on UART2");
+	expect(!tx_active, "one UART transfer at a time");
+	expect(len > 0, "UART transfer not empty");
+
+	if (out_len + len > buf_size) {
+		expect(false, "UART output within the expected output");
+		len = buf_size - out_len;
+	}
+	tx_start_offset = out_len;
+	memcpy(&out[out_len], data, len);
+	out_len += len;
+
+	tx_active = true;
+	tx_len = len;
+	tx_start_us = sim_us;
+	tx_end_us = sim_us + (uint64_t) len * 10 * 1000000 / baud;
+	transfers++;
+}
+
+void uart_wait_tx_finish(uart_t *uart_id)
+{
+}
+
+/* Run the UART until 'until_us', calling the console back at the end of each transfer */
+static void uart_run(uint64_t until_us)
+{
+	while (tx_active && tx_end_us <= until_us) {
+		sim_us = tx_end_us;
+		tx_active = false;
+
+		/* the messages of the transfer, on the line when their last byte is */
+		while (pending_tail != pending_head && pendings[pending_tail % pending_size].end <= out_len) {
+			const struct pending *p = &pendings[pending_tail % pending_size];
+			uint64_t latency = tx_start_us + (p->end - tx_start_offset) * 10 * 1000000 / baud - p->time_us;
+
+			latency_sum += latency;
+			latency_cnt++;
+			if (latency > latency_max)
+				latency_max = latency;
+			pending_tail++;
+		}
+
+		tx_cb(tx_len);
+	}
+	sim_us = until_us;
+}
+
+/*
+ * Workload
+ */
+
+static void make_msg(struct msg *m)
+{
+	m->type = rnd() % FORMAT_NUM;
+	switch (m->type) {
+	case 0:
+		m->arg[0] = -(int32_t)(rnd() % 90);
+		break;
+	case 1:
+		m->arg[0] = rnd() % 8;
+		m->arg[1] = rnd() & 0xFFFF;
+		break;
+	case 2:
+		m->arg[0] = rnd() & 0xFFF;
+		m->arg[1] = rnd() & 0xFFF;
+		break;
+	case 3:
+		m->str = names[rnd() % 3];
+		m->arg[0] = rnd() % 6;
+		break;
+	default:
+		m->arg[0] = rnd();
+		m->arg[1] = rnd();
+		break;
+	}
+}
+
+static void print_msg(const struct backend *b, const struct msg *m)
+{
+	const char *fmt = formats[m->type];
+
+	switch (m->type) {
+	case 0:
+		b->printf(fmt, (int32_t) m->arg[0]);
+		break;
+	case 3:
+		b->printf(fmt, m->str, m->arg[0]);
+		break;
+	default:
+		b->printf(fmt, m->arg[0], m->arg[1]);
+		break;
+	}
+}
+
+static void put_le32(uint8_t *p, uint32_t val)
+{
+	p[0] = (uint8_t) val;
+	p[1] = (uint8_t)(val >> 8);
+	p[2] = (uint8_t)(val >> 16);
+	p[3] = (uint8_t)(val >> 24);
+}
+
+/* The bytes a message should put on the line: its text or its deferred record */
+static int expected_msg(const struct backend *b, const struct msg *m, uint8_t *buf)
+{
+	const char *fmt = formats[m->type];
+	uint8_t *p = buf + ARCH_PRINTF_DEFERRED_HDR_LEN;
+
+	if (!b->deferred) {
+		switch (m->type) {
+		case 0:
+			return snprintf((char *) buf, MSG_MAX, fmt, (int32_t) m->arg[0]);
+		case 3:
+			return snprintf((char *) buf, MSG_MAX, fmt, m->str, m->arg[0]);
+		default:
+			return snprintf((char *) buf, MSG_MAX, fmt, m->arg[0], m->arg[1]);
+		}
+	}
+
+	if (m->type == 3) {
+		*p++ = strlen(m->str);
+		memcpy(p, m->str, strlen(m->str));
+		p += strlen(m->str);
+		put_le32(p, m->arg[0]);
+		p += 4;
+	} else {
+		put_le32(p, m->arg[0]);
+		p += 4;
+		if (m->type != 0) {
+			put_le32(p, m->arg[1]);
+			p += 4;
+		}
+	}
+	buf[0] = ARCH_PRINTF_DEFERRED_MARKER;
+	put_le32(&buf[1], (uint32_t)(uintptr_t) fmt);
+	buf[5] = p - buf - ARCH_PRINTF_DEFERRED_HDR_LEN;
+
+	return p - buf;
+}
+
+static void run(const struct backend *b, struct result *res)
+{
+	uint32_t start_seed = seed;
+	uint32_t acc = 0, drain = 0;
+	uint64_t producer_ns = 0;
+	uint32_t t;
+
+	sim_us = 0;
+	tx_active = false;
+	tx_cb = NULL;
+	transfers = 0;
+	out_len = expected_len = 0;
+	pending_head = pending_tail = 0;
+	latency_sum = 0;
+	latency_max = 0;
+	latency_cnt = 0;
+	forced_active = false;
+	active_us = 0;
+	heap_init(&heap, heap_size);
+	heap_used = heap_blocks = heap_peak = blocks_peak = mallocs = heap_over = 0;
+	memset(res, 0, sizeof(*res));
+
+	for (t = 0; t < duration_ms || drain < DRAIN_STEPS_MAX; t++) {
+		uint32_t n = 0;
+		uint32_t i;
+
+		if (t < duration_ms) {
+			acc += rate;
+			n = acc / 1000;
+			acc %= 1000;
+			if (t % 1000 == 500)
+				n += burst;
+		} else {
+			/* after the workload, until the console is drained */
+			if (!tx_active && !forced_active && pending_tail == pending_head)
+				break;
+			drain++;
+		}
+
+		for (i = 0; i < n; i++) {
+			uint8_t buf[MSG_MAX];
+			uint32_t dropped = b->dropped ? b->dropped() : 0;
+			struct msg m = { 0 };
+			uint64_t start;
+			int len;
+
+			make_msg(&m);
+			start = now_ns();
+			print_msg(b, &m);
+			producer_ns += now_ns() - start;
+			res->msgs++;
+
+			if (b->dropped && b->dropped() != dropped) {
+				res->dropped++;
+				continue;
+			}
+
+			len = expected_msg(b, &m, buf);
+			if (expected_len + len > buf_size) {
+				expect(false, "output buffer large enough");
+				break;
+			}
+			memcpy(&expected[expected_len], buf, len);
+			expected_len += len;
+			if (pending_head - pending_tail == pending_size) {
+				expect(false, "pending messages");
+				break;
+			}
+			pendings[pending_head % pending_size].end = expected_len;
+			pendings[pending_head % pending_size].time_us = sim_us;
+			pending_head++;
+		}
+
+		b->process();
+		uart_run(sim_us + STEP_US);
+	}
+
+	expect(drain < DRAIN_STEPS_MAX, "console drained");
+	expect(out_len == expected_len && memcmp(out, expected, out_len) == 0,
+	       "every accepted message sent once, in order");
+	expect(heap_used == 0, "heap freed");
+	if (forced_active)
+		arch_restore_sleep_mode();
+
+	res->producer_ns = res->msgs ? (double) producer_ns / res->msgs : 0;
+	res->mallocs = mallocs;
+	res->heap_peak = heap_peak;
+	res->blocks_peak = blocks_peak;
+	res->heap_over = heap_over;
+	res->transfers = transfers;
+	res->bytes_per_msg = res->msgs > res->dropped ? (double) out_len / (res->msgs - res->dropped) : 0;
+	res->latency_ms = latency_cnt ? latency_sum / latency_cnt / 1000 : 0;
+	res->latency_max_ms = (double) latency_max / 1000;
+	res->active = sim_us ? 100.0 * active_us / sim_us : 0;
+
+	seed = start_seed;
+}
+
+int main(int argc, char **argv)
+{
+	struct result res[BACKEND_NUM];
+	unsigned int k;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "r:B:t:b:s:S:")) != -1) {
+		switch (opt) {
+		case 'r':
+			rate = strtoul(optarg, NULL, 0);
+			break;
+		case 'B':
+			burst = strtoul(optarg, NULL, 0);
+			break;
+		case 't':
+			duration_ms = strtoul(optarg, NULL, 0);
+			break;
+		case 'b':
+			baud = strtoul(optarg, NULL, 0);
+			break;
+		case 's':
+			heap_size = strtoul(optarg, NULL, 0);
+			break;
+		case 'S':
+			seed = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	if (optind != argc || duration_ms == 0 || baud == 0 || heap_size < 64 || heap_size >= HEAP_SIZE_MAX) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	/* every message could be printed, and none sent before the end */
+	pending_size = (uint64_t) duration_ms * rate / 1000 + (duration_ms / 1000 + 1) * burst + 1;
+	buf_size = (uint64_t) pending_size * MSG_MAX;
+	out = malloc(buf_size);
+	expected = malloc(buf_size);
+	pendings = malloc(pending_size * sizeof(*pendings));
+	if (out == NULL || expected == NULL || pendings == NULL) {
+		fprintf(stderr, "Out of memory\n");
+		return EXIT_FAILURE;
+	}
+
+	for (k = 0; k < BACKEND_NUM; k++)
+		run(&backends[k], &res[k]);
+
+	printf("%u msgs/s, burst %u/s, %u ms, %u baud, heap %u bytes, ring %u bytes\n",
+	       rate, burst, duration_ms, baud, heap_size, CFG_PRINTF_RING_BUFFER_SIZE);
+	printf("%-9s %7s %7s %6s %8s %9s %7s %6s %9s %8s %9s %9s %7s\n", "backend", "msgs", "dropped",
+	       "ns/msg", "mallocs", "heap peak", "blocks", "over", "transfers", "B/msg", "lat ms",
+	       "lat max", "active");
+	for (k = 0; k < BACKEND_NUM; k++)
+		printf("%-9s %7u %7u %6.1f %8u %9u %7u %6u %9u %8.2f %9.2f %9.2f %6.1f%%\n", backends[k].name,
+		       res[k].msgs, res[k].dropped, res[k].producer_ns, res[k].mallocs, res[k].heap_peak,
+		       res[k].blocks_peak, res[k].heap_over, res[k].transfers, res[k].bytes_per_msg,
+		       res[k].latency_ms, res[k].latency_max_ms, res[k].active);
+
+	free(out);
+	free(expected);
+	free(pendings);
+
+	if (errors) {
+		printf("\nFAILED, %d errors\n", errors);
+		return EXIT_FAILURE;
+	}
+	printf("\nOK\n");
+
+	return EXIT_SUCCESS;
+}
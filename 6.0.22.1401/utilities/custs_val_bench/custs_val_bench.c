@@ -0,0 +1,1014 @@
+/**
+ ****************************************************************************************
+ *
+ * @file custs_val_bench.c
+ *
+ * @brief Custom profile value store checks and benchmark.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "co_list.h"
+#include "ke_mem.h"
+#include "ke_msg.h"
+#include "ke_task.h"
+#include "attm.h"
+#include "attm_db.h"
+#include "attm_db_128.h"
+#include "prf.h"
+#include "prf_types.h"
+#include "gattc_task.h"
+#include "custs1_task.h"
+#include "app_prf_types.h"
+
+#define CUSTS_VAL_BENCH_VERSION	"v_1.0"
+
+/* Kernel heap model, as in heap_replay: block descriptors and first fit from the end */
+#define USED_DESC_SIZE		4
+#define FREE_DESC_SIZE		12
+#define DB_HEAP_SIZE_MAX	0x10000
+#define DEFAULT_DB_HEAP_SIZE	4096
+
+/* Tasks of the benchmark: the profile and the application */
+#define BENCH_PRF_TASK		0x20
+#define BENCH_APP_TASK		0x21
+/* First handle of the custom profile in the attribute database */
+#define BENCH_START_HDL		0x0010
+
+/* Allocations of the other tasks, interleaved with the profile ones */
+#define OTHER_MAX		8
+#define OTHER_SIZE_MIN		8
+#define OTHER_SIZE_MAX		96
+
+#define SVC_MAX			8
+
+/* The database of ble_app_peripheral, see user_custs1_def.c */
+extern const struct attm_desc_128 custs1_att_db[];
+extern const uint8_t custs1_services[];
+extern const uint8_t custs1_services_size;
+extern const uint16_t custs1_att_max_nb;
+
+/* A variant of the profile: custs1 of this tree or of REF_REV, its symbols renamed */
+struct variant {
+	const char *name;
+	const struct prf_task_cbs *(*itf_get)(void);
+	const struct ke_state_handler *handler;
+	void (*set_ccc_value)(uint8_t conidx, uint8_t att_idx, uint16_t ccc);
+};
+
+const struct prf_task_cbs *new_custs1_prf_itf_get(void);
+const struct prf_task_cbs *ref_custs1_prf_itf_get(void);
+extern const struct ke_state_handler new_custs1_default_handler;
+extern const struct ke_state_handler ref_custs1_default_handler;
+void new_custs1_set_ccc_value(uint8_t conidx, uint8_t att_idx, uint16_t ccc);
+void ref_custs1_set_ccc_value(uint8_t conidx, uint8_t att_idx, uint16_t ccc);
+
+static const struct variant variants[] = {
+	{ "reference", ref_custs1_prf_itf_get, &ref_custs1_default_handler, ref_custs1_set_ccc_value },
+	{ "store", new_custs1_prf_itf_get, &new_custs1_default_handler, new_custs1_set_ccc_value },
+};
+
+struct blk {
+	uint16_t offset;
+	uint16_t size;
+};
+
+/* Model of the database heap. Its free list is in address order, its first block is never unlinked. */
+struct heap {
+	uint32_t size;
+	struct blk free[DB_HEAP_SIZE_MAX / FREE_DESC_SIZE + 1];
+	int nb_free;
+};
+
+/* Descriptor of a used block, in front of the data */
+struct used_desc {
+	uint16_t block;
+	uint8_t owner;
+	uint8_t pad;
+};
+
+enum {
+	OWNER_ATTM,
+	OWNER_PROFILE,
+	OWNER_OTHER,
+};
+
+/* Results of one variant */
+struct result {
+	/* database heap, after the service is created, averaged over the cycles */
+	double prf_blocks;
+	double prf_bytes;
+	double free_blocks;
+	double largest;
+	uint32_t min_largest;
+	uint32_t fails;
+	/* hot path, per operation */
+	double write_ns;
+	double read_ns;
+	double ntf_ns;
+	double value_ns;
+	uint64_t hot_mallocs;
+	/* what the peer and the application received */
+	uint32_t read_sum;
+	uint32_t evts;
+	uint32_t cfms;
+	uint32_t write_inds;
+	uint32_t write_bytes;
+};
+
+static uint32_t db_heap_size = DEFAULT_DB_HEAP_SIZE;
+static uint32_t cycles = 1000;
+static uint32_t ops = 200000;
+static uint32_t seed = 1;
+static int errors;
+
+static struct heap db_heap;
+static uint8_t db_mem[DB_HEAP_SIZE_MAX] __attribute__((aligned(8)));
+static uint8_t owner = OWNER_ATTM;
+static uint32_t prf_blocks;
+static uint32_t prf_bytes;
+static uint32_t db_fails;
+static uint64_t mallocs;
+
+static struct prf_task_env task_env;
+static ke_state_t prf_state;
+
+/* The attribute database: the services created by the profile */
+static struct {
+	struct attm_svc *svc;
+	const struct attm_desc_128 *att_db;
+} svcs[SVC_MAX];
+static int nb_svcs;
+
+/* Messages sent by the profile */
+static uint32_t sent_evts;
+static uint32_t sent_cfms;
+static uint32_t sent_read_cfms;
+static uint32_t sent_write_inds;
+static uint32_t sent_write_bytes;
+static uint16_t read_value;
+static uint8_t write_status;
+
+static void usage(const char* my_name)
+{
+	fprintf(stderr,
+		"Version: " CUSTS_VAL_BENCH_VERSION "\n"
+		"\n"
+		"Usage: %s [-c cycles] [-n operations] [-s db_heap_size] [-S seed]\n"
+		"\n"
+		"  Runs the custom profile of this tree, which keeps its values in a\n"
+		"  custs_val_store, and the one of the reference revision (see 'make bench'),\n"
+		"  which keeps them in a list, on the database of ble_app_peripheral.\n"
+		"\n"
+		"  Creates and destroys the profile 'cycles' times, between allocations of\n"
+		"  other tasks, in a model of the database heap of 'db_heap_size' bytes and\n"
+		"  reports the profile blocks, the free blocks and the largest free block.\n"
+		"  Then runs 'operations' CCC writes, CCC reads, notifications and writes of\n"
+		"  random length to the writable characteristic values through the task\n"
+		"  handlers and reports the host time and the heap allocations of each.\n"
+		"  Checks that both variants answer the peer and the application the same.\n"
+		"\n"
+		"  The sizes are the ones of this host, whose pointers may be wider than the\n"
+		"  ones of the target.\n"
+		"\n", my_name);
+}
+
+static uint32_t rnd(void)
+{
+	seed = seed * 1103515245 + 12345;
+	return seed >> 1;
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void expect(bool ok, const char *what)
+{
+	if (!ok) {
+		fprintf(stderr, "FAILED: %s\n", what);
+		errors++;
+	}
+}
+
+/*
+ * Database heap model
+ */
+
+static void heap_init(struct heap *heap, uint32_t size)
+{
+	memset(heap, 0, sizeof(*heap));
+	heap->size = size & ~3u;
+	heap->free[0].offset = 0;
+	heap->free[0].size = heap->size;
+	heap->nb_free = 1;
+}
+
+static uint16_t heap_largest(const struct heap *heap)
+{
+	uint16_t largest = 0;
+	int i;
+
+	for (i = 0; i < heap->nb_free; i++)
+		if (heap->free[i].size > largest)
+			largest = heap->free[i].size;
+	return largest;
+}
+
+/* Take a block of 'total' bytes from a heap, return its offset or -1 */
+static int heap_take(struct heap *heap, uint16_t total, uint16_t *block)
+{
+	int i;
+
+	for (i = 0; i < heap->nb_free; i++) {
+		struct blk *b = &heap->free[i];
+
+		if (b->size >= total + FREE_DESC_SIZE) {
+			/* the free block keeps its descriptor, the block is cut from its end */
+			b->size -= total;
+			*block = total;
+			return b->offset + b->size;
+		}
+
+		if (i && b->size >= total) {
+			/* the whole free block is taken */
+			int offset = b->offset;
+
+			*block = b->size;
+			memmove(b, b + 1, (heap->nb_free - i - 1) * sizeof(*b));
+			heap->nb_free--;
+			return offset;
+		}
+	}
+
+	return -1;
+}
+
+static void heap_give(struct heap *heap, uint16_t offset, uint16_t size)
+{
+	struct blk *prev, *next;
+	int i;
+
+	/* the first free block is at the base, so every block has a previous free block */
+	for (i = 1; i < heap->nb_free && heap->free[i].offset < offset; i++)
+		;
+
+	prev = &heap->free[i - 1];
+	next = i < heap->nb_free ? &heap->free[i] : NULL;
+
+	if (prev->offset + prev->size == offset) {
+		prev->size += size;
+		if (next && prev->offset + prev->size == next->offset) {
+			prev->size += next->size;
+			memmove(next, next + 1, (heap->nb_free - i - 1) * sizeof(*next));
+			heap->nb_free--;
+		}
+		return;
+	}
+
+	if (next && offset + size == next->offset) {
+		next->offset = offset;
+		next->size += size;
+		return;
+	}
+
+	memmove(&heap->free[i + 1], &heap->free[i], (heap->nb_free - i) * sizeof(*next));
+	heap->free[i].offset = offset;
+	heap->free[i].size = size;
+	heap->nb_free++;
+}
+
+static void *db_malloc(uint32_t size)
+{
+	uint16_t total = ((size + 3) & ~3u) + USED_DESC_SIZE;
+	struct used_desc *desc;
+	uint16_t block;
+	int offset;
+
+	if (total < FREE_DESC_SIZE)
+		total = FREE_DESC_SIZE;
+
+	offset = heap_take(&db_heap, total, &block);
+	if (offset < 0) {
+		db_fails++;
+		return NULL;
+	}
+
+	desc = (struct used_desc *) &db_mem[offset];
+	desc->block = block;
+	desc->owner = owner;
+	if (owner == OWNER_PROFILE) {
+		prf_blocks++;
+		prf_bytes += block;
+	}
+
+	return &db_mem[offset + USED_DESC_SIZE];
+}
+
+static void db_free(void *mem_ptr)
+{
+	uint16_t offset = (uint8_t *) mem_ptr - db_mem - USED_DESC_SIZE;
+	struct used_desc *desc = (struct used_desc *) &db_mem[offset];
+
+	if (desc->owner == OWNER_PROFILE) {
+		prf_blocks--;
+		prf_bytes -= desc->block;
+	}
+	heap_give(&db_heap, offset, desc->block);
+}
+
+/*
+ * Kernel
+ */
+
+void *ke_malloc(uint32_t size, uint8_t type)
+{
+	mallocs++;
+
+	if (type == KE_MEM_ATT_DB) {
+		void *mem_ptr = db_malloc(size);
+
+		/* the kernel asserts, as the profile does not handle it */
+		if (mem_ptr == NULL && owner != OWNER_OTHER) {
+			fprintf(stderr, "Database heap too small for the profile\n");
+			exit(EXIT_FAILURE);
+		}
+		return mem_ptr;
+	}
+
+	return malloc(size);
+}
+
+void ke_free(void *mem_ptr)
+{
+	if ((uint8_t *) mem_ptr >= db_mem && (uint8_t *) mem_ptr < db_mem + sizeof(db_mem))
+		db_free(mem_ptr);
+	else
+		free(mem_ptr);
+}
+
+void *ke_msg_alloc(ke_msg_id_t const id, ke_task_id_t const dest_id,
+		   ke_task_id_t const src_id, uint16_t const param_len)
+{
+	struct ke_msg *msg = calloc(1, sizeof(struct ke_msg) + param_len);
+
+	if (msg == NULL) {
+		fprintf(stderr, "Out of memory\n");
+		exit(EXIT_FAILURE);
+	}
+
+	msg->id = id;
+	msg->dest_id = dest_id;
+	msg->src_id = src_id;
+	msg->param_len = param_len;
+
+	return ke_msg2param(msg);
+}
+
+void ke_msg_send(void const *param_ptr)
+{
+	struct ke_msg *msg = ke_param2msg(param_ptr);
+
+	switch (msg->id) {
+	case GATTC_SEND_EVT_CMD:
+		sent_evts++;
+		break;
+	case GATTC_READ_CFM: {
+		const struct gattc_read_cfm *cfm = param_ptr;
+
+		sent_read_cfms++;
+		read_value = 0;
+		if (cfm->status == ATT_ERR_NO_ERROR && cfm->length == sizeof(read_value))
+			memcpy(&read_value, cfm->value, sizeof(read_value));
+		break;
+	}
+	case GATTC_WRITE_CFM:
+		write_status = ((const struct gattc_write_cfm *) param_ptr)->status;
+		break;
+	case CUSTS1_VAL_WRITE_IND:
+		sent_write_inds++;
+		sent_write_bytes += ((const struct custs1_val_write_ind *) param_ptr)->length;
+		break;
+	case CUSTS1_VAL_NTF_CFM:
+	case CUSTS1_VAL_IND_CFM:
+		sent_cfms++;
+		break;
+	default:
+		break;
+	}
+
+	free(msg);
+}
+
+ke_state_t ke_state_get(ke_task_id_t const id)
+{
+	return prf_state;
+}
+
+void ke_state_set(ke_task_id_t const id, ke_state_t const state_id)
+{
+	prf_state = state_id;
+}
+
+void co_list_init(struct co_list *list)
+{
+	memset(list, 0, sizeof(*list));
+}
+
+void co_list_push_back(struct co_list *list, struct co_list_hdr *list_hdr)
+{
+	if (list->first == NULL)
+		list->first = list_hdr;
+	else
+		list->last->next = list_hdr;
+	list->last = list_hdr;
+	list_hdr->next = NULL;
+}
+
+struct co_list_hdr *co_list_pop_front(struct co_list *list)
+{
+	struct co_list_hdr *element = list->first;
+
+	if (element != NULL) {
+		list->first = element->next;
+		if (list->first == NULL)
+			list->last = NULL;
+	}
+	return element;
+}
+
+bool co_list_extract(struct co_list *list, struct co_list_hdr *list_hdr, uint8_t nb_following)
+{
+	struct co_list_hdr *prev = NULL;
+	struct co_list_hdr *scan = list->first;
+	struct co_list_hdr *last = list_hdr;
+
+	while (scan != NULL && scan != list_hdr) {
+		prev = scan;
+		scan = scan->next;
+	}
+	if (scan == NULL)
+		return false;
+
+	while (nb_following-- && last->next != NULL)
+		last = last->next;
+
+	if (prev == NULL)
+		list->first = last->next;
+	else
+		prev->next = last->next;
+	if (list->last == last)
+		list->last = prev;
+
+	return true;
+}
+
+/*
+ * Profile framework
+ */
+
+prf_env_t *prf_env_get(uint16_t prf_id)
+{
+	return task_env.env;
+}
+
+ke_task_id_t prf_src_task_get(prf_env_t *env, uint8_t conidx)
+{
+	ke_task_id_t task = PERM_GET(env->prf_task, PRF_TASK);
+
+	if (PERM_GET(env->prf_task, PRF_MI))
+		task = KE_BUILD_ID(task, conidx);
+
+	return task;
+}
+
+ke_task_id_t prf_dst_task_get(prf_env_t *env, uint8_t conidx)
+{
+	ke_task_id_t task = PERM_GET(env->app_task, PRF_TASK);
+
+	if (PERM_GET(env->app_task, PRF_MI))
+		task = KE_BUILD_ID(task, conidx);
+
+	return task;
+}
+
+static const struct cust_prf_func_callbacks custs1_callbacks = {
+	.task_id = TASK_ID_CUSTS1,
+	.att_db = custs1_att_db,
+	.max_nb_att = 0,
+};
+
+const struct cust_prf_func_callbacks *custs_get_func_callbacks(enum KE_API_ID task_id)
+{
+	return task_id == TASK_ID_CUSTS1 ? &custs1_callbacks : NULL;
+}
+
+/*
+ * Attribute database: one block per service, as allocated by attmdb_svc_init(), with the
+ * attribute descriptions, the 128 bits UUIDs and the values stored in the database.
+ */
+
+uint8_t attm_svc_create_db_128(uint8_t svc_idx, uint16_t *shdl, uint8_t *cfg_flag, uint8_t max_nb_att,
+			       uint8_t *att_tbl, ke_task_id_t const dest_id,
+			       const struct attm_desc_128 *att_db, uint8_t svc_perm)
+{
+	int nb_att = max_nb_att - svc_idx;
+	uint32_t size = sizeof(struct attm_svc) + nb_att * sizeof(struct attm_att_desc);
+	struct attm_svc *svc;
+	int i;
+
+	for (i = 0; i < nb_att; i++) {
+		const struct attm_desc_128 *att = &att_db[svc_idx + i];
+
+		if (att->uuid_size == ATT_UUID_128_LEN)
+			size += ATT_UUID_128_LEN;
+		if (i && PERM_GET(att->max_length, RI) == 0 && att->max_length)
+			size += sizeof(struct attm_att_value) + ((att->max_length + 3) & ~3u);
+	}
+
+	if (nb_svcs == SVC_MAX)
+		return ATT_ERR_INSUFF_RESOURCE;
+
+	owner = OWNER_ATTM;
+	svc = ke_malloc(size, KE_MEM_ATT_DB);
+	owner = OWNER_PROFILE;
+
+	memset(svc, 0, sizeof(*svc));
+	svc->svc.start_hdl = *shdl;
+	svc->svc.end_hdl = *shdl + nb_att - 1;
+	svc->svc.task_id = dest_id;
+	svc->svc.perm = svc_perm;
+	svc->svc.nb_att = nb_att - 1;
+	for (i = 0; i < nb_att; i++) {
+		svc->atts[i].uuid = att_db[svc_idx + i].uuid_size == ATT_UUID_16_LEN ?
+				    *(uint16_t *) att_db[svc_idx + i].uuid : 0;
+		svc->atts[i].perm = att_db[svc_idx + i].perm;
+		svc->atts[i].info.max_lengh = att_db[svc_idx + i].max_length;
+	}
+
+	svcs[nb_svcs].svc = svc;
+	svcs[nb_svcs].att_db = &att_db[svc_idx];
+	nb_svcs++;
+
+	return ATT_ERR_NO_ERROR;
+}
+
+/* Database reset, as done by attmdb_destroy() */
+static void attmdb_reset(void)
+{
+	while (nb_svcs)
+		db_free(svcs[--nb_svcs].svc);
+}
+
+static int svc_find(uint16_t handle)
+{
+	int i;
+
+	for (i = 0; i < nb_svcs; i++)
+		if (handle >= svcs[i].svc->svc.start_hdl && handle <= svcs[i].svc->svc.end_hdl)
+			return i;
+	return -1;
+}
+
+struct attm_svc *attmdb_get_service(uint16_t handle)
+{
+	int i = svc_find(handle);
+
+	return i < 0 ? NULL : svcs[i].svc;
+}
+
+uint8_t attmdb_get_attribute(uint16_t handle, struct attm_elmt *elmt)
+{
+	int i = svc_find(handle);
+
+	if (i < 0)
+		return ATT_ERR_INVALID_HANDLE;
+
+	elmt->service = false;
+	elmt->info.att = &svcs[i].svc->atts[handle - svcs[i].svc->svc.start_hdl];
+	return ATT_ERR_NO_ERROR;
+}
+
+uint8_t attmdb_get_uuid(struct attm_elmt *elmt, uint8_t *uuid_len, uint8_t *uuid, bool srv_uuid, bool air)
+{
+	int i;
+
+	for (i = 0; i < nb_svcs; i++) {
+		struct attm_svc *svc = svcs[i].svc;
+		int idx = elmt->info.att - svc->atts;
+
+		if (idx >= 0 && idx <= svc->svc.end_hdl - svc->svc.start_hdl) {
+			const struct attm_desc_128 *att = &svcs[i].att_db[idx];
+
+			*uuid_len = att->uuid_size;
+			memcpy(uuid, att->uuid, att->uuid_size);
+			return ATT_ERR_NO_ERROR;
+		}
+	}
+
+	return ATT_ERR_INVALID_HANDLE;
+}
+
+uint8_t attmdb_att_get_permission(uint16_t handle, att_perm_type *perm, att_perm_type access_mask,
+				  struct attm_elmt *elmt)
+{
+	uint8_t status = attmdb_get_attribute(handle, elmt);
+
+	if (status == ATT_ERR_NO_ERROR)
+		*perm = elmt->info.att->perm;
+	return status;
+}
+
+uint8_t attmdb_att_set_value(uint16_t handle, att_size_t length, att_size_t offset, uint8_t *value)
+{
+	return ATT_ERR_NO_ERROR;
+}
+
+/*
+ * Drivers
+ */
+
+static bool is_ccc(int att_idx)
+{
+	return custs1_att_db[att_idx].uuid_size == ATT_UUID_16_LEN &&
+	       *(uint16_t *) custs1_att_db[att_idx].uuid == ATT_DESC_CLIENT_CHAR_CFG;
+}
+
+/* A characteristic value the peer writes */
+static bool is_writable_value(int att_idx)
+{
+	return !is_ccc(att_idx) && PERM_GET(custs1_att_db[att_idx].max_length, MAX_LEN) &&
+	       (PERM_GET(custs1_att_db[att_idx].perm, WRITE_REQ) ||
+		PERM_GET(custs1_att_db[att_idx].perm, WRITE_COMMAND));
+}
+
+/* The other tasks free some of their blocks and allocate new ones */
+static void others_churn(void **others)
+{
+	int i;
+
+	for (i = 0; i < OTHER_MAX; i++) {
+		if (others[i] && (rnd() & 1)) {
+			db_free(others[i]);
+			others[i] = NULL;
+		}
+		if (others[i] == NULL && (rnd() & 1))
+			others[i] = db_malloc(OTHER_SIZE_MIN + rnd() % (OTHER_SIZE_MAX - OTHER_SIZE_MIN));
+	}
+}
+
+static void others_free(void **others)
+{
+	int i;
+
+	for (i = 0; i < OTHER_MAX; i++) {
+		if (others[i])
+			db_free(others[i]);
+		others[i] = NULL;
+	}
+}
+
+static uint8_t profile_create(const struct variant *v)
+{
+	uint16_t start_hdl = BENCH_START_HDL;
+	uint8_t status;
+
+	memset(&task_env, 0, sizeof(task_env));
+	task_env.task = BENCH_PRF_TASK;
+	owner = OWNER_PROFILE;
+	status = v->itf_get()->init(&task_env, &start_hdl, BENCH_APP_TASK, 0, NULL);
+	owner = OWNER_OTHER;
+
+	return status;
+}
+
+static void profile_destroy(const struct variant *v)
+{
+	owner = OWNER_PROFILE;
+	v->itf_get()->destroy(&task_env);
+	owner = OWNER_OTHER;
+	attmdb_reset();
+}
+
+/* Deliver a message to the profile task, then the completion of the events it sent */
+static int deliver(const struct variant *v, ke_msg_id_t id, void *param)
+{
+	const struct ke_state_handler *handler = v->handler;
+	uint32_t evts;
+	int first = -1;
+	int ret;
+	int i;
+
+	do {
+		evts = sent_evts;
+		for (i = 0; i < handler->msg_cnt; i++)
+			if (handler->msg_table[i].id == id)
+				break;
+		if (i == handler->msg_cnt)
+			return -1;
+
+		ret = handler->msg_table[i].func(id, param, BENCH_PRF_TASK, KE_BUILD_ID(TASK_GATTC, 0));
+		if (ret == KE_MSG_CONSUMED)
+			free(ke_param2msg(param));
+		if (first < 0)
+			first = ret;
+
+		/* GATTC completes each event it was asked to send */
+		if (sent_evts == evts)
+			break;
+		id = GATTC_CMP_EVT;
+		param = ke_msg_alloc(GATTC_CMP_EVT, BENCH_PRF_TASK, TASK_GATTC, sizeof(struct gattc_cmp_evt));
+		((struct gattc_cmp_evt *) param)->operation = GATTC_NOTIFY;
+	} while (1);
+
+	return first;
+}
+
+static void ccc_write(const struct variant *v, uint16_t handle, uint16_t ccc)
+{
+	struct gattc_write_req_ind *req = ke_msg_alloc(GATTC_WRITE_REQ_IND, BENCH_PRF_TASK, TASK_GATTC,
+						       sizeof(*req) + sizeof(ccc));
+
+	req->handle = handle;
+	req->length = sizeof(ccc);
+	memcpy(req->value, &ccc, sizeof(ccc));
+	write_status = 0xFF;
+	expect(deliver(v, GATTC_WRITE_REQ_IND, req) == KE_MSG_CONSUMED, "write request consumed");
+	expect(write_status == ATT_ERR_NO_ERROR, "CCC write accepted");
+}
+
+static void value_write(const struct variant *v, uint16_t handle, uint16_t length)
+{
+	struct gattc_write_req_ind *req = ke_msg_alloc(GATTC_WRITE_REQ_IND, BENCH_PRF_TASK, TASK_GATTC,
+						       sizeof(*req) + length);
+
+	req->handle = handle;
+	req->length = length;
+	memset(req->value, length, length);
+	write_status = 0xFF;
+	expect(deliver(v, GATTC_WRITE_REQ_IND, req) == KE_MSG_CONSUMED, "write request consumed");
+	expect(write_status == ATT_ERR_NO_ERROR, "value write accepted");
+}
+
+static uint16_t ccc_read(const struct variant *v, uint16_t handle)
+{
+	struct gattc_read_req_ind *req = ke_msg_alloc(GATTC_READ_REQ_IND, BENCH_PRF_TASK, TASK_GATTC, sizeof(*req));
+
+	req->handle = handle;
+	expect(deliver(v, GATTC_READ_REQ_IND, req) == KE_MSG_CONSUMED, "read request consumed");
+
+	return read_value;
+}
+
+static void ntf_request(const struct variant *v, uint16_t att_idx, bool notification)
+{
+	static const uint8_t value[4] = { 1, 2, 3, 4 };
+	struct custs1_val_ntf_ind_req *req = ke_msg_alloc(notification ? CUSTS1_VAL_NTF_REQ : CUSTS1_VAL_IND_REQ,
+							  BENCH_PRF_TASK, BENCH_APP_TASK,
+							  sizeof(*req) + sizeof(value));
+
+	req->notification = notification;
+	req->handle = att_idx;
+	req->length = sizeof(value);
+	memcpy(req->value, value, sizeof(value));
+	expect(deliver(v, notification ? CUSTS1_VAL_NTF_REQ : CUSTS1_VAL_IND_REQ, req) == KE_MSG_NO_FREE,
+	       "notification request kept");
+}
+
+/* Create and destroy the profile between the allocations of other tasks */
+static void run_cycles(const struct variant *v, struct result *res)
+{
+	void *others[OTHER_MAX] = { NULL };
+	uint64_t prf_blocks_sum = 0, prf_bytes_sum = 0, free_sum = 0, largest_sum = 0;
+	uint32_t c;
+
+	heap_init(&db_heap, db_heap_size);
+	prf_blocks = prf_bytes = db_fails = 0;
+	res->min_largest = db_heap.size;
+	owner = OWNER_OTHER;
+
+	for (c = 0; c < cycles; c++) {
+		others_churn(others);
+
+		expect(profile_create(v) == ATT_ERR_NO_ERROR, "profile created");
+
+		prf_blocks_sum += prf_blocks;
+		prf_bytes_sum += prf_bytes;
+		free_sum += db_heap.nb_free;
+		largest_sum += heap_largest(&db_heap);
+		if (heap_largest(&db_heap) < res->min_largest)
+			res->min_largest = heap_largest(&db_heap);
+
+		profile_destroy(v);
+		expect(prf_blocks == 0 && prf_bytes == 0, "profile blocks freed");
+	}
+
+	others_free(others);
+	expect(db_heap.nb_free == 1 && db_heap.free[0].size == db_heap.size, "database heap empty");
+
+	res->prf_blocks = (double) prf_blocks_sum / cycles;
+	res->prf_bytes = (double) prf_bytes_sum / cycles;
+	res->free_blocks = (double) free_sum / cycles;
+	res->largest = (double) largest_sum / cycles;
+	res->fails = db_fails;
+}
+
+/* CCC writes, CCC reads, notifications and value writes of random length on a connected profile */
+static void run_hot_path(const struct variant *v, struct result *res)
+{
+	uint16_t ccc_idx[UINT8_MAX];
+	uint16_t val_idx[UINT8_MAX];
+	int nb_ccc = 0, nb_val = 0;
+	uint64_t start, write_ns = 0, read_ns = 0, ntf_ns = 0, value_ns = 0;
+	uint32_t n;
+	int i;
+
+	heap_init(&db_heap, db_heap_size);
+	if (profile_create(v) != ATT_ERR_NO_ERROR) {
+		expect(false, "profile created");
+		return;
+	}
+	v->itf_get()->create(&task_env, 0);
+
+	for (i = 1; i < custs1_att_max_nb; i++) {
+		if (is_ccc(i))
+			ccc_idx[nb_ccc++] = i;
+		else if (is_writable_value(i))
+			val_idx[nb_val++] = i;
+	}
+
+	sent_evts = sent_cfms = sent_read_cfms = sent_write_inds = sent_write_bytes = 0;
+	res->read_sum = 0;
+	mallocs = 0;
+
+	for (n = 0; n < ops; n++) {
+		int idx = ccc_idx[n % nb_ccc];
+		uint16_t handle = BENCH_START_HDL + idx;
+		/* the value precedes its CCC, enable what it supports */
+		bool ntf = PERM_GET(custs1_att_db[idx - 1].perm, NTF);
+		uint16_t ccc = (n & 2) ? 0 : (ntf ? PRF_CLI_START_NTF : PRF_CLI_START_IND);
+
+		start = now_ns();
+		ccc_write(v, handle, ccc);
+		write_ns += now_ns() - start;
+
+		start = now_ns();
+		res->read_sum += ccc_read(v, handle);
+		read_ns += now_ns() - start;
+
+		start = now_ns();
+		ntf_request(v, idx - 1, ntf);
+		ntf_ns += now_ns() - start;
+
+		idx = val_idx[n % nb_val];
+		start = now_ns();
+		value_write(v, BENCH_START_HDL + idx,
+			    1 + rnd() % PERM_GET(custs1_att_db[idx].max_length, MAX_LEN));
+		value_ns += now_ns() - start;
+	}
+
+	res->hot_mallocs = mallocs;
+	res->evts = sent_evts;
+	res->cfms = sent_cfms;
+	res->write_inds = sent_write_inds;
+	res->write_bytes = sent_write_bytes;
+	res->write_ns = (double) write_ns / ops;
+	res->read_ns = (double) read_ns / ops;
+	res->ntf_ns = (double) ntf_ns / ops;
+	res->value_ns = (double) value_ns / ops;
+	expect(sent_read_cfms == ops, "read confirmations");
+	expect(sent_cfms == ops, "notification confirmations");
+	/* the application is told about the CCC writes too */
+	expect(sent_write_inds == 2 * ops, "write indications");
+
+	v->itf_get()->cleanup(&task_env, 0, 0);
+	profile_destroy(v);
+}
+
+static void check_ccc_values(void)
+{
+	int i, k;
+
+	/* both variants start with the CCCs cleared and store what is written */
+	for (k = 0; k < 2; k++) {
+		heap_init(&db_heap, db_heap_size);
+		expect(profile_create(&variants[k]) == ATT_ERR_NO_ERROR, "profile created");
+		variants[k].itf_get()->create(&task_env, 0);
+		for (i = 1; i < custs1_att_max_nb; i++) {
+			if (!is_ccc(i))
+				continue;
+			expect(ccc_read(&variants[k], BENCH_START_HDL + i) == 0, "CCC cleared");
+			variants[k].set_ccc_value(0, i, PRF_CLI_START_NTF);
+			expect(ccc_read(&variants[k], BENCH_START_HDL + i) == PRF_CLI_START_NTF, "CCC set");
+		}
+		variants[k].itf_get()->cleanup(&task_env, 0, 0);
+		for (i = 1; i < custs1_att_max_nb; i++)
+			if (is_ccc(i))
+				expect(ccc_read(&variants[k], BENCH_START_HDL + i) == 0, "CCC cleared on disconnection");
+		profile_destroy(&variants[k]);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	struct result res[2];
+	uint32_t start_seed;
+	int opt, k;
+
+	while ((opt = getopt(argc, argv, "c:n:s:S:")) != -1) {
+		switch (opt) {
+		case 'c':
+			cycles = strtoul(optarg, NULL, 0);
+			break;
+		case 'n':
+			ops = strtoul(optarg, NULL, 0);
+			break;
+		case 's':
+			db_heap_size = strtoul(optarg, NULL, 0);
+			break;
+		case 'S':
+			seed = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	if (optind != argc || cycles == 0 || ops == 0 || db_heap_size < 256 || db_heap_size >= DB_HEAP_SIZE_MAX) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	check_ccc_values();
+
+	start_seed = seed;
+	for (k = 0; k < 2; k++) {
+		memset(&res[k], 0, sizeof(res[k]));
+		seed = start_seed;
+		run_cycles(&variants[k], &res[k]);
+		run_hot_path(&variants[k], &res[k]);
+	}
+
+	expect(res[0].read_sum == res[1].read_sum, "same CCC values read");
+	expect(res[0].evts == res[1].evts, "same notifications sent");
+	expect(res[0].cfms == res[1].cfms, "same confirmations sent");
+	expect(res[0].write_bytes == res[1].write_bytes, "same values written");
+
+	printf("database heap %u bytes, %u cycles\n", db_heap_size, cycles);
+	printf("%-10s %11s %11s %11s %11s %11s %6s\n", "values", "prf blocks", "prf bytes",
+	       "free blocks", "largest", "min largest", "fails");
+	for (k = 0; k < 2; k++)
+		printf("%-10s %11.1f %11.1f %11.2f %11.1f %11u %6u\n", variants[k].name,
+		       res[k].prf_blocks, res[k].prf_bytes, res[k].free_blocks, res[k].largest,
+		       res[k].min_largest, res[k].fails);
+
+	printf("\n%u operations, %u notifications sent, %u bytes written\n", ops, res[1].evts,
+	       res[1].write_bytes);
+	printf("%-10s %11s %11s %11s %11s %11s\n", "values", "write ns", "read ns", "ntf ns",
+	       "value ns", "ke_malloc");
+	for (k = 0; k < 2; k++)
+		printf("%-10s %11.1f %11.1f %11.1f %11.1f %11llu\n", variants[k].name, res[k].write_ns,
+		       res[k].read_ns, res[k].ntf_ns, res[k].value_ns, (unsigned long long) res[k].hot_mallocs);
+
+	if (errors) {
+		printf("\nFAILED, %d errors\n", errors);
+		return EXIT_FAILURE;
+	}
+	printf("\nOK\n");
+
+	return EXIT_SUCCESS;
+}
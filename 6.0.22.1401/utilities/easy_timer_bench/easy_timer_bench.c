@@ -0,0 +1,592 @@
+/**
+ ****************************************************************************************
+ *
+ * @file easy_timer_bench.c
+ *
+ * @brief Wakeups and CPU time of the easy timers for a simulated sensor application.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ke_msg.h"
+#include "ke_timer.h"
+#include "app_entry_point.h"
+#include "app_easy_timer.h"
+#include "lld_evt.h"
+
+#define EASY_TIMER_BENCH_VERSION	"v_1.0"
+
+/* Kernel timer tick (10 ms) and BLE time slot (625 us) */
+#define TICK_US			10000
+#define SLOT_US			625
+
+/* Kernel timers set at the same time */
+#define KE_TIMERS		32
+
+/* Handlers of both timer APIs are at most 255 */
+#define HANDLERS		256
+
+/* A build of app_easy_timer.c, see VARIANTS in gcc/Makefile */
+struct variant {
+	const char *name;
+	/* CFG_APP_EASY_TIMER_WHEEL_SLACK of the wheel builds, in ticks */
+	uint32_t slack;
+	enum process_event_response (*handler)(ke_msg_id_t const msgid, void const *param,
+					       ke_task_id_t const dest_id,
+					       ke_task_id_t const src_id,
+					       enum ke_msg_status_tag *msg_ret);
+	timer_hnd (*timer)(const uint32_t delay, timer_callback fn);
+	timer_hnd (*modify)(const timer_hnd timer_id, const uint32_t delay);
+	/* NULL for the build without CFG_APP_EASY_TIMER_WHEEL */
+	timer_hnd (*wheel_timer)(const uint32_t delay, const uint32_t period, timer_callback fn);
+	void (*wheel_cancel)(const timer_hnd timer_id);
+};
+
+#define VARIANT_API(v)								\
+	enum process_event_response v##_app_timer_api_process_handler(ke_msg_id_t const msgid, \
+		void const *param, ke_task_id_t const dest_id, ke_task_id_t const src_id, \
+		enum ke_msg_status_tag *msg_ret);				\
+	timer_hnd v##_app_easy_timer(const uint32_t delay, timer_callback fn);	\
+	timer_hnd v##_app_easy_timer_modify(const timer_hnd timer_id, const uint32_t delay); \
+	timer_hnd v##_app_easy_wheel_timer(const uint32_t delay, const uint32_t period, \
+					   timer_callback fn);			\
+	void v##_app_easy_wheel_timer_cancel(const timer_hnd timer_id)
+
+VARIANT_API(legacy);
+VARIANT_API(wheel);
+VARIANT_API(wheel_s2);
+VARIANT_API(wheel_s5);
+
+#define LEGACY(v)	{ #v, 0, v##_app_timer_api_process_handler, v##_app_easy_timer, \
+			  v##_app_easy_timer_modify, NULL, NULL }
+#define WHEEL(v, s)	{ #v, s, v##_app_timer_api_process_handler, v##_app_easy_timer, \
+			  v##_app_easy_timer_modify, v##_app_easy_wheel_timer, \
+			  v##_app_easy_wheel_timer_cancel }
+
+static const struct variant variants[] = {
+	LEGACY(legacy),
+	WHEEL(wheel, 0),
+	WHEEL(wheel_s2, 2),
+	WHEEL(wheel_s5, 5),
+};
+
+#define NB_VARIANTS		(sizeof(variants) / sizeof(variants[0]))
+
+/* Periods of the sensors, in ticks: 100 ms, 250 ms, 1 s, 2 s and 5 s */
+static const uint32_t sensor_periods[] = { 10, 25, 100, 200, 500 };
+
+#define NB_SENSORS		(sizeof(sensor_periods) / sizeof(sensor_periods[0]))
+
+/* One-shot timers started by a button press: debounce and inactivity timeout, in ticks */
+#define DEBOUNCE_TICKS		5
+#define TIMEOUT_TICKS		300
+
+struct bench_msg {
+	struct bench_msg *next;
+	struct ke_msg msg;
+};
+
+struct result {
+	uint64_t timer_wakeups;
+	uint64_t irq_wakeups;
+	uint64_t forced_wakeups;
+	uint64_t msgs;
+	uint64_t timer_ops;
+	uint64_t callbacks;
+	double cpu_us;
+	double late_us;
+	double max_late_us;
+};
+
+/* A one-shot or periodic timer of the application */
+struct app_timer {
+	const char *name;
+	uint32_t period;
+	timer_hnd hnd;
+	bool running;
+	uint64_t first_us;
+	uint64_t due_us;
+	uint32_t fired;
+};
+
+static uint32_t duration_s = 600;
+static uint32_t press_ms = 4000;
+static double wake_us = 500;
+static double msg_us = 20;
+static double cb_us = 50;
+static uint32_t seed = 1;
+static int errors;
+
+/* Simulation state of the current run */
+static const struct variant *cur;
+static struct result res;
+static uint64_t now_us;
+static bool ble_active;
+
+static struct {
+	ke_msg_id_t id;
+	ke_task_id_t task;
+	uint32_t tick;
+	bool set;
+} ke_timers[KE_TIMERS];
+
+static struct bench_msg *queue_head, *queue_tail;
+
+static struct app_timer sensors[NB_SENSORS];
+static struct app_timer debounce = { "debounce" };
+static struct app_timer timeout = { "timeout" };
+static struct app_timer *owner[HANDLERS];
+static uint32_t debounce_starts;
+static uint32_t timeout_starts;
+
+static void usage(const char* my_name)
+{
+	fprintf(stderr,
+		"Version: " EASY_TIMER_BENCH_VERSION "\n"
+		"\n"
+		"Usage: %s [-t seconds] [-b press_ms] [-w wake_us] [-m msg_us] [-u cb_us] [-S seed]\n"
+		"\n"
+		"  Runs a sensor application for 'seconds' of simulated time on the easy timers\n"
+		"  of this tree (app_easy_timer.c), built without CFG_APP_EASY_TIMER_WHEEL and\n"
+		"  with it, with a slack of 0, 2 and 5 ticks, and reports the wakeups and the\n"
+		"  CPU time of each build.\n"
+		"\n"
+		"  Five sensors are read every 100 ms, 250 ms, 1 s, 2 s and 5 s; the legacy\n"
+		"  build restarts a one-shot timer from each callback, the wheel builds use\n"
+		"  periodic wheel timers. A button is pressed at random intervals of 'press_ms'\n"
+		"  on average, while the system sleeps; each press starts a 50 ms debounce\n"
+		"  timer and starts (or restarts) a 3 s inactivity timeout.\n"
+		"\n"
+		"  The system sleeps whenever the kernel message queue is empty. It wakes up\n"
+		"  for a kernel timer or a button press; a timer created while the BLE sleeps\n"
+		"  forces a BLE wakeup. Each wakeup, forced or not, costs 'wake_us' of CPU\n"
+		"  time, each kernel message 'msg_us' and each timer callback 'cb_us'.\n"
+		"\n"
+		"  Checks that no timer expires early or later than the slack allows, the\n"
+		"  number of sensor readings and that every debounce and every timeout that\n"
+		"  was not restarted expires.\n"
+		"\n", my_name);
+}
+
+static uint32_t rnd(void)
+{
+	seed = seed * 1103515245 + 12345;
+	return seed >> 1;
+}
+
+static void expect(bool ok, const char *what)
+{
+	if (!ok) {
+		fprintf(stderr, "FAILED: %s: %s\n", cur->name, what);
+		errors++;
+	}
+}
+
+/*
+ * Kernel
+ */
+
+uint32_t lld_evt_time_get(void)
+{
+	return (now_us / SLOT_US) & BLE_BASETIMECNT_MASK;
+}
+
+/* The kernel time counts the ticks of the BLE time, as ke_time() */
+static uint32_t ke_tick(void)
+{
+	return lld_evt_time_get() / (TICK_US / SLOT_US);
+}
+
+bool app_check_BLE_active(void)
+{
+	return ble_active;
+}
+
+bool arch_ble_force_wakeup(void)
+{
+	if (ble_active)
+		return false;
+	res.forced_wakeups++;
+	res.cpu_us += wake_us;
+	ble_active = true;
+	return true;
+}
+
+void *ke_msg_alloc(ke_msg_id_t const id, ke_task_id_t const dest_id, ke_task_id_t const src_id,
+		   uint16_t const param_len)
+{
+	struct bench_msg *m = calloc(1, sizeof(*m) + param_len);
+
+	if (m == NULL) {
+		fprintf(stderr, "out of memory\n");
+		exit(EXIT_FAILURE);
+	}
+	m->msg.id = id;
+	m->msg.dest_id = dest_id;
+	m->msg.src_id = src_id;
+	m->msg.param_len = param_len;
+	return ke_msg2param(&m->msg);
+}
+
+void ke_msg_send(void const *param_ptr)
+{
+	struct bench_msg *m = (struct bench_msg *)((uint8_t *) ke_param2msg(param_ptr) -
+						   offsetof(struct bench_msg, msg));
+
+	m->next = NULL;
+	if (queue_tail != NULL)
+		queue_tail->next = m;
+	else
+		queue_head = m;
+	queue_tail = m;
+}
+
+void ke_msg_send_basic(ke_msg_id_t const id, ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+	ke_msg_send(ke_msg_alloc(id, dest_id, src_id, 0));
+}
+
+void ke_timer_set(ke_msg_id_t const timer_id, ke_task_id_t const task, uint32_t delay)
+{
+	int i, free_idx = -1;
+
+	res.timer_ops++;
+	for (i = 0; i < KE_TIMERS; i++) {
+		if (ke_timers[i].set && ke_timers[i].id == timer_id && ke_timers[i].task == task)
+			break;
+		if (!ke_timers[i].set && free_idx < 0)
+			free_idx = i;
+	}
+	if (i == KE_TIMERS) {
+		if (free_idx < 0) {
+			fprintf(stderr, "too many kernel timers\n");
+			exit(EXIT_FAILURE);
+		}
+		i = free_idx;
+	}
+	ke_timers[i].id = timer_id;
+	ke_timers[i].task = task;
+	ke_timers[i].tick = ke_tick() + (delay ? delay : 1);
+	ke_timers[i].set = true;
+}
+
+void ke_timer_clear(ke_msg_id_t const timer_id, ke_task_id_t const task)
+{
+	int i;
+
+	res.timer_ops++;
+	for (i = 0; i < KE_TIMERS; i++)
+		if (ke_timers[i].set && ke_timers[i].id == timer_id && ke_timers[i].task == task)
+			ke_timers[i].set = false;
+}
+
+/* Earliest kernel timer, false if none is set */
+static bool ke_timer_next(uint32_t *tick)
+{
+	bool found = false;
+	int i;
+
+	for (i = 0; i < KE_TIMERS; i++) {
+		if (ke_timers[i].set && (!found || (int32_t)(ke_timers[i].tick - *tick) < 0)) {
+			*tick = ke_timers[i].tick;
+			found = true;
+		}
+	}
+	return found;
+}
+
+/* Send the messages of the expired kernel timers, in expiry order */
+static bool ke_timer_expire(void)
+{
+	bool expired = false;
+	uint32_t tick = 0;
+	int i;
+
+	while (ke_timer_next(&tick) && (int32_t)(tick - ke_tick()) <= 0) {
+		for (i = 0; i < KE_TIMERS; i++) {
+			if (ke_timers[i].set && ke_timers[i].tick == tick) {
+				ke_timers[i].set = false;
+				ke_msg_send_basic(ke_timers[i].id, ke_timers[i].task, ke_timers[i].task);
+				expired = true;
+				break;
+			}
+		}
+	}
+	return expired;
+}
+
+static void run_queue(void)
+{
+	struct bench_msg *m;
+
+	do {
+		while ((m = queue_head) != NULL) {
+			enum ke_msg_status_tag ret;
+
+			queue_head = m->next;
+			if (queue_head == NULL)
+				queue_tail = NULL;
+			res.msgs++;
+			res.cpu_us += msg_us;
+			expect(cur->handler(m->msg.id, ke_msg2param(&m->msg), m->msg.dest_id,
+					    m->msg.src_id, &ret) == PR_EVENT_HANDLED,
+			       "unhandled message");
+			free(m);
+		}
+	} while (ke_timer_expire());
+}
+
+/*
+ * Application
+ */
+
+static void timer_expired(timer_hnd hnd);
+
+static void app_timer_start(struct app_timer *t, uint32_t delay)
+{
+	if (cur->wheel_timer != NULL)
+		t->hnd = cur->wheel_timer(delay, t->period, (timer_callback) timer_expired);
+	else
+		t->hnd = cur->timer(delay, (timer_callback) timer_expired);
+	expect(t->hnd != EASY_TIMER_INVALID_TIMER, "no timer available");
+	owner[t->hnd] = t;
+	t->running = true;
+	t->due_us = now_us + (uint64_t) delay * TICK_US;
+}
+
+static void app_timer_restart(struct app_timer *t, uint32_t delay)
+{
+	if (cur->wheel_timer != NULL) {
+		cur->wheel_cancel(t->hnd);
+		owner[t->hnd] = NULL;
+		app_timer_start(t, delay);
+	} else {
+		expect(cur->modify(t->hnd, delay) == t->hnd, "timer not modified");
+		t->due_us = now_us + (uint64_t) delay * TICK_US;
+	}
+}
+
+static void timer_expired(timer_hnd hnd)
+{
+	struct app_timer *t = owner[hnd];
+	double late;
+
+	res.callbacks++;
+	res.cpu_us += cb_us;
+	if (t == NULL || !t->running) {
+		expect(false, "callback of a timer that is not running");
+		return;
+	}
+
+	/* A timer may expire up to a tick early: the kernel timers count whole ticks */
+	late = (double) now_us - (double) t->due_us;
+	if (late < -TICK_US || late > (cur->slack + 1) * TICK_US) {
+		char what[128];
+
+		snprintf(what, sizeof(what), "%s timer expired %.1f ms late at %llu", t->name, late / 1000, (unsigned long long) now_us);
+		expect(false, what);
+	}
+	res.late_us += late;
+	if (late > res.max_late_us)
+		res.max_late_us = late;
+	t->fired++;
+
+	if (t->period == 0) {
+		owner[hnd] = NULL;
+		t->running = false;
+	} else if (cur->wheel_timer != NULL) {
+		t->due_us += (uint64_t) t->period * TICK_US;
+	} else {
+		/* The legacy timers are restarted from the callback, late ones drift */
+		uint64_t due_us = t->due_us + (uint64_t) t->period * TICK_US;
+
+		owner[hnd] = NULL;
+		app_timer_start(t, t->period);
+		t->due_us = due_us;
+	}
+}
+
+static void button_pressed(void)
+{
+	if (!debounce.running) {
+		app_timer_start(&debounce, DEBOUNCE_TICKS);
+		debounce_starts++;
+	}
+	if (timeout.running) {
+		app_timer_restart(&timeout, TIMEOUT_TICKS);
+	} else {
+		app_timer_start(&timeout, TIMEOUT_TICKS);
+		timeout_starts++;
+	}
+}
+
+/* Next press at a random interval of press_ms on average, from 0.2 to 1.8 times it */
+static uint64_t next_press(void)
+{
+	return now_us + (uint64_t) press_ms * 200 + rnd() % (press_ms * 1600 + 1);
+}
+
+static void run(const struct variant *v, uint32_t run_seed)
+{
+	uint64_t end_us = (uint64_t) duration_s * 1000000;
+	uint64_t press_us, timer_us;
+	uint32_t tick = 0;
+	unsigned int i;
+
+	cur = v;
+	seed = run_seed;
+	memset(&res, 0, sizeof(res));
+	memset(ke_timers, 0, sizeof(ke_timers));
+	memset(owner, 0, sizeof(owner));
+	now_us = 0;
+	debounce_starts = 0;
+	timeout_starts = 0;
+	debounce.running = false;
+	debounce.fired = 0;
+	timeout.running = false;
+	timeout.fired = 0;
+
+	/* The application starts the sensors after the system initialization, BLE active */
+	ble_active = true;
+	for (i = 0; i < NB_SENSORS; i++) {
+		sensors[i].name = "sensor";
+		sensors[i].period = sensor_periods[i];
+		sensors[i].fired = 0;
+		sensors[i].running = false;
+		app_timer_start(&sensors[i], 1 + rnd() % sensor_periods[i]);
+		sensors[i].first_us = sensors[i].due_us;
+	}
+	run_queue();
+	press_us = next_press();
+
+	for (;;) {
+		bool timer = ke_timer_next(&tick);
+
+		timer_us = (uint64_t) tick * TICK_US;
+		if (timer && timer_us <= press_us) {
+			if (timer_us > end_us)
+				break;
+			now_us = timer_us;
+			res.timer_wakeups++;
+			ble_active = true;
+		} else {
+			if (press_us > end_us)
+				break;
+			now_us = press_us;
+			res.irq_wakeups++;
+			ble_active = false;
+		}
+		res.cpu_us += wake_us;
+
+		if (now_us == press_us) {
+			button_pressed();
+			press_us = next_press();
+		}
+		run_queue();
+		ble_active = false;
+	}
+
+	for (i = 0; i < NB_SENSORS; i++) {
+		uint32_t expected = (end_us - sensors[i].first_us) /
+				    ((uint64_t) sensors[i].period * TICK_US) + 1;
+		char what[64];
+
+		snprintf(what, sizeof(what), "%u readings of sensor %u", sensors[i].fired, i);
+		expect(sensors[i].fired + 1 >= expected && sensors[i].fired <= expected + 1, what);
+	}
+	expect(timeout.fired + (timeout.running ? 1 : 0) == timeout_starts, "timeouts expired");
+	expect(debounce.fired + (debounce.running ? 1 : 0) == debounce_starts, "debounces expired");
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t run_seed;
+	unsigned int k;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "t:b:w:m:u:S:")) != -1) {
+		switch (opt) {
+		case 't':
+			duration_s = strtoul(optarg, NULL, 0);
+			break;
+		case 'b':
+			press_ms = strtoul(optarg, NULL, 0);
+			break;
+		case 'w':
+			wake_us = strtod(optarg, NULL);
+			break;
+		case 'm':
+			msg_us = strtod(optarg, NULL);
+			break;
+		case 'u':
+			cb_us = strtod(optarg, NULL);
+			break;
+		case 'S':
+			seed = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	if (optind != argc || duration_s == 0 || duration_s > 3600 || press_ms < 100 || press_ms > 1000000 ||
+	    wake_us < 0 || msg_us < 0 || cb_us < 0) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	/* Every build runs the same button presses */
+	run_seed = seed;
+	printf("%u s, button every %u ms, %.0f us per wakeup, %.0f us per message, "
+	       "%.0f us per callback\n", duration_s, press_ms, wake_us, msg_us, cb_us);
+	printf("%-10s %7s %7s %7s %8s %9s %8s %9s %8s %7s\n", "timers", "timer", "button",
+	       "forced", "messages", "ke timers", "CPU ms", "CPU us/s", "late ms", "max ms");
+	for (k = 0; k < NB_VARIANTS; k++) {
+		run(&variants[k], run_seed);
+		printf("%-10s %7llu %7llu %7llu %8llu %9llu %8.1f %9.1f %8.2f %7.1f\n",
+		       variants[k].name, (unsigned long long) res.timer_wakeups,
+		       (unsigned long long) res.irq_wakeups,
+		       (unsigned long long) res.forced_wakeups, (unsigned long long) res.msgs,
+		       (unsigned long long) res.timer_ops, res.cpu_us / 1000,
+		       res.cpu_us / duration_s, res.callbacks ? res.late_us / res.callbacks / 1000 : 0,
+		       res.max_late_us / 1000);
+	}
+
+	if (errors) {
+		printf("\nFAILED, %d errors\n", errors);
+		return EXIT_FAILURE;
+	}
+	printf("\nOK\n");
+
+	return EXIT_SUCCESS;
+}
@@ -46,6 +46,9 @@
 #include "syscntl.h"
 #include "timer0.h"
 #include "timer0_2.h"
+#if defined (USE_UART)
+#include "lzss.h"
+#endif
 #if defined (__DA14531__)
 #include "adc.h"
 #endif
@@ -87,6 +90,9 @@
 #define ACTION_SPI_GPIOS        0x95
 #define ACTION_SPI_IS_EMPTY     0x96
 #define ACTION_SPI_INIT         0x97
+#define ACTION_SPI_SYNC_DIFF    0x98
+#define ACTION_SPI_SYNC_WRITE   0x99
+#define ACTION_SPI_WRITE_LZ     0x9A
 
 #define ACTION_EEPROM_READ      0xA0
 #define ACTION_EEPROM_WRITE     0xA1
@@ -1114,6 +1120,537 @@ uint16_t get_size(uint8_t *buffer)
 #endif
 }
 
+#ifdef USE_UART
+/****************************************************************************************
+  ****************************************************************************************
+  ****************************** FLASH SYNC FUNCTIONS ************************************
+  ****************************************************************************************
+  ****************************************************************************************/
+
+/*
+ * Sync mode reprograms only the sectors of a flash region that differ from the image
+ * held by the host.
+ *
+ * ACTION_SPI_SYNC_DIFF: address[4] (sector aligned), size[2] (number of sectors) and
+ * the CRC32 of every sector of the image. The answer is ACTION_CONTENTS followed by a
+ * bitmap of the sectors that differ (bit 0 of the first byte is the first sector).
+ *
+ * ACTION_SPI_SYNC_WRITE: address[4] and size[2] of the last diff and a flags byte
+ * (SYNC_FLAG_xxx). The answer is a stream of 3-byte tokens instead of a packet:
+ * - SYNC_TOKEN_SEND idx[2]: send sector idx as idx[2] crc[4] data[4096], crc being the
+ *   CRC32 of the data. Only one sector is requested at a time; it is received by
+ *   interrupts while the previous one is programmed. A sector received with a bad CRC
+ *   is requested again.
+ * - SYNC_TOKEN_DONE count[2]: all the differing sectors have been programmed.
+ * - SYNC_TOKEN_ERROR code[2]: the operation was aborted. The code is ACTION_INVALID_CRC
+ *   after SYNC_MAX_RETRIES bad copies of a sector, ACTION_DATA if a requested sector
+ *   was not received within SYNC_RX_TIMEOUT_US, else an SPI_FLASH_ERR_xxx value.
+ * The first sector is received while the differing sectors are erased. Each run of them
+ * is erased with the largest block erase allowed by the flags that does not touch an
+ * unchanged sector holding data.
+ */
+#define SYNC_MAX_SECTORS        (1024)
+#define SYNC_BITMAP_SIZE        (SYNC_MAX_SECTORS / 8)
+#define SYNC_HEADER_SIZE        (6)
+#define SYNC_PACKET_SIZE        (SYNC_HEADER_SIZE + SPI_FLASH_SECTOR_SIZE)
+#define SYNC_MAX_RETRIES        (3)
+#define SYNC_RX_TIMEOUT_US      (5000000)   // a sector takes 4.3 s at 9600 baud
+#define SYNC_RX_POLL_US         (10)
+#define SYNC_NONE               (0xFFFF)
+
+#define SYNC_FLAG_BE32          0x01
+#define SYNC_FLAG_BE64          0x02
+#define SYNC_FLAG_VERIFY        0x04
+
+#define SYNC_TOKEN_SEND         ACTION_DATA
+#define SYNC_TOKEN_DONE         ACTION_OK
+#define SYNC_TOKEN_ERROR        ACTION_ERROR
+
+#if ((2 * SYNC_PACKET_SIZE) > ALLOWED_DATA_UART)
+#error "ALLOWED_DATA_UART is too small for the flash sync mode."
+#endif
+
+/// Result of the last ACTION_SPI_SYNC_DIFF
+static struct
+{
+    uint32_t address;
+    uint16_t count;
+    uint8_t diff[SYNC_BITMAP_SIZE];
+    uint8_t blank[SYNC_BITMAP_SIZE];
+} sync_env;
+
+/// Set by the UART receive callback when the requested sector has been received
+static volatile bool sync_rx_done;
+
+static inline bool sync_bit(const uint8_t *bitmap, uint16_t idx)
+{
+    return (bitmap[idx >> 3] >> (idx & 7)) & 1;
+}
+
+static bool sync_is_blank(const uint8_t *data, uint32_t size)
+{
+    while (size--)
+    {
+        if (*data++ != 0xFF)
+            return false;
+    }
+    return true;
+}
+
+static void sync_rx_callback(uint16_t length)
+{
+    sync_rx_done = true;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Check if the UART and the SPI flash share a pad. Sync write needs both at once.
+ ****************************************************************************************
+ */
+static bool sync_pads_shared(void)
+{
+    const uint8_t uart[2][2] = {
+        {uart_sel_pins.uart_tx_port, uart_sel_pins.uart_tx_pin},
+        {uart_sel_pins.uart_rx_port, uart_sel_pins.uart_rx_pin},
+    };
+    const uint8_t spi[4][2] = {
+        {spi_sel_pins.spi_cs_port, spi_sel_pins.spi_cs_pin},
+        {spi_sel_pins.spi_clk_port, spi_sel_pins.spi_clk_pin},
+        {spi_sel_pins.spi_do_port, spi_sel_pins.spi_do_pin},
+        {spi_sel_pins.spi_di_port, spi_sel_pins.spi_di_pin},
+    };
+
+    for (int i = 0; i < 2; i++)
+    {
+        for (int j = 0; j < 4; j++)
+        {
+            if ((uart[i][0] == spi[j][0]) && (uart[i][1] == spi[j][1]))
+                return true;
+        }
+    }
+    return false;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Send a sync mode token.
+ ****************************************************************************************
+ */
+static void sync_send_token(uint8_t token, uint16_t value)
+{
+#if defined (__DA14531__)
+    uart_one_wire_tx_en(UART1);
+#endif
+    send_byte(token);
+    send_uint16(value);
+#if defined (__DA14531__)
+    uart_one_wire_rx_en(UART1);
+#endif
+    uart_wait_tx_finish(UART1);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Request a sector from the host and receive it by interrupts into a slot.
+ ****************************************************************************************
+ */
+static void sync_request(uint8_t *slot, uint16_t idx)
+{
+    sync_rx_done = false;
+    sync_send_token(SYNC_TOKEN_SEND, idx);
+    uart_receive(UART1, slot, SYNC_PACKET_SIZE, UART_OP_INTR);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Wait for the requested sector, for at most SYNC_RX_TIMEOUT_US.
+ * @return true if the sector has been received
+ ****************************************************************************************
+ */
+static bool sync_wait_rx(void)
+{
+    for (uint32_t waited = 0; waited < SYNC_RX_TIMEOUT_US; waited += SYNC_RX_POLL_US)
+    {
+        if (sync_rx_done)
+            return true;
+        arch_asm_delay_us(SYNC_RX_POLL_US);
+    }
+    return sync_rx_done;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Find the next differing sector, starting from *scan.
+ ****************************************************************************************
+ */
+static uint16_t sync_next(uint16_t *scan)
+{
+    while (*scan < sync_env.count)
+    {
+        uint16_t idx = (*scan)++;
+
+        if (sync_bit(sync_env.diff, idx))
+            return idx;
+    }
+    return SYNC_NONE;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Compare the sectors of a flash region with the CRCs sent by the host.
+ *
+ ****************************************************************************************
+ */
+static int8_t sync_diff(uint8_t *buffer, uint32_t address, uint16_t count)
+{
+    uint8_t *crcs = get_write_position(buffer);
+    // The sectors are read just after the received CRCs
+    uint8_t *sector = crcs + count * 4;
+    uint32_t actual_size;
+    int8_t ret;
+
+    sync_env.count = 0;
+
+    if ((address % SPI_FLASH_SECTOR_SIZE) || (count == 0) || (count > SYNC_MAX_SECTORS) ||
+        ((sector + SPI_FLASH_SECTOR_SIZE) > (buffer + ALLOWED_DATA_UART)))
+    {
+        return ERR_INVAL;
+    }
+
+    memset(sync_env.diff, 0, sizeof(sync_env.diff));
+    memset(sync_env.blank, 0, sizeof(sync_env.blank));
+
+    for (uint16_t i = 0; i < count; i++)
+    {
+        ret = spi_flash_read_data(sector, address + i * SPI_FLASH_SECTOR_SIZE, SPI_FLASH_SECTOR_SIZE, &actual_size);
+        if ((ret != SPI_FLASH_ERR_OK) || (actual_size != SPI_FLASH_SECTOR_SIZE))
+            return SPI_FLASH_ERR_READ_ERROR;
+
+        if (crc32(0, sector, SPI_FLASH_SECTOR_SIZE) != get_uint32(&crcs[i * 4]))
+            sync_env.diff[i >> 3] |= 1 << (i & 7);
+        if (sync_is_blank(sector, SPI_FLASH_SECTOR_SIZE))
+            sync_env.blank[i >> 3] |= 1 << (i & 7);
+    }
+
+    sync_env.address = address;
+    sync_env.count = count;
+    return ERR_OK;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Check if n sectors starting at idx can be erased at once and need to be.
+ *
+ ****************************************************************************************
+ */
+static bool sync_erase_block(uint16_t idx, uint16_t n)
+{
+    bool needed = false;
+
+    if ((idx + n) > sync_env.count)
+        return false;
+
+    for (uint16_t i = idx; i < (idx + n); i++)
+    {
+        bool changed = sync_bit(sync_env.diff, i);
+        bool blank = sync_bit(sync_env.blank, i);
+
+        // Never erase data that stays
+        if (!changed && !blank)
+            return false;
+        needed |= changed && !blank;
+    }
+    return needed;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Erase the differing sectors of the last diff.
+ *
+ ****************************************************************************************
+ */
+static int8_t sync_erase(uint8_t flags)
+{
+    uint16_t idx = 0;
+
+    while (idx < sync_env.count)
+    {
+        uint32_t address = sync_env.address + idx * SPI_FLASH_SECTOR_SIZE;
+        spi_flash_op_t op = SPI_FLASH_OP_SE;
+        uint16_t n = 1;
+        int8_t ret;
+
+        if ((flags & SYNC_FLAG_BE64) && !(address % (16 * SPI_FLASH_SECTOR_SIZE)) && sync_erase_block(idx, 16))
+        {
+            op = SPI_FLASH_OP_BE64;
+            n = 16;
+        }
+        else if ((flags & SYNC_FLAG_BE32) && !(address % (8 * SPI_FLASH_SECTOR_SIZE)) && sync_erase_block(idx, 8))
+        {
+            op = SPI_FLASH_OP_BE32;
+            n = 8;
+        }
+        else if (!sync_erase_block(idx, 1))
+        {
+            idx++;
+            continue;
+        }
+
+        ret = spi_flash_block_erase(address, op);
+        if (ret != SPI_FLASH_ERR_OK)
+            return ret;
+        idx += n;
+    }
+    return ERR_OK;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Program an erased sector. Pages left blank by the image are skipped.
+ *
+ ****************************************************************************************
+ */
+static int8_t sync_program(uint8_t *data, uint32_t address, uint32_t crc, uint8_t flags)
+{
+    uint32_t actual_size;
+    int8_t ret;
+
+    for (uint32_t offset = 0; offset < SPI_FLASH_SECTOR_SIZE; offset += SPI_FLASH_PAGE_SIZE)
+    {
+        if (sync_is_blank(data + offset, SPI_FLASH_PAGE_SIZE))
+            continue;
+
+        ret = spi_flash_write_data(data + offset, address + offset, SPI_FLASH_PAGE_SIZE, &actual_size);
+        if ((ret != SPI_FLASH_ERR_OK) || (actual_size != SPI_FLASH_PAGE_SIZE))
+            return SPI_FLASH_ERR_PROG_ERROR;
+    }
+
+    if (flags & SYNC_FLAG_VERIFY)
+    {
+        // The sector data are no longer needed, read the programmed ones over them
+        ret = spi_flash_read_data(data, address, SPI_FLASH_SECTOR_SIZE, &actual_size);
+        if ((ret != SPI_FLASH_ERR_OK) || (actual_size != SPI_FLASH_SECTOR_SIZE) ||
+            (crc32(0, data, SPI_FLASH_SECTOR_SIZE) != crc))
+        {
+            return SPI_FLASH_ERR_PROG_ERROR;
+        }
+    }
+    return ERR_OK;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Erase and program the differing sectors of the last diff.
+ *
+ ****************************************************************************************
+ */
+static void sync_write(uint8_t *buffer, uint32_t address, uint16_t count, uint8_t flags)
+{
+    uint8_t *slot[2] = {buffer, buffer + SYNC_PACKET_SIZE};
+    uint8_t cur = 0;
+    uint8_t retries = 0;
+    uint16_t scan = 0;
+    uint16_t done = 0;
+    uint16_t idx;
+    int32_t ret;
+
+    if ((sync_env.count == 0) || (address != sync_env.address) || (count != sync_env.count))
+    {
+        sync_send_token(SYNC_TOKEN_ERROR, (uint16_t) SPI_FLASH_ERR_INVAL);
+        return;
+    }
+
+    idx = sync_next(&scan);
+    if (idx == SYNC_NONE)
+    {
+        sync_send_token(SYNC_TOKEN_DONE, 0);
+        return;
+    }
+
+    uart_register_rx_cb(UART1, sync_rx_callback);
+    sync_request(slot[cur], idx);
+
+    ret = sync_erase(flags);
+
+    while (ret == ERR_OK)
+    {
+        uint8_t *packet = slot[cur];
+        uint16_t next;
+        uint32_t crc;
+
+        if (!sync_wait_rx())
+        {
+            // The host is gone or missed the request
+            ret = ACTION_DATA;
+            break;
+        }
+
+        crc = get_uint32(&packet[2]);
+        if ((get_uint16(packet) != idx) ||
+            (crc32(0, &packet[SYNC_HEADER_SIZE], SPI_FLASH_SECTOR_SIZE) != crc))
+        {
+            if (++retries > SYNC_MAX_RETRIES)
+            {
+                ret = ACTION_INVALID_CRC;
+                break;
+            }
+            sync_request(packet, idx);
+            continue;
+        }
+        retries = 0;
+
+        // Receive the next sector while this one is programmed
+        next = sync_next(&scan);
+        if (next != SYNC_NONE)
+            sync_request(slot[cur ^ 1], next);
+
+        ret = sync_program(&packet[SYNC_HEADER_SIZE], sync_env.address + idx * SPI_FLASH_SECTOR_SIZE, crc, flags);
+        if (ret != ERR_OK)
+            break;
+        done++;
+
+        if (next == SYNC_NONE)
+            break;
+        idx = next;
+        cur ^= 1;
+    }
+
+    // Stop a pending reception
+    uart_rxdata_intr_setf(UART1, UART_BIT_DIS);
+    uart_register_rx_cb(UART1, NULL);
+
+    // The flash contents changed, a new diff is needed
+    sync_env.count = 0;
+
+    if (ret == ERR_OK)
+        sync_send_token(SYNC_TOKEN_DONE, done);
+    else
+        sync_send_token(SYNC_TOKEN_ERROR, (uint16_t) ret);
+}
+#endif // USE_UART
+
+#ifdef USE_UART
+/****************************************************************************************
+  ****************************************************************************************
+  *************************** COMPRESSED WRITE FUNCTIONS *********************************
+  ****************************************************************************************
+  ****************************************************************************************/
+
+/*
+ * ACTION_SPI_WRITE_LZ programs an image compressed by "mkimage compress" (refer to
+ * lzss.h) into an erased flash region, decoding it while it is received.
+ * address[4] is the flash address of the decoded image, the same in all the packets of
+ * an image, and size[2] is the number of compressed bytes that follow. The packets carry
+ * consecutive parts of the compressed stream; a packet with another address, or one that
+ * follows another action, starts a new image. Each packet is answered with ACTION_OK
+ * once its data are decoded and the completed pages programmed, else with ACTION_ERROR
+ * and ERR_INVAL (corrupted stream), ACTION_INVALID_CRC (the CRC32 of the decoded image
+ * does not match) or an SPI_FLASH_ERR_xxx value, which ends the image. Pages that are
+ * left blank by the image are not programmed.
+ * The decoder history and the page being decoded are kept at the end of the UART
+ * buffer, so a packet may carry at most LZ_MAX_CHUNK compressed bytes.
+ */
+#define LZ_WINDOW_SIZE          (1 << LZSS_WINDOW_LOG2_MAX)
+#define LZ_RESERVED             (LZ_WINDOW_SIZE + SPI_FLASH_PAGE_SIZE)
+#define LZ_MAX_CHUNK            (ALLOWED_DATA_UART - LZ_RESERVED - 7)
+
+#if (LZ_MAX_CHUNK < SPI_FLASH_SECTOR_SIZE)
+#error "ALLOWED_DATA_UART is too small for the compressed write."
+#endif
+
+/// Compressed image being programmed
+static struct
+{
+    lzss_dec_t dec;
+    /// Flash address of the image
+    uint32_t address;
+    /// Flash address of the page being decoded and number of bytes decoded in it
+    uint32_t write;
+    uint16_t fill;
+    bool active;
+} lz_env;
+
+/**
+ ****************************************************************************************
+ * @brief Program the decoded part of the current page.
+ *
+ ****************************************************************************************
+ */
+static int32_t lz_flush(uint8_t *page)
+{
+    uint32_t actual_size;
+    int8_t ret;
+
+    if ((lz_env.fill != 0) && !sync_is_blank(page, lz_env.fill))
+    {
+        ret = spi_flash_write_data(page, lz_env.write, lz_env.fill, &actual_size);
+        if ((ret != SPI_FLASH_ERR_OK) || (actual_size != lz_env.fill))
+            return SPI_FLASH_ERR_PROG_ERROR;
+    }
+    lz_env.write += lz_env.fill;
+    lz_env.fill = 0;
+    return ERR_OK;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Decode and program a part of a compressed image.
+ *
+ ****************************************************************************************
+ */
+static int32_t lz_write(uint8_t *buffer, uint32_t address, uint16_t size)
+{
+    uint8_t *in = get_write_position(buffer);
+    uint8_t *window = buffer + ALLOWED_DATA_UART - LZ_RESERVED;
+    uint8_t *page = window + LZ_WINDOW_SIZE;
+    uint32_t in_used;
+    uint32_t out_used;
+    uint32_t room;
+    int32_t ret;
+
+    if (size > LZ_MAX_CHUNK)
+    {
+        lz_env.active = false;
+        return ERR_INVAL;
+    }
+
+    if (!lz_env.active || (address != lz_env.address))
+    {
+        lzss_init(&lz_env.dec, window, LZ_WINDOW_SIZE);
+        lz_env.address = address;
+        lz_env.write = address;
+        lz_env.fill = 0;
+        lz_env.active = true;
+    }
+
+    do
+    {
+        // Decode up to the end of the flash page
+        room = SPI_FLASH_PAGE_SIZE - (lz_env.write % SPI_FLASH_PAGE_SIZE) - lz_env.fill;
+        ret = lzss_decode(&lz_env.dec, in, size, &in_used, page + lz_env.fill, room, &out_used);
+        in += in_used;
+        size -= in_used;
+        lz_env.fill += out_used;
+
+        if (((ret == LZSS_DONE) || ((ret == LZSS_OK) && (out_used == room))) &&
+            (lz_flush(page) != ERR_OK))
+        {
+            lz_env.active = false;
+            return SPI_FLASH_ERR_PROG_ERROR;
+        }
+    } while ((ret == LZSS_OK) && ((size != 0) || (out_used == room)));
+
+    if (ret == LZSS_OK)
+        return ERR_OK;
+
+    lz_env.active = false;
+
+    if (ret == LZSS_DONE)
+        return (size == 0) ? ERR_OK : ERR_INVAL;    // no data may follow the image
+    return (ret == LZSS_ERR_CRC) ? ACTION_INVALID_CRC : ERR_INVAL;
+}
+#endif // USE_UART
+
 /*
  * The following variable must be placed just after the code.
  * The 1-byte variable can be initialized by an external tool.
@@ -1227,6 +1764,13 @@ int main(void)
         size = get_size(buffer);
         starting_address = (uint32_t)address;
 
+#ifdef USE_UART
+        // The compressed write history is kept in the buffer, any other action ends it
+        if (action != ACTION_SPI_WRITE_LZ)
+        {
+            lz_env.active = false;
+        }
+#endif
 #ifndef USE_UART
         if (action)
         {
@@ -1600,6 +2144,58 @@ int main(void)
                 response_write_action_result(buffer, (uint32_t)result, port_sel);
                 break;
             }
+#ifdef USE_UART
+            case ACTION_SPI_SYNC_DIFF:
+            {
+                set_pad_spi();
+                if (spi_flash_peripheral_init() != ERR_OK)
+                {
+                    response_action_error(buffer, (uint32_t)SPI_FLASH_ERR_UNKNOWN_FLASH_TYPE, port_sel);
+                    break;
+                }
+                result = sync_diff(buffer, address, size);
+                if (result != ERR_OK)
+                {
+                    response_action_error(buffer, (uint32_t)result, port_sel);
+                    break;
+                }
+                p = get_read_position(buffer);
+                memcpy(p, sync_env.diff, (size + 7) / 8);
+                response_read_action_result(buffer, (size + 7) / 8 + 1, port_sel);
+                break;
+            }
+            case ACTION_SPI_SYNC_WRITE:
+            {
+                uint8_t flags = get_write_position(buffer)[0];
+
+                if (sync_pads_shared())
+                {
+                    sync_send_token(SYNC_TOKEN_ERROR, (uint16_t)SPI_FLASH_ERR_INVAL);
+                    break;
+                }
+                set_pad_spi();
+                if (spi_flash_peripheral_init() != ERR_OK)
+                {
+                    sync_send_token(SYNC_TOKEN_ERROR, (uint16_t)SPI_FLASH_ERR_UNKNOWN_FLASH_TYPE);
+                    break;
+                }
+                uart_pads(port_sel);
+                sync_write(buffer, address, size, flags);
+                break;
+            }
+            case ACTION_SPI_WRITE_LZ:
+            {
+                set_pad_spi();
+                if (spi_flash_peripheral_init() != ERR_OK)
+                {
+                    response_action_error(buffer, (uint32_t)SPI_FLASH_ERR_UNKNOWN_FLASH_TYPE, port_sel);
+                    break;
+                }
+                result = lz_write(buffer, address, size);
+                response_write_action_result(buffer, (uint32_t)result, port_sel);
+                break;
+            }
+#endif
             case ACTION_SPI_ID:
             {
                 uint32_t jedec_id;
@@ -0,0 +1,675 @@
+/**
+ ****************************************************************************************
+ *
+ * @file flash_sync.c
+ *
+ * @brief Delta programming of the SPI flash through the flash programmer (sync mode).
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#define FLASH_SYNC_VERSION	"v_1.0"
+
+/* These must match programmer.c of the flash programmer */
+#define ACTION_UART_BAUD	0x30
+#define ACTION_CONTENTS		0x82
+#define ACTION_OK		0x83
+#define ACTION_ERROR		0x84
+#define ACTION_DATA		0x85
+#define ACTION_INVALID_CRC	0x87
+#define ACTION_SPI_WRITE	0x91
+#define ACTION_SPI_ERASE_BLOCK	0x94
+#define ACTION_SPI_GPIOS	0x95
+#define ACTION_SPI_SYNC_DIFF	0x98
+#define ACTION_SPI_SYNC_WRITE	0x99
+
+#define SECTOR_SIZE		4096
+#define SYNC_MAX_SECTORS	1024
+#define SYNC_HEADER_SIZE	6
+#define SYNC_PACKET_SIZE	(SYNC_HEADER_SIZE + SECTOR_SIZE)
+
+#define SYNC_FLAG_BE32		0x01
+#define SYNC_FLAG_BE64		0x02
+#define SYNC_FLAG_VERIFY	0x04
+
+#define SYNC_TOKEN_SEND		ACTION_DATA
+#define SYNC_TOKEN_DONE		ACTION_OK
+#define SYNC_TOKEN_ERROR	ACTION_ERROR
+
+/* spi_flash_* error of the sync write when the UART and the SPI flash share a pad */
+#define SPI_FLASH_ERR_INVAL	(-4)
+
+/* Packet size of the legacy flow; the DA14531 flash programmer buffer is 32 KB */
+#define LEGACY_CHUNK_MAX	(32 * 1024 - 8)
+
+/* Answer timeout (ms), long enough for a full region diff or a 64 KB block erase */
+#define ANSWER_TIMEOUT		30000
+
+/* Baud rates selectable by ACTION_UART_BAUD */
+static const struct {
+	speed_t speed;
+	unsigned int rate;
+} baud_rates[] = {
+	{ B9600, 9600 },
+	{ B19200, 19200 },
+	{ B57600, 57600 },
+	{ B115200, 115200 },
+	{ B1000000, 1000000 },
+};
+
+#define BAUD_RATES	(sizeof(baud_rates) / sizeof(baud_rates[0]))
+
+static uint32_t crc32_table[256];
+
+/* Traffic counters */
+static size_t bytes_tx, bytes_rx;
+
+static void usage(const char* my_name)
+{
+	fprintf(stderr,
+		"Version: " FLASH_SYNC_VERSION "\n"
+		"\n"
+		"Usage:\n"
+		"  %s [-L] [-a address] [-r rate] [-b baud] [-e flags] [-p pads] tty image_bin\n"
+		"  %s -S flash_bin [-L] [-a address] [-r rate] [-b baud] [-e flags] [-p pads] image_bin\n"
+		"\n"
+		"  Program 'image_bin' to the SPI flash through the flash programmer\n"
+		"  running on the device at the serial port 'tty'. Only the 4 KB\n"
+		"  sectors that differ from the image are erased and programmed.\n"
+		"  -L            erase and program every sector (ACTION_SPI_ERASE_BLOCK\n"
+		"                and ACTION_SPI_WRITE), for comparison\n"
+		"  -a address    flash address of the image (default 0)\n"
+		"  -r rate       baud rate of the flash programmer (default 115200)\n"
+		"  -b baud       switch to the ACTION_UART_BAUD rate index first:\n"
+		"                0: 9600, 1: 19200, 2: 57600, 3: 115200, 4: 1000000\n"
+		"  -e flags      sync flags (default 7): 1: 32 KB block erase,\n"
+		"                2: 64 KB block erase, 4: read back and verify\n"
+		"  -p pads       SPI flash pads CS,CLK,DO,DI set with ACTION_SPI_GPIOS\n"
+		"                first, e.g. P0_3,P0_0,P0_6,P0_7. The sync write needs\n"
+		"                the UART and the SPI flash on different pads; on the\n"
+		"                development kit every UART pair shares one with the\n"
+		"                default SPI flash pads.\n"
+		"  -S flash_bin  do not use a device but run the flash programmer of\n"
+		"                this tree (programmer.c) on a pseudo terminal, with\n"
+		"                a simulated SPI flash whose contents are kept in\n"
+		"                'flash_bin' (created blank if missing). The line rate\n"
+		"                and the flash timings are modelled. The programmer\n"
+		"                uses the UART pads of the development kit, at\n"
+		"                57600 baud ('rate' is ignored).\n"
+		"  The bytes transferred and the programming time are reported.\n",
+		my_name, my_name);
+}
+
+static void crc32_init(void)
+{
+	uint32_t i, j, c;
+
+	for (i = 0; i < 256; i++) {
+		c = i;
+		for (j = 0; j < 8; j++)
+			c = (c & 1) ? (c >> 1) ^ 0xEDB88320 : c >> 1;
+		crc32_table[i] = c;
+	}
+}
+
+/* Same as crc32() of the flash programmer (zlib compatible) */
+static uint32_t crc32(uint32_t crc, const uint8_t *buf, size_t size)
+{
+	crc = ~crc;
+	while (size--)
+		crc = crc32_table[(crc ^ *buf++) & 0xFF] ^ (crc >> 8);
+	return ~crc;
+}
+
+static double now_s(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static speed_t rate_to_speed(unsigned int rate)
+{
+	unsigned int i;
+
+	for (i = 0; i < BAUD_RATES; i++)
+		if (baud_rates[i].rate == rate)
+			return baud_rates[i].speed;
+	return 0;
+}
+
+static int set_speed(int fd, speed_t speed)
+{
+	struct termios tio;
+
+	if (tcgetattr(fd, &tio) < 0)
+		return -1;
+	cfsetispeed(&tio, speed);
+	cfsetospeed(&tio, speed);
+	return tcsetattr(fd, TCSANOW, &tio);
+}
+
+static int open_tty(const char *name, speed_t speed)
+{
+	struct termios tio;
+	int fd;
+
+	fd = open(name, O_RDWR | O_NOCTTY);
+	if (fd < 0) {
+		fprintf(stderr, "Could not open %s: %s\n", name, strerror(errno));
+		return -1;
+	}
+
+	if (tcgetattr(fd, &tio) < 0) {
+		fprintf(stderr, "%s is not a serial port: %s\n", name, strerror(errno));
+		close(fd);
+		return -1;
+	}
+	cfmakeraw(&tio);
+	tio.c_cflag |= CLOCAL | CREAD;
+	tio.c_cflag &= ~(CSTOPB | CRTSCTS);
+	tio.c_cc[VMIN] = 1;
+	tio.c_cc[VTIME] = 0;
+	cfsetispeed(&tio, speed);
+	cfsetospeed(&tio, speed);
+	if (tcsetattr(fd, TCSANOW, &tio) < 0) {
+		fprintf(stderr, "Could not configure %s: %s\n", name, strerror(errno));
+		close(fd);
+		return -1;
+	}
+	tcflush(fd, TCIOFLUSH);
+
+	return fd;
+}
+
+static int write_all(int fd, const uint8_t *buf, size_t len)
+{
+	ssize_t n;
+
+	bytes_tx += len;
+	while (len > 0) {
+		n = write(fd, buf, len);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		buf += n;
+		len -= n;
+	}
+	return 0;
+}
+
+/* Read exactly 'len' bytes, giving up after 'timeout_ms' of silence */
+static int read_all(int fd, uint8_t *buf, size_t len, int timeout_ms)
+{
+	struct pollfd pfd = { .fd = fd, .events = POLLIN };
+	ssize_t n;
+
+	bytes_rx += len;
+	while (len > 0) {
+		n = poll(&pfd, 1, timeout_ms);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		if (n == 0)
+			return -1;
+		n = read(fd, buf, len);
+		if (n <= 0)
+			return -1;
+		buf += n;
+		len -= n;
+	}
+	return 0;
+}
+
+static uint8_t *put_u16(uint8_t *p, uint16_t v)
+{
+	*p++ = v >> 8;
+	*p++ = v;
+	return p;
+}
+
+static uint8_t *put_u32(uint8_t *p, uint32_t v)
+{
+	p = put_u16(p, v >> 16);
+	return put_u16(p, v);
+}
+
+static uint16_t get_u16(const uint8_t *p)
+{
+	return (p[0] << 8) | p[1];
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+	return ((uint32_t)get_u16(p) << 16) | get_u16(p + 2);
+}
+
+/* Packets of the flash programmer: length[2] crc[4] data */
+static int send_packet(int fd, const uint8_t *data, size_t len)
+{
+	uint8_t hdr[6];
+
+	put_u32(put_u16(hdr, len), crc32(0, data, len));
+	if (write_all(fd, hdr, sizeof(hdr)) < 0 || write_all(fd, data, len) < 0)
+		return -1;
+	return 0;
+}
+
+static int receive_packet(int fd, uint8_t *data, size_t max_len)
+{
+	uint8_t hdr[6];
+	size_t len;
+
+	if (read_all(fd, hdr, sizeof(hdr), ANSWER_TIMEOUT) < 0)
+		return -1;
+	len = get_u16(hdr);
+	if (len == 0 || len > max_len || read_all(fd, data, len, ANSWER_TIMEOUT) < 0)
+		return -1;
+	if (crc32(0, data, len) != get_u32(hdr + 2))
+		return -1;
+	return len;
+}
+
+/* Send a command and check that the answer is ACTION_OK */
+static int command(int fd, const uint8_t *cmd, size_t len, const char *what)
+{
+	uint8_t answer[8];
+	int n;
+
+	if (send_packet(fd, cmd, len) < 0) {
+		fprintf(stderr, "%s: write failed\n", what);
+		return -1;
+	}
+	n = receive_packet(fd, answer, sizeof(answer));
+	if (n < 1 || answer[0] != ACTION_OK) {
+		if (n == 5)
+			fprintf(stderr, "%s failed: %d\n", what, (int32_t)get_u32(answer + 1));
+		else
+			fprintf(stderr, "%s failed\n", what);
+		return -1;
+	}
+	return 0;
+}
+
+static int switch_baud(int fd, unsigned int baud)
+{
+	uint8_t cmd[2] = { ACTION_UART_BAUD, baud };
+
+	if (command(fd, cmd, sizeof(cmd), "ACTION_UART_BAUD") < 0)
+		return -1;
+	/* Let the programmer switch after its answer */
+	usleep(10000);
+	return set_speed(fd, baud_rates[baud].speed);
+}
+
+/* Parse the -p argument: 4 pads "P<port>_<pin>" separated by commas */
+static int parse_pads(const char *arg, uint8_t *pads)
+{
+	unsigned int port, pin;
+	int i, n;
+
+	for (i = 0; i < 4; i++) {
+		if (sscanf(arg, "P%u_%u%n", &port, &pin, &n) != 2 || port > 3 || pin > 9)
+			return -1;
+		pads[2 * i] = port;
+		pads[2 * i + 1] = pin;
+		arg += n;
+		if (*arg != (i < 3 ? ',' : '\0'))
+			return -1;
+		arg++;
+	}
+	return 0;
+}
+
+static int set_spi_pads(int fd, const uint8_t *pads)
+{
+	/* 4 port-pin pairs, then no enable pin */
+	uint8_t cmd[10] = { ACTION_SPI_GPIOS };
+
+	memcpy(cmd + 1, pads, 8);
+	return command(fd, cmd, sizeof(cmd), "ACTION_SPI_GPIOS");
+}
+
+/* Erase the sectors of the image and program it, one ACTION_SPI_WRITE per chunk */
+static int program_legacy(int fd, uint32_t address, const uint8_t *image, size_t size)
+{
+	uint8_t *cmd;
+	size_t offset, chunk;
+	int ret = 0;
+
+	cmd = malloc(7 + LEGACY_CHUNK_MAX);
+	if (cmd == NULL)
+		return -1;
+
+	cmd[0] = ACTION_SPI_ERASE_BLOCK;
+	put_u16(put_u32(cmd + 1, address), (size + SECTOR_SIZE - 1) / SECTOR_SIZE);
+	if (command(fd, cmd, 7, "ACTION_SPI_ERASE_BLOCK") < 0) {
+		free(cmd);
+		return -1;
+	}
+
+	for (offset = 0; offset < size && ret == 0; offset += chunk) {
+		chunk = size - offset;
+		if (chunk > LEGACY_CHUNK_MAX)
+			chunk = LEGACY_CHUNK_MAX;
+		cmd[0] = ACTION_SPI_WRITE;
+		put_u16(put_u32(cmd + 1, address + offset), chunk);
+		memcpy(cmd + 7, image + offset, chunk);
+		ret = command(fd, cmd, 7 + chunk, "ACTION_SPI_WRITE");
+	}
+	free(cmd);
+
+	if (ret == 0)
+		printf("%zu sectors programmed\n", (size + SECTOR_SIZE - 1) / SECTOR_SIZE);
+	return ret;
+}
+
+/* Sync one region of up to SYNC_MAX_SECTORS sectors */
+static int sync_region(int fd, uint32_t address, const uint8_t *image, unsigned int count,
+		       uint8_t flags, unsigned int *changed, unsigned int *programmed)
+{
+	uint8_t *cmd, answer[1 + SYNC_MAX_SECTORS / 8], token[3];
+	uint8_t *packet;
+	unsigned int i;
+	int n, ret = -1;
+
+	cmd = malloc(7 + 4 * count);
+	packet = malloc(SYNC_PACKET_SIZE);
+	if (cmd == NULL || packet == NULL)
+		goto out;
+
+	cmd[0] = ACTION_SPI_SYNC_DIFF;
+	put_u16(put_u32(cmd + 1, address), count);
+	for (i = 0; i < count; i++)
+		put_u32(cmd + 7 + 4 * i, crc32(0, image + i * SECTOR_SIZE, SECTOR_SIZE));
+	if (send_packet(fd, cmd, 7 + 4 * count) < 0)
+		goto out;
+	n = receive_packet(fd, answer, sizeof(answer));
+	if (n != 1 + (int)(count + 7) / 8 || answer[0] != ACTION_CONTENTS) {
+		fprintf(stderr, "ACTION_SPI_SYNC_DIFF failed at 0x%08x\n", address);
+		goto out;
+	}
+	for (i = 0; i < count; i++)
+		if (answer[1 + i / 8] & (1 << (i % 8)))
+			(*changed)++;
+
+	cmd[0] = ACTION_SPI_SYNC_WRITE;
+	cmd[7] = flags;
+	if (send_packet(fd, cmd, 8) < 0)
+		goto out;
+
+	for (;;) {
+		unsigned int idx;
+
+		if (read_all(fd, token, sizeof(token), ANSWER_TIMEOUT) < 0) {
+			fprintf(stderr, "No answer to ACTION_SPI_SYNC_WRITE\n");
+			goto out;
+		}
+		idx = get_u16(token + 1);
+		if (token[0] == SYNC_TOKEN_DONE) {
+			*programmed += idx;
+			ret = 0;
+			goto out;
+		}
+		if (token[0] != SYNC_TOKEN_SEND || idx >= count) {
+			if (token[0] == SYNC_TOKEN_ERROR && idx == ACTION_INVALID_CRC)
+				fprintf(stderr, "ACTION_SPI_SYNC_WRITE failed: bad sector CRC\n");
+			else if (token[0] == SYNC_TOKEN_ERROR && idx == ACTION_DATA)
+				fprintf(stderr, "ACTION_SPI_SYNC_WRITE failed: sector not received in time\n");
+			else if (token[0] == SYNC_TOKEN_ERROR && (int16_t)idx == SPI_FLASH_ERR_INVAL)
+				fprintf(stderr, "ACTION_SPI_SYNC_WRITE failed: the UART shares a pad "
+					"with the SPI flash, see -p\n");
+			else if (token[0] == SYNC_TOKEN_ERROR)
+				fprintf(stderr, "ACTION_SPI_SYNC_WRITE failed: %d\n", (int16_t)idx);
+			else
+				fprintf(stderr, "Unexpected token 0x%02x\n", token[0]);
+			goto out;
+		}
+		memcpy(packet + SYNC_HEADER_SIZE, image + idx * SECTOR_SIZE, SECTOR_SIZE);
+		put_u32(put_u16(packet, idx), crc32(0, packet + SYNC_HEADER_SIZE, SECTOR_SIZE));
+		if (write_all(fd, packet, SYNC_PACKET_SIZE) < 0)
+			goto out;
+	}
+
+out:
+	free(cmd);
+	free(packet);
+	return ret;
+}
+
+static int program_sync(int fd, uint32_t address, const uint8_t *image, size_t size, uint8_t flags)
+{
+	unsigned int sectors = size / SECTOR_SIZE, first, count;
+	unsigned int changed = 0, programmed = 0;
+
+	for (first = 0; first < sectors; first += count) {
+		count = sectors - first;
+		if (count > SYNC_MAX_SECTORS)
+			count = SYNC_MAX_SECTORS;
+		if (sync_region(fd, address + first * SECTOR_SIZE, image + first * SECTOR_SIZE,
+				count, flags, &changed, &programmed) < 0)
+			return -1;
+	}
+	printf("%u of %u sectors differ, %u programmed\n", changed, sectors, programmed);
+	return 0;
+}
+
+/****************************************************************************************
+ * Simulated target
+ ****************************************************************************************/
+
+/* flash_sync_target.c: programmer.c of the flash programmer, run on the host */
+unsigned int sim_target_rate(void);
+void sim_target_run(int fd, const char *flash_name);
+
+/* Start the simulated target on the master side of a pseudo terminal */
+static int sim_start(const char *flash_name, pid_t *pid)
+{
+	uint8_t hello[5];
+	struct termios tio;
+	int master, fd;
+
+	/* Raw from the start, so that nothing is echoed before the tty is configured */
+	master = posix_openpt(O_RDWR | O_NOCTTY);
+	if (master < 0 || grantpt(master) < 0 || unlockpt(master) < 0 ||
+	    tcgetattr(master, &tio) < 0) {
+		fprintf(stderr, "Could not create a pseudo terminal: %s\n", strerror(errno));
+		return -1;
+	}
+	cfmakeraw(&tio);
+	tcsetattr(master, TCSANOW, &tio);
+
+	fd = open_tty(ptsname(master), rate_to_speed(sim_target_rate()));
+	if (fd < 0)
+		return -1;
+
+	*pid = fork();
+	if (*pid < 0)
+		return -1;
+	if (*pid == 0) {
+		close(fd);
+		sim_target_run(master, flash_name);
+		_exit(0);
+	}
+	close(master);
+
+	/* The flash programmer greets once its UART is set up */
+	if (read_all(fd, hello, sizeof(hello), ANSWER_TIMEOUT) < 0 ||
+	    memcmp(hello, "Hello", sizeof(hello)) != 0) {
+		fprintf(stderr, "The simulated target did not start\n");
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+static uint8_t *read_image(const char *filename, size_t *size)
+{
+	FILE *f;
+	long len;
+	size_t padded;
+	uint8_t *buf;
+
+	f = fopen(filename, "rb");
+	if (f == NULL) {
+		fprintf(stderr, "Could not open %s: %s\n", filename, strerror(errno));
+		return NULL;
+	}
+	if (fseek(f, 0, SEEK_END) < 0 || (len = ftell(f)) <= 0 || fseek(f, 0, SEEK_SET) < 0) {
+		fprintf(stderr, "Could not get the size of %s\n", filename);
+		fclose(f);
+		return NULL;
+	}
+	/* The last sector is padded as erased flash */
+	padded = (len + SECTOR_SIZE - 1) / SECTOR_SIZE * SECTOR_SIZE;
+	buf = malloc(padded);
+	if (buf == NULL || fread(buf, 1, len, f) != (size_t)len) {
+		fprintf(stderr, "Could not read %s\n", filename);
+		free(buf);
+		fclose(f);
+		return NULL;
+	}
+	memset(buf + len, 0xFF, padded - len);
+	fclose(f);
+	*size = padded;
+	return buf;
+}
+
+int main(int argc, char **argv)
+{
+	int legacy = 0;
+	unsigned int rate = 115200, baud = BAUD_RATES, flags = SYNC_FLAG_BE32 | SYNC_FLAG_BE64 | SYNC_FLAG_VERIFY;
+	uint32_t address = 0;
+	const char *sim = NULL;
+	uint8_t pads[8];
+	int set_pads = 0;
+	pid_t pid = 0;
+	uint8_t *image;
+	size_t size;
+	double start, elapsed;
+	int fd, opt, ret;
+
+	while ((opt = getopt(argc, argv, "La:r:b:e:p:S:")) != -1) {
+		switch (opt) {
+		case 'L':
+			legacy = 1;
+			break;
+		case 'a':
+			address = strtoul(optarg, NULL, 0);
+			break;
+		case 'r':
+			rate = strtoul(optarg, NULL, 0);
+			break;
+		case 'b':
+			baud = strtoul(optarg, NULL, 0);
+			break;
+		case 'e':
+			flags = strtoul(optarg, NULL, 0);
+			break;
+		case 'p':
+			if (parse_pads(optarg, pads) < 0) {
+				usage(argv[0]);
+				return EXIT_FAILURE;
+			}
+			set_pads = 1;
+			break;
+		case 'S':
+			sim = optarg;
+			break;
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (argc - optind != (sim ? 1 : 2) || (baud > BAUD_RATES) ||
+	    (address % SECTOR_SIZE) || (flags & ~0x07)) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+	if (rate_to_speed(rate) == 0) {
+		fprintf(stderr, "Unsupported baud rate %u\n", rate);
+		return EXIT_FAILURE;
+	}
+
+	crc32_init();
+
+	image = read_image(argv[argc - 1], &size);
+	if (image == NULL)
+		return EXIT_FAILURE;
+
+	if (sim)
+		fd = sim_start(sim, &pid);
+	else
+		fd = open_tty(argv[optind], rate_to_speed(rate));
+	if (fd < 0) {
+		free(image);
+		return EXIT_FAILURE;
+	}
+
+	ret = 0;
+	if (set_pads)
+		ret = set_spi_pads(fd, pads);
+	if (ret == 0 && baud < BAUD_RATES)
+		ret = switch_baud(fd, baud);
+	if (ret == 0) {
+		bytes_tx = bytes_rx = 0;
+		start = now_s();
+		if (legacy)
+			ret = program_legacy(fd, address, image, size);
+		else
+			ret = program_sync(fd, address, image, size, flags);
+		elapsed = now_s() - start;
+		if (ret == 0)
+			printf("%zu bytes sent, %zu bytes received, %.3f s\n",
+			       bytes_tx, bytes_rx, elapsed);
+	}
+
+	close(fd);
+	if (pid > 0)
+		waitpid(pid, NULL, 0);
+	free(image);
+
+	return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,504 @@
+/**
+ ****************************************************************************************
+ *
+ * @file flash_sync_target.c
+ *
+ * @brief Simulated target of flash_sync: the flash programmer on the host.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "arch_system.h"
+#include "uart.h"
+#include "hw_otpc.h"
+#include "i2c_eeprom.h"
+#include "spi_flash.h"
+#include "user_periph_setup.h"
+
+/*
+ * programmer.c of the flash programmer, built for the DA14585 with USE_UART, runs on the
+ * main thread of the process. Its UART1 is the master side of a pseudo terminal, read by
+ * a line thread that puts the bytes of flash_sync into the receive FIFO at the bit rate
+ * and calls the receive callback, as the interrupt would. The answers of the programmer
+ * leave at the bit rate too. The SPI flash is the one of host_shim, with the erase and
+ * program times of the SPI flash devices supported by the SDK; the programmer waits for
+ * them in real time. The CPU time of the programmer is the one of the host.
+ */
+
+/* Receive FIFO of the UART */
+#define RX_FIFO_SIZE		16
+
+/* Bytes written by flash_sync that are not on the line yet */
+#define LINE_BUF_SIZE		4096
+
+/* The answers may be ahead of the line by this much before the programmer waits */
+#define TX_AHEAD_NS		1000000
+
+#define SIM_FLASH_SIZE		(1024 * 1024)
+
+/*
+ * UART pads of the programmer: P0_4/P0_5 at 57600 baud, as on the development kit. The
+ * other pairs share a pad with the default SPI flash pads, which sync write refuses.
+ */
+#define SIM_PORT_SEL		4
+#define SIM_START_RATE		57600
+
+int programmer_main(void);
+
+extern volatile uint8_t port_sel;
+
+uart_t host_uart1;
+uint8_t host_otp[MEMORY_OTP_SIZE];
+
+_uart_sel_pins uart_sel_pins = { UART_GPIO_PORT, UART_TX_PIN, UART_GPIO_PORT, UART_RX_PIN };
+_spi_sel_pins spi_sel_pins = {
+	SPI_CS_PORT, SPI_CS_PIN, SPI_CLK_PORT, SPI_CLK_PIN,
+	SPI_DO_PORT, SPI_DO_PIN, SPI_DI_PORT, SPI_DI_PIN,
+};
+
+static const struct {
+	UART_BAUDRATE divisor;
+	unsigned int rate;
+} bit_rates[] = {
+	{ UART_BAUDRATE_9600, 9600 },
+	{ UART_BAUDRATE_19200, 19200 },
+	{ UART_BAUDRATE_57600, 57600 },
+	{ UART_BAUDRATE_115200, 115200 },
+	{ UART_BAUDRATE_230400, 230400 },
+	{ UART_BAUDRATE_1000000, 1000000 },
+};
+
+static const char *flash_file;
+
+static pthread_mutex_t hw_lock;
+
+static struct {
+	pthread_t thread;
+	int fd;
+	unsigned int rate;
+	/* Bytes written by flash_sync, put on the line at the bit rate */
+	uint8_t line[LINE_BUF_SIZE];
+	unsigned int line_in;
+	unsigned int line_out;
+	uint64_t line_time;
+	uint8_t fifo[RX_FIFO_SIZE];
+	unsigned int fifo_in;
+	unsigned int fifo_out;
+	/* Transfer started by uart_receive() */
+	uart_cb_t rx_cb;
+	bool rx_busy;
+	uint8_t *rx_buf;
+	uint16_t rx_len;
+	uint16_t rx_count;
+	/* End of the last byte sent by the programmer */
+	uint64_t tx_time;
+} hw;
+
+/* End of the last delay of the programmer, and the simulated flash time waited for */
+static uint64_t delay_end;
+static double flash_time_us;
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void sleep_until(uint64_t t)
+{
+	struct timespec ts = { .tv_sec = t / 1000000000, .tv_nsec = t % 1000000000 };
+
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+		;
+}
+
+/*
+ * Peripherals of the board, see peripherals.c of the flash programmer. The simulated
+ * target has no pads, no EEPROM and a blank OTP.
+ */
+
+void system_init(void)
+{
+}
+
+void set_pad_uart(void)
+{
+}
+
+void set_pad_spi(void)
+{
+}
+
+void set_pad_eeprom(void)
+{
+}
+
+void update_uart_pads(GPIO_PORT tx_port, GPIO_PIN tx_pin, GPIO_PORT rx_port, GPIO_PIN rx_pin)
+{
+	uart_sel_pins = (_uart_sel_pins){ tx_port, tx_pin, rx_port, rx_pin };
+}
+
+void update_spi_pads(uint8_t *pin_buffer)
+{
+	memcpy(&spi_sel_pins, pin_buffer, sizeof(spi_sel_pins));
+}
+
+void update_eeprom_pads(uint8_t *pin_buffer)
+{
+}
+
+void hw_otpc_init(void)
+{
+}
+
+void hw_otpc_disable(void)
+{
+}
+
+void hw_otpc_manual_read_on(bool spare_rows)
+{
+}
+
+bool hw_otpc_fifo_prog(const uint32_t *p_data, uint32_t cell_offset, HW_OTPC_WORD cell_word,
+		       uint32_t num_of_words, bool use_rr)
+{
+	return false;
+}
+
+void i2c_eeprom_configure(const i2c_cfg_t *i2c_cfg, const i2c_eeprom_cfg_t *i2c_eeprom_cfg)
+{
+}
+
+void i2c_eeprom_initialize(void)
+{
+}
+
+i2c_error_code i2c_eeprom_read_data(uint8_t *rd_data_ptr, uint32_t address, uint32_t size,
+				    uint32_t *bytes_read)
+{
+	*bytes_read = 0;
+	return I2C_7B_ADDR_NOACK_ERROR;
+}
+
+i2c_error_code i2c_eeprom_write_data(uint8_t *wr_data_ptr, uint32_t address, uint32_t size,
+				     uint32_t *bytes_written)
+{
+	*bytes_written = 0;
+	return I2C_7B_ADDR_NOACK_ERROR;
+}
+
+/*
+ * The delays of the programmer are kept in real time: a late wake-up shortens the next
+ * delay, so that the polling loops of the programmer time out when they should.
+ */
+void arch_asm_delay_us(int nof_us)
+{
+	uint64_t now = now_ns();
+
+	if (delay_end + 1000000 < now)
+		delay_end = now;
+	delay_end += nof_us * 1000ULL;
+	if (delay_end > now)
+		sleep_until(delay_end);
+}
+
+/* Wait for the flash operations done since the last call, in real time */
+static void flash_wait(void)
+{
+	double t = spi_flash_sim_time_us();
+	uint64_t ns = (t - flash_time_us) * 1000;
+
+	flash_time_us = t;
+	sleep_until(now_ns() + ns);
+}
+
+/* The flash operations of programmer.c, linked with --wrap */
+int8_t __real_spi_flash_block_erase(uint32_t address, spi_flash_op_t erase_op);
+int8_t __real_spi_flash_chip_erase(void);
+int8_t __real_spi_flash_write_data(uint8_t *wr_data_ptr, uint32_t address, uint32_t size,
+				   uint32_t *actual_size);
+int8_t __real_spi_flash_read_data(uint8_t *rd_data_ptr, uint32_t address, uint32_t size,
+				  uint32_t *actual_size);
+int8_t __real_spi_flash_is_empty(void);
+int8_t __real_spi_flash_is_sector_empty(uint32_t sector_address);
+
+int8_t __wrap_spi_flash_block_erase(uint32_t address, spi_flash_op_t erase_op)
+{
+	int8_t ret = __real_spi_flash_block_erase(address, erase_op);
+
+	flash_wait();
+	return ret;
+}
+
+int8_t __wrap_spi_flash_chip_erase(void)
+{
+	int8_t ret = __real_spi_flash_chip_erase();
+
+	flash_wait();
+	return ret;
+}
+
+int8_t __wrap_spi_flash_write_data(uint8_t *wr_data_ptr, uint32_t address, uint32_t size,
+				   uint32_t *actual_size)
+{
+	int8_t ret = __real_spi_flash_write_data(wr_data_ptr, address, size, actual_size);
+
+	flash_wait();
+	return ret;
+}
+
+int8_t __wrap_spi_flash_read_data(uint8_t *rd_data_ptr, uint32_t address, uint32_t size,
+				  uint32_t *actual_size)
+{
+	int8_t ret = __real_spi_flash_read_data(rd_data_ptr, address, size, actual_size);
+
+	flash_wait();
+	return ret;
+}
+
+int8_t __wrap_spi_flash_is_empty(void)
+{
+	int8_t ret = __real_spi_flash_is_empty();
+
+	flash_wait();
+	return ret;
+}
+
+int8_t __wrap_spi_flash_is_sector_empty(uint32_t sector_address)
+{
+	int8_t ret = __real_spi_flash_is_sector_empty(sector_address);
+
+	flash_wait();
+	return ret;
+}
+
+/*
+ * UART driver. The receive callback is called by the line thread with the lock held.
+ */
+
+void uart_initialize(uart_t *uart_id, const uart_cfg_t *uart_cfg)
+{
+	unsigned int i;
+
+	pthread_mutex_lock(&hw_lock);
+	for (i = 0; i < sizeof(bit_rates) / sizeof(bit_rates[0]); i++)
+		if (bit_rates[i].divisor == uart_cfg->baud_rate)
+			hw.rate = bit_rates[i].rate;
+	hw.rx_busy = false;
+	hw.rx_cb = NULL;
+	pthread_mutex_unlock(&hw_lock);
+}
+
+uint8_t uart_read_byte(uart_t *uart_id)
+{
+	uint8_t b;
+
+	for (;;) {
+		pthread_mutex_lock(&hw_lock);
+		if (hw.fifo_in != hw.fifo_out) {
+			b = hw.fifo[hw.fifo_out++ % RX_FIFO_SIZE];
+			pthread_mutex_unlock(&hw_lock);
+			return b;
+		}
+		pthread_mutex_unlock(&hw_lock);
+		usleep(5);
+	}
+}
+
+void uart_write_byte(uart_t *uart_id, uint8_t data)
+{
+	uint64_t now = now_ns();
+
+	pthread_mutex_lock(&hw_lock);
+	if (hw.tx_time < now)
+		hw.tx_time = now;
+	hw.tx_time += 10000000000ULL / hw.rate;
+	pthread_mutex_unlock(&hw_lock);
+
+	while (write(hw.fd, &data, 1) < 0 && (errno == EINTR || errno == EAGAIN))
+		;
+	if (hw.tx_time > now + TX_AHEAD_NS)
+		sleep_until(hw.tx_time - TX_AHEAD_NS);
+}
+
+void uart_wait_tx_finish(uart_t *uart_id)
+{
+	sleep_until(hw.tx_time);
+}
+
+void uart_register_rx_cb(uart_t *uart_id, uart_cb_t cb)
+{
+	pthread_mutex_lock(&hw_lock);
+	hw.rx_cb = cb;
+	pthread_mutex_unlock(&hw_lock);
+}
+
+static void rx_done(void)
+{
+	hw.rx_busy = false;
+	if (hw.rx_cb != NULL)
+		hw.rx_cb(hw.rx_len);
+}
+
+void uart_receive(uart_t *uart_id, uint8_t *data, uint16_t len, UART_OP_CFG op)
+{
+	pthread_mutex_lock(&hw_lock);
+	hw.rx_buf = data;
+	hw.rx_len = len;
+	hw.rx_count = 0;
+	hw.rx_busy = true;
+	// The bytes waiting in the FIFO are read first
+	while (hw.rx_busy && hw.fifo_in != hw.fifo_out) {
+		hw.rx_buf[hw.rx_count++] = hw.fifo[hw.fifo_out++ % RX_FIFO_SIZE];
+		if (hw.rx_count == hw.rx_len)
+			rx_done();
+	}
+	pthread_mutex_unlock(&hw_lock);
+}
+
+void uart_rxdata_intr_setf(uart_t *uart_id, UART_BIT_CFG state)
+{
+	pthread_mutex_lock(&hw_lock);
+	if (state == UART_BIT_DIS)
+		hw.rx_busy = false;
+	pthread_mutex_unlock(&hw_lock);
+}
+
+/* flash_sync closed the line: keep the flash contents and stop */
+static void target_exit(void)
+{
+	if (spi_flash_sim_save(flash_file) != 0)
+		fprintf(stderr, "Could not write %s\n", flash_file);
+	_exit(0);
+}
+
+static void *line_thread(void *arg)
+{
+	struct pollfd pfd = { .fd = hw.fd, .events = POLLIN };
+	uint64_t now, byte_ns;
+	ssize_t n;
+
+	for (;;) {
+		pthread_mutex_lock(&hw_lock);
+		now = now_ns();
+
+		// Bytes written by flash_sync
+		if (poll(&pfd, 1, 0) > 0 && hw.line_in - hw.line_out < LINE_BUF_SIZE) {
+			unsigned int pos = hw.line_in % LINE_BUF_SIZE;
+			unsigned int room = LINE_BUF_SIZE - (hw.line_in - hw.line_out);
+
+			if (room > LINE_BUF_SIZE - pos)
+				room = LINE_BUF_SIZE - pos;
+			if (hw.line_in == hw.line_out && hw.line_time < now)
+				hw.line_time = now;
+			n = read(hw.fd, &hw.line[pos], room);
+			if (n > 0)
+				hw.line_in += n;
+			else if (n == 0 || errno != EAGAIN)
+				target_exit();
+		}
+
+		// Bytes whose last bit has been sent, 10 bits per byte. The line waits while the
+		// FIFO is full: the target reads it in time, the host may not run the programmer then
+		byte_ns = 10000000000ULL / hw.rate;
+		while (hw.line_in != hw.line_out && hw.line_time + byte_ns <= now &&
+		       (hw.rx_busy || hw.fifo_in - hw.fifo_out < RX_FIFO_SIZE)) {
+			uint8_t b = hw.line[hw.line_out++ % LINE_BUF_SIZE];
+
+			hw.line_time += byte_ns;
+			if (hw.rx_busy) {
+				hw.rx_buf[hw.rx_count++] = b;
+				if (hw.rx_count == hw.rx_len)
+					rx_done();
+			} else {
+				hw.fifo[hw.fifo_in++ % RX_FIFO_SIZE] = b;
+			}
+		}
+		pthread_mutex_unlock(&hw_lock);
+
+		usleep(5);
+	}
+
+	return NULL;
+}
+
+/* The baud rate the programmer starts at */
+unsigned int sim_target_rate(void)
+{
+	return SIM_START_RATE;
+}
+
+/*
+ * Run the programmer on fd, the master side of the pseudo terminal, with the flash
+ * contents of flash_name (blank if missing). Saves the flash and exits when the other
+ * side is closed.
+ */
+void sim_target_run(int fd, const char *flash_name)
+{
+	pthread_mutexattr_t attr;
+	spi_flash_sim_timing_t timing = *spi_flash_sim_timing();
+
+	flash_file = flash_name;
+	spi_flash_sim_init(SIM_FLASH_SIZE);
+	if (access(flash_name, F_OK) == 0 && spi_flash_sim_load(flash_name) != 0)
+		fprintf(stderr, "Could not read %s, starting blank\n", flash_name);
+
+	// A 2 MHz SPI bus (the flash programmer default) and typical erase/program times
+	timing.spi_mhz = 2;
+	timing.access_us = 0;
+	timing.page_program_us = 700;
+	timing.sector_erase_us = 45000;
+	timing.block32_erase_us = 120000;
+	timing.block64_erase_us = 150000;
+	spi_flash_sim_set_timing(&timing);
+	flash_time_us = spi_flash_sim_time_us();
+
+	memset(host_otp, 0xFF, sizeof(host_otp));
+	port_sel = SIM_PORT_SEL;
+
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&hw_lock, &attr);
+	hw.fd = fd;
+	hw.rate = SIM_START_RATE;
+	pthread_create(&hw.thread, NULL, line_thread, NULL);
+
+	programmer_main();
+	target_exit();
+}
@@ -0,0 +1,25 @@
+/**
+ ****************************************************************************************
+ *
+ * @file arch_system.h
+ *
+ * @brief System API of the host build of the flash programmer.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _ARCH_SYSTEM_H_
+#define _ARCH_SYSTEM_H_
+
+/* Host subset of sdk/platform/arch/main/arch_system.h, implemented by flash_sync_target.c */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "datasheet.h"
+
+void system_init(void);
+void arch_asm_delay_us(int nof_us);
+
+#endif /* _ARCH_SYSTEM_H_ */
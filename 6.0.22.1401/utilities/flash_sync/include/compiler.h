@@ -0,0 +1,22 @@
+/**
+ ****************************************************************************************
+ *
+ * @file compiler.h
+ *
+ * @brief Compiler definitions of the host build of the flash programmer.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _HOST_COMPILER_H_
+#define _HOST_COMPILER_H_
+
+/* host_shim/include/compiler.h, and the section of the variables kept across a reset */
+
+#include_next "compiler.h"
+
+#define __SECTION_ZERO(sec_name)
+
+#endif /* _HOST_COMPILER_H_ */
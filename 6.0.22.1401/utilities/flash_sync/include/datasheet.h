@@ -0,0 +1,29 @@
+/**
+ ****************************************************************************************
+ *
+ * @file datasheet.h
+ *
+ * @brief Registers of the host build of the flash programmer.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _HOST_DATASHEET_H_
+#define _HOST_DATASHEET_H_
+
+/* host_shim/include/datasheet.h, and the DA14585 registers used by programmer.c */
+
+#include "compiler.h"
+#include_next "datasheet.h"
+
+#define CLK_32K_REG			(0x50000020)
+#define RC32K_ENABLE			(0x0080)
+#define RESET_FREEZE_REG		(0x50003302)
+#define FRZ_WDOG			(0x0008)
+#define WATCHDOG_CTRL_REG		(0x50003102)
+#define NMI_RST				(0x0001)
+#define WDOG_VAL			(0x00FF)
+
+#endif /* _HOST_DATASHEET_H_ */
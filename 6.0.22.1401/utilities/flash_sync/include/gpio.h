@@ -0,0 +1,34 @@
+/**
+ ****************************************************************************************
+ *
+ * @file gpio.h
+ *
+ * @brief GPIO driver API of the host build of the flash programmer.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _HOST_GPIO_H_
+#define _HOST_GPIO_H_
+
+/* host_shim/include/gpio.h, and the GPIO calls of programmer.c */
+
+#include_next "gpio.h"
+
+typedef enum {
+	GPIO_POWER_RAIL_3V = 0,
+	GPIO_POWER_RAIL_1V = 1,
+} GPIO_POWER_RAIL;
+
+#define PID_PWM0			(PID_SPI_EN + 1)
+
+#define GPIO_ConfigurePinPower(port, pin, rail)	((void)(port), (void)(pin), (void)(rail))
+#define GPIO_SetPinFunction(port, pin, mode, function) \
+	((void)(port), (void)(pin), (void)(mode), (void)(function))
+#define GPIO_set_pad_latch_en(en)	((void)(en))
+#define GPIO_is_valid(port, pin)	((port) == GPIO_PORT_0 ? (pin) <= GPIO_PIN_7 : \
+					 (port) <= GPIO_PORT_3 && (pin) <= GPIO_PIN_9)
+
+#endif /* _HOST_GPIO_H_ */
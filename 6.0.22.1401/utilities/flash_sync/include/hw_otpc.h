@@ -0,0 +1,42 @@
+/**
+ ****************************************************************************************
+ *
+ * @file hw_otpc.h
+ *
+ * @brief OTP controller API of the host build of the flash programmer.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _HW_OTPC_H_
+#define _HW_OTPC_H_
+
+/*
+ * Host subset of sdk/platform/driver/hw_otpc/hw_otpc_58x.h. The OTP of the simulated
+ * target is host_otp[], blank and read-only: programming fails.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define HW_OTP_CELL_SIZE		(0x08)
+#define MEMORY_OTP_SIZE			(0x10000)
+
+extern uint8_t host_otp[MEMORY_OTP_SIZE];
+
+#define MEMORY_OTP_BASE			((uintptr_t) host_otp)
+
+typedef enum {
+	HW_OTPC_WORD_LOW = 0,
+	HW_OTPC_WORD_HIGH = 1,
+} HW_OTPC_WORD;
+
+void hw_otpc_init(void);
+void hw_otpc_disable(void);
+void hw_otpc_manual_read_on(bool spare_rows);
+bool hw_otpc_fifo_prog(const uint32_t *p_data, uint32_t cell_offset, HW_OTPC_WORD cell_word,
+		       uint32_t num_of_words, bool use_rr);
+
+#endif /* _HW_OTPC_H_ */
@@ -0,0 +1,73 @@
+/**
+ ****************************************************************************************
+ *
+ * @file i2c_eeprom.h
+ *
+ * @brief I2C EEPROM driver API of the host build of the flash programmer.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _I2C_EEPROM_H_
+#define _I2C_EEPROM_H_
+
+/*
+ * Host subset of sdk/platform/driver/i2c_eeprom/i2c_eeprom.h and of the i2c.h types it
+ * uses. The simulated target has no EEPROM: the transfers fail.
+ */
+
+#include <stdint.h>
+
+#define I2C_SS_SCL_HCNT_REG_RESET	(0x48)
+#define I2C_SS_SCL_LCNT_REG_RESET	(0x4F)
+#define I2C_FS_SCL_HCNT_REG_RESET	(0x08)
+#define I2C_FS_SCL_LCNT_REG_RESET	(0x17)
+
+typedef enum { I2C_RESTART_DISABLE, I2C_RESTART_ENABLE } i2c_restart_t;
+typedef enum { I2C_ADDRESSING_7B, I2C_ADDRESSING_10B } i2c_addressing_t;
+typedef enum { I2C_SPEED_FAST = 0, I2C_SPEED_STANDARD = 1 } i2c_speed_t;
+typedef enum { I2C_MODE_SLAVE, I2C_MODE_MASTER } i2c_mode_t;
+
+enum I2C_ADDRESS_BYTES_COUNT {
+	I2C_1BYTE_ADDR,
+	I2C_2BYTES_ADDR,
+	I2C_3BYTES_ADDR,
+};
+
+typedef enum {
+	I2C_NO_ERROR,
+	I2C_7B_ADDR_NOACK_ERROR,
+} i2c_error_code;
+
+typedef struct {
+	struct {
+		uint16_t ss_hcnt;
+		uint16_t ss_lcnt;
+		uint16_t fs_hcnt;
+		uint16_t fs_lcnt;
+	} clock_cfg;
+	i2c_restart_t restart_en;
+	i2c_speed_t speed;
+	i2c_mode_t mode;
+	i2c_addressing_t addr_mode;
+	uint16_t address;
+	uint8_t tx_fifo_level;
+	uint8_t rx_fifo_level;
+} i2c_cfg_t;
+
+typedef struct {
+	uint32_t size;
+	uint16_t page_size;
+	uint8_t address_size;
+} i2c_eeprom_cfg_t;
+
+void i2c_eeprom_configure(const i2c_cfg_t *i2c_cfg, const i2c_eeprom_cfg_t *i2c_eeprom_cfg);
+void i2c_eeprom_initialize(void);
+i2c_error_code i2c_eeprom_read_data(uint8_t *rd_data_ptr, uint32_t address, uint32_t size,
+				    uint32_t *bytes_read);
+i2c_error_code i2c_eeprom_write_data(uint8_t *wr_data_ptr, uint32_t address, uint32_t size,
+				     uint32_t *bytes_written);
+
+#endif /* _I2C_EEPROM_H_ */
@@ -0,0 +1,18 @@
+/**
+ ****************************************************************************************
+ *
+ * @file syscntl.h
+ *
+ * @brief System control API of the host build of the flash programmer.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _SYSCNTL_H_
+#define _SYSCNTL_H_
+
+/* Not needed by programmer.c, which includes it */
+
+#endif /* _SYSCNTL_H_ */
@@ -0,0 +1,29 @@
+/**
+ ****************************************************************************************
+ *
+ * @file timer0.h
+ *
+ * @brief Timer0 driver API of the host build of the flash programmer.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _TIMER0_H_
+#define _TIMER0_H_
+
+/* Host subset of sdk/platform/driver/timer/timer0.h. The GPIO watchdog PWM is not modelled */
+
+#include <stdint.h>
+
+typedef enum { TIM0_CLK_32K, TIM0_CLK_FAST } TIM0_CLK_SEL_t;
+typedef enum { PWM_MODE_ONE, PWM_MODE_CLOCK_DIV_BY_TWO } PWM_MODE_t;
+typedef enum { TIM0_CLK_DIV_BY_10, TIM0_CLK_NO_DIV } TIM0_CLK_DIV_t;
+
+#define timer0_init(clk, mode, div)	((void)(clk), (void)(mode), (void)(div))
+#define timer0_set(on, high, low)	((void)(on), (void)(high), (void)(low))
+#define timer0_start()			((void)0)
+#define timer0_stop()			((void)0)
+
+#endif /* _TIMER0_H_ */
@@ -0,0 +1,27 @@
+/**
+ ****************************************************************************************
+ *
+ * @file timer0_2.h
+ *
+ * @brief Timer0/2 clock API of the host build of the flash programmer.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _TIMER0_2_H_
+#define _TIMER0_2_H_
+
+/* Host subset of sdk/platform/driver/timer/timer0_2.h */
+
+typedef enum { TIM0_2_CLK_DIV_1, TIM0_2_CLK_DIV_2, TIM0_2_CLK_DIV_4, TIM0_2_CLK_DIV_8 } TIM0_2_CLK_DIV_t;
+
+typedef struct {
+	TIM0_2_CLK_DIV_t clk_div;
+} tim0_2_clk_div_config_t;
+
+#define timer0_2_clk_enable()		((void)0)
+#define timer0_2_clk_div_set(cfg)	((void)(cfg))
+
+#endif /* _TIMER0_2_H_ */
@@ -0,0 +1,82 @@
+/**
+ ****************************************************************************************
+ *
+ * @file uart.h
+ *
+ * @brief UART driver API of the host build of the flash programmer.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _UART_H_
+#define _UART_H_
+
+/*
+ * Host subset of sdk/platform/driver/uart/uart.h, used by programmer.c. UART1 is
+ * connected to a pseudo terminal by flash_sync_target.c, which implements these functions.
+ */
+
+#include <stdint.h>
+
+typedef struct {
+	int id;
+} uart_t;
+
+extern uart_t host_uart1;
+
+#define UART1				(&host_uart1)
+
+/* Divisor values of the SDK, the simulated target maps them to bit rates */
+typedef enum {
+	UART_BAUDRATE_1000000		= 0x000100,
+	UART_BAUDRATE_230400		= 0x000405,
+	UART_BAUDRATE_115200		= 0x00080b,
+	UART_BAUDRATE_57600		= 0x001106,
+	UART_BAUDRATE_19200		= 0x003401,
+	UART_BAUDRATE_9600		= 0x006803,
+} UART_BAUDRATE;
+
+typedef enum {
+	UART_BIT_DIS			= 0,
+	UART_BIT_EN			= 1,
+} UART_BIT_CFG;
+
+typedef enum { UART_DATABITS_8 = 3 } UART_DATABITS;
+typedef enum { UART_PARITY_NONE = 0 } UART_PARITY;
+typedef enum { UART_STOPBITS_1 = 0 } UART_STOPBITS;
+typedef enum { UART_AFCE_DIS = 0 } UART_AFCE_CFG;
+typedef enum { UART_FIFO_DIS = 0, UART_FIFO_EN = 1 } UART_FIFO_CFG;
+typedef enum { UART_TX_FIFO_LEVEL_0 = 0 } UART_TX_FIFO_LEVEL;
+typedef enum { UART_RX_FIFO_LEVEL_0 = 0 } UART_RX_FIFO_LEVEL;
+
+typedef enum {
+	UART_OP_BLOCKING,
+	UART_OP_INTR,
+	UART_OP_DMA,
+} UART_OP_CFG;
+
+typedef void (*uart_cb_t)(uint16_t data_cnt);
+
+typedef struct {
+	UART_BAUDRATE baud_rate;
+	UART_DATABITS data_bits;
+	UART_PARITY parity;
+	UART_STOPBITS stop_bits;
+	UART_AFCE_CFG auto_flow_control;
+	UART_FIFO_CFG use_fifo;
+	UART_TX_FIFO_LEVEL tx_fifo_tr_lvl;
+	UART_RX_FIFO_LEVEL rx_fifo_tr_lvl;
+	uint32_t intr_priority;
+} uart_cfg_t;
+
+void uart_initialize(uart_t *uart_id, const uart_cfg_t *uart_cfg);
+uint8_t uart_read_byte(uart_t *uart_id);
+void uart_write_byte(uart_t *uart_id, uint8_t data);
+void uart_wait_tx_finish(uart_t *uart_id);
+void uart_receive(uart_t *uart_id, uint8_t *data, uint16_t len, UART_OP_CFG op);
+void uart_register_rx_cb(uart_t *uart_id, uart_cb_t cb);
+void uart_rxdata_intr_setf(uart_t *uart_id, UART_BIT_CFG state);
+
+#endif /* _UART_H_ */
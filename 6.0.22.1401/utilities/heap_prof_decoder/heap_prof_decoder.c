@@ -0,0 +1,544 @@
+/**
+ ****************************************************************************************
+ *
+ * @file heap_prof_decoder.c
+ *
+ * @brief Host decoder for the kernel heap profiler records of ke_mem_prof.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#define HEAP_PROF_DECODER_VERSION	"v_1.0"
+
+/* These must match ke_mem_prof.h */
+#define PROF_MARKER		0x1D
+#define PROF_HDR_LEN		4
+#define PROF_REC_INFO		1
+#define PROF_REC_ALLOC		2
+#define PROF_REC_FREE		3
+#define PROF_REC_FAIL		4
+#define PROF_REC_HEAP		5
+#define PROF_HEAP_TRUNCATED	0x01
+#define PROF_HEAP_CORRUPTED	0x02
+#define PROF_HEAP_ON_FAIL	0x04
+
+/* These must match arch_console.h */
+#define DEFERRED_MARKER		0x1E
+#define DEFERRED_HDR_LEN	6
+
+/* Kernel heaps, in the order of the KE_MEM_* heap types */
+#define HEAP_MAX		4
+#define HEAP_SIZE_MAX		0x10000
+
+/* Base time counter of the BLE core: 27 bits, 625 us units */
+#define TIME_MASK		0x07FFFFFF
+
+#define DEFAULT_MAP_WIDTH	64
+
+static const char * const heap_names[HEAP_MAX] = { "ENV", "DB", "MSG", "NONRET" };
+
+struct heap {
+	uint32_t base;
+	uint32_t size;
+	int known;
+};
+
+/* Allocation still live, indexed by heap and offset / 4 */
+struct live {
+	uint32_t time;
+	int site;
+	uint16_t size;
+	uint16_t block;
+	int used;
+};
+
+/* Call site statistics */
+struct site {
+	uint32_t addr;
+	uint8_t heap;
+	uint32_t allocs;
+	uint32_t frees;
+	uint32_t fails;
+	uint32_t live;
+	uint32_t live_bytes;
+	uint32_t peak_bytes;
+	uint64_t lifetime;
+	uint32_t max_lifetime;
+};
+
+static struct heap heaps[HEAP_MAX];
+static struct live *live[HEAP_MAX];
+static struct site *sites;
+static int nb_sites;
+static int max_sites;
+
+static uint64_t now;		/* unwrapped time, 625 us units */
+static uint32_t last_raw;
+static int have_time;
+
+static int next_seq = -1;
+static uint32_t lost;
+static uint32_t unmatched_frees;
+static uint32_t fails;
+
+static int map_width = DEFAULT_MAP_WIDTH;
+static int show_maps;
+static int show_events;
+
+static void usage(const char* my_name)
+{
+	fprintf(stderr,
+		"Version: " HEAP_PROF_DECODER_VERSION "\n"
+		"\n"
+		"Usage:\n"
+		"  %s [-m] [-e] [-w width] [capture_file]\n"
+		"\n"
+		"  Decode the kernel heap profiler records (CFG_KE_MEM_PROF) found\n"
+		"  in the UART capture 'capture_file' (or the standard input).\n"
+		"  The printf text between the records is skipped.\n"
+		"\n"
+		"  The output is a fragmentation timeline, one line per heap snapshot,\n"
+		"  followed by the owners of every heap by call site. A call site is\n"
+		"  the address the allocating function returns to; it can be resolved\n"
+		"  with addr2line against the .axf/.elf of the application.\n"
+		"\n"
+		"  -m        draw the map of every snapshot ('#' used, '+' partly\n"
+		"            used, '.' free). The maps of the snapshots taken on an\n"
+		"            allocation failure are always drawn.\n"
+		"  -e        list every allocation and free\n"
+		"  -w width  width of the maps (default %d)\n",
+		my_name, DEFAULT_MAP_WIDTH);
+}
+
+static uint16_t get_le16(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+static uint32_t get_le32(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+/* Unwrap a time stamp of the 27-bit base time counter */
+static void update_time(uint32_t raw)
+{
+	if (have_time)
+		now += (raw - last_raw) & TIME_MASK;
+	else
+		now = raw;
+	last_raw = raw;
+	have_time = 1;
+}
+
+static double time_ms(uint64_t t)
+{
+	return t * 0.625;
+}
+
+static const char *heap_name(uint8_t heap)
+{
+	return heap < HEAP_MAX ? heap_names[heap] : "?";
+}
+
+static int find_site(uint32_t addr, uint8_t heap)
+{
+	int i;
+
+	for (i = 0; i < nb_sites; i++)
+		if (sites[i].addr == addr && sites[i].heap == heap)
+			return i;
+
+	if (nb_sites == max_sites) {
+		max_sites = max_sites ? 2 * max_sites : 64;
+		sites = realloc(sites, max_sites * sizeof(*sites));
+		if (!sites) {
+			fprintf(stderr, "Out of memory\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	memset(&sites[nb_sites], 0, sizeof(*sites));
+	sites[nb_sites].addr = addr;
+	sites[nb_sites].heap = heap;
+	return nb_sites++;
+}
+
+static struct live *live_entry(uint8_t heap, uint16_t offset)
+{
+	if (heap >= HEAP_MAX)
+		return NULL;
+	return &live[heap][offset / 4];
+}
+
+static void on_info(const uint8_t *p, uint8_t len)
+{
+	int count, i;
+
+	if (len < 5)
+		return;
+
+	update_time(get_le32(p));
+	count = p[4];
+	for (i = 0; i < count && i < HEAP_MAX && 5 + 6 * (i + 1) <= len; i++) {
+		heaps[i].base = get_le32(p + 5 + 6 * i);
+		heaps[i].size = get_le16(p + 9 + 6 * i);
+		heaps[i].known = 1;
+	}
+}
+
+static void on_alloc(const uint8_t *p, uint8_t len)
+{
+	struct live *l;
+	struct site *s;
+	uint16_t size, offset, block;
+	uint32_t site;
+	uint8_t heap;
+
+	if (len < 15)
+		return;
+
+	update_time(get_le32(p));
+	site = get_le32(p + 4) & ~1u;
+	size = get_le16(p + 8);
+	heap = p[10];
+	offset = get_le16(p + 11);
+	block = get_le16(p + 13);
+
+	if (show_events)
+		printf("%10.1f ms  alloc %-6s +0x%04X %5u (%5u) site 0x%08X\n",
+		       time_ms(now), heap_name(heap), offset, size, block, site);
+
+	l = live_entry(heap, offset);
+	if (!l)
+		return;
+
+	/* a live entry at the same place means its free was lost */
+	if (l->used) {
+		s = &sites[l->site];
+		s->live--;
+		s->live_bytes -= l->block;
+	}
+
+	l->time = (uint32_t) now;
+	l->site = find_site(site, heap);
+	l->size = size;
+	l->block = block;
+	l->used = 1;
+
+	s = &sites[l->site];
+	s->allocs++;
+	s->live++;
+	s->live_bytes += block;
+	if (s->live_bytes > s->peak_bytes)
+		s->peak_bytes = s->live_bytes;
+}
+
+static void on_free(const uint8_t *p, uint8_t len)
+{
+	struct live *l;
+	struct site *s;
+	uint32_t lifetime;
+	uint16_t offset;
+	uint8_t heap;
+
+	if (len < 13)
+		return;
+
+	update_time(get_le32(p));
+	heap = p[8];
+	offset = get_le16(p + 9);
+
+	if (show_events)
+		printf("%10.1f ms  free  %-6s +0x%04X %13s site 0x%08X\n",
+		       time_ms(now), heap_name(heap), offset, "", get_le32(p + 4) & ~1u);
+
+	l = live_entry(heap, offset);
+	if (!l || !l->used) {
+		unmatched_frees++;
+		return;
+	}
+
+	lifetime = (uint32_t) now - l->time;
+	s = &sites[l->site];
+	s->frees++;
+	s->live--;
+	s->live_bytes -= l->block;
+	s->lifetime += lifetime;
+	if (lifetime > s->max_lifetime)
+		s->max_lifetime = lifetime;
+	l->used = 0;
+}
+
+static void on_fail(const uint8_t *p, uint8_t len)
+{
+	uint32_t site;
+	uint8_t type;
+
+	if (len < 11)
+		return;
+
+	update_time(get_le32(p));
+	site = get_le32(p + 4) & ~1u;
+	type = p[10];
+	fails++;
+	sites[find_site(site, type)].fails++;
+
+	printf("%10.1f ms  FAIL  %-6s %5u bytes, site 0x%08X\n",
+	       time_ms(now), heap_name(type), get_le16(p + 8), site);
+}
+
+/* Draw the heap from its free blocks: '#' used, '+' partly used, '.' free */
+static void draw_map(uint32_t size, const uint8_t *list, int count)
+{
+	char map[1024];
+	int col, i;
+
+	for (col = 0; col < map_width; col++) {
+		uint32_t start = (uint64_t) size * col / map_width;
+		uint32_t end = (uint64_t) size * (col + 1) / map_width;
+		uint32_t free = 0;
+
+		for (i = 0; i < count; i++) {
+			uint32_t b_start = get_le16(list + 4 * i);
+			uint32_t b_end = b_start + get_le16(list + 4 * i + 2);
+
+			if (b_start < end && b_end > start)
+				free += (b_end < end ? b_end : end) - (b_start > start ? b_start : start);
+		}
+
+		map[col] = free == 0 ? '#' : free >= end - start ? '.' : '+';
+	}
+	map[map_width] = '\0';
+
+	printf("            |%s|\n", map);
+}
+
+static void on_heap(const uint8_t *p, uint8_t len)
+{
+	uint16_t free, largest, blocks;
+	uint8_t heap, flags, count;
+	uint32_t size;
+
+	if (len < 13)
+		return;
+
+	update_time(get_le32(p));
+	heap = p[4];
+	flags = p[5];
+	free = get_le16(p + 6);
+	largest = get_le16(p + 8);
+	blocks = get_le16(p + 10);
+	count = p[12];
+	if (13 + 4 * count > len)
+		return;
+
+	size = heap < HEAP_MAX && heaps[heap].known ? heaps[heap].size : 0;
+
+	printf("%10.1f ms  heap  %-6s used %5u/%-5u free %5u largest %5u blocks %3u frag %3u%%%s%s%s\n",
+	       time_ms(now), heap_name(heap), size > free ? size - free : 0, size, free, largest,
+	       blocks, free ? 100 - 100 * largest / free : 0,
+	       flags & PROF_HEAP_ON_FAIL ? " on-fail" : "",
+	       flags & PROF_HEAP_TRUNCATED ? " truncated" : "",
+	       flags & PROF_HEAP_CORRUPTED ? " CORRUPTED" : "");
+
+	if (size && (show_maps || (flags & PROF_HEAP_ON_FAIL)))
+		draw_map(size, p + 13, count);
+}
+
+static void on_record(const uint8_t *rec)
+{
+	const uint8_t *p = rec + PROF_HDR_LEN;
+	uint8_t len = rec[3];
+
+	if (next_seq >= 0 && rec[2] != next_seq) {
+		uint8_t gap = rec[2] - next_seq;
+
+		/* sent again by the blocking drain before an allocation failure */
+		if (gap >= 128)
+			return;
+
+		lost += gap;
+		printf("%10.1f ms  %u record(s) lost\n", time_ms(now), gap);
+	}
+	next_seq = (uint8_t) (rec[2] + 1);
+
+	switch (rec[1]) {
+	case PROF_REC_INFO:
+		on_info(p, len);
+		break;
+	case PROF_REC_ALLOC:
+		on_alloc(p, len);
+		break;
+	case PROF_REC_FREE:
+		on_free(p, len);
+		break;
+	case PROF_REC_FAIL:
+		on_fail(p, len);
+		break;
+	case PROF_REC_HEAP:
+		on_heap(p, len);
+		break;
+	default:
+		break;
+	}
+}
+
+static void decode_stream(FILE *in)
+{
+	uint8_t rec[PROF_HDR_LEN + 256];
+	int c;
+
+	while ((c = fgetc(in)) != EOF) {
+		if (c == DEFERRED_MARKER) {
+			/* deferred printf record: skip it */
+			if (fread(rec, 1, DEFERRED_HDR_LEN - 1, in) != DEFERRED_HDR_LEN - 1 ||
+			    fread(rec, 1, rec[DEFERRED_HDR_LEN - 2], in) != rec[DEFERRED_HDR_LEN - 2])
+				break;
+			continue;
+		}
+
+		if (c != PROF_MARKER)
+			continue;
+
+		rec[0] = c;
+		if (fread(&rec[1], 1, PROF_HDR_LEN - 1, in) != PROF_HDR_LEN - 1 ||
+		    rec[1] < PROF_REC_INFO || rec[1] > PROF_REC_HEAP)
+			continue;
+
+		if (fread(&rec[PROF_HDR_LEN], 1, rec[3], in) != rec[3])
+			break;
+
+		on_record(rec);
+	}
+}
+
+static int cmp_sites(const void *a, const void *b)
+{
+	const struct site *sa = a;
+	const struct site *sb = b;
+
+	if (sa->heap != sb->heap)
+		return sa->heap - sb->heap;
+	if (sa->live_bytes != sb->live_bytes)
+		return sa->live_bytes < sb->live_bytes ? 1 : -1;
+	if (sa->peak_bytes != sb->peak_bytes)
+		return sa->peak_bytes < sb->peak_bytes ? 1 : -1;
+	return sa->addr < sb->addr ? -1 : sa->addr > sb->addr;
+}
+
+static void print_owners(void)
+{
+	int heap = -1;
+	int i;
+
+	qsort(sites, nb_sites, sizeof(*sites), cmp_sites);
+
+	printf("\nOwners by call site (live at the end of the capture, peak live, lifetimes)\n");
+
+	for (i = 0; i < nb_sites; i++) {
+		const struct site *s = &sites[i];
+
+		if (s->heap != heap) {
+			heap = s->heap;
+			printf("\n  %s\n  %-10s %7s %7s %5s %6s %9s %6s %12s %12s\n", heap_name(heap),
+			       "site", "allocs", "frees", "fails", "live", "live_bytes", "peak",
+			       "mean_life_ms", "max_life_ms");
+		}
+
+		printf("  0x%08X %7u %7u %5u %6u %9u %6u %12.1f %12.1f\n", s->addr, s->allocs,
+		       s->frees, s->fails, s->live, s->live_bytes, s->peak_bytes,
+		       s->frees ? time_ms(s->lifetime) / s->frees : 0.0, time_ms(s->max_lifetime));
+	}
+
+	printf("\n%u allocation failure(s), %u record(s) lost, %u free(s) without allocation\n",
+	       fails, lost, unmatched_frees);
+}
+
+int main(int argc, char **argv)
+{
+	FILE *in = stdin;
+	int opt, i;
+
+	while ((opt = getopt(argc, argv, "mew:")) != -1) {
+		switch (opt) {
+		case 'm':
+			show_maps = 1;
+			break;
+		case 'e':
+			show_events = 1;
+			break;
+		case 'w':
+			map_width = atoi(optarg);
+			if (map_width < 8 || map_width > 1000) {
+				usage(argv[0]);
+				return EXIT_FAILURE;
+			}
+			break;
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (argc - optind > 1) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if (optind < argc) {
+		in = fopen(argv[optind], "rb");
+		if (!in) {
+			fprintf(stderr, "Could not open %s (%s)\n", argv[optind], strerror(errno));
+			return EXIT_FAILURE;
+		}
+	}
+
+	for (i = 0; i < HEAP_MAX; i++) {
+		live[i] = calloc(HEAP_SIZE_MAX / 4, sizeof(struct live));
+		if (!live[i]) {
+			fprintf(stderr, "Out of memory\n");
+			return EXIT_FAILURE;
+		}
+	}
+
+	decode_stream(in);
+	print_owners();
+
+	if (in != stdin)
+		fclose(in);
+	for (i = 0; i < HEAP_MAX; i++)
+		free(live[i]);
+	free(sites);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,807 @@
+/**
+ ****************************************************************************************
+ *
+ * @file heap_replay.c
+ *
+ * @brief Replay of allocation traces against a host model of the kernel heaps.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#define HEAP_REPLAY_VERSION	"v_1.0"
+
+/* These must match ke_mem_prof.h */
+#define PROF_MARKER		0x1D
+#define PROF_HDR_LEN		4
+#define PROF_REC_INFO		1
+#define PROF_REC_ALLOC		2
+#define PROF_REC_FREE		3
+#define PROF_REC_FAIL		4
+#define PROF_REC_HEAP		5
+#define PROF_HEAP_TRUNCATED	0x01
+#define PROF_HEAP_ON_FAIL	0x04
+#define PROF_BLOCKS		60
+
+/* These must match arch_console.h */
+#define DEFERRED_MARKER		0x1E
+#define DEFERRED_HDR_LEN	6
+
+/* Kernel heaps, in the order of the KE_MEM_* heap types */
+#define HEAP_MAX		4
+#define HEAP_SIZE_MAX		0x10000
+
+/* Block descriptors of the heap manager */
+#define USED_DESC_SIZE		4
+#define FREE_DESC_SIZE		12
+
+/* Allocations tracked at the same time */
+#define MAX_IDS			0x10000
+
+#define DEFAULT_MAP_WIDTH	64
+
+static const char * const heap_names[HEAP_MAX] = { "ENV", "DB", "MSG", "NONRET" };
+
+/* Default heap sizes, as in a single connection DA14531 build */
+static const uint16_t default_sizes[HEAP_MAX] = { 1260, 1024, 1372, 1024 };
+
+struct blk {
+	uint16_t offset;
+	uint16_t size;
+};
+
+/*
+ * Model of a kernel heap. The free list is kept in address order. Its first
+ * block is at the base of the heap and is never unlinked, so an allocation
+ * taken from it always leaves room for its descriptor.
+ */
+struct heap {
+	uint32_t size;
+	struct blk free[HEAP_SIZE_MAX / FREE_DESC_SIZE + 1];
+	int nb_free;
+	/* statistics, as in struct mem_usage_log */
+	uint32_t used;
+	uint32_t max_used;
+	uint32_t used_other;
+	uint32_t max_used_other;
+	uint32_t fails;
+	uint32_t min_largest;
+};
+
+struct alloc {
+	uint8_t heap;
+	uint8_t type;
+	uint16_t offset;
+	uint16_t block;
+	int used;
+};
+
+static struct heap heaps[HEAP_MAX];
+static struct alloc allocs[MAX_IDS];
+static int borrow = 1;
+static int verbose;
+static int map_width = DEFAULT_MAP_WIDTH;
+
+static uint32_t nb_allocs;
+static uint32_t nb_frees;
+static uint32_t nb_fails;
+
+/* profiler stream written with -o */
+static FILE *out;
+static uint8_t out_seq;
+static uint32_t out_time;
+static uint32_t snapshot_every;
+
+/* comparison with a device capture */
+static uint32_t placed_same;
+static uint32_t placed_total;
+
+static void usage(const char* my_name)
+{
+	fprintf(stderr,
+		"Version: " HEAP_REPLAY_VERSION "\n"
+		"\n"
+		"Usage:\n"
+		"  %s [options] trace_file\n"
+		"  %s [options] -c capture_file\n"
+		"  %s [options] -g count[,seed]\n"
+		"\n"
+		"  Replay an allocation trace against a model of the kernel heaps\n"
+		"  (first fit in address order, blocks taken from the end of a free\n"
+		"  block, free blocks merged with their neighbours) and report the\n"
+		"  heap usage as disp_heaplog() does, with the allocation failures\n"
+		"  and the fragmentation.\n"
+		"\n"
+		"  trace_file     text trace, one operation per line:\n"
+		"                   a <id> <size> <type>   allocate (type 0 ENV, 1 DB,\n"
+		"                                          2 MSG, 3 NONRET)\n"
+		"                   f <id>                 free\n"
+		"                   t <ms>                 advance the time\n"
+		"                   s                      heap snapshot (-o)\n"
+		"                 Lines starting with '#' are ignored.\n"
+		"  -c capture     replay the allocations of a heap profiler capture\n"
+		"                 (CFG_KE_MEM_PROF) and count the blocks placed where\n"
+		"                 the device placed them. The heap sizes of the\n"
+		"                 capture are used unless -s is given.\n"
+		"  -g count,seed  replay a generated workload of 'count' operations\n"
+		"\n"
+		"Options:\n"
+		"  -s env,db,msg,nonret  heap sizes (default %u,%u,%u,%u)\n"
+		"  -n                    do not allocate from the other heaps when a heap\n"
+		"                        is full\n"
+		"  -v                    draw the heaps at every failure\n"
+		"  -w width              width of the maps (default %d)\n"
+		"  -o file               write the replay as a heap profiler stream, with a\n"
+		"                        snapshot every 'n' operations (-S n, default 100),\n"
+		"                        to be read by heap_prof_decoder\n",
+		my_name, my_name, my_name, default_sizes[0], default_sizes[1],
+		default_sizes[2], default_sizes[3], DEFAULT_MAP_WIDTH);
+}
+
+/*
+ * Profiler stream output
+ */
+
+static uint8_t *put16(uint8_t *p, uint16_t val)
+{
+	p[0] = val;
+	p[1] = val >> 8;
+	return p + 2;
+}
+
+static uint8_t *put32(uint8_t *p, uint32_t val)
+{
+	p = put16(p, val);
+	return put16(p, val >> 16);
+}
+
+static void out_record(uint8_t *rec, uint8_t type, const uint8_t *end)
+{
+	rec[0] = PROF_MARKER;
+	rec[1] = type;
+	rec[2] = out_seq++;
+	rec[3] = end - rec - PROF_HDR_LEN;
+	fwrite(rec, 1, end - rec, out);
+}
+
+static void out_heap(int h, uint8_t flags)
+{
+	const struct heap *heap = &heaps[h];
+	uint8_t rec[PROF_HDR_LEN + 13 + 4 * PROF_BLOCKS];
+	uint8_t *p = put32(rec + PROF_HDR_LEN, out_time);
+	uint8_t *list = rec + PROF_HDR_LEN + 13;
+	uint32_t total = 0;
+	uint16_t largest = 0;
+	int i;
+
+	for (i = 0; i < heap->nb_free; i++) {
+		total += heap->free[i].size;
+		if (heap->free[i].size > largest)
+			largest = heap->free[i].size;
+		if (i < PROF_BLOCKS) {
+			list = put16(list, heap->free[i].offset);
+			list = put16(list, heap->free[i].size);
+		}
+	}
+	if (heap->nb_free > PROF_BLOCKS)
+		flags |= PROF_HEAP_TRUNCATED;
+
+	*p++ = h;
+	*p++ = flags;
+	p = put16(p, total);
+	p = put16(p, largest);
+	p = put16(p, heap->nb_free);
+	*p++ = heap->nb_free > PROF_BLOCKS ? PROF_BLOCKS : heap->nb_free;
+	out_record(rec, PROF_REC_HEAP, list);
+}
+
+static void out_snapshot(uint8_t flags)
+{
+	uint8_t rec[PROF_HDR_LEN + 5 + 6 * HEAP_MAX];
+	uint8_t *p = put32(rec + PROF_HDR_LEN, out_time);
+	int h;
+
+	*p++ = HEAP_MAX;
+	for (h = 0; h < HEAP_MAX; h++) {
+		p = put32(p, 0x07FC0000 + 0x1000 * h);
+		p = put16(p, heaps[h].size);
+	}
+	out_record(rec, PROF_REC_INFO, p);
+
+	for (h = 0; h < HEAP_MAX; h++)
+		out_heap(h, flags);
+}
+
+/*
+ * Heap model
+ */
+
+static void heap_init(int h, uint32_t size)
+{
+	struct heap *heap = &heaps[h];
+
+	memset(heap, 0, sizeof(*heap));
+	heap->size = size & ~3u;
+	heap->free[0].offset = 0;
+	heap->free[0].size = heap->size;
+	heap->nb_free = 1;
+	heap->min_largest = heap->size;
+}
+
+static uint16_t heap_largest(const struct heap *heap)
+{
+	uint16_t largest = 0;
+	int i;
+
+	for (i = 0; i < heap->nb_free; i++)
+		if (heap->free[i].size > largest)
+			largest = heap->free[i].size;
+	return largest;
+}
+
+static uint32_t heap_free(const struct heap *heap)
+{
+	uint32_t total = 0;
+	int i;
+
+	for (i = 0; i < heap->nb_free; i++)
+		total += heap->free[i].size;
+	return total;
+}
+
+/* Take a block of 'total' bytes from a heap, return its offset or -1 */
+static int heap_take(struct heap *heap, uint16_t total, uint16_t *block)
+{
+	int i;
+
+	for (i = 0; i < heap->nb_free; i++) {
+		struct blk *b = &heap->free[i];
+
+		if (b->size >= total + FREE_DESC_SIZE) {
+			/* the free block keeps its descriptor, the block is cut from its end */
+			b->size -= total;
+			*block = total;
+			return b->offset + b->size;
+		}
+
+		if (i && b->size >= total) {
+			/* the whole free block is taken */
+			int offset = b->offset;
+
+			*block = b->size;
+			memmove(b, b + 1, (heap->nb_free - i - 1) * sizeof(*b));
+			heap->nb_free--;
+			return offset;
+		}
+	}
+
+	return -1;
+}
+
+static void heap_give(struct heap *heap, uint16_t offset, uint16_t size)
+{
+	struct blk *prev, *next;
+	int i;
+
+	/* the first free block is at the base, so every block has a previous free block */
+	for (i = 1; i < heap->nb_free && heap->free[i].offset < offset; i++)
+		;
+
+	prev = &heap->free[i - 1];
+	next = i < heap->nb_free ? &heap->free[i] : NULL;
+
+	if (prev->offset + prev->size == offset) {
+		prev->size += size;
+		if (next && prev->offset + prev->size == next->offset) {
+			prev->size += next->size;
+			memmove(next, next + 1, (heap->nb_free - i - 1) * sizeof(*next));
+			heap->nb_free--;
+		}
+		return;
+	}
+
+	if (next && offset + size == next->offset) {
+		next->offset = offset;
+		next->size += size;
+		return;
+	}
+
+	memmove(&heap->free[i + 1], &heap->free[i], (heap->nb_free - i) * sizeof(*next));
+	heap->free[i].offset = offset;
+	heap->free[i].size = size;
+	heap->nb_free++;
+}
+
+static void draw_map(int h)
+{
+	const struct heap *heap = &heaps[h];
+	char map[1024];
+	int col, i;
+
+	for (col = 0; col < map_width; col++) {
+		uint32_t start = (uint64_t) heap->size * col / map_width;
+		uint32_t end = (uint64_t) heap->size * (col + 1) / map_width;
+		uint32_t free = 0;
+
+		for (i = 0; i < heap->nb_free; i++) {
+			uint32_t b_start = heap->free[i].offset;
+			uint32_t b_end = b_start + heap->free[i].size;
+
+			if (b_start < end && b_end > start)
+				free += (b_end < end ? b_end : end) - (b_start > start ? b_start : start);
+		}
+
+		map[col] = free == 0 ? '#' : free >= end - start ? '.' : '+';
+	}
+	map[map_width] = '\0';
+
+	printf("  %-6s |%s| free %5u largest %5u blocks %3d\n", heap_names[h], map,
+	       heap_free(heap), heap_largest(heap), heap->nb_free);
+}
+
+/* Allocate, return the heap and offset of the block or -1 */
+static int model_malloc(uint32_t id, uint16_t size, uint8_t type, int *offset)
+{
+	uint16_t total = ((size + 3) & ~3u) + USED_DESC_SIZE;
+	uint16_t block = 0;
+	int cursor, h;
+
+	if (total < FREE_DESC_SIZE)
+		total = FREE_DESC_SIZE;
+
+	for (cursor = 0; cursor < (borrow ? HEAP_MAX : 1); cursor++) {
+		h = (type + cursor) % HEAP_MAX;
+		*offset = heap_take(&heaps[h], total, &block);
+		if (*offset >= 0)
+			break;
+	}
+
+	nb_allocs++;
+
+	if (*offset < 0) {
+		struct heap *heap = &heaps[type];
+		uint16_t largest = heap_largest(heap);
+
+		nb_fails++;
+		heap->fails++;
+		if (largest < heap->min_largest)
+			heap->min_largest = largest;
+
+		if (verbose) {
+			printf("FAIL #%u: %u bytes (block %u) in %s, free %u largest %u\n",
+			       nb_allocs, size, total, heap_names[type], heap_free(heap), largest);
+			for (h = 0; h < HEAP_MAX; h++)
+				draw_map(h);
+		}
+
+		if (out) {
+			uint8_t rec[PROF_HDR_LEN + 11];
+			uint8_t *p = put32(rec + PROF_HDR_LEN, out_time);
+
+			p = put32(p, 0x07FC1000 + 4 * (id % 64));
+			p = put16(p, size);
+			*p++ = type;
+			out_record(rec, PROF_REC_FAIL, p);
+			out_snapshot(PROF_HEAP_ON_FAIL);
+		}
+		return -1;
+	}
+
+	if (h == type) {
+		heaps[type].used += block;
+		if (heaps[type].used > heaps[type].max_used)
+			heaps[type].max_used = heaps[type].used;
+	} else {
+		heaps[type].used_other += block;
+		if (heaps[type].used_other > heaps[type].max_used_other)
+			heaps[type].max_used_other = heaps[type].used_other;
+	}
+
+	allocs[id].heap = h;
+	allocs[id].type = type;
+	allocs[id].offset = *offset;
+	allocs[id].block = block;
+	allocs[id].used = 1;
+
+	if (out) {
+		uint8_t rec[PROF_HDR_LEN + 15];
+		uint8_t *p = put32(rec + PROF_HDR_LEN, out_time);
+
+		/* the trace has no call sites: one pseudo site per id class */
+		p = put32(p, 0x07FC1000 + 4 * (id % 64));
+		p = put16(p, size);
+		*p++ = h;
+		p = put16(p, *offset + USED_DESC_SIZE);
+		p = put16(p, block);
+		out_record(rec, PROF_REC_ALLOC, p);
+	}
+
+	return h;
+}
+
+static int model_free(uint32_t id)
+{
+	struct alloc *a = &allocs[id];
+
+	if (!a->used)
+		return -1;
+
+	heap_give(&heaps[a->heap], a->offset, a->block);
+	if (a->heap == a->type)
+		heaps[a->type].used -= a->block;
+	else
+		heaps[a->type].used_other -= a->block;
+	a->used = 0;
+	nb_frees++;
+
+	if (out) {
+		uint8_t rec[PROF_HDR_LEN + 13];
+		uint8_t *p = put32(rec + PROF_HDR_LEN, out_time);
+
+		p = put32(p, 0x07FC2000);
+		*p++ = a->heap;
+		p = put16(p, a->offset + USED_DESC_SIZE);
+		p = put16(p, a->block);
+		out_record(rec, PROF_REC_FREE, p);
+	}
+
+	return 0;
+}
+
+static void tick(void)
+{
+	static uint32_t ops;
+
+	if (out && snapshot_every && ++ops % snapshot_every == 0)
+		out_snapshot(0);
+}
+
+/*
+ * Trace readers
+ */
+
+static int replay_text(FILE *in)
+{
+	char line[256];
+	int lineno = 0;
+
+	while (fgets(line, sizeof(line), in)) {
+		unsigned long id, size, type, ms;
+		int offset;
+
+		lineno++;
+		if (line[0] == '#' || line[0] == '\n' || line[0] == '\r')
+			continue;
+
+		if (sscanf(line, "a %lu %lu %lu", &id, &size, &type) == 3 && id < MAX_IDS &&
+		    size < HEAP_SIZE_MAX && type < HEAP_MAX) {
+			if (allocs[id].used)
+				fprintf(stderr, "line %d: id %lu is already allocated\n", lineno, id);
+			else
+				model_malloc(id, size, type, &offset);
+		} else if (sscanf(line, "f %lu", &id) == 1 && id < MAX_IDS) {
+			if (model_free(id))
+				fprintf(stderr, "line %d: id %lu is not allocated\n", lineno, id);
+		} else if (sscanf(line, "t %lu", &ms) == 1) {
+			out_time += ms * 8 / 5;
+			continue;
+		} else if (line[0] == 's') {
+			if (out)
+				out_snapshot(0);
+			continue;
+		} else {
+			fprintf(stderr, "line %d: invalid operation: %s", lineno, line);
+			return -1;
+		}
+		tick();
+	}
+
+	return 0;
+}
+
+/*
+ * Replay of a device capture. The allocations are identified by their place in
+ * the device heaps, so a free finds its allocation even if the model placed it
+ * elsewhere.
+ */
+static int replay_capture(FILE *in, int sizes_given)
+{
+	static uint32_t ids[HEAP_MAX][HEAP_SIZE_MAX / 4];
+	uint8_t rec[PROF_HDR_LEN + 256];
+	uint32_t next_id = 1;
+	int c;
+
+	while ((c = fgetc(in)) != EOF) {
+		const uint8_t *p = rec + PROF_HDR_LEN;
+		int h, offset;
+
+		if (c == DEFERRED_MARKER) {
+			if (fread(rec, 1, DEFERRED_HDR_LEN - 1, in) != DEFERRED_HDR_LEN - 1 ||
+			    fread(rec, 1, rec[DEFERRED_HDR_LEN - 2], in) != rec[DEFERRED_HDR_LEN - 2])
+				break;
+			continue;
+		}
+
+		if (c != PROF_MARKER)
+			continue;
+
+		if (fread(&rec[1], 1, PROF_HDR_LEN - 1, in) != PROF_HDR_LEN - 1 ||
+		    rec[1] < PROF_REC_INFO || rec[1] > PROF_REC_HEAP)
+			continue;
+		if (fread(&rec[PROF_HDR_LEN], 1, rec[3], in) != rec[3])
+			break;
+
+		out_time = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+
+		if (rec[1] == PROF_REC_INFO && !sizes_given && next_id == 1 && rec[3] >= 5) {
+			for (h = 0; h < p[4] && h < HEAP_MAX && 5 + 6 * (h + 1) <= rec[3]; h++)
+				heap_init(h, p[9 + 6 * h] | (p[10 + 6 * h] << 8));
+		} else if (rec[1] == PROF_REC_ALLOC && rec[3] >= 15) {
+			uint16_t size = p[8] | (p[9] << 8);
+			uint8_t heap = p[10];
+			uint16_t dev_offset = p[11] | (p[12] << 8);
+			uint32_t id = next_id++ % MAX_IDS;
+
+			if (heap >= HEAP_MAX)
+				continue;
+
+			/* the requested type is not in the record, the device heap is the best guess */
+			if (allocs[id].used)
+				model_free(id);
+			h = model_malloc(id, size, heap, &offset);
+			ids[heap][dev_offset / 4] = id;
+			placed_total++;
+			if (h == heap && offset + USED_DESC_SIZE == dev_offset)
+				placed_same++;
+			tick();
+		} else if (rec[1] == PROF_REC_FREE && rec[3] >= 13) {
+			uint8_t heap = p[8];
+			uint16_t dev_offset = p[9] | (p[10] << 8);
+
+			if (heap >= HEAP_MAX || !ids[heap][dev_offset / 4])
+				continue;
+
+			model_free(ids[heap][dev_offset / 4]);
+			ids[heap][dev_offset / 4] = 0;
+			tick();
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Generated workload: long lived environment and database allocations made
+ * early, short lived messages, and connection buffers in the non retained heap.
+ */
+static uint32_t rnd_state;
+
+static uint32_t rnd(void)
+{
+	rnd_state = rnd_state * 1103515245 + 12345;
+	return (rnd_state >> 16) & 0x7FFF;
+}
+
+static void replay_generated(uint32_t count)
+{
+	static uint32_t live_ids[MAX_IDS];
+	uint32_t nb_live = 0;
+	uint32_t next_id = 0;
+	uint32_t i;
+
+	for (i = 0; i < count; i++) {
+		uint32_t r = rnd() % 100;
+		int offset;
+
+		out_time += 1 + rnd() % 16;
+
+		if (nb_live && (r < 45 || nb_live > 48)) {
+			/* free: mostly the recent messages, sometimes an old block */
+			uint32_t k = rnd() % 4 ? nb_live - 1 - rnd() % (nb_live < 8 ? nb_live : 8)
+					       : rnd() % nb_live;
+
+			model_free(live_ids[k]);
+			live_ids[k] = live_ids[--nb_live];
+		} else {
+			uint8_t type;
+			uint16_t size;
+			uint32_t id = next_id++ % MAX_IDS;
+
+			if (allocs[id].used)
+				continue;
+
+			if (r < 80) {
+				type = 2;
+				size = 8 + rnd() % 64;
+			} else if (r < 90) {
+				type = 0;
+				size = 16 + rnd() % 96;
+			} else if (r < 95) {
+				type = 3;
+				size = 32 + rnd() % 224;
+			} else {
+				type = 1;
+				size = 8 + rnd() % 48;
+			}
+
+			if (model_malloc(id, size, type, &offset) >= 0)
+				live_ids[nb_live++] = id;
+		}
+		tick();
+	}
+}
+
+static void report(void)
+{
+	int h;
+
+	printf("\n*** Memory Logging Results (model) ***\n\n");
+
+	for (h = 0; h < HEAP_MAX; h++) {
+		const struct heap *heap = &heaps[h];
+
+		printf(">>> %s HEAP (%u bytes) <<<\n", heap_names[h], heap->size);
+		printf("Used size in this HEAP  : %4u (current) - %4u (maximum)\n",
+		       heap->used, heap->max_used);
+		printf("Used size in other HEAPs: %4u (current) - %4u (maximum)\n",
+		       heap->used_other, heap->max_used_other);
+		printf("Failures                : %4u", heap->fails);
+		if (heap->fails)
+			printf(" (smallest largest free block %u)", heap->min_largest);
+		printf("\n\n");
+	}
+
+	printf("Heaps at the end of the replay:\n");
+	for (h = 0; h < HEAP_MAX; h++)
+		draw_map(h);
+
+	printf("\n%u allocations, %u frees, %u failures\n", nb_allocs, nb_frees, nb_fails);
+	if (placed_total)
+		printf("%u of %u blocks placed where the device placed them\n",
+		       placed_same, placed_total);
+}
+
+int main(int argc, char **argv)
+{
+	const char *capture = NULL;
+	const char *out_name = NULL;
+	unsigned long count = 0, seed = 1;
+	unsigned sizes[HEAP_MAX];
+	int sizes_given = 0;
+	FILE *in = NULL;
+	int opt, h, ret;
+
+	snapshot_every = 100;
+
+	for (h = 0; h < HEAP_MAX; h++)
+		sizes[h] = default_sizes[h];
+
+	while ((opt = getopt(argc, argv, "s:nvw:o:S:c:g:")) != -1) {
+		switch (opt) {
+		case 's':
+			if (sscanf(optarg, "%u,%u,%u,%u", &sizes[0], &sizes[1], &sizes[2],
+				   &sizes[3]) != HEAP_MAX) {
+				usage(argv[0]);
+				return EXIT_FAILURE;
+			}
+			for (h = 0; h < HEAP_MAX; h++) {
+				if (sizes[h] < FREE_DESC_SIZE || sizes[h] >= HEAP_SIZE_MAX) {
+					fprintf(stderr, "Invalid heap size %u\n", sizes[h]);
+					return EXIT_FAILURE;
+				}
+			}
+			sizes_given = 1;
+			break;
+		case 'n':
+			borrow = 0;
+			break;
+		case 'v':
+			verbose = 1;
+			break;
+		case 'w':
+			map_width = atoi(optarg);
+			if (map_width < 8 || map_width > 1000) {
+				usage(argv[0]);
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'o':
+			out_name = optarg;
+			break;
+		case 'S':
+			snapshot_every = strtoul(optarg, NULL, 0);
+			break;
+		case 'c':
+			capture = optarg;
+			break;
+		case 'g':
+			if (sscanf(optarg, "%lu,%lu", &count, &seed) < 1 || !count) {
+				usage(argv[0]);
+				return EXIT_FAILURE;
+			}
+			break;
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if ((capture != NULL) + (count != 0) + (optind < argc) != 1 || optind + 1 < argc) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	for (h = 0; h < HEAP_MAX; h++)
+		heap_init(h, sizes[h]);
+
+	if (capture || optind < argc) {
+		const char *name = capture ? capture : argv[optind];
+
+		in = fopen(name, capture ? "rb" : "r");
+		if (!in) {
+			fprintf(stderr, "Could not open %s (%s)\n", name, strerror(errno));
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (out_name) {
+		out = fopen(out_name, "wb");
+		if (!out) {
+			fprintf(stderr, "Could not open %s (%s)\n", out_name, strerror(errno));
+			return EXIT_FAILURE;
+		}
+		out_snapshot(0);
+	}
+
+	if (capture) {
+		ret = replay_capture(in, sizes_given);
+	} else if (count) {
+		rnd_state = seed;
+		replay_generated(count);
+		ret = 0;
+	} else {
+		ret = replay_text(in);
+	}
+
+	if (out) {
+		out_snapshot(0);
+		fclose(out);
+	}
+	if (in)
+		fclose(in);
+
+	if (ret)
+		return EXIT_FAILURE;
+
+	report();
+
+	return nb_fails ? 2 : EXIT_SUCCESS;
+}
@@ -0,0 +1,88 @@
+/**
+ ****************************************************************************************
+ *
+ * @file arch.h
+ *
+ * @brief Architecture definitions of the host builds.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _ARCH_H_
+#define _ARCH_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+#include "compiler.h"
+
+/* No retention RAM on the host */
+#define __SECTION_ZERO(s)
+#define __SECTION(s)
+
+/* Typical value, as in sdk/platform/arch/arch.h for DA14531 */
+#define DEFAULT_TEMPERATURE_CAL_VAL	(30272)
+
+typedef enum
+{
+	mode_active = 0,
+	mode_idle,
+	mode_ext_sleep,
+	mode_ext_sleep_otp_copy,
+	mode_sleeping,
+} sleep_mode_t;
+
+/*
+ * The host builds are single threaded: the "interrupts" are run by the tool between
+ * main loop calls. A tool that times critical sections defines HOST_SHIM_IRQ_HOOKS and
+ * provides host_irq_disable() and host_irq_restore().
+ */
+#if defined (HOST_SHIM_IRQ_HOOKS)
+void host_irq_disable(void);
+void host_irq_restore(void);
+
+#define GLOBAL_INT_DISABLE()		do { host_irq_disable();
+#define GLOBAL_INT_RESTORE()		host_irq_restore(); } while (0)
+#else
+#define GLOBAL_INT_DISABLE()		do {
+#define GLOBAL_INT_RESTORE()		} while (0)
+#endif
+
+/*
+ * A tool that checks how a module reports an error defines HOST_SHIM_ASSERT_HOOKS and
+ * provides host_assert_warning(), called for every ASSERT_WARNING().
+ */
+#if defined (HOST_SHIM_ASSERT_HOOKS)
+void host_assert_warning(bool cond, const char *expr);
+
+#define ASSERT_WARNING(cond)		host_assert_warning(!!(cond), #cond)
+#else
+#define ASSERT_WARNING(cond)		assert(cond)
+#endif
+#define ASSERT_ERROR(cond)		assert(cond)
+#define ASSERT_INFO(cond)		assert(cond)
+
+#endif /* _ARCH_H_ */
@@ -0,0 +1,151 @@
+/**
+ ****************************************************************************************
+ *
+ * @file datasheet.h
+ *
+ * @brief Register access of the host builds, DA14531 register subset.
+ *        register model.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _DATASHEET_H_
+#define _DATASHEET_H_
+
+#include <stdint.h>
+#include "compiler.h"
+
+/*
+ * Register model. host_shim/src/host_regs.c provides a plain register file; a tool
+ * that models a peripheral defines its own host_reg_read() and host_reg_write().
+ */
+uint32_t host_reg_read(uint32_t addr);
+void host_reg_write(uint32_t addr, uint32_t value);
+
+#define SetWord16(a,d)			host_reg_write((a), (uint16_t)(d))
+#define GetWord16(a)			((uint16_t)host_reg_read(a))
+#define SetWord32(a,d)			host_reg_write((a), (uint32_t)(d))
+#define GetWord32(a)			host_reg_read(a)
+
+/* Data access macros, as in da14531.h */
+#define SHIF16(a) ((a)&0x0001? 0:(a)&0x0002? 1:(a)&0x0004? 2:(a)&0x0008? 3: \
+                   (a)&0x0010? 4:(a)&0x0020? 5:(a)&0x0040? 6:(a)&0x0080? 7: \
+                   (a)&0x0100? 8:(a)&0x0200? 9:(a)&0x0400?10:(a)&0x0800?11: \
+                   (a)&0x1000?12:(a)&0x2000?13:(a)&0x4000?14:           15)
+
+#define SetBits16(a,f,d) ( SetWord16( (a), (GetWord16(a)&(~(uint16_t)(f))) | (((uint16_t)(d))<<SHIF16((f))) ))
+#define GetBits16(a,f) ( (GetWord16(a)&( (uint16_t)(f) )) >> SHIF16(f) )
+
+#define SHIF32(a)((a)&0x00000001? 0:(a)&0x00000002? 1:(a)&0x00000004? 2:(a)&0x00000008? 3:\
+                  (a)&0x00000010? 4:(a)&0x00000020? 5:(a)&0x00000040? 6:(a)&0x00000080? 7:\
+                  (a)&0x00000100? 8:(a)&0x00000200? 9:(a)&0x00000400?10:(a)&0x00000800?11:\
+                  (a)&0x00001000?12:(a)&0x00002000?13:(a)&0x00004000?14:(a)&0x00008000?15:\
+                  (a)&0x00010000?16:(a)&0x00020000?17:(a)&0x00040000?18:(a)&0x00080000?19:\
+                  (a)&0x00100000?20:(a)&0x00200000?21:(a)&0x00400000?22:(a)&0x00800000?23:\
+                  (a)&0x01000000?24:(a)&0x02000000?25:(a)&0x04000000?26:(a)&0x08000000?27:\
+                  (a)&0x10000000?28:(a)&0x20000000?29:(a)&0x40000000?30:           31)
+
+#define SetBits32(a,f,d) ( SetWord32( (a), (GetWord32(a)&(~(uint32_t)(f))) | (((uint32_t)(d))<<SHIF32((f))) ))
+#define GetBits32(a,f) ( (GetWord32(a)&( (uint32_t)(f) )) >> SHIF32(f) )
+
+/* Interrupt numbers, from da14531.h */
+typedef enum {
+	UART_IRQn = 2,
+	UART2_IRQn = 3,
+	I2C_IRQn = 4,
+	SPI_IRQn = 5,
+	ADC_IRQn = 6,
+	DMA_IRQn = 19,
+} IRQn_Type;
+
+#define NVIC_DisableIRQ(irq)		((void)(irq))
+#define NVIC_EnableIRQ(irq)		((void)(irq))
+#define NVIC_ClearPendingIRQ(irq)	((void)(irq))
+#define NVIC_SetPriority(irq, prio)	((void)(irq), (void)(prio))
+
+/* Clock and BLE sleep state, from da14531.h */
+#define CLK_RADIO_REG                   (0x50000008)
+#define BLE_ENABLE                      (0x0080)
+#define BLE_DEEPSLCNTL_REG              (0x40000030)
+#define DEEP_SLEEP_STAT                 (0x8000)
+
+/* Watchdog, from da14531.h */
+#define WATCHDOG_REG                    (0x50003100)
+#define WATCHDOG_REG_RESET              (0x000000FF)
+
+/* GP ADC registers, from da14531.h */
+#define GP_ADC_CTRL2_REG                (0x50001502)
+#define GP_ADC_CTRL2_REG_RESET          (0x00000210)
+#define GP_ADC_ATTN                     (0x0003)
+#define GP_ADC_I20U                     (0x0004)
+#define GP_ADC_OFFS_SH_EN               (0x0008)
+#define GP_ADC_OFFS_SH_CM               (0x0030)
+#define GP_ADC_CONV_NRS                 (0x01C0)
+#define GP_ADC_SMPL_TIME                (0x1E00)
+#define GP_ADC_STORE_DEL                (0xE000)
+#define GP_ADC_CTRL3_REG                (0x50001504)
+#define GP_ADC_CTRL3_REG_RESET          (0x00000040)
+#define GP_ADC_EN_DEL                   (0x00FF)
+#define GP_ADC_INTERVAL                 (0xFF00)
+#define GP_ADC_OFFP_REG                 (0x50001508)
+#define GP_ADC_OFFP_REG_RESET           (0x00000200)
+#define GP_ADC_OFFP                     (0x03FF)
+#define GP_ADC_OFFN_REG                 (0x5000150A)
+#define GP_ADC_OFFN_REG_RESET           (0x00000200)
+#define GP_ADC_OFFN                     (0x03FF)
+#define GP_ADC_TRIM_REG                 (0x5000150C)
+#define GP_ADC_TRIM_REG_RESET           (0x00000038)
+#define GP_ADC_OFFS_SH_VREF             (0x000F)
+#define GP_ADC_LDO_LEVEL                (0x0070)
+#define GP_ADC_CLEAR_INT_REG            (0x5000150E)
+#define GP_ADC_CLEAR_INT_REG_RESET      (0x00000000)
+#define GP_ADC_CLR_INT                  (0xFFFF)
+#define GP_ADC_RESULT_REG               (0x50001510)
+#define GP_ADC_RESULT_REG_RESET         (0x00000000)
+#define GP_ADC_VAL                      (0xFFFF)
+#define GP_ADC_CTRL_REG                 (0x50001500)
+#define GP_ADC_CTRL_REG_RESET           (0x00000000)
+#define GP_ADC_EN                       (0x0001)
+#define GP_ADC_START                    (0x0002)
+#define GP_ADC_CONT                     (0x0004)
+#define GP_ADC_DMA_EN                   (0x0008)
+#define GP_ADC_INT                      (0x0010)
+#define GP_ADC_MINT                     (0x0020)
+#define GP_ADC_SE                       (0x0040)
+#define GP_ADC_MUTE                     (0x0080)
+#define GP_ADC_SIGN                     (0x0100)
+#define GP_ADC_CHOP                     (0x0200)
+#define GP_ADC_LDO_HOLD                 (0x0400)
+#define GP_ADC_OFFS_SH_GAIN_SEL         (0x0800)
+#define DIE_TEMP_EN                     (0x1000)
+#define GP_ADC_SEL_REG                  (0x50001506)
+#define GP_ADC_SEL_REG_RESET            (0x00000000)
+#define GP_ADC_SEL_N                    (0x0007)
+#define GP_ADC_SEL_N_TST                (0x0008)
+#define GP_ADC_SEL_P                    (0x0070)
+#define GP_ADC_SEL_P_TST                (0x0080)
+
+#endif /* _DATASHEET_H_ */
@@ -0,0 +1,89 @@
+/**
+ ****************************************************************************************
+ *
+ * @file gpio.h
+ *
+ * @brief GPIO driver API of the host builds.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _GPIO_H_
+#define _GPIO_H_
+
+/* The host builds have no pads: the configuration calls do nothing */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "datasheet.h"
+
+typedef enum {
+	INPUT = 0,
+	INPUT_PULLUP = 0x100,
+	INPUT_PULLDOWN = 0x200,
+	OUTPUT = 0x300,
+} GPIO_PUPD;
+
+typedef enum {
+	GPIO_PORT_0 = 0U,
+	GPIO_PORT_1,
+	GPIO_PORT_2,
+	GPIO_PORT_3,
+} GPIO_PORT;
+
+typedef enum {
+	GPIO_PIN_0 = 0U,
+	GPIO_PIN_1,
+	GPIO_PIN_2,
+	GPIO_PIN_3,
+	GPIO_PIN_4,
+	GPIO_PIN_5,
+	GPIO_PIN_6,
+	GPIO_PIN_7,
+	GPIO_PIN_8,
+	GPIO_PIN_9,
+	GPIO_PIN_10,
+	GPIO_PIN_11,
+} GPIO_PIN;
+
+typedef enum {
+	PID_GPIO = 0,
+	PID_UART1_RX,
+	PID_UART1_TX,
+	PID_I2C_SCL,
+	PID_I2C_SDA,
+	PID_SPI_DI,
+	PID_SPI_DO,
+	PID_SPI_CLK,
+	PID_SPI_EN,
+} GPIO_FUNCTION;
+
+#define GPIO_ConfigurePin(port, pin, mode, function, high) \
+	((void)(port), (void)(pin), (void)(mode), (void)(function), (void)(high))
+#define GPIO_SetActive(port, pin)	((void)(port), (void)(pin))
+#define GPIO_SetInactive(port, pin)	((void)(port), (void)(pin))
+
+#endif /* _GPIO_H_ */
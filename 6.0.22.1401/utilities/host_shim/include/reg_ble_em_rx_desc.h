@@ -0,0 +1,51 @@
+/**
+ ****************************************************************************************
+ *
+ * @file reg_ble_em_rx_desc.h
+ *
+ * @brief BLE exchange memory RX descriptor fields of the host builds.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _REG_BLE_EM_RX_DESC_H_
+#define _REG_BLE_EM_RX_DESC_H_
+
+#include <stdint.h>
+
+/* RXSTATUS error bits, as in the DA14531 register file */
+#define BLE_MIC_ERR_BIT			((uint16_t)0x00000010)
+#define BLE_CRC_ERR_BIT			((uint16_t)0x00000008)
+#define BLE_LEN_ERR_BIT			((uint16_t)0x00000004)
+#define BLE_TYPE_ERR_BIT		((uint16_t)0x00000002)
+#define BLE_SYNC_ERR_BIT		((uint16_t)0x00000001)
+
+/* RXHEADER bits */
+#define BLE_RXMD_BIT			((uint16_t)0x00000010)
+#define BLE_RXSN_BIT			((uint16_t)0x00000008)
+#define BLE_RXNESN_BIT			((uint16_t)0x00000004)
+
+#endif /* _REG_BLE_EM_RX_DESC_H_ */
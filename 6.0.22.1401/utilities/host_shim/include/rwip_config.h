@@ -0,0 +1,86 @@
+/**
+ ****************************************************************************************
+ *
+ * @file rwip_config.h
+ *
+ * @brief Stack configuration of the host builds.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _RWIP_CONFIG_H_
+#define _RWIP_CONFIG_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "compiler.h"
+#include "arch.h"
+
+/* Connections of the DA14531 build */
+#ifndef BLE_CONNECTION_MAX
+#define BLE_CONNECTION_MAX		3
+#endif
+
+/* Profiles, enabled by the tools that build them with -D */
+#ifndef BLE_SERVER_PRF
+#define BLE_SERVER_PRF			0
+#endif
+#ifndef BLE_CLIENT_PRF
+#define BLE_CLIENT_PRF			0
+#endif
+#ifndef BLE_GL_SENSOR
+#define BLE_GL_SENSOR			0
+#endif
+#ifndef BLE_GL_COLLECTOR
+#define BLE_GL_COLLECTOR		0
+#endif
+#ifndef BLE_CGM_SERVER
+#define BLE_CGM_SERVER			0
+#endif
+
+/* Task types and the task identifiers of the messages, as in the SDK rwip_config.h */
+enum KE_TASK_TYPE
+{
+	TASK_LLM,
+	TASK_LLC,
+	TASK_LLD,
+	TASK_DBG,
+	TASK_APP,
+};
+
+enum KE_API_ID
+{
+	TASK_ID_GATTC		= 12,
+	TASK_ID_GAPM		= 13,
+	TASK_ID_GAPC		= 14,
+	TASK_ID_APP		= 15,
+	TASK_ID_DISS		= 20,
+	TASK_ID_BASS		= 36,
+	TASK_ID_SUOTAR		= 0xFC,
+	TASK_ID_CUSTS1		= 0xFD,
+};
+
+#endif /* _RWIP_CONFIG_H_ */
@@ -0,0 +1,144 @@
+/**
+ ****************************************************************************************
+ *
+ * @file spi.h
+ *
+ * @brief SPI driver API of the host builds.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _SPI_H_
+#define _SPI_H_
+
+/*
+ * Host subset of sdk/platform/driver/spi/spi_531.h. The bus is connected to the
+ * simulated SPI flash of host_shim/src/spi_flash_sim.c.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "gpio.h"
+
+#define SPI_STATUS_ERR_OK		(0)
+#define SPI_STATUS_CFG_ERR		(-1)
+
+typedef enum {
+	SPI_MS_MODE_MASTER = 0,
+} SPI_MS_MODE_CFG;
+
+typedef enum {
+	SPI_CP_MODE_0 = 0,
+	SPI_CP_MODE_1 = 1,
+	SPI_CP_MODE_2 = 2,
+	SPI_CP_MODE_3 = 3,
+} SPI_CP_MODE_CFG;
+
+typedef enum {
+	SPI_SPEED_MODE_2MHz = 2000,
+	SPI_SPEED_MODE_4MHz = 4000,
+	SPI_SPEED_MODE_8MHz = 8000,
+	SPI_SPEED_MODE_16MHz = 16000,
+	SPI_SPEED_MODE_32MHz = 32000,
+} SPI_SPEED_MODE_CFG;
+
+typedef enum {
+	SPI_MODE_8BIT = 0,
+	SPI_MODE_16BIT = 1,
+	SPI_MODE_32BIT = 2,
+} SPI_WSZ_MODE_CFG;
+
+typedef enum {
+	SPI_CS_NONE = 0,
+	SPI_CS_0 = 1,
+	SPI_CS_1 = 2,
+	SPI_CS_GPIO = 4,
+} SPI_CS_MODE_CFG;
+
+typedef enum {
+	SPI_IRQ_DISABLED = 0,
+	SPI_IRQ_ENABLED = 1,
+} SPI_IRQ_CFG;
+
+typedef enum {
+	SPI_OP_BLOCKING = 0,
+	SPI_OP_DMA = 2,
+} SPI_OP_CFG;
+
+typedef enum {
+	SPI_DMA_CHANNEL_01,
+	SPI_DMA_CHANNEL_23,
+} SPI_DMA_CHANNEL_CFG;
+
+typedef enum {
+	DMA_PRIO_0 = 0,
+	DMA_PRIO_1,
+	DMA_PRIO_2,
+	DMA_PRIO_3,
+} DMA_PRIO_CFG;
+
+typedef enum {
+	SPI_MASTER_EDGE_CAPTURE = 0,
+	SPI_MASTER_EDGE_CAPTURE_NEXT = 1,
+} SPI_MASTER_EDGE_CAPTURE_CFG;
+
+typedef struct {
+	GPIO_PORT port;
+	GPIO_PIN pin;
+} SPI_Pad_t;
+
+typedef void (*spi_cb_t)(uint16_t length);
+
+typedef struct {
+	SPI_MS_MODE_CFG spi_ms;
+	SPI_CP_MODE_CFG spi_cp;
+	SPI_SPEED_MODE_CFG spi_speed;
+	SPI_WSZ_MODE_CFG spi_wsz;
+	SPI_CS_MODE_CFG spi_cs;
+	SPI_IRQ_CFG spi_irq;
+	SPI_Pad_t cs_pad;
+	spi_cb_t send_cb;
+	spi_cb_t receive_cb;
+	spi_cb_t transfer_cb;
+	SPI_DMA_CHANNEL_CFG spi_dma_channel;
+	DMA_PRIO_CFG spi_dma_priority;
+	SPI_MASTER_EDGE_CAPTURE_CFG spi_capture;
+} spi_cfg_t;
+
+/* The transfers of num words move num bytes in 8-bit mode, 2 * num in 16-bit mode... */
+int8_t spi_initialize(const spi_cfg_t *spi_cfg);
+void spi_set_bitmode(SPI_WSZ_MODE_CFG spi_wsz);
+void spi_cs_low(void);
+void spi_cs_high(void);
+int8_t spi_send(const void *data, uint16_t num, SPI_OP_CFG op);
+int8_t spi_receive(void *data, uint16_t num, SPI_OP_CFG op);
+int8_t spi_transfer(const void *data_out, void *data_in, uint16_t num, SPI_OP_CFG op);
+uint32_t spi_access(uint32_t dataToSend);
+uint32_t spi_transaction(uint32_t dataToSend);
+void spi_wait_dma_write_to_finish(void);
+void spi_wait_dma_read_to_finish(void);
+
+#endif /* _SPI_H_ */
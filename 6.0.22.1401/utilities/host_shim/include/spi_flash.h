@@ -0,0 +1,186 @@
+/**
+ ****************************************************************************************
+ *
+ * @file spi_flash.h
+ *
+ * @brief SPI flash driver API of the host builds.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _SPI_FLASH_H_
+#define _SPI_FLASH_H_
+
+/*
+ * Host subset of sdk/platform/driver/spi_flash/spi_flash.h, backed by the simulated
+ * NOR flash of host_shim/src/spi_flash_sim.c. The definitions keep the values of the
+ * SDK driver.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "spi.h"
+
+#define SPI_FLASH_SECTOR_SIZE		4096
+#define SPI_FLASH_PAGE_SIZE		256
+
+#define SPI_FLASH_WAIT			2000000
+
+#define SPI_FLASH_ERR_OK		(0)
+#define SPI_FLASH_ERR_TIMEOUT		(-1)
+#define SPI_FLASH_ERR_NOT_ERASED	(-2)
+#define SPI_FLASH_ERR_PROTECTED		(-3)
+#define SPI_FLASH_ERR_INVAL		(-4)
+#define SPI_FLASH_ERR_ALIGN		(-5)
+#define SPI_FLASH_ERR_UNKNOWN_FLASH_TYPE	(-7)
+#define SPI_FLASH_ERR_PROG_ERROR	(-8)
+#define SPI_FLASH_ERR_READ_ERROR	(-9)
+#define SPI_FLASH_ERR_NOT_DETECTED	(-10)
+#define SPI_FLASH_ERR_AUTODETECT_ERROR	(-11)
+#define SPI_FLASH_ERR_ERASE_ERROR	(-13)
+#define SPI_FLASH_ERR_BUSY		(-14)
+
+#define SPI_FLASH_SR_BUSY		0x01
+#define SPI_FLASH_SR_WEL		0x02
+
+#define SPI_FLASH_MEM_PROT_NONE		0
+
+#define SPI_FLASH_OP_PP			0x02
+#define SPI_FLASH_OP_READ		0x03
+#define SPI_FLASH_OP_FAST_READ		0x0B
+#define SPI_FLASH_OP_CE			0xC7
+
+typedef enum {
+	SPI_FLASH_OP_SE = 0x20,
+	SPI_FLASH_OP_BE32 = 0x52,
+	SPI_FLASH_OP_BE64 = 0xD8,
+} spi_flash_op_t;
+
+typedef struct {
+	uint8_t dev_index;
+	uint32_t jedec_id;
+	uint32_t chip_size;
+} spi_flash_cfg_t;
+
+int8_t spi_flash_enable(const spi_cfg_t *spi_cfg, const spi_flash_cfg_t *spi_flash_cfg);
+int8_t spi_flash_enable_with_autodetect(const spi_cfg_t *spi_cfg, uint8_t *dev_id);
+void spi_flash_configure_env(const spi_flash_cfg_t *spi_flash_cfg);
+int8_t spi_flash_is_busy(void);
+int8_t spi_flash_wait_till_ready(void);
+int8_t spi_flash_auto_detect(uint8_t *dev_id);
+int8_t spi_flash_read_jedec_id(uint32_t *data);
+int8_t spi_flash_power_down(void);
+int8_t spi_flash_release_from_power_down(void);
+uint16_t spi_flash_read_status_reg(void);
+int8_t spi_flash_configure_memory_protection(uint8_t data);
+int8_t spi_flash_block_erase(uint32_t address, spi_flash_op_t erase_op);
+int8_t spi_flash_block_erase_no_wait(uint32_t address, spi_flash_op_t erase_op);
+int8_t spi_flash_chip_erase(void);
+int8_t spi_flash_page_program(uint8_t *wr_data_ptr, uint32_t address, uint16_t size);
+int8_t spi_flash_write_data(uint8_t *wr_data_ptr, uint32_t address, uint32_t size,
+			    uint32_t *actual_size);
+int8_t spi_flash_read_data(uint8_t *rd_data_ptr, uint32_t address, uint32_t size,
+			   uint32_t *actual_size);
+int8_t spi_flash_read_data_buffer(uint8_t *rd_data_ptr, uint32_t address, uint32_t size,
+				  uint32_t *actual_size);
+int8_t spi_flash_read_data_dma(uint8_t *rd_data_ptr, uint32_t address, uint32_t size,
+			       uint32_t *actual_size);
+int8_t spi_flash_is_sector_empty(uint32_t sector_address);
+int8_t spi_flash_is_empty(void);
+
+/*
+ * Simulation control
+ */
+
+/* Timing model, in us; the SPI clock in MHz sets the command, address and data time */
+typedef struct {
+	double spi_mhz;
+	double access_us;		/* software and chip select overhead of a command */
+	double page_program_us;
+	double sector_erase_us;
+	double block32_erase_us;
+	double block64_erase_us;
+	double chip_erase_us;
+} spi_flash_sim_timing_t;
+
+typedef struct {
+	uint64_t transactions;		/* chip selects */
+	uint64_t rd_ops;
+	uint64_t rd_bytes;
+	uint64_t wr_ops;
+	uint64_t wr_bytes;
+	uint64_t pages;
+	uint64_t erase_ops;
+	uint64_t erased_bytes;
+	uint64_t status_polls;
+	uint64_t accesses;		/* words moved by the CPU, one SPI FIFO access each */
+	uint64_t dma_items;		/* words moved by the DMA */
+	double bus_us;			/* commands, addresses and data on the bus */
+	double busy_us;			/* programming and erasing */
+} spi_flash_sim_stats_t;
+
+/* Allocate an erased flash of size bytes, a multiple of SPI_FLASH_SECTOR_SIZE */
+void spi_flash_sim_init(uint32_t size);
+
+/* Erase the whole flash and clear the statistics and the failures */
+void spi_flash_sim_format(void);
+
+/* Load the flash from a file (at most its size) / save it to a file, 0 on success */
+int spi_flash_sim_load(const char *filename);
+int spi_flash_sim_save(const char *filename);
+
+uint8_t *spi_flash_sim_mem(void);
+uint32_t spi_flash_sim_size(void);
+
+/* Power is lost after programming bytes more bytes; -1 for never */
+void spi_flash_sim_fail_after(long bytes);
+bool spi_flash_sim_failed(void);
+/* Power is back: the flash keeps its content, the operations work again */
+void spi_flash_sim_power_up(void);
+
+/* The erase number n (counting from 1 after this call) fails; 0 for none */
+void spi_flash_sim_erase_error_at(uint32_t n);
+
+void spi_flash_sim_set_timing(const spi_flash_sim_timing_t *timing);
+const spi_flash_sim_timing_t *spi_flash_sim_timing(void);
+
+const spi_flash_sim_stats_t *spi_flash_sim_stats(void);
+void spi_flash_sim_clear_stats(void);
+
+/* Erase count of a sector, and the highest one */
+uint32_t spi_flash_sim_sector_erases(uint32_t sector);
+uint32_t spi_flash_sim_max_sector_erases(void);
+
+/* CPU time spent away from the flash: a DMA transfer or an erase in progress goes on */
+void spi_flash_sim_advance(double us);
+
+/*
+ * Simulated time, in us: the time waited for the bus, programming and erasing, plus
+ * the time given to spi_flash_sim_advance()
+ */
+double spi_flash_sim_time_us(void);
+
+#endif /* _SPI_FLASH_H_ */
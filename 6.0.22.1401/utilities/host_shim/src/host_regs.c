@@ -0,0 +1,80 @@
+/**
+ ****************************************************************************************
+ *
+ * @file host_regs.c
+ *
+ * @brief Plain register file and scheduler of the host builds.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "compiler.h"
+#include "datasheet.h"
+#include "rwip.h"
+
+/* Registers written so far; the others read as 0 */
+#define HOST_REGS	64
+
+static struct {
+	uint32_t addr;
+	uint32_t value;
+} regs[HOST_REGS];
+
+static unsigned int nb_regs;
+
+__WEAK uint32_t host_reg_read(uint32_t addr)
+{
+	unsigned int i;
+
+	for (i = 0; i < nb_regs; i++)
+		if (regs[i].addr == addr)
+			return regs[i].value;
+	return 0;
+}
+
+__WEAK void host_reg_write(uint32_t addr, uint32_t value)
+{
+	unsigned int i;
+
+	for (i = 0; i < nb_regs; i++)
+		if (regs[i].addr == addr)
+			break;
+	if (i == HOST_REGS) {
+		fprintf(stderr, "host_regs: too many registers, 0x%08x\n", addr);
+		exit(EXIT_FAILURE);
+	}
+	if (i == nb_regs)
+		nb_regs++;
+	regs[i].addr = addr;
+	regs[i].value = value;
+}
+
+/* No BLE events to run on the host */
+__WEAK void rwip_schedule(void)
+{
+}
@@ -0,0 +1,763 @@
+/**
+ ****************************************************************************************
+ *
+ * @file spi_flash_sim.c
+ *
+ * @brief Simulated SPI NOR flash of the host builds.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "spi.h"
+#include "spi_flash.h"
+
+/*
+ * The flash is reached in two ways: through the spi_flash_*() driver API below, or
+ * through the spi_*() bus functions, which decode the commands sent by code that drives
+ * the bus itself (or by the SDK spi_flash.c, whose definitions then replace the weak
+ * ones of this file). Both share the memory, the statistics and the simulated time.
+ */
+
+#define __HOST_WEAK		__attribute__((weak))
+
+/* Bytes of command and address of a read, program and erase command */
+#define CMD_BYTES		4
+
+#define CMD_WRSR		0x01
+#define CMD_WRDI		0x04
+#define CMD_RDSR		0x05
+#define CMD_WREN		0x06
+#define CMD_CE_ALT		0x60
+#define CMD_RDID		0x9F
+#define CMD_RDP			0xAB
+#define CMD_DP			0xB9
+
+/* MX25R2035F, as in the secondary bootloader */
+static const uint8_t jedec_id[3] = { 0xC2, 0x28, 0x12 };
+
+/* Typical values of a low power 1 to 4 Mbit part */
+static spi_flash_sim_timing_t timing = {
+	.spi_mhz = 16,
+	.access_us = 2,
+	.page_program_us = 1000,
+	.sector_erase_us = 40000,
+	.block32_erase_us = 150000,
+	.block64_erase_us = 300000,
+	.chip_erase_us = 2000000,
+};
+
+/* NOR flash: erase sets bytes to 0xFF, programming can only clear bits */
+static uint8_t *flash;
+static uint32_t flash_size;
+static uint32_t *sector_erases;
+
+/* Programmed bytes left before the simulated power failure, -1 for none */
+static long fail_budget = -1;
+static bool failed;
+
+static uint32_t erase_error_at;
+static uint32_t erase_count;
+
+static spi_flash_sim_stats_t stats;
+
+/* Simulated time, the end of the programming or erasing and of the DMA transfer */
+static double now_us;
+static double busy_until_us;
+static double dma_until_us;
+
+/* Command decoder of the bus side */
+static struct {
+	bool selected;
+	bool wel;
+	uint8_t cmd;
+	uint32_t count;
+	uint32_t addr;
+	uint8_t page[SPI_FLASH_PAGE_SIZE];
+	uint32_t page_len;
+	SPI_WSZ_MODE_CFG bitmode;
+} bus_dev;
+
+static void check_range(const char *op, uint32_t address, uint32_t size)
+{
+	if (flash == NULL || address > flash_size || size > flash_size - address) {
+		fprintf(stderr, "spi_flash_sim: %s out of range 0x%x+%u\n", op, address, size);
+		exit(EXIT_FAILURE);
+	}
+}
+
+static double byte_us(uint32_t bytes)
+{
+	return bytes * 8 / timing.spi_mhz;
+}
+
+/* One command of bytes on the bus, with the CPU waiting for it */
+static void bus(uint32_t bytes)
+{
+	double us = timing.access_us + byte_us(bytes);
+
+	stats.transactions++;
+	stats.bus_us += us;
+	now_us += us;
+}
+
+static bool busy(void)
+{
+	return busy_until_us > now_us;
+}
+
+/* Wait for the programming or erasing in progress */
+static void wait_ready(void)
+{
+	if (busy()) {
+		stats.busy_us += busy_until_us - now_us;
+		now_us = busy_until_us;
+	}
+}
+
+static void wait_dma(void)
+{
+	if (dma_until_us > now_us)
+		now_us = dma_until_us;
+}
+
+static int8_t do_erase(uint32_t address, uint32_t size, double us)
+{
+	uint32_t i;
+
+	address &= ~(size - 1);
+	check_range("erase", address, size);
+	if (failed)
+		return SPI_FLASH_ERR_OK;
+	stats.erase_ops++;
+	if (erase_error_at && ++erase_count == erase_error_at)
+		return SPI_FLASH_ERR_ERASE_ERROR;
+	memset(&flash[address], 0xFF, size);
+	for (i = 0; i < size / SPI_FLASH_SECTOR_SIZE; i++)
+		sector_erases[address / SPI_FLASH_SECTOR_SIZE + i]++;
+	stats.erased_bytes += size;
+	busy_until_us = now_us + us;
+	return SPI_FLASH_ERR_OK;
+}
+
+static int8_t erase_op(uint32_t address, uint8_t op)
+{
+	switch (op) {
+	case SPI_FLASH_OP_SE:
+		return do_erase(address, SPI_FLASH_SECTOR_SIZE, timing.sector_erase_us);
+	case SPI_FLASH_OP_BE32:
+		return do_erase(address, 32 * 1024, timing.block32_erase_us);
+	case SPI_FLASH_OP_BE64:
+		return do_erase(address, 64 * 1024, timing.block64_erase_us);
+	case SPI_FLASH_OP_CE:
+	case CMD_CE_ALT:
+		return do_erase(0, flash_size, timing.chip_erase_us);
+	default:
+		return SPI_FLASH_ERR_INVAL;
+	}
+}
+
+/* Program size bytes within one page */
+static void do_program(const uint8_t *data, uint32_t address, uint32_t size)
+{
+	uint32_t i;
+
+	check_range("program", address, size);
+	for (i = 0; i < size && !failed; i++) {
+		if (fail_budget == 0) {
+			failed = true;
+			break;
+		}
+		if (fail_budget > 0)
+			fail_budget--;
+		flash[address + i] &= data[i];
+	}
+	stats.pages++;
+	stats.wr_bytes += i;
+	busy_until_us = now_us + timing.page_program_us;
+}
+
+/*
+ * Driver API
+ */
+
+__HOST_WEAK int8_t spi_flash_enable(const spi_cfg_t *spi_cfg, const spi_flash_cfg_t *spi_flash_cfg)
+{
+	return SPI_FLASH_ERR_OK;
+}
+
+__HOST_WEAK int8_t spi_flash_enable_with_autodetect(const spi_cfg_t *spi_cfg, uint8_t *dev_id)
+{
+	bus(4);
+	*dev_id = 0;
+	return SPI_FLASH_ERR_OK;
+}
+
+__HOST_WEAK void spi_flash_configure_env(const spi_flash_cfg_t *spi_flash_cfg)
+{
+}
+
+__HOST_WEAK int8_t spi_flash_is_busy(void)
+{
+	return (spi_flash_read_status_reg() & SPI_FLASH_SR_BUSY) ? SPI_FLASH_ERR_BUSY : SPI_FLASH_ERR_OK;
+}
+
+__HOST_WEAK int8_t spi_flash_wait_till_ready(void)
+{
+	wait_ready();
+	return SPI_FLASH_ERR_OK;
+}
+
+__HOST_WEAK int8_t spi_flash_auto_detect(uint8_t *dev_id)
+{
+	bus(4);
+	*dev_id = 0;
+	return SPI_FLASH_ERR_OK;
+}
+
+__HOST_WEAK int8_t spi_flash_read_jedec_id(uint32_t *data)
+{
+	bus(1 + sizeof(jedec_id));
+	*data = (jedec_id[0] << 16) | (jedec_id[1] << 8) | jedec_id[2];
+	return SPI_FLASH_ERR_OK;
+}
+
+__HOST_WEAK int8_t spi_flash_power_down(void)
+{
+	bus(1);
+	return SPI_FLASH_ERR_OK;
+}
+
+__HOST_WEAK int8_t spi_flash_release_from_power_down(void)
+{
+	bus(1);
+	return SPI_FLASH_ERR_OK;
+}
+
+__HOST_WEAK uint16_t spi_flash_read_status_reg(void)
+{
+	stats.status_polls++;
+	bus(2);
+	return busy() ? SPI_FLASH_SR_BUSY : 0;
+}
+
+__HOST_WEAK int8_t spi_flash_configure_memory_protection(uint8_t data)
+{
+	return SPI_FLASH_ERR_OK;
+}
+
+__HOST_WEAK int8_t spi_flash_block_erase_no_wait(uint32_t address, spi_flash_op_t erase_op_code)
+{
+	int8_t ret;
+
+	wait_ready();
+	bus(CMD_BYTES);
+	ret = erase_op(address, erase_op_code);
+	return ret;
+}
+
+__HOST_WEAK int8_t spi_flash_block_erase(uint32_t address, spi_flash_op_t erase_op_code)
+{
+	int8_t ret = spi_flash_block_erase_no_wait(address, erase_op_code);
+
+	wait_ready();
+	return ret;
+}
+
+__HOST_WEAK int8_t spi_flash_chip_erase(void)
+{
+	int8_t ret;
+
+	wait_ready();
+	bus(1);
+	ret = erase_op(0, SPI_FLASH_OP_CE);
+	wait_ready();
+	return ret;
+}
+
+__HOST_WEAK int8_t spi_flash_page_program(uint8_t *wr_data_ptr, uint32_t address, uint16_t size)
+{
+	if (size > SPI_FLASH_PAGE_SIZE - (address % SPI_FLASH_PAGE_SIZE))
+		return SPI_FLASH_ERR_INVAL;
+	check_range("program", address, size);
+	wait_ready();
+	bus(CMD_BYTES + size);
+	do_program(wr_data_ptr, address, size);
+	wait_ready();
+	return SPI_FLASH_ERR_OK;
+}
+
+__HOST_WEAK int8_t spi_flash_write_data(uint8_t *wr_data_ptr, uint32_t address, uint32_t size,
+					uint32_t *actual_size)
+{
+	uint32_t done = 0;
+
+	check_range("write", address, size);
+	stats.wr_ops++;
+	while (done < size) {
+		uint32_t len = SPI_FLASH_PAGE_SIZE - ((address + done) % SPI_FLASH_PAGE_SIZE);
+
+		if (len > size - done)
+			len = size - done;
+		spi_flash_page_program(wr_data_ptr + done, address + done, len);
+		done += len;
+	}
+	*actual_size = size;
+	return SPI_FLASH_ERR_OK;
+}
+
+__HOST_WEAK int8_t spi_flash_read_data(uint8_t *rd_data_ptr, uint32_t address, uint32_t size,
+				       uint32_t *actual_size)
+{
+	check_range("read", address, size);
+	wait_ready();
+	bus(CMD_BYTES + size);
+	memcpy(rd_data_ptr, &flash[address], size);
+	stats.rd_ops++;
+	stats.rd_bytes += size;
+	*actual_size = size;
+	return SPI_FLASH_ERR_OK;
+}
+
+__HOST_WEAK int8_t spi_flash_read_data_buffer(uint8_t *rd_data_ptr, uint32_t address, uint32_t size,
+					      uint32_t *actual_size)
+{
+	return spi_flash_read_data(rd_data_ptr, address, size, actual_size);
+}
+
+__HOST_WEAK int8_t spi_flash_read_data_dma(uint8_t *rd_data_ptr, uint32_t address, uint32_t size,
+					   uint32_t *actual_size)
+{
+	return spi_flash_read_data(rd_data_ptr, address, size, actual_size);
+}
+
+__HOST_WEAK int8_t spi_flash_is_sector_empty(uint32_t sector_address)
+{
+	uint32_t i;
+
+	sector_address &= ~(SPI_FLASH_SECTOR_SIZE - 1);
+	check_range("read", sector_address, SPI_FLASH_SECTOR_SIZE);
+	wait_ready();
+	bus(CMD_BYTES + SPI_FLASH_SECTOR_SIZE);
+	stats.rd_ops++;
+	stats.rd_bytes += SPI_FLASH_SECTOR_SIZE;
+	for (i = 0; i < SPI_FLASH_SECTOR_SIZE; i++)
+		if (flash[sector_address + i] != 0xFF)
+			return SPI_FLASH_ERR_NOT_ERASED;
+	return SPI_FLASH_ERR_OK;
+}
+
+__HOST_WEAK int8_t spi_flash_is_empty(void)
+{
+	uint32_t address;
+	int8_t ret;
+
+	for (address = 0; address < flash_size; address += SPI_FLASH_SECTOR_SIZE) {
+		ret = spi_flash_is_sector_empty(address);
+		if (ret != SPI_FLASH_ERR_OK)
+			return ret;
+	}
+	return SPI_FLASH_ERR_OK;
+}
+
+/*
+ * SPI bus
+ */
+
+/* Exchange one byte with the flash while it is selected */
+static uint8_t bus_xfer(uint8_t out)
+{
+	uint32_t n = bus_dev.count++;
+
+	if (n == 0) {
+		/* A busy flash only answers the status register reads */
+		bus_dev.cmd = (busy() && out != CMD_RDSR) ? 0 : out;
+		bus_dev.addr = 0;
+		bus_dev.page_len = 0;
+		switch (bus_dev.cmd) {
+		case CMD_WREN:
+			bus_dev.wel = true;
+			break;
+		case CMD_WRDI:
+			bus_dev.wel = false;
+			break;
+		case CMD_RDSR:
+			stats.status_polls++;
+			break;
+		case SPI_FLASH_OP_READ:
+		case SPI_FLASH_OP_FAST_READ:
+			stats.rd_ops++;
+			break;
+		}
+		return 0xFF;
+	}
+
+	switch (bus_dev.cmd) {
+	case CMD_RDSR:
+		return (busy() ? SPI_FLASH_SR_BUSY : 0) | (bus_dev.wel ? SPI_FLASH_SR_WEL : 0);
+	case CMD_RDID:
+	case CMD_RDP:
+		return jedec_id[(n - 1) % sizeof(jedec_id)];
+	case SPI_FLASH_OP_READ:
+	case SPI_FLASH_OP_FAST_READ:
+	case SPI_FLASH_OP_PP:
+	case SPI_FLASH_OP_SE:
+	case SPI_FLASH_OP_BE32:
+	case SPI_FLASH_OP_BE64:
+		if (n <= 3) {
+			bus_dev.addr = (bus_dev.addr << 8) | out;
+			return 0xFF;
+		}
+		if (bus_dev.cmd == SPI_FLASH_OP_FAST_READ && n == 4)
+			return 0xFF;
+		if (bus_dev.cmd == SPI_FLASH_OP_READ || bus_dev.cmd == SPI_FLASH_OP_FAST_READ) {
+			uint8_t in = flash[bus_dev.addr % flash_size];
+
+			bus_dev.addr++;
+			stats.rd_bytes++;
+			return in;
+		}
+		if (bus_dev.cmd == SPI_FLASH_OP_PP) {
+			/* The address wraps around within the page, as on the device */
+			if (bus_dev.page_len < SPI_FLASH_PAGE_SIZE)
+				bus_dev.page[bus_dev.page_len++] = out;
+			else
+				bus_dev.page[(bus_dev.page_len++) % SPI_FLASH_PAGE_SIZE] = out;
+		}
+		return 0xFF;
+	default:
+		return 0xFF;
+	}
+}
+
+/* Complete the program and erase commands when the flash is deselected */
+static void bus_deselect(void)
+{
+	uint32_t page_base = bus_dev.addr & ~(SPI_FLASH_PAGE_SIZE - 1);
+	uint32_t first = bus_dev.addr % SPI_FLASH_PAGE_SIZE;
+	uint32_t len = bus_dev.page_len > SPI_FLASH_PAGE_SIZE ? SPI_FLASH_PAGE_SIZE : bus_dev.page_len;
+	uint8_t data[SPI_FLASH_PAGE_SIZE];
+	uint32_t i;
+
+	if (!bus_dev.wel || bus_dev.count < 4)
+		return;
+
+	switch (bus_dev.cmd) {
+	case SPI_FLASH_OP_PP:
+		memset(data, 0xFF, sizeof(data));
+		for (i = 0; i < len; i++)
+			data[(first + i) % SPI_FLASH_PAGE_SIZE] = bus_dev.page[i];
+		do_program(data, page_base, SPI_FLASH_PAGE_SIZE);
+		stats.wr_bytes -= SPI_FLASH_PAGE_SIZE - len;
+		bus_dev.wel = false;
+		break;
+	case SPI_FLASH_OP_SE:
+	case SPI_FLASH_OP_BE32:
+	case SPI_FLASH_OP_BE64:
+		erase_op(bus_dev.addr, bus_dev.cmd);
+		bus_dev.wel = false;
+		break;
+	}
+}
+
+static uint32_t bus_word(uint32_t out)
+{
+	uint32_t bytes = 1 << bus_dev.bitmode;
+	uint32_t in = 0;
+	uint32_t i;
+
+	for (i = bytes; i-- > 0;)
+		in = (in << 8) | bus_xfer(out >> (8 * i));
+	return in;
+}
+
+static void bus_words(const void *out, void *in, uint16_t num)
+{
+	uint32_t i;
+
+	for (i = 0; i < num; i++) {
+		uint32_t w = 0;
+
+		switch (bus_dev.bitmode) {
+		case SPI_MODE_8BIT:
+			w = out ? ((const uint8_t *) out)[i] : 0xFF;
+			w = bus_word(w);
+			if (in)
+				((uint8_t *) in)[i] = w;
+			break;
+		case SPI_MODE_16BIT:
+			w = out ? ((const uint16_t *) out)[i] : 0xFFFF;
+			w = bus_word(w);
+			if (in)
+				((uint16_t *) in)[i] = w;
+			break;
+		default:
+			w = out ? ((const uint32_t *) out)[i] : 0xFFFFFFFF;
+			w = bus_word(w);
+			if (in)
+				((uint32_t *) in)[i] = w;
+			break;
+		}
+	}
+}
+
+/* Account for a transfer on the bus: the CPU waits for it unless the DMA moves it */
+static void bus_time(uint32_t words, SPI_OP_CFG op)
+{
+	double us = byte_us(words << bus_dev.bitmode);
+
+	stats.bus_us += us;
+	if (op == SPI_OP_DMA) {
+		stats.dma_items += words;
+		dma_until_us = (dma_until_us > now_us ? dma_until_us : now_us) + us;
+	} else {
+		stats.accesses += words;
+		wait_dma();
+		now_us += us;
+	}
+}
+
+__HOST_WEAK int8_t spi_initialize(const spi_cfg_t *spi_cfg)
+{
+	bus_dev.bitmode = spi_cfg->spi_wsz;
+	return SPI_STATUS_ERR_OK;
+}
+
+__HOST_WEAK void spi_set_bitmode(SPI_WSZ_MODE_CFG spi_wsz)
+{
+	bus_dev.bitmode = spi_wsz;
+}
+
+__HOST_WEAK void spi_cs_low(void)
+{
+	wait_dma();
+	bus_dev.selected = true;
+	bus_dev.count = 0;
+	stats.transactions++;
+	stats.bus_us += timing.access_us;
+	now_us += timing.access_us;
+}
+
+__HOST_WEAK void spi_cs_high(void)
+{
+	wait_dma();
+	if (bus_dev.selected)
+		bus_deselect();
+	bus_dev.selected = false;
+}
+
+__HOST_WEAK int8_t spi_send(const void *data, uint16_t num, SPI_OP_CFG op)
+{
+	bus_words(data, NULL, num);
+	bus_time(num, op);
+	return SPI_STATUS_ERR_OK;
+}
+
+__HOST_WEAK int8_t spi_receive(void *data, uint16_t num, SPI_OP_CFG op)
+{
+	bus_words(NULL, data, num);
+	bus_time(num, op);
+	return SPI_STATUS_ERR_OK;
+}
+
+__HOST_WEAK int8_t spi_transfer(const void *data_out, void *data_in, uint16_t num, SPI_OP_CFG op)
+{
+	bus_words(data_out, data_in, num);
+	bus_time(num, op);
+	return SPI_STATUS_ERR_OK;
+}
+
+__HOST_WEAK uint32_t spi_access(uint32_t dataToSend)
+{
+	uint32_t in = bus_word(dataToSend);
+
+	bus_time(1, SPI_OP_BLOCKING);
+	return in;
+}
+
+__HOST_WEAK uint32_t spi_transaction(uint32_t dataToSend)
+{
+	uint32_t in;
+
+	spi_cs_low();
+	in = spi_access(dataToSend);
+	spi_cs_high();
+	return in;
+}
+
+__HOST_WEAK void spi_wait_dma_write_to_finish(void)
+{
+	wait_dma();
+}
+
+__HOST_WEAK void spi_wait_dma_read_to_finish(void)
+{
+	wait_dma();
+}
+
+/*
+ * Simulation control
+ */
+
+void spi_flash_sim_init(uint32_t size)
+{
+	free(flash);
+	free(sector_erases);
+	flash_size = (size + SPI_FLASH_SECTOR_SIZE - 1) & ~(SPI_FLASH_SECTOR_SIZE - 1);
+	flash = malloc(flash_size);
+	sector_erases = calloc(flash_size / SPI_FLASH_SECTOR_SIZE, sizeof(*sector_erases));
+	if (flash == NULL || sector_erases == NULL) {
+		fprintf(stderr, "spi_flash_sim: out of memory\n");
+		exit(EXIT_FAILURE);
+	}
+	spi_flash_sim_format();
+}
+
+void spi_flash_sim_format(void)
+{
+	memset(flash, 0xFF, flash_size);
+	memset(sector_erases, 0, flash_size / SPI_FLASH_SECTOR_SIZE * sizeof(*sector_erases));
+	fail_budget = -1;
+	failed = false;
+	erase_error_at = 0;
+	busy_until_us = now_us;
+	spi_flash_sim_clear_stats();
+}
+
+int spi_flash_sim_load(const char *filename)
+{
+	FILE *f = fopen(filename, "rb");
+	size_t n;
+
+	if (f == NULL)
+		return -1;
+	n = fread(flash, 1, flash_size, f);
+	if (ferror(f)) {
+		fclose(f);
+		return -1;
+	}
+	memset(flash + n, 0xFF, flash_size - n);
+	fclose(f);
+	return 0;
+}
+
+int spi_flash_sim_save(const char *filename)
+{
+	FILE *f = fopen(filename, "wb");
+
+	if (f == NULL)
+		return -1;
+	if (fwrite(flash, 1, flash_size, f) != flash_size) {
+		fclose(f);
+		return -1;
+	}
+	return fclose(f);
+}
+
+uint8_t *spi_flash_sim_mem(void)
+{
+	return flash;
+}
+
+uint32_t spi_flash_sim_size(void)
+{
+	return flash_size;
+}
+
+void spi_flash_sim_fail_after(long bytes)
+{
+	fail_budget = bytes;
+	failed = false;
+}
+
+bool spi_flash_sim_failed(void)
+{
+	return failed;
+}
+
+void spi_flash_sim_power_up(void)
+{
+	fail_budget = -1;
+	failed = false;
+	busy_until_us = now_us;
+	dma_until_us = now_us;
+	bus_dev.selected = false;
+	bus_dev.wel = false;
+}
+
+void spi_flash_sim_erase_error_at(uint32_t n)
+{
+	erase_error_at = n;
+	erase_count = 0;
+}
+
+void spi_flash_sim_set_timing(const spi_flash_sim_timing_t *t)
+{
+	timing = *t;
+}
+
+const spi_flash_sim_timing_t *spi_flash_sim_timing(void)
+{
+	return &timing;
+}
+
+const spi_flash_sim_stats_t *spi_flash_sim_stats(void)
+{
+	return &stats;
+}
+
+void spi_flash_sim_clear_stats(void)
+{
+	memset(&stats, 0, sizeof(stats));
+}
+
+uint32_t spi_flash_sim_sector_erases(uint32_t sector)
+{
+	return sector < flash_size / SPI_FLASH_SECTOR_SIZE ? sector_erases[sector] : 0;
+}
+
+uint32_t spi_flash_sim_max_sector_erases(void)
+{
+	uint32_t i, max = 0;
+
+	for (i = 0; i < flash_size / SPI_FLASH_SECTOR_SIZE; i++)
+		if (sector_erases[i] > max)
+			max = sector_erases[i];
+	return max;
+}
+
+void spi_flash_sim_advance(double us)
+{
+	now_us += us;
+}
+
+double spi_flash_sim_time_us(void)
+{
+	return now_us;
+}
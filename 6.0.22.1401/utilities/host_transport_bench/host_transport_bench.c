@@ -0,0 +1,417 @@
+/**
+ ****************************************************************************************
+ *
+ * @file host_transport_bench.c
+ *
+ * @brief Loopback throughput and latency benchmark of the host transport.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "host_transport.h"
+
+#define HOST_TRANSPORT_BENCH_VERSION	"v_1.0"
+
+/* GTL header after the packet type: msg_id, dest_id, src_id, length */
+#define GTL_HDR_LEN			8
+/* Parameters of the test messages: send time (ns) and sequence number */
+#define MSG_MIN_PARAMS			12
+/* Largest GTL parameter length accepted by the host applications (MAX_PACKET_LENGTH) */
+#define MSG_MAX_PARAMS			350
+
+static unsigned int msg_count = 100000;
+static unsigned int msg_params = 32;
+static unsigned int msg_rate;
+static int legacy;
+
+static int pty_master = -1;
+static volatile int stop_rx;
+static uint64_t *latencies;
+
+static void usage(const char* my_name)
+{
+	fprintf(stderr,
+		"Version: " HOST_TRANSPORT_BENCH_VERSION "\n"
+		"\n"
+		"Usage: %s [-n messages] [-s size] [-r rate] [-l]\n"
+		"\n"
+		"  Loopback benchmark of the host transport: a sender thread writes GTL\n"
+		"  messages to a pty, the reception thread of the host transport parses\n"
+		"  them and the main thread takes them from the frame queue. Prints the\n"
+		"  message rate and the send to consume latency.\n"
+		"\n"
+		"  -n messages  number of messages (default 100000)\n"
+		"  -s size      parameter bytes per message, %d..%d (default 32)\n"
+		"  -r rate      messages per second (default: as fast as possible)\n"
+		"  -l           use the previous reception path instead: one read per\n"
+		"               byte, one allocation per message, mutex protected list\n",
+		my_name, MSG_MIN_PARAMS, MSG_MAX_PARAMS);
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void put_le(uint8_t *p, uint64_t value, unsigned int len)
+{
+	while (len--) {
+		*p++ = value & 0xFF;
+		value >>= 8;
+	}
+}
+
+static uint64_t get_le(const uint8_t *p, unsigned int len)
+{
+	uint64_t value = 0;
+
+	while (len--)
+		value = (value << 8) | p[len];
+	return value;
+}
+
+/* The DUT: writes the test messages, several per write() like a UART burst */
+static void *sender(void *arg)
+{
+	uint8_t buf[4096];
+	unsigned int frame_len = 1 + GTL_HDR_LEN + msg_params;
+	unsigned int seq = 0, len, i;
+	uint64_t start = now_ns(), due;
+	ssize_t n;
+
+	while (seq < msg_count) {
+		len = 0;
+		do {
+			uint8_t *p = &buf[len];
+
+			p[0] = HT_PKT_GTL;
+			put_le(&p[1], 0x3F00 + (seq & 0xFF), 2);	/* msg_id */
+			put_le(&p[3], 0x000B, 2);			/* dest_id */
+			put_le(&p[5], 0x0010, 2);			/* src_id */
+			put_le(&p[7], msg_params, 2);
+			for (i = MSG_MIN_PARAMS; i < msg_params; i++)
+				p[9 + i] = seq + i;
+			put_le(&p[17], seq, 4);
+			if (msg_rate) {
+				due = start + (uint64_t)seq * 1000000000ULL / msg_rate;
+				while (now_ns() < due)
+					;
+			}
+			put_le(&p[9], now_ns(), 8);
+			len += frame_len;
+			seq++;
+		} while (!msg_rate && seq < msg_count && len + frame_len <= sizeof(buf));
+
+		for (i = 0; i < len; i += n) {
+			n = write(pty_master, &buf[i], len - i);
+			if (n < 0 && errno != EINTR && errno != EAGAIN) {
+				perror("write");
+				exit(EXIT_FAILURE);
+			}
+			if (n < 0)
+				n = 0;
+		}
+	}
+	return NULL;
+}
+
+/* Check a received message and record its latency; returns its sequence number */
+static unsigned int consume(const uint8_t *msg, unsigned int length, uint64_t t)
+{
+	unsigned int seq, i;
+
+	if (length != GTL_HDR_LEN + msg_params || get_le(&msg[6], 2) != msg_params) {
+		fprintf(stderr, "Bad message length %u\n", length);
+		exit(EXIT_FAILURE);
+	}
+	seq = get_le(&msg[8 + 8], 4);
+	for (i = MSG_MIN_PARAMS; i < msg_params; i++) {
+		if (msg[GTL_HDR_LEN + i] != (uint8_t)(seq + i)) {
+			fprintf(stderr, "Corrupted message %u\n", seq);
+			exit(EXIT_FAILURE);
+		}
+	}
+	if (seq < msg_count)
+		latencies[seq] = t - get_le(&msg[8], 8);
+	return seq;
+}
+
+/*
+ ****************************************************************************************
+ * Host transport
+ ****************************************************************************************
+ */
+
+static ht_transport transport;
+
+static void *transport_rx(void *arg)
+{
+	while (!stop_rx) {
+		if (ht_transport_rx_poll(&transport, 100) < 0) {
+			fprintf(stderr, "Reception failed\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+	return NULL;
+}
+
+static void transport_run(void)
+{
+	unsigned int expected = 0;
+	ht_frame *frame;
+
+	while (expected < msg_count) {
+		frame = ht_queue_peek(&transport.queue);
+		if (frame == NULL) {
+			sched_yield();
+			continue;
+		}
+		if (consume(frame->data, frame->length, now_ns()) != expected++) {
+			fprintf(stderr, "Message %u lost\n", expected - 1);
+			exit(EXIT_FAILURE);
+		}
+		ht_queue_release(&transport.queue);
+	}
+}
+
+/*
+ ****************************************************************************************
+ * Previous reception path of the host applications (UARTProc(), SendToMain(), EnQueue())
+ ****************************************************************************************
+ */
+
+struct legacy_node {
+	struct legacy_node *next;
+	uint8_t *data;
+	unsigned int length;
+};
+
+static struct legacy_node *legacy_first, *legacy_last;
+static pthread_mutex_t legacy_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int legacy_fd;
+
+static void legacy_send_to_main(unsigned int length, const uint8_t *data)
+{
+	struct legacy_node *node;
+
+	node = malloc(sizeof(*node));
+	node->data = malloc(length);
+	memcpy(node->data, data, length);
+	node->length = length;
+	node->next = NULL;
+
+	pthread_mutex_lock(&legacy_mutex);
+	if (legacy_first == NULL)
+		legacy_first = node;
+	else
+		legacy_last->next = node;
+	legacy_last = node;
+	pthread_mutex_unlock(&legacy_mutex);
+}
+
+static void *legacy_rx(void *arg)
+{
+	uint8_t frame[1000];
+	unsigned int pos = 0, length = 0, state = 0;
+	uint8_t c;
+
+	while (!stop_rx) {
+		if (read(legacy_fd, &c, 1) != 1)
+			continue;
+
+		switch (state) {
+		case 0:
+			if (c == HT_PKT_GTL) {
+				pos = 0;
+				frame[pos++] = c;
+				state = 1;
+			}
+			break;
+		case 1:
+			frame[pos++] = c;
+			if (pos == 1 + GTL_HDR_LEN) {
+				length = get_le(&frame[7], 2);
+				if (length > MSG_MAX_PARAMS)
+					state = 0;
+				else if (length == 0) {
+					legacy_send_to_main(pos - 1, &frame[1]);
+					state = 0;
+				} else
+					state = 2;
+			}
+			break;
+		case 2:
+			frame[pos++] = c;
+			if (pos == 1 + GTL_HDR_LEN + length) {
+				legacy_send_to_main(pos - 1, &frame[1]);
+				state = 0;
+			}
+			break;
+		}
+	}
+	return NULL;
+}
+
+static void legacy_run(void)
+{
+	unsigned int expected = 0;
+	struct legacy_node *node;
+
+	while (expected < msg_count) {
+		pthread_mutex_lock(&legacy_mutex);
+		node = legacy_first;
+		if (node)
+			legacy_first = node->next;
+		pthread_mutex_unlock(&legacy_mutex);
+		if (node == NULL) {
+			sched_yield();
+			continue;
+		}
+		if (consume(node->data, node->length, now_ns()) != expected++) {
+			fprintf(stderr, "Message %u lost\n", expected - 1);
+			exit(EXIT_FAILURE);
+		}
+		free(node->data);
+		free(node);
+	}
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+int main(int argc, char **argv)
+{
+	pthread_t tx, rx;
+	struct termios tio;
+	uint64_t start, elapsed;
+	const char *slave;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:s:r:l")) != -1) {
+		switch (opt) {
+		case 'n':
+			msg_count = strtoul(optarg, NULL, 0);
+			break;
+		case 's':
+			msg_params = strtoul(optarg, NULL, 0);
+			break;
+		case 'r':
+			msg_rate = strtoul(optarg, NULL, 0);
+			break;
+		case 'l':
+			legacy = 1;
+			break;
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	if (optind != argc || msg_count == 0 || msg_params < MSG_MIN_PARAMS || msg_params > MSG_MAX_PARAMS) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	latencies = calloc(msg_count, sizeof(*latencies));
+	if (latencies == NULL)
+		return EXIT_FAILURE;
+
+	/* The pty stands for the UART link */
+	pty_master = posix_openpt(O_RDWR | O_NOCTTY);
+	if (pty_master < 0 || grantpt(pty_master) || unlockpt(pty_master)) {
+		perror("Could not create a pty");
+		return EXIT_FAILURE;
+	}
+	tcgetattr(pty_master, &tio);
+	cfmakeraw(&tio);
+	tcsetattr(pty_master, TCSANOW, &tio);
+	slave = ptsname(pty_master);
+
+	if (legacy) {
+		legacy_fd = open(slave, O_RDWR | O_NOCTTY);
+		if (legacy_fd < 0 || tcgetattr(legacy_fd, &tio) < 0) {
+			perror(slave);
+			return EXIT_FAILURE;
+		}
+		cfmakeraw(&tio);
+		tio.c_cc[VMIN] = 0;
+		tio.c_cc[VTIME] = 1;	/* so that the thread can be stopped */
+		tcsetattr(legacy_fd, TCSANOW, &tio);
+	} else {
+		ht_transport_init(&transport, HT_FILTER(HT_PKT_GTL), NULL, NULL);
+		if (ht_port_open(&transport.port, slave, 115200, 0) < 0) {
+			perror(slave);
+			return EXIT_FAILURE;
+		}
+	}
+
+	pthread_create(&rx, NULL, legacy ? legacy_rx : transport_rx, NULL);
+	start = now_ns();
+	pthread_create(&tx, NULL, sender, NULL);
+
+	if (legacy)
+		legacy_run();
+	else
+		transport_run();
+
+	elapsed = now_ns() - start;
+	stop_rx = 1;
+	pthread_join(tx, NULL);
+	pthread_join(rx, NULL);
+
+	qsort(latencies, msg_count, sizeof(*latencies), cmp_u64);
+	printf("%s: %u messages of %u bytes in %.3f s: %.0f messages/s, %.2f MB/s\n",
+	       legacy ? "legacy" : "host_transport", msg_count, 1 + GTL_HDR_LEN + msg_params,
+	       elapsed / 1e9, msg_count / (elapsed / 1e9),
+	       (double)msg_count * (1 + GTL_HDR_LEN + msg_params) / (elapsed / 1e3));
+	printf("latency: p50 %.1f us, p99 %.1f us, max %.1f us\n",
+	       latencies[msg_count / 2] / 1e3, latencies[(uint64_t)msg_count * 99 / 100] / 1e3,
+	       latencies[msg_count - 1] / 1e3);
+	if (!legacy)
+		printf("reads %u (%.1f messages per read), queue full %u times, sync errors %u\n",
+		       transport.stats.reads, (double)transport.stats.frames / transport.stats.reads,
+		       transport.stats.stalls, transport.stats.sync_errors);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,1047 @@
+/**
+ ****************************************************************************************
+ *
+ * @file i2c_eeprom_bench.c
+ *
+ * @brief I2C EEPROM model and benchmark of the synchronous and asynchronous drivers.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+#define _DEFAULT_SOURCE
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "arch.h"
+#include "i2c.h"
+#include "dma.h"
+#include "systick.h"
+#include "i2c_eeprom.h"
+#include "i2c_eeprom_async.h"
+
+#define I2C_EEPROM_BENCH_VERSION	"v_1.0"
+
+/* CPU cost of the driver operations at 16 MHz (us) */
+#define REG_US			0.25		/* register access */
+#define ISR_US			5.0		/* interrupt entry, dispatch and exit */
+#define DMA_SETUP_US		12.0		/* i2c_prepare_dma(), two DMA channels */
+#define SYSTICK_US		1.0
+
+#define FIFO_MAX		64
+#define INF			1e30
+
+#define SLAVE_ADDR		0x50
+
+/* EEPROM model */
+static struct {
+	uint8_t *mem;
+	uint32_t size;
+	uint16_t page_size;
+	uint8_t address_size;		/* enum I2C_ADDRESS_BYTES_COUNT */
+	double twr_us;			/* internal write cycle */
+	double busy_until;
+	uint32_t ptr;			/* address pointer */
+	uint8_t addr_bytes;		/* address bytes received in the transaction */
+	uint8_t page[256];		/* page latches */
+	uint8_t latched[256];
+	uint16_t data_bytes;		/* data bytes received in the transaction */
+	bool read;
+	uint32_t writes;		/* write cycles */
+} ee;
+
+/* I2C controller and bus model */
+enum phase { BUS_IDLE, BUS_ADDR, BUS_BYTE, BUS_HOLD, BUS_STOP };
+
+static struct {
+	bool enabled;
+	uint16_t target;
+	double bit_us;
+	int fifo_depth;
+	uint16_t tx[FIFO_MAX];
+	int tx_n;
+	uint8_t rx[FIFO_MAX];
+	int rx_n;
+	enum phase phase;
+	double end;			/* end of the phase in progress */
+	uint16_t cmd;			/* command in progress */
+	bool dir_read;			/* direction of the transaction */
+	bool addr_pending;		/* command waits for its (re)start and address */
+	bool flush;			/* TX FIFO flushed until the abort is cleared */
+	uint16_t raw;			/* raw interrupt status */
+	uint16_t mask;
+	uint16_t abort_source;
+	bool acked;			/* slave address of the transaction acknowledged */
+	bool dma_en;
+	i2c_interrupt_cb_t intr_cb;
+	uint32_t transactions;
+	uint32_t nacks;
+} bus;
+
+/* DMA model: channel pair, A is RX from the FIFO, B is TX to the FIFO */
+struct dma_ch {
+	bool on;
+	const uint16_t *src;		/* TX source, NULL for the read command */
+	uint8_t *dst;
+	uint16_t len, num;
+	uint16_t fixed;			/* read command */
+	void (*cb)(uint16_t len);
+	bool irq;
+};
+
+static struct dma_ch dma_rx, dma_tx;
+
+/* I2C driver state, as in i2c.c */
+static struct {
+	i2c_complete_cb_t cb;
+	void *cb_data;
+	uint32_t flags;
+	uint16_t len, num, rr;
+	uint8_t *rx_data;
+	uint16_t read_cmd;
+} drv;
+
+/* SysTick */
+static systick_callback_function_t systick_cb;
+static double systick_due = INF;
+static bool systick_irq;
+
+/* CPU */
+static double now;
+static double cpu_us;			/* CPU time of the asynchronous driver */
+static int irq_depth;
+static double irq_off_start, irq_off_max;
+
+/*
+ ****************************************************************************************
+ * EEPROM
+ ****************************************************************************************
+ */
+
+static bool ee_busy(void)
+{
+	return now < ee.busy_until;
+}
+
+static void ee_start(bool read, uint16_t target)
+{
+	ee.read = read;
+	if (!read) {
+		ee.addr_bytes = 0;
+		ee.data_bytes = 0;
+		memset(ee.latched, 0, sizeof(ee.latched));
+	}
+	/* Block select bits of the 2 bytes addressed devices above 64 KB */
+	if (ee.address_size == I2C_2BYTES_ADDR)
+		ee.ptr = (ee.ptr & 0xFFFF) | ((uint32_t)(target & 3) << 16);
+}
+
+static void ee_write(uint8_t byte)
+{
+	uint8_t n = ee.address_size + 1;
+
+	if (ee.addr_bytes < n) {
+		uint32_t shift = 8 * (n - 1 - ee.addr_bytes);
+		uint32_t keep = (ee.address_size == I2C_2BYTES_ADDR) ? 0x30000 : 0;
+
+		if (ee.addr_bytes == 0)
+			ee.ptr &= keep;
+		ee.ptr |= (uint32_t)byte << shift;
+		ee.ptr %= ee.size;
+		ee.addr_bytes++;
+		return;
+	}
+	/* Page latches, the address rolls over within the page */
+	ee.page[(ee.ptr + ee.data_bytes) % ee.page_size] = byte;
+	ee.latched[(ee.ptr + ee.data_bytes) % ee.page_size] = 1;
+	ee.data_bytes++;
+}
+
+static uint8_t ee_read(void)
+{
+	uint8_t byte = ee.mem[ee.ptr];
+
+	ee.ptr = (ee.ptr + 1) % ee.size;
+	return byte;
+}
+
+static void ee_stop(void)
+{
+	uint32_t base;
+	int i;
+
+	if (ee.read || !ee.data_bytes)
+		return;
+
+	base = ee.ptr - ee.ptr % ee.page_size;
+	for (i = 0; i < ee.page_size; i++)
+		if (ee.latched[i])
+			ee.mem[base + i] = ee.page[i];
+	ee.busy_until = now + ee.twr_us;
+	ee.writes++;
+}
+
+/*
+ ****************************************************************************************
+ * I2C controller
+ ****************************************************************************************
+ */
+
+static uint16_t raw_status(void)
+{
+	uint16_t raw = bus.raw;
+
+	if (bus.tx_n == 0)
+		raw |= I2C_INT_TX_EMPTY;
+	if (bus.rx_n)
+		raw |= I2C_INT_RX_FULL;
+	return raw;
+}
+
+/* Start what can start at the current time */
+static void bus_kick(void)
+{
+	if (!bus.enabled)
+		return;
+
+	if ((bus.phase == BUS_IDLE || bus.phase == BUS_HOLD) && bus.tx_n) {
+		uint16_t cmd = bus.tx[0];
+		bool read = (cmd & I2C_CMD) != 0;
+
+		/* The master holds SCL while the RX FIFO is full */
+		if (read && bus.phase == BUS_HOLD && read == bus.dir_read && bus.rx_n == bus.fifo_depth)
+			return;
+
+		memmove(bus.tx, bus.tx + 1, --bus.tx_n * sizeof(bus.tx[0]));
+		bus.cmd = cmd;
+		if (bus.phase == BUS_IDLE || read != bus.dir_read) {
+			/* (RE)START and slave address */
+			if (bus.phase == BUS_IDLE) {
+				bus.transactions++;
+				bus.acked = false;
+			}
+			bus.addr_pending = true;
+			bus.dir_read = read;
+			bus.phase = BUS_ADDR;
+			bus.end = now + 10 * bus.bit_us;
+		} else {
+			bus.phase = BUS_BYTE;
+			bus.end = now + 9 * bus.bit_us;
+		}
+	}
+}
+
+static void bus_complete(void)
+{
+	switch (bus.phase) {
+	case BUS_ADDR:
+		bus.addr_pending = false;
+		if (ee_busy() || (bus.target & ~3) != SLAVE_ADDR) {
+			/* Not acknowledged: abort, flush and STOP */
+			bus.nacks++;
+			bus.abort_source |= ABRT_7B_ADDR_NOACK;
+			bus.raw |= I2C_INT_TX_ABORT;
+			bus.tx_n = 0;
+			bus.flush = true;
+			bus.phase = BUS_STOP;
+			bus.end = now + bus.bit_us;
+			return;
+		}
+		bus.acked = true;
+		ee_start(bus.dir_read, bus.target);
+		bus.phase = BUS_BYTE;
+		bus.end = now + 9 * bus.bit_us;
+		return;
+
+	case BUS_BYTE:
+		if (bus.dir_read) {
+			if (bus.rx_n < bus.fifo_depth)
+				bus.rx[bus.rx_n++] = ee_read();
+		} else {
+			ee_write(bus.cmd & 0xFF);
+		}
+		if (bus.cmd & I2C_STOP) {
+			bus.phase = BUS_STOP;
+			bus.end = now + bus.bit_us;
+		} else {
+			bus.phase = BUS_HOLD;
+		}
+		return;
+
+	case BUS_STOP:
+		if (bus.acked)
+			ee_stop();
+		bus.phase = BUS_IDLE;
+		bus.raw |= I2C_INT_STOP_DETECTED;
+		return;
+
+	default:
+		return;
+	}
+}
+
+static void dma_service(void)
+{
+	if (!bus.dma_en)
+		return;
+
+	while (dma_tx.on && dma_tx.num < dma_tx.len && bus.tx_n < bus.fifo_depth && !bus.flush) {
+		bus.tx[bus.tx_n++] = dma_tx.src ? dma_tx.src[dma_tx.num] : dma_tx.fixed;
+		if (++dma_tx.num == dma_tx.len)
+			dma_tx.irq = true;
+		bus_kick();
+	}
+	while (dma_rx.on && dma_rx.num < dma_rx.len && bus.rx_n) {
+		dma_rx.dst[dma_rx.num] = bus.rx[0];
+		memmove(bus.rx, bus.rx + 1, --bus.rx_n);
+		if (++dma_rx.num == dma_rx.len)
+			dma_rx.irq = true;
+		bus_kick();
+	}
+}
+
+/* Run the hardware up to a time */
+static void hw_run(double until)
+{
+	for (;;) {
+		double t;
+
+		dma_service();
+		bus_kick();
+		t = (bus.phase == BUS_ADDR || bus.phase == BUS_BYTE || bus.phase == BUS_STOP) ? bus.end : INF;
+		if (systick_due < t)
+			t = systick_due;
+		if (t > until)
+			break;
+		if (t > now)
+			now = t;
+		if (t == systick_due) {
+			systick_due = INF;
+			systick_irq = true;
+		} else {
+			bus_complete();
+		}
+	}
+	if (until > now)
+		now = until;
+}
+
+/* CPU time of a driver operation */
+static void cpu(double us)
+{
+	cpu_us += us;
+	hw_run(now + us);
+}
+
+void host_irq_disable(void)
+{
+	if (irq_depth++ == 0)
+		irq_off_start = now;
+}
+
+void host_irq_restore(void)
+{
+	if (--irq_depth == 0 && now - irq_off_start > irq_off_max)
+		irq_off_max = now - irq_off_start;
+}
+
+/*
+ ****************************************************************************************
+ * I2C driver (i2c.h inline functions and i2c.c)
+ ****************************************************************************************
+ */
+
+void i2c_init(const i2c_cfg_t *cfg)
+{
+	bus.target = cfg->address;
+	bus.bit_us = (cfg->speed == I2C_SPEED_FAST) ? 2.5 : 10.0;
+	bus.enabled = true;
+}
+
+void i2c_release(void)
+{
+	bus.enabled = false;
+}
+
+void i2c_set_controller_status(i2c_controller_t status)
+{
+	cpu(REG_US);
+	bus.enabled = (status == I2C_CONTROLLER_ENABLE);
+}
+
+void i2c_set_target_address(uint16_t address)
+{
+	cpu(REG_US);
+	bus.target = address;
+}
+
+void i2c_write_byte(uint16_t byte)
+{
+	cpu(REG_US);
+	if (!bus.flush && bus.tx_n < bus.fifo_depth)
+		bus.tx[bus.tx_n++] = byte;
+	bus_kick();
+}
+
+uint8_t i2c_read_byte(void)
+{
+	uint8_t byte = bus.rx[0];
+
+	cpu(REG_US);
+	if (bus.rx_n)
+		memmove(bus.rx, bus.rx + 1, --bus.rx_n);
+	bus_kick();
+	return byte;
+}
+
+uint8_t i2c_is_tx_fifo_empty(void)
+{
+	cpu(REG_US);
+	return bus.tx_n == 0;
+}
+
+uint8_t i2c_is_tx_fifo_not_full(void)
+{
+	cpu(REG_US);
+	return bus.tx_n < bus.fifo_depth;
+}
+
+uint8_t i2c_get_rx_fifo_level(void)
+{
+	cpu(REG_US);
+	return bus.rx_n;
+}
+
+uint8_t i2c_is_master_busy(void)
+{
+	cpu(REG_US);
+	return bus.phase != BUS_IDLE || bus.tx_n;
+}
+
+uint16_t i2c_get_abort_source(void)
+{
+	cpu(REG_US);
+	return bus.abort_source;
+}
+
+void i2c_reset_int_tx_abort(void)
+{
+	cpu(REG_US);
+	bus.raw &= ~I2C_INT_TX_ABORT;
+	bus.abort_source = 0;
+	bus.flush = false;
+}
+
+void i2c_reset_int_stop_detected(void)
+{
+	cpu(REG_US);
+	bus.raw &= ~I2C_INT_STOP_DETECTED;
+}
+
+void i2c_set_int_mask(uint16_t mask)
+{
+	cpu(REG_US);
+	bus.mask = mask;
+}
+
+uint16_t i2c_get_int_mask(void)
+{
+	return bus.mask;
+}
+
+void i2c_register_int(i2c_interrupt_cb_t cb, uint16_t mask)
+{
+	bus.intr_cb = cb;
+	i2c_set_int_mask(mask);
+}
+
+void i2c_unregister_int(void)
+{
+	i2c_register_int(NULL, 0);
+}
+
+static void reply(bool success)
+{
+	i2c_unregister_int();
+	if (drv.cb)
+		drv.cb(drv.cb_data, drv.num, success);
+}
+
+static void intr_master_receive_buffer_handler(uint16_t mask)
+{
+	if (mask & I2C_INT_TX_ABORT) {
+		reply(false);
+		i2c_reset_int_tx_abort();
+		return;
+	}
+	while (drv.rr < drv.len && i2c_is_tx_fifo_not_full()) {
+		drv.rr++;
+		i2c_write_byte(I2C_CMD | ((drv.rr == drv.len && (drv.flags & I2C_F_ADD_STOP)) ? I2C_STOP : 0));
+	}
+	while (drv.num < drv.len && i2c_get_rx_fifo_level())
+		drv.rx_data[drv.num++] = i2c_read_byte();
+	if (drv.num == drv.len)
+		reply(true);
+}
+
+void i2c_master_receive_buffer_async(uint8_t *data, uint16_t len, i2c_complete_cb_t cb, void *cb_data, uint32_t flags)
+{
+	drv.rx_data = data;
+	drv.len = len;
+	drv.num = 0;
+	drv.rr = 0;
+	drv.cb = cb;
+	drv.cb_data = cb_data;
+	drv.flags = flags;
+	i2c_reset_int_tx_abort();
+	i2c_register_int(intr_master_receive_buffer_handler,
+			 I2C_INT_TX_EMPTY | I2C_INT_RX_FULL | I2C_INT_TX_ABORT);
+}
+
+void i2c_dma_start(void)
+{
+	bus.dma_en = true;
+	cpu(REG_US);
+}
+
+static void i2c_dma_stop(void)
+{
+	cpu(REG_US);
+	bus.dma_en = false;
+}
+
+static void intr_dma_handler(uint16_t mask)
+{
+	if (mask & I2C_INT_TX_ABORT) {
+		i2c_dma_stop();
+		reply(false);
+		i2c_reset_int_tx_abort();
+		return;
+	}
+	if (mask & I2C_INT_STOP_DETECTED) {
+		i2c_reset_int_stop_detected();
+		/* A STOP while the DMA is enabled comes with an abort */
+		if (!bus.dma_en)
+			reply(drv.num == drv.len);
+	}
+}
+
+static void dma_write_end(uint16_t len)
+{
+	i2c_dma_stop();
+	drv.num = len;
+}
+
+static void dma_read_request_end(uint16_t len)
+{
+	while (!i2c_is_tx_fifo_not_full())
+		;
+	i2c_write_byte(drv.read_cmd | I2C_STOP);
+}
+
+static void dma_read_end(uint16_t len)
+{
+	drv.num = len;
+	i2c_dma_stop();
+	reply(drv.num == drv.len);
+}
+
+void dma_channel_stop(DMA_ID id)
+{
+	cpu(REG_US);
+	if (id == DMA_CHANNEL_0 || id == DMA_CHANNEL_2)
+		dma_rx.on = false;
+	else
+		dma_tx.on = false;
+}
+
+/* Write with I2C_F_WAIT_FOR_STOP and master read, the uses of the EEPROM engine */
+void i2c_prepare_dma(i2c_dma_channel_pair_t dma_channel_pair, void *data, uint16_t len, i2c_dma_transfer_t type, i2c_complete_cb_t cb, void *cb_data, uint32_t flags)
+{
+	i2c_dma_stop();
+	cpu(DMA_SETUP_US);
+	drv.cb = cb;
+	drv.cb_data = cb_data;
+	drv.read_cmd = I2C_CMD;
+	drv.num = 0;
+	drv.len = len;
+	memset(&dma_rx, 0, sizeof(dma_rx));
+	memset(&dma_tx, 0, sizeof(dma_tx));
+
+	i2c_reset_int_tx_abort();
+	if (type == I2C_DMA_TRANSFER_MASTER_READ) {
+		dma_rx.on = true;
+		dma_rx.dst = data;
+		dma_rx.len = len;
+		dma_rx.cb = dma_read_end;
+		dma_tx.on = true;
+		dma_tx.fixed = I2C_CMD;
+		dma_tx.len = (flags & I2C_F_ADD_STOP) ? len - 1 : len;
+		dma_tx.cb = (flags & I2C_F_ADD_STOP) ? dma_read_request_end : NULL;
+		i2c_register_int(intr_dma_handler, I2C_INT_TX_ABORT);
+	} else {
+		assert(flags & I2C_F_WAIT_FOR_STOP);
+		((uint16_t *)data)[len - 1] |= I2C_STOP;
+		dma_tx.on = true;
+		dma_tx.src = data;
+		dma_tx.len = len;
+		dma_tx.cb = dma_write_end;
+		i2c_reset_int_stop_detected();
+		i2c_register_int(intr_dma_handler, I2C_INT_TX_ABORT | I2C_INT_STOP_DETECTED);
+	}
+}
+
+void i2c_master_transmit_buffer_dma(i2c_dma_channel_pair_t dma_channel_pair, const uint16_t *data, uint16_t len, i2c_complete_cb_t cb, void *cb_data, uint32_t flags)
+{
+	i2c_prepare_dma(dma_channel_pair, (void *)data, len, I2C_DMA_TRANSFER_WRITE, cb, cb_data, flags);
+	i2c_dma_start();
+}
+
+/*
+ ****************************************************************************************
+ * SysTick
+ ****************************************************************************************
+ */
+
+void systick_register_callback(systick_callback_function_t callback)
+{
+	systick_cb = callback;
+}
+
+void systick_start(uint32_t usec, uint8_t exception)
+{
+	cpu(SYSTICK_US);
+	systick_due = now + usec;
+	systick_irq = false;
+}
+
+void systick_stop(void)
+{
+	cpu(SYSTICK_US);
+	systick_due = INF;
+	systick_irq = false;
+}
+
+/*
+ ****************************************************************************************
+ * Interrupts
+ ****************************************************************************************
+ */
+
+static void isr_enter(void)
+{
+	cpu(ISR_US);
+}
+
+/* Serve one pending interrupt, false if none */
+static bool isr_serve(void)
+{
+	uint16_t pending = raw_status() & bus.mask;
+
+	if (dma_rx.irq) {
+		dma_rx.irq = false;
+		isr_enter();
+		if (dma_rx.cb)
+			dma_rx.cb(dma_rx.num);
+	} else if (dma_tx.irq) {
+		dma_tx.irq = false;
+		isr_enter();
+		if (dma_tx.cb)
+			dma_tx.cb(dma_tx.num);
+	} else if (pending && bus.intr_cb) {
+		isr_enter();
+		bus.intr_cb(raw_status() & bus.mask);
+	} else if (systick_irq) {
+		systick_irq = false;
+		isr_enter();
+		if (systick_cb)
+			systick_cb();
+	} else {
+		return false;
+	}
+	return true;
+}
+
+/* Sleep until the next event and serve the interrupts */
+static void idle(void)
+{
+	hw_run(now);
+	if (isr_serve())
+		return;
+
+	/* Jump to the next hardware event */
+	if (bus.phase == BUS_ADDR || bus.phase == BUS_BYTE || bus.phase == BUS_STOP)
+		hw_run(bus.end < systick_due ? bus.end : systick_due);
+	else if (systick_due < INF)
+		hw_run(systick_due);
+	else {
+		fprintf(stderr, "Stalled at %.1f us: phase %d, tx %d, rx %d, raw 0x%X, mask 0x%X, dma %d/%d %d/%d en %d\n", now, bus.phase, bus.tx_n, bus.rx_n, raw_status(), bus.mask, dma_tx.num, dma_tx.len, dma_rx.num, dma_rx.len, bus.dma_en);
+		exit(EXIT_FAILURE);
+	}
+}
+
+/*
+ ****************************************************************************************
+ * Benchmark
+ ****************************************************************************************
+ */
+
+struct op {
+	bool write;
+	uint32_t address;
+	uint32_t size;
+	uint32_t offset;		/* in the data buffer */
+};
+
+struct scenario {
+	const char *name;
+	struct op *ops;
+	int nb;
+};
+
+struct result {
+	double ms;
+	double cpu_ms;
+	double irq_off_us;
+	uint32_t bytes;
+	uint32_t transactions;
+	uint32_t nacks;
+};
+
+static i2c_eeprom_async_cfg_t async_cfg = {
+	.dma_channel_pair = I2C_DMA_CHANNEL_PAIR_1,
+	.twr_us = 3000,
+	.poll_us = 200,
+	.poll_max = 100,
+};
+
+static i2c_cfg_t i2c_cfg = {
+	.speed = I2C_SPEED_FAST,
+	.address = SLAVE_ADDR,
+};
+
+static uint8_t *wr_data, *rd_data, *expect;
+static uint32_t data_len;
+static int async_pending, async_errors;
+static uint32_t seed = 1;
+
+static uint32_t rnd(void)
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	return seed;
+}
+
+static void usage(const char* my_name)
+{
+	fprintf(stderr,
+		"Version: " I2C_EEPROM_BENCH_VERSION "\n"
+		"\n"
+		"Usage: %s [-s size] [-p page] [-a bytes] [-w twr_us] [-k kbps] [-F depth]\n"
+		"          [-t twr_us] [-P poll_us]\n"
+		"\n"
+		"  Runs the I2C EEPROM driver (i2c_eeprom.c) and the asynchronous engine\n"
+		"  (i2c_eeprom_async.c) against a model of the DA14531 I2C controller, DMA,\n"
+		"  SysTick and of an I2C EEPROM, and reports for each scenario the time,\n"
+		"  the throughput, the CPU time, the longest time with the interrupts\n"
+		"  disabled and the bus transactions. The synchronous driver keeps the CPU\n"
+		"  busy for the whole transfer; the asynchronous engine only for its calls\n"
+		"  and interrupts. The data read and written are checked.\n"
+		"\n"
+		"  EEPROM:\n"
+		"  -s size      memory size in bytes (default 32768)\n"
+		"  -p page      page size in bytes (default 64)\n"
+		"  -a bytes     memory address bytes, 1 to 3 (default 2)\n"
+		"  -w twr_us    internal write cycle (default 3500)\n"
+		"  I2C:\n"
+		"  -k kbps      bus speed, 100 or 400 (default 400)\n"
+		"  -F depth     FIFO depth, 32 to 64 (default 32)\n"
+		"  Asynchronous engine:\n"
+		"  -t twr_us    delay to the first ACK poll (default 3000)\n"
+		"  -P poll_us   ACK poll period (default 200)\n",
+		my_name);
+}
+
+static void model_reset(void)
+{
+	uint32_t i;
+
+	for (i = 0; i < ee.size; i++)
+		ee.mem[i] = (uint8_t)(i * 7 + 3);
+	ee.busy_until = 0;
+	ee.writes = 0;
+	ee.ptr = 0;
+	memset(&bus.tx, 0, sizeof(bus.tx));
+	bus.tx_n = bus.rx_n = 0;
+	bus.phase = BUS_IDLE;
+	bus.raw = bus.abort_source = 0;
+	bus.flush = false;
+	bus.dma_en = false;
+	bus.transactions = bus.nacks = 0;
+	memset(&dma_rx, 0, sizeof(dma_rx));
+	memset(&dma_tx, 0, sizeof(dma_tx));
+	systick_due = INF;
+	systick_irq = false;
+	now = 0;
+	cpu_us = 0;
+	irq_off_max = 0;
+
+	/* Expected contents */
+	memcpy(expect, ee.mem, ee.size);
+	memset(rd_data, 0, data_len);
+}
+
+static void async_cb(void *cb_data, i2c_error_code status, uint32_t len)
+{
+	const struct op *op = cb_data;
+
+	if (status != I2C_NO_ERROR || len != op->size) {
+		fprintf(stderr, "%s of %u bytes at 0x%05X: status %d, %u bytes\n",
+			op->write ? "Write" : "Read", op->size, op->address, status, len);
+		async_errors++;
+	}
+	async_pending--;
+}
+
+static int run(const struct scenario *sc, bool async, struct result *r)
+{
+	int i, errors = 0;
+
+	model_reset();
+	i2c_eeprom_initialize();
+	if (async) {
+		i2c_eeprom_async_init(&async_cfg);
+		async_pending = 0;
+		async_errors = 0;
+	}
+	cpu_us = 0;
+
+	for (i = 0; i < sc->nb; i++) {
+		const struct op *op = &sc->ops[i];
+		uint32_t n = 0;
+		i2c_error_code status;
+
+		if (op->write)
+			memcpy(&expect[op->address], &wr_data[op->offset], op->size);
+
+		if (!async) {
+			status = op->write ?
+				i2c_eeprom_write_data(&wr_data[op->offset], op->address, op->size, &n) :
+				i2c_eeprom_read_data(&rd_data[op->offset], op->address, op->size, &n);
+			if (status != I2C_NO_ERROR || n != op->size) {
+				fprintf(stderr, "Synchronous op %d: status %d, %u bytes\n", i, status, n);
+				errors++;
+			}
+			continue;
+		}
+
+		/* Wait for room in the queue */
+		for (;;) {
+			status = op->write ?
+				i2c_eeprom_write_data_async(&wr_data[op->offset], op->address, op->size,
+							    async_cb, (void *)op) :
+				i2c_eeprom_read_data_async(&rd_data[op->offset], op->address, op->size,
+							   async_cb, (void *)op);
+			if (status != I2C_QUEUE_FULL_ERROR)
+				break;
+			idle();
+		}
+		if (status != I2C_NO_ERROR) {
+			fprintf(stderr, "Asynchronous op %d: status %d\n", i, status);
+			errors++;
+		} else {
+			async_pending++;
+		}
+	}
+
+	if (async) {
+		while (i2c_eeprom_async_busy())
+			idle();
+		errors += async_errors + (async_pending != 0);
+		r->cpu_ms = cpu_us / 1000;
+	} else {
+		/* The last page written, as the asynchronous completion */
+		if (sc->ops[sc->nb - 1].write && i2c_wait_until_eeprom_ready() != I2C_NO_ERROR)
+			errors++;
+		r->cpu_ms = now / 1000;
+	}
+	r->ms = now / 1000;
+	r->irq_off_us = irq_off_max;
+	r->transactions = bus.transactions;
+	r->nacks = bus.nacks;
+	r->bytes = 0;
+	for (i = 0; i < sc->nb; i++) {
+		const struct op *op = &sc->ops[i];
+
+		r->bytes += op->size;
+		if (!op->write && memcmp(&rd_data[op->offset], &expect[op->address], op->size)) {
+			fprintf(stderr, "%s: read %d does not match\n", sc->name, i);
+			errors++;
+		}
+	}
+	if (memcmp(ee.mem, expect, ee.size)) {
+		fprintf(stderr, "%s: EEPROM contents do not match\n", sc->name);
+		errors++;
+	}
+	i2c_eeprom_release();
+
+	return errors;
+}
+
+static void print_result(const char *name, const char *driver, const struct result *r)
+{
+	printf("%-12s %-6s %9.2f %8.1f %9.2f %6.1f %9.1f %7u %6u\n", name, driver, r->ms,
+	       r->bytes / r->ms, r->cpu_ms, 100 * r->cpu_ms / r->ms, r->irq_off_us,
+	       r->transactions, r->nacks);
+}
+
+int main(int argc, char **argv)
+{
+	i2c_eeprom_cfg_t eeprom_cfg = {
+		.size = 0x8000,
+		.page_size = 64,
+		.address_size = I2C_2BYTES_ADDR,
+	};
+	struct op read_ops[1], write_ops[1], record_ops[7], small_ops[64];
+	struct scenario scenarios[4];
+	int kbps = 400, opt, i, errors = 0;
+	uint32_t span;
+
+	ee.twr_us = 3500;
+	bus.fifo_depth = 32;
+
+	while ((opt = getopt(argc, argv, "s:p:a:w:k:F:t:P:")) != -1) {
+		switch (opt) {
+		case 's':
+			eeprom_cfg.size = strtoul(optarg, NULL, 0);
+			break;
+		case 'p':
+			eeprom_cfg.page_size = atoi(optarg);
+			break;
+		case 'a':
+			eeprom_cfg.address_size = atoi(optarg) - 1;
+			break;
+		case 'w':
+			ee.twr_us = atof(optarg);
+			break;
+		case 'k':
+			kbps = atoi(optarg);
+			break;
+		case 'F':
+			bus.fifo_depth = atoi(optarg);
+			break;
+		case 't':
+			async_cfg.twr_us = atoi(optarg);
+			break;
+		case 'P':
+			async_cfg.poll_us = atoi(optarg);
+			break;
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	if (eeprom_cfg.address_size > I2C_3BYTES_ADDR || eeprom_cfg.page_size == 0 ||
+	    eeprom_cfg.page_size > I2C_EEPROM_ASYNC_PAGE_MAX || eeprom_cfg.size % eeprom_cfg.page_size ||
+	    eeprom_cfg.size < 256 || bus.fifo_depth < 32 || bus.fifo_depth > FIFO_MAX ||
+	    (kbps != 100 && kbps != 400) || !async_cfg.twr_us || !async_cfg.poll_us) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+	/* 1 byte addresses: block select bits are not modelled */
+	if (eeprom_cfg.address_size == I2C_1BYTE_ADDR && eeprom_cfg.size > 256)
+		eeprom_cfg.size = 256;
+	i2c_cfg.speed = (kbps == 400) ? I2C_SPEED_FAST : I2C_SPEED_STANDARD;
+
+	ee.size = eeprom_cfg.size;
+	ee.page_size = eeprom_cfg.page_size;
+	ee.address_size = eeprom_cfg.address_size;
+	ee.mem = malloc(ee.size);
+	expect = malloc(ee.size);
+	/* Room for the data of the 64 lookups on the small memories */
+	data_len = (ee.size < 64 * 16) ? 64 * 16 : ee.size;
+	wr_data = malloc(data_len);
+	rd_data = malloc(data_len);
+	if (!ee.mem || !expect || !wr_data || !rd_data) {
+		perror("malloc");
+		return EXIT_FAILURE;
+	}
+	for (i = 0; i < (int)data_len; i++)
+		wr_data[i] = rnd();
+	i2c_eeprom_configure(&i2c_cfg, &eeprom_cfg);
+
+	/* Sequential read and write of up to 4 KB, from the second page */
+	span = (ee.size / 2 < 4096) ? ee.size / 2 : 4096;
+	read_ops[0] = (struct op){ false, ee.page_size, span, 0 };
+	write_ops[0] = (struct op){ true, ee.page_size, span, 0 };
+
+	/* Records across page boundaries, read back at once */
+	for (i = 0; i < 6; i++)
+		record_ops[i] = (struct op){ true, ee.size / 2 + i * (span / 40), span / 40, i * (span / 40) };
+	record_ops[6] = (struct op){ false, ee.size / 2, 6 * (span / 40), 0 };
+
+	/* Lookups */
+	for (i = 0; i < 64; i++)
+		small_ops[i] = (struct op){ false, rnd() % (ee.size - 16), 16, i * 16 };
+
+	scenarios[0] = (struct scenario){ "read", read_ops, 1 };
+	scenarios[1] = (struct scenario){ "write", write_ops, 1 };
+	scenarios[2] = (struct scenario){ "records", record_ops, 7 };
+	scenarios[3] = (struct scenario){ "lookups", small_ops, 64 };
+
+	printf("EEPROM %u bytes, %u bytes pages, %d address bytes, write cycle %.0f us\n"
+	       "I2C %d kbit/s, FIFO %d, engine first poll %u us, poll period %u us\n\n",
+	       ee.size, ee.page_size, ee.address_size + 1, ee.twr_us, kbps, bus.fifo_depth,
+	       async_cfg.twr_us, async_cfg.poll_us);
+	printf("%-12s %-6s %9s %8s %9s %6s %9s %7s %6s\n", "scenario", "driver", "ms", "KB/s",
+	       "CPU ms", "CPU %", "IRQoff us", "transf", "NACKs");
+
+	for (i = 0; i < 4; i++) {
+		struct result sync, async;
+		int e;
+
+		e = run(&scenarios[i], false, &sync);
+		e += run(&scenarios[i], true, &async);
+		print_result(scenarios[i].name, "sync", &sync);
+		print_result(scenarios[i].name, "async", &async);
+		if (async.cpu_ms >= sync.cpu_ms) {
+			printf("%-12s asynchronous CPU time not below synchronous\n", scenarios[i].name);
+			e++;
+		}
+		errors += e;
+	}
+
+	free(ee.mem);
+	free(expect);
+	free(wr_data);
+	free(rd_data);
+
+	return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
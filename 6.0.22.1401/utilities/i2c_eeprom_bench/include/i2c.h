@@ -0,0 +1,122 @@
+/**
+ ****************************************************************************************
+ *
+ * @file i2c.h
+ *
+ * @brief I2C driver of the I2C EEPROM model (DA14531 controller).
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _I2C_H_
+#define _I2C_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "arch.h"
+
+/* I2C_DATA_CMD_REG bits */
+#define I2C_CMD				(0x0100)
+#define I2C_STOP			(0x0200)
+
+/* I2C_TX_ABRT_SOURCE_REG bits */
+#define ABRT_7B_ADDR_NOACK		(0x0001)
+#define ABRT_TXDATA_NOACK		(0x0008)
+
+enum
+{
+	I2C_F_NONE =		0x00000000,
+	I2C_F_WAIT_FOR_STOP =	0x00000001,
+	I2C_F_ADD_STOP =	0x00000002,
+};
+
+typedef enum
+{
+	I2C_CONTROLLER_DISABLE = 0,
+	I2C_CONTROLLER_ENABLE = 1,
+} i2c_controller_t;
+
+typedef enum
+{
+	I2C_SPEED_STANDARD = 1,
+	I2C_SPEED_FAST = 0,
+} i2c_speed_t;
+
+enum
+{
+	I2C_INT_RX_FULL = 0x0004,
+	I2C_INT_TX_EMPTY = 0x0010,
+	I2C_INT_TX_ABORT = 0x0040,
+	I2C_INT_STOP_DETECTED = 0x0200,
+};
+
+typedef enum
+{
+	I2C_DMA_TRANSFER_WRITE = 0,
+	I2C_DMA_TRANSFER_MASTER_READ = 1,
+	I2C_DMA_TRANSFER_SLAVE_READ = 2,
+} i2c_dma_transfer_t;
+
+typedef enum
+{
+	I2C_DMA_CHANNEL_PAIR_1 = 0,
+	I2C_DMA_CHANNEL_PAIR_2 = 2,
+} i2c_dma_channel_pair_t;
+
+typedef void (*i2c_interrupt_cb_t)(uint16_t mask);
+typedef void (*i2c_complete_cb_t)(void *cb_data, uint16_t len, bool success);
+
+/* The fields used by the EEPROM drivers */
+typedef struct
+{
+	i2c_speed_t speed;
+	uint16_t address;
+} i2c_cfg_t;
+
+void i2c_init(const i2c_cfg_t *cfg);
+void i2c_release(void);
+void i2c_set_controller_status(i2c_controller_t status);
+void i2c_set_target_address(uint16_t address);
+void i2c_write_byte(uint16_t byte);
+uint8_t i2c_read_byte(void);
+uint8_t i2c_is_tx_fifo_empty(void);
+uint8_t i2c_is_tx_fifo_not_full(void);
+uint8_t i2c_get_rx_fifo_level(void);
+uint8_t i2c_is_master_busy(void);
+uint16_t i2c_get_abort_source(void);
+void i2c_reset_int_tx_abort(void);
+void i2c_reset_int_stop_detected(void);
+void i2c_set_int_mask(uint16_t mask);
+uint16_t i2c_get_int_mask(void);
+void i2c_register_int(i2c_interrupt_cb_t cb, uint16_t mask);
+void i2c_unregister_int(void);
+
+void i2c_master_receive_buffer_async(uint8_t *data, uint16_t len, i2c_complete_cb_t cb, void *cb_data, uint32_t flags);
+void i2c_master_transmit_buffer_dma(i2c_dma_channel_pair_t dma_channel_pair, const uint16_t *data, uint16_t len, i2c_complete_cb_t cb, void *cb_data, uint32_t flags);
+void i2c_prepare_dma(i2c_dma_channel_pair_t dma_channel_pair, void *data, uint16_t len, i2c_dma_transfer_t type, i2c_complete_cb_t cb, void *cb_data, uint32_t flags);
+void i2c_dma_start(void);
+
+#endif /* _I2C_H_ */
@@ -0,0 +1,888 @@
+/**
+ ****************************************************************************************
+ *
+ * @file link_telemetry_collector.c
+ *
+ * @brief Host collector of the link telemetry buckets.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "host_transport.h"
+#include "rwip_config.h"
+#include "reg_ble_em_rx_desc.h"
+#include "link_telemetry.h"
+
+#define LINK_TELEMETRY_COLLECTOR_VERSION	"v_1.0"
+
+/* Vendor HCI commands of the hci project (dialog_commands.h) */
+#define HCI_LINK_TELEMETRY_GET_CMD_OPCODE	0xFE01
+#define HCI_LINK_TELEMETRY_RESET_CMD_OPCODE	0xFE02
+#define HCI_CMD_CMP_EVT_CODE			0x0E
+#define HCI_TIMEOUT_MS				1000
+
+#define CO_ERROR_NO_ERROR			0x00
+#define CO_ERROR_UNKNOWN_CONNECTION_ID		0x02
+
+/* Handles scanned on a device, the scan stops at the first unknown one */
+#define MAX_LINKS				16
+
+/* BLE time: 625 us slots, 27 bits */
+#define SLOT_US					625
+#define TIME_MASK				0x07FFFFFF
+#define PERIOD_SLOTS				((uint32_t)LINK_TELEMETRY_PERIOD * 8 / 5)
+
+/* Result of a bucket read */
+enum {
+	READ_OK,
+	READ_NO_BUCKET,
+	READ_NO_LINK,
+	READ_FAILED = -1,
+};
+
+/* Decoded record */
+struct tlm_rec {
+	uint8_t conhdl;
+	uint8_t flags;
+	uint8_t age;
+	uint8_t conn;
+	uint8_t buckets;
+	uint16_t seq;
+	uint16_t interval;
+	uint16_t latency;
+	uint32_t start;
+	uint32_t last;
+	uint16_t events;
+	uint16_t rx_ok;
+	uint16_t rx_crc;
+	uint16_t rx_sync;
+	uint16_t rx_other;
+	uint16_t rssi[LINK_TELEMETRY_RSSI_BINS];
+	uint16_t pkts[LINK_TELEMETRY_PKTS_BINS];
+	uint16_t wakeup[LINK_TELEMETRY_WAKEUP_BINS];
+};
+
+/* Collector state of a connection handle */
+struct link_state {
+	int open_valid;			/* open holds a bucket with events */
+	struct tlm_rec open;		/* last snapshot of the current bucket */
+	int conn_valid;
+	uint8_t conn;			/* connection of the buckets reported */
+	int seq_valid;
+	uint16_t seq;			/* newest closed bucket reported */
+	struct tlm_rec total;		/* sum of the buckets reported */
+	unsigned int reported;
+	unsigned int partial;
+};
+
+static const uint16_t wakeup_edges[] = LINK_TELEMETRY_WAKEUP_EDGES_US;
+
+static int (*read_bucket)(uint8_t conhdl, uint8_t age, uint8_t *rec);
+static void (*bucket_done)(const struct tlm_rec *r, int partial);
+
+static struct link_state links[MAX_LINKS];
+static unsigned int nb_links = MAX_LINKS;
+static FILE *csv;
+static int quiet;
+static volatile sig_atomic_t stop;
+
+static void usage(const char* my_name)
+{
+	fprintf(stderr,
+		"Version: " LINK_TELEMETRY_COLLECTOR_VERSION "\n"
+		"\n"
+		"Usage: %s -p port [-b baud] [-i seconds] [-t seconds] [-r] [-o csv] [-q]\n"
+		"       %s -s seed[,seconds] [-i seconds] [-o csv] [-q]\n"
+		"\n"
+		"  Collects the link telemetry buckets of a device running the hci project\n"
+		"  built with CFG_LINK_TELEMETRY. Every poll reads the buckets of each\n"
+		"  connection handle with the vendor HCI command and reports the buckets\n"
+		"  closed since the previous poll once: CRC and other error rates, empty\n"
+		"  receive windows per event, RSSI median, packets per event and the ratio\n"
+		"  of late wake-ups. The last bucket of a connection is reported as partial.\n"
+		"\n"
+		"  -p port      serial port of the device\n"
+		"  -b baud      baud rate (default 115200)\n"
+		"  -i seconds   poll period (default 5)\n"
+		"  -t seconds   collection time (default: until interrupted)\n"
+		"  -r           reset the telemetry of all the connections first\n"
+		"  -o csv       write the reported buckets to a CSV file\n"
+		"  -q           print the summary only\n"
+		"  -s seed[,seconds]\n"
+		"               replay mode: runs the SDK link telemetry on the host with\n"
+		"               generated links (default 300 s), collects it with the same\n"
+		"               code as a device and compares every reported bucket with\n"
+		"               the generated traffic. Exits with a failure on a mismatch.\n",
+		my_name, my_name);
+}
+
+/*
+ ****************************************************************************************
+ * Records
+ ****************************************************************************************
+ */
+
+static uint32_t get_le(const uint8_t *p, unsigned int len)
+{
+	uint32_t value = 0;
+
+	while (len--)
+		value = (value << 8) | p[len];
+	return value;
+}
+
+static int tlm_parse(const uint8_t *p, struct tlm_rec *r)
+{
+	const uint8_t *q = &p[30];
+	int i;
+
+	if (p[0] != LINK_TELEMETRY_REC_VERSION)
+		return -1;
+
+	r->conhdl = p[1];
+	r->flags = p[2];
+	r->age = p[3];
+	r->conn = p[4];
+	r->buckets = p[5];
+	r->seq = get_le(&p[6], 2);
+	r->interval = get_le(&p[8], 2);
+	r->latency = get_le(&p[10], 2);
+	r->start = get_le(&p[12], 4);
+	r->last = get_le(&p[16], 4);
+	r->events = get_le(&p[20], 2);
+	r->rx_ok = get_le(&p[22], 2);
+	r->rx_crc = get_le(&p[24], 2);
+	r->rx_sync = get_le(&p[26], 2);
+	r->rx_other = get_le(&p[28], 2);
+	for (i = 0; i < LINK_TELEMETRY_RSSI_BINS; i++, q += 2)
+		r->rssi[i] = get_le(q, 2);
+	for (i = 0; i < LINK_TELEMETRY_PKTS_BINS; i++, q += 2)
+		r->pkts[i] = get_le(q, 2);
+	for (i = 0; i < LINK_TELEMETRY_WAKEUP_BINS; i++, q += 2)
+		r->wakeup[i] = get_le(q, 2);
+
+	return 0;
+}
+
+/* Add the counters of a bucket to a total; the totals do not saturate at 16 bits
+ * in practice because a summary covers a few hours at most */
+static void tlm_add(struct tlm_rec *t, const struct tlm_rec *r)
+{
+	int i;
+
+	t->events += r->events;
+	t->rx_ok += r->rx_ok;
+	t->rx_crc += r->rx_crc;
+	t->rx_sync += r->rx_sync;
+	t->rx_other += r->rx_other;
+	for (i = 0; i < LINK_TELEMETRY_RSSI_BINS; i++)
+		t->rssi[i] += r->rssi[i];
+	for (i = 0; i < LINK_TELEMETRY_PKTS_BINS; i++)
+		t->pkts[i] += r->pkts[i];
+	for (i = 0; i < LINK_TELEMETRY_WAKEUP_BINS; i++)
+		t->wakeup[i] += r->wakeup[i];
+}
+
+static double ratio(unsigned int n, unsigned int d)
+{
+	return d ? (double)n / d : 0.0;
+}
+
+/* Print the RSSI bin holding the median packet */
+static void print_rssi_median(FILE *f, const uint16_t *rssi)
+{
+	unsigned int total = 0, sum = 0;
+	int i;
+
+	for (i = 0; i < LINK_TELEMETRY_RSSI_BINS; i++)
+		total += rssi[i];
+	if (!total) {
+		fprintf(f, "%-10s", "-");
+		return;
+	}
+	for (i = 0; sum + rssi[i] <= total / 2; i++)
+		sum += rssi[i];
+
+	if (i == 0)
+		fprintf(f, "<%-9d", LINK_TELEMETRY_RSSI_EDGE(0));
+	else if (i == LINK_TELEMETRY_RSSI_BINS - 1)
+		fprintf(f, ">=%-8d", LINK_TELEMETRY_RSSI_EDGE(i - 1));
+	else
+		fprintf(f, "%d..%-5d", LINK_TELEMETRY_RSSI_EDGE(i - 1), LINK_TELEMETRY_RSSI_EDGE(i));
+}
+
+static void print_stats(FILE *f, const struct tlm_rec *r)
+{
+	unsigned int rx = r->rx_ok + r->rx_crc + r->rx_other;
+	unsigned int wakeups = 0;
+	int i;
+
+	for (i = 0; i < LINK_TELEMETRY_WAKEUP_BINS; i++)
+		wakeups += r->wakeup[i];
+
+	fprintf(f, "evts %6u  rx %7u  crc %5.1f%%  oth %4.1f%%  miss/evt %4.2f  rssi ",
+		r->events, rx, 100.0 * ratio(r->rx_crc, rx), 100.0 * ratio(r->rx_other, rx),
+		ratio(r->rx_sync, r->events));
+	print_rssi_median(f, r->rssi);
+	fprintf(f, "  pkt/evt %4.2f [%u %u %u %u]  late %4.1f%%\n",
+		ratio(rx, r->events), r->pkts[0], r->pkts[1], r->pkts[2], r->pkts[3],
+		100.0 * ratio(wakeups - r->wakeup[0], wakeups));
+}
+
+static void csv_header(void)
+{
+	int i;
+
+	fprintf(csv, "conhdl,conn,seq,partial,saturated,interval,latency,start,last,"
+		"events,rx_ok,rx_crc,rx_sync,rx_other");
+	for (i = 0; i < LINK_TELEMETRY_RSSI_BINS; i++)
+		fprintf(csv, ",rssi%d", i);
+	for (i = 0; i < LINK_TELEMETRY_PKTS_BINS; i++)
+		fprintf(csv, ",pkts%d", i);
+	for (i = 0; i < LINK_TELEMETRY_WAKEUP_BINS; i++)
+		fprintf(csv, ",wakeup%d", i);
+	fprintf(csv, "\n");
+}
+
+static void csv_row(const struct tlm_rec *r, int partial)
+{
+	int i;
+
+	fprintf(csv, "%u,%u,%u,%d,%d,%u,%u,%u,%u,%u,%u,%u,%u,%u",
+		r->conhdl, r->conn, r->seq, partial, !!(r->flags & LINK_TELEMETRY_SATURATED),
+		r->interval, r->latency, r->start, r->last,
+		r->events, r->rx_ok, r->rx_crc, r->rx_sync, r->rx_other);
+	for (i = 0; i < LINK_TELEMETRY_RSSI_BINS; i++)
+		fprintf(csv, ",%u", r->rssi[i]);
+	for (i = 0; i < LINK_TELEMETRY_PKTS_BINS; i++)
+		fprintf(csv, ",%u", r->pkts[i]);
+	for (i = 0; i < LINK_TELEMETRY_WAKEUP_BINS; i++)
+		fprintf(csv, ",%u", r->wakeup[i]);
+	fprintf(csv, "\n");
+}
+
+/*
+ ****************************************************************************************
+ * Collection
+ ****************************************************************************************
+ */
+
+static void report(const struct tlm_rec *r, int partial)
+{
+	struct link_state *l = &links[r->conhdl];
+
+	tlm_add(&l->total, r);
+	l->reported++;
+	l->partial += partial;
+
+	if (!quiet) {
+		printf("%u/%-3u #%-5u %c%c %6.2fms %7.1fs  ", r->conhdl, r->conn, r->seq,
+		       partial ? 'P' : ' ', (r->flags & LINK_TELEMETRY_SATURATED) ? 'S' : ' ',
+		       r->interval * SLOT_US / 1000.0,
+		       (((r->last - r->start) & TIME_MASK) * (double)SLOT_US) / 1000000);
+		print_stats(stdout, r);
+	}
+	if (csv)
+		csv_row(r, partial);
+	if (bucket_done)
+		bucket_done(r, partial);
+}
+
+/* The current bucket of a connection that has ended is only known up to the last poll */
+static void flush_open(struct link_state *l)
+{
+	if (l->open_valid)
+		report(&l->open, 1);
+	l->open_valid = 0;
+	l->conn_valid = 0;
+	l->seq_valid = 0;
+}
+
+static int poll_link(uint8_t conhdl)
+{
+	struct link_state *l = &links[conhdl];
+	uint8_t rec[LINK_TELEMETRY_REC_LEN];
+	struct tlm_rec cur, closed[128];
+	int n = 0, res, age;
+
+	res = read_bucket(conhdl, 0, rec);
+	if (res != READ_OK) {
+		if (res == READ_NO_BUCKET)
+			flush_open(l);
+		return res;
+	}
+	if (tlm_parse(rec, &cur)) {
+		fprintf(stderr, "Unsupported record version %u\n", rec[0]);
+		return READ_FAILED;
+	}
+	if (l->conn_valid && cur.conn != l->conn)
+		flush_open(l);
+	l->conn = cur.conn;
+	l->conn_valid = 1;
+
+	/* Newest first, down to the last bucket already reported */
+	for (age = 1; age < cur.buckets && n < 128; age++) {
+		res = read_bucket(conhdl, age, rec);
+		if (res == READ_FAILED)
+			return res;
+		if (res != READ_OK || tlm_parse(rec, &closed[n]) || closed[n].conn != cur.conn)
+			break;
+		if (l->seq_valid && (int16_t)(closed[n].seq - l->seq) <= 0)
+			break;
+		n++;
+	}
+	while (n--) {
+		report(&closed[n], 0);
+		l->seq = closed[n].seq;
+		l->seq_valid = 1;
+	}
+
+	/* A bucket is opened at the end of the last event of the previous one */
+	l->open = cur;
+	l->open_valid = (cur.events != 0);
+
+	return READ_OK;
+}
+
+static int poll_all(void)
+{
+	unsigned int i;
+	int res;
+
+	for (i = 0; i < nb_links; i++) {
+		res = poll_link(i);
+		if (res == READ_FAILED)
+			return -1;
+		if (res == READ_NO_LINK) {
+			nb_links = i;
+			break;
+		}
+	}
+	return 0;
+}
+
+static void print_summary(void)
+{
+	unsigned int i;
+
+	printf("\nSummary (buckets of %u ms)\n", LINK_TELEMETRY_PERIOD);
+	for (i = 0; i < nb_links; i++) {
+		if (!links[i].reported)
+			continue;
+		printf("%u: %3u buckets, %u partial  ", i, links[i].reported, links[i].partial);
+		print_stats(stdout, &links[i].total);
+	}
+}
+
+/*
+ ****************************************************************************************
+ * Device
+ ****************************************************************************************
+ */
+
+static ht_transport transport;
+
+static int hci_cmd(uint16_t opcode, const uint8_t *params, uint8_t len, uint8_t *ret, uint8_t ret_len)
+{
+	uint8_t cmd[3 + 2];
+	uint32_t waited = 0;
+	ht_frame *f;
+
+	cmd[0] = opcode & 0xFF;
+	cmd[1] = opcode >> 8;
+	cmd[2] = len;
+	memcpy(&cmd[3], params, len);
+	if (ht_transport_send(&transport, HT_PKT_HCI_CMD, cmd, 3 + len))
+		return -1;
+
+	while (waited < HCI_TIMEOUT_MS) {
+		f = ht_queue_peek(&transport.queue);
+		if (!f) {
+			if (ht_transport_rx_poll(&transport, 50) < 0)
+				return -1;
+			waited += 50;
+			continue;
+		}
+		/* event code, length, number of commands, opcode, return parameters */
+		if (f->data[0] == HCI_CMD_CMP_EVT_CODE && f->length >= 5 + ret_len &&
+		    get_le(&f->data[3], 2) == opcode) {
+			memcpy(ret, &f->data[5], ret_len);
+			ht_queue_release(&transport.queue);
+			return 0;
+		}
+		ht_queue_release(&transport.queue);
+	}
+	fprintf(stderr, "No response to command 0x%04X\n", opcode);
+	return -1;
+}
+
+static int hci_read_bucket(uint8_t conhdl, uint8_t age, uint8_t *rec)
+{
+	uint8_t params[2] = { conhdl, age };
+	uint8_t ret[1 + LINK_TELEMETRY_REC_LEN];
+
+	if (hci_cmd(HCI_LINK_TELEMETRY_GET_CMD_OPCODE, params, 2, ret, sizeof(ret)))
+		return READ_FAILED;
+	if (ret[0] == CO_ERROR_UNKNOWN_CONNECTION_ID)
+		return READ_NO_LINK;
+	if (ret[0] != CO_ERROR_NO_ERROR)
+		return READ_NO_BUCKET;
+	memcpy(rec, &ret[1], LINK_TELEMETRY_REC_LEN);
+	return READ_OK;
+}
+
+static void on_signal(int sig)
+{
+	stop = 1;
+}
+
+static int run_device(const char *port, uint32_t baud, unsigned int poll_s, unsigned int time_s, int reset)
+{
+	time_t end = time(NULL) + time_s;
+	unsigned int i;
+
+	ht_transport_init(&transport, HT_FILTER(HT_PKT_HCI_EVT), NULL, NULL);
+	if (ht_port_open(&transport.port, port, baud, 0)) {
+		fprintf(stderr, "Cannot open %s\n", port);
+		return EXIT_FAILURE;
+	}
+	read_bucket = hci_read_bucket;
+
+	if (reset) {
+		uint8_t all = LINK_TELEMETRY_ALL, ret[2];
+
+		if (hci_cmd(HCI_LINK_TELEMETRY_RESET_CMD_OPCODE, &all, 1, ret, sizeof(ret)) ||
+		    ret[0] != CO_ERROR_NO_ERROR) {
+			fprintf(stderr, "Reset failed, is the firmware built with CFG_LINK_TELEMETRY?\n");
+			return EXIT_FAILURE;
+		}
+	}
+
+	signal(SIGINT, on_signal);
+	while (!stop) {
+		if (poll_all())
+			return EXIT_FAILURE;
+		if (time_s && time(NULL) >= end)
+			break;
+		for (i = 0; i < poll_s * 10 && !stop; i++)
+			ht_sleep_ms(100);
+	}
+
+	for (i = 0; i < nb_links; i++)
+		flush_open(&links[i]);
+	print_summary();
+	ht_port_close(&transport.port);
+
+	return EXIT_SUCCESS;
+}
+
+/*
+ ****************************************************************************************
+ * Replay: the SDK code fed with generated links
+ ****************************************************************************************
+ */
+
+#define SIM_ADV		BLE_CONNECTION_MAX	/* link label and handle of advertising */
+
+struct sim_profile {
+	const char *name;
+	int rssi;		/* dBm */
+	int rssi_spread;
+	int crc_pct;
+	int other_pct;
+	int sync_pct;		/* empty receive windows */
+	uint16_t interval;	/* slots */
+	uint16_t latency;
+	int max_pkts;
+};
+
+static const struct sim_profile sim_profiles[BLE_CONNECTION_MAX] = {
+	{ "near",  -48,  6,  1, 0,  1, 24, 0, 6 },
+	{ "edge",  -84,  8, 12, 1,  8, 40, 0, 3 },
+	{ "lossy", -93,  5, 30, 3, 20, 80, 2, 2 },
+};
+
+/* Expected bucket, in the order of the sequence numbers */
+struct sim_bucket {
+	struct tlm_rec rec;
+	int checked;
+};
+
+struct sim_link {
+	uint64_t next;		/* time of the next event, slots from the start */
+	uint16_t counter;
+	int up;
+	uint8_t conn;
+	unsigned int cur;	/* current bucket */
+};
+
+static struct sim_link sim_links[BLE_CONNECTION_MAX];
+static struct sim_bucket *sim_buckets;
+static unsigned int sim_nb_buckets, sim_max_buckets;
+static uint16_t sim_seq;
+static uint32_t sim_base;
+static unsigned int sim_errors, sim_closed, sim_partial;
+static uint32_t rnd_state;
+
+static uint32_t rnd(void)
+{
+	/* xorshift32 */
+	rnd_state ^= rnd_state << 13;
+	rnd_state ^= rnd_state >> 17;
+	rnd_state ^= rnd_state << 5;
+	return rnd_state;
+}
+
+/* DA14585 conversion (rf_585.c) */
+static uint8_t sim_rssi_convert(uint8_t rssi_reg)
+{
+	return (rssi_reg >> 1U) - 112U;
+}
+
+static int sim_rssi_bin(int dbm)
+{
+	int bin = 0;
+
+	while (bin < LINK_TELEMETRY_RSSI_BINS - 1 && dbm >= LINK_TELEMETRY_RSSI_EDGE(bin))
+		bin++;
+	return bin;
+}
+
+static int sim_wakeup_bin(uint32_t delay_us)
+{
+	int bin;
+
+	if (!delay_us)
+		return 0;
+	for (bin = 1; bin < LINK_TELEMETRY_WAKEUP_BINS - 1; bin++)
+		if (delay_us < wakeup_edges[bin - 1])
+			break;
+	return bin;
+}
+
+/* Buckets are opened in the same order as on the device: a connection opens its
+ * first one and the end of the last event of a bucket opens the next one */
+static unsigned int sim_new_bucket(uint8_t conhdl, uint8_t conn)
+{
+	struct sim_bucket *b;
+
+	if (sim_nb_buckets == sim_max_buckets) {
+		sim_max_buckets = sim_max_buckets ? 2 * sim_max_buckets : 64;
+		sim_buckets = realloc(sim_buckets, sim_max_buckets * sizeof(*sim_buckets));
+		if (!sim_buckets) {
+			perror("realloc");
+			exit(EXIT_FAILURE);
+		}
+	}
+	b = &sim_buckets[sim_nb_buckets++];
+	memset(b, 0, sizeof(*b));
+	b->rec.conhdl = conhdl;
+	b->rec.conn = conn;
+	b->rec.seq = sim_seq++;
+	return sim_nb_buckets - 1;
+}
+
+/* Wake-up before an event: often on time, sometimes late, not always measured */
+static int sim_wakeup(void)
+{
+	uint32_t r = rnd() % 100, delay;
+
+	if (r < 25)
+		return -1;
+	delay = (r < 85) ? 0 : 1 + rnd() % 4000;
+	link_telemetry_wakeup(delay);
+	return sim_wakeup_bin(delay);
+}
+
+static void sim_adv_event(uint64_t t)
+{
+	sim_wakeup();
+	link_telemetry_rx(SIM_ADV, 0, 0x80);
+	link_telemetry_event_end(SIM_ADV, 0, 0, 0, (sim_base + t) & TIME_MASK);
+}
+
+static void sim_conn_event(uint8_t conhdl, uint64_t t)
+{
+	const struct sim_profile *p = &sim_profiles[conhdl];
+	struct sim_link *l = &sim_links[conhdl];
+	uint32_t time = (sim_base + t) & TIME_MASK;
+	int wakeup = sim_wakeup();
+	int first = !l->up;
+	int pkts = rnd() % (p->max_pkts + 1), rx = 0, i;
+	struct sim_bucket *b;
+
+	if (first) {
+		/* The counter of a connection starts at 0; the first one starts close
+		 * to the wrap to check that it is not taken for a new connection */
+		l->up = 1;
+		l->conn++;
+		l->counter = (l->conn == 1 && conhdl == 0) ? 0xFFF0 : 0;
+		l->cur = sim_new_bucket(conhdl, l->conn);
+	}
+	b = &sim_buckets[l->cur];
+	if (!b->rec.events)
+		b->rec.start = time;
+
+	for (i = 0; i < pkts; i++) {
+		uint16_t status = 0;
+		int dbm = p->rssi + (int)(rnd() % (2 * p->rssi_spread + 1)) - p->rssi_spread;
+		uint8_t raw = (dbm + 112) * 2 + (rnd() & 1);
+		uint32_t r = rnd() % 100;
+
+		if (r < p->crc_pct)
+			status = BLE_CRC_ERR_BIT;
+		else if (r < p->crc_pct + p->other_pct)
+			status = (rnd() & 1) ? BLE_LEN_ERR_BIT : BLE_MIC_ERR_BIT;
+		link_telemetry_rx(conhdl, status, raw);
+
+		/* The packets of the first event of a connection are not accounted */
+		if (first)
+			continue;
+		rx++;
+		if (status & BLE_CRC_ERR_BIT)
+			b->rec.rx_crc++;
+		else if (status)
+			b->rec.rx_other++;
+		else {
+			b->rec.rx_ok++;
+			b->rec.rssi[sim_rssi_bin((int8_t)sim_rssi_convert(raw))]++;
+		}
+	}
+	if (rnd() % 100 < p->sync_pct) {
+		link_telemetry_rx(conhdl, BLE_SYNC_ERR_BIT, 0);
+		if (!first)
+			b->rec.rx_sync++;
+	}
+
+	link_telemetry_event_end(conhdl, l->counter, p->interval, p->latency, time);
+
+	b->rec.last = time;
+	b->rec.interval = p->interval;
+	b->rec.latency = p->latency;
+	b->rec.events++;
+	b->rec.pkts[(rx < 2) ? rx : (rx < 4) ? 2 : 3]++;
+	if (wakeup >= 0)
+		b->rec.wakeup[wakeup]++;
+	l->counter += p->latency + 1;
+
+	if (((time - b->rec.start) & TIME_MASK) >= PERIOD_SLOTS)
+		l->cur = sim_new_bucket(conhdl, l->conn);
+}
+
+static int sim_compare(const struct tlm_rec *a, const struct tlm_rec *b, int partial)
+{
+	/* A partial bucket is a snapshot of the last poll */
+	if (partial)
+		return a->events > b->events || a->rx_ok > b->rx_ok || a->rx_crc > b->rx_crc ||
+		       a->rx_sync > b->rx_sync || a->rx_other > b->rx_other;
+
+	return a->interval != b->interval || a->latency != b->latency ||
+	       a->start != b->start || a->last != b->last || a->events != b->events ||
+	       a->rx_ok != b->rx_ok || a->rx_crc != b->rx_crc || a->rx_sync != b->rx_sync ||
+	       a->rx_other != b->rx_other || memcmp(a->rssi, b->rssi, sizeof(a->rssi)) ||
+	       memcmp(a->pkts, b->pkts, sizeof(a->pkts)) ||
+	       memcmp(a->wakeup, b->wakeup, sizeof(a->wakeup));
+}
+
+static void sim_bucket_done(const struct tlm_rec *r, int partial)
+{
+	unsigned int i;
+
+	for (i = 0; i < sim_nb_buckets; i++) {
+		struct sim_bucket *b = &sim_buckets[i];
+
+		if (b->rec.seq != r->seq || b->rec.conhdl != r->conhdl)
+			continue;
+		if (b->checked || b->rec.conn != r->conn || sim_compare(r, &b->rec, partial)) {
+			fprintf(stderr, "Mismatch: handle %u connection %u bucket %u%s\n",
+				r->conhdl, r->conn, r->seq, b->checked ? " reported twice" : "");
+			sim_errors++;
+		}
+		b->checked = 1;
+		if (partial)
+			sim_partial++;
+		else
+			sim_closed++;
+		return;
+	}
+	fprintf(stderr, "Unexpected bucket %u of handle %u\n", r->seq, r->conhdl);
+	sim_errors++;
+}
+
+static int sim_read_bucket(uint8_t conhdl, uint8_t age, uint8_t *rec)
+{
+	if (conhdl >= BLE_CONNECTION_MAX)
+		return READ_NO_LINK;
+	return link_telemetry_read(conhdl, age, rec) ? READ_OK : READ_NO_BUCKET;
+}
+
+static int run_replay(uint32_t seed, unsigned int seconds, unsigned int poll_s)
+{
+	uint64_t end = (uint64_t)seconds * 1600, poll = (uint64_t)poll_s * 1600;
+	uint64_t next_poll = poll, next_adv = 0, t;
+	/* The second connection drops in the middle of the run and comes back */
+	uint64_t down = end / 2, up = end / 2 + 8 * 1600;
+	unsigned int i, missed = 0;
+	int conhdl;
+
+	rnd_state = seed ? seed : 1;
+	/* Start 40 s before the BLE time wraps */
+	sim_base = (TIME_MASK + 1) - 40 * 1600;
+	read_bucket = sim_read_bucket;
+	bucket_done = sim_bucket_done;
+	link_telemetry_init(sim_rssi_convert);
+
+	for (i = 0; i < BLE_CONNECTION_MAX; i++)
+		sim_links[i].next = 1 + rnd() % sim_profiles[i].interval;
+
+	for (;;) {
+		conhdl = -1;
+		t = next_adv;
+		for (i = 0; i < BLE_CONNECTION_MAX; i++) {
+			if (sim_links[i].next < t) {
+				t = sim_links[i].next;
+				conhdl = i;
+			}
+		}
+		if (t >= end)
+			break;
+		if (t >= next_poll) {
+			poll_all();
+			next_poll += poll;
+		}
+
+		if (conhdl < 0) {
+			sim_adv_event(t);
+			next_adv += 160 + rnd() % 16;
+			continue;
+		}
+
+		if (conhdl == 1 && t >= down && t < up) {
+			/* Disconnected */
+			sim_links[1].up = 0;
+			sim_links[1].next = up;
+			continue;
+		}
+		sim_conn_event(conhdl, t);
+		sim_links[conhdl].next += sim_profiles[conhdl].interval * (sim_profiles[conhdl].latency + 1);
+	}
+	poll_all();
+	for (i = 0; i < BLE_CONNECTION_MAX; i++)
+		flush_open(&links[i]);
+
+	/* Every bucket must have been reported, the last one of a connection as partial.
+	 * A bucket opened just before its connection dropped holds no event. */
+	for (i = 0; i < sim_nb_buckets; i++) {
+		if (!sim_buckets[i].checked && sim_buckets[i].rec.events) {
+			fprintf(stderr, "Bucket %u of handle %u not reported\n",
+				sim_buckets[i].rec.seq, sim_buckets[i].rec.conhdl);
+			missed++;
+		}
+	}
+	print_summary();
+	printf("\nReplay: %u buckets, %u closed and %u partial reported, %u mismatches, %u missed\n",
+	       sim_nb_buckets, sim_closed, sim_partial, sim_errors, missed);
+	free(sim_buckets);
+
+	return (sim_errors || missed) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv)
+{
+	const char *port = NULL, *csv_name = NULL;
+	uint32_t baud = 115200, seed = 0;
+	unsigned int poll_s = 5, time_s = 0, seconds = 300;
+	int opt, reset = 0, replay = 0, res;
+	char *end;
+
+	while ((opt = getopt(argc, argv, "p:b:i:t:ro:qs:")) != -1) {
+		switch (opt) {
+		case 'p':
+			port = optarg;
+			break;
+		case 'b':
+			baud = strtoul(optarg, NULL, 0);
+			break;
+		case 'i':
+			poll_s = strtoul(optarg, NULL, 0);
+			break;
+		case 't':
+			time_s = strtoul(optarg, NULL, 0);
+			break;
+		case 'r':
+			reset = 1;
+			break;
+		case 'o':
+			csv_name = optarg;
+			break;
+		case 'q':
+			quiet = 1;
+			break;
+		case 's':
+			replay = 1;
+			seed = strtoul(optarg, &end, 0);
+			if (*end == ',')
+				seconds = strtoul(end + 1, NULL, 0);
+			break;
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	if ((!port && !replay) || (port && replay) || !poll_s || !seconds) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if (csv_name) {
+		csv = fopen(csv_name, "w");
+		if (!csv) {
+			perror(csv_name);
+			return EXIT_FAILURE;
+		}
+		csv_header();
+	}
+
+	if (replay)
+		res = run_replay(seed, seconds, poll_s);
+	else
+		res = run_device(port, baud, poll_s, time_s, reset);
+
+	if (csv)
+		fclose(csv);
+	return res;
+}
@@ -0,0 +1,299 @@
+/**
+ ****************************************************************************************
+ *
+ * @file log_decoder.c
+ *
+ * @brief Host decoder for the deferred printf records of arch_console.
+ *
+ * Copyright (C) 2023 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#define LOG_DECODER_VERSION	"v_1.0"
+
+/* These must match arch_console.h */
+#define DEFERRED_MARKER		0x1E
+#define DEFERRED_HDR_LEN	6
+
+/* Default load address of the application image */
+#define DEFAULT_LOAD_ADDR	0x07FC0000
+
+/* Same as PRINT_SZ in arch_console.c */
+#define MAX_RECORD_LEN		256
+
+static uint8_t *image;
+static size_t image_size;
+static uint32_t load_addr = DEFAULT_LOAD_ADDR;
+
+static void usage(const char* my_name)
+{
+	fprintf(stderr,
+		"Version: " LOG_DECODER_VERSION "\n"
+		"\n"
+		"Usage:\n"
+		"  %s app_bin [load_addr] [capture_file]\n"
+		"\n"
+		"  Expand the deferred printf records (CFG_PRINTF_DEFERRED) found\n"
+		"  in the UART capture 'capture_file' (or the standard input) and\n"
+		"  write the text to the standard output.\n"
+		"  'app_bin' is the raw binary image (e.g. .bin file) of the\n"
+		"  application that produced the capture. It is used to look up\n"
+		"  the format strings. 'load_addr' is the address the image is\n"
+		"  executed from (default 0x%08X). It can be given either as a\n"
+		"  decimal or hex number.\n"
+		"  Bytes that are not part of a valid record are copied as is.\n",
+		my_name, DEFAULT_LOAD_ADDR);
+}
+
+static int read_image(const char *filename)
+{
+	FILE *f;
+	long size;
+
+	f = fopen(filename, "rb");
+	if (!f) {
+		fprintf(stderr, "Could not open %s (%s)\n", filename, strerror(errno));
+		return -1;
+	}
+
+	if (fseek(f, 0, SEEK_END) || (size = ftell(f)) < 0 || fseek(f, 0, SEEK_SET)) {
+		fprintf(stderr, "Could not get the size of %s\n", filename);
+		fclose(f);
+		return -1;
+	}
+
+	image_size = size;
+	image = malloc(image_size + 1);
+	if (!image || fread(image, 1, image_size, f) != image_size) {
+		fprintf(stderr, "Could not read %s\n", filename);
+		fclose(f);
+		return -1;
+	}
+	/* make sure the last string in the image is terminated */
+	image[image_size] = '\0';
+
+	fclose(f);
+	return 0;
+}
+
+static const char *lookup_format(uint32_t addr)
+{
+	if (addr < load_addr || addr - load_addr >= image_size)
+		return NULL;
+
+	return (const char *) &image[addr - load_addr];
+}
+
+static uint32_t get_le32(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static void print_int(FILE *out, uint32_t val, int radix, int uppercase, int pad,
+		      int is_signed)
+{
+	char buf[24];
+	char *p = buf + sizeof(buf);
+	int negative = 0;
+	int len;
+
+	/* same rules as arch_itoa() */
+	if (is_signed && radix == 10 && (int32_t) val < 0) {
+		negative = 1;
+		val = -val;
+	}
+
+	*(--p) = '\0';
+	do {
+		int digit = val % radix;
+		*(--p) = digit < 10 ? '0' + digit : (uppercase ? 'A' : 'a') + digit - 10;
+		val /= radix;
+	} while (val > 0);
+
+	for (len = strlen(p); len < pad; len++)
+		*(--p) = '0';
+
+	if (negative)
+		*(--p) = '-';
+
+	fputs(p, out);
+}
+
+/*
+ * Expand one record. The format string is parsed the same way
+ * arch_vsnprintf() does on the device.
+ */
+static void expand_record(FILE *out, const char *fmt, const uint8_t *payload,
+			  unsigned int payload_len)
+{
+	const uint8_t *end = payload + payload_len;
+	char ch;
+
+	while ((ch = *(fmt++)) != '\0') {
+		int pad = 0;
+
+		if (ch != '%') {
+			fputc(ch, out);
+			continue;
+		}
+
+		ch = *(fmt++);
+		if (ch == '0') {
+			ch = *(fmt++);
+			if (ch == '\0')
+				return;
+			if (ch >= '0' && ch <= '9')
+				pad = ch - '0';
+			ch = *(fmt++);
+		}
+
+		if (ch == 'l' || ch == 'h')
+			ch = *(fmt++);
+
+		switch (ch) {
+		case '\0':
+			return;
+
+		case 'i':
+		case 'd':
+		case 'u':
+		case 'x':
+		case 'X':
+		case 'c': {
+			uint32_t val;
+
+			/* the device ran out of record space */
+			if (end - payload < 4)
+				return;
+			val = get_le32(payload);
+			payload += 4;
+
+			if (ch == 'c')
+				fputc((char) val, out);
+			else if (ch == 'x' || ch == 'X')
+				print_int(out, val, 16, ch == 'X', pad, 0);
+			else
+				print_int(out, val, 10, 0, pad, ch != 'u');
+			break;
+		}
+
+		case 's': {
+			unsigned int len;
+
+			if (end - payload < 1)
+				return;
+			len = *(payload++);
+			if (len > end - payload)
+				len = end - payload;
+			fwrite(payload, 1, len, out);
+			payload += len;
+			break;
+		}
+
+		default:
+			fprintf(out, "FATAL: unsupported printf character: %c.\n", ch);
+			break;
+		}
+	}
+}
+
+static void decode_stream(FILE *in, FILE *out)
+{
+	uint8_t rec[DEFERRED_HDR_LEN + MAX_RECORD_LEN];
+	int c;
+
+	while ((c = fgetc(in)) != EOF) {
+		const char *fmt;
+		size_t n;
+
+		if (c != DEFERRED_MARKER) {
+			fputc(c, out);
+			continue;
+		}
+
+		rec[0] = c;
+		n = 1 + fread(&rec[1], 1, DEFERRED_HDR_LEN - 1, in);
+		if (n == DEFERRED_HDR_LEN && (fmt = lookup_format(get_le32(&rec[1])))) {
+			size_t len = fread(&rec[DEFERRED_HDR_LEN], 1, rec[5], in);
+
+			if (len == rec[5]) {
+				expand_record(out, fmt, &rec[DEFERRED_HDR_LEN], rec[5]);
+				continue;
+			}
+			n += len;
+		}
+
+		/* not a record (or a truncated one) - copy it as is */
+		fwrite(rec, 1, n, out);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	FILE *in = stdin;
+	char *endp;
+	int arg = 2;
+
+	if (argc < 2 || argc > 4) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if (argc > 2) {
+		unsigned long val = strtoul(argv[2], &endp, 0);
+
+		if (*endp == '\0') {
+			load_addr = val;
+			arg++;
+		} else if (argc == 4) {
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (read_image(argv[1]))
+		return EXIT_FAILURE;
+
+	if (arg < argc) {
+		in = fopen(argv[arg], "rb");
+		if (!in) {
+			fprintf(stderr, "Could not open %s (%s)\n", argv[arg], strerror(errno));
+			return EXIT_FAILURE;
+		}
+	}
+
+	decode_stream(in, stdout);
+
+	if (in != stdin)
+		fclose(in);
+	free(image);
+
+	return EXIT_SUCCESS;
+}
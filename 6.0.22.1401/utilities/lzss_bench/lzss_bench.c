@@ -0,0 +1,251 @@
+/**
+ ****************************************************************************************
+ *
+ * @file lzss_bench.c
+ *
+ * @brief Benchmark of the compressed image transfers.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+#define _DEFAULT_SOURCE
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include "lzss.h"
+#include "lzss_enc.h"
+
+#define LZSS_BENCH_VERSION	"v_1.0"
+
+/* Input chunk of the decoder, as received from the link */
+#define CHUNK_SIZE		64
+
+/* Output buffer of the windowed decoder, a flash page */
+#define PAGE_SIZE		256
+
+/* Decoding passes, the best time is kept */
+#define PASSES			5
+
+static const struct {
+	unsigned int window_log2;
+	unsigned int lookahead_log2;
+} params[] = {
+	{ 8, 4 },
+	{ 10, 4 },
+	{ 11, 4 },
+	{ 12, 4 },
+	{ 12, 5 },
+};
+
+#define PARAMS	(sizeof(params) / sizeof(params[0]))
+
+extern uint32_t crc32(uint32_t crc, const void *buf, size_t size);
+
+static void usage(const char* my_name)
+{
+	fprintf(stderr,
+		"Version: " LZSS_BENCH_VERSION "\n"
+		"\n"
+		"Usage:\n"
+		"  %s [-b baud] bin_file...\n"
+		"\n"
+		"  Compress every 'bin_file' (e.g. binaries/*/prod_test/*.bin)\n"
+		"  with the mkimage compress encoder for several window and\n"
+		"  lookahead sizes, decode it back with the target decoder and\n"
+		"  report the compression ratio and the end-to-end time of a\n"
+		"  UART transfer at 'baud' (default 115200, 8N1): link time\n"
+		"  plus the decoding time measured on this host, which on the\n"
+		"  target overlaps with the reception.\n",
+		my_name);
+}
+
+static double now_s(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint8_t *read_file(const char *filename, size_t *size)
+{
+	FILE *f;
+	long len;
+	uint8_t *buf;
+
+	f = fopen(filename, "rb");
+	if (f == NULL) {
+		fprintf(stderr, "Could not open %s: %s\n", filename, strerror(errno));
+		return NULL;
+	}
+	if (fseek(f, 0, SEEK_END) < 0 || (len = ftell(f)) <= 0 || fseek(f, 0, SEEK_SET) < 0) {
+		fprintf(stderr, "Could not get the size of %s\n", filename);
+		fclose(f);
+		return NULL;
+	}
+	buf = malloc(len);
+	if (buf == NULL || fread(buf, 1, len, f) != (size_t)len) {
+		fprintf(stderr, "Could not read %s\n", filename);
+		free(buf);
+		fclose(f);
+		return NULL;
+	}
+	fclose(f);
+	*size = len;
+	return buf;
+}
+
+/*
+ * Decode in CHUNK_SIZE input pieces, either into PAGE_SIZE output pieces through a
+ * window (flash programmer) or straight into the output (UART booter, no window).
+ * Returns the decoding time or a negative value on error.
+ */
+static double decode(const uint8_t *lz, size_t lz_len, uint8_t *out, size_t size,
+		     unsigned int window_log2, int flat)
+{
+	static uint8_t window[1 << LZSS_WINDOW_LOG2_MAX];
+	uint32_t in_used, out_used;
+	size_t in_pos = 0, out_pos = 0, chunk;
+	lzss_dec_t dec;
+	double start;
+	int ret = LZSS_OK;
+
+	start = now_s();
+	lzss_init(&dec, flat ? NULL : window, flat ? 0 : 1 << window_log2);
+	while (ret == LZSS_OK && in_pos < lz_len) {
+		chunk = lz_len - in_pos;
+		if (chunk > CHUNK_SIZE)
+			chunk = CHUNK_SIZE;
+		do {
+			size_t room = size - out_pos;
+
+			if (!flat && room > PAGE_SIZE)
+				room = PAGE_SIZE;
+			ret = lzss_decode(&dec, lz + in_pos, chunk, &in_used, out + out_pos, room,
+					  &out_used);
+			in_pos += in_used;
+			chunk -= in_used;
+			out_pos += out_used;
+		} while (ret == LZSS_OK && out_used != 0);
+	}
+	if (ret != LZSS_DONE || out_pos != size)
+		return -1;
+	return now_s() - start;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int baud = 115200, i, p;
+	size_t total_raw = 0, total_lz[PARAMS] = { 0 };
+	double total_time[PARAMS] = { 0 }, total_raw_time = 0;
+	int opt, ret = EXIT_SUCCESS;
+
+	while ((opt = getopt(argc, argv, "b:")) != -1) {
+		switch (opt) {
+		case 'b':
+			baud = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	if (optind == argc || baud == 0) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	printf("%-40s %7s %5s %5s %7s %7s %8s %8s %8s\n", "file", "size", "win", "look",
+	       "lz", "ratio", "raw s", "lz s", "dec us");
+
+	for (i = optind; i < (unsigned int)argc; i++) {
+		const char *name = strrchr(argv[i], '/') ? strrchr(argv[i], '/') + 1 : argv[i];
+		uint8_t *image, *lz, *out;
+		size_t size, lz_len;
+		double raw_time;
+
+		image = read_file(argv[i], &size);
+		if (image == NULL)
+			return EXIT_FAILURE;
+		out = malloc(size);
+		if (out == NULL)
+			return EXIT_FAILURE;
+
+		raw_time = size * 10.0 / baud;
+		total_raw += size;
+		total_raw_time += raw_time;
+
+		for (p = 0; p < PARAMS; p++) {
+			double dec_time = 1e9, t;
+			int pass, flat;
+
+			if (lzss_compress(image, size, params[p].window_log2, params[p].lookahead_log2,
+					  &lz, &lz_len)) {
+				fprintf(stderr, "%s: compression failed\n", argv[i]);
+				return EXIT_FAILURE;
+			}
+			for (pass = 0; pass < 2 * PASSES; pass++) {
+				flat = pass & 1;
+				memset(out, 0, size);
+				t = decode(lz, lz_len, out, size, params[p].window_log2, flat);
+				if (t < 0 || memcmp(out, image, size)) {
+					fprintf(stderr, "%s: %s decoding failed\n", argv[i],
+						flat ? "flat" : "windowed");
+					ret = EXIT_FAILURE;
+					break;
+				}
+				if (t < dec_time)
+					dec_time = t;
+			}
+
+			/* the decoder keeps up with the link, the slower of both sets the pace */
+			t = lz_len * 10.0 / baud;
+			if (dec_time > t)
+				t = dec_time;
+			total_lz[p] += lz_len;
+			total_time[p] += t;
+
+			printf("%-40s %7zu %5u %5u %7zu %6.1f%% %8.3f %8.3f %8.0f\n", name, size,
+			       1U << params[p].window_log2, 1U << params[p].lookahead_log2, lz_len,
+			       100.0 * lz_len / size, raw_time, t, dec_time * 1e6);
+			free(lz);
+		}
+		free(out);
+		free(image);
+	}
+
+	printf("\nTotal %zu bytes, %.3f s uncompressed at %u baud\n", total_raw, total_raw_time, baud);
+	for (p = 0; p < PARAMS; p++)
+		printf("  window %4u lookahead %2u: %7zu bytes (%.1f%%), %.3f s (%.1f%% of the time)\n",
+		       1U << params[p].window_log2, 1U << params[p].lookahead_log2, total_lz[p],
+		       100.0 * total_lz[p] / total_raw, total_time[p],
+		       100.0 * total_time[p] / total_raw_time);
+
+	return ret;
+}
@@ -0,0 +1,205 @@
+/**
+ ****************************************************************************************
+ *
+ * @file lzss_enc.c
+ *
+ * @brief LZSS encoder of compressed images (format of sdk/platform/utilities/lzss).
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "lzss.h"
+#include "lzss_enc.h"
+
+extern uint32_t crc32(uint32_t crc, const void *buf, size_t size);
+
+#define HASH_SIZE	(1 << 16)
+#define NO_POS		((size_t)-1)
+
+struct bit_writer {
+	uint8_t *buf;
+	size_t pos;
+	uint32_t bits;
+	unsigned count;
+};
+
+/* MSB first, as the decoder reads */
+static void put_bits(struct bit_writer *bw, uint32_t value, unsigned n)
+{
+	while (n--) {
+		bw->bits = (bw->bits << 1) | ((value >> n) & 1);
+		if (++bw->count == 8) {
+			bw->buf[bw->pos++] = bw->bits;
+			bw->bits = 0;
+			bw->count = 0;
+		}
+	}
+}
+
+static void flush_bits(struct bit_writer *bw)
+{
+	if (bw->count)
+		bw->buf[bw->pos++] = bw->bits << (8 - bw->count);
+	bw->bits = 0;
+	bw->count = 0;
+}
+
+static void put_le32(uint8_t *p, uint32_t v)
+{
+	p[0] = v;
+	p[1] = v >> 8;
+	p[2] = v >> 16;
+	p[3] = v >> 24;
+}
+
+static unsigned hash2(const uint8_t *p)
+{
+	return (p[0] << 8) | p[1];
+}
+
+/* Longest match for position 'pos' through the hash chains */
+static unsigned find_match(const uint8_t *in, size_t in_len, size_t pos, const size_t *head,
+			   const size_t *prev, size_t window, unsigned max_len, size_t *distance)
+{
+	unsigned best = 0, len;
+	size_t cand;
+
+	if (pos + 2 > in_len)
+		return 0;
+	if (max_len > in_len - pos)
+		max_len = in_len - pos;
+
+	for (cand = head[hash2(in + pos)]; cand != NO_POS && pos - cand <= window;
+	     cand = prev[cand]) {
+		for (len = 0; len < max_len && in[cand + len] == in[pos + len]; len++)
+			;
+		if (len > best) {
+			best = len;
+			*distance = pos - cand;
+			if (len == max_len)
+				break;
+		}
+	}
+	return best;
+}
+
+static void insert_pos(const uint8_t *in, size_t in_len, size_t pos, size_t *head, size_t *prev)
+{
+	unsigned h;
+
+	if (pos + 2 > in_len)
+		return;
+	h = hash2(in + pos);
+	prev[pos] = head[h];
+	head[h] = pos;
+}
+
+int lzss_compress(const uint8_t *in, size_t in_len, unsigned window_log2,
+		  unsigned lookahead_log2, uint8_t **out, size_t *out_len)
+{
+	struct bit_writer bw = { 0 };
+	unsigned min_match, max_len, len, next_len;
+	size_t window, distance, next_distance, pos, i;
+	size_t *head, *prev;
+
+	if (window_log2 < LZSS_WINDOW_LOG2_MIN || window_log2 > LZSS_WINDOW_LOG2_MAX ||
+	    lookahead_log2 < LZSS_LOOKAHEAD_LOG2_MIN || lookahead_log2 >= window_log2 ||
+	    in_len > UINT32_MAX)
+		return -1;
+
+	min_match = LZSS_MIN_MATCH(window_log2, lookahead_log2);
+	max_len = (1U << lookahead_log2) - 1 + min_match;
+	window = (size_t)1 << window_log2;
+
+	/* worst case: every byte a 9-bit literal */
+	bw.buf = malloc(LZSS_HEADER_SIZE + in_len + in_len / 8 + 1);
+	head = malloc(HASH_SIZE * sizeof(*head));
+	prev = malloc((in_len + 1) * sizeof(*prev));
+	if (bw.buf == NULL || head == NULL || prev == NULL) {
+		free(bw.buf);
+		free(head);
+		free(prev);
+		return -1;
+	}
+	for (i = 0; i < HASH_SIZE; i++)
+		head[i] = NO_POS;
+
+	bw.buf[0] = LZSS_MAGIC0;
+	bw.buf[1] = LZSS_MAGIC1;
+	bw.buf[2] = window_log2;
+	bw.buf[3] = lookahead_log2;
+	put_le32(&bw.buf[4], in_len);
+	put_le32(&bw.buf[8], crc32(0, in, in_len));
+	bw.pos = LZSS_HEADER_SIZE;
+
+	pos = 0;
+	while (pos < in_len) {
+		len = find_match(in, in_len, pos, head, prev, window, max_len, &distance);
+		if (len >= min_match && len < max_len) {
+			/* lazy matching: prefer a literal if the next match is longer */
+			insert_pos(in, in_len, pos, head, prev);
+			next_len = find_match(in, in_len, pos + 1, head, prev, window, max_len,
+					      &next_distance);
+			if (next_len > len) {
+				put_bits(&bw, 1, 1);
+				put_bits(&bw, in[pos], 8);
+				pos++;
+				len = next_len;
+				distance = next_distance;
+			} else {
+				/* pos is already in the chains */
+				put_bits(&bw, 0, 1);
+				put_bits(&bw, distance - 1, window_log2);
+				put_bits(&bw, len - min_match, lookahead_log2);
+				for (i = 1; i < len; i++)
+					insert_pos(in, in_len, pos + i, head, prev);
+				pos += len;
+				continue;
+			}
+		}
+		if (len >= min_match) {
+			put_bits(&bw, 0, 1);
+			put_bits(&bw, distance - 1, window_log2);
+			put_bits(&bw, len - min_match, lookahead_log2);
+			for (i = 0; i < len; i++)
+				insert_pos(in, in_len, pos + i, head, prev);
+			pos += len;
+		} else {
+			put_bits(&bw, 1, 1);
+			put_bits(&bw, in[pos], 8);
+			insert_pos(in, in_len, pos, head, prev);
+			pos++;
+		}
+	}
+	flush_bits(&bw);
+
+	free(head);
+	free(prev);
+	*out = bw.buf;
+	*out_len = bw.pos;
+	return 0;
+}
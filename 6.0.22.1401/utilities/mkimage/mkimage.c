@@ -31,6 +31,7 @@
  ****************************************************************************************
  */
 #define _XOPEN_SOURCE 700
+#include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -42,6 +43,8 @@
 #include <io.h>
 #else
 #include <unistd.h>
+#include <sys/mman.h>
+#include <pthread.h>
 #endif
 #ifdef __linux__
 #include <endian.h>
@@ -52,29 +55,34 @@
 #include <assert.h>
 #include "image.h"
 #include "sw_aes.h"
+#include "lzss.h"
+#include "lzss_enc.h"
 
 #ifdef _MSC_VER
 #  define RW_RET_TYPE	int
 #  define snprintf	_snprintf
 #  define S_IRUSR	S_IREAD
 #  define S_IWUSR	S_IWRITE
+#  define strtok_r	strtok_s
 #else
 #  define RW_RET_TYPE	ssize_t
+/* memory mapped input files and the batch worker pool need POSIX */
+#  define MKIMAGE_USE_MMAP
+#  define MKIMAGE_BATCH
 #endif
 
-static AES_CTX aes_ctx;
 /* pre-determined cryptography key and IV */
-static uint8_t def_key[16] = {
+static const uint8_t def_key[16] = {
 	0x06, 0xa9, 0x21, 0x40, 0x36, 0xb8, 0xa1, 0x5b,
 	0x51, 0x2e, 0x03, 0xd5, 0x34, 0x12, 0x00, 0x06
 };
-static uint8_t def_iv[16] = {
+static const uint8_t def_iv[16] = {
 	0x3d, 0xaf, 0xba, 0x42, 0x9d, 0x9e, 0xb4, 0x30,
 	0xb4, 0x22, 0xda, 0x80, 0x2c, 0x9f, 0xac, 0x41
 };
 
 
-#define MKIMAGE_VERSION "1.11"
+#define MKIMAGE_VERSION "1.12"
 
 /* uncomment to store multi-byte values in little-endian order */
 #define MKIMAGE_LITTLE_ENDIAN
@@ -126,9 +134,43 @@ static void usage(const char* my_name)
 		" Product header field configuration:\n"
 		"   * 'Configuration Offset' is initialized from 'off4'. If 'off4' is not provided then it is set to 0xFFFFFFFF.\n"
 		"   * 'BD Address'           is initialized from 'bdaddr'. If 'bdaddr' is not provided then it is set to FF:FF:FF:FF:FF:FF.\n"
-		"\n",
-
-		my_name, my_name);
+		"\n"
+		"\n"
+		"Usage case #3:\n"
+		"  %s compress in_file out_file [window_log2 [lookahead_log2]]\n"
+		"\n"
+		"  Compress 'in_file' (e.g. .bin or .img file) into 'out_file' for\n"
+		"  the compressed transfers of the flash programmer and of the\n"
+		"  secondary bootloader UART booter. The output carries the size\n"
+		"  and the CRC32 of 'in_file'. The target decoder needs a window of\n"
+		"  2^window_log2 bytes, %d to %d (default %d). Back-references\n"
+		"  are up to about 2^lookahead_log2 bytes long (default %d).\n"
+		"\n"
+#ifdef MKIMAGE_BATCH
+		"\n"
+		"Usage case #4:\n"
+		"  %s batch manifest_file [jobs]\n"
+		"\n"
+		"  Create many images in one run. Every non-empty line of\n"
+		"  'manifest_file' not starting with '#' holds the arguments of\n"
+		"  a single, multi or compress command (everything after the\n"
+		"  program name), separated by blanks, e.g.\n"
+		"\tsingle app.bin sdk_version.h app.img enc\n"
+		"\tmulti spi app.img 0x20 app.img 0x8000 0x38000 cfg 0,80:EA:CA:01:02:03 unit1.bin\n"
+		"\tcompress app.bin app.lz\n"
+		"  The lines are processed concurrently by 'jobs' worker threads\n"
+		"  (default: number of online CPUs). Input files are only read,\n"
+		"  so lines may share them in any role.\n"
+		"  A throughput summary is printed when all lines are done.\n"
+		"\n"
+#endif
+		,
+		my_name, my_name, my_name, LZSS_WINDOW_LOG2_MIN, LZSS_WINDOW_LOG2_MAX,
+		LZSS_ENC_WINDOW_LOG2, LZSS_ENC_LOOKAHEAD_LOG2
+#ifdef MKIMAGE_BATCH
+		, my_name
+#endif
+		);
 }
 
 #ifdef _MSC_VER
@@ -206,17 +248,23 @@ static int safe_read(int fd, void* buf, size_t len)
 }
 
 
-static int set_active_image(int img,unsigned char active){
-	struct image_header hdr;
-	if (safe_read(img,&hdr,sizeof(struct image_header))<0)
+/*
+ * Set the image_id of the image that was appended to outf at img_off. Only
+ * the output is patched, the input image is opened read-only, so that batch
+ * jobs can share an input file.
+ */
+static int set_active_image(int outf, off_t img_off, unsigned char active)
+{
+	off_t end;
+
+	end = lseek(outf, 0, SEEK_CUR);
+	if (-1 == end)
 		return -1;
-	hdr.image_id = active;
-	
-	if (lseek(img, 0, SEEK_SET)<0)
+	if (lseek(outf, img_off + offsetof(struct image_header, image_id), SEEK_SET) == -1)
 		return -1;
-	if (safe_write(img,&hdr,sizeof(struct image_header))<0)
+	if (safe_write(outf, &active, sizeof active))
 		return -1;
-	if (lseek(img, 0, SEEK_SET)<0)
+	if (lseek(outf, end, SEEK_SET) == -1)
 		return -1;
 	return 0;
 }
@@ -363,65 +411,195 @@ static int parse_version_file(FILE* f, struct image_header* hdr)
 }
 
 /*
- * Encryption is done in blocks of AES_BLOCKSIZE bytes.
- * To keep things simple we also maintain AES_BLOCKSIZE buffers.
+ * CRC32 (same polynomial as third_party/crc32) processed eight bytes at a
+ * time. Table 0 is the classic byte-wise table, table k gives the CRC of a
+ * byte followed by k zero bytes, so eight lookups fold a 64-bit word.
  */
-static uint8_t copy_buf_clr[AES_BLOCKSIZE];
-static uint8_t copy_buf_enc[AES_BLOCKSIZE];
-static int append_file_crc32(int outf, int inf, uint32_t *crc, int encrypt)
+static uint32_t crc32_slice_tab[8][256];
+
+static void crc32_slice_init(void)
 {
-	RW_RET_TYPE n;
-	const uint8_t* buf;
+	uint32_t c;
+	int i, k;
+
+	for (i = 0; i < 256; i++) {
+		c = i;
+		for (k = 0; k < 8; k++)
+			c = (c & 1) ? (c >> 1) ^ 0xedb88320U : (c >> 1);
+		crc32_slice_tab[0][i] = c;
+	}
+	for (i = 0; i < 256; i++) {
+		c = crc32_slice_tab[0][i];
+		for (k = 1; k < 8; k++) {
+			c = crc32_slice_tab[0][c & 0xff] ^ (c >> 8);
+			crc32_slice_tab[k][i] = c;
+		}
+	}
+}
 
-	do {
-		size_t count;
-		size_t size;
+/* drop-in replacement of crc32(); crc32_slice_init() must have been called */
+static uint32_t crc32_fast(uint32_t crc, const void* buf, size_t size)
+{
+	const uint8_t* p = buf;
+	size_t head;
+
+	/* byte-wise up to the first 8-byte boundary */
+	head = (8 - ((uintptr_t)p & 7)) & 7;
+	if (head > size)
+		head = size;
+	crc = crc32(crc, p, head);
+	p += head;
+	size -= head;
+
+	crc = ~crc;
+	while (size >= 8) {
+		uint32_t lo = crc ^ ((uint32_t)p[0] | (uint32_t)p[1] << 8 |
+				(uint32_t)p[2] << 16 | (uint32_t)p[3] << 24);
+		uint32_t hi = (uint32_t)p[4] | (uint32_t)p[5] << 8 |
+				(uint32_t)p[6] << 16 | (uint32_t)p[7] << 24;
+
+		crc = crc32_slice_tab[7][lo & 0xff] ^
+			crc32_slice_tab[6][(lo >> 8) & 0xff] ^
+			crc32_slice_tab[5][(lo >> 16) & 0xff] ^
+			crc32_slice_tab[4][lo >> 24] ^
+			crc32_slice_tab[3][hi & 0xff] ^
+			crc32_slice_tab[2][(hi >> 8) & 0xff] ^
+			crc32_slice_tab[1][(hi >> 16) & 0xff] ^
+			crc32_slice_tab[0][hi >> 24];
+		p += 8;
+		size -= 8;
+	}
+	crc = ~crc;
 
-		memset(copy_buf_clr, 0, sizeof copy_buf_clr);
-		memset(copy_buf_enc, 0, sizeof copy_buf_enc);
-		count = sizeof(copy_buf_clr);
-		n = safe_read(inf, copy_buf_clr, count);
-		if (n < 0) {
-			perror("reading input image");
-			return -1;
-		}
-		/* convert from bytes missing to bytes read */
-		n = count - n;
-		if (n == 0)
-			break;  /* EOF */
-
-		if (encrypt) {
-			AES_cbc_encrypt(&aes_ctx, copy_buf_clr,
-					copy_buf_enc, count);
-			buf = copy_buf_enc;
-			size = count;
-		} else {
-			buf = copy_buf_clr;
-			size = n;
-		}
-		if (safe_write(outf, buf, size)) {
-			perror("writing image");
-			return -1;
-		}
+	return crc32(crc, p, size);
+}
 
-		if (size <= sizeof (copy_buf_clr))
-		{
-		        *crc = crc32(*crc, copy_buf_clr, size);
-		}
-		else
-		{
-		        assert(0);
-		}
+/*
+ * The whole input file is made available in memory, either mapped (POSIX)
+ * or read into a heap buffer, and then processed in COPY_CHUNK_SIZE pieces.
+ */
+#define COPY_CHUNK_SIZE		(64 * 1024)
 
-	} while (n != 0);
+struct in_file_map {
+	const uint8_t* data;
+	size_t size;
+	int mapped;
+};
+
+static int map_input_file(int inf, struct in_file_map* map)
+{
+	struct stat sbuf;
+	uint8_t* buf;
+	int n;
+
+	memset(map, 0, sizeof *map);
+	if (fstat(inf, &sbuf))
+		return -1;
+	map->size = sbuf.st_size;
+	if (map->size == 0)
+		return 0;
+
+#ifdef MKIMAGE_USE_MMAP
+	buf = mmap(NULL, map->size, PROT_READ, MAP_PRIVATE, inf, 0);
+	if (buf != MAP_FAILED) {
+		map->data = buf;
+		map->mapped = 1;
+		return 0;
+	}
+	/* e.g. a pipe; fall back to reading the file */
+#endif
+	buf = malloc(map->size);
+	if (buf == NULL)
+		return -1;
+	n = safe_read(inf, buf, map->size);
+	if (n != 0) {
+		free(buf);
+		if (n > 0)
+			errno = EIO;  /* file shrunk while reading it */
+		return -1;
+	}
+	map->data = buf;
 
 	return 0;
 }
 
+static void unmap_input_file(struct in_file_map* map)
+{
+	if (map->data == NULL)
+		return;
+#ifdef MKIMAGE_USE_MMAP
+	if (map->mapped) {
+		munmap((void*)map->data, map->size);
+		return;
+	}
+#endif
+	free((void*)map->data);
+}
+
+/*
+ * Copy inf to outf, encrypting it when aes is not NULL. Encrypted images are
+ * padded with zeros to a multiple of AES_BLOCKSIZE. The CRC is always
+ * calculated over the clear (padded) data.
+ */
+static int append_file_crc32(int outf, int inf, uint32_t *crc, AES_CTX* aes)
+{
+	struct in_file_map map;
+	uint8_t enc_buf[COPY_CHUNK_SIZE];
+	size_t done, chunk, body;
+	int res = -1;
+
+	if (map_input_file(inf, &map)) {
+		perror("reading input image");
+		return -1;
+	}
+
+	body = map.size;
+	if (aes)
+		body -= map.size % AES_BLOCKSIZE;
+
+	for (done = 0; done < body; done += chunk) {
+		chunk = body - done;
+		if (chunk > COPY_CHUNK_SIZE)
+			chunk = COPY_CHUNK_SIZE;
+
+		*crc = crc32_fast(*crc, map.data + done, chunk);
+		if (aes) {
+			AES_cbc_encrypt(aes, map.data + done, enc_buf, chunk);
+			if (safe_write(outf, enc_buf, chunk))
+				goto write_error;
+		} else if (safe_write(outf, map.data + done, chunk)) {
+			goto write_error;
+		}
+	}
+
+	if (body < map.size) {
+		/* last partial AES block */
+		uint8_t clr[AES_BLOCKSIZE];
+
+		memset(clr, 0, sizeof clr);
+		memcpy(clr, map.data + body, map.size - body);
+		*crc = crc32_fast(*crc, clr, sizeof clr);
+		AES_cbc_encrypt(aes, clr, enc_buf, sizeof clr);
+		if (safe_write(outf, enc_buf, sizeof clr))
+			goto write_error;
+	}
+
+	res = 0;
+	goto cleanup;
+
+write_error:
+	perror("writing image");
+cleanup:
+	unmap_input_file(&map);
+
+	return res;
+}
+
 static int append_file_csum(int outf, int inf, uint8_t* _csum)
 {
 	RW_RET_TYPE n;
 	uint8_t csum = 0;
+	uint8_t copy_buf_clr[COPY_CHUNK_SIZE];
 
 	do {
 		size_t count;
@@ -484,6 +662,7 @@ static int create_single_image(int argc, const char* argv[])
 	struct stat sbuf;
 	struct image_header hdr;
 	int encrypt = 0;
+	AES_CTX aes_ctx;
 	off_t size;
 
 	if (argc != 5  &&  argc != 6  && argc != 8 ) {
@@ -589,7 +768,7 @@ static int create_single_image(int argc, const char* argv[])
 		goto cleanup_and_exit;
 	}
 
-	if( append_file_crc32(outf, inf, &crc32, encrypt) )
+	if( append_file_crc32(outf, inf, &crc32, encrypt ? &aes_ctx : NULL) )
 		goto cleanup_and_exit;
 	store_crc(&hdr, crc32);
 
@@ -625,6 +804,96 @@ cleanup_and_exit:
 }
 
 
+static int compress_image(int argc, const char* argv[])
+{
+	int inf = -1, outf = -1;
+	int oflags, res = EXIT_FAILURE;
+	unsigned window_log2 = LZSS_ENC_WINDOW_LOG2;
+	unsigned lookahead_log2 = LZSS_ENC_LOOKAHEAD_LOG2;
+	uint8_t *in = NULL, *out = NULL, *check = NULL;
+	size_t out_len;
+	uint32_t in_used, out_used;
+	struct stat sbuf;
+	lzss_dec_t dec;
+
+	if (argc < 4  ||  argc > 6) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+	if (argc > 4)
+		window_log2 = strtoul(argv[4], NULL, 0);
+	if (argc > 5)
+		lookahead_log2 = strtoul(argv[5], NULL, 0);
+
+	oflags = O_RDONLY;
+#ifdef O_BINARY
+	oflags |= O_BINARY;
+#endif
+	inf = open(argv[2], oflags);
+	if (-1 == inf) {
+		perror(argv[2]);
+		return EXIT_FAILURE;
+	}
+	if (fstat(inf, &sbuf)) {
+		perror(argv[2]);
+		goto cleanup_and_exit;
+	}
+	in = malloc(sbuf.st_size + 1);
+	check = malloc(sbuf.st_size + 1);
+	if (in == NULL  ||  check == NULL  ||  safe_read(inf, in, sbuf.st_size)) {
+		fprintf(stderr, "Could not read %s\n", argv[2]);
+		goto cleanup_and_exit;
+	}
+
+	if (lzss_compress(in, sbuf.st_size, window_log2, lookahead_log2, &out, &out_len)) {
+		fprintf(stderr, "Invalid compression parameters %u %u\n",
+				window_log2, lookahead_log2);
+		goto cleanup_and_exit;
+	}
+
+	/* decode it back with the decoder of the targets */
+	lzss_init(&dec, NULL, 0);
+	if (lzss_decode(&dec, out, out_len, &in_used, check, sbuf.st_size, &out_used) != LZSS_DONE
+			||  out_used != (uint32_t)sbuf.st_size
+			||  memcmp(in, check, sbuf.st_size)) {
+		fprintf(stderr, "Compressed image of %s does not decode back\n", argv[2]);
+		goto cleanup_and_exit;
+	}
+
+	oflags = O_WRONLY | O_CREAT | O_TRUNC;
+#ifdef O_BINARY
+	oflags |= O_BINARY;
+#endif
+	outf = open(argv[3], oflags, S_IRUSR | S_IWUSR);
+	if (-1 == outf  ||  safe_write(outf, out, out_len)) {
+		perror(argv[3]);
+		goto cleanup_and_exit;
+	}
+
+	printf("%s: %lld -> %zu bytes (%.1f%%), window %u, lookahead %u\n", argv[2],
+			(long long)sbuf.st_size, out_len,
+			sbuf.st_size ? 100.0 * out_len / sbuf.st_size : 0.0,
+			1U << window_log2, 1U << lookahead_log2);
+
+	res = EXIT_SUCCESS;
+
+cleanup_and_exit:
+	if (outf != -1) {
+		if (close(outf))
+			perror(argv[3]);
+	}
+	if (inf != -1) {
+		if (close(inf))
+			perror(argv[2]);
+	}
+	free(in);
+	free(out);
+	free(check);
+
+	return res;
+}
+
+
 static int parse_offset(const char* s, unsigned* offset)
 {
 	long val;
@@ -703,6 +972,7 @@ static int parse_prod_header_cfg(const char* s, unsigned* cfg_offset, unsigned c
     const char DELIMETER[] = ",";
     char *buffer = (char *) malloc(strlen(s) + 1);
     char *token = NULL;
+    char *save_ptr = NULL;
     int rc = EXIT_SUCCESS; // return code
 
     // copy parameter string s to a dynamically allocated buffer
@@ -712,7 +982,7 @@ static int parse_prod_header_cfg(const char* s, unsigned* cfg_offset, unsigned c
     //
     // 1st Configuration Value: application specific configuration offset
     //
-    token = strtok(buffer, DELIMETER); // get 1st token
+    token = strtok_r(buffer, DELIMETER, &save_ptr); // get 1st token
 
     if (!token) {
         rc = EXIT_FAILURE; // failure if not found
@@ -729,7 +999,7 @@ static int parse_prod_header_cfg(const char* s, unsigned* cfg_offset, unsigned c
     //
     // 2nd Configuration Value: BD address (optional)
     //
-    token = strtok(NULL, DELIMETER); // get next token
+    token = strtok_r(NULL, DELIMETER, &save_ptr); // get next token
 
     if (!token) {
         rc = EXIT_SUCCESS; // it is optional
@@ -746,7 +1016,7 @@ static int parse_prod_header_cfg(const char* s, unsigned* cfg_offset, unsigned c
     //
     // No more values are expected
     //
-    token = strtok(NULL, DELIMETER); // get next token
+    token = strtok_r(NULL, DELIMETER, &save_ptr); // get next token
 
     // if another value exists then it is an error.
     if (token) {
@@ -764,19 +1034,14 @@ cleanup_and_return:
 
 static int add_padding(int outf, const unsigned count, const uint8_t pad)
 {
-	unsigned i;
-    #ifdef _MSC_VER
-	size_t n;
-	#else
-	ssize_t n;
-    #endif
-
-	for (i = 0; i < count; i++) {
-		do {
-			n = write(outf, &pad, 1);
-			if (n < 0  &&  errno != EINTR)
-				return -1;
-		} while (n < 1);
+	uint8_t pad_buf[COPY_CHUNK_SIZE];
+	unsigned left, chunk;
+
+	memset(pad_buf, pad, sizeof pad_buf);
+	for (left = count; left; left -= chunk) {
+		chunk = left < sizeof pad_buf ? left : sizeof pad_buf;
+		if (safe_write(outf, pad_buf, chunk))
+			return -1;
 	}
 
 	return 0;
@@ -870,7 +1135,7 @@ static int create_multi_image(int argc, const char* argv[])
 
 
 	/* open the input files */
-	oflags = O_RDWR;
+	oflags = O_RDONLY;
 #ifdef O_BINARY
 	oflags |= O_BINARY;
 #endif
@@ -974,14 +1239,12 @@ static int create_multi_image(int argc, const char* argv[])
 		printf("[%08x] Padding (%02X's)\n", (unsigned)offset, pad_byte);
 	}
 
-	if (set_active_image(img1,0x01)<0){
-			goto cleanup_and_exit;
-	}
-	
-	
-
 	if (append_file_csum(outf, img1, NULL))
 		goto cleanup_and_exit;
+	if (set_active_image(outf, off1, 0x01)) {
+		perror(argv[arg_base + 5]);
+		goto cleanup_and_exit;
+	}
 	printf("[%08x] '%s'\n", off1, argv[arg_base]);
 
 	/* then goes img2 at offset off2 */
@@ -1001,13 +1264,13 @@ static int create_multi_image(int argc, const char* argv[])
 		}
 		printf("[%08x] Padding (%02X's)\n", (unsigned)offset, pad_byte);
 	}
-	
-	if (set_active_image(img2,0x00)<0){
-			goto cleanup_and_exit;
-	}
-	
+
 	if (append_file_csum(outf, img2, NULL))
 		goto cleanup_and_exit;
+	if (set_active_image(outf, off2, 0x00)) {
+		perror(argv[arg_base + 5]);
+		goto cleanup_and_exit;
+	}
 	printf("[%08x] '%s'\n", off2, argv[arg_base + 2]);
 
 	/* finally, the product header goes at off3 */
@@ -1082,6 +1345,224 @@ cleanup_and_exit:
 }
 
 
+#ifdef MKIMAGE_BATCH
+/*
+ * Batch mode: each manifest line is one single/multi job. Jobs are handed
+ * out to a pool of worker threads; every job only uses its own file
+ * descriptors, AES context and buffers, so the image creation code runs
+ * unchanged in each worker.
+ *
+ * What the workers share is read-only while they run:
+ *  - the job table, parsed completely before the first worker starts;
+ *    each job owns its copy of the manifest line its arguments point to,
+ *    and the results are written to a separate array, one slot per job,
+ *  - the default key and IV and the CRC32 tables, set up in main(),
+ *  - input files named by several jobs, which every job opens read-only
+ *    and maps (PROT_READ, MAP_PRIVATE) or reads on its own. A multi image
+ *    job sets the image_id in its output, not in the input images.
+ */
+#define BATCH_MAX_ARGS		16
+
+struct batch_job {
+	char* line;
+	int argc;
+	const char* argv[BATCH_MAX_ARGS];
+};
+
+struct batch_ctx {
+	const struct batch_job* jobs;
+	int* res;
+	unsigned njobs;
+	unsigned next;
+	pthread_mutex_t lock;
+};
+
+static int batch_split_line(const char* my_name, struct batch_job* job)
+{
+	char* save_ptr = NULL;
+	char* token;
+
+	job->argc = 0;
+	job->argv[job->argc++] = my_name;
+	for (token = strtok_r(job->line, " \t\r\n", &save_ptr); token;
+			token = strtok_r(NULL, " \t\r\n", &save_ptr)) {
+		if (job->argc == BATCH_MAX_ARGS)
+			return -1;
+		job->argv[job->argc++] = token;
+	}
+
+	return 0;
+}
+
+static int batch_run_job(const struct batch_job* job)
+{
+	const char* argv[BATCH_MAX_ARGS];
+
+	/* the image functions take a plain argv; hand them a private copy */
+	memcpy(argv, job->argv, job->argc * sizeof argv[0]);
+	if (job->argc < 2)
+		return EXIT_FAILURE;
+	if (!strcmp(argv[1], "single"))
+		return create_single_image(job->argc, argv);
+	if (!strcmp(argv[1], "multi"))
+		return create_multi_image(job->argc, argv);
+	if (!strcmp(argv[1], "compress"))
+		return compress_image(job->argc, argv);
+
+	fprintf(stderr, "Unknown manifest command '%s'.\n", argv[1]);
+	return EXIT_FAILURE;
+}
+
+/* the output file is argument #4 of single and the last one of multi */
+static const char* batch_out_file(const struct batch_job* job)
+{
+	if (!strcmp(job->argv[1], "single"))
+		return job->argc > 4 ? job->argv[4] : NULL;
+	if (!strcmp(job->argv[1], "compress"))
+		return job->argc > 3 ? job->argv[3] : NULL;
+
+	return job->argv[job->argc - 1];
+}
+
+static void* batch_worker(void* arg)
+{
+	struct batch_ctx* ctx = arg;
+	unsigned idx;
+
+	for (;;) {
+		pthread_mutex_lock(&ctx->lock);
+		idx = ctx->next++;
+		pthread_mutex_unlock(&ctx->lock);
+		if (idx >= ctx->njobs)
+			break;
+		ctx->res[idx] = batch_run_job(&ctx->jobs[idx]);
+	}
+
+	return NULL;
+}
+
+static int create_batch_images(int argc, const char* argv[])
+{
+	struct batch_ctx ctx;
+	struct batch_job* jobs = NULL;
+	pthread_t* workers = NULL;
+	unsigned i, nworkers, failed = 0;
+	long online;
+	FILE* manf;
+	char* line = NULL;
+	size_t len = 0;
+	unsigned long long total_bytes = 0;
+	struct timespec t_start, t_end;
+	double secs;
+	int res = EXIT_FAILURE;
+
+	if (argc != 3  &&  argc != 4) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if (argc == 4) {
+		nworkers = strtoul(argv[3], NULL, 0);
+	} else {
+		online = sysconf(_SC_NPROCESSORS_ONLN);
+		nworkers = online > 0 ? (unsigned)online : 1;
+	}
+	if (nworkers == 0) {
+		fprintf(stderr, "Invalid number of jobs '%s'.\n", argv[3]);
+		return EXIT_FAILURE;
+	}
+
+	manf = fopen(argv[2], "r");
+	if (NULL == manf) {
+		perror(argv[2]);
+		return EXIT_FAILURE;
+	}
+
+	/* read the whole manifest first */
+	memset(&ctx, 0, sizeof ctx);
+	while (getline(&line, &len, manf) >= 0) {
+		char* p = line + strspn(line, " \t\r\n");
+
+		if (*p == '\0' || *p == '#')
+			continue;
+		jobs = realloc(jobs, (ctx.njobs + 1) * sizeof *jobs);
+		assert(jobs);
+		memset(&jobs[ctx.njobs], 0, sizeof *jobs);
+		jobs[ctx.njobs].line = strdup(p);
+		assert(jobs[ctx.njobs].line);
+		if (batch_split_line(argv[0], &jobs[ctx.njobs++])) {
+			fprintf(stderr, "Too many arguments in manifest line %u.\n",
+					ctx.njobs);
+			goto cleanup_and_exit;
+		}
+	}
+	if (ferror(manf)) {
+		perror(argv[2]);
+		goto cleanup_and_exit;
+	}
+
+	ctx.jobs = jobs;
+	ctx.res = calloc(ctx.njobs ? ctx.njobs : 1, sizeof *ctx.res);
+	assert(ctx.res);
+	if (nworkers > ctx.njobs)
+		nworkers = ctx.njobs;
+	workers = calloc(nworkers ? nworkers : 1, sizeof *workers);
+	assert(workers);
+	pthread_mutex_init(&ctx.lock, NULL);
+
+	clock_gettime(CLOCK_MONOTONIC, &t_start);
+	for (i = 0; i < nworkers; i++) {
+		if (pthread_create(&workers[i], NULL, batch_worker, &ctx)) {
+			perror("pthread_create");
+			/* the threads already started will do all the jobs */
+			nworkers = i;
+			break;
+		}
+	}
+	if (nworkers == 0)
+		batch_worker(&ctx);
+	for (i = 0; i < nworkers; i++)
+		pthread_join(workers[i], NULL);
+	clock_gettime(CLOCK_MONOTONIC, &t_end);
+	pthread_mutex_destroy(&ctx.lock);
+
+	for (i = 0; i < ctx.njobs; i++) {
+		struct stat sbuf;
+		const char* out = batch_out_file(&ctx.jobs[i]);
+
+		if (ctx.res[i] != EXIT_SUCCESS) {
+			fprintf(stderr, "Manifest line %u failed.\n", i + 1);
+			failed++;
+		} else if (out && !stat(out, &sbuf)) {
+			total_bytes += sbuf.st_size;
+		}
+	}
+
+	secs = (t_end.tv_sec - t_start.tv_sec) +
+		(t_end.tv_nsec - t_start.tv_nsec) / 1e9;
+	if (secs <= 0)
+		secs = 1e-9;
+	printf("%u images (%u failed), %llu bytes in %.3f s: "
+			"%.1f images/s, %.2f MB/s\n",
+			ctx.njobs, failed, total_bytes, secs,
+			(ctx.njobs - failed) / secs, total_bytes / secs / 1e6);
+
+	res = failed ? EXIT_FAILURE : EXIT_SUCCESS;
+
+cleanup_and_exit:
+	for (i = 0; i < ctx.njobs; i++)
+		free(jobs[i].line);
+	free(jobs);
+	free(ctx.res);
+	free(workers);
+	free(line);
+	fclose(manf);
+
+	return res;
+}
+#endif
+
+
 int main(int argc, const char* argv[])
 {
 	int res = EXIT_FAILURE;
@@ -1091,13 +1572,20 @@ int main(int argc, const char* argv[])
 		exit(EXIT_FAILURE);
 	}
 
+	crc32_slice_init();
+
 	if (!strcmp(argv[1], "single"))
 		res = create_single_image(argc, argv);
 	else if (!strcmp(argv[1], "multi"))
 		res = create_multi_image(argc, argv);
+	else if (!strcmp(argv[1], "compress"))
+		res = compress_image(argc, argv);
+#ifdef MKIMAGE_BATCH
+	else if (!strcmp(argv[1], "batch"))
+		res = create_batch_images(argc, argv);
+#endif
 	else
 		usage(argv[0]);
 
 	exit(res);
 }
-
@@ -0,0 +1,490 @@
+/**
+ ****************************************************************************************
+ *
+ * @file mkimage_bench.c
+ *
+ * @brief Benchmark of mkimage against a reference build.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#define MKIMAGE_BENCH_VERSION	"v_1.0"
+
+#define MAX_ARGS		16
+#define PATH_LEN		512
+
+/* Runs compared, in this order; the first one is the reference */
+enum run {
+	RUN_REF,
+	RUN_SEQ,
+	RUN_BATCH,
+	RUNS
+};
+
+static const char *run_name[RUNS] = {
+	"reference, one process per image",
+	"mkimage, one process per image",
+	"mkimage batch",
+};
+
+static const char *run_prefix[RUNS] = { "ref", "seq", "bat" };
+
+struct job {
+	int argc;
+	char *argv[MAX_ARGS];
+	int out_arg;
+	char *out[RUNS];
+};
+
+static char workdir[PATH_LEN];
+static uint32_t seed = 1;
+
+extern char **environ;
+
+static void usage(const char* my_name)
+{
+	fprintf(stderr,
+		"Version: " MKIMAGE_BENCH_VERSION "\n"
+		"\n"
+		"Usage:\n"
+		"  %s [-n images] [-s size_kb] [-j jobs] [-w dir] [-k] ref_mkimage mkimage\n"
+		"\n"
+		"  Build the same set of images with 'ref_mkimage' (e.g. mkimage\n"
+		"  built from the previous release, see 'make bench') and with\n"
+		"  'mkimage', once with one process per image and once in batch\n"
+		"  mode, check that the outputs are byte-identical and report\n"
+		"  images/s and MB/s of image output for each run.\n"
+		"\n"
+		"  The set holds 'images' single images of about 'size_kb' KB,\n"
+		"  every other one encrypted, and as many per-unit multi images\n"
+		"  for SPI flash with their own BD address. The multi images share\n"
+		"  two application images, each used as the first image by some\n"
+		"  jobs and as the second by others, and some jobs use one\n"
+		"  application image for both. They are checked to be unchanged\n"
+		"  after the runs of 'mkimage' (the reference may modify them).\n"
+		"\n"
+		"  -n images     single and multi images each (default 200)\n"
+		"  -s size_kb    average input size (default 32)\n"
+		"  -j jobs       batch worker threads (default: online CPUs)\n"
+		"  -w dir        work directory (default: a new one in /tmp)\n"
+		"  -k            keep the work directory\n",
+		my_name);
+}
+
+static uint32_t rnd(void)
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	return seed;
+}
+
+static double now_s(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static char *path(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+static char *path(const char *fmt, ...)
+{
+	char name[PATH_LEN], *p;
+	va_list ap;
+
+	va_start(ap, fmt);
+	vsnprintf(name, sizeof(name), fmt, ap);
+	va_end(ap);
+	if (asprintf(&p, "%s/%s", workdir, name) < 0) {
+		perror("asprintf");
+		exit(EXIT_FAILURE);
+	}
+	return p;
+}
+
+static int write_file(const char *filename, const void *buf, size_t size)
+{
+	FILE *f = fopen(filename, "wb");
+
+	if (f == NULL || fwrite(buf, 1, size, f) != size) {
+		fprintf(stderr, "Could not write %s: %s\n", filename, strerror(errno));
+		if (f)
+			fclose(f);
+		return -1;
+	}
+	return fclose(f);
+}
+
+static uint8_t *read_file(const char *filename, size_t *size)
+{
+	struct stat sbuf;
+	uint8_t *buf;
+	FILE *f;
+
+	f = fopen(filename, "rb");
+	if (f == NULL || fstat(fileno(f), &sbuf)) {
+		fprintf(stderr, "Could not open %s: %s\n", filename, strerror(errno));
+		if (f)
+			fclose(f);
+		return NULL;
+	}
+	*size = sbuf.st_size;
+	buf = malloc(*size ? *size : 1);
+	if (buf == NULL || fread(buf, 1, *size, f) != *size) {
+		fprintf(stderr, "Could not read %s\n", filename);
+		free(buf);
+		buf = NULL;
+	}
+	fclose(f);
+	return buf;
+}
+
+/*
+ * Firmware-like input: runs of code-like random bytes and of constant fill, so that
+ * neither the CRC nor the encryption sees a degenerate pattern.
+ */
+static int make_input(const char *filename, size_t size)
+{
+	uint8_t *buf = malloc(size);
+	size_t i = 0;
+	int ret;
+
+	if (buf == NULL)
+		return -1;
+	while (i < size) {
+		size_t run = 16 + rnd() % 512;
+		uint8_t fill = rnd() & 1 ? 0xff : 0x00;
+		int random = rnd() % 4 != 0;
+
+		for (; run && i < size; run--, i++)
+			buf[i] = random ? (uint8_t)rnd() : fill;
+	}
+	ret = write_file(filename, buf, size);
+	free(buf);
+	return ret;
+}
+
+/* Run prog with args, stdout to /dev/null. Returns the exit status or -1. */
+static int run(const char *prog, char *const args[])
+{
+	posix_spawn_file_actions_t fa;
+	int status, ret;
+	pid_t pid;
+
+	posix_spawn_file_actions_init(&fa);
+	posix_spawn_file_actions_addopen(&fa, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+	ret = posix_spawn(&pid, prog, &fa, NULL, args, environ);
+	posix_spawn_file_actions_destroy(&fa);
+	if (ret) {
+		fprintf(stderr, "Could not run %s: %s\n", prog, strerror(ret));
+		return -1;
+	}
+	if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status))
+		return -1;
+	return WEXITSTATUS(status);
+}
+
+/* Run every job with prog, writing the outputs of run r */
+static int run_each(const char *prog, struct job *jobs, unsigned int nb, enum run r)
+{
+	unsigned int i;
+
+	for (i = 0; i < nb; i++) {
+		char *args[MAX_ARGS + 1];
+
+		memcpy(args, jobs[i].argv, jobs[i].argc * sizeof(args[0]));
+		args[0] = (char *)prog;
+		args[jobs[i].out_arg] = jobs[i].out[r];
+		args[jobs[i].argc] = NULL;
+		if (run(prog, args)) {
+			fprintf(stderr, "%s failed on image %u\n", prog, i);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/* Run every job through one 'mkimage batch' invocation */
+static int run_batch(const char *prog, struct job *jobs, unsigned int nb, const char *nb_jobs)
+{
+	char *manifest = path("manifest.txt");
+	char *args[] = { (char *)prog, "batch", manifest, (char *)nb_jobs, NULL };
+	unsigned int i;
+	FILE *f;
+	int a, ret;
+
+	f = fopen(manifest, "w");
+	if (f == NULL) {
+		perror(manifest);
+		return -1;
+	}
+	fprintf(f, "# mkimage_bench\n");
+	for (i = 0; i < nb; i++) {
+		for (a = 1; a < jobs[i].argc; a++)
+			fprintf(f, "%s%c", a == jobs[i].out_arg ? jobs[i].out[RUN_BATCH] :
+				jobs[i].argv[a], a == jobs[i].argc - 1 ? '\n' : ' ');
+	}
+	fclose(f);
+	if (nb_jobs == NULL)
+		args[3] = NULL;
+	ret = run(prog, args);
+	free(manifest);
+	return ret;
+}
+
+static void add_arg(struct job *job, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+static void add_arg(struct job *job, const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	if (job->argc == MAX_ARGS || vasprintf(&job->argv[job->argc++], fmt, ap) < 0) {
+		fprintf(stderr, "Too many arguments\n");
+		exit(EXIT_FAILURE);
+	}
+	va_end(ap);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int nb = 200, size_kb = 32, i, nb_jobs;
+	const char *jobs_arg = NULL, *prog[RUNS];
+	char *version, *app[2];
+	uint8_t *app_data[2] = { NULL, NULL };
+	size_t app_size[2];
+	struct job *jobs;
+	size_t out_bytes = 0;
+	double t[RUNS];
+	int opt, keep = 0, ret = EXIT_FAILURE, r;
+
+	while ((opt = getopt(argc, argv, "n:s:j:w:k")) != -1) {
+		switch (opt) {
+		case 'n':
+			nb = strtoul(optarg, NULL, 0);
+			break;
+		case 's':
+			size_kb = strtoul(optarg, NULL, 0);
+			break;
+		case 'j':
+			jobs_arg = optarg;
+			break;
+		case 'w':
+			snprintf(workdir, sizeof(workdir), "%s", optarg);
+			break;
+		case 'k':
+			keep = 1;
+			break;
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	if (argc - optind != 2 || nb == 0 || size_kb == 0) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+	prog[RUN_REF] = argv[optind];
+	prog[RUN_SEQ] = prog[RUN_BATCH] = argv[optind + 1];
+
+	if (workdir[0] == '\0') {
+		snprintf(workdir, sizeof(workdir), "/tmp/mkimage_bench.XXXXXX");
+		if (mkdtemp(workdir) == NULL) {
+			perror("mkdtemp");
+			return EXIT_FAILURE;
+		}
+	} else if (mkdir(workdir, 0700) && errno != EEXIST) {
+		perror(workdir);
+		return EXIT_FAILURE;
+	}
+
+	/* the version file fixes the header timestamp, so the outputs are comparable */
+	version = path("sdk_version.h");
+	{
+		static const char ver[] = "#define SDK_VERSION \"v_6.0.22.1401\"\n"
+					  "#define SDK_VERSION_DATE \"2024-01-01 12:00 \"\n";
+
+		if (write_file(version, ver, sizeof(ver) - 1))
+			goto out;
+	}
+
+	/* the two application images of the multi images */
+	for (i = 0; i < 2; i++) {
+		char *bin = path("app%u.bin", i);
+		char *args[] = { (char *)prog[RUN_REF], "single", bin, version, NULL, NULL };
+
+		app[i] = args[4] = path("app%u.img", i);
+		if (make_input(bin, 24 * 1024 + 100 * i) || run(prog[RUN_REF], args)) {
+			fprintf(stderr, "Could not build %s\n", app[i]);
+			goto out;
+		}
+		free(bin);
+	}
+	for (i = 0; i < 2; i++) {
+		app_data[i] = read_file(app[i], &app_size[i]);
+		if (app_data[i] == NULL)
+			goto out;
+	}
+
+	jobs = calloc(2 * nb, sizeof(*jobs));
+	if (jobs == NULL)
+		goto out;
+	for (i = 0; i < 2 * nb; i++) {
+		struct job *job = &jobs[i];
+
+		add_arg(job, "mkimage");
+		if (i < nb) {
+			/* odd sizes, so that encrypted images are padded */
+			size_t size = size_kb * 1024 / 2 + rnd() % (size_kb * 1024) + (rnd() & 15);
+			char *bin = path("in%u.bin", i);
+
+			if (make_input(bin, size))
+				goto out;
+			add_arg(job, "single");
+			add_arg(job, "%s", bin);
+			add_arg(job, "%s", version);
+			job->out_arg = job->argc;
+			add_arg(job, "out");
+			if (i & 1)
+				add_arg(job, "enc");
+			free(bin);
+		} else {
+			/*
+			 * Concurrent jobs read the same input file, once as image 1 and
+			 * once as image 2, which catches an input modified by a job.
+			 */
+			unsigned int swap = i % 3;
+
+			add_arg(job, "multi");
+			add_arg(job, "spi");
+			add_arg(job, "%s", app[swap == 1]);
+			add_arg(job, "0x1000");
+			add_arg(job, "%s", app[swap == 0]);
+			add_arg(job, "0x11000");
+			add_arg(job, "0x1F000");
+			add_arg(job, "cfg");
+			add_arg(job, "0x20000,80:EA:CA:%02X:%02X:%02X", (i >> 16) & 0xff,
+				(i >> 8) & 0xff, i & 0xff);
+			job->out_arg = job->argc;
+			add_arg(job, "out");
+		}
+		for (r = 0; r < RUNS; r++)
+			job->out[r] = path("%s%u.img", run_prefix[r], i);
+	}
+
+	nb_jobs = jobs_arg ? strtoul(jobs_arg, NULL, 0) : (unsigned int)sysconf(_SC_NPROCESSORS_ONLN);
+	for (r = 0; r < RUNS; r++) {
+		double start;
+
+		/* the inputs are restored before each run, which must not change them */
+		for (i = 0; r != RUN_REF && i < 2; i++) {
+			if (write_file(app[i], app_data[i], app_size[i]))
+				goto out;
+		}
+		start = now_s();
+		if (r == RUN_BATCH ? run_batch(prog[r], jobs, 2 * nb, jobs_arg) :
+				     run_each(prog[r], jobs, 2 * nb, r)) {
+			fprintf(stderr, "%s failed\n", run_name[r]);
+			goto out;
+		}
+		t[r] = now_s() - start;
+		for (i = 0; r != RUN_REF && i < 2; i++) {
+			size_t size;
+			uint8_t *img = read_file(app[i], &size);
+
+			if (img == NULL || size != app_size[i] || memcmp(img, app_data[i], size)) {
+				fprintf(stderr, "%s: input %s was modified\n", run_name[r], app[i]);
+				free(img);
+				goto out;
+			}
+			free(img);
+		}
+	}
+
+	/* byte-identical check */
+	for (i = 0; i < 2 * nb; i++) {
+		size_t ref_size, size;
+		uint8_t *ref = read_file(jobs[i].out[RUN_REF], &ref_size), *img;
+
+		if (ref == NULL)
+			goto out;
+		out_bytes += ref_size;
+		for (r = RUN_SEQ; r < RUNS; r++) {
+			img = read_file(jobs[i].out[r], &size);
+			if (img == NULL || size != ref_size || memcmp(img, ref, size)) {
+				fprintf(stderr, "%s differs from %s\n", jobs[i].out[r],
+					jobs[i].out[RUN_REF]);
+				free(img);
+				free(ref);
+				goto out;
+			}
+			free(img);
+		}
+		free(ref);
+	}
+
+	printf("%u single (half encrypted) and %u multi images, %zu bytes, all outputs "
+	       "byte-identical, inputs unchanged\n\n", nb, nb, out_bytes);
+	printf("%-36s %9s %10s %9s %8s\n", "run", "s", "images/s", "MB/s", "speedup");
+	for (r = 0; r < RUNS; r++) {
+		char name[64];
+
+		snprintf(name, sizeof(name), "%s", run_name[r]);
+		if (r == RUN_BATCH)
+			snprintf(name, sizeof(name), "%s, %u jobs", run_name[r], nb_jobs);
+		printf("%-36s %9.3f %10.1f %9.2f %7.2fx\n", name, t[r], 2 * nb / t[r],
+		       out_bytes / t[r] / 1e6, t[RUN_REF] / t[r]);
+	}
+	ret = EXIT_SUCCESS;
+
+out:
+	free(app_data[0]);
+	free(app_data[1]);
+	if (!keep) {
+		char *args[] = { "rm", "-rf", workdir, NULL };
+
+		posix_spawnp(NULL, "rm", NULL, NULL, args, environ);
+		wait(NULL);
+	} else {
+		printf("\nFiles kept in %s\n", workdir);
+	}
+	return ret;
+}
@@ -0,0 +1,1395 @@
+/**
+ ****************************************************************************************
+ *
+ * @file prodtest_station.c
+ *
+ * @brief Production test of several DUTs at once with the prod_test firmware.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+/* The HCI definitions of the prodtest tool, built for Windows */
+#define __stdcall
+#include "host_hci.h"
+#include "commands.h"
+
+#define PRODTEST_STATION_VERSION	"v_1.0"
+
+/* Status codes of the station, following the SC_xxx ones of the prodtest tool */
+#define SC_CHECK_FAILED			100
+#define SC_PORT_CLOSED			101
+
+#define MAX_DUTS			256
+#define MAX_STEPS			128
+#define MAX_ARGS			(3 + MAX_READ_WRITE_OTP_WORDS)
+#define MAX_FIELDS			(2 + MAX_READ_WRITE_OTP_WORDS)
+#define MAX_LINE			1024
+
+/* HCI packet types and events */
+#define HCI_CMD_PACKET			0x01
+#define HCI_EVT_PACKET			0x04
+#define HCI_CMD_CMP_EVT			0x0E
+
+/* Standard HCI commands used by prodtest */
+#define HCI_RESET_CMD_OPCODE		0x0C03
+#define HCI_LE_RX_TEST_CMD_OPCODE	0x201D
+#define HCI_LE_TX_TEST_CMD_OPCODE	0x201E
+#define HCI_LE_TEST_END_CMD_OPCODE	0x201F
+
+/* Same values as in commands.c */
+#define UNMODULATED_CMD_MODE_OFF	0x4F
+#define UNMODULATED_CMD_MODE_TX		0x54
+#define UNMODULATED_CMD_MODE_RX		0x52
+#define CMD__XTRIM_OP_CALTEST		0x06
+#define CMD__XTRIM_OP_CAL		0x07
+
+/* Answer timeouts (ms), as used by the prodtest commands */
+#define PKT_TX_TIMEOUT			60000
+#define XTRIM_CAL_TIMEOUT		15000
+
+/* Simulated DUT: command processing time, packet interval of the test modes */
+#define SIM_CMD_US			1500
+#define SIM_PKT_US			625
+#define SIM_OTP_WORDS			2048
+#define SIM_REGS			64
+
+/* Decoding of the command complete event parameters */
+enum answer {
+	ANS_NONE,		/* no return parameters */
+	ANS_STATUS,		/* DUT status */
+	ANS_TEST_END,		/* DUT status, number of packets */
+	ANS_RX_STATS,		/* packets ok, sync errors, CRC errors, RSSI */
+	ANS_XTRIM,		/* trim value or calibration result */
+	ANS_OTP,		/* operation, data[6] */
+	ANS_OTP_READ,		/* DUT status, word count, words */
+	ANS_OTP_WRITE,		/* DUT status, word count */
+	ANS_REG,		/* operation, reserved, value */
+};
+
+enum field_format {
+	FMT_DEC,
+	FMT_HEX,
+	FMT_BDADDR,
+};
+
+struct field {
+	char name[16];
+	uint64_t value;
+	enum field_format format;
+};
+
+enum step_kind {
+	STEP_HCI,
+	STEP_DELAY,
+	STEP_CHECK,
+};
+
+/* One line of the test plan */
+struct step {
+	enum step_kind kind;
+	unsigned int line;
+	char text[MAX_LINE];
+	/* STEP_HCI */
+	uint16_t opcode;
+	uint8_t length;
+	uint8_t params[255];
+	uint8_t evt_length;		/* expected, 0: depends on the answer */
+	enum answer answer;
+	uint8_t operation;
+	unsigned int timeout_ms;
+	/* STEP_DELAY */
+	unsigned int delay_ms;
+	/* STEP_CHECK */
+	char field[16];
+	long long min, max;
+};
+
+struct step_result {
+	int run;
+	int status;
+	double ms;
+	unsigned int nfields;
+	struct field fields[MAX_FIELDS];
+};
+
+enum dut_state {
+	DUT_PENDING,
+	DUT_WAIT_EVENT,
+	DUT_DELAY,
+	DUT_DONE,
+};
+
+struct dut {
+	const char *port;
+	int fd;
+	enum dut_state state;
+	unsigned int step;
+	unsigned int last_hci;
+	double deadline;
+	double start, step_start, end;
+	int status;
+	struct step_result *results;
+	/* HCI event receiver */
+	uint8_t rx[3 + 255];
+	unsigned int rx_len;
+	unsigned int echo_hdr;
+	unsigned int rx_skip;
+};
+
+static struct step plan[MAX_STEPS];
+static unsigned int plan_steps;
+static struct dut duts[MAX_DUTS];
+static unsigned int dut_count;
+
+static void usage(const char* my_name)
+{
+	fprintf(stderr,
+		"Version: " PRODTEST_STATION_VERSION "\n"
+		"\n"
+		"Usage:\n"
+		"  %s [-j jobs] [-o report] -f plan port...\n"
+		"  %s -S count [-e every] [-j jobs] [-o report] -f plan\n"
+		"  %s -D count [-e every]\n"
+		"\n"
+		"  Run the test 'plan' on the prodtest firmware of every DUT connected to\n"
+		"  the serial 'port's (115200 8N1), all of them at the same time, and write\n"
+		"  a JSON report to 'report' (default: standard output).\n"
+		"\n"
+		"  The plan holds one step per line ('#' starts a comment):\n"
+		"  - a prodtest command with the arguments of the prodtest tool, e.g.\n"
+		"    'xtrim rd', 'pkt_tx 2402 37 0 1000', 'start_pkt_rx_stats 2440',\n"
+		"    'stop_pkt_rx_stats', 'otp_read 7fd4 2', 'read_reg32 50000012'\n"
+		"    ('sleep' is not supported, the DUT stops answering),\n"
+		"  - 'delay ms',\n"
+		"  - 'check field min max': a field returned by the last command must be\n"
+		"    within [min, max]. The fields are dut_status (the status answered\n"
+		"    by the DUT), packets (stoptest), rx_ok, rx_sync_err, rx_crc_err,\n"
+		"    rssi (stop_pkt_rx_stats), trim (xtrim, otp rd_xtrim), bdaddr,\n"
+		"    enable (otp), count and word0... (otp_read) and value\n"
+		"    (read_reg32/16).\n"
+		"  A DUT stops at its first failing step. The exit status is 0 if all\n"
+		"  the DUTs pass.\n"
+		"\n"
+		"  -j jobs      number of DUTs tested at the same time (default: all,\n"
+		"               1 runs them one after the other like the prodtest tool)\n"
+		"  -S count     do not use ports but 'count' simulated DUTs over ptys\n"
+		"  -D count     only serve 'count' simulated DUTs, printing their pty\n"
+		"               names, until interrupted\n"
+		"  -e every     make every 'every'-th simulated DUT faulty, alternately\n"
+		"               with a weak radio and off-range trim, or silent\n",
+		my_name, my_name, my_name);
+}
+
+static double now_s(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int open_tty(const char *name)
+{
+	struct termios tio;
+	int fd;
+
+	fd = open(name, O_RDWR | O_NOCTTY | O_NONBLOCK);
+	if (fd < 0) {
+		fprintf(stderr, "Could not open %s: %s\n", name, strerror(errno));
+		return -1;
+	}
+
+	if (tcgetattr(fd, &tio) < 0) {
+		fprintf(stderr, "%s is not a serial port: %s\n", name, strerror(errno));
+		close(fd);
+		return -1;
+	}
+	cfmakeraw(&tio);
+	tio.c_cflag |= CLOCAL | CREAD;
+	tio.c_cflag &= ~(CSTOPB | CRTSCTS);
+	tio.c_cc[VMIN] = 1;
+	tio.c_cc[VTIME] = 0;
+	cfsetispeed(&tio, B115200);
+	cfsetospeed(&tio, B115200);
+	if (tcsetattr(fd, TCSANOW, &tio) < 0) {
+		fprintf(stderr, "Could not configure %s: %s\n", name, strerror(errno));
+		close(fd);
+		return -1;
+	}
+	tcflush(fd, TCIOFLUSH);
+
+	return fd;
+}
+
+static int write_all(int fd, const uint8_t *buf, size_t len)
+{
+	struct pollfd pfd = { .fd = fd, .events = POLLOUT };
+	ssize_t n;
+
+	while (len) {
+		n = write(fd, buf, len);
+		if (n < 0 && errno == EAGAIN) {
+			poll(&pfd, 1, 100);
+			continue;
+		}
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return -1;
+		buf += n;
+		len -= n;
+	}
+	return 0;
+}
+
+/*
+ ****************************************************************************************
+ * Test plan
+ ****************************************************************************************
+ */
+
+static int parse_long(const char *str, int base, long min, long max, long *value)
+{
+	char *end;
+
+	errno = 0;
+	*value = strtol(str, &end, base);
+	return (errno || end == str || *end || *value < min || *value > max) ? -1 : 0;
+}
+
+/* Frequency in MHz to channel, as parse_frequency() of commands.c */
+static int parse_channel(const char *str, uint8_t *channel)
+{
+	long f;
+
+	if (parse_long(str, 10, 2402, 2480, &f) || (f % 2))
+		return -1;
+	*channel = (f - 2402) / 2;
+	return 0;
+}
+
+static int parse_bdaddr(const char *str, uint8_t *bdaddr)
+{
+	unsigned int b[6];
+	int i;
+
+	if (sscanf(str, "%02X:%02X:%02X:%02X:%02X:%02X", &b[5], &b[4], &b[3], &b[2], &b[1], &b[0]) != 6)
+		return -1;
+	for (i = 0; i < 6; i++)
+		bdaddr[i] = b[i];
+	return 0;
+}
+
+static void put_le(uint8_t *p, uint32_t value, unsigned int len)
+{
+	while (len--) {
+		*p++ = value & 0xFF;
+		value >>= 8;
+	}
+}
+
+static uint32_t get_le(const uint8_t *p, unsigned int len)
+{
+	uint32_t value = 0;
+
+	while (len--)
+		value = (value << 8) | p[len];
+	return value;
+}
+
+/* Build the HCI command of a prodtest command line; returns an SC_xxx code */
+static int parse_command(struct step *s, int argc, char **argv)
+{
+	const char *cmd = argv[0];
+	uint8_t *p = s->params;
+	long v, w;
+	int i;
+
+	s->kind = STEP_HCI;
+	s->evt_length = 3;
+	s->answer = ANS_NONE;
+	s->timeout_ms = RX_TIMEOUT_MILLIS;
+
+#define NARGS(n)	do { if (argc != (n)) return SC_WRONG_NUMBER_OF_ARGUMENTS; } while (0)
+#define CHANNEL(i, sc)	do { if (parse_channel(argv[i], &p[s->length++])) return sc; } while (0)
+#define NUMBER(i, lo, hi, sc) \
+	do { if (parse_long(argv[i], 10, lo, hi, &v)) return sc; } while (0)
+
+	if (!strcmp(cmd, "cont_pkt_tx") || !strcmp(cmd, "pkt_tx")) {
+		int count = !strcmp(cmd, "pkt_tx");
+
+		NARGS(4 + count);
+		CHANNEL(1, SC_INVALID_FREQUENCY_ARG);
+		NUMBER(2, 0, 255, SC_INVALID_DATA_LENGTH_ARG);
+		p[s->length++] = v;
+		NUMBER(3, 0, 7, SC_INVALID_PAYLOAD_TYPE_ARG);
+		p[s->length++] = v;
+		if (count) {
+			NUMBER(4, 1, 65535, SC_INVALID_NUMBER_OF_PACKETS_ARG);
+			put_le(&p[s->length], v, 2);
+			s->length += 2;
+			s->opcode = HCI_TX_TEST_CMD_OPCODE;
+			s->timeout_ms = PKT_TX_TIMEOUT;
+		} else {
+			s->opcode = HCI_LE_TX_TEST_CMD_OPCODE;
+			s->evt_length = 4;
+			s->answer = ANS_STATUS;
+		}
+	} else if (!strcmp(cmd, "start_pkt_rx")) {
+		NARGS(2);
+		CHANNEL(1, SC_INVALID_FREQUENCY_ARG);
+		s->opcode = HCI_LE_RX_TEST_CMD_OPCODE;
+		s->evt_length = 4;
+		s->answer = ANS_STATUS;
+	} else if (!strcmp(cmd, "start_pkt_rx_stats")) {
+		NARGS(2);
+		CHANNEL(1, SC_INVALID_FREQUENCY_ARG);
+		s->opcode = HCI_START_PROD_RX_TEST_CMD_OPCODE;
+	} else if (!strcmp(cmd, "stop_pkt_rx_stats")) {
+		NARGS(1);
+		s->opcode = HCI_END_PROD_RX_TEST_CMD_OPCODE;
+		s->evt_length = 11;
+		s->answer = ANS_RX_STATS;
+	} else if (!strcmp(cmd, "stoptest")) {
+		NARGS(1);
+		s->opcode = HCI_LE_TEST_END_CMD_OPCODE;
+		s->evt_length = 6;
+		s->answer = ANS_TEST_END;
+	} else if (!strcmp(cmd, "unmodulated")) {
+		if (argc < 2)
+			return SC_WRONG_NUMBER_OF_ARGUMENTS;
+		if (!strcasecmp(argv[1], "OFF")) {
+			NARGS(2);
+			p[s->length++] = UNMODULATED_CMD_MODE_OFF;
+			p[s->length++] = 0;
+		} else if (!strcasecmp(argv[1], "TX") || !strcasecmp(argv[1], "RX")) {
+			NARGS(3);
+			p[s->length++] = (toupper((unsigned char)argv[1][0]) == 'T') ?
+					 UNMODULATED_CMD_MODE_TX : UNMODULATED_CMD_MODE_RX;
+			CHANNEL(2, SC_INVALID_FREQUENCY_ARG);
+		} else {
+			return SC_INVALID_UNMODULATED_CMD_MODE_ARG;
+		}
+		s->opcode = HCI_UNMODULATED_ON_CMD_OPCODE;
+	} else if (!strcmp(cmd, "start_cont_tx")) {
+		NARGS(3);
+		CHANNEL(1, SC_INVALID_FREQUENCY_ARG);
+		NUMBER(2, 0, 7, SC_INVALID_PAYLOAD_TYPE_ARG);
+		p[s->length++] = v;
+		s->opcode = HCI_TX_START_CONTINUE_TEST_CMD_OPCODE;
+	} else if (!strcmp(cmd, "stop_cont_tx")) {
+		NARGS(1);
+		s->opcode = HCI_TX_END_CONTINUE_TEST_CMD_OPCODE;
+	} else if (!strcmp(cmd, "reset")) {
+		NARGS(1);
+		s->opcode = HCI_RESET_CMD_OPCODE;
+		s->evt_length = 4;
+		s->answer = ANS_STATUS;
+	} else if (!strcmp(cmd, "xtrim")) {
+		static const char *const ops[] = { "rd", "wr", "en", "inc", "dec", "dis", "caltest", "cal" };
+
+		if (argc < 2)
+			return SC_WRONG_NUMBER_OF_ARGUMENTS;
+		for (i = 0; i < 8 && strcmp(argv[1], ops[i]); i++)
+			;
+		if (i == 8)
+			return SC_INVALID_XTAL_TRIMMING_CMD_OPERATION_ARG;
+		s->operation = i;
+		v = 0;
+		if (i == 1 || i == 3 || i == 4) {
+			NARGS(3);
+			NUMBER(2, 0, 0xFFFF, SC_INVALID_XTAL_TRIMMING_CMD_TRIM_VALUE_ARG);
+		} else if (i >= CMD__XTRIM_OP_CALTEST) {
+			NARGS(3);
+			/* P<port>_<pin>, coded as port * 10 + pin like parse_gpio() */
+			if (strlen(argv[2]) != 4 || argv[2][0] != 'P' || argv[2][2] != '_' ||
+			    argv[2][1] < '0' || argv[2][1] > '3' || argv[2][3] < '0' || argv[2][3] > '9')
+				return SC_INVALID_GPIO_ARG;
+			v = (argv[2][1] - '0') * 10 + (argv[2][3] - '0');
+			s->timeout_ms = XTRIM_CAL_TIMEOUT;
+		} else {
+			NARGS(2);
+		}
+		p[s->length++] = i;
+		put_le(&p[s->length], v, 2);
+		s->length += 2;
+		s->opcode = HCI_XTAL_TRIM_CMD_OPCODE;
+		s->evt_length = 5;
+		s->answer = ANS_XTRIM;
+	} else if (!strcmp(cmd, "otp")) {
+		static const char *const ops[] = { "rd_xtrim", "wr_xtrim", "rd_bdaddr", "wr_bdaddr", "re_xtrim", "we_xtrim" };
+
+		if (argc < 2)
+			return SC_WRONG_NUMBER_OF_ARGUMENTS;
+		for (i = 0; i < 6 && strcmp(argv[1], ops[i]); i++)
+			;
+		if (i == 6)
+			return SC_INVALID_OTP_CMD_OPERATION_ARG;
+		NARGS((i == CMD__OTP_OP_WR_XTRIM || i == CMD__OTP_OP_WR_BDADDR) ? 3 : 2);
+		s->operation = i;
+		memset(p, 0, 7);
+		p[0] = i;
+		if (i == CMD__OTP_OP_WR_XTRIM) {
+			NUMBER(2, 0, 0xFFFF, SC_INVALID_OTP_CMD_TRIM_VALUE_ARG);
+			put_le(&p[1], v, 2);
+		} else if (i == CMD__OTP_OP_WR_BDADDR) {
+			if (parse_bdaddr(argv[2], &p[1]))
+				return SC_INVALID_OTP_CMD_BDADDR_ARG;
+		} else if (i == CMD__OTP_OP_WE_XTRIM) {
+			p[1] = 0x10;	/* as hci_dialog_otp_we_xtrim() */
+		}
+		s->length = 7;
+		s->opcode = HCI_OTP_RW_CMD_OPCODE;
+		s->evt_length = 10;
+		s->answer = ANS_OTP;
+	} else if (!strcmp(cmd, "otp_read")) {
+		NARGS(3);
+		if (parse_long(argv[1], 16, 0, 0xFFFF, &w))
+			return SC_INVALID_OTP_ADDRESS_ARG;
+		NUMBER(2, 1, MAX_READ_WRITE_OTP_WORDS, SC_INVALID_NUMBER_OF_OTP_WORDS_ARG);
+		put_le(p, w, 2);
+		p[2] = v;
+		s->length = 3;
+		s->opcode = HCI_OTP_READ_CMD_OPCODE;
+		s->evt_length = 5 + 4 * v;
+		s->answer = ANS_OTP_READ;
+	} else if (!strcmp(cmd, "otp_write")) {
+		if (argc < 3 || argc > 2 + MAX_READ_WRITE_OTP_WORDS)
+			return SC_WRONG_NUMBER_OF_ARGUMENTS;
+		if (parse_long(argv[1], 16, 0, 0xFFFF, &w))
+			return SC_INVALID_OTP_ADDRESS_ARG;
+		put_le(p, w, 2);
+		p[2] = argc - 2;
+		for (i = 2; i < argc; i++) {
+			unsigned long word;
+			char *end;
+
+			errno = 0;
+			word = strtoul(argv[i], &end, 16);
+			if (errno || *end || end == argv[i] || word > 0xFFFFFFFFUL)
+				return SC_INVALID_WORD_VALUE_ARG;
+			put_le(&p[3 + 4 * (i - 2)], word, 4);
+		}
+		s->length = 3 + 4 * (argc - 2);
+		s->opcode = HCI_OTP_WRITE_CMD_OPCODE;
+		s->evt_length = 5;
+		s->answer = ANS_OTP_WRITE;
+	} else if (!strcmp(cmd, "read_reg32") || !strcmp(cmd, "write_reg32") ||
+		   !strcmp(cmd, "read_reg16") || !strcmp(cmd, "write_reg16")) {
+		int write = (cmd[0] == 'w');
+		int reg16 = (strstr(cmd, "16") != NULL);
+		unsigned long addr, value = 0;
+		char *end;
+
+		NARGS(2 + write);
+		errno = 0;
+		addr = strtoul(argv[1], &end, 16);
+		if (errno || *end || end == argv[1] || addr > 0xFFFFFFFFUL)
+			return SC_INVALID_REGISTER_ADDRESS_ARG;
+		if (write) {
+			value = strtoul(argv[2], &end, 16);
+			if (errno || *end || end == argv[2] || value > (reg16 ? 0xFFFFUL : 0xFFFFFFFFUL))
+				return SC_INVALID_REGISTER_VALUE_ARG;
+		}
+		s->operation = reg16 ? (write ? CMD__REGISTER_RW_OP_WRITE_REG16 : CMD__REGISTER_RW_OP_READ_REG16) :
+				       (write ? CMD__REGISTER_RW_OP_WRITE_REG32 : CMD__REGISTER_RW_OP_READ_REG32);
+		p[0] = s->operation;
+		put_le(&p[1], addr, 4);
+		put_le(&p[5], value, 4);
+		s->length = 9;
+		s->opcode = HCI_REGISTER_RW_CMD_OPCODE;
+		s->evt_length = 9;
+		s->answer = ANS_REG;
+	} else {
+		return SC_INVALID_COMMAND;
+	}
+
+#undef NARGS
+#undef CHANNEL
+#undef NUMBER
+
+	return SC_NO_ERROR;
+}
+
+static int load_plan(const char *filename)
+{
+	char line[MAX_LINE], copy[MAX_LINE];
+	char *argv[MAX_ARGS + 1];
+	unsigned int line_no = 0;
+	int have_command = 0;
+	FILE *f;
+
+	f = fopen(filename, "r");
+	if (f == NULL) {
+		fprintf(stderr, "Could not open %s: %s\n", filename, strerror(errno));
+		return -1;
+	}
+
+	while (fgets(line, sizeof(line), f)) {
+		struct step *s = &plan[plan_steps];
+		char *hash, *tok, *save;
+		int argc = 0, sc;
+		long v;
+
+		line_no++;
+		if ((hash = strchr(line, '#')) != NULL)
+			*hash = 0;
+		line[strcspn(line, "\r\n")] = 0;
+		strcpy(copy, line);
+		for (tok = strtok_r(copy, " \t", &save); tok && argc <= MAX_ARGS; tok = strtok_r(NULL, " \t", &save))
+			argv[argc++] = tok;
+		if (argc == 0)
+			continue;
+		if (plan_steps == MAX_STEPS || argc > MAX_ARGS) {
+			fprintf(stderr, "%s:%u: too many steps or arguments\n", filename, line_no);
+			goto fail;
+		}
+
+		memset(s, 0, sizeof(*s));
+		s->line = line_no;
+		snprintf(s->text, sizeof(s->text), "%s", line + strspn(line, " \t"));
+		s->text[strcspn(s->text, "#")] = 0;
+		while (strlen(s->text) && strchr(" \t", s->text[strlen(s->text) - 1]))
+			s->text[strlen(s->text) - 1] = 0;
+
+		if (!strcmp(argv[0], "delay")) {
+			if (argc != 2 || parse_long(argv[1], 10, 0, 3600000, &v)) {
+				fprintf(stderr, "%s:%u: usage: delay ms\n", filename, line_no);
+				goto fail;
+			}
+			s->kind = STEP_DELAY;
+			s->delay_ms = v;
+		} else if (!strcmp(argv[0], "check")) {
+			char *end1, *end2;
+
+			if (argc != 4 || !have_command || strlen(argv[1]) >= sizeof(s->field)) {
+				fprintf(stderr, "%s:%u: usage: check field min max, after a command\n", filename, line_no);
+				goto fail;
+			}
+			s->kind = STEP_CHECK;
+			strcpy(s->field, argv[1]);
+			s->min = strtoll(argv[2], &end1, 0);
+			s->max = strtoll(argv[3], &end2, 0);
+			if (*end1 || *end2) {
+				fprintf(stderr, "%s:%u: invalid limits\n", filename, line_no);
+				goto fail;
+			}
+		} else {
+			sc = parse_command(s, argc, argv);
+			if (sc != SC_NO_ERROR) {
+				fprintf(stderr, "%s:%u: \"%s\": error %d\n", filename, line_no, s->text, sc);
+				goto fail;
+			}
+			have_command = 1;
+		}
+		plan_steps++;
+	}
+	fclose(f);
+
+	if (plan_steps == 0) {
+		fprintf(stderr, "%s: empty test plan\n", filename);
+		return -1;
+	}
+	return 0;
+
+fail:
+	fclose(f);
+	return -1;
+}
+
+/*
+ ****************************************************************************************
+ * Orchestrator
+ ****************************************************************************************
+ */
+
+static void add_field(struct step_result *r, const char *name, uint64_t value, enum field_format format)
+{
+	struct field *f;
+
+	if (r->nfields == MAX_FIELDS)
+		return;
+	f = &r->fields[r->nfields++];
+	snprintf(f->name, sizeof(f->name), "%s", name);
+	f->value = value;
+	f->format = format;
+}
+
+/* Decode a command complete event into fields; returns an SC_xxx code */
+static int decode_answer(const struct step *s, const uint8_t *evt, struct step_result *r)
+{
+	const uint8_t *p = &evt[2];	/* parameters, after num_hci_pkts and opcode */
+	unsigned int len = evt[1];
+	char name[16];
+	unsigned int i;
+
+	if (evt[0] != HCI_CMD_CMP_EVT || len < 3 || get_le(&p[1], 2) != s->opcode ||
+	    (len != s->evt_length))
+		return SC_UNEXPECTED_EVENT;
+
+	switch (s->answer) {
+	case ANS_NONE:
+		break;
+	case ANS_STATUS:
+		add_field(r, "dut_status", p[3], FMT_DEC);
+		if (p[3])
+			return SC_HCI_STANDARD_ERROR_CODE_BASE + p[3];
+		break;
+	case ANS_TEST_END:
+		add_field(r, "dut_status", p[3], FMT_DEC);
+		add_field(r, "packets", get_le(&p[4], 2), FMT_DEC);
+		if (p[3])
+			return SC_HCI_STANDARD_ERROR_CODE_BASE + p[3];
+		break;
+	case ANS_RX_STATS:
+		add_field(r, "rx_ok", get_le(&p[3], 2), FMT_DEC);
+		add_field(r, "rx_sync_err", get_le(&p[5], 2), FMT_DEC);
+		add_field(r, "rx_crc_err", get_le(&p[7], 2), FMT_DEC);
+		add_field(r, "rssi", get_le(&p[9], 2), FMT_DEC);
+		break;
+	case ANS_XTRIM:
+		add_field(r, "trim", get_le(&p[3], 2), FMT_DEC);
+		if (s->operation >= CMD__XTRIM_OP_CALTEST) {
+			if (get_le(&p[3], 2) == 0x01)
+				return SC_XTAL_TRIMMING_CAL_OUT_OF_RANGE_ERROR;
+			if (get_le(&p[3], 2) == 0x02)
+				return SC_XTAL_TRIMMING_CAL_FREQ_NOT_CONNECTED;
+		}
+		break;
+	case ANS_OTP:
+		if (s->operation == CMD__OTP_OP_RD_XTRIM)
+			add_field(r, "trim", get_le(&p[4], 2), FMT_DEC);
+		else if (s->operation == CMD__OTP_OP_RD_BDADDR)
+			add_field(r, "bdaddr", (uint64_t)get_le(&p[8], 2) << 32 | get_le(&p[4], 4), FMT_BDADDR);
+		else if (s->operation == CMD__OTP_OP_RE_XTRIM)
+			add_field(r, "enable", p[4], FMT_DEC);
+		break;
+	case ANS_OTP_READ:
+		add_field(r, "dut_status", p[3], FMT_DEC);
+		add_field(r, "count", p[4], FMT_DEC);
+		for (i = 0; i < p[4] && 5 + 4 * i + 4 <= len; i++) {
+			snprintf(name, sizeof(name), "word%u", i);
+			add_field(r, name, get_le(&p[5 + 4 * i], 4), FMT_HEX);
+		}
+		if (p[3])
+			return SC_HCI_STANDARD_ERROR_CODE_BASE + p[3];
+		break;
+	case ANS_OTP_WRITE:
+		add_field(r, "dut_status", p[3], FMT_DEC);
+		add_field(r, "count", p[4], FMT_DEC);
+		if (p[3])
+			return SC_HCI_STANDARD_ERROR_CODE_BASE + p[3];
+		break;
+	case ANS_REG:
+		if (s->operation == CMD__REGISTER_RW_OP_READ_REG32)
+			add_field(r, "value", get_le(&p[5], 4), FMT_HEX);
+		else if (s->operation == CMD__REGISTER_RW_OP_READ_REG16)
+			add_field(r, "value", get_le(&p[5], 2), FMT_HEX);
+		break;
+	}
+	return SC_NO_ERROR;
+}
+
+static void dut_finish_step(struct dut *d, int status)
+{
+	struct step_result *r = &d->results[d->step];
+	double t = now_s();
+
+	r->run = 1;
+	r->status = status;
+	r->ms = (t - d->step_start) * 1000;
+	if (status != SC_NO_ERROR) {
+		d->status = status;
+		d->state = DUT_DONE;
+		d->end = t;
+		return;
+	}
+	d->step++;
+	d->state = DUT_PENDING;
+}
+
+/* Start the steps of a DUT until one of them has to wait */
+static void dut_run(struct dut *d)
+{
+	while (d->state == DUT_PENDING) {
+		const struct step *s;
+		struct step_result *r, *last;
+		uint8_t pkt[4 + 255];
+		unsigned int i;
+
+		if (d->step == plan_steps) {
+			d->state = DUT_DONE;
+			d->end = now_s();
+			return;
+		}
+		s = &plan[d->step];
+		d->step_start = now_s();
+
+		switch (s->kind) {
+		case STEP_HCI:
+			pkt[0] = HCI_CMD_PACKET;
+			put_le(&pkt[1], s->opcode, 2);
+			pkt[3] = s->length;
+			memcpy(&pkt[4], s->params, s->length);
+			d->rx_len = d->echo_hdr = d->rx_skip = 0;
+			d->last_hci = d->step;
+			if (write_all(d->fd, pkt, 4 + s->length) < 0) {
+				dut_finish_step(d, SC_PORT_CLOSED);
+				return;
+			}
+			d->state = DUT_WAIT_EVENT;
+			d->deadline = d->step_start + s->timeout_ms / 1000.0;
+			return;
+		case STEP_DELAY:
+			d->state = DUT_DELAY;
+			d->deadline = d->step_start + s->delay_ms / 1000.0;
+			return;
+		case STEP_CHECK:
+			last = &d->results[d->last_hci];
+			r = &d->results[d->step];
+			for (i = 0; i < last->nfields && strcmp(last->fields[i].name, s->field); i++)
+				;
+			if (i == last->nfields) {
+				dut_finish_step(d, SC_CHECK_FAILED);
+				return;
+			}
+			add_field(r, s->field, last->fields[i].value, last->fields[i].format);
+			dut_finish_step(d, ((long long)last->fields[i].value < s->min ||
+					    (long long)last->fields[i].value > s->max) ?
+					   SC_CHECK_FAILED : SC_NO_ERROR);
+			break;
+		}
+	}
+}
+
+/*
+ * HCI receiver, as UARTProc() of the prodtest tool: events (0x04) are collected,
+ * the echo of the commands on a 1-wire UART (0x01) is skipped, other bytes dropped.
+ */
+static void dut_receive(struct dut *d)
+{
+	uint8_t buf[256];
+	ssize_t n;
+	int i;
+
+	n = read(d->fd, buf, sizeof(buf));
+	if (n < 0 && (errno == EAGAIN || errno == EINTR))
+		return;
+	if (n <= 0) {
+		if (d->state == DUT_WAIT_EVENT)
+			dut_finish_step(d, SC_PORT_CLOSED);
+		else
+			d->status = SC_PORT_CLOSED;
+		return;
+	}
+
+	for (i = 0; i < n; i++) {
+		uint8_t c = buf[i];
+
+		if (d->rx_skip) {
+			d->rx_skip--;
+			continue;
+		}
+		if (d->echo_hdr) {
+			/* 1-wire echo: opcode[2] and length, then the parameters */
+			if (++d->echo_hdr == 4) {
+				d->echo_hdr = 0;
+				d->rx_skip = c;
+			}
+			continue;
+		}
+		if (d->rx_len == 0 && c != HCI_EVT_PACKET) {
+			if (c == HCI_CMD_PACKET)
+				d->echo_hdr = 1;
+			continue;
+		}
+		d->rx[d->rx_len++] = c;
+		if (d->rx_len >= 3 && d->rx_len == 3u + d->rx[2]) {
+			d->rx_len = 0;
+			if (d->state == DUT_WAIT_EVENT)
+				dut_finish_step(d, decode_answer(&plan[d->step], &d->rx[1], &d->results[d->step]));
+			/* an event outside a command is ignored */
+		}
+	}
+}
+
+static void run_station(unsigned int jobs)
+{
+	struct pollfd pfd[MAX_DUTS];
+	struct dut *map[MAX_DUTS];
+	unsigned int started = 0, active, i, n;
+	double t, next;
+
+	for (;;) {
+		t = now_s();
+		active = 0;
+		for (i = 0; i < started; i++)
+			active += (duts[i].state != DUT_DONE);
+		while (started < dut_count && active < jobs) {
+			duts[started].start = t;
+			dut_run(&duts[started++]);
+			active++;
+		}
+
+		/* Timeouts and delays */
+		next = t + 1;
+		n = 0;
+		for (i = 0; i < started; i++) {
+			struct dut *d = &duts[i];
+
+			if ((d->state == DUT_WAIT_EVENT || d->state == DUT_DELAY) && t >= d->deadline) {
+				dut_finish_step(d, (d->state == DUT_DELAY) ? SC_NO_ERROR : SC_RX_TIMEOUT);
+				dut_run(d);
+			}
+			if (d->state == DUT_DONE)
+				continue;
+			if (d->deadline < next)
+				next = d->deadline;
+			pfd[n].fd = d->fd;
+			pfd[n].events = POLLIN;
+			map[n++] = d;
+		}
+		if (n == 0 && started == dut_count)
+			break;
+
+		t = now_s();
+		if (poll(pfd, n, next > t ? (int)((next - t) * 1000) + 1 : 0) < 0 && errno != EINTR) {
+			perror("poll");
+			exit(EXIT_FAILURE);
+		}
+		for (i = 0; i < n; i++) {
+			if (pfd[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+				dut_receive(map[i]);
+				dut_run(map[i]);
+			}
+		}
+	}
+}
+
+static void print_field(FILE *f, const struct field *fl)
+{
+	switch (fl->format) {
+	case FMT_DEC:
+		fprintf(f, "\"%s\": %llu", fl->name, (unsigned long long)fl->value);
+		break;
+	case FMT_HEX:
+		fprintf(f, "\"%s\": \"0x%08llX\"", fl->name, (unsigned long long)fl->value);
+		break;
+	case FMT_BDADDR:
+		fprintf(f, "\"%s\": \"%02X:%02X:%02X:%02X:%02X:%02X\"", fl->name,
+			(unsigned int)(fl->value >> 40) & 0xFF, (unsigned int)(fl->value >> 32) & 0xFF,
+			(unsigned int)(fl->value >> 24) & 0xFF, (unsigned int)(fl->value >> 16) & 0xFF,
+			(unsigned int)(fl->value >> 8) & 0xFF, (unsigned int)fl->value & 0xFF);
+		break;
+	}
+}
+
+static void print_json_string(FILE *f, const char *s)
+{
+	fputc('"', f);
+	for (; *s; s++) {
+		if (*s == '"' || *s == '\\')
+			fputc('\\', f);
+		fputc(*s, f);
+	}
+	fputc('"', f);
+}
+
+static unsigned int write_report(FILE *f, const char *plan_name, unsigned int jobs, double elapsed)
+{
+	unsigned int i, j, k, passed = 0;
+	double sum = 0;
+
+	fprintf(f, "{\n  \"version\": \"" PRODTEST_STATION_VERSION "\",\n  \"plan\": ");
+	print_json_string(f, plan_name);
+	fprintf(f, ",\n  \"jobs\": %u,\n  \"duts\": [\n", jobs);
+	for (i = 0; i < dut_count; i++) {
+		struct dut *d = &duts[i];
+
+		passed += (d->status == SC_NO_ERROR);
+		sum += d->end - d->start;
+		fprintf(f, "    {\n      \"port\": ");
+		print_json_string(f, d->port);
+		fprintf(f, ",\n      \"result\": \"%s\",\n      \"status\": %d,\n",
+			d->status == SC_NO_ERROR ? "pass" : "fail", d->status);
+		if (d->status != SC_NO_ERROR && d->step < plan_steps)
+			fprintf(f, "      \"failed_line\": %u,\n", plan[d->step].line);
+		fprintf(f, "      \"ms\": %.1f,\n      \"steps\": [\n", (d->end - d->start) * 1000);
+		for (j = 0; j < plan_steps && d->results[j].run; j++) {
+			const struct step_result *r = &d->results[j];
+
+			fprintf(f, "        { \"line\": %u, \"step\": ", plan[j].line);
+			print_json_string(f, plan[j].text);
+			fprintf(f, ", \"status\": %d, \"ms\": %.1f", r->status, r->ms);
+			for (k = 0; k < r->nfields; k++) {
+				fprintf(f, ", ");
+				print_field(f, &r->fields[k]);
+			}
+			fprintf(f, " }%s\n", (j + 1 < plan_steps && d->results[j + 1].run) ? "," : "");
+		}
+		fprintf(f, "      ]\n    }%s\n", i + 1 < dut_count ? "," : "");
+	}
+	fprintf(f, "  ],\n  \"summary\": { \"duts\": %u, \"passed\": %u, \"failed\": %u, "
+		"\"elapsed_ms\": %.1f, \"sum_of_dut_ms\": %.1f, \"duts_per_hour\": %.0f }\n}\n",
+		dut_count, passed, dut_count - passed, elapsed * 1000, sum * 1000,
+		elapsed > 0 ? dut_count * 3600 / elapsed : 0);
+	return passed;
+}
+
+/*
+ ****************************************************************************************
+ * Simulated DUTs: the answers of dialog_commands.c of the prod_test firmware
+ ****************************************************************************************
+ */
+
+struct sim_dut {
+	int fd;
+	int faulty;		/* 0: good, 1: weak radio and off-range trim, 2: silent */
+	uint8_t rx[4 + 255];
+	unsigned int rx_len;
+	/* pending answer */
+	uint8_t tx[3 + 255];
+	unsigned int tx_len;
+	double tx_at;
+	/* state */
+	int rx_test;
+	double rx_since;
+	uint16_t trim;
+	uint16_t otp_trim;
+	uint8_t bdaddr[6];
+	uint32_t otp[SIM_OTP_WORDS];
+	uint32_t reg_addr[SIM_REGS];
+	uint32_t reg_value[SIM_REGS];
+	unsigned int regs;
+};
+
+static void sim_answer(struct sim_dut *s, uint16_t opcode, const uint8_t *params, unsigned int len,
+		       double delay_s)
+{
+	s->tx[0] = HCI_EVT_PACKET;
+	s->tx[1] = HCI_CMD_CMP_EVT;
+	s->tx[2] = 3 + len;
+	s->tx[3] = 1;
+	put_le(&s->tx[4], opcode, 2);
+	memcpy(&s->tx[6], params, len);
+	s->tx_len = 6 + len;
+	s->tx_at = now_s() + SIM_CMD_US / 1e6 + delay_s;
+}
+
+static uint32_t *sim_reg(struct sim_dut *s, uint32_t addr)
+{
+	unsigned int i;
+
+	for (i = 0; i < s->regs; i++)
+		if (s->reg_addr[i] == addr)
+			return &s->reg_value[i];
+	if (s->regs == SIM_REGS)
+		i = addr % SIM_REGS;
+	else
+		i = s->regs++;
+	s->reg_addr[i] = addr;
+	s->reg_value[i] = addr * 2654435761u;	/* some reset value */
+	return &s->reg_value[i];
+}
+
+static void sim_command(struct sim_dut *s, uint16_t opcode, const uint8_t *p, unsigned int len)
+{
+	uint8_t a[255];
+	unsigned int i, words, addr;
+	double t = now_s();
+
+	memset(a, 0, sizeof(a));
+
+	if (s->faulty == 2)
+		return;
+
+	switch (opcode) {
+	case HCI_RESET_CMD_OPCODE:
+	case HCI_LE_TX_TEST_CMD_OPCODE:
+		s->rx_test = 0;
+		sim_answer(s, opcode, a, 1, 0);
+		break;
+	case HCI_LE_RX_TEST_CMD_OPCODE:
+	case HCI_START_PROD_RX_TEST_CMD_OPCODE:
+		s->rx_test = 1;
+		s->rx_since = t;
+		sim_answer(s, opcode, a, opcode == HCI_LE_RX_TEST_CMD_OPCODE, 0);
+		break;
+	case HCI_LE_TEST_END_CMD_OPCODE:
+	case HCI_END_PROD_RX_TEST_CMD_OPCODE:
+	{
+		/* A tester sends one packet per SIM_PKT_US, the weak radio gets half of them */
+		unsigned int pkts = s->rx_test ? (unsigned int)((t - s->rx_since) * 1e6 / SIM_PKT_US) : 0;
+
+		if (s->faulty)
+			pkts /= 2;
+		s->rx_test = 0;
+		if (opcode == HCI_LE_TEST_END_CMD_OPCODE) {
+			put_le(&a[1], pkts, 2);
+			sim_answer(s, opcode, a, 3, 0);
+		} else {
+			put_le(&a[0], pkts, 2);
+			put_le(&a[2], pkts / 200, 2);
+			put_le(&a[4], pkts / 100, 2);
+			put_le(&a[6], s->faulty ? 40 : 70, 2);
+			sim_answer(s, opcode, a, 8, 0);
+		}
+		break;
+	}
+	case HCI_TX_TEST_CMD_OPCODE:
+		/* Answered when all the packets have been sent */
+		sim_answer(s, opcode, a, 0, (len >= 5 ? get_le(&p[3], 2) : 0) * SIM_PKT_US / 1e6);
+		break;
+	case HCI_UNMODULATED_ON_CMD_OPCODE:
+	case HCI_TX_START_CONTINUE_TEST_CMD_OPCODE:
+	case HCI_TX_END_CONTINUE_TEST_CMD_OPCODE:
+		sim_answer(s, opcode, a, 0, 0);
+		break;
+	case HCI_XTAL_TRIM_CMD_OPCODE:
+	{
+		uint16_t v = len >= 3 ? get_le(&p[1], 2) : 0;
+
+		switch (len ? p[0] : 0xFF) {
+		case 1: s->trim = v; break;
+		case 3: s->trim += v; break;
+		case 4: s->trim -= v; break;
+		case CMD__XTRIM_OP_CALTEST:
+		case CMD__XTRIM_OP_CAL:
+			/* the calibration takes a while and fails on a faulty DUT */
+			put_le(a, s->faulty ? 0x01 : 0x00, 2);
+			sim_answer(s, opcode, a, 2, 0.5);
+			return;
+		}
+		put_le(a, s->trim, 2);
+		sim_answer(s, opcode, a, 2, 0);
+		break;
+	}
+	case HCI_OTP_RW_CMD_OPCODE:
+		if (len < 7)
+			return;
+		a[0] = p[0];
+		switch (p[0]) {
+		case CMD__OTP_OP_RD_XTRIM: put_le(&a[1], s->otp_trim, 2); break;
+		case CMD__OTP_OP_WR_XTRIM: s->otp_trim = get_le(&p[1], 2); break;
+		case CMD__OTP_OP_RD_BDADDR: memcpy(&a[1], s->bdaddr, 6); break;
+		case CMD__OTP_OP_WR_BDADDR: memcpy(s->bdaddr, &p[1], 6); break;
+		case CMD__OTP_OP_RE_XTRIM: a[1] = s->otp_trim != 0; break;
+		}
+		sim_answer(s, opcode, a, 7, 0.002);	/* OTP programming time */
+		break;
+	case HCI_OTP_READ_CMD_OPCODE:
+	case HCI_OTP_WRITE_CMD_OPCODE:
+		if (len < 3)
+			return;
+		addr = get_le(p, 2) / 4;
+		words = p[2];
+		a[1] = words;
+		for (i = 0; i < words; i++) {
+			uint32_t *w = &s->otp[(addr + i) % SIM_OTP_WORDS];
+
+			if (opcode == HCI_OTP_READ_CMD_OPCODE)
+				put_le(&a[2 + 4 * i], *w, 4);
+			else if (3 + 4 * i + 4 <= len)
+				*w |= get_le(&p[3 + 4 * i], 4);	/* OTP bits only get set */
+		}
+		sim_answer(s, opcode, a, opcode == HCI_OTP_READ_CMD_OPCODE ? 2 + 4 * words : 2,
+			   opcode == HCI_OTP_WRITE_CMD_OPCODE ? words * 0.0005 : 0);
+		break;
+	case HCI_REGISTER_RW_CMD_OPCODE:
+	{
+		uint32_t *r;
+
+		if (len < 9)
+			return;
+		r = sim_reg(s, get_le(&p[1], 4));
+		a[0] = p[0];
+		switch (p[0]) {
+		case CMD__REGISTER_RW_OP_READ_REG32: put_le(&a[2], *r, 4); break;
+		case CMD__REGISTER_RW_OP_WRITE_REG32: *r = get_le(&p[5], 4); break;
+		case CMD__REGISTER_RW_OP_READ_REG16: put_le(&a[2], *r & 0xFFFF, 2); break;
+		case CMD__REGISTER_RW_OP_WRITE_REG16: *r = (*r & 0xFFFF0000) | get_le(&p[5], 2); break;
+		}
+		sim_answer(s, opcode, a, 6, 0);
+		break;
+	}
+	default:
+		/* Unknown command: command complete with "unknown HCI command" */
+		a[0] = 0x01;
+		sim_answer(s, opcode, a, 1, 0);
+		break;
+	}
+}
+
+static volatile sig_atomic_t sim_stop;
+
+static void sim_signal(int sig)
+{
+	sim_stop = 1;
+}
+
+/* Serve the simulated DUTs until all the ports are closed or a signal is received */
+static void sim_serve(struct sim_dut *sims, unsigned int count)
+{
+	struct pollfd pfd[MAX_DUTS];
+	unsigned int i, open_count;
+	double t, next;
+
+	signal(SIGTERM, sim_signal);
+	signal(SIGINT, sim_signal);
+
+	while (!sim_stop) {
+		t = now_s();
+		next = t + 1;
+		open_count = 0;
+		for (i = 0; i < count; i++) {
+			struct sim_dut *s = &sims[i];
+
+			if (s->tx_len && t >= s->tx_at) {
+				write_all(s->fd, s->tx, s->tx_len);
+				s->tx_len = 0;
+			}
+			if (s->tx_len && s->tx_at < next)
+				next = s->tx_at;
+			pfd[i].fd = s->fd;
+			pfd[i].events = POLLIN;
+			open_count += (s->fd >= 0);
+		}
+		if (open_count == 0)
+			break;
+
+		if (poll(pfd, count, (int)((next - t) * 1000) + 1) < 0 && errno != EINTR)
+			break;
+
+		for (i = 0; i < count; i++) {
+			struct sim_dut *s = &sims[i];
+			uint8_t buf[256];
+			ssize_t n, k;
+
+			if (!(pfd[i].revents & (POLLIN | POLLHUP | POLLERR)))
+				continue;
+			n = read(s->fd, buf, sizeof(buf));
+			if (n <= 0) {
+				if (n < 0 && (errno == EAGAIN || errno == EINTR))
+					continue;
+				if (n < 0 && errno == EIO) {
+					/* the station has closed the pty, wait for it to be reopened */
+					pfd[i].fd = -1;
+					continue;
+				}
+				close(s->fd);
+				s->fd = -1;
+				continue;
+			}
+			for (k = 0; k < n; k++) {
+				if (s->rx_len == 0 && buf[k] != HCI_CMD_PACKET)
+					continue;
+				s->rx[s->rx_len++] = buf[k];
+				if (s->rx_len >= 4 && s->rx_len == 4u + s->rx[3]) {
+					sim_command(s, get_le(&s->rx[1], 2), &s->rx[4], s->rx[3]);
+					s->rx_len = 0;
+				}
+			}
+		}
+	}
+}
+
+/* Create 'count' simulated DUTs on ptys; returns their names */
+static struct sim_dut *sim_create(unsigned int count, unsigned int faulty_every, char **names)
+{
+	struct sim_dut *sims = calloc(count, sizeof(*sims));
+	unsigned int i;
+
+	if (sims == NULL)
+		return NULL;
+
+	for (i = 0; i < count; i++) {
+		struct sim_dut *s = &sims[i];
+		struct termios tio;
+		int fd;
+
+		s->fd = posix_openpt(O_RDWR | O_NOCTTY);
+		if (s->fd < 0 || grantpt(s->fd) || unlockpt(s->fd)) {
+			perror("Could not create a pty");
+			return NULL;
+		}
+		tcgetattr(s->fd, &tio);
+		cfmakeraw(&tio);
+		tcsetattr(s->fd, TCSANOW, &tio);
+		fcntl(s->fd, F_SETFL, O_NONBLOCK);
+		names[i] = strdup(ptsname(s->fd));
+
+		/* Keep a slave open so that the master does not hang up between two users */
+		fd = open(names[i], O_RDWR | O_NOCTTY);
+		(void)fd;
+
+		if (faulty_every && ((i + 1) % faulty_every) == 0)
+			s->faulty = 1 + (((i + 1) / faulty_every) % 2 == 0);
+		s->trim = s->faulty == 1 ? 400 : 1000 + (i * 37) % 200;
+		s->otp_trim = 0;
+		s->bdaddr[0] = i;
+		s->bdaddr[1] = i >> 8;
+		s->bdaddr[3] = 0xCA;
+		s->bdaddr[4] = 0xEA;
+		s->bdaddr[5] = 0x80;
+	}
+	return sims;
+}
+
+int main(int argc, char **argv)
+{
+	const char *plan_name = NULL, *report_name = NULL;
+	unsigned int sim_count = 0, serve_count = 0, faulty_every = 0, jobs = 0, i, passed;
+	struct sim_dut *sims = NULL;
+	char **ports = NULL;
+	pid_t sim_pid = -1;
+	double start, elapsed;
+	FILE *report = stdout;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "f:j:o:S:D:e:")) != -1) {
+		switch (opt) {
+		case 'f':
+			plan_name = optarg;
+			break;
+		case 'j':
+			jobs = strtoul(optarg, NULL, 0);
+			break;
+		case 'o':
+			report_name = optarg;
+			break;
+		case 'S':
+			sim_count = strtoul(optarg, NULL, 0);
+			break;
+		case 'D':
+			serve_count = strtoul(optarg, NULL, 0);
+			break;
+		case 'e':
+			faulty_every = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (serve_count) {
+		char *names[MAX_DUTS];
+
+		if (serve_count > MAX_DUTS || optind != argc) {
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+		sims = sim_create(serve_count, faulty_every, names);
+		if (sims == NULL)
+			return EXIT_FAILURE;
+		for (i = 0; i < serve_count; i++)
+			printf("%s%c", names[i], i + 1 < serve_count ? ' ' : '\n');
+		fflush(stdout);
+		sim_serve(sims, serve_count);
+		return EXIT_SUCCESS;
+	}
+
+	dut_count = sim_count ? sim_count : (unsigned int)(argc - optind);
+	if (plan_name == NULL || dut_count == 0 || dut_count > MAX_DUTS ||
+	    (sim_count && optind != argc)) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+	if (load_plan(plan_name) < 0)
+		return EXIT_FAILURE;
+
+	if (sim_count) {
+		ports = calloc(sim_count, sizeof(*ports));
+		sims = ports ? sim_create(sim_count, faulty_every, ports) : NULL;
+		if (sims == NULL)
+			return EXIT_FAILURE;
+		sim_pid = fork();
+		if (sim_pid == 0) {
+			sim_serve(sims, sim_count);
+			_exit(0);
+		}
+		if (sim_pid < 0) {
+			perror("fork");
+			return EXIT_FAILURE;
+		}
+		for (i = 0; i < sim_count; i++)
+			close(sims[i].fd);
+	} else {
+		ports = argv + optind;
+	}
+
+	for (i = 0; i < dut_count; i++) {
+		duts[i].port = ports[i];
+		duts[i].fd = open_tty(ports[i]);
+		duts[i].results = calloc(plan_steps, sizeof(struct step_result));
+		if (duts[i].fd < 0 || duts[i].results == NULL)
+			return EXIT_FAILURE;
+	}
+
+	if (jobs == 0 || jobs > dut_count)
+		jobs = dut_count;
+
+	start = now_s();
+	run_station(jobs);
+	elapsed = now_s() - start;
+
+	for (i = 0; i < dut_count; i++)
+		close(duts[i].fd);
+	if (sim_pid > 0) {
+		kill(sim_pid, SIGTERM);
+		waitpid(sim_pid, NULL, 0);
+	}
+
+	if (report_name) {
+		report = fopen(report_name, "w");
+		if (report == NULL) {
+			fprintf(stderr, "Could not create %s: %s\n", report_name, strerror(errno));
+			return EXIT_FAILURE;
+		}
+	}
+	passed = write_report(report, plan_name, jobs, elapsed);
+	if (report != stdout)
+		fclose(report);
+
+	fprintf(stderr, "%u DUTs, %u passed, %u failed, %.2f s (%u at a time)\n",
+		dut_count, passed, dut_count - passed, elapsed, jobs);
+
+	return passed == dut_count ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,552 @@
+/**
+ ****************************************************************************************
+ *
+ * @file record_store_bench.c
+ *
+ * @brief Record store and RACP handling checks and latency benchmark on simulated SPI flash.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "spi_flash.h"
+#include "app_record_store.h"
+#include "record_handling.h"
+
+#define RECORD_STORE_BENCH_VERSION	"v_1.0"
+
+#define FLASH_SIZE	(APP_RECORD_STORE_DATA_OFFSET + APP_RECORD_STORE_SECTORS * SPI_FLASH_SECTOR_SIZE)
+
+static unsigned int num_records = 10000;
+static unsigned int spi_mhz = 16;
+
+static void usage(const char* my_name)
+{
+	fprintf(stderr,
+		"Version: " RECORD_STORE_BENCH_VERSION "\n"
+		"\n"
+		"Usage: %s [-n records] [-c spi_clock_mhz]\n"
+		"\n"
+		"  Runs the record store and the Record Access Control Point handling\n"
+		"  of the SDK on a simulated SPI flash. Checks appends interrupted by\n"
+		"  power failures, wrap-around and deletion, then fills the store and\n"
+		"  reports the SPI flash traffic and the estimated latency of RACP\n"
+		"  requests, next to a linear scan of all the records.\n"
+		"\n"
+		"  -n records      Records stored for the measurements (default 10000,\n"
+		"                  at most %u)\n"
+		"  -c spi_clock    SPI clock in MHz used for the estimate (default 16)\n",
+		my_name, (unsigned int) APP_RECORD_STORE_CAPACITY);
+}
+
+/*
+ * Helpers
+ */
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void payload(uint32_t time, uint8_t *data, uint8_t *len)
+{
+	*len = 4 + time % (APP_RECORD_STORE_PAYLOAD_SIZE - 3);
+	for (uint8_t i = 0; i < *len; i++)
+		data[i] = (uint8_t) (time * 31 + i * 7);
+}
+
+static bool payload_ok(const struct app_record_store_rec *rec)
+{
+	uint8_t data[APP_RECORD_STORE_PAYLOAD_SIZE];
+	uint8_t len;
+
+	payload(rec->hdr.time, data, &len);
+	return rec->hdr.len == len && !memcmp(rec->data, data, len);
+}
+
+static bool append(uint32_t time, uint32_t *seq)
+{
+	uint8_t data[APP_RECORD_STORE_PAYLOAD_SIZE];
+	uint8_t len;
+
+	payload(time, data, &len);
+	return app_record_store_append(time, data, len, false, seq) == APP_RECORD_STORE_OK;
+}
+
+static int errors;
+
+static void expect(bool ok, const char *what)
+{
+	if (!ok) {
+		printf("FAIL  %s\n", what);
+		errors++;
+	}
+}
+
+static void sec_to_date_time(uint32_t t, struct prf_date_time *dt)
+{
+	/* civil from days, the inverse of record_handling_date_time_to_sec() */
+	uint32_t z = t / 86400 + 719468;
+	uint32_t era = z / 146097;
+	uint32_t doe = z - era * 146097;
+	uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	uint32_t mp = (5 * doy + 2) / 153;
+	uint32_t m = mp < 10 ? mp + 3 : mp - 9;
+
+	dt->year = yoe + era * 400 + (m <= 2);
+	dt->month = m;
+	dt->day = doy - (153 * mp + 2) / 5 + 1;
+	dt->hour = t % 86400 / 3600;
+	dt->min = t % 3600 / 60;
+	dt->sec = t % 60;
+}
+
+/* Read all the records of the store, in sequence order */
+static uint32_t read_all(struct app_record_store_rec *out, uint32_t max)
+{
+	struct app_record_store_cursor cursor;
+	uint32_t n = 0;
+	uint16_t got;
+
+	if (app_record_store_select_seq(&cursor, APP_RECORD_STORE_OP_ALL, 0, 0) != APP_RECORD_STORE_OK)
+		return 0;
+	while (n < max && (got = app_record_store_read(&cursor, &out[n],
+			max - n > 16 ? 16 : max - n)) != 0)
+		n += got;
+	return n;
+}
+
+/*
+ * Checks
+ */
+
+static struct app_record_store_rec all[APP_RECORD_STORE_SECTORS * APP_RECORD_STORE_SLOTS];
+
+/* Appends interrupted at every point by a power failure survive the reboot */
+static void check_power_fail(void)
+{
+	static uint32_t acked[4 * APP_RECORD_STORE_SLOTS];
+	static const unsigned int base_counts[] = {
+		0, 1, APP_RECORD_STORE_SLOTS - 1, APP_RECORD_STORE_SLOTS, APP_RECORD_STORE_SLOTS + 1,
+		2 * APP_RECORD_STORE_SLOTS - 1,
+	};
+	unsigned int runs = 0;
+	unsigned int partial = 0;
+	char what[96];
+
+	for (unsigned int b = 0; b < sizeof(base_counts) / sizeof(base_counts[0]); b++) {
+		for (long budget = 0; budget < 3 * APP_RECORD_STORE_REC_SIZE + 24; budget++) {
+			uint32_t n_acked = 0;
+			uint32_t maybe = UINT32_MAX;
+			uint32_t t = 1000;
+			uint32_t n, seq, prev;
+
+			spi_flash_sim_format();
+			app_record_store_init();
+			for (unsigned int i = 0; i < base_counts[b]; i++) {
+				append(t, NULL);
+				acked[n_acked++] = t++;
+			}
+
+			spi_flash_sim_fail_after(budget);
+			for (int i = 0; i < 3 && !spi_flash_sim_failed(); i++) {
+				append(t, NULL);
+				if (spi_flash_sim_failed())
+					maybe = t;
+				else
+					acked[n_acked++] = t;
+				t++;
+			}
+
+			/* reboot */
+			spi_flash_sim_power_up();
+			app_record_store_init();
+			runs++;
+
+			n = read_all(all, sizeof(all) / sizeof(all[0]));
+			snprintf(what, sizeof(what), "power fail base %u budget %ld: %u records, %u acked",
+				 base_counts[b], budget, n, n_acked);
+			expect(n == n_acked || (n == n_acked + 1 && all[n - 1].hdr.time == maybe), what);
+			partial += (n == n_acked + 1);
+			for (uint32_t i = 0; i < n && i < n_acked; i++) {
+				snprintf(what, sizeof(what), "power fail base %u budget %ld: record %u",
+					 base_counts[b], budget, i);
+				expect(all[i].hdr.time == acked[i] && payload_ok(&all[i]), what);
+			}
+			expect(app_record_store_get_count() == n, "power fail: count after reboot");
+
+			/* the store goes on after the reboot */
+			prev = n ? all[n - 1].hdr.seq : 0;
+			for (int i = 0; i < 4; i++) {
+				expect(append(t, &seq) && (n + i == 0 || seq > prev), "power fail: append after reboot");
+				prev = seq;
+				t++;
+			}
+			app_record_store_init();
+			expect(read_all(all, sizeof(all) / sizeof(all[0])) == n + 4, "power fail: reload after reboot");
+		}
+	}
+	printf("Power failure: %u interrupted appends, %u found complete after the reboot\n", runs, partial);
+}
+
+/* The oldest sector is reused once the store is full, 16-bit sequence numbers wrap */
+static void check_wrap(void)
+{
+	struct app_record_store_cursor cursor;
+	struct glp_filter filter;
+	uint32_t total = 0x10000 + 3 * APP_RECORD_STORE_SLOTS + 7;
+	uint32_t seq = 0;
+	uint32_t n;
+
+	spi_flash_sim_format();
+	app_record_store_init();
+	for (uint32_t i = 0; i < total; i++)
+		append(i, &seq);
+	app_record_store_init();
+
+	n = read_all(all, sizeof(all) / sizeof(all[0]));
+	expect(n >= APP_RECORD_STORE_CAPACITY && n <= APP_RECORD_STORE_SECTORS * APP_RECORD_STORE_SLOTS,
+	       "wrap: number of records");
+	expect(n && all[n - 1].hdr.seq == seq && all[n - 1].hdr.time == total - 1, "wrap: last record");
+	for (uint32_t i = 1; i < n; i++) {
+		if (all[i].hdr.seq != all[i - 1].hdr.seq + 1 || !payload_ok(&all[i])) {
+			expect(false, "wrap: records in sequence");
+			break;
+		}
+	}
+
+	/* the 16-bit sequence numbers of the RACP select the most recent records */
+	filter.operator = GLP_OP_GT_OR_EQ;
+	filter.filter_type = GLP_FILTER_SEQ_NUMBER;
+	filter.val.seq_num.min = (uint16_t) (seq - 9);
+	expect(record_handling_glp_select(&filter, &cursor) == GLP_RSP_SUCCESS &&
+	       record_handling_count(&cursor) == 10, "wrap: GLP sequence number >= last - 9");
+	filter.operator = GLP_OP_WITHIN_RANGE_OF;
+	filter.val.seq_num.min = (uint16_t) (seq - 20);
+	filter.val.seq_num.max = (uint16_t) (seq - 11);
+	expect(record_handling_glp_select(&filter, &cursor) == GLP_RSP_SUCCESS &&
+	       record_handling_count(&cursor) == 10 && cursor.seq == seq - 20,
+	       "wrap: GLP sequence number range");
+}
+
+static uint32_t brute_count(const uint32_t *times, const bool *live, uint32_t n, uint32_t min, uint32_t max)
+{
+	uint32_t count = 0;
+
+	for (uint32_t i = 0; i < n; i++)
+		count += live[i] && times[i] >= min && times[i] <= max;
+	return count;
+}
+
+/* Time selections of records not appended in time order, CGM time offsets, deletion */
+static void check_unordered(void)
+{
+	enum { N = 5 * APP_RECORD_STORE_SLOTS / 2 };
+	static uint32_t times[N];
+	static bool live[N];
+	struct app_record_store_cursor cursor;
+	struct cgm_filter filter;
+	char what[96];
+	uint32_t n;
+
+	spi_flash_sim_format();
+	app_record_store_init();
+	srand(1);
+	for (uint32_t i = 0; i < N; i++) {
+		times[i] = rand() % 60000;
+		live[i] = true;
+		append(times[i], NULL);
+	}
+
+	filter.filter_type = CGM_FILTER_TIME_OFFSET;
+	for (int i = 0; i < 200; i++) {
+		uint16_t a = rand() % 60000;
+		uint16_t b = rand() % 60000;
+		uint32_t got = 0;
+		uint8_t status;
+
+		filter.operator = CGM_OP_LT_OR_EQ + i % 3;
+		filter.val.time_offset.min = a < b ? a : b;
+		filter.val.time_offset.max = a < b ? b : a;
+		status = record_handling_cgm_select(&filter, &cursor);
+		if (status == CGM_RSP_SUCCESS)
+			got = record_handling_count(&cursor);
+		else
+			expect(status == CGM_RSP_NO_RECS_FOUND, "unordered: CGM select status");
+
+		snprintf(what, sizeof(what), "unordered: CGM time offset operator %u [%u, %u]",
+			 filter.operator, filter.val.time_offset.min, filter.val.time_offset.max);
+		switch (filter.operator) {
+		case CGM_OP_LT_OR_EQ:
+			expect(got == brute_count(times, live, N, 0, filter.val.time_offset.max), what);
+			break;
+		case CGM_OP_GT_OR_EQ:
+			expect(got == brute_count(times, live, N, filter.val.time_offset.min, UINT32_MAX), what);
+			break;
+		default:
+			expect(got == brute_count(times, live, N, filter.val.time_offset.min,
+						  filter.val.time_offset.max), what);
+			break;
+		}
+
+		/* delete some of the selections */
+		if (status == CGM_RSP_SUCCESS && i % 20 == 19) {
+			uint32_t min = filter.operator == CGM_OP_LT_OR_EQ ? 0 : filter.val.time_offset.min;
+			uint32_t max = filter.operator == CGM_OP_GT_OR_EQ ? UINT32_MAX : filter.val.time_offset.max;
+
+			expect(app_record_store_delete(&cursor) == APP_RECORD_STORE_OK, "unordered: delete");
+			for (uint32_t j = 0; j < N; j++)
+				if (times[j] >= min && times[j] <= max)
+					live[j] = false;
+		}
+	}
+
+	app_record_store_init();
+	n = read_all(all, sizeof(all) / sizeof(all[0]));
+	expect(n == brute_count(times, live, N, 0, UINT32_MAX) && n == app_record_store_get_count(),
+	       "unordered: records left after reload");
+
+	filter.operator = 7;
+	expect(record_handling_cgm_select(&filter, &cursor) == CGM_RSP_INVALID_OPERATOR, "CGM invalid operator");
+	filter.operator = CGM_OP_WITHIN_RANGE_OF;
+	filter.filter_type = 2;
+	expect(record_handling_cgm_select(&filter, &cursor) == CGM_RSP_OPERAND_NOT_SUP, "CGM unsupported filter");
+	filter.filter_type = CGM_FILTER_TIME_OFFSET;
+	filter.val.time_offset.min = 2;
+	filter.val.time_offset.max = 1;
+	expect(record_handling_cgm_select(&filter, &cursor) == CGM_RSP_INVALID_OPERAND, "CGM inverted range");
+}
+
+/*
+ * RACP latency
+ */
+
+static void io_reset(void)
+{
+	spi_flash_sim_clear_stats();
+}
+
+static void report(const char *name, uint32_t result, uint64_t ns)
+{
+	const spi_flash_sim_stats_t *io = spi_flash_sim_stats();
+
+	printf("%-42s %6u %7llu %8llu %10.1f %8.1f\n", name, result,
+	       (unsigned long long) io->rd_ops, (unsigned long long) io->rd_bytes,
+	       io->bus_us + io->busy_us, ns / 1000.0);
+}
+
+/* Linear scan of every slot, one record per SPI flash access */
+static uint32_t linear_scan(uint32_t sectors, uint32_t min_time, uint32_t max_time)
+{
+	struct app_record_store_rec rec;
+	uint32_t actual_size;
+	uint32_t count = 0;
+
+	for (uint32_t s = 0; s < sectors; s++) {
+		uint32_t offset = APP_RECORD_STORE_DATA_OFFSET + s * SPI_FLASH_SECTOR_SIZE +
+				  sizeof(struct app_record_store_sector_hdr);
+
+		for (uint32_t i = 0; i < APP_RECORD_STORE_SLOTS; i++) {
+			spi_flash_read_data((uint8_t *) &rec, offset + i * APP_RECORD_STORE_REC_SIZE,
+					    sizeof(rec), &actual_size);
+			count += rec.hdr.commit == 0x5A && rec.hdr.deleted == 0xFF &&
+				 rec.hdr.time >= min_time && rec.hdr.time <= max_time;
+		}
+	}
+	return count;
+}
+
+static void run_bench(void)
+{
+	/* one reading every 5 minutes from 1 March 2024 */
+	const uint32_t t0 = 1709251200;
+	const uint32_t period = 300;
+	struct app_record_store_cursor cursor;
+	const struct app_record_store_rec *rec;
+	struct glp_filter filter;
+	uint32_t last_seq = 0;
+	uint32_t n, ok;
+	uint64_t t;
+
+	spi_flash_sim_format();
+	app_record_store_init();
+	for (uint32_t i = 0; i < num_records; i++)
+		append(t0 + i * period, &last_seq);
+
+	printf("\n%u records of %u bytes in %u sectors, %u slots per sector, SPI clock %u MHz\n",
+	       num_records, (unsigned int) APP_RECORD_STORE_REC_SIZE, (unsigned int) APP_RECORD_STORE_SECTORS,
+	       (unsigned int) APP_RECORD_STORE_SLOTS, spi_mhz);
+	printf("%-42s %6s %7s %8s %10s %8s\n", "", "result", "reads", "bytes", "est. us", "host us");
+
+	io_reset();
+	t = now_ns();
+	app_record_store_init();
+	report("Boot: load store and build index", app_record_store_get_count(), now_ns() - t);
+
+	io_reset();
+	t = now_ns();
+	filter.operator = GLP_OP_ALL_RECS;
+	record_handling_glp_select(&filter, &cursor);
+	n = record_handling_count(&cursor);
+	report("Number of records, all", n, now_ns() - t);
+	expect(n == num_records, "count all");
+
+	io_reset();
+	t = now_ns();
+	filter.operator = GLP_OP_GT_OR_EQ;
+	filter.filter_type = GLP_FILTER_SEQ_NUMBER;
+	filter.val.seq_num.min = (uint16_t) (last_seq - 99);
+	record_handling_glp_select(&filter, &cursor);
+	n = record_handling_count(&cursor);
+	report("Number of records, seq >= last - 99", n, now_ns() - t);
+	expect(n == 100, "count seq >= last - 99");
+
+	io_reset();
+	t = now_ns();
+	filter.operator = GLP_OP_WITHIN_RANGE_OF;
+	filter.filter_type = GLP_FILTER_USER_FACING_TIME;
+	sec_to_date_time(t0 + num_records / 2 * period, &filter.val.time.facetime_min);
+	sec_to_date_time(t0 + num_records / 2 * period + 86400 - 1, &filter.val.time.facetime_max);
+	record_handling_glp_select(&filter, &cursor);
+	n = record_handling_count(&cursor);
+	report("Number of records, one day by time", n, now_ns() - t);
+	expect(n == 86400 / period, "count one day");
+
+	io_reset();
+	t = now_ns();
+	ok = record_handling_glp_select(&filter, &cursor) == GLP_RSP_SUCCESS;
+	record_handling_report_start(&cursor);
+	for (n = 0; (rec = record_handling_report_next()) != NULL; n++)
+		ok &= rec->hdr.time == t0 + num_records / 2 * period + n * period && payload_ok(rec);
+	report("Report records, one day by time", n, now_ns() - t);
+	expect(ok && n == 86400 / period, "report one day");
+
+	io_reset();
+	t = now_ns();
+	filter.operator = GLP_OP_LAST_REC;
+	ok = record_handling_glp_select(&filter, &cursor) == GLP_RSP_SUCCESS;
+	record_handling_report_start(&cursor);
+	for (n = 0; (rec = record_handling_report_next()) != NULL; n++)
+		ok &= rec->hdr.seq == last_seq;
+	report("Report last record", n, now_ns() - t);
+	expect(ok && n == 1, "report last record");
+
+	io_reset();
+	t = now_ns();
+	filter.operator = GLP_OP_GT_OR_EQ;
+	filter.filter_type = GLP_FILTER_SEQ_NUMBER;
+	filter.val.seq_num.min = (uint16_t) (last_seq - 99);
+	ok = record_handling_glp_select(&filter, &cursor) == GLP_RSP_SUCCESS;
+	record_handling_report_start(&cursor);
+	for (n = 0; (rec = record_handling_report_next()) != NULL; n++)
+		ok &= rec->hdr.seq == last_seq - 99 + n;
+	report("Report records, seq >= last - 99", n, now_ns() - t);
+	expect(ok && n == 100, "report seq >= last - 99");
+
+	io_reset();
+	t = now_ns();
+	filter.operator = GLP_OP_ALL_RECS;
+	ok = record_handling_glp_select(&filter, &cursor) == GLP_RSP_SUCCESS;
+	record_handling_report_start(&cursor);
+	for (n = 0; (rec = record_handling_report_next()) != NULL; n++)
+		ok &= payload_ok(rec);
+	report("Report all records", n, now_ns() - t);
+	expect(ok && n == num_records, "report all");
+
+	io_reset();
+	t = now_ns();
+	n = linear_scan((num_records + APP_RECORD_STORE_SLOTS - 1) / APP_RECORD_STORE_SLOTS,
+			t0 + num_records / 2 * period, t0 + num_records / 2 * period + 86400 - 1);
+	report("Linear scan, one day by time", n, now_ns() - t);
+	expect(n == 86400 / period, "linear scan one day");
+
+	io_reset();
+	t = now_ns();
+	filter.operator = GLP_OP_LT_OR_EQ;
+	filter.filter_type = GLP_FILTER_SEQ_NUMBER;
+	filter.val.seq_num.max = (uint16_t) (last_seq - num_records / 2);
+	ok = record_handling_glp_select(&filter, &cursor) == GLP_RSP_SUCCESS &&
+	     app_record_store_delete(&cursor) == APP_RECORD_STORE_OK;
+	report("Delete records, seq <= last - n/2", ok, now_ns() - t);
+	printf("%-42s %6llu flash writes, %llu erases\n", "",
+	       (unsigned long long) spi_flash_sim_stats()->wr_bytes,
+	       (unsigned long long) spi_flash_sim_stats()->erase_ops);
+	app_record_store_init();
+	expect(ok && app_record_store_get_count() == num_records / 2, "delete seq <= last - n/2");
+}
+
+int main(int argc, char **argv)
+{
+	spi_flash_sim_timing_t timing;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:c:")) != -1) {
+		switch (opt) {
+		case 'n':
+			num_records = strtoul(optarg, NULL, 0);
+			break;
+		case 'c':
+			spi_mhz = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	if (optind != argc || num_records < 200 || num_records > APP_RECORD_STORE_CAPACITY || spi_mhz == 0) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	spi_flash_sim_init(FLASH_SIZE);
+	timing = *spi_flash_sim_timing();
+	timing.spi_mhz = spi_mhz;
+	spi_flash_sim_set_timing(&timing);
+
+	check_power_fail();
+	check_wrap();
+	check_unordered();
+	run_bench();
+
+	if (errors) {
+		printf("\nFAILED, %d errors\n", errors);
+		return EXIT_FAILURE;
+	}
+	printf("\nOK\n");
+
+	return EXIT_SUCCESS;
+}
@@ -49,6 +49,24 @@
 /****************************************************************************************************************/
 #define ONE_WIRE_UART_SUPPORTED
 
+/****************************************************************************************************************/
+/* Framed boot protocol over the 2-wire UART: large blocks with sequence number and CRC32, selective            */
+/* retransmission and a negotiated baud rate. The STX/SOH protocol remains available. Refer to uart_booter.h.   */
+/* The blocks are received with DMA, so CFG_UART_DMA_SUPPORT must be defined as well.                           */
+/****************************************************************************************************************/
+#undef CFG_UART_FRAMED_BOOT
+
+/****************************************************************************************************************/
+/* Compressed images over the STX/SOH UART protocols: an image made by "mkimage compress" is decoded while it   */
+/* is received. Plain images are still accepted. Refer to uart_booter.h.                                        */
+/****************************************************************************************************************/
+#undef CFG_UART_COMPRESSED_BOOT
+
+/****************************************************************************************************************/
+/* Enables/Disables the DMA Support for the UART interface                                                      */
+/****************************************************************************************************************/
+#undef CFG_UART_DMA_SUPPORT
+
 /****************************************************************************************************************/
 /* SPI flash memory support                                                                                     */
 /****************************************************************************************************************/
@@ -34,6 +34,12 @@
 #ifndef _DECRYPT_H
 #define _DECRYPT_H
 
+#include <stdint.h>
+
 void Decrypt_Image(int nsize);
 
+void Decrypt_Init(void);
+
+void Decrypt_Chunk(uint8_t *buf, int nsize);
+
 #endif
@@ -44,7 +44,79 @@
 #define SYSRAM_BASE_ADDRESS         (SDK_RAM_1_BASE_ADDR)
 #define SOH     (0x01)
 #define STX     (0x02)
+#define EOT     (0x04)
 #define ACK     (0x06)
+#define SOB     (0x11)
 #define NAK     (0x15)
+#define CAN     (0x18)
+
+/*
+ * Framed boot protocol (2-wire UART, CFG_UART_FRAMED_BOOT)
+ *
+ * The host answers STX with SOB instead of SOH, followed by the header:
+ *     size[4] block_log2[1] baud[1] image_crc[4] header_crc[4]
+ * (little endian, header_crc is the CRC32 of the 10 bytes before it).
+ * The device answers ACK baud[1] window[1] with the accepted baud rate index and the
+ * number of frames the host may send ahead, or NAK. Both sides then switch to the
+ * accepted baud rate and the host sends the image in blocks of (1 << block_log2) bytes
+ * (the last one may be shorter), in any order, each one as a frame:
+ *     seq[2] ~seq[2] payload[] crc[4]
+ * where crc is the CRC32 of seq[2] and the payload. The device answers each frame with
+ * ACK seq[2] or NAK seq[2]. The host sends again the frames that were not acknowledged.
+ * NAK 0xFFFF means that the framing was lost, or that no frame has arrived within the
+ * frame timeout: the device has waited for the line to become idle and the host must send
+ * again all the frames it has not received an answer for. The device gives up after a
+ * few of these in a row without a good frame in between. When all blocks have been
+ * received, the device answers EOT 0x0000 if the CRC32 of the image matches image_crc,
+ * CAN 0x0000 otherwise.
+ */
+#if defined (CFG_UART_FRAMED_BOOT)
+#define USE_UART_FRAMED_BOOT                (1)
+#else
+#define USE_UART_FRAMED_BOOT                (0)
+#endif
+
+#if (USE_UART_FRAMED_BOOT) && !defined (CFG_UART_DMA_SUPPORT)
+    #error "CFG_UART_FRAMED_BOOT requires CFG_UART_DMA_SUPPORT."
+#endif
+
+/// Block size limits of the framed boot protocol (log2)
+#define FRAMED_BLOCK_LOG2_MIN               (8)
+#define FRAMED_BLOCK_LOG2_MAX               (12)
+
+/// Baud rate indexes of the framed boot protocol
+enum
+{
+    /// Keep the baud rate of the STX/SOH handshake
+    FRAMED_BAUD_KEEP = 0,
+    FRAMED_BAUD_115200,
+    FRAMED_BAUD_230400,
+    FRAMED_BAUD_460800,
+    FRAMED_BAUD_921600,
+    FRAMED_BAUD_1000000,
+    FRAMED_BAUD_MAX,
+};
+
+/// Sequence number of the NAK sent when the framing is lost
+#define FRAMED_SEQ_RESYNC                   (0xFFFF)
+
+/*
+ * Compressed images (STX/SOH protocol, CFG_UART_COMPRESSED_BOOT)
+ *
+ * When the first byte of the image is LZSS_MAGIC0, the image is an LZSS stream made by
+ * "mkimage compress" (refer to lzss.h). The length sent after SOH is the length of the
+ * stream and the XOR checksum is computed over the stream bytes, as for a plain image.
+ * The stream is decoded while it is received, directly into SYSRAM_COPY_BASE_ADDRESS.
+ * If the stream is corrupted, its CRC32 does not match or the decoded image does not
+ * fit into MAX_CODE_LENGTH, the device sends the complement of the XOR checksum, so that
+ * the host sees a checksum error, and the download fails.
+ * The framed protocol does not accept compressed images, because its blocks may arrive
+ * in any order.
+ */
+#if defined (CFG_UART_COMPRESSED_BOOT)
+#define USE_UART_COMPRESSED_BOOT            (1)
+#else
+#define USE_UART_COMPRESSED_BOOT            (0)
+#endif
 
 #endif
@@ -90,7 +90,7 @@ static int FlashRead(unsigned long destination_buffer, unsigned long source_addr
 #if defined (CFG_SPI_DMA_SUPPORT)
     spi_flash_read_data_dma((uint8_t*)destination_buffer, source_addr, len, &actual_length);
 #else
-    spi_flash_read_data((uint8_t*)destination_buffer, source_addr, len, &actual_length);
+    spi_flash_read_data_buffer((uint8_t*)destination_buffer, source_addr, len, &actual_length);
 #endif
     return 0;
 #else
@@ -198,7 +198,7 @@ static bool imageHeaderValidityCheck(s_imageHeader *imgHeader)
 uint8_t imageGetActive(uint32_t imageAddress1, uint32_t imageAddress2, uint8_t *pvalid_images)
 {
     uint8_t valid_images = 0;
-    uint8_t imageId[2];
+    uint8_t imageId[2] = {0, 0};
     s_imageHeader ImageHeader;
     s_imageHeader *pImageHeader;
 
@@ -230,6 +230,126 @@ uint8_t imageGetActive(uint32_t imageAddress1, uint32_t imageAddress2, uint8_t *
     return findlatest(imageId[0], imageId[1]) - 1;
 }
 
+#if defined (SPI_FLASH_SUPPORTED) && defined (CFG_SPI_DMA_SUPPORT)
+// Size of the chunks in which an image is streamed into SYSRAM (multiple of AES_BLOCKSIZE)
+#define IMAGE_LOAD_CHUNK_SIZE       (1024)
+
+/**
+ ****************************************************************************************
+ * @brief Return the length of the chunk of an image starting at offset
+ * @param[in] code_size: the size of the image
+ * @param[in] offset: the offset of the chunk inside the image
+ * @return The length of the chunk
+ ****************************************************************************************
+ */
+static uint32_t imageChunkLength(uint32_t code_size, uint32_t offset)
+{
+    uint32_t remaining = code_size - offset;
+
+    return (remaining < IMAGE_LOAD_CHUNK_SIZE) ? remaining : IMAGE_LOAD_CHUNK_SIZE;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Decrypt (if needed) a chunk of an image that has just been loaded to SYSRAM and
+ *        add it to the running CRC
+ * @param[in] chunk: the chunk in SYSRAM
+ * @param[in] len: the length of the chunk
+ * @param[in] decrypt: true if the chunk must be decrypted in place first
+ * @param[in] crc: the CRC of the image up to this chunk
+ * @return The CRC of the image including this chunk
+ ****************************************************************************************
+ */
+static uint32_t imageProcessChunk(uint8_t *chunk, uint32_t len, bool decrypt, uint32_t crc)
+{
+#if AES_ENCRYPTED_IMAGE_SUPPORTED
+    if (decrypt)
+    {
+        Decrypt_Chunk(chunk, len);
+    }
+#endif
+    return crc32(crc, chunk, len);
+}
+#endif // SPI_FLASH_SUPPORTED && CFG_SPI_DMA_SUPPORT
+
+/**
+ ****************************************************************************************
+ * @brief Load an image from the external memory to SYSRAM and return its CRC
+ * @details With SPI DMA support the whole image is read with one flash read command in
+ *          IMAGE_LOAD_CHUNK_SIZE chunks. Every chunk is decrypted and added to the CRC
+ *          while the DMA transfer of the next chunk runs. Without it the read cannot
+ *          overlap with the processing, so the image is read at once and then decrypted
+ *          and checked as a whole.
+ * @param[in] source_addr: the address of the image code in the external memory
+ * @param[in] code_size: the size of the image code
+ * @param[in] decrypt: true if the image must be decrypted
+ * @return The CRC32 of the (decrypted) image
+ ****************************************************************************************
+ */
+static uint32_t imageStreamLoad(uint32_t source_addr, uint32_t code_size, bool decrypt)
+{
+    uint8_t *dst = (uint8_t *)SYSRAM_BASE_ADDRESS;
+    uint32_t crc = 0;
+
+#if defined (SPI_FLASH_SUPPORTED) && defined (CFG_SPI_DMA_SUPPORT)
+    uint32_t offset;
+    uint32_t len;
+
+  #if AES_ENCRYPTED_IMAGE_SUPPORTED
+    if (decrypt)
+    {
+        Decrypt_Init();
+    }
+  #endif
+
+    if (spi_flash_is_busy() != SPI_FLASH_ERR_OK)
+    {
+        // Let the CRC check fail, so that the other image is tried
+        return ~crc;
+    }
+
+    // Send one sequential read command for the whole image
+    spi_set_bitmode(SPI_MODE_32BIT);
+    spi_cs_low();
+    spi_access((SPI_FLASH_OP_READ << 24) | source_addr);
+    spi_set_bitmode(SPI_MODE_8BIT);
+
+    if (code_size)
+    {
+        spi_receive(dst, imageChunkLength(code_size, 0), SPI_OP_DMA);
+    }
+
+    for (offset = 0; offset < code_size; offset += len)
+    {
+        len = imageChunkLength(code_size, offset);
+        spi_wait_dma_read_to_finish();
+
+        // Kick off the next chunk before processing the current one
+        if (offset + len < code_size)
+        {
+            spi_receive(dst + offset + len, imageChunkLength(code_size, offset + len), SPI_OP_DMA);
+        }
+
+        crc = imageProcessChunk(dst + offset, len, decrypt, crc);
+    }
+
+    spi_cs_high();
+#else
+    FlashRead((unsigned long)dst, (unsigned long)source_addr, (unsigned long)code_size);
+
+  #if AES_ENCRYPTED_IMAGE_SUPPORTED
+    if (decrypt)
+    {
+        Decrypt_Image(code_size);
+    }
+  #endif
+
+    crc = crc32(crc, dst, code_size);
+#endif
+
+    return crc;
+}
+
 /**
  ****************************************************************************************
  * @brief Load the active (latest and valid) image from a non-volatile memory
@@ -264,31 +384,34 @@ static int loadActiveImage(void)
     imageOffsets[1] = ProductHeader->offset2;   
     
     activeImageIdx = imageGetActive(imageOffsets[0], imageOffsets[1], &images_status);
+
+    // No image has a valid header
+    if (images_status == 0)
+    {
+        return -1;
+    }
     
     ImageHeader = (s_imageHeader *)flashbuffer;
     
     while (1) {
+        bool decrypt = false;
+
         // Get the image header of the current active marked image
         imageHeaderRead(imageOffsets[activeImageIdx], ImageHeader);
-        
-        // Read the whole image from the external memory into RAM
-        FlashRead(SYSRAM_BASE_ADDRESS,
-                  (unsigned long) imageOffsets[activeImageIdx] + CODE_OFFSET,
-                  (unsigned long) ImageHeader->code_size);
-                  
+
   #if AES_ENCRYPTED_IMAGE_SUPPORTED
     #if AES_ENCRYPTED_IMAGE_CHECK_ENCRYPTION_FLAG
-        if (ImageHeader->encryption)
+        decrypt = (ImageHeader->encryption != 0);
+    #else
+        decrypt = true;
     #endif
-        {
-            // Decrypt the copied image
-            Decrypt_Image(ImageHeader->code_size);
-        }
   #endif
-        
+
         // Check if the CRC of the image is not valid compared to the one we calculated
+        // while loading (and decrypting) the image from the external memory into RAM
         if ((ImageHeader->encryption && !AES_ENCRYPTED_IMAGE_SUPPORTED) ||
-            (ImageHeader->CRC != crc32(0, (uint8_t*)SYSRAM_BASE_ADDRESS, ImageHeader->code_size)))
+            (ImageHeader->CRC != imageStreamLoad(imageOffsets[activeImageIdx] + CODE_OFFSET,
+                                                 ImageHeader->code_size, decrypt)))
         {
   #if INVALIDATE_BAD_IMAGES
             // Before moving on, invalidate this bad image's 'validflag' field
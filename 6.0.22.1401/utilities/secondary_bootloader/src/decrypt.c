@@ -33,6 +33,7 @@
 
 #include "sw_aes.h"
 #include "uart_booter.h"
+#include "decrypt.h"
 #if !defined (__DA14531__)
 #include "datasheet.h"
 #endif
@@ -50,8 +51,7 @@ const uint8_t IV[16] = {0x3d,0xaf,0xba,0x42,0x9d,0x9e,0xb4,0x30,0xb4,0x22,0xda,0
  */
 void Decrypt_Image(int nsize)
 {
-    AES_set_key(&ctx,Key,IV,AES_MODE_128);
-    AES_convert_key(&ctx);
+    Decrypt_Init();
 #if defined (__DA14531__)
     AES_cbc_decrypt(&ctx, (const uint8_t *)SYSRAM_BASE_ADDRESS, (uint8_t *)SYSRAM_BASE_ADDRESS, nsize);
 #else
@@ -60,9 +60,36 @@ void Decrypt_Image(int nsize)
 
     for (int i = nsize; i >= 0; i -= DECRYPT_CHUNK)
     {
-        AES_cbc_decrypt(&ctx, (const uint8_t *)sys_ram, sys_ram, DECRYPT_CHUNK);
-        SetWord16(WATCHDOG_REG, WATCHDOG_REG_RESET);
+        Decrypt_Chunk(sys_ram, DECRYPT_CHUNK);
         sys_ram += DECRYPT_CHUNK;
     }
 #endif
 }
+
+/**
+ ****************************************************************************************
+ * @brief Prepares the AES context for a chunked decryption of an image.
+ ****************************************************************************************
+ */
+void Decrypt_Init(void)
+{
+    AES_set_key(&ctx,Key,IV,AES_MODE_128);
+    AES_convert_key(&ctx);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Decrypts the next chunk of an image in place. The CBC chaining value is kept
+ *        in the AES context between calls.
+ * @param[in] buf   the chunk to decrypt
+ * @param[in] nsize the size of the chunk which is expected to be a multiple
+ *                  of AES_BLOCKSIZE.
+ ****************************************************************************************
+ */
+void Decrypt_Chunk(uint8_t *buf, int nsize)
+{
+    AES_cbc_decrypt(&ctx, (const uint8_t *)buf, buf, nsize);
+#if !defined (__DA14531__)
+    SetWord16(WATCHDOG_REG, WATCHDOG_REG_RESET);
+#endif
+}
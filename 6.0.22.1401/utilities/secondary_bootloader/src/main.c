@@ -108,6 +108,10 @@ static const uart_cfg_t uart_cfg =
     .intr_priority = 2,
     .uart_rx_cb = uart_receive_callback,
     .uart_err_cb = uart_error_callback,
+#if defined (CFG_UART_DMA_SUPPORT)
+    .uart_dma_channel = UART_DMA_CHANNEL_01,
+    .uart_dma_priority = DMA_PRIO_0,
+#endif
 };
 #endif
 
@@ -38,6 +38,12 @@
 #include "gpio.h"
 #include "uart.h"
 #include "systick.h"
+#if defined (UART_SUPPORTED) && (USE_UART_FRAMED_BOOT)
+#include "dma.h"
+#endif
+#if (USE_UART_COMPRESSED_BOOT)
+#include "lzss.h"
+#endif
 
 #if defined (UART_SUPPORTED) || defined (ONE_WIRE_UART_SUPPORTED)
 
@@ -53,13 +59,27 @@ static void systick_callback(void)
 }
 
 static volatile bool received = false;
+
+#if defined (UART_SUPPORTED) && (USE_UART_FRAMED_BOOT)
+static void framed_rx_callback(void);
+
+static bool framed_active;
+#endif
+
 /**
  ****************************************************************************************
  * @brief callback UART receiver
  ****************************************************************************************
  */
-void uart_receive_callback(void)
+void uart_receive_callback(uint16_t length)
 {
+#if defined (UART_SUPPORTED) && (USE_UART_FRAMED_BOOT)
+    if (framed_active)
+    {
+        framed_rx_callback();
+        return;
+    }
+#endif
     received = true;
 }
 
@@ -105,6 +125,464 @@ static int uart_receive_byte(uint8_t *recv_byte)
 }
 
 
+#if defined (UART_SUPPORTED) && (USE_UART_FRAMED_BOOT)
+extern uint32_t crc32(uint32_t crc, const void *buf, size_t size);
+
+/// Frames received and not checked yet, also the number of frames the host may send ahead
+#define FRAMED_QUEUE_SIZE           (4)
+
+/// Line idle time (us) after which the framing is restarted
+#define FRAMED_RESYNC_IDLE_US       (20000)
+
+/// Resyncs in a row, without a good frame in between, after which the download is aborted
+#define FRAMED_MAX_RESYNCS          (8)
+
+/// Maximum number of blocks of an image
+#define FRAMED_MAX_BLOCKS           ((MAX_CODE_LENGTH >> FRAMED_BLOCK_LOG2_MIN) + 1)
+
+/// Baud rates of the framed boot protocol, indexed by FRAMED_BAUD_xxx
+static const UART_BAUDRATE framed_baud_rates[FRAMED_BAUD_MAX] =
+{
+    UART_FRAC_BAUDRATE,
+    UART_BAUDRATE_115200,
+    UART_BAUDRATE_230400,
+    UART_BAUDRATE_460800,
+    UART_BAUDRATE_921600,
+    UART_BAUDRATE_1000000,
+};
+
+/// Bit rates used for the reception timeouts (57600 is the lowest handshake baud rate)
+static const uint32_t framed_bit_rates[FRAMED_BAUD_MAX] =
+{
+    57600, 115200, 230400, 460800, 921600, 1000000,
+};
+
+/// Frame reception states
+enum framed_rx_state
+{
+    /// Receiving seq[2] ~seq[2]
+    FRAMED_RX_HEADER,
+    /// Receiving the payload into SYSRAM
+    FRAMED_RX_PAYLOAD,
+    /// Receiving crc[4]
+    FRAMED_RX_CRC,
+    /// Reception stopped (framing lost, or all blocks received)
+    FRAMED_RX_STOPPED,
+};
+
+static struct
+{
+    /// Image in SYSRAM
+    uint8_t *image;
+    /// Image size
+    uint32_t size;
+    /// Number of blocks
+    uint16_t blocks;
+    /// Block size (log2)
+    uint8_t block_log2;
+    /// Reception state
+    volatile uint8_t state;
+    /// Header of the frame being received
+    uint8_t header[4];
+    /// Block of the frame being received
+    uint16_t seq;
+    /// Received frames (block and CRC) to be checked
+    uint16_t queue_seq[FRAMED_QUEUE_SIZE];
+    uint32_t queue_crc[FRAMED_QUEUE_SIZE];
+    volatile uint8_t queue_in;
+    volatile uint8_t queue_out;
+    /// Incremented on every reception step, to restart the timeout
+    volatile uint8_t events;
+} framed;
+
+/**
+ ****************************************************************************************
+ * @brief Get the length of a block.
+ * @param[in] seq The block
+ * @return The block length
+ ****************************************************************************************
+ */
+static uint16_t framed_block_len(uint16_t seq)
+{
+    uint32_t offset = (uint32_t) seq << framed.block_log2;
+
+    if (framed.size - offset < (1UL << framed.block_log2))
+    {
+        return framed.size - offset;
+    }
+    return 1UL << framed.block_log2;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Frame reception state machine, called when a reception step has finished.
+ * @details The next step is started right away from the DMA interrupt, so that the
+ * payload of the next frame lands in SYSRAM while the previous one is checked.
+ ****************************************************************************************
+ */
+static void framed_rx_callback(void)
+{
+    uint16_t inv;
+
+    framed.events++;
+
+    switch (framed.state)
+    {
+        case FRAMED_RX_HEADER:
+            framed.seq = framed.header[0] | (framed.header[1] << 8);
+            inv = framed.header[2] | (framed.header[3] << 8);
+            if (((framed.seq ^ inv) != 0xFFFF) || (framed.seq >= framed.blocks))
+            {
+                // Framing lost
+                framed.state = FRAMED_RX_STOPPED;
+                break;
+            }
+            framed.state = FRAMED_RX_PAYLOAD;
+            uart_receive(UART1, framed.image + ((uint32_t) framed.seq << framed.block_log2),
+                         framed_block_len(framed.seq), UART_OP_DMA);
+            break;
+
+        case FRAMED_RX_PAYLOAD:
+            // The host never sends more frames ahead than the queue can hold
+            framed.queue_seq[framed.queue_in % FRAMED_QUEUE_SIZE] = framed.seq;
+            framed.state = FRAMED_RX_CRC;
+            uart_receive(UART1, (uint8_t *) &framed.queue_crc[framed.queue_in % FRAMED_QUEUE_SIZE],
+                         sizeof(uint32_t), UART_OP_DMA);
+            break;
+
+        case FRAMED_RX_CRC:
+            framed.queue_in++;
+            framed.state = FRAMED_RX_HEADER;
+            uart_receive(UART1, framed.header, sizeof(framed.header), UART_OP_DMA);
+            break;
+
+        default:
+            break;
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Send an answer of the framed boot protocol.
+ * @param[in] code  ACK, NAK, EOT or CAN
+ * @param[in] value The sequence number or the value of the answer
+ ****************************************************************************************
+ */
+static void framed_answer(uint8_t code, uint16_t value)
+{
+    uint8_t answer[3] = {code, value & 0xFF, value >> 8};
+
+    uart_write_buffer(UART1, answer, sizeof(answer));
+}
+
+/**
+ ****************************************************************************************
+ * @brief Receive a buffer byte by byte, with the timeout of uart_receive_byte().
+ * @param[out] buf Pointer to the buffer
+ * @param[in] len  Number of bytes
+ * @return 1 on success, 0 on failure.
+ ****************************************************************************************
+ */
+static int uart_receive_bytes(uint8_t *buf, uint16_t len)
+{
+    while (len--)
+    {
+        if (0 == uart_receive_byte(buf++))
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Discard the received bytes until the line is idle for FRAMED_RESYNC_IDLE_US.
+ ****************************************************************************************
+ */
+static void framed_drain(void)
+{
+    timeout = false;
+    systick_register_callback(systick_callback);
+    systick_start(FRAMED_RESYNC_IDLE_US, true);
+    while (!timeout)
+    {
+        SetWord16(WATCHDOG_REG, 0xFF);
+        if (uart_data_ready_getf(UART1))
+        {
+            uart_read_byte(UART1);
+            systick_start(FRAMED_RESYNC_IDLE_US, true);
+        }
+    }
+    systick_stop();
+}
+
+/**
+ ****************************************************************************************
+ * @brief Stop the frame reception.
+ ****************************************************************************************
+ */
+static void framed_stop(void)
+{
+    uint8_t state = framed.state;
+
+    framed.state = FRAMED_RX_STOPPED;
+    if (state != FRAMED_RX_STOPPED)
+    {
+        // Cancel the pending transfer (Rx channel of UART_DMA_CHANNEL_01)
+        dma_channel_cancel(DMA_CHANNEL_0);
+    }
+    framed_active = false;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Restart the framing: drop the frame being received, wait for the line to become
+ * idle, ask the host to send again the frames without an answer and wait for a header.
+ ****************************************************************************************
+ */
+static void framed_resync(void)
+{
+    framed_stop();
+    framed_drain();
+    framed_answer(NAK, FRAMED_SEQ_RESYNC);
+    framed.state = FRAMED_RX_HEADER;
+    framed_active = true;
+    uart_receive(UART1, framed.header, sizeof(framed.header), UART_OP_DMA);
+}
+
+/**
+****************************************************************************************
+* @brief download firmware through UART with the framed boot protocol
+* @details Called after SOB has been received. The frames are received with DMA straight
+*          into SYSRAM, while the CRC32 of the frames that have arrived is checked here.
+* @return The image size on success, a negative value on failure.
+****************************************************************************************
+*/
+static int FwDownloadFramed(void)
+{
+    uint8_t hdr[14];
+    uint32_t image_crc;
+    uint8_t baud;
+    uint32_t received_map[(FRAMED_MAX_BLOCKS + 31) / 32] = {0};
+    uint16_t missing;
+    uint32_t frame_timeout;
+    uint8_t events;
+    uint8_t resyncs = 0;
+
+    if (0 == uart_receive_bytes(hdr, sizeof(hdr)))
+    {
+        return -10; // receive header
+    }
+
+    framed.size = hdr[0] | (hdr[1] << 8) | (hdr[2] << 16) | ((uint32_t) hdr[3] << 24);
+    framed.block_log2 = hdr[4];
+    baud = hdr[5];
+    image_crc = hdr[6] | (hdr[7] << 8) | (hdr[8] << 16) | ((uint32_t) hdr[9] << 24);
+
+    if ((crc32(0, hdr, 10) != (hdr[10] | (hdr[11] << 8) | (hdr[12] << 16) | ((uint32_t) hdr[13] << 24))) ||
+        (framed.size == 0) || (framed.size > MAX_CODE_LENGTH) ||
+        (framed.block_log2 < FRAMED_BLOCK_LOG2_MIN) || (framed.block_log2 > FRAMED_BLOCK_LOG2_MAX))
+    {
+        uart_write_byte(UART1, NAK);
+        return -11;
+    }
+
+    if (baud >= FRAMED_BAUD_MAX)
+    {
+        baud = FRAMED_BAUD_MAX - 1;
+    }
+
+    uart_write_byte(UART1, ACK);
+    uart_write_byte(UART1, baud);
+    uart_write_byte(UART1, FRAMED_QUEUE_SIZE);
+    uart_wait_tx_finish(UART1);
+    if (baud != FRAMED_BAUD_KEEP)
+    {
+        uart_baudrate_setf(UART1, framed_baud_rates[baud]);
+    }
+
+    framed.image = (uint8_t *) SYSRAM_COPY_BASE_ADDRESS;
+    framed.blocks = (framed.size + (1UL << framed.block_log2) - 1) >> framed.block_log2;
+    framed.queue_in = 0;
+    framed.queue_out = 0;
+    missing = framed.blocks;
+
+    // Time of a frame of the largest block plus the usual 60ms of silence
+    frame_timeout = 60000 + (((1UL << framed.block_log2) + 8) * 10 * 1000) / (framed_bit_rates[baud] / 1000);
+
+    framed.state = FRAMED_RX_HEADER;
+    framed_active = true;
+    uart_receive(UART1, framed.header, sizeof(framed.header), UART_OP_DMA);
+
+    systick_register_callback(systick_callback);
+
+    while (missing > 0)
+    {
+        events = framed.events;
+        timeout = false;
+        systick_start(frame_timeout, true);
+
+        // Wait for a frame to be checked, for the framing to be lost or for a timeout
+        while ((framed.queue_out == framed.queue_in) && (framed.state != FRAMED_RX_STOPPED) && !timeout)
+        {
+            SetWord16(WATCHDOG_REG, 0xFF);
+        }
+        systick_stop();
+
+        if (framed.queue_out != framed.queue_in)
+        {
+            uint8_t slot = framed.queue_out % FRAMED_QUEUE_SIZE;
+            uint16_t seq = framed.queue_seq[slot];
+            uint8_t seq_le[2] = {seq & 0xFF, seq >> 8};
+            uint32_t crc = crc32(crc32(0, seq_le, sizeof(seq_le)),
+                                 framed.image + ((uint32_t) seq << framed.block_log2),
+                                 framed_block_len(seq));
+            bool done = (received_map[seq / 32] & (1UL << (seq % 32))) != 0;
+
+            if (crc == framed.queue_crc[slot])
+            {
+                resyncs = 0;
+                if (!done)
+                {
+                    received_map[seq / 32] |= 1UL << (seq % 32);
+                    missing--;
+                }
+                framed_answer(ACK, seq);
+            }
+            else
+            {
+                // A bad copy of a block has overwritten the good one
+                if (done)
+                {
+                    received_map[seq / 32] &= ~(1UL << (seq % 32));
+                    missing++;
+                }
+                framed_answer(NAK, seq);
+            }
+            framed.queue_out++;
+        }
+        else if ((framed.state == FRAMED_RX_STOPPED) || (events == framed.events))
+        {
+            // Framing lost, or no progress within the frame timeout (a byte of the frame
+            // being received was lost, or an answer was): wait for the host to stop
+            // sending, then start over
+            if (++resyncs > FRAMED_MAX_RESYNCS)
+            {
+                framed_stop();
+                return -12; // the host does not answer the resyncs
+            }
+            framed_resync();
+        }
+    }
+
+    framed_stop();
+
+    if (crc32(0, framed.image, framed.size) != image_crc)
+    {
+        framed_answer(CAN, 0);
+        uart_wait_tx_finish(UART1);
+        return -13;
+    }
+
+    framed_answer(EOT, 0);
+    uart_wait_tx_finish(UART1);
+
+    return framed.size;
+}
+#endif // UART_SUPPORTED && USE_UART_FRAMED_BOOT
+
+#if (USE_UART_COMPRESSED_BOOT)
+/// Decoder of a compressed image, NULL window: the image is decoded in place
+static lzss_dec_t lz_dec;
+/// Decoder status, LZSS_OK while the image is not complete
+static int lz_status;
+/// Bytes decoded so far
+static uint32_t lz_size;
+/// Set if the image being received is compressed
+static bool lz_active;
+#endif
+
+/**
+****************************************************************************************
+* @brief Store a received image byte
+ *
+ * @param[in] offset    Offset of the byte in the received image
+ * @param[in] byte      Received byte
+ *
+ * @note A compressed image is decoded while it is received. Decoding errors are kept
+ *       until code_end() so that the protocol runs to its end.
+****************************************************************************************
+*/
+static void code_store(int offset, uint8_t byte)
+{
+#if (USE_UART_COMPRESSED_BOOT)
+    uint32_t in_used;
+    uint32_t out_used;
+
+    if (offset == 0)
+    {
+        lz_active = (byte == LZSS_MAGIC0);
+        lz_status = LZSS_OK;
+        lz_size = 0;
+        lzss_init(&lz_dec, NULL, 0);
+    }
+
+    if (lz_active)
+    {
+        if (lz_status != LZSS_OK)
+        {
+            lz_status = (lz_status == LZSS_DONE) ? LZSS_ERR_DATA : lz_status;   // trailing data
+            return;
+        }
+
+        lz_status = lzss_decode(&lz_dec, &byte, 1, &in_used,
+                                (uint8_t *) (SYSRAM_COPY_BASE_ADDRESS) + lz_size,
+                                MAX_CODE_LENGTH - lz_size, &out_used);
+        lz_size += out_used;
+
+        if ((lz_status == LZSS_OK) && (in_used == 0))
+        {
+            lz_status = LZSS_ERR_DATA;                  // the image does not fit into memory
+        }
+        if ((lz_status == LZSS_OK) && lzss_header_done(&lz_dec) && (lz_dec.size > MAX_CODE_LENGTH))
+        {
+            lz_status = LZSS_ERR_HEADER;
+        }
+        return;
+    }
+#endif
+    ((char *) (SYSRAM_COPY_BASE_ADDRESS))[offset] = byte;   // write to RAM
+}
+
+/**
+****************************************************************************************
+* @brief Finish the reception of the image
+ *
+ * @param[in] fw_size   Number of received bytes
+ * @param[in] crc_code  XOR checksum of the received bytes
+ *
+ * @return The size of the image in SYSRAM_COPY_BASE_ADDRESS (the decoded size of a
+ *         compressed image), or a negative value if a compressed image is corrupted.
+ *         In that case crc_code is complemented so that the host sees a checksum error.
+****************************************************************************************
+*/
+static int code_end(int fw_size, char *crc_code)
+{
+#if (USE_UART_COMPRESSED_BOOT)
+    if (lz_active)
+    {
+        if (lz_status != LZSS_DONE)
+        {
+            *crc_code = ~*crc_code;
+            return -10;
+        }
+        return lz_size;
+    }
+#endif
+    return fw_size;
+}
+
 /**
 ****************************************************************************************
 * @brief download firmware through UART
@@ -113,8 +591,8 @@ static int uart_receive_byte(uint8_t *recv_byte)
 int FwDownload(void)
 {
     int fw_size;
+    int size;
     int i;
-    char *code;
     char crc_code;
     uint8_t recv_byte;
 
@@ -124,6 +602,12 @@ int FwDownload(void)
     {
         return -1;  // receive SOH
     }
+#if defined (UART_SUPPORTED) && (USE_UART_FRAMED_BOOT)
+    if (recv_byte == SOB)
+    {
+        return FwDownloadFramed();
+    }
+#endif
     if (recv_byte != SOH)
     {
         return -2;
@@ -174,7 +658,6 @@ int FwDownload(void)
     }
 
     crc_code = 0;
-    code = (char*) (SYSRAM_COPY_BASE_ADDRESS);          // set pointer to SYSRAM
     for (i = 0; i < fw_size; i++)                       // copy code from UART to RAM
     {
         SetWord16(WATCHDOG_REG, 0xFF);
@@ -184,9 +667,9 @@ int FwDownload(void)
             return -6; // receive code byte
         }
         crc_code ^= recv_byte;                          // update CRC
-        *code = recv_byte;                              // write to RAM
-        code++;                                         // increase RAM pointer
+        code_store(i, recv_byte);                       // write to RAM
     }
+    size = code_end(fw_size, &crc_code);
     uart_write_byte(UART1, crc_code);                           // send CRC byte
 
     if (0 == uart_receive_byte(&recv_byte))
@@ -199,7 +682,7 @@ int FwDownload(void)
         return -8;
     }
 
-    return fw_size;
+    return size;
 }
 
 /**
@@ -211,8 +694,8 @@ int FwDownload(void)
 int FwDownloadOneWireUART(void)
 {
     int fw_size;
+    int size;
     int i;
-    char *code;
     char crc_code;
     uint8_t recv_byte;
 
@@ -281,7 +764,6 @@ int FwDownloadOneWireUART(void)
 
     GPIO_ConfigurePin(UART_GPIO_PORT, GPIO_PIN_5, INPUT, PID_UART1_RX, false);
     crc_code = 0;
-    code = (char*) (SYSRAM_COPY_BASE_ADDRESS);          // set pointer to SYSRAM
     for (i = 0; i < fw_size; i++)                       // copy code from UART to RAM
     {
         SetWord16(WATCHDOG_REG, 0xFF);
@@ -291,9 +773,9 @@ int FwDownloadOneWireUART(void)
             return -6; // receive code byte
         }
         crc_code ^= recv_byte;                          // update CRC
-        *code = recv_byte;                              // write to RAM
-        code++;                                         // increase RAM pointer
+        code_store(i, recv_byte);                       // write to RAM
     }
+    size = code_end(fw_size, &crc_code);
     GPIO_ConfigurePin(UART_GPIO_PORT, GPIO_PIN_5, OUTPUT, PID_UART1_TX, false);
     uart_write_byte(UART1, crc_code);                           // send CRC byte
     uart_wait_tx_finish(UART1);
@@ -309,7 +791,7 @@ int FwDownloadOneWireUART(void)
         return -8;
     }
 
-    return fw_size;
+    return size;
 }
 
 #endif
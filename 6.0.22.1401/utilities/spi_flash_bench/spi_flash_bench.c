@@ -0,0 +1,316 @@
+/**
+ ****************************************************************************************
+ *
+ * @file spi_flash_bench.c
+ *
+ * @brief Transaction counts of the read paths of the SDK SPI flash driver.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "spi.h"
+#include "spi_flash.h"
+
+#define SPI_FLASH_BENCH_VERSION	"v_1.0"
+
+/* MX25R2035F, the device of host_shim/src/spi_flash_sim.c */
+#define FLASH_SIZE		(256 * 1024)
+
+/* Guard bytes around the read buffer, which must be left untouched; a multiple of 4 */
+#define GUARD			8
+#define GUARD_BYTE		0xA5
+
+/* Longer than one spi_receive() call (0xFFFF items) in 8-bit mode */
+#define LONG_READ		70000
+
+typedef int8_t (*read_func_t)(uint8_t *rd_data_ptr, uint32_t address, uint32_t size,
+			      uint32_t *actual_size);
+
+/* The read functions of the driver */
+enum {
+	READ_DATA,
+	READ_DATA_BUFFER,
+	READ_DATA_DMA,
+	NB_READS
+};
+
+static const char *const read_names[NB_READS] = { "read_data", "buffer", "dma" };
+
+/* A build of sdk/platform/driver/spi_flash/spi_flash.c, see VARIANTS in gcc/Makefile */
+struct variant {
+	const char *name;
+	int8_t (*enable)(const spi_cfg_t *spi_cfg, uint8_t *dev_id);
+	read_func_t read[NB_READS];
+};
+
+#define VARIANT_API(v)								\
+	int8_t v##_spi_flash_enable_with_autodetect(const spi_cfg_t *spi_cfg,	\
+						    uint8_t *dev_id);		\
+	int8_t v##_spi_flash_read_data(uint8_t *rd_data_ptr, uint32_t address,	\
+				       uint32_t size, uint32_t *actual_size);	\
+	int8_t v##_spi_flash_read_data_buffer(uint8_t *rd_data_ptr, uint32_t address, \
+					      uint32_t size, uint32_t *actual_size); \
+	int8_t v##_spi_flash_read_data_dma(uint8_t *rd_data_ptr, uint32_t address, \
+					   uint32_t size, uint32_t *actual_size)
+
+VARIANT_API(ref);
+VARIANT_API(new);
+
+#define VARIANT(v)	{ #v, v##_spi_flash_enable_with_autodetect,		\
+			  { v##_spi_flash_read_data, v##_spi_flash_read_data_buffer,	\
+			    v##_spi_flash_read_data_dma } }
+
+static const struct variant variants[] = {
+	VARIANT(ref),
+	VARIANT(new),
+};
+
+#define NB_VARIANTS		(sizeof(variants) / sizeof(variants[0]))
+
+/* The reads reported: size and offset of the buffer from a word aligned address */
+struct workload {
+	const char *name;
+	uint32_t size;
+	uint32_t offset;
+};
+
+static const struct workload workloads[] = {
+	{ "header 64 B",	64,		0 },
+	{ "page 256 B",		256,		0 },
+	{ "page 256 B +1",	256,		1 },
+	{ "sector 4 KB",	4096,		0 },
+	{ "image 32 KB",	32 * 1024,	0 },
+};
+
+#define NB_WORKLOADS		(sizeof(workloads) / sizeof(workloads[0]))
+
+/* Sizes of the checked reads, with every buffer offset from a word aligned address */
+static const uint32_t check_sizes[] = {
+	0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 15, 16, 17, 255, 256, 257, 4095, 4096, LONG_READ
+};
+
+#define NB_CHECK_SIZES		(sizeof(check_sizes) / sizeof(check_sizes[0]))
+
+static const spi_cfg_t spi_cfg = {
+	.spi_ms = SPI_MS_MODE_MASTER,
+	.spi_cp = SPI_CP_MODE_0,
+	.spi_speed = SPI_SPEED_MODE_16MHz,
+	.spi_wsz = SPI_MODE_8BIT,
+	.spi_cs = SPI_CS_0,
+	.spi_irq = SPI_IRQ_DISABLED,
+	.spi_dma_channel = SPI_DMA_CHANNEL_01,
+	.spi_dma_priority = DMA_PRIO_0,
+};
+
+/* CPU time of one SPI FIFO access of a blocking read: write, wait for the SPI, read back */
+static double cpu_us = 0.75;
+static uint32_t seed = 1;
+static int errors;
+
+static void usage(const char* my_name)
+{
+	fprintf(stderr,
+		"Version: " SPI_FLASH_BENCH_VERSION "\n"
+		"\n"
+		"Usage: %s [-c cpu_us] [-f spi_mhz] [-S seed]\n"
+		"\n"
+		"  Reads a simulated SPI flash (host_shim/src/spi_flash_sim.c) through the SDK\n"
+		"  SPI flash driver of this tree (sdk/platform/driver/spi_flash/spi_flash.c) and\n"
+		"  of the reference revision (see 'make bench'), and reports for\n"
+		"  spi_flash_read_data(), spi_flash_read_data_buffer() and\n"
+		"  spi_flash_read_data_dma() the chip selects, the SPI FIFO accesses of the CPU,\n"
+		"  the items moved by the DMA, the bus time and the time of a few typical reads.\n"
+		"  The time adds the CPU time of every FIFO access to the bus time.\n"
+		"\n"
+		"  Checks the data of reads of many sizes into buffers at every offset from a\n"
+		"  word aligned address, the bytes around the buffer, and the size of a read\n"
+		"  that runs past the end of the flash.\n"
+		"\n"
+		"  -c cpu_us       CPU time of one SPI FIFO access in us (default %.2f)\n"
+		"  -f spi_mhz      SPI clock in MHz (default %g)\n"
+		"  -S seed         Seed of the flash content and the addresses (default 1)\n"
+		"\n", my_name, cpu_us, spi_flash_sim_timing()->spi_mhz);
+}
+
+static uint32_t rnd(void)
+{
+	seed = seed * 1103515245 + 12345;
+	return seed >> 1;
+}
+
+static void expect(bool ok, const char *what)
+{
+	if (!ok) {
+		fprintf(stderr, "FAILED: %s\n", what);
+		errors++;
+	}
+}
+
+static bool guards_ok(const uint8_t *buf, uint32_t size)
+{
+	uint32_t i;
+
+	for (i = 0; i < GUARD; i++)
+		if (buf[i] != GUARD_BYTE || buf[GUARD + size + i] != GUARD_BYTE)
+			return false;
+	return true;
+}
+
+/* Read size bytes from address into a buffer at offset from a word aligned address */
+static bool check_read(read_func_t read, uint32_t address, uint32_t size, uint32_t offset,
+		       uint32_t expected_size)
+{
+	/* The data starts offset bytes after a word aligned address */
+	uint32_t *mem = malloc(GUARD + 4 + size + GUARD);
+	uint8_t *buf = (uint8_t *) mem + offset;
+	uint32_t actual = 0;
+	int8_t status;
+	bool ok;
+
+	memset(buf, GUARD_BYTE, GUARD + size + GUARD);
+	status = read(buf + GUARD, address, size, &actual);
+	ok = status == SPI_FLASH_ERR_OK && actual == expected_size &&
+	     !memcmp(buf + GUARD, spi_flash_sim_mem() + address, actual) &&
+	     guards_ok(buf, actual) &&
+	     (actual == size || buf[GUARD + actual] == GUARD_BYTE);
+	free(mem);
+	return ok;
+}
+
+static void check_variant(const struct variant *v)
+{
+	char what[128];
+	uint32_t i, offset, address;
+	int r;
+
+	for (r = 0; r < NB_READS; r++) {
+		for (i = 0; i < NB_CHECK_SIZES; i++) {
+			for (offset = 0; offset < 4; offset++) {
+				address = rnd() % (FLASH_SIZE - check_sizes[i] + 1);
+				snprintf(what, sizeof(what), "%s %s of %u bytes at 0x%x, offset %u",
+					 v->name, read_names[r], check_sizes[i], address, offset);
+				expect(check_read(v->read[r], address, check_sizes[i], offset,
+						  check_sizes[i]), what);
+			}
+		}
+		/* The size is cut at the end of the flash */
+		snprintf(what, sizeof(what), "%s %s past the end of the flash", v->name,
+			 read_names[r]);
+		expect(check_read(v->read[r], FLASH_SIZE - 13, 64, 1, 13), what);
+	}
+}
+
+/* Run a read, return its time in us */
+static double run_workload(const struct variant *v, const struct workload *w, int r)
+{
+	uint32_t *mem = malloc(w->size + 4);
+	uint8_t *buf = (uint8_t *) mem + w->offset;
+	const spi_flash_sim_stats_t *s = spi_flash_sim_stats();
+	uint32_t actual = 0;
+	int8_t status;
+	double us;
+
+	spi_flash_sim_clear_stats();
+	status = v->read[r](buf, 0x1000, w->size, &actual);
+	expect(status == SPI_FLASH_ERR_OK && actual == w->size &&
+	       !memcmp(buf, spi_flash_sim_mem() + 0x1000, w->size), w->name);
+	us = s->bus_us + s->accesses * cpu_us;
+	printf("%-6s %-10s %-14s %6llu %9llu %9llu %9.1f %9.1f\n", v->name, read_names[r],
+	       w->name, (unsigned long long) s->transactions, (unsigned long long) s->accesses,
+	       (unsigned long long) s->dma_items, s->bus_us, us);
+	free(mem);
+
+	return us;
+}
+
+int main(int argc, char **argv)
+{
+	spi_flash_sim_timing_t timing = *spi_flash_sim_timing();
+	double us[NB_VARIANTS];
+	uint8_t *flash;
+	uint8_t dev_id;
+	unsigned int k, i;
+	int opt, r;
+
+	while ((opt = getopt(argc, argv, "c:f:S:")) != -1) {
+		switch (opt) {
+		case 'c':
+			cpu_us = strtod(optarg, NULL);
+			break;
+		case 'f':
+			timing.spi_mhz = strtod(optarg, NULL);
+			break;
+		case 'S':
+			seed = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	if (optind != argc || cpu_us < 0 || timing.spi_mhz <= 0) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	spi_flash_sim_init(FLASH_SIZE);
+	spi_flash_sim_set_timing(&timing);
+	flash = spi_flash_sim_mem();
+	for (i = 0; i < FLASH_SIZE; i++)
+		flash[i] = rnd() >> 16;
+
+	for (k = 0; k < NB_VARIANTS; k++) {
+		dev_id = 0;
+		expect(variants[k].enable(&spi_cfg, &dev_id) == SPI_FLASH_ERR_OK && dev_id != 0,
+		       variants[k].name);
+		check_variant(&variants[k]);
+	}
+
+	printf("SPI clock %g MHz, %.2f us of CPU time per SPI FIFO access\n\n", timing.spi_mhz,
+	       cpu_us);
+	printf("%-6s %-10s %-14s %6s %9s %9s %9s %9s %7s\n", "driver", "read", "size", "cs",
+	       "accesses", "dma items", "bus us", "time us", "speedup");
+	for (i = 0; i < NB_WORKLOADS; i++)
+		for (r = 0; r < NB_READS; r++) {
+			for (k = 0; k < NB_VARIANTS; k++)
+				us[k] = run_workload(&variants[k], &workloads[i], r);
+			printf("%80s%6.2fx\n", "", us[0] / us[1]);
+		}
+
+	if (errors) {
+		printf("\nFAILED, %d errors\n", errors);
+		return EXIT_FAILURE;
+	}
+	printf("\nOK\n");
+
+	return EXIT_SUCCESS;
+}
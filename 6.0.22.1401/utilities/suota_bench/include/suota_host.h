@@ -0,0 +1,70 @@
+/**
+ ****************************************************************************************
+ *
+ * @file suota_host.h
+ *
+ * @brief Host build settings of the SUOTA receiver benchmark, included first.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+
+#ifndef _SUOTA_HOST_H_
+#define _SUOTA_HOST_H_
+
+#include <assert.h>
+#include <stdint.h>
+
+/* A failed SDK assertion stops the benchmark: arch.h keeps these definitions */
+#define ASSERT_ERROR(x)		assert(x)
+#define ASSERT_WARNING(x)	assert(x)
+
+/*
+ * The register accesses of the SDK sources go to the register file of
+ * host_shim/src/host_regs.c, also the ones through a pointer to a register block.
+ * datasheet.h is not included again.
+ */
+#include "datasheet.h"
+
+uint32_t host_reg_read(uint32_t addr);
+void host_reg_write(uint32_t addr, uint32_t value);
+
+/* The SDK reads some registers only to clear them */
+static inline uint16_t host_reg_read16(uint32_t addr)
+{
+	return (uint16_t)host_reg_read(addr);
+}
+
+#undef SetWord16
+#undef GetWord16
+#undef SetWord32
+#undef GetWord32
+#define SetWord16(a,d)		host_reg_write((uint32_t)(uintptr_t)(a), (uint16_t)(d))
+#define GetWord16(a)		host_reg_read16((uint32_t)(uintptr_t)(a))
+#define SetWord32(a,d)		host_reg_write((uint32_t)(uintptr_t)(a), (uint32_t)(d))
+#define GetWord32(a)		host_reg_read((uint32_t)(uintptr_t)(a))
+
+#endif /* _SUOTA_HOST_H_ */
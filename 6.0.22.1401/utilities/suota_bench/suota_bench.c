@@ -0,0 +1,795 @@
+/**
+ ****************************************************************************************
+ *
+ * @file suota_bench.c
+ *
+ * @brief SUOTA receiver replay of an image stream over a simulated link and SPI flash.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ke_msg.h"
+#include "prf.h"
+#include "gpio.h"
+#include "spi.h"
+#include "app.h"
+#include "app_entry_point.h"
+#include "app_prf_perm_types.h"
+#include "app_suotar.h"
+#include "suotar_task.h"
+#include "user_periph_setup.h"
+
+#define SUOTA_BENCH_VERSION	"v_1.0"
+
+/* SUOTA layout of the flash of ble_app_ota: two image banks below the product header */
+#define FLASH_SIZE		SPI_FLASH_DEV_SIZE
+#define IMAGE1_OFFSET		0x04000
+#define IMAGE2_OFFSET		0x1E000
+#define IMAGE_CODE_MAX		(IMAGE2_OFFSET - IMAGE1_OFFSET - CODE_OFFSET)
+
+/* The messages sent to this task are the notifications of the SUOTAR profile to the peer */
+#define BENCH_SUOTAR_TASK	0x30
+
+/* An update that has not finished after this simulated time has failed */
+#define RUN_LIMIT_US		(600 * 1000000.0)
+
+/* Notifications waiting for a connection event */
+#define NTF_MAX			64
+
+/*
+ * Simulation control of host_shim/src/spi_flash_sim.c. Its header replaces the SDK
+ * driver header, which the SUOTA receiver and this file are built with.
+ */
+void spi_flash_sim_init(uint32_t size);
+void spi_flash_sim_format(void);
+uint8_t *spi_flash_sim_mem(void);
+uint32_t spi_flash_sim_sector_erases(uint32_t sector);
+void spi_flash_sim_advance(double us);
+double spi_flash_sim_time_us(void);
+
+/* A SUOTA receiver, see RECEIVERS in gcc/Makefile */
+struct receiver {
+	const char *name;
+	void (*init)(void);
+	enum process_event_response (*handler)(ke_msg_id_t const msgid, void const *param,
+					       ke_task_id_t const dest_id, ke_task_id_t const src_id,
+					       enum ke_msg_status_tag *msg_ret);
+};
+
+#define RECEIVER_API(r)								\
+	void r##_app_suotar_init(void);						\
+	enum process_event_response r##_app_suotar_process_handler(ke_msg_id_t const msgid, \
+		void const *param, ke_task_id_t const dest_id, ke_task_id_t const src_id, \
+		enum ke_msg_status_tag *msg_ret)
+
+RECEIVER_API(sync);
+RECEIVER_API(pipe2);
+RECEIVER_API(pipe3);
+RECEIVER_API(pipe3_crc32);
+
+#define RECEIVER(r)	{ #r, r##_app_suotar_init, r##_app_suotar_process_handler }
+
+static const struct receiver receivers[] = {
+	RECEIVER(sync),
+	RECEIVER(pipe2),
+	RECEIVER(pipe3),
+	RECEIVER(pipe3_crc32),
+};
+
+#define NB_RECEIVERS		(sizeof(receivers) / sizeof(receivers[0]))
+
+/* The connection, 1M PHY */
+struct link {
+	const char *name;
+	uint32_t interval_us;
+	/* packets the peer sends in one connection event */
+	uint32_t pkts;
+	/* patch data of one write command: the ATT MTU - 3 */
+	uint32_t chunk;
+	/* SUOTA block size (PATCH_LEN), at most SUOTA_OVERALL_PD_SIZE */
+	uint32_t block;
+};
+
+static const struct link links[] = {
+	{ "MTU 23, 15 ms", 15000, 4, 20, 240 },
+	{ "MTU 23, 7.5 ms", 7500, 4, 20, 240 },
+	{ "MTU 247, 15 ms", 15000, 5, 244, 488 },
+};
+
+#define NB_LINKS		(sizeof(links) / sizeof(links[0]))
+
+/* A kernel message and the time it is in the queue of the receiver */
+struct bench_msg {
+	struct bench_msg *next;
+	double t;
+	struct ke_msg msg;
+};
+
+/* The SUOTA initiator, as the SUOTA applications of the phones */
+enum peer_state {
+	PEER_MEM_DEV,
+	PEER_WAIT_STARTED,
+	PEER_GPIO_MAP,
+	PEER_PATCH_LEN,
+	PEER_DATA,
+	PEER_WAIT_BLOCK,
+	PEER_END,
+	PEER_WAIT_END,
+	PEER_DONE,
+	PEER_FAILED,
+};
+
+struct peer {
+	enum peer_state state;
+	const uint8_t *stream;
+	uint32_t len;
+	/* bytes sent, end of the current block and PATCH_LEN */
+	uint32_t pos;
+	uint32_t block_end;
+	uint32_t patch_len;
+	/* first connection event the peer sends in */
+	double ready_us;
+	double done_us;
+	uint8_t status;
+};
+
+/* Results of one update */
+struct result {
+	double time_s;
+	double kbps;
+	uint32_t erases;
+	uint32_t max_queue;
+	uint8_t status;
+};
+
+static uint32_t image_kb = 64;
+static double cpu_us = 30;
+static uint32_t seed = 1;
+static int errors;
+
+static struct link custom_link;
+static bool custom;
+
+/* The receiver under test and its message queue, in arrival order */
+static const struct receiver *rcv;
+static struct bench_msg *queue;
+static uint32_t queue_len;
+static uint32_t max_queue;
+
+/* Status notifications to the peer */
+static struct {
+	double t;
+	uint8_t status;
+} ntf[NTF_MAX];
+static uint32_t ntf_head;
+static uint32_t ntf_cnt;
+
+static struct peer peer;
+
+/* Used by app_suotar.c */
+struct app_env_tag app_env[APP_EASY_MAX_ACTIVE_CONNECTION];
+int GPIO[NO_OF_PORTS][NO_OF_MAX_PINS_PER_PORT];
+volatile uint64_t GPIO_status;
+
+static void usage(const char* my_name)
+{
+	fprintf(stderr,
+		"Version: " SUOTA_BENCH_VERSION "\n"
+		"\n"
+		"Usage: %s [-s image_kb] [-u cpu_us] [-i interval_us -p packets -c chunk -b block] [-S seed]\n"
+		"\n"
+		"  Replays the SUOTA update of a random image of 'image_kb' KB, as sent by a\n"
+		"  phone, against the SUOTA receiver of this tree (app_suotar.c, built as in\n"
+		"  ble_app_ota) and a simulated SPI flash, and reports the effective KB/s.\n"
+		"  The receivers are the default one, which programs each block before it\n"
+		"  acknowledges it, and the CFG_SUOTAR_PIPELINED ones with 2 and 3 buffers\n"
+		"  (the last one also with CFG_SUOTAR_CRC32).\n"
+		"\n"
+		"  The peer sends up to 'packets' write commands of 'chunk' bytes in each\n"
+		"  connection event and waits for the status notification of each block of\n"
+		"  'block' bytes. Without these options a few typical connections are run.\n"
+		"  The kernel messages of the receiver are handled in arrival order, each one\n"
+		"  costs 'cpu_us' plus the time spent in the SPI flash driver, which includes\n"
+		"  the erase and program times of host_shim/src/spi_flash_sim.c.\n"
+		"\n"
+		"  Checks the image written to the flash, and that a corrupted image is\n"
+		"  rejected.\n"
+		"\n", my_name);
+}
+
+static uint32_t rnd(void)
+{
+	seed = seed * 1103515245 + 12345;
+	return seed >> 1;
+}
+
+static void expect(bool ok, const char *what)
+{
+	if (!ok) {
+		fprintf(stderr, "FAILED: %s\n", what);
+		errors++;
+	}
+}
+
+static uint32_t crc32(const uint8_t *data, uint32_t len)
+{
+	uint32_t crc = 0xFFFFFFFF;
+	int i;
+
+	while (len--) {
+		crc ^= *data++;
+		for (i = 0; i < 8; i++)
+			crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+	}
+	return ~crc;
+}
+
+/*
+ * Kernel messages
+ */
+
+static struct bench_msg *bench_msg(void const *param_ptr)
+{
+	return (struct bench_msg *)((uint8_t *) ke_param2msg(param_ptr) - offsetof(struct bench_msg, msg));
+}
+
+void *ke_msg_alloc(ke_msg_id_t const id, ke_task_id_t const dest_id, ke_task_id_t const src_id,
+		   uint16_t const param_len)
+{
+	struct bench_msg *m = calloc(1, sizeof(*m) + param_len);
+
+	if (m == NULL) {
+		fprintf(stderr, "out of memory\n");
+		exit(EXIT_FAILURE);
+	}
+	m->msg.id = id;
+	m->msg.dest_id = dest_id;
+	m->msg.src_id = src_id;
+	m->msg.param_len = param_len;
+	return ke_msg2param(&m->msg);
+}
+
+/* Queue a message of the receiver, behind the ones that arrived before it */
+static void queue_msg(struct bench_msg *m, double t)
+{
+	struct bench_msg **p = &queue;
+
+	while (*p != NULL && (*p)->t <= t)
+		p = &(*p)->next;
+	m->t = t;
+	m->next = *p;
+	*p = m;
+	if (++queue_len > max_queue)
+		max_queue = queue_len;
+}
+
+void ke_msg_send(void const *param_ptr)
+{
+	struct bench_msg *m = bench_msg(param_ptr);
+
+	if (m->msg.dest_id == TASK_APP) {
+		queue_msg(m, spi_flash_sim_time_us());
+		return;
+	}
+
+	if (m->msg.dest_id == BENCH_SUOTAR_TASK && m->msg.id == SUOTAR_STATUS_UPDATE_REQ) {
+		const struct suotar_status_update_req *req = param_ptr;
+
+		if (ntf_cnt == NTF_MAX) {
+			fprintf(stderr, "too many notifications\n");
+			exit(EXIT_FAILURE);
+		}
+		ntf[(ntf_head + ntf_cnt) % NTF_MAX].t = spi_flash_sim_time_us();
+		ntf[(ntf_head + ntf_cnt) % NTF_MAX].status = req->status;
+		ntf_cnt++;
+	}
+	/* The memory info notifications are not used by the peer */
+	free(m);
+}
+
+void ke_msg_send_basic(ke_msg_id_t const id, ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+	ke_msg_send(ke_msg_alloc(id, dest_id, src_id, 0));
+}
+
+enum process_event_response app_std_process_event(ke_msg_id_t const msgid, void const *param,
+						  ke_task_id_t const src_id, ke_task_id_t const dest_id,
+						  enum ke_msg_status_tag *msg_ret,
+						  const struct ke_msg_handler *handlers,
+						  const int handler_num)
+{
+	int i;
+
+	for (i = 0; i < handler_num; i++) {
+		if (handlers[i].id == msgid) {
+			*msg_ret = (enum ke_msg_status_tag) handlers[i].func(msgid, param, dest_id, src_id);
+			return PR_EVENT_HANDLED;
+		}
+	}
+	return PR_EVENT_UNHANDLED;
+}
+
+ke_task_id_t prf_get_task_from_id(ke_msg_id_t id)
+{
+	return BENCH_SUOTAR_TASK;
+}
+
+/*
+ * Stubs of the rest of ble_app_ota
+ */
+
+app_prf_srv_perm_t get_user_prf_srv_perm(enum KE_API_ID task_id)
+{
+	return SRV_PERM_ENABLE;
+}
+
+void on_suotar_status_change(const uint8_t suotar_event)
+{
+}
+
+void app_easy_gap_disconnect(uint8_t conidx)
+{
+	fprintf(stderr, "unexpected disconnection\n");
+	exit(EXIT_FAILURE);
+}
+
+void platform_reset(uint32_t error)
+{
+	fprintf(stderr, "unexpected reset 0x%x\n", error);
+	exit(EXIT_FAILURE);
+}
+
+void GPIO_ConfigurePin(GPIO_PORT port, GPIO_PIN pin, GPIO_PUPD mode, GPIO_FUNCTION function,
+		       const bool high)
+{
+}
+
+void spi_set_cs_pad(SPI_Pad_t cs_pad)
+{
+}
+
+void spi_disable(void)
+{
+}
+
+/*
+ * The peer and the connection
+ */
+
+/* Air time of a packet of the peer and of the empty packet that answers it, 1M PHY */
+static double pkt_us(uint32_t att_len)
+{
+	/* preamble, access address, header, L2CAP header and CRC */
+	return (1 + 4 + 2 + 4 + att_len + 3) * 8 + 150 + 80 + 150;
+}
+
+/* A write of the peer, as the SUOTAR profile passes it to the application */
+static void *peer_write(ke_msg_id_t id, uint16_t param_len, double t)
+{
+	void *param = ke_msg_alloc(id, TASK_APP, BENCH_SUOTAR_TASK, param_len);
+
+	queue_msg(bench_msg(param), t);
+	return param;
+}
+
+static void peer_status(uint8_t status, double te, const struct link *l)
+{
+	uint32_t blk;
+
+	switch (peer.state) {
+	case PEER_WAIT_STARTED:
+		if (status != SUOTAR_IMG_STARTED)
+			break;
+		peer.state = PEER_GPIO_MAP;
+		peer.ready_us = te + l->interval_us;
+		return;
+	case PEER_WAIT_BLOCK:
+		if (status != SUOTAR_CMP_OK)
+			break;
+		if (peer.pos == peer.len) {
+			peer.state = PEER_END;
+		} else {
+			blk = peer.len - peer.pos;
+			if (blk > l->block)
+				blk = l->block;
+			peer.block_end = peer.pos + blk;
+			peer.state = (blk == peer.patch_len) ? PEER_DATA : PEER_PATCH_LEN;
+		}
+		peer.ready_us = te + l->interval_us;
+		return;
+	case PEER_WAIT_END:
+		if (status != SUOTAR_CMP_OK)
+			break;
+		peer.state = PEER_DONE;
+		peer.done_us = te;
+		return;
+	default:
+		/* a status while sending, e.g. an error of the background programming */
+		if (status == SUOTAR_CMP_OK)
+			return;
+		break;
+	}
+	peer.state = PEER_FAILED;
+	peer.status = status;
+}
+
+/*
+ * One connection event: the peer gets the notifications sent before it and sends its
+ * writes. A write request (memory device, GPIO map, patch length) is answered in this
+ * event, the peer sends the next write in the following one.
+ */
+static void connection_event(double te, const struct link *l)
+{
+	double t = te;
+	uint32_t k;
+
+	while (ntf_cnt != 0 && ntf[ntf_head].t <= te) {
+		uint8_t status = ntf[ntf_head].status;
+
+		ntf_head = (ntf_head + 1) % NTF_MAX;
+		ntf_cnt--;
+		peer_status(status, te, l);
+	}
+
+	if (te < peer.ready_us)
+		return;
+
+	for (k = 0; k < l->pkts; k++) {
+		switch (peer.state) {
+		case PEER_MEM_DEV:
+		case PEER_END:
+		{
+			struct suotar_patch_mem_dev_ind *ind;
+
+			t += pkt_us(7);
+			ind = peer_write(SUOTAR_PATCH_MEM_DEV_IND, sizeof(*ind), t);
+			ind->char_code = 1;
+			if (peer.state == PEER_MEM_DEV) {
+				/* any image bank */
+				ind->mem_dev = (uint32_t) SUOTAR_IMG_SPI_FLASH << 24;
+				peer.state = PEER_WAIT_STARTED;
+			} else {
+				ind->mem_dev = (uint32_t) SUOTAR_IMG_END << 24;
+				peer.state = PEER_WAIT_END;
+			}
+			return;
+		}
+		case PEER_GPIO_MAP:
+		{
+			struct suotar_gpio_map_ind *ind;
+
+			t += pkt_us(7);
+			ind = peer_write(SUOTAR_GPIO_MAP_IND, sizeof(*ind), t);
+			ind->char_code = 1;
+			/* MISO P0_5, MOSI P0_6, CS P0_3, SCK P0_0 */
+			ind->gpio_map = 0x05060300;
+			peer.state = PEER_PATCH_LEN;
+			peer.ready_us = te + l->interval_us;
+			return;
+		}
+		case PEER_PATCH_LEN:
+		{
+			struct suotar_patch_len_ind *ind;
+
+			t += pkt_us(5);
+			ind = peer_write(SUOTAR_PATCH_LEN_IND, sizeof(*ind), t);
+			ind->char_code = 1;
+			ind->len = peer.patch_len = peer.block_end - peer.pos;
+			peer.state = PEER_DATA;
+			peer.ready_us = te + l->interval_us;
+			return;
+		}
+		case PEER_DATA:
+		{
+			struct suotar_patch_data_ind *ind;
+			uint32_t len = peer.block_end - peer.pos;
+
+			if (len > l->chunk)
+				len = l->chunk;
+			t += pkt_us(3 + len);
+			if (t > te + l->interval_us)
+				return;
+			ind = peer_write(SUOTAR_PATCH_DATA_IND, sizeof(*ind) + len, t);
+			ind->char_code = 1;
+			ind->len = len;
+			memcpy(ind->pd, &peer.stream[peer.pos], len);
+			peer.pos += len;
+			if (peer.pos == peer.block_end) {
+				peer.state = PEER_WAIT_BLOCK;
+				return;
+			}
+			break;
+		}
+		default:
+			return;
+		}
+	}
+}
+
+/*
+ * Image
+ */
+
+/* An image as sent by the peer: header, code and the XOR of all the bytes before */
+static uint8_t *make_stream(uint32_t code_size, uint32_t *len)
+{
+	uint8_t *stream = malloc(CODE_OFFSET + code_size + ADDITINAL_CRC_SIZE);
+	image_header_t *hdr = (image_header_t *) stream;
+	uint8_t xor = 0;
+	uint32_t i;
+
+	if (stream == NULL) {
+		fprintf(stderr, "out of memory\n");
+		exit(EXIT_FAILURE);
+	}
+	memset(hdr, 0, CODE_OFFSET);
+	for (i = 0; i < code_size; i++)
+		stream[CODE_OFFSET + i] = rnd() >> 8;
+	hdr->signature[0] = IMAGE_HEADER_SIGNATURE1;
+	hdr->signature[1] = IMAGE_HEADER_SIGNATURE2;
+	hdr->code_size = code_size;
+	hdr->CRC = crc32(&stream[CODE_OFFSET], code_size);
+	strcpy((char *) hdr->version, "suota_bench");
+	hdr->timestamp = seed;
+	for (i = 0; i < CODE_OFFSET + code_size; i++)
+		xor ^= stream[i];
+	stream[CODE_OFFSET + code_size] = xor;
+	*len = CODE_OFFSET + code_size + ADDITINAL_CRC_SIZE;
+	return stream;
+}
+
+/* An empty flash with the product header of the two image banks */
+static void flash_setup(void)
+{
+	product_header_t *ph = (product_header_t *) &spi_flash_sim_mem()[PRODUCT_HEADER_POSITION];
+
+	spi_flash_sim_format();
+	ph->signature[0] = PRODUCT_HEADER_SIGNATURE1;
+	ph->signature[1] = PRODUCT_HEADER_SIGNATURE2;
+	ph->version[0] = 0;
+	ph->version[1] = 0;
+	ph->offset1 = IMAGE1_OFFSET;
+	ph->offset2 = IMAGE2_OFFSET;
+}
+
+/* The image is in the first bank, valid, with the header sent by the peer */
+static bool image_ok(const uint8_t *stream, uint32_t code_size)
+{
+	const uint8_t *mem = &spi_flash_sim_mem()[IMAGE1_OFFSET];
+	const image_header_t *hdr = (const image_header_t *) mem;
+	const image_header_t *sent = (const image_header_t *) stream;
+
+	return hdr->signature[0] == IMAGE_HEADER_SIGNATURE1 &&
+	       hdr->signature[1] == IMAGE_HEADER_SIGNATURE2 &&
+	       hdr->validflag == STATUS_VALID_IMAGE &&
+	       hdr->code_size == code_size && hdr->CRC == sent->CRC &&
+	       hdr->timestamp == sent->timestamp &&
+	       !memcmp(hdr->version, sent->version, IMAGE_HEADER_VERSION_SIZE) &&
+	       !memcmp(&mem[CODE_OFFSET], &stream[CODE_OFFSET], code_size);
+}
+
+/*
+ * Update
+ */
+
+/* Run one update: the receiver handles its messages, the connection events run meanwhile */
+static void run_update(const struct receiver *r, const struct link *l, const uint8_t *stream,
+		       uint32_t len, struct result *res)
+{
+	double start, next_event, now;
+	uint32_t blk, i;
+
+	flash_setup();
+	rcv = r;
+	queue_len = 0;
+	max_queue = 0;
+	ntf_head = 0;
+	ntf_cnt = 0;
+	memset(&peer, 0, sizeof(peer));
+	peer.stream = stream;
+	peer.len = len;
+	blk = (len < l->block) ? len : l->block;
+	peer.block_end = blk;
+	peer.state = PEER_MEM_DEV;
+	r->init();
+
+	start = spi_flash_sim_time_us();
+	next_event = start;
+	peer.ready_us = start;
+	while (peer.state != PEER_DONE && peer.state != PEER_FAILED) {
+		now = spi_flash_sim_time_us();
+		if (queue != NULL && queue->t <= now) {
+			struct bench_msg *m = queue;
+			enum ke_msg_status_tag msg_ret = KE_MSG_CONSUMED;
+
+			queue = m->next;
+			queue_len--;
+			spi_flash_sim_advance(cpu_us);
+			if (r->handler(m->msg.id, ke_msg2param(&m->msg), m->msg.dest_id, m->msg.src_id,
+				       &msg_ret) != PR_EVENT_HANDLED) {
+				fprintf(stderr, "%s: message 0x%04x not handled\n", r->name, m->msg.id);
+				exit(EXIT_FAILURE);
+			}
+			free(m);
+		} else {
+			double next = next_event;
+
+			if (queue != NULL && queue->t < next)
+				next = queue->t;
+			spi_flash_sim_advance(next - now);
+		}
+
+		now = spi_flash_sim_time_us();
+		while (next_event <= now) {
+			connection_event(next_event, l);
+			next_event += l->interval_us;
+		}
+		if (now - start > RUN_LIMIT_US) {
+			peer.state = PEER_FAILED;
+			peer.status = 0;
+		}
+	}
+
+	/* Messages left by a failed update */
+	while (queue != NULL) {
+		struct bench_msg *m = queue;
+
+		queue = m->next;
+		free(m);
+	}
+
+	memset(res, 0, sizeof(*res));
+	res->status = (peer.state == PEER_DONE) ? SUOTAR_CMP_OK : peer.status;
+	if (peer.state == PEER_DONE) {
+		res->time_s = (peer.done_us - start) / 1000000;
+		res->kbps = len / 1024.0 / res->time_s;
+	}
+	for (i = 0; i < FLASH_SIZE / SPI_FLASH_SECTOR_SIZE; i++)
+		res->erases += spi_flash_sim_sector_erases(i);
+	res->max_queue = max_queue;
+}
+
+static void run_link(const struct link *l, const uint8_t *stream, uint32_t len, uint32_t code_size)
+{
+	struct result res;
+	uint8_t *bad;
+	char what[128];
+	unsigned int k;
+
+	bad = malloc(len);
+	if (bad == NULL) {
+		fprintf(stderr, "out of memory\n");
+		exit(EXIT_FAILURE);
+	}
+	memcpy(bad, stream, len);
+	bad[CODE_OFFSET + code_size / 2] ^= 0x10;
+
+	for (k = 0; k < NB_RECEIVERS; k++) {
+		run_update(&receivers[k], l, stream, len, &res);
+		snprintf(what, sizeof(what), "%s, %s: update done (status 0x%02x)", l->name,
+			 receivers[k].name, res.status);
+		expect(res.status == SUOTAR_CMP_OK, what);
+		snprintf(what, sizeof(what), "%s, %s: image in the flash", l->name, receivers[k].name);
+		expect(image_ok(stream, code_size), what);
+		printf("%-16s %-12s %8.2f %8.2f %8u %8u\n", l->name, receivers[k].name, res.time_s,
+		       res.kbps, res.erases, res.max_queue);
+
+		run_update(&receivers[k], l, bad, len, &res);
+		snprintf(what, sizeof(what), "%s, %s: corrupted image rejected (status 0x%02x)", l->name,
+			 receivers[k].name, res.status);
+		expect(res.status == SUOTAR_CRC_ERR, what);
+		expect(spi_flash_sim_mem()[IMAGE1_OFFSET + 2] != STATUS_VALID_IMAGE, what);
+	}
+	free(bad);
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t code_size, len;
+	uint8_t *stream;
+	unsigned int k;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "s:u:i:p:c:b:S:")) != -1) {
+		switch (opt) {
+		case 's':
+			image_kb = strtoul(optarg, NULL, 0);
+			break;
+		case 'u':
+			cpu_us = strtod(optarg, NULL);
+			break;
+		case 'i':
+			custom_link.interval_us = strtoul(optarg, NULL, 0);
+			custom = true;
+			break;
+		case 'p':
+			custom_link.pkts = strtoul(optarg, NULL, 0);
+			custom = true;
+			break;
+		case 'c':
+			custom_link.chunk = strtoul(optarg, NULL, 0);
+			custom = true;
+			break;
+		case 'b':
+			custom_link.block = strtoul(optarg, NULL, 0);
+			custom = true;
+			break;
+		case 'S':
+			seed = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	if (custom) {
+		custom_link.name = "custom";
+		if (custom_link.interval_us == 0)
+			custom_link.interval_us = links[0].interval_us;
+		if (custom_link.pkts == 0)
+			custom_link.pkts = links[0].pkts;
+		if (custom_link.chunk == 0)
+			custom_link.chunk = links[0].chunk;
+		if (custom_link.block == 0)
+			custom_link.block = links[0].block;
+	}
+	code_size = image_kb * 1024;
+	if (optind != argc || code_size == 0 || code_size > IMAGE_CODE_MAX || cpu_us < 0 ||
+	    (custom && (custom_link.chunk > 244 || custom_link.block < CODE_OFFSET ||
+			custom_link.block > SUOTA_OVERALL_PD_SIZE ||
+			pkt_us(3 + custom_link.chunk) > custom_link.interval_us))) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	spi_flash_sim_init(FLASH_SIZE);
+	stream = make_stream(code_size, &len);
+
+	printf("image %u bytes, %.0f us per kernel message\n", len, cpu_us);
+	printf("%-16s %-12s %8s %8s %8s %8s\n", "link", "receiver", "time s", "KB/s", "erases",
+	       "queue");
+	if (custom)
+		run_link(&custom_link, stream, len, code_size);
+	else
+		for (k = 0; k < NB_LINKS; k++)
+			run_link(&links[k], stream, len, code_size);
+	free(stream);
+
+	if (errors) {
+		printf("\nFAILED, %d errors\n", errors);
+		return EXIT_FAILURE;
+	}
+	printf("\nOK\n");
+
+	return EXIT_SUCCESS;
+}
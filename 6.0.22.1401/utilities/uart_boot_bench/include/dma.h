@@ -0,0 +1,28 @@
+/**
+ ****************************************************************************************
+ *
+ * @file dma.h
+ *
+ * @brief DMA driver API of the host build of the UART booter.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _DMA_H_
+#define _DMA_H_
+
+/*
+ * Host subset of sdk/platform/driver/dma/dma.h. Only the UART receive channel is
+ * modelled, by uart_boot_bench.c.
+ */
+
+typedef enum {
+	DMA_CHANNEL_0 = 0,
+	DMA_CHANNEL_1 = 1,
+} DMA_ID;
+
+void dma_channel_cancel(DMA_ID id);
+
+#endif /* _DMA_H_ */
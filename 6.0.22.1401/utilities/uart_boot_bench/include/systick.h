@@ -0,0 +1,29 @@
+/**
+ ****************************************************************************************
+ *
+ * @file systick.h
+ *
+ * @brief SysTick driver API of the host build of the UART booter.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _SYSTICK_H_
+#define _SYSTICK_H_
+
+/*
+ * Host subset of sdk/platform/driver/systick/systick.h, implemented by uart_boot_bench.c
+ * with the monotonic clock of the host.
+ */
+
+#include <stdint.h>
+
+typedef void (*systick_callback_function_t)(void);
+
+void systick_register_callback(systick_callback_function_t callback);
+void systick_start(uint32_t usec, uint8_t exception);
+void systick_stop(void);
+
+#endif /* _SYSTICK_H_ */
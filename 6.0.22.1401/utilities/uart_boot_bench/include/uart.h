@@ -0,0 +1,56 @@
+/**
+ ****************************************************************************************
+ *
+ * @file uart.h
+ *
+ * @brief UART driver API of the host build of the UART booter.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _UART_H_
+#define _UART_H_
+
+/*
+ * Host subset of sdk/platform/driver/uart/uart.h, used by uart_booter.c. UART1 is
+ * connected to a pseudo terminal by uart_boot_bench.c, which implements these functions.
+ */
+
+#include <stdint.h>
+
+typedef struct {
+	int id;
+} uart_t;
+
+extern uart_t host_uart1;
+
+#define UART1				(&host_uart1)
+
+/* Divisor values of the SDK, the bench maps them to bit rates */
+typedef enum {
+	UART_BAUDRATE_1000000		= 0x000100,
+	UART_BAUDRATE_921600		= 0x000101,
+	UART_BAUDRATE_500000		= 0x000200,
+	UART_BAUDRATE_460800		= 0x000203,
+	UART_BAUDRATE_230400		= 0x000405,
+	UART_BAUDRATE_115200		= 0x00080b,
+	UART_BAUDRATE_57600		= 0x001106,
+} UART_BAUDRATE;
+
+typedef enum {
+	UART_OP_BLOCKING,
+	UART_OP_INTR,
+	UART_OP_DMA,
+} UART_OP_CFG;
+
+void uart_baudrate_setf(uart_t *uart_id, UART_BAUDRATE baud_rate);
+uint16_t uart_data_ready_getf(uart_t *uart_id);
+uint8_t uart_read_byte(uart_t *uart_id);
+void uart_write_byte(uart_t *uart_id, uint8_t data);
+void uart_write_buffer(uart_t *uart_id, const uint8_t *data, uint16_t len);
+void uart_wait_tx_finish(uart_t *uart_id);
+void uart_receive(uart_t *uart_id, uint8_t *data, uint16_t len, UART_OP_CFG op);
+
+#endif /* _UART_H_ */
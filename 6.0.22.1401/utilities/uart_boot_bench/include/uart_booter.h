@@ -0,0 +1,30 @@
+/**
+ ****************************************************************************************
+ *
+ * @file uart_booter.h
+ *
+ * @brief UART booter definitions of the host build.
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _HOST_UART_BOOTER_H_
+#define _HOST_UART_BOOTER_H_
+
+/*
+ * secondary_bootloader/includes/uart_booter.h, with the copy area moved from address
+ * 0x300 to the same offset in host_sysram[]. MAX_CODE_LENGTH is kept.
+ */
+
+#include_next "uart_booter.h"
+
+#undef SYSRAM_COPY_BASE_ADDRESS
+#define SYSRAM_COPY_BASE_ADDRESS	(SDK_RAM_1_BASE_ADDR + SDK_SEC_BOOTLOADER_COPY_BASE_ADDRESS)
+
+#undef MAX_CODE_LENGTH
+#define MAX_CODE_LENGTH			(SDK_SEC_BOOTLOADER_LOAD_IMAGE_SIZE_INIT_VALUE - \
+					 SDK_SEC_BOOTLOADER_COPY_BASE_ADDRESS)
+
+#endif /* _HOST_UART_BOOTER_H_ */
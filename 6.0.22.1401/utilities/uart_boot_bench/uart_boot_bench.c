@@ -0,0 +1,601 @@
+/**
+ ****************************************************************************************
+ *
+ * @file uart_boot_bench.c
+ *
+ * @brief Loopback benchmark of the UART booter of the secondary bootloader
+ *
+ * Copyright (C) 2024 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "uart.h"
+#include "systick.h"
+#include "dma.h"
+#include "uart_booter.h"
+
+#define UART_BOOT_BENCH_VERSION	"v_1.0"
+
+/* Receive FIFO of the UART */
+#define RX_FIFO_SIZE		16
+
+/* Bytes written by the sender that are not on the line yet */
+#define LINE_BUF_SIZE		4096
+
+/* Baud rate of the STX/SOH handshake (UART_FRAC_BAUDRATE of the DA14585) */
+#define HANDSHAKE_RATE		57600
+
+/* Time given to the sender to open the pseudo terminal and answer STX */
+#define STX_TIMEOUT_US		10000000
+
+/* Most bytes dropped by -d */
+#define MAX_DROPS		64
+
+/* The SYSRAM the image is received to */
+uint8_t host_sysram[SDK_SEC_BOOTLOADER_LOAD_IMAGE_SIZE_INIT_VALUE];
+
+uart_t host_uart1;
+
+int FwDownload(void);
+void uart_receive_callback(uint16_t length);
+
+static const struct {
+	UART_BAUDRATE divisor;
+	unsigned int rate;
+} bit_rates[] = {
+	{ UART_BAUDRATE_57600, 57600 },
+	{ UART_BAUDRATE_115200, 115200 },
+	{ UART_BAUDRATE_230400, 230400 },
+	{ UART_BAUDRATE_460800, 460800 },
+	{ UART_BAUDRATE_500000, 500000 },
+	{ UART_BAUDRATE_921600, 921600 },
+	{ UART_BAUDRATE_1000000, 1000000 },
+};
+
+/* Bit rates of the framed protocol, indexed by FRAMED_BAUD_xxx */
+static const unsigned int framed_rates[FRAMED_BAUD_MAX] = {
+	HANDSHAKE_RATE, 115200, 230400, 460800, 921600, 1000000,
+};
+
+/*
+ * The UART of the device, its line and its SysTick. The line runs in its own thread,
+ * which also calls the receive and SysTick callbacks, as the interrupts would.
+ */
+static pthread_mutex_t hw_lock;
+
+static struct {
+	pthread_t thread;
+	volatile bool stop;
+	int fd;
+	unsigned int rate;
+	/* Bytes written by the sender, put on the line at the bit rate */
+	uint8_t line[LINE_BUF_SIZE];
+	unsigned int line_in;
+	unsigned int line_out;
+	uint64_t line_time;
+	uint8_t fifo[RX_FIFO_SIZE];
+	unsigned int fifo_in;
+	unsigned int fifo_out;
+	/* Transfer started by uart_receive() */
+	bool rx_busy;
+	uint8_t *rx_buf;
+	uint16_t rx_len;
+	uint16_t rx_count;
+	/* SysTick */
+	systick_callback_function_t tick_cb;
+	bool tick_on;
+	uint64_t tick_period;
+	uint64_t tick_deadline;
+	/* Fault injection: indexes of the received bytes to drop, and where the line is cut */
+	uint64_t rx_bytes;
+	uint64_t drops[MAX_DROPS + 1];
+	unsigned int nb_drops;
+	unsigned int next_drop;
+	uint64_t cut_at;
+	/* Statistics */
+	unsigned int dropped;
+	unsigned int resyncs;
+} hw;
+
+struct bench_case {
+	const char *name;
+	bool legacy;
+	unsigned int baud;
+	unsigned int block_log2;
+	/* Bytes dropped at random (-d), and the last byte of the stream (a frame that stalls) */
+	bool drops;
+	bool stall;
+	/* Line cut in the middle of the image: the download must fail */
+	bool cut;
+};
+
+static const struct bench_case cases[] = {
+	{ "legacy", true,  0, 12, false, false, false },
+	{ "framed", false, 0, 12, false, false, false },
+	{ "framed", false, 1, 12, false, false, false },
+	{ "framed", false, 2, 12, false, false, false },
+	{ "framed", false, 3, 12, false, false, false },
+	{ "framed", false, 4, 12, false, false, false },
+	{ "framed", false, 5, 12, false, false, false },
+	{ "framed", false, 5, 10, false, false, false },
+	{ "framed", false, 5,  8, false, false, false },
+	{ "stall",  false, 5, 12, false, true,  false },
+	{ "drops",  false, 5, 12, true,  true,  false },
+	{ "cut",    false, 5, 12, false, false, true  },
+};
+
+#define NUM_CASES		(sizeof(cases) / sizeof(cases[0]))
+
+static const char *sender = "uart_boot_sender.exe";
+static uint32_t image_size = 32 * 1024;
+static unsigned int random_drops = 4;
+static int verbose;
+static uint32_t seed = 1;
+static int errors;
+
+static void usage(const char* my_name)
+{
+	fprintf(stderr,
+		"Version: " UART_BOOT_BENCH_VERSION "\n"
+		"\n"
+		"Usage: %s [-s size] [-d drops] [-S sender] [-v]\n"
+		"\n"
+		"  Runs FwDownload() of the secondary bootloader (uart_booter.c, built\n"
+		"  with CFG_UART_FRAMED_BOOT) on the host, with UART1 connected to a\n"
+		"  pseudo terminal, and downloads images to it with uart_boot_sender.\n"
+		"  The bytes written by the sender are put on the line at the bit rate\n"
+		"  of the UART and the device side runs the protocol with the timeouts\n"
+		"  of the target. The answers of the device and its CPU time are not\n"
+		"  charged, and the line waits while the receive FIFO is full, as the\n"
+		"  host may not run the device in time. Reports the throughput of the STX/SOH protocol and of the\n"
+		"  framed one at each baud rate, then checks the framed protocol with\n"
+		"  lost bytes: the last byte of the image (a frame that stalls), random\n"
+		"  bytes, and a line cut in the middle of the image, which the device\n"
+		"  must give up after a few resyncs.\n"
+		"\n"
+		"  -s size       image size in bytes (default 32768)\n"
+		"  -d drops      random bytes dropped by the 'drops' case (default 4)\n"
+		"  -S sender     uart_boot_sender executable (default %s)\n"
+		"  -v            show the output of the sender\n",
+		my_name, sender);
+}
+
+static uint32_t rnd(void)
+{
+	seed = seed * 1103515245 + 12345;
+	return seed >> 8;
+}
+
+static void expect(bool cond, const char *what, const char *name)
+{
+	if (!cond) {
+		printf("  %s: %s\n", name, what);
+		errors++;
+	}
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/*
+ * UART driver of the device. The callbacks are called with the lock held, which is
+ * recursive so that they can start the next transfer.
+ */
+
+/* A byte has been received by the UART, the FIFO has room for it */
+static void rx_byte(uint8_t b)
+{
+	if (hw.rx_busy) {
+		hw.rx_buf[hw.rx_count++] = b;
+		if (hw.rx_count == hw.rx_len) {
+			hw.rx_busy = false;
+			uart_receive_callback(hw.rx_len);
+		}
+	} else {
+		hw.fifo[hw.fifo_in++ % RX_FIFO_SIZE] = b;
+	}
+}
+
+void uart_baudrate_setf(uart_t *uart_id, UART_BAUDRATE baud_rate)
+{
+	unsigned int i;
+
+	pthread_mutex_lock(&hw_lock);
+	for (i = 0; i < sizeof(bit_rates) / sizeof(bit_rates[0]); i++)
+		if (bit_rates[i].divisor == baud_rate)
+			hw.rate = bit_rates[i].rate;
+	pthread_mutex_unlock(&hw_lock);
+}
+
+uint16_t uart_data_ready_getf(uart_t *uart_id)
+{
+	uint16_t ready;
+
+	pthread_mutex_lock(&hw_lock);
+	ready = hw.fifo_in != hw.fifo_out;
+	pthread_mutex_unlock(&hw_lock);
+	return ready;
+}
+
+uint8_t uart_read_byte(uart_t *uart_id)
+{
+	uint8_t b = 0;
+
+	pthread_mutex_lock(&hw_lock);
+	if (hw.fifo_in != hw.fifo_out)
+		b = hw.fifo[hw.fifo_out++ % RX_FIFO_SIZE];
+	pthread_mutex_unlock(&hw_lock);
+	return b;
+}
+
+void uart_write_buffer(uart_t *uart_id, const uint8_t *data, uint16_t len)
+{
+	ssize_t n;
+
+	if (len == 3 && data[0] == NAK && (data[1] | (data[2] << 8)) == FRAMED_SEQ_RESYNC)
+		hw.resyncs++;
+
+	while (len > 0) {
+		n = write(hw.fd, data, len);
+		if (n < 0) {
+			if (errno == EINTR || errno == EAGAIN)
+				continue;
+			return;
+		}
+		data += n;
+		len -= n;
+	}
+}
+
+void uart_write_byte(uart_t *uart_id, uint8_t data)
+{
+	uart_write_buffer(uart_id, &data, 1);
+}
+
+void uart_wait_tx_finish(uart_t *uart_id)
+{
+}
+
+void uart_receive(uart_t *uart_id, uint8_t *data, uint16_t len, UART_OP_CFG op)
+{
+	pthread_mutex_lock(&hw_lock);
+	hw.rx_buf = data;
+	hw.rx_len = len;
+	hw.rx_count = 0;
+	hw.rx_busy = true;
+	// The bytes waiting in the FIFO are read first
+	while (hw.rx_busy && hw.fifo_in != hw.fifo_out) {
+		uint8_t b = hw.fifo[hw.fifo_out++ % RX_FIFO_SIZE];
+
+		hw.rx_buf[hw.rx_count++] = b;
+		if (hw.rx_count == hw.rx_len) {
+			hw.rx_busy = false;
+			uart_receive_callback(hw.rx_len);
+		}
+	}
+	pthread_mutex_unlock(&hw_lock);
+}
+
+void dma_channel_cancel(DMA_ID id)
+{
+	pthread_mutex_lock(&hw_lock);
+	hw.rx_busy = false;
+	pthread_mutex_unlock(&hw_lock);
+}
+
+void systick_register_callback(systick_callback_function_t callback)
+{
+	pthread_mutex_lock(&hw_lock);
+	hw.tick_cb = callback;
+	pthread_mutex_unlock(&hw_lock);
+}
+
+void systick_start(uint32_t usec, uint8_t exception)
+{
+	pthread_mutex_lock(&hw_lock);
+	hw.tick_period = usec * 1000ULL;
+	hw.tick_deadline = now_ns() + usec * 1000ULL;
+	hw.tick_on = true;
+	pthread_mutex_unlock(&hw_lock);
+}
+
+void systick_stop(void)
+{
+	pthread_mutex_lock(&hw_lock);
+	hw.tick_on = false;
+	pthread_mutex_unlock(&hw_lock);
+}
+
+/* Decide whether the next byte of the line is lost */
+static bool drop_byte(void)
+{
+	uint64_t index = hw.rx_bytes++;
+	bool drop = index >= hw.cut_at;
+
+	while (hw.next_drop < hw.nb_drops && hw.drops[hw.next_drop] <= index) {
+		if (hw.drops[hw.next_drop] == index)
+			drop = true;
+		hw.next_drop++;
+	}
+	if (drop)
+		hw.dropped++;
+	return drop;
+}
+
+/* As uart_disable(), called by the bootloader after each download attempt */
+static void uart_stop(void)
+{
+	pthread_mutex_lock(&hw_lock);
+	hw.rx_busy = false;
+	hw.fifo_out = hw.fifo_in;
+	hw.tick_on = false;
+	pthread_mutex_unlock(&hw_lock);
+}
+
+static void *line_thread(void *arg)
+{
+	struct pollfd pfd = { .fd = hw.fd, .events = POLLIN };
+	uint64_t now, byte_ns;
+	ssize_t n;
+
+	while (!hw.stop) {
+		pthread_mutex_lock(&hw_lock);
+		now = now_ns();
+
+		// Bytes written by the sender
+		if (poll(&pfd, 1, 0) > 0 && (pfd.revents & POLLIN) &&
+		    hw.line_in - hw.line_out < LINE_BUF_SIZE) {
+			unsigned int pos = hw.line_in % LINE_BUF_SIZE;
+			unsigned int room = LINE_BUF_SIZE - (hw.line_in - hw.line_out);
+
+			if (room > LINE_BUF_SIZE - pos)
+				room = LINE_BUF_SIZE - pos;
+			if (hw.line_in == hw.line_out && hw.line_time < now)
+				hw.line_time = now;
+			n = read(hw.fd, &hw.line[pos], room);
+			if (n > 0)
+				hw.line_in += n;
+		}
+
+		// Bytes whose last bit has been sent, 10 bits per byte. The line waits while the
+		// FIFO is full: the target reads it in time, the host may not run the device then
+		byte_ns = 10000000000ULL / hw.rate;
+		while (hw.line_in != hw.line_out && hw.line_time + byte_ns <= now &&
+		       (hw.rx_busy || hw.fifo_in - hw.fifo_out < RX_FIFO_SIZE)) {
+			uint8_t b = hw.line[hw.line_out++ % LINE_BUF_SIZE];
+
+			hw.line_time += byte_ns;
+			if (!drop_byte())
+				rx_byte(b);
+		}
+
+		if (hw.tick_on && now >= hw.tick_deadline) {
+			hw.tick_deadline += hw.tick_period;
+			if (hw.tick_cb != NULL)
+				hw.tick_cb();
+		}
+		pthread_mutex_unlock(&hw_lock);
+
+		usleep(5);
+	}
+
+	return NULL;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static pid_t start_sender(const struct bench_case *c, const char *tty, const char *file)
+{
+	char rate[16], baud[16], block[16];
+	pid_t pid;
+
+	snprintf(rate, sizeof(rate), "%u", HANDSHAKE_RATE);
+	snprintf(baud, sizeof(baud), "%u", c->baud);
+	snprintf(block, sizeof(block), "%u", c->block_log2);
+
+	pid = fork();
+	if (pid != 0)
+		return pid;
+
+	if (!verbose) {
+		int null = open("/dev/null", O_WRONLY);
+
+		dup2(null, STDOUT_FILENO);
+		dup2(null, STDERR_FILENO);
+	}
+	if (c->legacy)
+		execl(sender, sender, "-l", "-r", rate, tty, file, (char *)NULL);
+	else
+		execl(sender, sender, "-r", rate, "-b", baud, "-k", block, tty, file, (char *)NULL);
+	fprintf(stderr, "Could not run %s: %s\n", sender, strerror(errno));
+	_exit(127);
+}
+
+static void run_case(const struct bench_case *c, const uint8_t *image, const char *file)
+{
+	uint32_t blocks = (image_size + (1U << c->block_log2) - 1) >> c->block_log2;
+	/* SOB, the header, then each block once with its seq[2] ~seq[2] and crc[4] */
+	uint64_t stream = 1 + 14 + image_size + 8 * (uint64_t)blocks;
+	unsigned int rate = c->legacy ? HANDSHAKE_RATE : framed_rates[c->baud];
+	uint64_t start, deadline, elapsed;
+	struct termios tio;
+	int ret, status, i;
+	pid_t pid;
+
+	memset(&hw, 0, sizeof(hw));
+	hw.rate = HANDSHAKE_RATE;
+	hw.cut_at = c->cut ? 15 + image_size / 2 : UINT64_MAX;
+	if (c->stall)
+		hw.drops[hw.nb_drops++] = stream - 1;
+	if (c->drops)
+		for (i = 0; i < (int)random_drops; i++)
+			hw.drops[hw.nb_drops++] = 15 + rnd() % (stream - 15);
+	qsort(hw.drops, hw.nb_drops, sizeof(hw.drops[0]), cmp_u64);
+	memset(host_sysram, 0, sizeof(host_sysram));
+
+	// Raw from the start, so that STX is not echoed before the sender configures the tty
+	hw.fd = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+	if (hw.fd < 0 || grantpt(hw.fd) < 0 || unlockpt(hw.fd) < 0 || tcgetattr(hw.fd, &tio) < 0) {
+		fprintf(stderr, "Could not open a pseudo terminal: %s\n", strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	cfmakeraw(&tio);
+	tcsetattr(hw.fd, TCSANOW, &tio);
+
+	pid = start_sender(c, ptsname(hw.fd), file);
+	if (pid < 0) {
+		fprintf(stderr, "Could not fork: %s\n", strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	pthread_create(&hw.thread, NULL, line_thread, NULL);
+
+	// As the bootloader, try again until the sender answers STX
+	deadline = now_ns() + STX_TIMEOUT_US * 1000ULL;
+	do {
+		start = now_ns();
+		ret = FwDownload();
+		uart_stop();
+	} while (ret == -1 && now_ns() < deadline);
+	elapsed = now_ns() - start;
+
+	waitpid(pid, &status, 0);
+	hw.stop = true;
+	pthread_join(hw.thread, NULL);
+	close(hw.fd);
+
+	if (c->legacy)
+		printf("%-8s %8u %6s", c->name, rate, "-");
+	else
+		printf("%-8s %8u %6u", c->name, rate, 1U << c->block_log2);
+
+	if (c->cut) {
+		printf(" %9s %6s %8u %7u\n", "-", "-", hw.resyncs, hw.dropped);
+		expect(ret == -12, "the download was not aborted", c->name);
+		expect(hw.resyncs > 0, "no resync before the abort", c->name);
+		expect(!WIFEXITED(status) || WEXITSTATUS(status) != 0, "the sender succeeded", c->name);
+		return;
+	}
+
+	printf(" %9.2f %5.1f%% %8u %7u\n", image_size / (elapsed / 1e9) / 1000,
+	       100.0 * image_size / (elapsed / 1e9) / (rate / 10.0), hw.resyncs, hw.dropped);
+	expect(ret == (int)image_size, "download failed", c->name);
+	expect(ret != (int)image_size ||
+	       memcmp((uint8_t *)SYSRAM_COPY_BASE_ADDRESS, image, image_size) == 0,
+	       "image mismatch", c->name);
+	expect(WIFEXITED(status) && WEXITSTATUS(status) == 0, "the sender failed", c->name);
+	if (c->stall)
+		expect(hw.resyncs > 0, "no resync", c->name);
+}
+
+int main(int argc, char **argv)
+{
+	char file[] = "/tmp/uart_boot_bench_XXXXXX";
+	pthread_mutexattr_t attr;
+	uint8_t *image;
+	unsigned int i;
+	int opt, fd;
+
+	while ((opt = getopt(argc, argv, "s:d:S:v")) != -1) {
+		switch (opt) {
+		case 's':
+			image_size = strtoul(optarg, NULL, 0);
+			break;
+		case 'd':
+			random_drops = strtoul(optarg, NULL, 0);
+			break;
+		case 'S':
+			sender = optarg;
+			break;
+		case 'v':
+			verbose = 1;
+			break;
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (optind != argc || image_size < 2 || image_size > MAX_CODE_LENGTH ||
+	    random_drops > MAX_DROPS) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	image = malloc(image_size);
+	if (image == NULL)
+		return EXIT_FAILURE;
+	for (i = 0; i < image_size; i++)
+		image[i] = rnd();
+	fd = mkstemp(file);
+	if (fd < 0 || write(fd, image, image_size) != (ssize_t)image_size) {
+		fprintf(stderr, "Could not write %s: %s\n", file, strerror(errno));
+		return EXIT_FAILURE;
+	}
+	close(fd);
+
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&hw_lock, &attr);
+
+	printf("%u bytes, handshake at %u baud\n", image_size, HANDSHAKE_RATE);
+	printf("%-8s %8s %6s %9s %6s %8s %7s\n", "case", "baud", "block", "kB/s", "line",
+	       "resyncs", "dropped");
+	for (i = 0; i < NUM_CASES; i++)
+		run_case(&cases[i], image, file);
+
+	unlink(file);
+	free(image);
+
+	if (errors) {
+		printf("FAILED, %d errors\n", errors);
+		return EXIT_FAILURE;
+	}
+	printf("OK\n");
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,546 @@
+/**
+ ****************************************************************************************
+ *
+ * @file uart_boot_sender.c
+ *
+ * @brief Host sender of the secondary bootloader UART boot protocols.
+ *
+ * Copyright (C) 2023 Renesas Electronics Corporation and/or its affiliates.
+ * All rights reserved. Confidential Information.
+ *
+ * This software ("Software") is supplied by Renesas Electronics Corporation and/or its
+ * affiliates ("Renesas"). Renesas grants you a personal, non-exclusive, non-transferable,
+ * revocable, non-sub-licensable right and license to use the Software, solely if used in
+ * or together with Renesas products. You may make copies of this Software, provided this
+ * copyright notice and disclaimer ("Notice") is included in all such copies. Renesas
+ * reserves the right to change or discontinue the Software at any time without notice.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS". RENESAS DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED, OR STATUTORY, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. TO THE
+ * MAXIMUM EXTENT PERMITTED UNDER LAW, IN NO EVENT SHALL RENESAS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE, EVEN IF RENESAS HAS BEEN ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGES. USE OF THIS SOFTWARE MAY BE SUBJECT TO TERMS AND CONDITIONS CONTAINED IN
+ * AN ADDITIONAL AGREEMENT BETWEEN YOU AND RENESAS. IN CASE OF CONFLICT BETWEEN THE TERMS
+ * OF THIS NOTICE AND ANY SUCH ADDITIONAL LICENSE AGREEMENT, THE TERMS OF THE AGREEMENT
+ * SHALL TAKE PRECEDENCE. BY CONTINUING TO USE THIS SOFTWARE, YOU AGREE TO THE TERMS OF
+ * THIS NOTICE.IF YOU DO NOT AGREE TO THESE TERMS, YOU ARE NOT PERMITTED TO USE THIS
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+#define _DEFAULT_SOURCE
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define UART_BOOT_SENDER_VERSION	"v_1.0"
+
+/* These must match uart_booter.h of the secondary bootloader */
+#define SOH		0x01
+#define STX		0x02
+#define EOT		0x04
+#define ACK		0x06
+#define SOB		0x11
+#define NAK		0x15
+#define CAN		0x18
+
+#define FRAMED_BLOCK_LOG2_MIN	8
+#define FRAMED_BLOCK_LOG2_MAX	12
+#define FRAMED_SEQ_RESYNC	0xFFFF
+
+/* Answer timeout (ms) */
+#define ANSWER_TIMEOUT		2000
+
+/* Time (ms) to wait for the STX of the device */
+#define STX_TIMEOUT		10000
+
+enum block_state {
+	BLOCK_TO_SEND,
+	BLOCK_SENT,
+	BLOCK_ACKED,
+};
+
+/* Baud rates of the framed boot protocol, indexed as FRAMED_BAUD_xxx */
+static const struct {
+	speed_t speed;
+	unsigned int rate;
+} baud_rates[] = {
+	{ 0, 0 },		/* keep the handshake baud rate */
+	{ B115200, 115200 },
+	{ B230400, 230400 },
+	{ B460800, 460800 },
+	{ B921600, 921600 },
+	{ B1000000, 1000000 },
+};
+
+#define BAUD_RATES	(sizeof(baud_rates) / sizeof(baud_rates[0]))
+
+static uint32_t crc32_table[256];
+
+static void usage(const char* my_name)
+{
+	fprintf(stderr,
+		"Version: " UART_BOOT_SENDER_VERSION "\n"
+		"\n"
+		"Usage:\n"
+		"  %s [-l] [-r rate] [-b baud] [-k block_log2] [-w window] tty app_bin\n"
+		"\n"
+		"  Download 'app_bin' to the secondary bootloader through the\n"
+		"  serial port 'tty' (a UART or a pseudo terminal).\n"
+		"  -l            use the STX/SOH protocol instead of the framed one\n"
+		"  -r rate       handshake baud rate (default 115200)\n"
+		"  -b baud       framed protocol baud rate index (default 5):\n"
+		"                0: handshake rate, 1: 115200, 2: 230400,\n"
+		"                3: 460800, 4: 921600, 5: 1000000\n"
+		"  -k block_log2 framed protocol block size, %d to %d (default 12)\n"
+		"  -w window     frames sent ahead of the answers (default: as\n"
+		"                many as the device accepts)\n"
+		"  The effective throughput is reported when the download is done.\n",
+		my_name, FRAMED_BLOCK_LOG2_MIN, FRAMED_BLOCK_LOG2_MAX);
+}
+
+static void crc32_init(void)
+{
+	uint32_t i, j, c;
+
+	for (i = 0; i < 256; i++) {
+		c = i;
+		for (j = 0; j < 8; j++)
+			c = (c & 1) ? (c >> 1) ^ 0xEDB88320 : c >> 1;
+		crc32_table[i] = c;
+	}
+}
+
+/* Same as crc32() of the secondary bootloader (zlib compatible) */
+static uint32_t crc32(uint32_t crc, const uint8_t *buf, size_t size)
+{
+	crc = ~crc;
+	while (size--)
+		crc = crc32_table[(crc ^ *buf++) & 0xFF] ^ (crc >> 8);
+	return ~crc;
+}
+
+static double now_s(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static speed_t rate_to_speed(unsigned int rate)
+{
+	unsigned int i;
+
+	for (i = 1; i < BAUD_RATES; i++)
+		if (baud_rates[i].rate == rate)
+			return baud_rates[i].speed;
+	switch (rate) {
+	case 9600: return B9600;
+	case 19200: return B19200;
+	case 38400: return B38400;
+	case 57600: return B57600;
+	default: return 0;
+	}
+}
+
+static int set_speed(int fd, speed_t speed)
+{
+	struct termios tio;
+
+	if (tcgetattr(fd, &tio) < 0)
+		return -1;
+	cfsetispeed(&tio, speed);
+	cfsetospeed(&tio, speed);
+	return tcsetattr(fd, TCSANOW, &tio);
+}
+
+static int open_tty(const char *name, speed_t speed)
+{
+	struct termios tio;
+	int fd;
+
+	fd = open(name, O_RDWR | O_NOCTTY);
+	if (fd < 0) {
+		fprintf(stderr, "Could not open %s: %s\n", name, strerror(errno));
+		return -1;
+	}
+
+	if (tcgetattr(fd, &tio) < 0) {
+		fprintf(stderr, "%s is not a serial port: %s\n", name, strerror(errno));
+		close(fd);
+		return -1;
+	}
+	cfmakeraw(&tio);
+	tio.c_cflag |= CLOCAL | CREAD;
+	tio.c_cflag &= ~(CSTOPB | CRTSCTS);
+	tio.c_cc[VMIN] = 1;
+	tio.c_cc[VTIME] = 0;
+	cfsetispeed(&tio, speed);
+	cfsetospeed(&tio, speed);
+	if (tcsetattr(fd, TCSANOW, &tio) < 0) {
+		fprintf(stderr, "Could not configure %s: %s\n", name, strerror(errno));
+		close(fd);
+		return -1;
+	}
+	tcflush(fd, TCIOFLUSH);
+
+	return fd;
+}
+
+static int write_all(int fd, const uint8_t *buf, size_t len)
+{
+	ssize_t n;
+
+	while (len > 0) {
+		n = write(fd, buf, len);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		buf += n;
+		len -= n;
+	}
+	return 0;
+}
+
+/* Read exactly 'len' bytes, giving up after 'timeout_ms' of silence */
+static int read_all(int fd, uint8_t *buf, size_t len, int timeout_ms)
+{
+	struct pollfd pfd = { .fd = fd, .events = POLLIN };
+	ssize_t n;
+
+	while (len > 0) {
+		n = poll(&pfd, 1, timeout_ms);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		if (n == 0)
+			return -1;
+		n = read(fd, buf, len);
+		if (n <= 0)
+			return -1;
+		buf += n;
+		len -= n;
+	}
+	return 0;
+}
+
+static int wait_stx(int fd)
+{
+	uint8_t c;
+
+	do {
+		if (read_all(fd, &c, 1, STX_TIMEOUT) < 0) {
+			fprintf(stderr, "No STX received from the device\n");
+			return -1;
+		}
+	} while (c != STX);
+
+	return 0;
+}
+
+static int send_legacy(int fd, const uint8_t *image, size_t size)
+{
+	uint8_t hdr[6];
+	size_t hdr_len;
+	uint8_t crc = 0, c;
+	size_t i;
+
+	hdr[0] = SOH;
+	if (size < 0x10000) {
+		hdr[1] = size & 0xFF;
+		hdr[2] = size >> 8;
+		hdr_len = 3;
+	} else {
+		/* extended length */
+		hdr[1] = 0;
+		hdr[2] = 0;
+		hdr[3] = size & 0xFF;
+		hdr[4] = (size >> 8) & 0xFF;
+		hdr[5] = (size >> 16) & 0xFF;
+		hdr_len = 6;
+	}
+
+	if (write_all(fd, hdr, hdr_len) < 0 || read_all(fd, &c, 1, ANSWER_TIMEOUT) < 0) {
+		fprintf(stderr, "No answer to the header\n");
+		return -1;
+	}
+	if (c != ACK) {
+		fprintf(stderr, "The device rejected the image size\n");
+		return -1;
+	}
+
+	for (i = 0; i < size; i++)
+		crc ^= image[i];
+
+	if (write_all(fd, image, size) < 0 || read_all(fd, &c, 1, ANSWER_TIMEOUT) < 0) {
+		fprintf(stderr, "No checksum received\n");
+		return -1;
+	}
+	if (c != crc) {
+		fprintf(stderr, "Checksum mismatch (0x%02X instead of 0x%02X)\n", c, crc);
+		return -1;
+	}
+
+	c = ACK;
+	return write_all(fd, &c, 1);
+}
+
+static int send_frame(int fd, const uint8_t *image, size_t size, unsigned int block_log2,
+		      uint16_t seq)
+{
+	static uint8_t frame[4 + (1 << FRAMED_BLOCK_LOG2_MAX) + 4];
+	size_t offset = (size_t)seq << block_log2;
+	size_t len = size - offset;
+	uint32_t crc;
+
+	if (len > (1U << block_log2))
+		len = 1U << block_log2;
+
+	frame[0] = seq & 0xFF;
+	frame[1] = seq >> 8;
+	frame[2] = ~seq & 0xFF;
+	frame[3] = (~seq >> 8) & 0xFF;
+	memcpy(&frame[4], image + offset, len);
+	crc = crc32(0, frame, 2);
+	crc = crc32(crc, &frame[4], len);
+	frame[4 + len] = crc & 0xFF;
+	frame[5 + len] = (crc >> 8) & 0xFF;
+	frame[6 + len] = (crc >> 16) & 0xFF;
+	frame[7 + len] = crc >> 24;
+
+	return write_all(fd, frame, len + 8);
+}
+
+static int send_framed(int fd, const uint8_t *image, size_t size, unsigned int baud,
+		       unsigned int block_log2, unsigned int window)
+{
+	uint8_t hdr[15];
+	uint8_t ans[3];
+	uint32_t crc;
+	unsigned int blocks, outstanding = 0, acked = 0, resent = 0, i;
+	uint8_t *state;
+	int ret = -1;
+
+	hdr[0] = SOB;
+	hdr[1] = size & 0xFF;
+	hdr[2] = (size >> 8) & 0xFF;
+	hdr[3] = (size >> 16) & 0xFF;
+	hdr[4] = (size >> 24) & 0xFF;
+	hdr[5] = block_log2;
+	hdr[6] = baud;
+	crc = crc32(0, image, size);
+	hdr[7] = crc & 0xFF;
+	hdr[8] = (crc >> 8) & 0xFF;
+	hdr[9] = (crc >> 16) & 0xFF;
+	hdr[10] = crc >> 24;
+	crc = crc32(0, &hdr[1], 10);
+	hdr[11] = crc & 0xFF;
+	hdr[12] = (crc >> 8) & 0xFF;
+	hdr[13] = (crc >> 16) & 0xFF;
+	hdr[14] = crc >> 24;
+
+	if (write_all(fd, hdr, sizeof(hdr)) < 0 || read_all(fd, ans, 1, ANSWER_TIMEOUT) < 0) {
+		fprintf(stderr, "No answer to the header\n");
+		return -1;
+	}
+	if (ans[0] != ACK) {
+		fprintf(stderr, "The device rejected the header (framed protocol not supported?)\n");
+		return -1;
+	}
+	if (read_all(fd, &ans[1], 2, ANSWER_TIMEOUT) < 0 || ans[1] >= BAUD_RATES || ans[2] == 0) {
+		fprintf(stderr, "Bad answer to the header\n");
+		return -1;
+	}
+	if (ans[1] != 0 && set_speed(fd, baud_rates[ans[1]].speed) < 0) {
+		fprintf(stderr, "Could not switch to %u baud\n", baud_rates[ans[1]].rate);
+		return -1;
+	}
+	if (window == 0 || window > ans[2])
+		window = ans[2];
+
+	blocks = (size + (1U << block_log2) - 1) >> block_log2;
+	state = calloc(blocks, 1);
+	if (state == NULL)
+		return -1;
+
+	while (acked < blocks) {
+		/* Fill the window, lowest blocks first */
+		for (i = 0; i < blocks && outstanding < window; i++) {
+			if (state[i] != BLOCK_TO_SEND)
+				continue;
+			if (send_frame(fd, image, size, block_log2, i) < 0)
+				goto out;
+			state[i] = BLOCK_SENT;
+			outstanding++;
+		}
+
+		if (read_all(fd, ans, sizeof(ans), ANSWER_TIMEOUT) < 0) {
+			fprintf(stderr, "No answer from the device (%u of %u blocks done)\n",
+				acked, blocks);
+			goto out;
+		}
+
+		i = ans[1] | (ans[2] << 8);
+		if (ans[0] == NAK && i == FRAMED_SEQ_RESYNC) {
+			/* Framing lost, the frames without an answer were dropped */
+			for (i = 0; i < blocks; i++) {
+				if (state[i] == BLOCK_SENT) {
+					state[i] = BLOCK_TO_SEND;
+					resent++;
+				}
+			}
+			outstanding = 0;
+		} else if ((ans[0] == ACK || ans[0] == NAK) && i < blocks) {
+			if (state[i] == BLOCK_SENT)
+				outstanding--;
+			if (ans[0] == ACK) {
+				if (state[i] != BLOCK_ACKED)
+					acked++;
+				state[i] = BLOCK_ACKED;
+			} else {
+				if (state[i] == BLOCK_ACKED)
+					acked--;
+				state[i] = BLOCK_TO_SEND;
+				resent++;
+			}
+		} else {
+			fprintf(stderr, "Bad answer 0x%02X 0x%02X 0x%02X\n", ans[0], ans[1], ans[2]);
+			goto out;
+		}
+	}
+
+	if (read_all(fd, ans, sizeof(ans), ANSWER_TIMEOUT) < 0) {
+		fprintf(stderr, "No final answer from the device\n");
+		goto out;
+	}
+	if (ans[0] != EOT) {
+		fprintf(stderr, "Image CRC32 mismatch\n");
+		goto out;
+	}
+
+	if (resent)
+		printf("%u frames sent again\n", resent);
+	ret = 0;
+out:
+	free(state);
+	return ret;
+}
+
+static uint8_t *read_file(const char *filename, size_t *size)
+{
+	FILE *f;
+	long len;
+	uint8_t *buf;
+
+	f = fopen(filename, "rb");
+	if (f == NULL) {
+		fprintf(stderr, "Could not open %s: %s\n", filename, strerror(errno));
+		return NULL;
+	}
+	if (fseek(f, 0, SEEK_END) < 0 || (len = ftell(f)) <= 0 || fseek(f, 0, SEEK_SET) < 0) {
+		fprintf(stderr, "Could not get the size of %s\n", filename);
+		fclose(f);
+		return NULL;
+	}
+	buf = malloc(len);
+	if (buf == NULL || fread(buf, 1, len, f) != (size_t)len) {
+		fprintf(stderr, "Could not read %s\n", filename);
+		free(buf);
+		fclose(f);
+		return NULL;
+	}
+	fclose(f);
+	*size = len;
+	return buf;
+}
+
+int main(int argc, char **argv)
+{
+	int legacy = 0;
+	unsigned int rate = 115200, baud = 5, block_log2 = FRAMED_BLOCK_LOG2_MAX, window = 0;
+	speed_t speed;
+	uint8_t *image;
+	size_t size;
+	double start, elapsed;
+	int fd, opt, ret;
+
+	while ((opt = getopt(argc, argv, "lr:b:k:w:")) != -1) {
+		switch (opt) {
+		case 'l':
+			legacy = 1;
+			break;
+		case 'r':
+			rate = strtoul(optarg, NULL, 0);
+			break;
+		case 'b':
+			baud = strtoul(optarg, NULL, 0);
+			break;
+		case 'k':
+			block_log2 = strtoul(optarg, NULL, 0);
+			break;
+		case 'w':
+			window = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (argc - optind != 2 || baud >= BAUD_RATES ||
+	    block_log2 < FRAMED_BLOCK_LOG2_MIN || block_log2 > FRAMED_BLOCK_LOG2_MAX) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	speed = rate_to_speed(rate);
+	if (speed == 0) {
+		fprintf(stderr, "Unsupported baud rate %u\n", rate);
+		return EXIT_FAILURE;
+	}
+
+	crc32_init();
+
+	image = read_file(argv[optind + 1], &size);
+	if (image == NULL)
+		return EXIT_FAILURE;
+
+	fd = open_tty(argv[optind], speed);
+	if (fd < 0) {
+		free(image);
+		return EXIT_FAILURE;
+	}
+
+	ret = wait_stx(fd);
+	if (ret == 0) {
+		start = now_s();
+		if (legacy)
+			ret = send_legacy(fd, image, size);
+		else
+			ret = send_framed(fd, image, size, baud, block_log2, window);
+		tcdrain(fd);
+		elapsed = now_s() - start;
+		if (ret == 0)
+			printf("%zu bytes in %.3f s: %.1f kB/s\n", size, elapsed,
+			       size / elapsed / 1000);
+	}
+
+	close(fd);
+	free(image);
+
+	return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}